@@ -0,0 +1,128 @@
+#!/bin/bash
+
+# Aria AST Benchmark
+# Parses a generated source of about LINES lines, then walks every function
+# body once (loop_reads_var visits each node), and reports the nodes built,
+# memory per node (resident growth, strings and intern table included) and
+# the parse and traversal times. Given a git ref, the same harness is built
+# against that revision as well so the two node layouts can be compared.
+#
+# Usage: scripts/bench_ast.sh [lines] [baseline-ref]
+
+LINES=${1:-1000000}
+BASE=$2
+CC=${CC:-gcc}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/frontend/parser.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+
+# 20-line functions with distinct names, plus an entry point
+awk -v units=$(( LINES / 20 )) 'BEGIN {
+    for (i = 0; i < units; i++) {
+        printf "func stats_%d(samples, n, limit) {\n", i
+        print "        var total = 0;"
+        print "        var square = 0;"
+        print "        var i = 0;"
+        print "        while (i < n) {"
+        print "                var s = samples[i];"
+        print "                total = total + s;"
+        print "                square = square + s * s;"
+        print "                if (s > limit) {"
+        print "                        println(\"above limit\");"
+        print "                }"
+        print "                i = i + 1;"
+        print "        }"
+        print "        for (var k = 0; k < n; k = k + 2) {"
+        print "                total = total - k;"
+        print "        }"
+        print "        var report = [total, square, n];"
+        print "        return report[0] + report[1] * 2 - report[2];"
+        print "}"
+        print ""
+    }
+    print "func main() {"
+    print "        println(stats_0([1, 2, 3], 3, 2));"
+    print "}"
+}' > "$WORK/input.aria"
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "frontend/parser.h"
+#include "frontend/source.h"
+#include "backend/loops.h"
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static long rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char** argv) {
+    SourceFile source;
+    if (argc < 2 || !source_load(&source, argv[1])) return 1;
+    long rss = rss_kb();
+    double t0 = now();
+    AstArena* arena = arena_create(source.length);
+    if (!arena) return 1;
+    AstNode* root = parse_program(source.text, source.length, argv[1], arena);
+    double t1 = now();
+    long nodes = -1;
+#ifdef AST_NEXT
+    nodes = (long)arena_node_count(arena);
+    for (AstNode* n = root; n; n = AST_NEXT(n)) {
+        if (ast_type(n) == NODE_FUNC_DECL) loop_reads_var(n, NULL);
+    }
+#else
+    for (AstNode* n = root; n; n = n->next) {
+        if (n->type == NODE_FUNC_DECL) loop_reads_var(n, NULL);
+    }
+#endif
+    double t2 = now();
+    printf("%ld %ld %zu %.0f %.0f\n", nodes, rss_kb() - rss, sizeof(AstNode),
+           (t1 - t0) * 1e3, (t2 - t1) * 1e3);
+    return 0;
+}
+EOT
+
+build() {
+    (cd "$1" && $CC -O2 -march=native -std=c99 -D_GNU_SOURCE -Isrc -o "$2" "$WORK/bench.c" \
+        src/frontend/lexer.c src/frontend/parser.c src/frontend/arena.c src/frontend/source.c \
+        src/backend/loops.c) || { echo "Build failed"; exit 1; }
+}
+
+report() {
+    read -r NODES RSS SIZE PARSE WALK < <("$2" "$WORK/input.aria")
+    [ "$NODES" -gt 0 ] && COUNT=$NODES
+    printf "  %-12s %4s B/node %6s MB resident %5s B/node %6s ms parse %5s ms walk\n" \
+        "$1:" "$SIZE" $(( RSS / 1024 )) $(( RSS * 1024 / COUNT )) "$PARSE" "$WALK"
+}
+
+echo "Aria AST Benchmark"
+echo "=================="
+echo "Input: $(wc -l < "$WORK/input.aria") lines"
+
+build . "$WORK/current"
+COUNT=1
+read -r COUNT _ < <("$WORK/current" "$WORK/input.aria")
+echo "Nodes: $COUNT"
+echo ""
+
+if [ -n "$BASE" ]; then
+    mkdir -p "$WORK/base"
+    git archive "$BASE" src | tar -x -C "$WORK/base" || exit 1
+    build "$WORK/base" "$WORK/baseline"
+    report "$BASE" "$WORK/baseline"
+fi
+report "current" "$WORK/current"
@@ -0,0 +1,179 @@
+#!/bin/bash
+
+# Aria AST Cache Benchmark
+# Times parsing a generated source against mapping its saved AST back
+# (arena_save / arena_load), then checks that the compiler reuses a cached
+# AST only when it should: unchanged text hits, edits, damaged files and
+# entries under another key are parsed afresh, and output never differs
+# from an uncached compile. Exits non-zero if any check fails.
+#
+# Usage: scripts/bench_ast_cache.sh [lines]
+
+LINES=${1:-1000000}
+CC=${CC:-gcc}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/frontend/arena.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+awk -v units=$(( LINES / 10 )) 'BEGIN {
+    for (i = 0; i < units; i++) {
+        printf "func step_%d(state, limit) {\n", i
+        print "        var next = state * 31 + 7;"
+        print "        if (next > limit) {"
+        print "                next = next - limit;"
+        print "                println(\"wrapped around the limit\");"
+        print "        }"
+        print "        var pair = [next, state];"
+        print "        return pair[0] + pair[1];"
+        print "}"
+        print ""
+    }
+}' > "$WORK/input.aria"
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "frontend/parser.h"
+#include "frontend/source.h"
+#include "driver/cache.h"
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    SourceFile source;
+    if (argc < 3 || !source_load(&source, argv[1])) return 1;
+    char key[65];
+    cache_ast_key("bench", source.text, source.length, key);
+
+    double t0 = now();
+    AstArena* parsed = arena_create(source.length);
+    if (!parsed) return 1;
+    AstNode* root = parse_program(source.text, source.length, argv[1], parsed);
+    double t1 = now();
+    if (!arena_save(parsed, root, key, argv[2])) return 1;
+    double t2 = now();
+    AstArena* loaded = arena_create(source.length);
+    if (!loaded) return 1;
+    AstNode* mapped;
+    if (!arena_load(loaded, key, argv[2], &mapped)) return 1;
+    double t3 = now();
+
+    // Same top-level declarations, in order, with the same names
+    int same = 1;
+    for (; root && mapped; root = AST_NEXT(root), mapped = AST_NEXT(mapped)) {
+        same &= ast_type(root) == ast_type(mapped) && root->line == mapped->line &&
+                strcmp(root->data.func_decl.name, mapped->data.func_decl.name) == 0;
+    }
+    same &= root == NULL && mapped == NULL;
+    printf("%.0f %.0f %.0f %d\n", (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t3 - t2) * 1e3, same);
+    return 0;
+}
+EOT
+
+echo "Aria AST Cache Benchmark"
+echo "========================"
+echo "Input: $(wc -l < "$WORK/input.aria") lines"
+echo ""
+
+$CC -O2 -march=native -std=c99 -D_GNU_SOURCE -Isrc -o "$WORK/bench" "$WORK/bench.c" \
+    src/frontend/lexer.c src/frontend/parser.c src/frontend/arena.c src/frontend/source.c \
+    src/driver/cache.c src/driver/sha256.c || { echo "Build failed"; exit 1; }
+read -r PARSE SAVE LOAD SAME < <("$WORK/bench" "$WORK/input.aria" "$WORK/input.ast")
+printf "  %-24s %6s ms\n" "parse:" "$PARSE" "save:" "$SAVE" "load cached AST:" "$LOAD"
+echo "  AST file: $(( $(wc -c < "$WORK/input.ast") / 1024 / 1024 )) MB"
+echo ""
+
+FAILED=0
+check() {
+    if [ "$2" = 1 ]; then
+        echo "  ok    $1"
+    else
+        echo "  FAIL  $1"
+        FAILED=1
+    fi
+}
+check "loaded AST matches the parsed one" "$SAME"
+
+export ARIA_CACHE_DIR="$WORK/cache"
+cd "$WORK"
+cat > prog.aria <<'EOT'
+class Counter {
+    func bump(by) { return by + 1; }
+}
+
+func fold(items) {
+    var total = 0;
+    for (var x in items) {
+        total = total + x;
+    }
+    return total;
+}
+
+func main() {
+    var c = new Counter();
+    println(fold([1, 2, 3]) + c.bump(4));
+    println("done");
+}
+EOT
+cat > other.aria <<'EOT'
+func main() {
+    println("other");
+}
+EOT
+
+# compile <file> <tag> [flags]: keeps the assembly as <file>.<tag>.asm
+compile() {
+    "$COMPILER" "$1" --asm-only "${@:3}" > /dev/null 2>&1 && cp "${1%.aria}.asm" "$1.$2.asm"
+}
+entries() { ls cache/*.ast 2>/dev/null | wc -l; }
+
+compile prog.aria fresh --no-cache
+compile prog.aria cold
+check "a cold compile saves one AST" $(( $(entries) == 1 ))
+AST=$(ls cache/*.ast)
+INODE=$(stat -c %i "$AST")
+compile prog.aria warm
+check "an unchanged source reuses it" $(( $(entries) == 1 && $(stat -c %i "$AST") == INODE ))
+cmp -s prog.aria.fresh.asm prog.aria.warm.asm
+check "output from the cached AST is identical" $(( $? == 0 ))
+
+echo "// trailing comment" >> prog.aria
+compile prog.aria fresh --no-cache
+compile prog.aria edited
+check "an edit parses afresh under a new key" $(( $(entries) == 2 ))
+cmp -s prog.aria.fresh.asm prog.aria.edited.asm
+check "output after the edit is identical" $(( $? == 0 ))
+
+for f in cache/*.ast; do head -c 3000 "$f" > "$f.cut" && mv "$f.cut" "$f"; done
+compile prog.aria truncated
+cmp -s prog.aria.fresh.asm prog.aria.truncated.asm
+check "a truncated file is parsed afresh" $(( $? == 0 && $(stat -c %s $(ls -t cache/*.ast | head -1)) > 3000 ))
+
+compile other.aria fresh --no-cache
+compile other.aria cold
+OTHER=$(ls -t cache/*.ast | head -1)
+for f in cache/*.ast; do [ "$f" != "$OTHER" ] && cp "$OTHER" "$f"; done
+compile prog.aria foreign
+cmp -s prog.aria.fresh.asm prog.aria.foreign.asm
+check "a file saved under another key is rejected" $(( $? == 0 ))
+
+rm -rf cache
+ARIA_CACHE=0 compile prog.aria disabled
+check "ARIA_CACHE=0 saves nothing" $(( $(entries) == 0 ))
+
+echo ""
+[ "$FAILED" = 0 ] || { echo "FAIL: AST cache checks failed"; exit 1; }
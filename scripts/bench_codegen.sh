@@ -0,0 +1,78 @@
+#!/bin/bash
+
+# Aria Codegen Benchmark
+# Compares object emission through the built-in x86-64 encoder against the
+# external NASM path on a generated program of N functions.
+#
+# Usage: scripts/bench_codegen.sh [num_functions] [runs]
+
+N=${1:-400}
+RUNS=${2:-5}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+SRC="$WORK/bench.aria"
+{
+    echo "var total = 0;"
+    for ((i = 0; i < N; i++)); do
+        # Names are unique per function: the parser's symbol table is program-wide
+        # and capped at 2048 entries, so bulk comes from statements, not variables
+        echo "func f$i(a$i, b$i) {"
+        echo "    var x$i = a$i + b$i * $i;"
+        echo "    var l$i = [x$i, a$i, b$i];"
+        for ((k = 0; k < 8; k++)); do
+            echo "    if (x$i > $k) { x$i = x$i - l$i[1]; } else { x$i = x$i + l$i[2]; }"
+            echo "    while (x$i < $((i + k))) { x$i = x$i + 1; l$i[0] = x$i; }"
+            echo "    print(\"step $k\");"
+        done
+        echo "    return x$i;"
+        echo "}"
+    done
+    echo "func main() {"
+    for ((i = 0; i < N; i += 10)); do
+        echo "    total = total + f$i($i, 2);"
+    done
+    echo "    print(\"done\");"
+    echo "}"
+} > "$SRC"
+
+echo "Aria Codegen Benchmark"
+echo "======================"
+echo "Program: $N functions, $(wc -c < "$SRC") bytes, best of $RUNS runs"
+echo ""
+
+# Prints the best wall time in milliseconds for the given compiler flags
+best_ms() {
+    local best=""
+    for ((r = 0; r < RUNS; r++)); do
+        local start end ms
+        start=$(date +%s%N)
+        "$COMPILER" "$SRC" "$@" > /dev/null || return 1
+        end=$(date +%s%N)
+        ms=$(( (end - start) / 1000000 ))
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+    done
+    echo "$best"
+}
+
+BUILTIN=$(best_ms -c) || { echo "Built-in encoder failed"; exit 1; }
+printf "  %-28s %6s ms  (%s bytes)\n" "built-in encoder:" "$BUILTIN" "$(wc -c < "$WORK/bench.o")"
+
+TEXT=$(best_ms --asm-only) || { echo "Assembly printer failed"; exit 1; }
+printf "  %-28s %6s ms  (%s bytes)\n" "textual .asm only:" "$TEXT" "$(wc -c < "$WORK/bench.asm")"
+
+if NASM=$(best_ms -c --nasm 2> /dev/null); then
+    printf "  %-28s %6s ms  (%s bytes)\n" "nasm:" "$NASM" "$(wc -c < "$WORK/bench.o")"
+    if [ "$BUILTIN" -gt 0 ]; then
+        echo ""
+        echo "  speedup: $(awk "BEGIN { printf \"%.1f\", $NASM / $BUILTIN }")x"
+    fi
+else
+    echo "  nasm:                        unavailable (bundled toolchain has no nasm)"
+fi
@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# Aria Concatenation Benchmark
+# Builds one long string from many short pieces three ways: `s = s + piece`
+# statements (extended in place, see backend/append.h), the sb_* string
+# builder, and a copying concatenation through a temporary that keeps the
+# generic dyn_add. The copying loop duplicates the whole string on every
+# step, so it runs a fraction of the appends. Reports the time per append
+# and exits non-zero if the variants build different strings or the
+# in-place append is not faster per append than copying.
+#
+# Usage: scripts/bench_concat.sh [appends]
+
+N=${1:-1000000}
+COPY_N=$(( N / 250 ))
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+# program <name> <appends> <loop statement> [setup] [result]
+program() {
+    cat > "$WORK/$1.aria" <<EOT
+func main() {
+    var s = "";
+    ${4}
+    var i = 0;
+    while (i < $2) { $3 i = i + 1; }
+    println(${5:-s});
+}
+EOT
+}
+
+program append "$N" 's = s + "item,";'
+program builder "$N" 'sb_append(b, "item,");' 'var b = sb_new();' 'sb_to_string(b)'
+program copy "$COPY_N" 'var t = s + "item,"; s = t;'
+program append_small "$COPY_N" 's = s + "item,";'
+
+echo "Aria Concatenation Benchmark"
+echo "============================"
+echo "Program: $N appends of a 5-byte piece ($COPY_N when copying)"
+echo ""
+
+# Builds one program, runs it once and prints its run time in ms
+run_variant() {
+    local out="$WORK/$1"
+    "$COMPILER" "$out.aria" --no-cache > /dev/null || return 1
+    local start end
+    start=$(date +%s%N)
+    "$out" > "$out.stdout" || return 1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+APPEND_MS=$(run_variant append) || { echo "In-place append build failed"; exit 1; }
+BUILDER_MS=$(run_variant builder) || { echo "String builder build failed"; exit 1; }
+COPY_MS=$(run_variant copy) || { echo "Copying concatenation build failed"; exit 1; }
+run_variant append_small > /dev/null || { echo "In-place append build failed"; exit 1; }
+
+per_append() { echo $(( $1 * 1000000 / $2 )); }
+printf "  %-28s %8s appends %6s ms %8s ns/append\n" \
+    "copying concatenation:" "$COPY_N" "$COPY_MS" "$(per_append "$COPY_MS" "$COPY_N")" \
+    "in-place append:" "$N" "$APPEND_MS" "$(per_append "$APPEND_MS" "$N")" \
+    "string builder:" "$N" "$BUILDER_MS" "$(per_append "$BUILDER_MS" "$N")"
+echo "  Result: $(( $(wc -c < "$WORK/append.stdout") / 1024 )) KB"
+
+if ! cmp -s "$WORK/append.stdout" "$WORK/builder.stdout" ||
+   ! cmp -s "$WORK/copy.stdout" "$WORK/append_small.stdout"; then
+    echo ""
+    echo "FAIL: the variants built different strings"
+    exit 1
+fi
+if ! [ $(( APPEND_MS * COPY_N )) -lt $(( COPY_MS * N )) ]; then
+    echo ""
+    echo "FAIL: the in-place append was not faster per append than copying"
+    exit 1
+fi
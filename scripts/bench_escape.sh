@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# Aria Escape Analysis Benchmark
+# Runs a program full of short-lived lists and objects built with and without
+# frame allocation (--no-stack-alloc) and compares the heap allocation counts
+# the runtime reports under ARIA_GC_STATS. Exits non-zero if the frame build
+# does not allocate less or prints different output.
+#
+# Usage: scripts/bench_escape.sh [iterations]
+
+N=${1:-100000}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/bench.aria" <<EOF
+class Vec {
+    func set(self, x, y) { self.x = x; self.y = y; }
+    func dot(self, other) { return self.x * other.x + self.y * other.y; }
+}
+
+func middle(l) { return l[1]; }
+
+func step(i) {
+    var window = [i, i + 1, i + 2];
+    window[0] = window[2] - window[1];
+    var a = new Vec();
+    var b = new Vec();
+    a.set(i, 1);
+    b.set(2, window[0]);
+    return middle(window) + a.dot(b);
+}
+
+func main() {
+    var total = 0;
+    var i = 0;
+    while (i < $N) {
+        total = total + step(i % 100);
+        i = i + 1;
+    }
+    dyn_print(total);
+    println("");
+}
+EOF
+
+echo "Aria Escape Analysis Benchmark"
+echo "=============================="
+echo "Program: $N calls, each building one list and two objects"
+echo ""
+
+# Builds with the given flags, runs once and prints "<allocations> <ms>"
+run_variant() {
+    local out="$WORK/$1"
+    shift
+    cp "$WORK/bench.aria" "$out.aria"
+    "$COMPILER" "$out.aria" --no-cache "$@" > /dev/null || return 1
+    local start end
+    start=$(date +%s%N)
+    ARIA_GC_STATS=1 "$out" > "$out.stdout" 2> "$out.stats" || return 1
+    end=$(date +%s%N)
+    local allocs
+    allocs=$(sed -n 's/^\[Aria GC\] \([0-9]*\) allocations.*/\1/p' "$out.stats")
+    echo "${allocs:-?} $(( (end - start) / 1000000 ))"
+}
+
+read -r HEAP_ALLOCS HEAP_MS <<< "$(run_variant heap --no-stack-alloc)" || { echo "Heap build failed"; exit 1; }
+read -r FRAME_ALLOCS FRAME_MS <<< "$(run_variant frame)" || { echo "Frame build failed"; exit 1; }
+
+printf "  %-28s %10s allocations %6s ms\n" "heap only:" "$HEAP_ALLOCS" "$HEAP_MS"
+printf "  %-28s %10s allocations %6s ms\n" "escape analysis:" "$FRAME_ALLOCS" "$FRAME_MS"
+
+if ! cmp -s "$WORK/heap.stdout" "$WORK/frame.stdout"; then
+    echo ""
+    echo "FAIL: program output differs between builds"
+    exit 1
+fi
+if ! [ "$FRAME_ALLOCS" -lt "$HEAP_ALLOCS" ] 2> /dev/null; then
+    echo ""
+    echo "FAIL: escape analysis did not reduce heap allocations"
+    exit 1
+fi
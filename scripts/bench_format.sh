@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# Aria Format Benchmark
+# Builds the same log line many times with format() from a format string held
+# in a variable (parsed at run time on every call) and from a literal format
+# (split at compile time into constant text and typed appends). Exits
+# non-zero if the two programs print different lines or the literal format
+# is not faster.
+#
+# Usage: scripts/bench_format.sh [iterations]
+
+N=${1:-300000}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/dynamic.aria" <<EOT
+func main() {
+    var fmt = "request %d from %s took %f ms (status %d)";
+    var host = "10.0.0.7";
+    var line = "";
+    var i = 0;
+    while (i < $N) { line = format(fmt, i, host, 1.5, 200); i = i + 1; }
+    println(line);
+}
+EOT
+
+cat > "$WORK/literal.aria" <<EOT
+func main() {
+    var host = "10.0.0.7";
+    var line = "";
+    var i = 0;
+    while (i < $N) { line = format("request %d from %s took %f ms (status %d)", i, host, 1.5, 200); i = i + 1; }
+    println(line);
+}
+EOT
+
+echo "Aria Format Benchmark"
+echo "====================="
+echo "Program: $N formatted log lines"
+echo ""
+
+# Builds one program, runs it once and prints its run time in ms
+run_variant() {
+    local out="$WORK/$1"
+    "$COMPILER" "$out.aria" --no-cache > /dev/null || return 1
+    local start end
+    start=$(date +%s%N)
+    "$out" > "$out.stdout" || return 1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+DYNAMIC_MS=$(run_variant dynamic) || { echo "Dynamic format build failed"; exit 1; }
+LITERAL_MS=$(run_variant literal) || { echo "Literal format build failed"; exit 1; }
+
+printf "  %-28s %6s ms\n" "run-time format:" "$DYNAMIC_MS"
+printf "  %-28s %6s ms\n" "compile-time format:" "$LITERAL_MS"
+
+if ! cmp -s "$WORK/dynamic.stdout" "$WORK/literal.stdout"; then
+    echo ""
+    echo "FAIL: the programs formatted different lines"
+    exit 1
+fi
+if ! [ "$LITERAL_MS" -lt "$DYNAMIC_MS" ]; then
+    echo ""
+    echo "FAIL: the literal format was not faster than run-time formatting"
+    exit 1
+fi
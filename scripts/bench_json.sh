@@ -0,0 +1,202 @@
+#!/bin/bash
+
+# Aria JSON Benchmark
+# Generates a large JSON document (records of ints, floats, escaped and
+# non-ASCII strings, nested lists and objects) and times, in MB/s:
+#   - validation alone (stage 1 index + stage 2 tape, no values built) at
+#     every classifier level the CPU supports,
+#   - json_parse to AriaObject / AriaList values,
+#   - json_stringify of the parsed values.
+# Every level must build the same values, and writing them, parsing that
+# text and writing again must give identical text. Allocation is a bump
+# arena so the timings are the parser's, not the collector's. Then parses,
+# reads and writes JSON from an Aria program. Exits non-zero if any check
+# fails.
+#
+# Usage: scripts/bench_json.sh [document MB]
+
+DOC_MB=${1:-100}
+CC=${CC:-gcc}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/stdlib/json.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+
+long long aria_json_parse(const char* text, size_t len, void** out);
+const char* aria_json_kernels_use(const char* limit);
+void* json_stringify(void* value);
+uint32_t aria_str_length(const char* data);
+
+#define PTR_MASK 0x0000FFFFFFFFFFFFULL
+static const char* LEVELS[] = { "scalar", "sse4.2", "avx2" };
+
+// The collector is not linked in: every run allocates from one arena that
+// is cleared before the next, since aria_alloc returns zeroed memory
+static char* arena;
+static size_t arena_used, arena_size = (size_t)16 << 30;
+void* aria_alloc(size_t size) {
+    size_t at = arena_used;
+    arena_used += (size + 15) & ~(size_t)15;
+    if (arena_used > arena_size) { fprintf(stderr, "arena exhausted\n"); exit(2); }
+    return arena + at;
+}
+
+static void reset_arena(void) {
+    memset(arena, 0, arena_used);
+    arena_used = 0;
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint64_t seed = 88172645463325252ULL;
+static uint64_t next(void) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    return seed;
+}
+
+// Records shaped like API responses, pretty-printed in part
+static char* make_document(size_t target, size_t* len) {
+    static const char* WORDS[] = { "alpha", "caf\xc3\xa9", "quote\\\"d", "tab\\there", "\\u00e9t\\u00e9",
+                                   "emoji \xf0\x9f\x98\x80", "back\\\\slash", "line\\nbreak", "\\ud83d\\ude00" };
+    char* doc = malloc(target + 4096);
+    size_t n = 0;
+    n += sprintf(doc + n, "{\"generated\": true, \"records\": [\n");
+    for (int i = 0; n < target; i++) {
+        n += sprintf(doc + n, "%s  {\"id\": %d, \"score\": %.*f, \"ratio\": %de-%d, \"name\": \"%s %s\",\n"
+                     "   \"tags\": [\"%s\", \"%s\", %d, %s], \"owner\": {\"login\": \"user%llu\", \"admin\": %s},"
+                     " \"history\": [[%d, %d], [], {\"k\": null}]}",
+                     i ? ",\n" : "", i, (int)(next() % 7), (double)(next() % 100000) / 37.0,
+                     (int)(next() % 1000), (int)(next() % 20), WORDS[next() % 9], WORDS[next() % 9],
+                     WORDS[next() % 9], WORDS[next() % 9], (int)(next() % 2000000000) - 1000000000,
+                     next() % 2 ? "null" : "false", (unsigned long long)(next() % 100000),
+                     next() % 2 ? "true" : "false", (int)(next() % 100), -(int)(next() % 100));
+    }
+    n += sprintf(doc + n, "\n]}\n");
+    *len = n;
+    return doc;
+}
+
+int main(int argc, char** argv) {
+    size_t len;
+    char* doc = make_document((size_t)atol(argv[1]) << 20, &len);
+    double mb = len / 1e6;
+    arena = mmap(NULL, arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arena == MAP_FAILED) { printf("  cannot reserve the arena\n"); return 1; }
+    printf("  document: %.1f MB\n\n", mb);
+
+    char* expect = NULL;
+    size_t expect_len = 0;
+    const char* last = "";
+    int failed = 0;
+    for (int l = 0; l < 3; l++) {
+        // A cap the CPU cannot reach gives the level below it again
+        const char* level = aria_json_kernels_use(LEVELS[l]);
+        if (strcmp(level, last) == 0) continue;
+        last = level;
+
+        reset_arena();
+        double t0 = now();
+        long long ok = aria_json_parse(doc, len, NULL);
+        double t1 = now();
+        void* value = NULL;
+        ok &= aria_json_parse(doc, len, &value);
+        double t2 = now();
+        const char* text = (const char*)((uint64_t)json_stringify(value) & PTR_MASK & ~7ULL);
+        double t3 = now();
+        size_t text_len = aria_str_length(text);
+        if (!ok) { printf("  %-8s document rejected\n", level); failed = 1; continue; }
+
+        printf("  %-8s validate %7.1f MB/s   parse %7.1f MB/s   stringify %7.1f MB/s\n", level,
+               mb / (t1 - t0), mb / (t2 - t1), text_len / 1e6 / (t3 - t2));
+        if (!expect) {
+            expect = malloc(text_len);
+            memcpy(expect, text, text_len);
+            expect_len = text_len;
+        } else if (text_len != expect_len || memcmp(text, expect, text_len) != 0) {
+            printf("  %-8s values differ from the first level\n", level);
+            failed = 1;
+        }
+    }
+
+    // stringify(parse(stringify(v))) == stringify(v)
+    reset_arena();
+    void* again = NULL;
+    aria_json_kernels_use(NULL);
+    if (!expect || !aria_json_parse(expect, expect_len, &again)) {
+        printf("  written text does not parse\n");
+        return 1;
+    }
+    const char* text = (const char*)((uint64_t)json_stringify(again) & PTR_MASK & ~7ULL);
+    if (aria_str_length(text) != expect_len || memcmp(text, expect, expect_len) != 0) {
+        printf("  round trip changed the text\n");
+        failed = 1;
+    }
+    return failed;
+}
+EOT
+
+echo "Aria JSON Benchmark"
+echo "==================="
+echo "Document: $DOC_MB MB"
+echo ""
+
+$CC -O2 -std=c99 -D_GNU_SOURCE -o "$WORK/bench" "$WORK/bench.c" src/stdlib/json.c src/stdlib/io.c \
+    src/stdlib/dynamic.c src/stdlib/string_utils.c src/stdlib/string_kernels.c \
+    src/stdlib/dataStructures.c src/stdlib/list_kernels.c src/runtime/object.c -lpthread -lm 2> /dev/null ||
+    { echo "Build failed"; exit 1; }
+
+FAILED=0
+"$WORK/bench" "$DOC_MB" || { echo ""; echo "FAIL: levels or round trip disagree"; FAILED=1; }
+
+cat > "$WORK/prog.aria" <<'EOT'
+func main() {
+    var doc = json_parse("{\"name\": \"aria\", \"tags\": [\"fast\", \"small\"], \"n\": 40}");
+    println(doc.name);
+    println(format("%d", doc.n + 2));
+    for (var t in doc.tags) {
+        println(t);
+    }
+    println(json_stringify(doc.tags));
+    println(json_stringify(json_parse("[1, 2.5, true, null, \"a\\nb\", {\"k\": []}]")));
+    println(json_stringify(json_parse("[1,")));
+}
+EOT
+cat > "$WORK/expect.txt" <<'EOT'
+aria
+42
+fast
+small
+["fast","small"]
+[1,2.5,true,null,"a\nb",{"k":[]}]
+null
+EOT
+
+echo ""
+if "$COMPILER" "$WORK/prog.aria" --no-cache > /dev/null && "$WORK/prog" > "$WORK/out.txt" 2> /dev/null &&
+   cmp -s "$WORK/out.txt" "$WORK/expect.txt"; then
+    echo "  ok    json_parse / json_stringify from Aria"
+else
+    echo "  FAIL  json_parse / json_stringify from Aria"
+    FAILED=1
+fi
+exit $FAILED
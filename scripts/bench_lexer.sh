@@ -0,0 +1,123 @@
+#!/bin/bash
+
+# Aria Lexer Benchmark
+# Tokenizes two large generated sources with lex_all(), once with the
+# default bytewise scanner and once with the vector scans (ARIA_VECTOR_LEXER,
+# -march=native), and reports throughput in MB/s. The first source is
+# ordinary code; the second is mostly long doc comments and strings, the
+# runs the vector scans are for. Exits non-zero if the two scanners produce
+# different token streams.
+#
+# Usage: scripts/bench_lexer.sh [copies]
+
+COPIES=${1:-4000}
+CC=${CC:-gcc}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/frontend/lexer.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+
+# One unit of indented code, comments and strings, repeated COPIES times
+cat > "$WORK/unit.aria" <<'EOT'
+// Running statistics over a window of samples, recomputed on every push
+/*
+ * The window is kept as a plain list; callers read mean and spread
+ * after each update.
+ */
+func window_stats(samples, window_length, threshold_value) {
+        var running_total = 0;
+        var running_square = 0.0;
+        var index_position = 0;
+        while (index_position < window_length) {
+                var current_sample = samples[index_position];
+                running_total = running_total + current_sample;
+                running_square = running_square + current_sample * current_sample;
+                if (current_sample > threshold_value) {
+                        println("sample above threshold, position recorded for the report");
+                }
+                index_position = index_position + 1;
+        }
+        return { total: running_total, square: running_square, mask: 0xFF, flags: 0b1010 };
+}
+EOT
+
+# Long runs: a wide doc comment and a long string per declaration
+cat > "$WORK/long.aria" <<'EOT'
+/*
+ * Report text kept with the code that prints it, so that translators and reviewers see the whole
+ * message in one place; every line here is a long run of comment bytes for the scanner to cross.
+ */
+var report_header = "Window statistics over the most recent samples, with running totals and the spread of values";
+EOT
+
+for i in $(seq "$COPIES"); do cat "$WORK/unit.aria"; done > "$WORK/input.aria"
+for i in $(seq "$COPIES"); do cat "$WORK/long.aria"; done > "$WORK/long_input.aria"
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "token.h"
+
+int main(int argc, char** argv) {
+    FILE* f = fopen(argv[1], "rb");
+    if (!f) return 1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char* src = malloc(size + 1);
+    if (fread(src, 1, size, f) != (size_t)size) return 1;
+    src[size] = '\0';
+    fclose(f);
+
+    int rounds = argc > 2 ? atoi(argv[2]) : 10;
+    unsigned long long checksum = 0;
+    int count = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < rounds; r++) {
+        TokenArray tokens;
+        if (!lex_all(src, size, &tokens)) return 1;
+        count = tokens.count;
+        if (r == 0) {
+            for (int i = 0; i < tokens.count; i++) {
+                LexToken* t = &tokens.tokens[i];
+                checksum = checksum * 31 + t->type * 7 + t->offset * 3 + t->length + t->line;
+            }
+        }
+        token_array_free(&tokens);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%d %llx %.0f\n", count, checksum, (double)size * rounds / secs / 1e6);
+    return 0;
+}
+EOT
+
+echo "Aria Lexer Benchmark"
+echo "===================="
+echo "Input: $(( $(wc -c < "$WORK/input.aria") / 1024 )) KB of code, $(( $(wc -c < "$WORK/long_input.aria") / 1024 )) KB of long runs"
+
+$CC -O2 -march=native -Isrc/frontend -o "$WORK/scalar" "$WORK/bench.c" src/frontend/lexer.c || { echo "Build failed"; exit 1; }
+$CC -O2 -march=native -DARIA_VECTOR_LEXER -Isrc/frontend -o "$WORK/vector" "$WORK/bench.c" src/frontend/lexer.c || { echo "Build failed"; exit 1; }
+
+STATUS=0
+for INPUT in input long_input; do
+    read -r SCALAR_TOKENS SCALAR_SUM SCALAR_MBS < <("$WORK/scalar" "$WORK/$INPUT.aria")
+    read -r VECTOR_TOKENS VECTOR_SUM VECTOR_MBS < <("$WORK/vector" "$WORK/$INPUT.aria")
+
+    echo ""
+    [ "$INPUT" = input ] && echo "Ordinary code:" || echo "Long comments and strings:"
+    printf "  %-24s %8s tokens %6s MB/s\n" "bytewise scanner:" "$SCALAR_TOKENS" "$SCALAR_MBS"
+    printf "  %-24s %8s tokens %6s MB/s\n" "vector scanner:" "$VECTOR_TOKENS" "$VECTOR_MBS"
+
+    if [ "$VECTOR_TOKENS" != "$SCALAR_TOKENS" ] || [ "$VECTOR_SUM" != "$SCALAR_SUM" ]; then
+        echo "  FAIL: the scanners produced different token streams"
+        STATUS=1
+    fi
+done
+exit $STATUS
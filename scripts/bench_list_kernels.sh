@@ -0,0 +1,256 @@
+#!/bin/bash
+
+# Aria List Kernel Benchmark
+# Times list_sum, list_dot, list_min, list_max and list_map_mul over an int
+# list and a float list of N items, in ns per item, at every kernel level
+# the CPU supports (stdlib/list_kernels.c), against loops over boxed Values
+# that call an add / multiply / compare per item, as compiled Aria code
+# does. Reports the layout each list was stored in and its bytes per item.
+# Every level must give the loops' results. Allocation is a bump arena so
+# the timings are the kernels', not the collector's. Then runs the list_*
+# kernels from an Aria program. Exits non-zero if any check fails.
+#
+# Usage: scripts/bench_list_kernels.sh [items]
+
+N=${1:-10000000}
+CC=${CC:-gcc}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/stdlib/list_kernels.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+
+void* list_new(void);
+void list_push(void* list_tagged, void* item_tagged);
+void* list_header(void* list_tagged);
+void* list_sum(void* list_tagged);
+void* list_min(void* list_tagged);
+void* list_max(void* list_tagged);
+void* list_dot(void* a_tagged, void* b_tagged);
+void* list_map_mul(void* list_tagged, void* x_tagged);
+const char* aria_list_kernels_use(const char* limit);
+
+typedef uint64_t Value;
+#define QNAN_MASK   0x7FF8000000000000ULL
+#define TAG_BASE    (QNAN_MASK | 0x8000000000000000ULL)
+#define TAG_INTEGER (TAG_BASE | (4ULL << 48))
+#define INTS_TAG    0xFFFF000000000000ULL
+#define IS_DOUBLE(v) (((v) & QNAN_MASK) != QNAN_MASK)
+enum { LIST_EMPTY, LIST_INTS, LIST_DOUBLES, LIST_VALUES };
+typedef struct { uint64_t* items; int capacity; int count; char writer; int kind; } ListHeader;
+
+static Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
+static Value box_double(double d) { Value v; memcpy(&v, &d, 8); return v; }
+static double unbox_double(Value v) { double d; memcpy(&d, &v, 8); return d; }
+static int is_int(Value v) { return (v & 0xFFFF000000000000ULL) == TAG_INTEGER; }
+static double number(Value v) { return is_int(v) ? (double)(int32_t)v : unbox_double(v); }
+
+// The collector is not linked in: everything comes from one arena
+static char* arena;
+static size_t arena_used, arena_size = (size_t)16 << 30;
+void* aria_alloc(size_t size) {
+    size_t at = arena_used;
+    arena_used += (size + 15) & ~(size_t)15;
+    if (arena_used > arena_size) { fprintf(stderr, "arena exhausted\n"); exit(2); }
+    return arena + at;
+}
+
+// --- Boxed loops: one call per item, each boxing its result ---
+
+__attribute__((noinline)) static Value boxed_add(Value a, Value b) {
+    if (is_int(a) && is_int(b)) return box_int((int32_t)((uint32_t)a + (uint32_t)b));
+    return box_double(number(a) + number(b));
+}
+
+__attribute__((noinline)) static Value boxed_mul(Value a, Value b) {
+    if (is_int(a) && is_int(b)) return box_int((int32_t)((uint32_t)a * (uint32_t)b));
+    return box_double(number(a) * number(b));
+}
+
+__attribute__((noinline)) static int boxed_less(Value a, Value b) { return number(a) < number(b); }
+
+static Value loop_sum(const Value* v, int n) {
+    Value acc = box_int(0);
+    for (int i = 0; i < n; i++) acc = boxed_add(acc, v[i]);
+    return acc;
+}
+
+static Value loop_dot(const Value* a, const Value* b, int n) {
+    Value acc = box_int(0);
+    for (int i = 0; i < n; i++) acc = boxed_add(acc, boxed_mul(a[i], b[i]));
+    return acc;
+}
+
+static Value loop_range(const Value* v, int n, int largest) {
+    Value best = v[0];
+    for (int i = 1; i < n; i++) {
+        if (largest ? boxed_less(best, v[i]) : boxed_less(v[i], best)) best = v[i];
+    }
+    return best;
+}
+
+static Value loop_map_sum(const Value* v, int n, Value x) {
+    Value* out = aria_alloc(sizeof(Value) * n);
+    for (int i = 0; i < n; i++) out[i] = boxed_mul(v[i], x);
+    return loop_sum(out, n);
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static const char* layout(void* list, int* bytes) {
+    ListHeader* h = list_header(list);
+    int packed = ((uint64_t)h->items & INTS_TAG) != 0;
+    *bytes = packed ? 4 : 8;
+    return packed ? "ints" : h->kind == LIST_DOUBLES ? "floats" : "values";
+}
+
+static void row(const char* name, const char* stored, int bytes, const double* t, int n) {
+    printf("  %-8s %-7s %10d", name, stored, bytes);
+    for (int k = 0; k < 5; k++) printf(" %7.2f", t[k] * 1e9 / n);
+    printf("\n");
+}
+
+static const char* LEVELS[] = { "scalar", "avx2" };
+
+int main(int argc, char** argv) {
+    int n = atoi(argv[1]);
+    arena = mmap(NULL, arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arena == MAP_FAILED) { printf("  cannot reserve the arena\n"); return 1; }
+    int failed = 0;
+
+    // Sums stay exact in any order: small ints, and floats in quarters
+    printf("  %d items, ns per item\n", n);
+    for (int f = 0; f < 2; f++) {
+        Value* a = malloc(sizeof(Value) * n);
+        Value* b = malloc(sizeof(Value) * n);
+        void* la = list_new();
+        void* lb = list_new();
+        for (int i = 0; i < n; i++) {
+            a[i] = f ? box_double(((i % 1000) - 500) * 0.25) : box_int(i % 7 - 3);
+            b[i] = f ? box_double(((i * 7 % 1000) - 500) * 0.25) : box_int(i * 3 % 5 - 2);
+            list_push(la, (void*)a[i]);
+            list_push(lb, (void*)b[i]);
+        }
+        Value x = f ? box_double(0.5) : box_int(3);
+        const char* kind = f ? "floats" : "ints";
+        double t[5];
+        printf("\n  %-16s bytes/item     sum     dot     min     max   map*x\n", kind);
+
+        Value want[5];
+        double t0 = now();
+        want[0] = loop_sum(a, n);
+        double t1 = now();
+        want[1] = loop_dot(a, b, n);
+        double t2 = now();
+        want[2] = loop_range(a, n, 0);
+        double t3 = now();
+        want[3] = loop_range(a, n, 1);
+        double t4 = now();
+        want[4] = loop_map_sum(a, n, x);
+        double t5 = now();
+        t[0] = t1 - t0; t[1] = t2 - t1; t[2] = t3 - t2; t[3] = t4 - t3; t[4] = t5 - t4;
+        row("boxed", "values", 8, t, n);
+
+        for (int l = 0; l < 2; l++) {
+            const char* level = aria_list_kernels_use(LEVELS[l]);
+            if (strcmp(level, LEVELS[l]) != 0) continue;
+            Value got[5];
+            int bytes;
+            const char* stored = layout(la, &bytes);
+            t0 = now();
+            got[0] = (Value)list_sum(la);
+            t1 = now();
+            got[1] = (Value)list_dot(la, lb);
+            t2 = now();
+            got[2] = (Value)list_min(la);
+            t3 = now();
+            got[3] = (Value)list_max(la);
+            t4 = now();
+            void* mapped = list_map_mul(la, (void*)x);
+            t5 = now();
+            got[4] = (Value)list_sum(mapped);
+            t[0] = t1 - t0; t[1] = t2 - t1; t[2] = t3 - t2; t[3] = t4 - t3; t[4] = t5 - t4;
+            row(level, stored, bytes, t, n);
+            for (int k = 0; k < 5; k++) {
+                if (got[k] != want[k]) {
+                    printf("  %-8s %-7s result %d differs from the boxed loop\n", level, kind, k);
+                    failed = 1;
+                }
+            }
+        }
+        free(a);
+        free(b);
+    }
+    return failed;
+}
+EOT
+
+echo "Aria List Kernel Benchmark"
+echo "=========================="
+echo "Items: $N"
+echo ""
+
+$CC -O2 -std=c99 -D_GNU_SOURCE -o "$WORK/bench" "$WORK/bench.c" src/stdlib/dataStructures.c \
+    src/stdlib/list_kernels.c -lpthread 2> /dev/null ||
+    { echo "Build failed"; exit 1; }
+
+FAILED=0
+"$WORK/bench" "$N" || { echo ""; echo "FAIL: a kernel disagreed with the boxed loop"; FAILED=1; }
+
+cat > "$WORK/prog.aria" <<'EOT'
+func main() {
+    var xs = [];
+    var i = 0;
+    while (i < 1000) { list_push(xs, i % 7); i = i + 1; }
+    var total = 0;
+    for (var x in xs) { total = total + x; }
+    println(format("%d %d", total, list_sum(xs)));
+    println(format("%d %d", list_min(xs), list_max(xs)));
+    var ys = list_map_mul(xs, 3);
+    println(format("%d", list_dot(xs, ys)));
+    var fs = [1.5, 2.5, -3.0];
+    println(format("%f %f", list_sum(fs), list_max(fs)));
+    println(format("%f", list_sum(list_map_add(xs, 0.5))));
+    xs[3] = "s";
+    var n = 0;
+    for (var x in xs) { n = n + 1; }
+    println(format("%d %s %d", n, xs[3], list_sum(xs)));
+}
+EOT
+cat > "$WORK/expect.txt" <<'EOT'
+2997 2997
+0 6
+38931
+1.000000 2.500000
+3497.000000
+1000 s 2994
+EOT
+
+echo ""
+if "$COMPILER" "$WORK/prog.aria" --no-cache > /dev/null && "$WORK/prog" > "$WORK/out.txt" 2> /dev/null &&
+   cmp -s "$WORK/out.txt" "$WORK/expect.txt"; then
+    echo "  ok    list_sum / min / max / dot / map from Aria"
+else
+    echo "  FAIL  list_sum / min / max / dot / map from Aria"
+    FAILED=1
+fi
+exit $FAILED
@@ -0,0 +1,262 @@
+#!/bin/bash
+
+# Aria List Benchmark
+# Times list_get, list_set and list_push in ns per call, against the same
+# functions built around a pthread_rwlock per list (a copy of the previous
+# implementation kept here for comparison):
+#   - from one thread, over a list of N items,
+#   - with reader threads calling list_get at random indices while one
+#     writer pushes N items, so the item array is replaced many times under
+#     the readers.
+# Every value read must be the one pushed at that index. Allocation is a
+# bump arena so the timings are the list's, not the collector's. Then runs
+# an indexed Aria loop over a list. Exits non-zero if any check fails.
+#
+# Usage: scripts/bench_lists.sh [items] [reader threads]
+
+N=${1:-10000000}
+READERS=${2:-3}
+CC=${CC:-gcc}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/stdlib/dataStructures.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+void* list_new(void);
+void list_push(void* list_tagged, void* item_tagged);
+void* list_get(void* list_tagged, void* index_tagged);
+void* list_set(void* list_tagged, void* index_tagged, void* val_tagged);
+void* list_header(void* list_tagged);
+
+#define TAG_LIST    0xFFF8000000000007ULL
+#define PTR_MASK    0x0000FFFFFFFFFFFFULL
+typedef struct { uint64_t* items; int capacity; int count; } ListHeader;
+
+// The collector is not linked in: everything comes from one arena
+static char* arena;
+static size_t arena_used, arena_size = (size_t)16 << 30;
+static pthread_mutex_t arena_lock = PTHREAD_MUTEX_INITIALIZER;
+void* aria_alloc(size_t size) {
+    pthread_mutex_lock(&arena_lock);
+    size_t at = arena_used;
+    arena_used += (size + 15) & ~(size_t)15;
+    pthread_mutex_unlock(&arena_lock);
+    if (arena_used > arena_size) { fprintf(stderr, "arena exhausted\n"); exit(2); }
+    return arena + at;
+}
+
+// --- The previous list: a pthread_rwlock taken by every call ---
+
+typedef struct {
+    uint64_t* items;
+    int capacity;
+    int count;
+    pthread_rwlock_t lock;
+} RwList;
+
+static void* rw_new(void) {
+    RwList* list = aria_alloc(sizeof(RwList));
+    list->capacity = 8;
+    list->items = aria_alloc(sizeof(uint64_t) * list->capacity);
+    pthread_rwlock_init(&list->lock, NULL);
+    return (void*)(TAG_LIST | (uintptr_t)list);
+}
+
+static void rw_push(void* list_tagged, void* item) {
+    RwList* list = (RwList*)((uint64_t)list_tagged & PTR_MASK & ~7ULL);
+    pthread_rwlock_wrlock(&list->lock);
+    if (list->count >= list->capacity) {
+        int new_cap = list->capacity * 2;
+        uint64_t* new_items = aria_alloc(sizeof(uint64_t) * new_cap);
+        memcpy(new_items, list->items, sizeof(uint64_t) * list->count);
+        list->items = new_items;
+        list->capacity = new_cap;
+    }
+    list->items[list->count++] = (uint64_t)item;
+    pthread_rwlock_unlock(&list->lock);
+}
+
+static void* rw_get(void* list_tagged, void* index_tagged) {
+    RwList* list = (RwList*)((uint64_t)list_tagged & PTR_MASK & ~7ULL);
+    int index = (int)((uint64_t)index_tagged & 0xFFFFFFFF);
+    pthread_rwlock_rdlock(&list->lock);
+    if (index < 0 || index >= list->count) { fprintf(stderr, "Runtime Error: Index OOB\n"); exit(1); }
+    uint64_t val = list->items[index];
+    pthread_rwlock_unlock(&list->lock);
+    return (void*)val;
+}
+
+static void* rw_set(void* list_tagged, void* index_tagged, void* val) {
+    RwList* list = (RwList*)((uint64_t)list_tagged & PTR_MASK & ~7ULL);
+    int index = (int)((uint64_t)index_tagged & 0xFFFFFFFF);
+    pthread_rwlock_wrlock(&list->lock);
+    if (index < 0 || index >= list->count) { fprintf(stderr, "Runtime Error: Index OOB\n"); exit(1); }
+    list->items[index] = (uint64_t)val;
+    pthread_rwlock_unlock(&list->lock);
+    return val;
+}
+
+static int rw_count(void* list_tagged) {
+    RwList* list = (RwList*)((uint64_t)list_tagged & PTR_MASK & ~7ULL);
+    pthread_rwlock_rdlock(&list->lock);
+    int count = list->count;
+    pthread_rwlock_unlock(&list->lock);
+    return count;
+}
+
+static int lf_count(void* list_tagged) {
+    return atomic_load_explicit((_Atomic int*)&((ListHeader*)list_header(list_tagged))->count, memory_order_acquire);
+}
+
+typedef struct {
+    const char* name;
+    void* (*make)(void);
+    void (*push)(void*, void*);
+    void* (*get)(void*, void*);
+    void* (*set)(void*, void*, void*);
+    int (*count)(void*);
+} Impl;
+
+static const Impl IMPLS[] = {
+    { "rwlock", rw_new, rw_push, rw_get, rw_set, rw_count },
+    { "lock-free", list_new, list_push, list_get, list_set, lf_count }
+};
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Indices and items are ints, which the runtime reads from the low 32 bits
+static void* tag(int i) { return (void*)(uintptr_t)(uint32_t)i; }
+
+typedef struct {
+    const Impl* impl;
+    void* list;
+    atomic_int* done;
+    long reads, bad;
+    uint64_t seed;
+} Reader;
+
+// Random reads below the count seen, until the writer is done
+static void* reader(void* arg) {
+    Reader* r = arg;
+    while (!atomic_load_explicit(r->done, memory_order_acquire)) {
+        for (int k = 0; k < 1024; k++) {
+            int count = r->impl->count(r->list);
+            if (count == 0) continue;
+            r->seed ^= r->seed << 13; r->seed ^= r->seed >> 7; r->seed ^= r->seed << 17;
+            int i = (int)(r->seed % (uint64_t)count);
+            r->bad += r->impl->get(r->list, tag(i)) != tag(i);
+            r->reads++;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int n = atoi(argv[1]), readers = atoi(argv[2]);
+    arena = mmap(NULL, arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arena == MAP_FAILED) { printf("  cannot reserve the arena\n"); return 1; }
+    int failed = 0;
+
+    printf("  one thread, %d items                 push    get    set  (ns per call)\n", n);
+    for (int m = 0; m < 2; m++) {
+        const Impl* impl = &IMPLS[m];
+        void* list = impl->make();
+        double t0 = now();
+        for (int i = 0; i < n; i++) impl->push(list, tag(i));
+        double t1 = now();
+        long bad = 0;
+        for (int i = 0; i < n; i++) bad += impl->get(list, tag(i)) != tag(i);
+        double t2 = now();
+        for (int i = 0; i < n; i++) impl->set(list, tag(i), tag(n - i));
+        double t3 = now();
+        for (int i = 0; i < n; i++) bad += impl->get(list, tag(i)) != tag(n - i);
+        printf("  %-10s %32.2f %6.2f %6.2f\n", impl->name, (t1 - t0) * 1e9 / n, (t2 - t1) * 1e9 / n,
+               (t3 - t2) * 1e9 / n);
+        if (bad) { printf("  %-10s %ld wrong values\n", impl->name, bad); failed = 1; }
+    }
+
+    printf("\n  %d readers, 1 writer pushing %d items   reads/s (millions)   push ns\n", readers, n);
+    for (int m = 0; m < 2; m++) {
+        const Impl* impl = &IMPLS[m];
+        void* list = impl->make();
+        atomic_int done = 0;
+        Reader* rs = calloc((size_t)readers, sizeof(Reader));
+        pthread_t* ts = calloc((size_t)readers, sizeof(pthread_t));
+        for (int r = 0; r < readers; r++) {
+            rs[r] = (Reader){ impl, list, &done, 0, 0, 88172645463325252ULL + (uint64_t)r };
+            pthread_create(&ts[r], NULL, reader, &rs[r]);
+        }
+        double t0 = now();
+        for (int i = 0; i < n; i++) impl->push(list, tag(i));
+        double t1 = now();
+        atomic_store(&done, 1);
+        long reads = 0, bad = 0;
+        for (int r = 0; r < readers; r++) {
+            pthread_join(ts[r], NULL);
+            reads += rs[r].reads;
+            bad += rs[r].bad;
+        }
+        printf("  %-10s %38.1f %12.2f\n", impl->name, reads / (t1 - t0) / 1e6, (t1 - t0) * 1e9 / n);
+        if (bad) { printf("  %-10s %ld reads saw a wrong value\n", impl->name, bad); failed = 1; }
+        free(rs);
+        free(ts);
+    }
+    return failed;
+}
+EOT
+
+echo "Aria List Benchmark"
+echo "==================="
+echo "Items: $N, reader threads: $READERS"
+echo ""
+
+$CC -O2 -std=c99 -D_GNU_SOURCE -o "$WORK/bench" "$WORK/bench.c" src/stdlib/dataStructures.c src/stdlib/list_kernels.c -lpthread 2> /dev/null ||
+    { echo "Build failed"; exit 1; }
+
+FAILED=0
+"$WORK/bench" "$N" "$READERS" || { echo ""; echo "FAIL: a read returned the wrong value"; FAILED=1; }
+
+cat > "$WORK/prog.aria" <<'EOT'
+func main() {
+    var xs = [];
+    var i = 0;
+    while (i < 100000) { list_push(xs, i % 7); i = i + 1; }
+    var j = 0;
+    while (j < 100000) { xs[j] = xs[j] * 2; j = j + 1; }
+    var total = 0;
+    j = 0;
+    while (j < 100000) { total = total + xs[j]; j = j + 1; }
+    println(format("%d", total));
+}
+EOT
+
+echo ""
+if "$COMPILER" "$WORK/prog.aria" --no-cache > /dev/null && [ "$("$WORK/prog" 2> /dev/null)" = "599990" ]; then
+    echo "  ok    list_push / list_get / list_set from Aria"
+else
+    echo "  FAIL  list_push / list_get / list_set from Aria"
+    FAILED=1
+fi
+exit $FAILED
@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# Aria Loop Benchmark
+# Sums a large list with an indexed while loop (a list_get call per element)
+# and with 'for (var x in list)' / a counted 'for', which compile to direct
+# element loads and an unboxed counter. Exits non-zero if the two programs
+# print different totals or the for loops are not faster.
+#
+# Usage: scripts/bench_loops.sh [list length] [passes]
+
+N=${1:-1000000}
+PASSES=${2:-20}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/indexed.aria" <<EOF
+func main() {
+    var xs = [];
+    var i = 0;
+    while (i < $N) { list_push(xs, i % 7); i = i + 1; }
+    var total = 0;
+    var pass = 0;
+    while (pass < $PASSES) {
+        var j = 0;
+        while (j < $N) { total = total + xs[j]; j = j + 1; }
+        pass = pass + 1;
+    }
+    dyn_print(total);
+}
+EOF
+
+cat > "$WORK/foreach.aria" <<EOF
+func main() {
+    var xs = [];
+    for (var i = 0; i < $N; i = i + 1) list_push(xs, i % 7);
+    var total = 0;
+    for (var pass = 0; pass < $PASSES; pass = pass + 1) {
+        for (var x in xs) total = total + x;
+    }
+    dyn_print(total);
+}
+EOF
+
+echo "Aria Loop Benchmark"
+echo "==================="
+echo "Program: $PASSES passes over a $N-element list"
+echo ""
+
+# Builds one program, runs it once and prints its run time in ms
+run_variant() {
+    local out="$WORK/$1"
+    "$COMPILER" "$out.aria" --no-cache > /dev/null || return 1
+    local start end
+    start=$(date +%s%N)
+    "$out" > "$out.stdout" || return 1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+INDEXED_MS=$(run_variant indexed) || { echo "Indexed build failed"; exit 1; }
+FOREACH_MS=$(run_variant foreach) || { echo "For-each build failed"; exit 1; }
+
+printf "  %-28s %6s ms\n" "while + list_get:" "$INDEXED_MS"
+printf "  %-28s %6s ms\n" "for-each:" "$FOREACH_MS"
+
+if ! cmp -s "$WORK/indexed.stdout" "$WORK/foreach.stdout"; then
+    echo ""
+    echo "FAIL: the loops computed different totals"
+    exit 1
+fi
+if ! [ "$FOREACH_MS" -lt "$INDEXED_MS" ]; then
+    echo ""
+    echo "FAIL: for-each was not faster than indexed iteration"
+    exit 1
+fi
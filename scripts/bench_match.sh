@@ -0,0 +1,112 @@
+#!/bin/bash
+
+# Aria Match Benchmark
+# Dispatches over 50 integer cases with an if/else chain (one dyn_eq call per
+# comparison) and with 'match' (one jump table lookup), then over 50 string
+# cases with 'match' (one hash and one confirming compare). Exits non-zero if
+# any program prints a total other than the expected one or match is not
+# faster than the chain.
+#
+# Usage: scripts/bench_match.sh [iterations]
+
+N=${1:-2000000}
+CASES=50
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+# route(k) returns k * 3 + 1 for every case, 0 otherwise
+{
+    echo "func route(k) {"
+    echo "    if (k == 0) { return 1; }"
+    for ((i = 1; i < CASES; i++)); do echo "    else if (k == $i) { return $((i * 3 + 1)); }"; done
+    echo "    return 0;"
+    echo "}"
+} > "$WORK/chain.inc"
+{
+    echo "func route(k) {"
+    echo "    match (k) {"
+    for ((i = 0; i < CASES; i++)); do echo "        $i -> return $((i * 3 + 1));"; done
+    echo "    }"
+    echo "    return 0;"
+    echo "}"
+} > "$WORK/table.inc"
+{
+    echo "func route(k) {"
+    echo "    match (k) {"
+    for ((i = 0; i < CASES; i++)); do echo "        \"route$i\" -> return $((i * 3 + 1));"; done
+    echo "    }"
+    echo "    return 0;"
+    echo "}"
+} > "$WORK/strings.inc"
+
+MAIN_INT="
+func main() {
+    var total = 0;
+    var i = 0;
+    while (i < $N) { total = total + route(i % $((CASES + 1))); i = i + 1; }
+    dyn_print(total);
+}"
+for variant in chain table; do
+    cat "$WORK/$variant.inc" > "$WORK/$variant.aria"
+    echo "$MAIN_INT" >> "$WORK/$variant.aria"
+done
+
+# String subjects come from a list built once, so the loop only measures dispatch
+{
+    cat "$WORK/strings.inc"
+    echo "func main() {"
+    echo "    var keys = [];"
+    for ((i = 0; i <= CASES; i++)); do echo "    list_push(keys, \"route$i\");"; done
+    echo "    var total = 0;"
+    echo "    var i = 0;"
+    echo "    while (i < $N) { total = total + route(keys[i % $((CASES + 1))]); i = i + 1; }"
+    echo "    dyn_print(total);"
+    echo "}"
+} > "$WORK/strings.aria"
+
+echo "Aria Match Benchmark"
+echo "===================="
+echo "Program: $N dispatches over $CASES cases"
+echo ""
+
+# Builds one program, runs it once and prints its run time in ms
+run_variant() {
+    local out="$WORK/$1"
+    "$COMPILER" "$out.aria" --no-cache > /dev/null || return 1
+    local start end
+    start=$(date +%s%N)
+    "$out" > "$out.stdout" || return 1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+CHAIN_MS=$(run_variant chain) || { echo "If/else build failed"; exit 1; }
+TABLE_MS=$(run_variant table) || { echo "Integer match build failed"; exit 1; }
+STRING_MS=$(run_variant strings) || { echo "String match build failed"; exit 1; }
+
+printf "  %-28s %6s ms\n" "if/else chain (ints):" "$CHAIN_MS"
+printf "  %-28s %6s ms\n" "match (ints):" "$TABLE_MS"
+printf "  %-28s %6s ms\n" "match (strings):" "$STRING_MS"
+
+# Each run of CASES + 1 subjects adds up route(0) .. route(CASES - 1), then 0
+PER_RUN=$(( 3 * CASES * (CASES - 1) / 2 + CASES ))
+LEFT=$(( N % (CASES + 1) < CASES ? N % (CASES + 1) : CASES ))
+EXPECT=$(( N / (CASES + 1) * PER_RUN + 3 * LEFT * (LEFT - 1) / 2 + LEFT ))
+for variant in chain table strings; do
+    if [ "$(cat "$WORK/$variant.stdout")" != "$EXPECT" ]; then
+        echo ""
+        echo "FAIL: $variant dispatch printed $(cat "$WORK/$variant.stdout"), expected $EXPECT"
+        exit 1
+    fi
+done
+if ! [ "$TABLE_MS" -lt "$CHAIN_MS" ]; then
+    echo ""
+    echo "FAIL: match was not faster than the if/else chain"
+    exit 1
+fi
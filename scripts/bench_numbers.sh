@@ -0,0 +1,212 @@
+#!/bin/bash
+
+# Aria Number Text Benchmark
+# Times the integer and float formatting print and format() use
+# (aria_int_text / aria_float_text in stdlib/io.c) against snprintf, and
+# the parsers behind parse_int / parse_float against strtoll / strtod.
+# Every result is compared with the C library's, on the timed values and on
+# random edge cases: ties, tiny and huge floats, long mantissas and junk
+# after the number. Then runs parse_int / parse_float from an Aria program.
+# Exits non-zero if any result differs.
+#
+# Usage: scripts/bench_numbers.sh [values]
+
+N=${1:-2000000}
+CC=${CC:-gcc}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/stdlib/io.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "number_text.h"
+
+// The rest of the runtime is not linked in
+void* aria_alloc(size_t size) { return calloc(1, size); }
+void* dyn_add(void* a, void* b) { (void)a; (void)b; return NULL; }
+void* dyn_new_int(long long v) { return (void*)(intptr_t)v; }
+void* dyn_new_float(long long bits) { return (void*)(intptr_t)bits; }
+void* list_new(void) { return NULL; }
+void list_push(void* list, void* item) { (void)list; (void)item; }
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint64_t seed = 88172645463325252ULL;
+static uint64_t next(void) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    return seed;
+}
+
+static int failures = 0;
+static void fail(const char* what, const char* input, const char* got, const char* want) {
+    if (failures++ < 10) printf("  mismatch in %s for %s: got %s, want %s\n", what, input, got, want);
+}
+
+static void check_int(int64_t n) {
+    char got[32], want[32];
+    got[aria_int_text(got, n)] = '\0';
+    snprintf(want, sizeof(want), "%lld", (long long)n);
+    if (strcmp(got, want) != 0) fail("int text", want, got, want);
+}
+
+static void check_float(double f) {
+    char got[FLOAT_TEXT_MAX], want[FLOAT_TEXT_MAX];
+    got[aria_float_text(got, f)] = '\0';
+    snprintf(want, sizeof(want), "%.6f", f);
+    if (strcmp(got, want) != 0) fail("float text", want, got, want);
+}
+
+static void check_parse(const char* s) {
+    char *got_end, *want_end;
+    double got = aria_parse_double(s, &got_end), want = strtod(s, &want_end);
+    if (memcmp(&got, &want, sizeof(double)) != 0 || got_end != want_end) {
+        char a[40], b[40];
+        snprintf(a, sizeof(a), "%.17g+%d", got, (int)(got_end - s));
+        snprintf(b, sizeof(b), "%.17g+%d", want, (int)(want_end - s));
+        fail("parse_float", s, a, b);
+    }
+    long long gi = aria_parse_int(s, &got_end), wi = strtoll(s, &want_end, 10);
+    if (gi != wi || got_end != want_end) fail("parse_int", s, "?", "?");
+}
+
+// Values like the ones metrics and CSV files hold
+static double metric_double(void) {
+    switch (next() % 3) {
+        case 0: return (double)(int64_t)(next() >> (next() % 64)) / (double)(1ULL << (next() % 40));
+        case 1: return (double)(next() % 2000001) / 2e6 * (next() % 2 ? 1 : -1);
+        default: return ((double)(next() % 100000000) + 0.5) / 1e6;
+    }
+}
+
+// A double of any magnitude, or one with few bits near a rounding tie
+static double random_double(void) {
+    union { uint64_t u; double d; } v;
+    v.u = next();
+    return next() % 4 == 0 ? v.d : metric_double();
+}
+
+static void random_number_text(char* s, size_t size) {
+    static const char* JUNK[] = { "", ",", "e", "e+", "x", " 7", ".", "E-", "abc" };
+    char body[64];
+    double d = random_double();
+    switch (next() % 6) {
+        case 0: snprintf(body, sizeof(body), "%.17g", d); break;
+        case 1: snprintf(body, sizeof(body), "%.6f", d); break;
+        case 2: snprintf(body, sizeof(body), "%e", d); break;
+        case 3: snprintf(body, sizeof(body), "%lld", (long long)(next() >> (next() % 64))); break;
+        case 4: snprintf(body, sizeof(body), "%lld.%03de%d", (long long)(next() % 100000), (int)(next() % 1000), (int)(next() % 60) - 30); break;
+        default: snprintf(body, sizeof(body), "%s%llu", next() % 2 ? "-" : "+", (unsigned long long)(next() % 1000)); break;
+    }
+    snprintf(s, size, "%s%s", body, JUNK[next() % 9]);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    static const char* EDGES[] = {
+        "0", "-0", "0.0", ".5", "5.", ".", "-", "+", "", " 1.5", "0x1p3", "-0x10", "inf", "-Infinity",
+        "nan", "1e", "1e+", "1e-400", "1e400", "9007199254740993", "9007199254740992e-22",
+        "123456789012345678901234567890", "0.000000000000000000000000001", "1.7976931348623157e308",
+        "4.9e-324", "2.2250738585072014e-308", "9223372036854775807", "9223372036854775808",
+        "-9223372036854775808", "00000000000000000000000000012.5", "1_000", "12,34"
+    };
+    for (size_t i = 0; i < sizeof(EDGES) / sizeof(*EDGES); i++) check_parse(EDGES[i]);
+    static const double FLOAT_EDGES[] = {
+        0.0, -0.0, 0.5e-6, -0.5e-6, 1.5e-6, 2.5e-6, 0.0078125, 9.2233720368547758e18,
+        9.2233720368547748e18, 1e300, -1e-300, 4.9e-324, 1.0 / 0.0, -1.0 / 0.0
+    };
+    for (size_t i = 0; i < sizeof(FLOAT_EDGES) / sizeof(*FLOAT_EDGES); i++) check_float(FLOAT_EDGES[i]);
+    check_int(INT64_MIN); check_int(INT64_MAX); check_int(0); check_int(-1);
+
+    int64_t* ints = malloc(sizeof(int64_t) * n);
+    double* floats = malloc(sizeof(double) * n);
+    char* texts = malloc((size_t)n * 64);
+    for (int i = 0; i < n; i++) {
+        ints[i] = (int64_t)next() >> (next() % 64);
+        floats[i] = metric_double();
+        random_number_text(texts + (size_t)i * 64, 64);
+        check_int(ints[i]);
+        check_float(floats[i]);
+        check_float(random_double());
+        check_parse(texts + (size_t)i * 64);
+    }
+
+    char buf[FLOAT_TEXT_MAX];
+    volatile long sink = 0;
+    double t0 = now();
+    for (int i = 0; i < n; i++) sink += snprintf(buf, sizeof(buf), "%lld", (long long)ints[i]);
+    double t1 = now();
+    for (int i = 0; i < n; i++) sink += aria_int_text(buf, ints[i]);
+    double t2 = now();
+    for (int i = 0; i < n; i++) sink += snprintf(buf, sizeof(buf), "%.6f", floats[i]);
+    double t3 = now();
+    for (int i = 0; i < n; i++) sink += aria_float_text(buf, floats[i]);
+    double t4 = now();
+    double total = 0;
+    for (int i = 0; i < n; i++) total += strtod(texts + (size_t)i * 64, NULL);
+    double t5 = now();
+    for (int i = 0; i < n; i++) total += aria_parse_double(texts + (size_t)i * 64, NULL);
+    double t6 = now();
+    for (int i = 0; i < n; i++) sink += strtoll(texts + (size_t)i * 64, NULL, 10);
+    double t7 = now();
+    for (int i = 0; i < n; i++) sink += aria_parse_int(texts + (size_t)i * 64, NULL);
+    double t8 = now();
+    (void)total;
+
+    printf("  %-26s %8.1f ns   %-14s %8.1f ns\n", "snprintf %lld:", (t1 - t0) * 1e9 / n, "aria_int_text:", (t2 - t1) * 1e9 / n);
+    printf("  %-26s %8.1f ns   %-14s %8.1f ns\n", "snprintf %.6f:", (t3 - t2) * 1e9 / n, "aria_float_text:", (t4 - t3) * 1e9 / n);
+    printf("  %-26s %8.1f ns   %-14s %8.1f ns\n", "strtod:", (t5 - t4) * 1e9 / n, "aria_parse_double:", (t6 - t5) * 1e9 / n);
+    printf("  %-26s %8.1f ns   %-14s %8.1f ns\n", "strtoll:", (t7 - t6) * 1e9 / n, "aria_parse_int:", (t8 - t7) * 1e9 / n);
+    return failures != 0;
+}
+EOT
+
+echo "Aria Number Text Benchmark"
+echo "=========================="
+echo "Values: $N of each kind, per call"
+echo ""
+
+$CC -O2 -march=native -std=c99 -D_GNU_SOURCE -Isrc/stdlib -o "$WORK/bench" "$WORK/bench.c" src/stdlib/io.c \
+    src/stdlib/string_utils.c src/stdlib/string_kernels.c -lpthread 2> /dev/null ||
+    { echo "Build failed"; exit 1; }
+
+FAILED=0
+"$WORK/bench" "$N" || { echo ""; echo "FAIL: results differ from the C library"; FAILED=1; }
+
+cat > "$WORK/prog.aria" <<'EOT'
+func main() {
+    var total = parse_int("40") + parse_int("-2x");
+    println(format("%d %f", total, parse_float("2.5e3") + parse_float("0.125")));
+    println(format("%d %f %f", parse_int("junk"), parse_float("-0.1"), 1.0 / 3.0));
+}
+EOT
+cat > "$WORK/expect.txt" <<'EOT'
+38 2500.125000
+0 -0.100000 0.333333
+EOT
+
+echo ""
+if "$COMPILER" "$WORK/prog.aria" --no-cache > /dev/null && "$WORK/prog" > "$WORK/out.txt" &&
+   cmp -s "$WORK/out.txt" "$WORK/expect.txt"; then
+    echo "  ok    parse_int / parse_float from Aria"
+else
+    echo "  FAIL  parse_int / parse_float from Aria"
+    FAILED=1
+fi
+exit $FAILED
@@ -0,0 +1,92 @@
+#!/bin/bash
+
+# Aria Profile-Guided Optimization Benchmark
+# Builds one program three ways: plain, instrumented with --profile-generate
+# (run once to write a training profile) and optimized with --profile-use
+# against that profile. The program calls a small helper, reads object
+# properties and takes a lopsided branch in a hot loop. Exits non-zero if
+# the builds print different results or the optimized build is not faster
+# than the plain one.
+#
+# Usage: scripts/bench_pgo.sh [iterations]
+
+N=${1:-2000000}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/program.aria" <<EOT
+class Point {
+    func origin() { return 0; }
+}
+
+func sq(x) { return x * x; }
+
+func classify(n) {
+    if (n % 16 == 0) {
+        return 1;
+    } else {
+        return 2;
+    }
+}
+
+func main() {
+    var p = new Point();
+    p.x = 3;
+    p.y = 4;
+    var total = 0;
+    var i = 0;
+    while (i < $N) {
+        var k = i % 100;
+        total = total + sq(k) + p.x + p.y + classify(i);
+        i = i + 1;
+    }
+    print("%d\n", total);
+}
+EOT
+
+echo "Aria PGO Benchmark"
+echo "=================="
+echo "Program: $N loop iterations"
+echo ""
+
+# Builds the program with the given flags, runs it once and prints its run time in ms
+run_variant() {
+    local name=$1
+    shift
+    cp "$WORK/program.aria" "$WORK/$name.aria"
+    "$COMPILER" "$WORK/$name.aria" --no-cache "$@" > /dev/null || return 1
+    local start end
+    start=$(date +%s%N)
+    ARIA_PROFILE="$WORK/training.profile" "$WORK/$name" > "$WORK/$name.stdout" || return 1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+PLAIN_MS=$(run_variant plain) || { echo "Plain build failed"; exit 1; }
+TRAIN_MS=$(run_variant train --profile-generate) || { echo "Instrumented build failed"; exit 1; }
+if [ ! -s "$WORK/training.profile" ]; then
+    echo "FAIL: the instrumented build wrote no profile"
+    exit 1
+fi
+OPT_MS=$(run_variant optimized --profile-use "$WORK/training.profile") || { echo "Profile-use build failed"; exit 1; }
+
+printf "  %-28s %6s ms\n" "plain:" "$PLAIN_MS"
+printf "  %-28s %6s ms\n" "instrumented:" "$TRAIN_MS"
+printf "  %-28s %6s ms\n" "profile-guided:" "$OPT_MS"
+
+if ! cmp -s "$WORK/plain.stdout" "$WORK/train.stdout" || ! cmp -s "$WORK/plain.stdout" "$WORK/optimized.stdout"; then
+    echo ""
+    echo "FAIL: the builds printed different results"
+    exit 1
+fi
+if ! [ "$OPT_MS" -lt "$PLAIN_MS" ]; then
+    echo ""
+    echo "FAIL: the profile-guided build was not faster than the plain build"
+    exit 1
+fi
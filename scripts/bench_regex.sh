@@ -0,0 +1,269 @@
+#!/bin/bash
+
+# Aria Regex Benchmark
+# Generates a log (timestamped lines with levels, services, IP addresses,
+# durations and free text) and times, in MB/s, against glibc regexec:
+#   - regex_find_all over the whole log for a literal, a literal prefix
+#     followed by classes, an IP address and an alternation,
+#   - regex_match on every line, as a log filter would.
+# Both engines must count the same matches. Then times patterns that make
+# backtracking engines exponential on 1 and 4 MB inputs; the time must grow
+# linearly. Allocation is a bump arena so the timings are the engine's, not
+# the collector's. Last, filters and rewrites a log from an Aria program.
+# Exits non-zero if any check fails.
+#
+# Usage: scripts/bench_regex.sh [log MB]
+
+LOG_MB=${1:-100}
+CC=${CC:-gcc}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/stdlib/regex.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <regex.h>
+#include <sys/mman.h>
+
+void* regex_compile(void* pattern_tagged);
+void* regex_match(void* re_tagged, void* s_tagged);
+void* regex_find_all(void* re_tagged, void* s_tagged);
+void* aria_str_box_n(const char* buf, size_t len);
+void* list_header(void* list_tagged);
+
+#define TAG_TRUE 0xFFF8000000000003ULL
+typedef struct { uint64_t* items; int capacity; int count; } ListHeader;
+
+// The collector is not linked in: every run allocates from one arena that
+// is cleared before the next, since aria_alloc returns zeroed memory
+static char* arena;
+static size_t arena_used, arena_size = (size_t)16 << 30;
+void* aria_alloc(size_t size) {
+    size_t at = arena_used;
+    arena_used += (size + 15) & ~(size_t)15;
+    if (arena_used > arena_size) { fprintf(stderr, "arena exhausted\n"); exit(2); }
+    return arena + at;
+}
+
+static void reset_arena(size_t keep) {
+    memset(arena + keep, 0, arena_used - keep);
+    arena_used = keep;
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint64_t seed = 88172645463325252ULL;
+static uint64_t next(void) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    return seed;
+}
+
+static char* make_log(size_t target, size_t* len) {
+    static const char* LEVELS[] = { "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR" };
+    static const char* SERVICES[] = { "api", "db", "auth", "cache", "queue", "billing" };
+    static const char* TEXT[] = {
+        "request served", "connection refused by upstream", "user logged in", "cache miss for key",
+        "retrying request", "timeout after %dms", "reset after %dms", "slow query took %dms",
+        "refused after %dms", "payload of %d bytes"
+    };
+    char* log = malloc(target + 256);
+    size_t n = 0;
+    while (n < target) {
+        char text[64];
+        snprintf(text, sizeof(text), TEXT[next() % 10], (int)(next() % 5000));
+        n += sprintf(log + n, "2024-05-%02d %02d:%02d:%02d.%03d %s [%s] %d.%d.%d.%d %s\n",
+                     (int)(next() % 28) + 1, (int)(next() % 24), (int)(next() % 60), (int)(next() % 60),
+                     (int)(next() % 1000), LEVELS[next() % 6], SERVICES[next() % 6], (int)(next() % 256),
+                     (int)(next() % 256), (int)(next() % 256), (int)(next() % 256), text);
+    }
+    *len = n;
+    return log;
+}
+
+// Matches of a POSIX pattern in the whole log, resuming after each
+static long posix_count(const regex_t* re, const char* log, size_t len) {
+    long count = 0;
+    size_t at = 0;
+    regmatch_t m;
+    while (at <= len) {
+        m.rm_so = (regoff_t)at;
+        m.rm_eo = (regoff_t)len;
+        if (regexec(re, log, 1, &m, REG_STARTEND | (at ? REG_NOTBOL : 0)) != 0) break;
+        count++;
+        at = m.rm_eo > m.rm_so ? (size_t)m.rm_eo : (size_t)m.rm_eo + 1;
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    size_t len;
+    char* log = make_log((size_t)atol(argv[1]) << 20, &len);
+    double mb = len / 1e6;
+    arena = mmap(NULL, arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arena == MAP_FAILED) { printf("  cannot reserve the arena\n"); return 1; }
+    void* text = aria_str_box_n(log, len);
+    printf("  log: %.1f MB\n\n", mb);
+
+    // Each pattern and its POSIX spelling
+    static const char* FIND[][3] = {
+        { "literal", "connection refused", "connection refused" },
+        { "prefix", "ERROR \\[\\w+\\] [\\d.]+", "ERROR \\[[[:alnum:]_]+\\] [0-9.]+" },
+        { "ip", "\\d+\\.\\d+\\.\\d+\\.\\d+", "[0-9]+\\.[0-9]+\\.[0-9]+\\.[0-9]+" },
+        { "alternation", "(?:timeout|refused|reset) after \\d+ms", "(timeout|refused|reset) after [0-9]+ms" }
+    };
+    int failed = 0;
+    size_t keep = arena_used;
+    for (int p = 0; p < 4; p++) {
+        regex_t posix;
+        regcomp(&posix, FIND[p][2], REG_EXTENDED);
+        void* re = regex_compile(aria_str_box_n(FIND[p][1], strlen(FIND[p][1])));
+        reset_arena(keep);
+        double t0 = now();
+        long count = ((ListHeader*)list_header(regex_find_all(re, text)))->count;
+        double t1 = now();
+        long want = posix_count(&posix, log, len);
+        double t2 = now();
+        printf("  find_all %-12s %8ld matches   aria %8.1f MB/s   regexec %8.1f MB/s\n", FIND[p][0], count,
+               mb / (t1 - t0), mb / (t2 - t1));
+        if (count != want) {
+            printf("  find_all %-12s regexec finds %ld\n", FIND[p][0], want);
+            failed = 1;
+        }
+        regfree(&posix);
+    }
+
+    // One string per line, boxed before timing
+    reset_arena(keep);
+    size_t n_lines = 0;
+    for (size_t i = 0; i < len; i++) n_lines += log[i] == '\n';
+    void** lines = malloc(sizeof(void*) * n_lines);
+    size_t* starts = malloc(sizeof(size_t) * (n_lines + 1));
+    for (size_t i = 0, at = 0, k = 0; i < len; i++) {
+        if (log[i] != '\n') continue;
+        starts[k] = at;
+        lines[k++] = aria_str_box_n(log + at, i - at);
+        at = i + 1;
+    }
+    starts[n_lines] = len;
+
+    static const char* FILTER[][2] = {
+        { "^\\S+ \\S+ (?:WARN|ERROR) \\[db\\]", "^[^ ]+ [^ ]+ (WARN|ERROR) \\[db\\]" },
+        { "took \\d{4,}ms$", "took [0-9]{4,}ms$" }
+    };
+    for (int p = 0; p < 2; p++) {
+        regex_t posix;
+        regcomp(&posix, FILTER[p][1], REG_EXTENDED | REG_NOSUB);
+        void* re = regex_compile(aria_str_box_n(FILTER[p][0], strlen(FILTER[p][0])));
+        long count = 0, want = 0;
+        double t0 = now();
+        for (size_t k = 0; k < n_lines; k++) count += (uint64_t)regex_match(re, lines[k]) == TAG_TRUE;
+        double t1 = now();
+        for (size_t k = 0; k < n_lines; k++) {
+            // glibc anchors ^ at the string, not at rm_so
+            regmatch_t m = { 0, (regoff_t)(starts[k + 1] - 1 - starts[k]) };
+            want += regexec(&posix, log + starts[k], 1, &m, REG_STARTEND) == 0;
+        }
+        double t2 = now();
+        printf("  filter   %-12s %8ld lines     aria %8.1f MB/s   regexec %8.1f MB/s\n", p ? "slow" : "db-errors",
+               count, mb / (t1 - t0), mb / (t2 - t1));
+        if (count != want) {
+            printf("  filter   regexec keeps %ld lines\n", want);
+            failed = 1;
+        }
+        regfree(&posix);
+    }
+
+    // Exponential for backtracking engines: the time must follow the length
+    static const char* HARD[] = { "(x+x+)+y", "(x|xx)*z", "(x?){25}x{25}y" };
+    char* xs = malloc(4 << 20);
+    memset(xs, 'x', 4 << 20);
+    for (int p = 0; p < 3; p++) {
+        void* re = regex_compile(aria_str_box_n(HARD[p], strlen(HARD[p])));
+        double t[2];
+        for (int s = 0; s < 2; s++) {
+            void* input = aria_str_box_n(xs, (size_t)1 << (20 + 2 * s));
+            double t0 = now();
+            if ((uint64_t)regex_match(re, input) == TAG_TRUE) failed = 1;
+            t[s] = now() - t0;
+        }
+        printf("  linear   %-16s 1 MB %6.1f ms   4 MB %6.1f ms\n", HARD[p], t[0] * 1e3, t[1] * 1e3);
+        if (t[1] > 8 * t[0] + 0.01) {
+            printf("  linear   %s grows faster than the input\n", HARD[p]);
+            failed = 1;
+        }
+    }
+    return failed;
+}
+EOT
+
+echo "Aria Regex Benchmark"
+echo "===================="
+echo "Log: $LOG_MB MB"
+echo ""
+
+$CC -O2 -std=c99 -D_GNU_SOURCE -o "$WORK/bench" "$WORK/bench.c" src/stdlib/regex.c src/stdlib/io.c \
+    src/stdlib/dynamic.c src/stdlib/string_utils.c src/stdlib/string_kernels.c \
+    src/stdlib/dataStructures.c src/stdlib/list_kernels.c src/runtime/object.c -lpthread -lm 2> /dev/null ||
+    { echo "Build failed"; exit 1; }
+
+FAILED=0
+"$WORK/bench" "$LOG_MB" || { echo ""; echo "FAIL: engines disagree or matching is not linear"; FAILED=1; }
+
+cat > "$WORK/prog.aria" <<'EOT'
+func main() {
+    var log = "10.0.0.1 ERROR db: timeout after 30ms\n10.0.0.2 INFO ok\n10.0.0.3 ERROR net: refused after 5ms\n";
+    var errors = regex_compile("ERROR (\\w+): (\\w+)");
+    for (var line in regex_find_all("[^\n]+", log)) {
+        if (regex_match(errors, line)) {
+            var m = regex_find(errors, line);
+            println(m[1] + " " + m[2]);
+        }
+    }
+    for (var ip in regex_find_all("\\d+\\.\\d+\\.\\d+\\.\\d+", log)) {
+        println(ip);
+    }
+    println(regex_replace("after (\\d+)ms", log, "in ${1} ms"));
+    if (regex_compile("a(") == null) {
+        println("rejected");
+    }
+}
+EOT
+cat > "$WORK/expect.txt" <<'EOT'
+db timeout
+net refused
+10.0.0.1
+10.0.0.2
+10.0.0.3
+10.0.0.1 ERROR db: timeout in 30 ms
+10.0.0.2 INFO ok
+10.0.0.3 ERROR net: refused in 5 ms
+
+rejected
+EOT
+
+echo ""
+if "$COMPILER" "$WORK/prog.aria" --no-cache > /dev/null && "$WORK/prog" > "$WORK/out.txt" 2> /dev/null &&
+   cmp -s "$WORK/out.txt" "$WORK/expect.txt"; then
+    echo "  ok    regex_compile / match / find / find_all / replace from Aria"
+else
+    echo "  FAIL  regex_compile / match / find / find_all / replace from Aria"
+    FAILED=1
+fi
+exit $FAILED
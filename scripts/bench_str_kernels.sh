@@ -0,0 +1,171 @@
+#!/bin/bash
+
+# Aria String Kernel Benchmark
+# Times the byte kernels behind str_find, str_find_any, str_count and
+# str_upper / str_lower (stdlib/string_kernels.c) at every level the CPU
+# supports, on a 1 KB text searched many times and on one 100 MB text, and
+# reports throughput in GB/s. Every level must return the same results as
+# the scalar code, there and on random short inputs. Then runs the str_*
+# functions from an Aria program. Exits non-zero if any check fails.
+#
+# Usage: scripts/bench_str_kernels.sh [large MB]
+
+LARGE_MB=${1:-100}
+CC=${CC:-gcc}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -f src/stdlib/string_kernels.c ]; then
+    echo "Error: run from the repository root"
+    exit 1
+fi
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+cat > "$WORK/bench.c" <<'EOT'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+const char* aria_str_kernels_use(const char* limit);
+long long aria_str_find(const char* s, size_t n, const char* needle, size_t m);
+long long aria_str_find_any(const char* s, size_t n, const char* set, size_t k);
+size_t aria_str_count(const char* s, size_t n, const char* needle, size_t m);
+void aria_str_fold(char* dst, const char* src, size_t n, int upper);
+
+static const char* LEVELS[] = { "scalar", "sse4.2", "avx2" };
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Lowercase words and spaces; the needles below only occur at the very end
+static char* make_text(size_t n) {
+    char* s = malloc(n + 1);
+    unsigned seed = 12345;
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned r = (seed >> 16) % 32;
+        s[i] = r < 5 ? ' ' : (char)('a' + r % 20);
+    }
+    memcpy(s + n - 12, "<end>quartz.", 12);
+    s[n] = '\0';
+    return s;
+}
+
+// Runs every kernel 'reps' times over s; returns a checksum of the results
+// and adds the seconds spent in each kernel to secs[]
+static unsigned long long run(const char* s, size_t n, int reps, char* out, double secs[5]) {
+    unsigned long long sum = 0;
+    double t;
+    t = now(); for (int r = 0; r < reps; r++) sum += aria_str_find(s, n, "quartz", 6); secs[0] += now() - t;
+    t = now(); for (int r = 0; r < reps; r++) sum += aria_str_find_any(s, n, "<>&\"", 4); secs[1] += now() - t;
+    t = now(); for (int r = 0; r < reps; r++) sum += aria_str_count(s, n, " ", 1); secs[2] += now() - t;
+    t = now(); for (int r = 0; r < reps; r++) sum += aria_str_count(s, n, "ab", 2); secs[3] += now() - t;
+    t = now(); for (int r = 0; r < reps; r++) aria_str_fold(out, s, n, r & 1); secs[4] += now() - t;
+    for (size_t i = 0; i < n; i++) sum = sum * 31 + (unsigned char)out[i];
+    return sum;
+}
+
+// Random short texts over a small alphabet, including bytes >= 0x80, so
+// that matches, near misses and block tails are all common
+static unsigned long long fuzz(void) {
+    static const char ALPHABET[] = "abAZ@[`{\x80\xff";
+    unsigned long long sum = 0;
+    unsigned seed = 99;
+    char s[200], needle[8], out[200];
+    for (int round = 0; round < 200000; round++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t n = (seed >> 8) % 200, m = (seed >> 20) % 8;
+        for (size_t i = 0; i < n; i++) { seed = seed * 1103515245u + 12345u; s[i] = ALPHABET[(seed >> 16) % 10]; }
+        for (size_t i = 0; i < m; i++) { seed = seed * 1103515245u + 12345u; needle[i] = ALPHABET[(seed >> 16) % 3]; }
+        sum = sum * 31 + (unsigned long long)(aria_str_find(s, n, needle, m) + 1);
+        sum = sum * 31 + (unsigned long long)(aria_str_find_any(s, n, needle, m) + 1);
+        sum = sum * 31 + aria_str_count(s, n, needle, m);
+        aria_str_fold(out, s, n, round & 1);
+        for (size_t i = 0; i < n; i++) sum = sum * 31 + (unsigned char)out[i];
+    }
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    size_t large = (size_t)atol(argv[1]) << 20;
+    char* small_text = make_text(1024);
+    char* large_text = make_text(large);
+    char* out = malloc(large);
+    unsigned long long expect[3] = {0};
+    int failed = 0;
+
+    for (int l = 0; l < 3; l++) {
+        const char* level = aria_str_kernels_use(LEVELS[l]);
+        if (strcmp(level, LEVELS[l]) != 0) continue;
+        double small_secs[5] = {0}, large_secs[5] = {0};
+        unsigned long long got[3];
+        got[0] = run(small_text, 1024, 200000, out, small_secs);
+        got[1] = run(large_text, large, 2, out, large_secs);
+        got[2] = fuzz();
+        for (int i = 0; i < 3; i++) {
+            if (l == 0) expect[i] = got[i];
+            else if (got[i] != expect[i]) failed = 1;
+        }
+        static const char* NAMES[] = { "find", "find_any", "count byte", "count pair", "case fold" };
+        for (int k = 0; k < 5; k++) {
+            printf("  %-8s %-12s 1 KB: %6.2f GB/s   %zu MB: %6.2f GB/s\n", level, NAMES[k],
+                   200000 * 1024.0 / small_secs[k] / 1e9, large >> 20, 2.0 * large / large_secs[k] / 1e9);
+        }
+    }
+    return failed;
+}
+EOT
+
+echo "Aria String Kernel Benchmark"
+echo "============================"
+echo "Inputs: 1 KB x 200000 and $LARGE_MB MB x 2"
+echo ""
+
+$CC -O2 -std=c99 -D_GNU_SOURCE -o "$WORK/bench" "$WORK/bench.c" src/stdlib/string_kernels.c ||
+    { echo "Build failed"; exit 1; }
+
+FAILED=0
+"$WORK/bench" "$LARGE_MB" || { echo ""; echo "FAIL: the kernel levels gave different results"; FAILED=1; }
+
+cat > "$WORK/prog.aria" <<'EOT'
+func main() {
+    var s = "GET /index.html?a=1&b=2 HTTP/1.1";
+    println(format("%d %d %d", str_find(s, "HTTP"), str_find(s, "missing"), str_find_any(s, "?&")));
+    println(format("%d %d", str_count(s, "="), str_count("aaaa", "aa")));
+    for (var part in str_split("a,b,,c", ",")) {
+        println(format("[%s]", part));
+    }
+    println(str_replace(s, "=", " is "));
+    println(str_upper(s));
+    println(str_lower("MiXeD 123"));
+}
+EOT
+cat > "$WORK/expect.txt" <<'EOT'
+24 -1 15
+2 2
+[a]
+[b]
+[]
+[c]
+GET /index.html?a is 1&b is 2 HTTP/1.1
+GET /INDEX.HTML?A=1&B=2 HTTP/1.1
+mixed 123
+EOT
+
+echo ""
+if "$COMPILER" "$WORK/prog.aria" --no-cache > /dev/null && "$WORK/prog" > "$WORK/out.txt" &&
+   cmp -s "$WORK/out.txt" "$WORK/expect.txt"; then
+    echo "  ok    str_* functions from Aria"
+else
+    echo "  FAIL  str_* functions from Aria"
+    FAILED=1
+fi
+exit $FAILED
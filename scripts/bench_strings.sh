@@ -0,0 +1,94 @@
+#!/bin/bash
+
+# Aria String Benchmark
+# Times string equality and string 'match' on a short subject and on a long
+# one built by appending. Strings carry their length and a cached hash
+# (stdlib/string_utils.c), so once the subject has been hashed neither
+# dispatch nor an unequal compare reads its text again. Exits non-zero if
+# the two programs disagree or the long subject costs more than a few times
+# the short one per operation.
+#
+# Usage: scripts/bench_strings.sh [iterations] [long pieces]
+
+N=${1:-2000000}
+PIECES=${2:-100000}
+COMPILER=${ARIA_COMPILER:-bin/aria_compiler}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Error: compiler not found at $COMPILER (run make first)"
+    exit 1
+fi
+
+# program <name> <pieces>: the subject is <pieces> copies of "abcdefgh" and
+# one more byte; 'other' has the same length and differs only in that byte.
+# 'same' is equal to the subject, so comparing them reads every byte, once.
+program() {
+    cat > "$WORK/$1.aria" <<EOT
+func kind(s) {
+    var r = 0;
+    match (s) {
+        "alpha" -> r = 1;
+        "beta" -> r = 2;
+        "gamma" -> r = 3;
+    }
+    return r;
+}
+
+func main() {
+    var s = "";
+    var i = 0;
+    while (i < $2) { s = s + "abcdefgh"; i = i + 1; }
+    var same = s + "x";
+    var other = s + "y";
+    s = s + "x";
+    var hits = 0;
+    i = 0;
+    while (i < $N) {
+        if (s == other) { hits = hits + 1; }
+        if (s != other) { hits = hits + 1; }
+        hits = hits + kind(s);
+        i = i + 1;
+    }
+    println(format("%d hits", hits));
+    if (s == same) { println("equal"); }
+}
+EOT
+}
+
+program short 1
+program long "$PIECES"
+
+echo "Aria String Benchmark"
+echo "====================="
+echo "Program: $N rounds of two compares and one match ($(( PIECES * 8 + 1 )) byte subject when long)"
+echo ""
+
+# Builds one program, runs it once and prints its run time in ms
+run_variant() {
+    local out="$WORK/$1"
+    "$COMPILER" "$out.aria" --no-cache > /dev/null || return 1
+    local start end
+    start=$(date +%s%N)
+    "$out" > "$out.stdout" || return 1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+SHORT_MS=$(run_variant short) || { echo "Short subject build failed"; exit 1; }
+LONG_MS=$(run_variant long) || { echo "Long subject build failed"; exit 1; }
+
+printf "  %-28s %6s ms\n" "9 byte subject:" "$SHORT_MS" "$(( PIECES * 8 + 1 )) byte subject:" "$LONG_MS"
+
+if ! cmp -s "$WORK/short.stdout" "$WORK/long.stdout" || [ "$(cat "$WORK/short.stdout")" != "$N hits
+equal" ]; then
+    echo ""
+    echo "FAIL: the programs gave different results"
+    exit 1
+fi
+if ! [ "$LONG_MS" -lt $(( 4 * SHORT_MS + 50 )) ]; then
+    echo ""
+    echo "FAIL: compares and dispatch still scale with the string length"
+    exit 1
+fi
@@ -0,0 +1,154 @@
+/* Aria_lang/src/backend/append.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include "append.h"
+
+// Variable ids of the analyzed function that have a lowered append
+static int* tracked = NULL;
+static int tracked_count = 0;
+static int tracked_cap = 0;
+
+// Expressions that always make a string: a string literal, `+` of two of
+// them (dyn_add only concatenates strings) or a choice between two of them
+static int is_text(AstNode* node) {
+    if (!node) return 0;
+    switch (ast_type(node)) {
+        case NODE_STRING: return 1;
+        case NODE_BINARY_OP:
+            return node->data.binary.op == TOKEN_PLUS &&
+                   is_text(AST_KID(node, binary.left)) && is_text(AST_KID(node, binary.right));
+        case NODE_TERNARY:
+            return is_text(AST_KID(node, ternary.true_expr)) && is_text(AST_KID(node, ternary.false_expr));
+        default: return 0;
+    }
+}
+
+// `v = v + x` where v is a local of this function kept in a plain slot,
+// declared with a string, and x is a string. Counters and numeric
+// accumulators (`total = total + f(i)`) are left to dyn_add.
+static int is_append(AstNode* node) {
+    if (ast_type(node) != NODE_ASSIGN || node->data.assign.id <= 0) return 0;
+    AstNode* decl = AST_KID(node, assign.decl);
+    if (!decl || decl->data.var_decl.is_captured || decl->data.var_decl.is_boxed) return 0;
+    if (!is_text(AST_KID(decl, var_decl.init_expr))) return 0;
+    AstNode* value = AST_KID(node, assign.value);
+    if (!value || ast_type(value) != NODE_BINARY_OP || value->data.binary.op != TOKEN_PLUS) return 0;
+    AstNode* left = AST_KID(value, binary.left);
+    if (!is_text(AST_KID(value, binary.right))) return 0;
+    return left && ast_type(left) == NODE_VAR_ACCESS && left->data.var_access.id == node->data.assign.id;
+}
+
+static int assigns_non_text_list(AstNode* node, int vid);
+
+// True if something under 'node' may store a non-string in variable 'vid':
+// an assignment that is neither an append nor of a string. Nested functions
+// are skipped; they can only assign captured variables, which are not lowered.
+static int assigns_non_text(AstNode* node, int vid) {
+    if (!node) return 0;
+    switch (ast_type(node)) {
+        case NODE_ASSIGN:
+            if (node->data.assign.id == vid && !is_append(node) && !is_text(AST_KID(node, assign.value))) return 1;
+            return assigns_non_text(AST_KID(node, assign.value), vid);
+        case NODE_VAR_DECL: return assigns_non_text(AST_KID(node, var_decl.init_expr), vid);
+        case NODE_BLOCK: return assigns_non_text_list(AST_KID(node, block.body), vid);
+        case NODE_BINARY_OP:
+            return assigns_non_text(AST_KID(node, binary.left), vid) || assigns_non_text(AST_KID(node, binary.right), vid);
+        case NODE_IF:
+            return assigns_non_text(AST_KID(node, if_stmt.condition), vid) ||
+                   assigns_non_text(AST_KID(node, if_stmt.then_branch), vid) ||
+                   assigns_non_text(AST_KID(node, if_stmt.else_branch), vid);
+        case NODE_WHILE:
+            return assigns_non_text(AST_KID(node, while_stmt.condition), vid) ||
+                   assigns_non_text(AST_KID(node, while_stmt.body), vid);
+        case NODE_FOR:
+            return assigns_non_text(AST_KID(node, for_stmt.iterable), vid) ||
+                   assigns_non_text(AST_KID(node, for_stmt.body), vid);
+        case NODE_MATCH:
+            return assigns_non_text(AST_KID(node, match.subject), vid) ||
+                   assigns_non_text_list(AST_KID(node, match.arms), vid) ||
+                   assigns_non_text(AST_KID(node, match.otherwise), vid);
+        case NODE_MATCH_ARM: return assigns_non_text(AST_KID(node, match_arm.body), vid);
+        case NODE_RETURN: return assigns_non_text(AST_KID(node, return_stmt.expr), vid);
+        case NODE_CALL:
+            return assigns_non_text(AST_KID(node, call.callee), vid) || assigns_non_text_list(AST_KID(node, call.args), vid);
+        case NODE_GET: return assigns_non_text(AST_KID(node, get.obj), vid);
+        case NODE_SET:
+            return assigns_non_text(AST_KID(node, set.obj), vid) || assigns_non_text(AST_KID(node, set.value), vid);
+        case NODE_INDEX_GET:
+            return assigns_non_text(AST_KID(node, index_get.obj), vid) || assigns_non_text(AST_KID(node, index_get.index), vid);
+        case NODE_INDEX_SET:
+            return assigns_non_text(AST_KID(node, index_set.obj), vid) ||
+                   assigns_non_text(AST_KID(node, index_set.index), vid) ||
+                   assigns_non_text(AST_KID(node, index_set.value), vid);
+        case NODE_ARRAY_LITERAL: return assigns_non_text_list(AST_KID(node, array_literal.elements), vid);
+        case NODE_TERNARY:
+            return assigns_non_text(AST_KID(node, ternary.condition), vid) ||
+                   assigns_non_text(AST_KID(node, ternary.true_expr), vid) ||
+                   assigns_non_text(AST_KID(node, ternary.false_expr), vid);
+        default: return 0;
+    }
+}
+
+static int assigns_non_text_list(AstNode* node, int vid) {
+    for (; node; node = AST_NEXT(node)) {
+        if (assigns_non_text(node, vid)) return 1;
+    }
+    return 0;
+}
+
+static void track(int vid) {
+    if (append_tracks(vid)) return;
+    if (tracked_count >= tracked_cap) {
+        tracked_cap = tracked_cap ? tracked_cap * 2 : 8;
+        tracked = realloc(tracked, sizeof(int) * tracked_cap);
+        if (!tracked) { fprintf(stderr, "Fatal: Out of memory in append analysis.\n"); exit(1); }
+    }
+    tracked[tracked_count++] = vid;
+}
+
+// Statements only: an assignment nested in an expression is never lowered
+static void scan_statements(AstNode* stmt) {
+    for (; stmt; stmt = AST_NEXT(stmt)) {
+        switch (ast_type(stmt)) {
+            case NODE_ASSIGN: if (is_append(stmt)) track(stmt->data.assign.id); break;
+            case NODE_BLOCK: scan_statements(AST_KID(stmt, block.body)); break;
+            case NODE_IF:
+                scan_statements(AST_KID(stmt, if_stmt.then_branch));
+                scan_statements(AST_KID(stmt, if_stmt.else_branch));
+                break;
+            case NODE_WHILE: scan_statements(AST_KID(stmt, while_stmt.body)); break;
+            case NODE_FOR: scan_statements(AST_KID(stmt, for_stmt.body)); break;
+            case NODE_MATCH:
+                for (AstNode* arm = AST_KID(stmt, match.arms); arm; arm = AST_NEXT(arm)) {
+                    scan_statements(AST_KID(arm, match_arm.body));
+                }
+                scan_statements(AST_KID(stmt, match.otherwise));
+                break;
+            default: break;
+        }
+    }
+}
+
+void append_analyze(AstNode* func) {
+    tracked_count = 0;
+    if (!func) return;
+    AstNode* body = AST_KID(func, func_decl.body);
+    scan_statements(body);
+    // Keep only variables that hold a string throughout
+    int kept = 0;
+    for (int i = 0; i < tracked_count; i++) {
+        if (!assigns_non_text(body, tracked[i])) tracked[kept++] = tracked[i];
+    }
+    tracked_count = kept;
+}
+
+int append_tracks(int var_id) {
+    for (int i = 0; i < tracked_count; i++) {
+        if (tracked[i] == var_id) return 1;
+    }
+    return 0;
+}
+
+int append_is_lowered(AstNode* stmt) {
+    return is_append(stmt) && append_tracks(stmt->data.assign.id);
+}
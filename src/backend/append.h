@@ -0,0 +1,40 @@
+/* Aria_lang/src/backend/append.h */
+#ifndef ARIA_APPEND_H
+#define ARIA_APPEND_H
+
+#include "../frontend/ast.h"
+
+/*
+ * Append Lowering
+ * ---------------
+ * A statement `s = s + x` (or `s += x`) on a local that no nested function
+ * captures becomes a call to aria_str_append (see "String Accumulation" in
+ * stdlib/io.c) instead of dyn_add, provided both sides are known strings:
+ * x and every value s is declared with or assigned are string literals or
+ * concatenations of them. The variable gets a hidden companion
+ * holding the growable buffer its current text was built in, so a loop of
+ * appends extends that buffer in place rather than copying the whole
+ * string every time.
+ *
+ * The buffer may only grow while the variable is its sole owner. Every
+ * other read of the variable therefore clears the companion first: the
+ * text read stays as it is, and the next append starts a fresh buffer.
+ * Appends that are part of a larger expression keep the generic dyn_add.
+ */
+
+// The hidden buffer of an accumulating variable is compiled as an extra
+// local with an id derived from the variable's (below LOOP_STATE_BASE)
+#define APPEND_STATE_BASE 0x20000000
+#define APPEND_STATE_ID(var_id) (APPEND_STATE_BASE + (var_id))
+
+// Finds the accumulating variables of one function, replacing the previous
+// function's. Nested functions are analyzed on their own.
+void append_analyze(AstNode* func);
+
+// True if the analyzed function lowers appends to variable 'var_id'
+int append_tracks(int var_id);
+
+// True if the statement 'stmt' is lowered to aria_str_append
+int append_is_lowered(AstNode* stmt);
+
+#endif
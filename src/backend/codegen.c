@@ -2,25 +2,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
 #include <stdint.h>
 #include <limits.h>
 #include "../frontend/ast.h"
+#include "x64.h"
+#include "escape.h"
+#include "loops.h"
+#include "match.h"
+#include "format.h"
+#include "pgo.h"
+#include "append.h"
 
-#define REG_COUNT 14
-static const char* REG_NAMES[REG_COUNT] = {
-    "rbx", "r12", "r13", "r14", "r15", 
-    "r10", "r11", "r8", "r9",          
-    "rsi", "rdi", "rcx", "rdx", "rax"  
-};
+/*
+ * Variables only get callee-saved registers: every operation is a runtime
+ * call, so anything in a caller-saved register would be clobbered. Functions
+ * save the ones they use. R10 carries a closure's environment on entry and
+ * R11 is scratch.
+ */
+#define REG_COUNT 5
+static const X64Reg REG_NAMES[REG_COUNT] = { X64_RBX, X64_R12, X64_R13, X64_R14, X64_R15 };
 
-static const char* ABI_ARG_REGS[6] = { "rdi", "rsi", "rdx", "rcx", "r8", "r9" };
+// Frame layout: [rbp-8] closure environment, [rbp-16..-48] saved registers, spills
+// below, then lists and objects that escape analysis placed in the frame
+#define ENV_SLOT (-8)
+#define SAVE_AREA 48
 
-FILE* asm_out = NULL;
-static int label_seq = 0;
+// Top 16 bits of a closure value; the low 48 bits point at its record
+#define CLOSURE_TAG ((int64_t)0xFFFF000000000000ULL)
+
+// Top bits of a packed int list's item pointer, and of a boxed int; they match
+// INTS_TAG and TAG_INTEGER in stdlib/dataStructures.c
+#define INTS_TAG ((int64_t)0xFFFF000000000000ULL)
+#define INT_BOX_TAG ((int64_t)0xFFFC000000000000ULL)
+
+static const X64Reg ABI_ARG_REGS[6] = { X64_RDI, X64_RSI, X64_RDX, X64_RCX, X64_R8, X64_R9 };
+
+// Instruction stream being built; encoded or printed by the driver
+X64Program* x64_out = NULL;
 static int instruction_counter = 0; 
 static int max_stack_usage = 0; 
+static int saved_regs_mask = 0;
 static AstNode* program_root = NULL; 
+static AstNode* current_function = NULL;
+
+// Closures met while generating a function; emitted as functions afterwards
+static AstNode** pending_closures = NULL;
+static int pending_count = 0;
+static int pending_cap = 0;
 
 typedef struct LiveInterval {
     int var_id;         
@@ -43,17 +71,52 @@ void gen_function_node(AstNode* func);
 void gen_expression(AstNode* node);
 void gen_string_literal(const char* str);
 
-void emit(const char* format,...) {
-    va_list args;
-    va_start(args, format);
-    fprintf(asm_out, "    "); 
-    vfprintf(asm_out, format, args);
-    fprintf(asm_out, "\n");
-    va_end(args);
+void emit(X64Opcode op, X64Operand a, X64Operand b) {
+    x64_emit(x64_out, op, a, b);
+}
+
+static void emit_call(const char* fn) { emit(X64_CALL, x64_sym(fn), x64_none()); }
+static void emit_label(int lbl) { emit(X64_LABEL, x64_label(lbl), x64_none()); }
+static X64Operand R(X64Reg reg) { return x64_reg(reg); }
+
+// --- Variables and Captures ---
+
+static int is_boxed(AstNode* decl) {
+    return decl && decl->data.var_decl.is_boxed;
+}
+
+// Index of 'vid' in the current closure's record, or -1 if it is not a capture
+static int upvalue_index(int vid) {
+    if (!current_function) return -1;
+    int k = 0;
+    for (AstNode* up = AST_KID(current_function, func_decl.upvalues); up; up = AST_NEXT(up), k++) {
+        if (up->data.var_access.id == vid) return k;
+    }
+    return -1;
+}
+
+static X64Operand upvalue_operand(X64Reg env, int k) { return x64_mem(env, 16 + 8 * k); }
+
+// A local bound once to a closure expression: calls can target its code directly
+static AstNode* known_closure(AstNode* callee) {
+    if (ast_type(callee) != NODE_VAR_ACCESS || !callee->data.var_access.decl) return NULL;
+    VarDeclData* decl = &AST_KID(callee, var_access.decl)->data.var_decl;
+    if (decl->is_mutated || !ast_at(AST_KID(callee, var_access.decl), decl->init_expr)) return NULL;
+    AstNode* init = ast_at(AST_KID(callee, var_access.decl), decl->init_expr);
+    return (ast_type(init) == NODE_FUNC_DECL && init->data.func_decl.is_closure) ? init : NULL;
+}
+
+static void queue_closure(AstNode* fn) {
+    if (pending_count >= pending_cap) {
+        pending_cap = pending_cap ? pending_cap * 2 : 16;
+        pending_closures = realloc(pending_closures, sizeof(AstNode*) * pending_cap);
+    }
+    pending_closures[pending_count++] = fn;
 }
 
 void liveness_record_use(int var_id, int instr_idx) {
-    if (var_id <= 0) return; 
+    if (var_id <= 0 || upvalue_index(var_id) >= 0) return; 
+    if (append_tracks(var_id)) liveness_record_use(APPEND_STATE_ID(var_id), instr_idx);
     for(int i=0; i<global_intervals.count; i++) {
         if (global_intervals.intervals[i].var_id == var_id) {
             if (global_intervals.intervals[i].start == -1) global_intervals.intervals[i].start = instr_idx;
@@ -76,35 +139,77 @@ void liveness_record_use(int var_id, int instr_idx) {
 void analyze_liveness(AstNode* node) {
     if (!node) return;
     int current_instr = instruction_counter++;
-    switch(node->type) {
+    switch(ast_type(node)) {
         case NODE_VAR_DECL: {
             int vid = node->data.var_decl.shadow_stack_offset;
             liveness_record_use(vid, current_instr);
-            if (node->data.var_decl.init_expr) analyze_liveness(node->data.var_decl.init_expr);
+            if (node->data.var_decl.init_expr) analyze_liveness(AST_KID(node, var_decl.init_expr));
             break;
         }
         case NODE_VAR_ACCESS: liveness_record_use(node->data.var_access.id, current_instr); break;
-        case NODE_BINARY_OP: analyze_liveness(node->data.binary.left); analyze_liveness(node->data.binary.right); break;
+        case NODE_BINARY_OP: analyze_liveness(AST_KID(node, binary.left)); analyze_liveness(AST_KID(node, binary.right)); break;
         case NODE_BLOCK: {
-            AstNode* stmt = node->data.func_decl.body;
-            while(stmt) { analyze_liveness(stmt); stmt = stmt->next; }
+            AstNode* stmt = AST_KID(node, block.body);
+            while(stmt) { analyze_liveness(stmt); stmt = AST_NEXT(stmt); }
+            break;
+        }
+        case NODE_WHILE: {
+            analyze_liveness(AST_KID(node, while_stmt.condition)); analyze_liveness(AST_KID(node, while_stmt.body));
+            // A variable live into the loop is read again after the back edge: keep it to the end
+            for (int i = 0; i < global_intervals.count; i++) {
+                LiveInterval* iv = &global_intervals.intervals[i];
+                if (iv->start < current_instr && iv->end >= current_instr && iv->end < instruction_counter) iv->end = instruction_counter;
+            }
+            break;
+        }
+        case NODE_FOR: {
+            // The loop variable and the hidden counter, bound and list state
+            // are all written before the body and read across the back edge
+            int vid = AST_KID(node, for_stmt.var)->data.var_decl.shadow_stack_offset;
+            analyze_liveness(AST_KID(node, for_stmt.iterable));
+            liveness_record_use(vid, current_instr);
+            int hidden = node->data.for_stmt.is_each ? 4 : 2;
+            for (int k = 0; k < hidden; k++) liveness_record_use(LOOP_STATE_ID(vid, k), current_instr);
+            analyze_liveness(AST_KID(node, for_stmt.body));
+            for (int k = 0; k < hidden; k++) liveness_record_use(LOOP_STATE_ID(vid, k), instruction_counter);
+            for (int i = 0; i < global_intervals.count; i++) {
+                LiveInterval* iv = &global_intervals.intervals[i];
+                if (iv->start < current_instr && iv->end >= current_instr && iv->end < instruction_counter) iv->end = instruction_counter;
+            }
+            break;
+        }
+        case NODE_MATCH: {
+            analyze_liveness(AST_KID(node, match.subject));
+            for (AstNode* arm = AST_KID(node, match.arms); arm; arm = AST_NEXT(arm)) analyze_liveness(AST_KID(arm, match_arm.body));
+            analyze_liveness(AST_KID(node, match.otherwise));
             break;
         }
-        case NODE_WHILE: analyze_liveness(node->data.while_stmt.condition); analyze_liveness(node->data.while_stmt.body); break;
-        case NODE_IF: analyze_liveness(node->data.if_stmt.condition); analyze_liveness(node->data.if_stmt.then_branch); 
-            if (node->data.if_stmt.else_branch) analyze_liveness(node->data.if_stmt.else_branch); break;
-        case NODE_RETURN: if (node->data.return_stmt.expr) analyze_liveness(node->data.return_stmt.expr); break;
+        case NODE_IF: analyze_liveness(AST_KID(node, if_stmt.condition)); analyze_liveness(AST_KID(node, if_stmt.then_branch)); 
+            if (node->data.if_stmt.else_branch) analyze_liveness(AST_KID(node, if_stmt.else_branch)); break;
+        case NODE_RETURN: if (node->data.return_stmt.expr) analyze_liveness(AST_KID(node, return_stmt.expr)); break;
         case NODE_CALL: {
-            analyze_liveness(node->data.call.callee);
-            AstNode* arg = node->data.call.args;
-            while(arg) { analyze_liveness(arg); arg = arg->next; }
+            analyze_liveness(AST_KID(node, call.callee));
+            AstNode* arg = AST_KID(node, call.args);
+            while(arg) { analyze_liveness(arg); arg = AST_NEXT(arg); }
+            break;
+        }
+        case NODE_ASSIGN: analyze_liveness(AST_KID(node, assign.value)); liveness_record_use(node->data.assign.id, current_instr); break;
+        case NODE_INDEX_SET: analyze_liveness(AST_KID(node, index_set.obj)); analyze_liveness(AST_KID(node, index_set.index)); analyze_liveness(AST_KID(node, index_set.value)); break;
+        case NODE_INDEX_GET: analyze_liveness(AST_KID(node, index_get.obj)); analyze_liveness(AST_KID(node, index_get.index)); break;
+        case NODE_SET: analyze_liveness(AST_KID(node, set.obj)); analyze_liveness(AST_KID(node, set.value)); break;
+        case NODE_GET: analyze_liveness(AST_KID(node, get.obj)); break;
+        case NODE_TERNARY: analyze_liveness(AST_KID(node, ternary.condition)); analyze_liveness(AST_KID(node, ternary.true_expr)); analyze_liveness(AST_KID(node, ternary.false_expr)); break;
+        case NODE_ARRAY_LITERAL: {
+            AstNode* elem = AST_KID(node, array_literal.elements);
+            while(elem) { analyze_liveness(elem); elem = AST_NEXT(elem); }
+            break;
+        }
+        case NODE_FUNC_DECL: {
+            // Building a closure reads every captured variable
+            AstNode* up = AST_KID(node, func_decl.upvalues);
+            while(up) { liveness_record_use(up->data.var_access.id, current_instr); up = AST_NEXT(up); }
             break;
         }
-        case NODE_ASSIGN: analyze_liveness(node->data.assign.value); liveness_record_use(node->data.assign.id, current_instr); break;
-        case NODE_INDEX_SET: analyze_liveness(node->data.index_set.obj); analyze_liveness(node->data.index_set.index); analyze_liveness(node->data.index_set.value); break;
-        case NODE_INDEX_GET: analyze_liveness(node->data.index_get.obj); analyze_liveness(node->data.index_get.index); break;
-        case NODE_SET: analyze_liveness(node->data.set.obj); analyze_liveness(node->data.set.value); break;
-        case NODE_GET: analyze_liveness(node->data.get.obj); break;
         default: break;
     }
 }
@@ -141,107 +246,367 @@ void allocate_registers() {
                 }
             }
         } else {
-            int slot = -8 * (i + 1);
+            int slot = -SAVE_AREA - 8 * (i + 1);
             if ((-slot) > max_stack_usage) max_stack_usage = -slot;
             current->reg_index = -1;
             current->stack_offset = slot;
         }
     }
+    if (max_stack_usage < SAVE_AREA) max_stack_usage = SAVE_AREA;
     if (max_stack_usage % 16!= 0) max_stack_usage += (16 - (max_stack_usage % 16));
-    if (max_stack_usage < 32) max_stack_usage = 32; 
+
+    saved_regs_mask = 0;
+    for (int i = 0; i < global_intervals.count; i++) {
+        if (global_intervals.intervals[i].reg_index != -1) saved_regs_mask |= 1 << global_intervals.intervals[i].reg_index;
+    }
 }
 
-const char* get_location(int vid) {
-    // FIX 3.1: Rotating Buffer Pool - prevents static buffer collision
-    static char buffers[4][64]; // Pool of 4 buffers
-    static int rotate_idx = 0;
-    
-    // Select next buffer in rotation
-    char* buf = buffers[rotate_idx++ % 4];
-    
+X64Operand get_location(int vid) {
     for(int i=0; i<global_intervals.count; i++) {
         if (global_intervals.intervals[i].var_id == vid) {
-            if (global_intervals.intervals[i].reg_index!= -1) return REG_NAMES[global_intervals.intervals[i].reg_index];
-            else { snprintf(buf, 64, "[rbp%d]", global_intervals.intervals[i].stack_offset); return buf; }
+            if (global_intervals.intervals[i].reg_index!= -1) return R(REG_NAMES[global_intervals.intervals[i].reg_index]);
+            else return x64_mem(X64_RBP, global_intervals.intervals[i].stack_offset);
+        }
+    }
+    return R(X64_RAX);
+}
+
+// RAX = the variable's storage word: its value, or its cell when boxed
+static void gen_load_slot(int vid) {
+    int k = upvalue_index(vid);
+    if (k >= 0) {
+        emit(X64_MOV, R(X64_RAX), x64_mem(X64_RBP, ENV_SLOT));
+        emit(X64_MOV, R(X64_RAX), upvalue_operand(X64_RAX, k));
+    } else {
+        emit(X64_MOV, R(X64_RAX), get_location(vid));
+    }
+}
+
+static void gen_load_var(int vid, AstNode* decl) {
+    gen_load_slot(vid);
+    if (is_boxed(decl)) emit(X64_MOV, R(X64_RAX), x64_mem(X64_RAX, 0));
+}
+
+// Stores RAX into a local; boxed variables write through their cell
+static void gen_store_var(int vid, AstNode* decl) {
+    if (!is_boxed(decl)) {
+        emit(X64_MOV, get_location(vid), R(X64_RAX));
+        return;
+    }
+    int k = upvalue_index(vid);
+    if (k >= 0) {
+        emit(X64_MOV, R(X64_R11), x64_mem(X64_RBP, ENV_SLOT));
+        emit(X64_MOV, R(X64_R11), upvalue_operand(X64_R11, k));
+    } else {
+        emit(X64_MOV, R(X64_R11), get_location(vid));
+    }
+    emit(X64_MOV, x64_mem(X64_R11, 0), R(X64_RAX));
+}
+
+// Drops an accumulating variable's buffer: its text may now be shared
+static void gen_append_reset(int vid) {
+    if (append_tracks(vid)) emit(X64_MOV, get_location(APPEND_STATE_ID(vid)), x64_imm(0));
+}
+
+/*
+ * v = v + x on an accumulating variable (backend/append.h). The runtime
+ * returns the new text in RAX and the buffer holding it in RDX.
+ */
+static void gen_append(AstNode* node) {
+    int vid = node->data.assign.id;
+    AstNode* decl = AST_KID(node, assign.decl);
+    X64Operand buffer = get_location(APPEND_STATE_ID(vid));
+    gen_load_var(vid, decl);
+    emit(X64_PUSH, R(X64_RAX), x64_none());
+    gen_expression(AST_KID(AST_KID(node, assign.value), binary.right));
+    emit(X64_MOV, R(X64_RDX), R(X64_RAX));
+    emit(X64_POP, R(X64_RSI), x64_none());
+    emit(X64_MOV, R(X64_RDI), buffer);
+    emit_call("aria_str_append");
+    emit(X64_MOV, buffer, R(X64_RDX));
+    gen_store_var(vid, decl);
+}
+
+// Fresh heap cell for a boxed variable, stored in its location
+static void gen_new_cell(int vid) {
+    emit(X64_MOV, R(X64_RDI), x64_imm(8));
+    emit_call("aria_alloc");
+    emit(X64_MOV, get_location(vid), R(X64_RAX));
+}
+
+/*
+ * Closure value in RAX. A closure without captures is just its code
+ * address, like any top-level function. Otherwise a record
+ * { code, count, captures... } is allocated: immutable captures are copied
+ * by value, boxed ones share the cell pointer. The record pointer is tagged
+ * with CLOSURE_TAG so calls can tell it from a code address.
+ */
+static void gen_closure(AstNode* fn) {
+    queue_closure(fn);
+    int count = fn->data.func_decl.upvalue_count;
+    if (count == 0) {
+        emit(X64_LEA, R(X64_RAX), x64_rip_sym(fn->data.func_decl.name));
+        return;
+    }
+    emit(X64_MOV, R(X64_RDI), x64_imm(16 + 8 * count));
+    emit_call("aria_alloc");
+    emit(X64_PUSH, R(X64_RAX), x64_none());
+    emit(X64_LEA, R(X64_R11), x64_rip_sym(fn->data.func_decl.name));
+    emit(X64_MOV, x64_mem(X64_RAX, 0), R(X64_R11));
+    emit(X64_MOV, x64_mem(X64_RAX, 8), x64_imm(count));
+    int k = 0;
+    for (AstNode* up = AST_KID(fn, func_decl.upvalues); up; up = AST_NEXT(up), k++) {
+        gen_load_slot(up->data.var_access.id);
+        emit(X64_MOV, R(X64_R11), x64_mem(X64_RSP, 0));
+        emit(X64_MOV, upvalue_operand(X64_R11, k), R(X64_RAX));
+    }
+    emit(X64_POP, R(X64_RAX), x64_none());
+    emit(X64_MOV, R(X64_R11), x64_imm(CLOSURE_TAG));
+    emit(X64_OR, R(X64_RAX), R(X64_R11));
+}
+
+// Calls the function value in R10. A tagged closure is entered through its
+// code pointer with the untagged record left in R10 as its environment.
+static void gen_dynamic_call(void) {
+    int plain = x64_new_label(x64_out, "plain_call"), done = x64_new_label(x64_out, "call_done");
+    emit(X64_MOV, R(X64_R11), x64_imm(CLOSURE_TAG));
+    emit(X64_MOV, R(X64_RAX), R(X64_R10));
+    emit(X64_AND, R(X64_RAX), R(X64_R11));
+    emit(X64_CMP, R(X64_RAX), R(X64_R11));
+    emit(X64_JNE, x64_label(plain), x64_none());
+    emit(X64_XOR, R(X64_R10), R(X64_R11));
+    emit(X64_CALL, x64_mem(X64_R10, 0), x64_none());
+    emit(X64_JMP, x64_label(done), x64_none());
+    emit_label(plain);
+    emit(X64_CALL, R(X64_R10), x64_none());
+    emit_label(done);
+}
+
+// Every function keeps the caller's rbp below its frame; the X64_CFI marks
+// describe each step to the unwinder (dwarf.c)
+static void gen_frame_enter(void) {
+    emit(X64_PUSH, R(X64_RBP), x64_none()); emit(X64_CFI, x64_imm(X64_CFI_PUSH_RBP), x64_none());
+    emit(X64_MOV, R(X64_RBP), R(X64_RSP)); emit(X64_CFI, x64_imm(X64_CFI_SET_RBP), x64_none());
+}
+
+static void gen_frame_return(void) {
+    emit(X64_LEAVE, x64_none(), x64_none()); emit(X64_CFI, x64_imm(X64_CFI_LEAVE), x64_none());
+    emit(X64_RET, x64_none(), x64_none()); emit(X64_CFI, x64_imm(X64_CFI_RET), x64_none());
+}
+
+// Source line of the code that follows, for the debug line table
+static void gen_line(int line) {
+    if (line > 0) emit(X64_LINE, x64_imm(line), x64_none());
+}
+
+static void gen_epilogue(void) {
+    for (int r = 0; r < REG_COUNT; r++) {
+        if (saved_regs_mask & (1 << r)) emit(X64_MOV, R(REG_NAMES[r]), x64_mem(X64_RBP, -16 - 8 * r));
+    }
+    gen_frame_return();
+}
+
+// True if 'name' is a function or method emitted into this object
+static int is_local_function(const char* name) {
+    for (AstNode* curr = program_root; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_FUNC_DECL && strcmp(curr->data.func_decl.name, name) == 0) return 1;
+        if (ast_type(curr) == NODE_CLASS_DECL && !curr->data.class_decl.is_extern) {
+            for (AstNode* m = AST_KID(curr, class_decl.methods); m; m = AST_NEXT(m)) {
+                if (strcmp(m->data.func_decl.name, name) == 0) return 1;
+            }
         }
     }
-    return "rax"; 
+    return 0;
 }
 
-void gen_safepoint_poll(int lbl) {
-    emit("cmp dword [rel gc_suspend_request], 0");
-    emit("je.Lsafe_%d", lbl);
-    emit("call gc_enter_safepoint"); 
-    fprintf(asm_out, ".Lsafe_%d:\n", lbl);
+// Function address into 'dst': RIP-relative when local, through the GOT otherwise
+static void gen_function_address(X64Reg dst, const char* name) {
+    if (is_local_function(name)) emit(X64_LEA, R(dst), x64_rip_sym(name));
+    else emit(X64_MOV, R(dst), x64_got(name));
 }
 
+void gen_safepoint_poll(void) {
+    int lbl = x64_new_label(x64_out, "safe");
+    X64Operand flag = x64_rip_sym("gc_suspend_request");
+    flag.size = 4;
+    emit(X64_CMP, flag, x64_imm(0));
+    emit(X64_JE, x64_label(lbl), x64_none());
+    emit_call("gc_enter_safepoint");
+    emit_label(lbl);
+}
+
+// String constants live in .rodata behind their runtime header; the address lands in RAX
 void gen_string_literal(const char* str) {
-    int lbl_end = label_seq++;
-    int lbl_str = label_seq++;
-    emit("jmp.Lstr_end_%d", lbl_end);
-    fprintf(asm_out, ".Lstr_data_%d: db ", lbl_str);
-    const char* p = str;
-    int first = 1;
-    while(*p) {
-        if (!first) fprintf(asm_out, ",");
-        fprintf(asm_out, "%d", (unsigned char)*p);
-        first = 0; p++;
-    }
-    if (!first) fprintf(asm_out, ",");
-    fprintf(asm_out, "0\n"); 
-    fprintf(asm_out, ".Lstr_end_%d:\n", lbl_end);
-    emit("mov rax,.Lstr_data_%d", lbl_str);
+    int lbl = x64_add_literal(x64_out, str);
+    emit(X64_LEA, R(X64_RAX), x64_rip_label(lbl));
+}
+
+// --- Profile-Guided Optimization ---
+
+// [rel sym + 8 * index] inside a .data block
+static X64Operand block_slot(const char* sym, int index) {
+    X64Operand o = x64_rip_sym(sym);
+    o.imm = 8 * (int64_t)index;
+    return o;
+}
+
+// Instrumented builds count each execution of 'site' (see pgo.h)
+static void gen_profile_count(AstNode* site, const char* what) {
+    if (pgo_mode != PGO_GENERATE) return;
+    int idx = pgo_counter(site, what);
+    if (idx >= 0) emit(X64_ADD, block_slot(PGO_COUNTERS_SYM, idx), x64_imm(1));
+}
+
+/*
+ * Reads property RSI of the object in RDI. Instrumented builds also record
+ * where the key was found; with a profile, hot sites get an inline cache
+ * seeded with that slot, so a read usually skips hashing the key.
+ */
+static void gen_obj_get(AstNode* site) {
+    if (pgo_mode == PGO_GENERATE) {
+        int idx = pgo_counter(site, "get");
+        if (idx >= 0) {
+            pgo_counter(site, "slot");   // adjacent to "get"; the runtime stores slot + 1 there
+            emit(X64_LEA, R(X64_RDX), block_slot(PGO_COUNTERS_SYM, idx));
+            emit_call("aria_obj_get_profiled");
+            return;
+        }
+    } else if (pgo_is_hot(pgo_count(site, "get"))) {
+        emit(X64_LEA, R(X64_RDX), block_slot(PGO_CACHES_SYM, pgo_new_cache()));
+        emit(X64_MOV, R(X64_RCX), x64_imm((int64_t)pgo_count(site, "slot")));
+        emit_call("aria_obj_get_cached");
+        return;
+    }
+    emit_call("aria_obj_get");
+}
+
+// Function being expanded in place of a hot call, and that call's arguments
+static AstNode* inline_func = NULL;
+static AstNode* inline_call = NULL;
+
+// The argument that stands in for parameter 'decl' of the expanded function
+static AstNode* inline_arg(AstNode* decl) {
+    if (!inline_func || !decl) return NULL;
+    AstNode* arg = AST_KID(inline_call, call.args);
+    for (AstNode* p = AST_KID(inline_func, func_decl.params); p && arg; p = AST_NEXT(p), arg = AST_NEXT(arg)) {
+        if (p == decl) return arg;
+    }
+    return NULL;
+}
+
+// Generates the return expression of 'func' with its parameters replaced by
+// the (side-effect free) arguments of 'call'; pgo_inline_target vets both
+static void gen_inline_call(AstNode* func, AstNode* call) {
+    AstNode* body = AST_KID(func, func_decl.body);
+    if (ast_type(body) == NODE_BLOCK) body = AST_KID(body, block.body);
+    inline_func = func;
+    inline_call = call;
+    gen_expression(AST_KID(body, return_stmt.expr));
+    inline_func = NULL;
+    inline_call = NULL;
+}
+
+/*
+ * print / format with a literal format (see format.h). The run-time
+ * arguments are evaluated into a stack block first, so nothing is written
+ * while an argument is still being computed; format keeps its buffer in the
+ * slot below them.
+ */
+static void gen_format(FormatPlan* plan) {
+    static const char* APPENDS[] = { NULL, "aria_fmt_int", "aria_fmt_float", "aria_fmt_str" };
+    int base = plan->is_print ? 0 : 8;
+    int block = (base + 8 * plan->arg_count + 15) & ~15;
+    if (block > 0) emit(X64_SUB, R(X64_RSP), x64_imm(block));
+    for (int i = 0; i < plan->arg_count; i++) {
+        gen_expression(plan->args[i]);
+        emit(X64_MOV, x64_mem(X64_RSP, base + 8 * i), R(X64_RAX));
+    }
+
+    if (plan->is_print) {
+        emit_call("aria_print_begin");
+    } else {
+        emit(X64_MOV, R(X64_RDI), x64_imm(plan->size_hint));
+        emit_call("aria_fmt_new");
+        emit(X64_MOV, x64_mem(X64_RSP, 0), R(X64_RAX));
+    }
+    for (int i = 0; i < plan->segment_count; i++) {
+        FormatSegment* seg = &plan->segments[i];
+        // The print sink is the locked stdout buffer, passed as NULL
+        if (plan->is_print) emit(X64_MOV, R(X64_RDI), x64_imm(0));
+        else emit(X64_MOV, R(X64_RDI), x64_mem(X64_RSP, 0));
+        if (seg->kind == FMT_TEXT) {
+            emit(X64_LEA, R(X64_RSI), x64_rip_label(x64_add_string_copy(x64_out, seg->text)));
+            emit(X64_MOV, R(X64_RDX), x64_imm(seg->len));
+            emit_call("aria_fmt_text");
+        } else {
+            emit(X64_MOV, R(X64_RSI), x64_mem(X64_RSP, base + 8 * seg->arg));
+            emit_call(APPENDS[seg->kind]);
+        }
+    }
+    if (plan->is_print) {
+        emit_call("aria_print_end");
+    } else {
+        emit(X64_MOV, R(X64_RDI), x64_mem(X64_RSP, 0));
+        emit_call("aria_fmt_finish");
+    }
+    if (block > 0) emit(X64_ADD, R(X64_RSP), x64_imm(block));
 }
 
 void gen_expression(AstNode* node) {
     if (!node) return;
-    switch (node->type) {
+    switch (ast_type(node)) {
         case NODE_LITERAL: 
-            emit("mov rdi, %lld", node->data.int_val);
-            emit("call dyn_new_int");
+            emit(X64_MOV, R(X64_RDI), x64_imm(node->data.int_val));
+            emit_call("dyn_new_int");
             break;
         case NODE_FLOAT: {
             union { double d; int64_t i; } u; u.d = node->data.double_val;
-            emit("mov rdi, %lld", u.i);
-            emit("call dyn_new_float");
+            emit(X64_MOV, R(X64_RDI), x64_imm(u.i));
+            emit_call("dyn_new_float");
             break;
         }
         case NODE_BOOL: 
-            emit("mov rdi, %d", node->data.int_val);
-            emit("call dyn_new_bool");
+            emit(X64_MOV, R(X64_RDI), x64_imm(node->data.int_val));
+            emit_call("dyn_new_bool");
             break;
-        case NODE_NULL: emit("call dyn_new_null"); break;
+        case NODE_NULL: emit_call("dyn_new_null"); break;
         case NODE_STRING: 
             gen_string_literal(node->data.string_val);
-            emit("mov rdi, rax");
-            emit("call dyn_new_str");
+            emit(X64_MOV, R(X64_RDI), R(X64_RAX));
+            emit_call("dyn_new_str");
             break;
         case NODE_VAR_ACCESS: {
             int vid = node->data.var_access.id;
-            if (vid == -2) emit("mov rax, [rel %s]", node->data.var_access.name);
-            else if (vid == -1) emit("mov rax, %s", node->data.var_access.name);
-            else emit("mov rax, %s", get_location(vid));
+            AstNode* arg = inline_arg(AST_KID(node, var_access.decl));
+            if (arg) gen_expression(arg);
+            else if (vid == -2) emit(X64_MOV, R(X64_RAX), x64_rip_sym(node->data.var_access.name));
+            else if (vid == -1) gen_function_address(X64_RAX, node->data.var_access.name);
+            else {
+                gen_load_var(vid, AST_KID(node, var_access.decl));
+                gen_append_reset(vid);
+            }
             break;
         }
         case NODE_ASSIGN: {
-             gen_expression(node->data.assign.value); 
+             gen_expression(AST_KID(node, assign.value)); 
              int vid = node->data.assign.id;
-             if (vid == -2) emit("mov [rel %s], rax", node->data.assign.name);
-             else emit("mov %s, rax", get_location(vid));
+             if (vid == -2) emit(X64_MOV, x64_rip_sym(node->data.assign.name), R(X64_RAX));
+             else gen_store_var(vid, AST_KID(node, assign.decl));
              break;
         }
+        case NODE_FUNC_DECL: gen_closure(node); break;
         case NODE_BINARY_OP: {
             // 1. Handle Unary Operations (Left child is NULL)
-            if (node->data.binary.left == NULL) {
+            if (AST_KID(node, binary.left) == NULL) {
                 // Generate code for the operand (result in RAX)
-                gen_expression(node->data.binary.right);
+                gen_expression(AST_KID(node, binary.right));
                 
                 // Move result to first argument register (RDI)
-                emit("mov rdi, rax");
+                emit(X64_MOV, R(X64_RDI), R(X64_RAX));
                 
                 switch(node->data.binary.op) {
-                    case TOKEN_MINUS: emit("call dyn_neg"); break;
-                    case TOKEN_BANG:  emit("call dyn_not"); break;
+                    case TOKEN_MINUS: emit_call("dyn_neg"); break;
+                    case TOKEN_BANG:  emit_call("dyn_not"); break;
                     default: 
                         fprintf(stderr, "Codegen Error: Unknown unary operator token %d\n", node->data.binary.op);
                         exit(1);
@@ -249,252 +614,710 @@ void gen_expression(AstNode* node) {
             } 
             // 2. Handle Binary Operations
             else {
-                gen_expression(node->data.binary.left);
-                emit("push rax"); // Save left operand
+                gen_expression(AST_KID(node, binary.left));
+                emit(X64_PUSH, R(X64_RAX), x64_none()); // Save left operand
                 
-                gen_expression(node->data.binary.right);
-                emit("mov rsi, rax"); // Right operand to RSI
-                emit("pop rdi");      // Left operand to RDI
+                gen_expression(AST_KID(node, binary.right));
+                emit(X64_MOV, R(X64_RSI), R(X64_RAX)); // Right operand to RSI
+                emit(X64_POP, R(X64_RDI), x64_none());  // Left operand to RDI
                 
                 switch(node->data.binary.op) {
-                    case TOKEN_PLUS: emit("call dyn_add"); break;
-                    case TOKEN_MINUS: emit("call dyn_sub"); break;
-                    case TOKEN_STAR: emit("call dyn_mul"); break;
-                    case TOKEN_SLASH: emit("call dyn_div"); break;
-                    case TOKEN_PERCENT: emit("call dyn_mod"); break;
-                    case TOKEN_EQEQ: emit("call dyn_eq"); break;
-                    case TOKEN_NEQ: emit("call dyn_neq"); break;
-                    case TOKEN_LT: emit("call dyn_lt"); break;
-                    case TOKEN_GT: emit("call dyn_gt"); break;
+                    case TOKEN_PLUS: emit_call("dyn_add"); break;
+                    case TOKEN_MINUS: emit_call("dyn_sub"); break;
+                    case TOKEN_STAR: emit_call("dyn_mul"); break;
+                    case TOKEN_SLASH: emit_call("dyn_div"); break;
+                    case TOKEN_PERCENT: emit_call("dyn_mod"); break;
+                    case TOKEN_EQEQ: emit_call("dyn_eq"); break;
+                    case TOKEN_NEQ: emit_call("dyn_neq"); break;
+                    case TOKEN_LT: emit_call("dyn_lt"); break;
+                    case TOKEN_GT: emit_call("dyn_gt"); break;
                     default: break;
                 }
             }
             break;
         }
         case NODE_CALL: {
-            AstNode* arg = node->data.call.args;
+            AstNode* inlined = inline_func ? NULL : pgo_inline_target(node, program_root);
+            if (inlined) {
+                gen_inline_call(inlined, node);
+                break;
+            }
+            FormatPlan* format = format_plan(node, program_root);
+            if (format) {
+                gen_format(format);
+                format_plan_free(format);
+                break;
+            }
+            AstNode* target = AST_KID(node, call.callee);
+            if (pgo_mode == PGO_GENERATE && ast_type(target) == NODE_VAR_ACCESS && target->data.var_access.id == -1 &&
+                is_local_function(target->data.var_access.name)) {
+                gen_profile_count(node, "call");
+            }
+            AstNode* arg = AST_KID(node, call.args);
             AstNode* arg_list[64]; 
             int arg_count = 0;
-            while(arg && arg_count < 64) { arg_list[arg_count++] = arg; arg = arg->next; }
+            while(arg && arg_count < 64) { arg_list[arg_count++] = arg; arg = AST_NEXT(arg); }
             
-            int implicit_this = (node->data.call.callee->type == NODE_GET);
+            int implicit_this = (ast_type(AST_KID(node, call.callee)) == NODE_GET);
+            AstNode* known = implicit_this ? NULL : known_closure(AST_KID(node, call.callee));
             int total_args = arg_count + implicit_this;
             int stack_args = (total_args > 6)? total_args - 6 : 0;
-            if (stack_args % 2!= 0) emit("sub rsp, 8"); 
+            if (stack_args % 2!= 0) emit(X64_SUB, R(X64_RSP), x64_imm(8));
 
             for (int i = arg_count - 1; i >= 0; i--) {
                 gen_expression(arg_list[i]);
-                emit("push rax");
+                emit(X64_PUSH, R(X64_RAX), x64_none());
             }
 
             if (implicit_this) {
-                gen_expression(node->data.call.callee->data.get.obj); 
-                emit("push rax"); 
-                gen_string_literal(node->data.call.callee->data.get.name);
-                emit("mov rsi, rax"); 
-                emit("mov rdi, [rsp]"); 
-                emit("call aria_obj_get");
-                emit("mov r10, rax"); 
+                gen_expression(AST_KID(AST_KID(node, call.callee), get.obj)); 
+                emit(X64_PUSH, R(X64_RAX), x64_none());
+                gen_string_literal(AST_KID(node, call.callee)->data.get.name);
+                emit(X64_MOV, R(X64_RSI), R(X64_RAX));
+                emit(X64_MOV, R(X64_RDI), x64_mem(X64_RSP, 0));
+                gen_obj_get(AST_KID(node, call.callee));
+                emit(X64_MOV, R(X64_R10), R(X64_RAX));
             } else {
-                if (node->data.call.callee->type == NODE_VAR_ACCESS && node->data.call.callee->data.var_access.id == -1) {
+                if (ast_type(AST_KID(node, call.callee)) == NODE_VAR_ACCESS && AST_KID(node, call.callee)->data.var_access.id == -1) {
+                } else if (known && known->data.func_decl.upvalue_count == 0) {
                 } else {
-                     gen_expression(node->data.call.callee);
-                     emit("mov r10, rax");
+                     gen_expression(AST_KID(node, call.callee));
+                     emit(X64_MOV, R(X64_R10), R(X64_RAX));
                 }
             }
 
             int reg_idx = 0;
             if (implicit_this) {
-                emit("pop rdi"); 
+                emit(X64_POP, R(X64_RDI), x64_none());
                 reg_idx++;
             }
             for (int i = 0; i < arg_count; i++) {
-                if (reg_idx < 6) emit("pop %s", ABI_ARG_REGS[reg_idx++]);
+                if (reg_idx < 6) emit(X64_POP, R(ABI_ARG_REGS[reg_idx++]), x64_none());
             }
 
-            if (implicit_this) emit("call r10");
+            if (implicit_this) gen_dynamic_call();
             else {
-                if (node->data.call.callee->type == NODE_VAR_ACCESS && node->data.call.callee->data.var_access.id == -1) {
-                     emit("call %s", node->data.call.callee->data.var_access.name);
+                if (ast_type(AST_KID(node, call.callee)) == NODE_VAR_ACCESS && AST_KID(node, call.callee)->data.var_access.id == -1) {
+                     emit_call(AST_KID(node, call.callee)->data.var_access.name);
+                } else if (known) {
+                     // Known closure: direct call, record (if any) untagged into R10
+                     if (known->data.func_decl.upvalue_count > 0) {
+                         emit(X64_MOV, R(X64_R11), x64_imm(CLOSURE_TAG));
+                         emit(X64_XOR, R(X64_R10), R(X64_R11));
+                     }
+                     emit_call(known->data.func_decl.name);
                 } else {
-                     emit("call r10");
+                     gen_dynamic_call();
                 }
             }
             
             if (stack_args > 0) {
                 int total_cleanup = stack_args * 8;
                 if (stack_args % 2!= 0) total_cleanup += 8;
-                emit("add rsp, %d", total_cleanup);
+                emit(X64_ADD, R(X64_RSP), x64_imm(total_cleanup));
             }
             break;
         }
         case NODE_ARRAY_LITERAL: {
-            emit("call list_new"); 
-            AstNode* elem = node->data.array_literal.elements;
+            FrameAlloc* fa = escape_find(node);
+            if (fa) {
+                emit(X64_LEA, R(X64_RDI), x64_mem(X64_RBP, fa->offset));
+                emit(X64_MOV, R(X64_RSI), x64_imm(fa->capacity));
+                emit_call("list_new_at");
+            } else {
+                emit_call("list_new");
+            }
+            AstNode* elem = AST_KID(node, array_literal.elements);
             while(elem) {
-                emit("push rax"); gen_expression(elem); 
-                emit("mov rsi, rax"); emit("pop rdi"); emit("push rdi");     
-                emit("call list_push"); emit("pop rax"); elem = elem->next;
+                emit(X64_PUSH, R(X64_RAX), x64_none()); gen_expression(elem);
+                emit(X64_MOV, R(X64_RSI), R(X64_RAX)); emit(X64_POP, R(X64_RDI), x64_none()); emit(X64_PUSH, R(X64_RDI), x64_none());
+                emit_call("list_push"); emit(X64_POP, R(X64_RAX), x64_none()); elem = AST_NEXT(elem);
             }
             break;
         }
         case NODE_INDEX_GET: {
-            gen_expression(node->data.index_get.obj); emit("push rax"); 
-            gen_expression(node->data.index_get.index);
-            emit("mov rsi, rax"); emit("pop rdi"); emit("call list_get");
+            gen_expression(AST_KID(node, index_get.obj)); emit(X64_PUSH, R(X64_RAX), x64_none());
+            gen_expression(AST_KID(node, index_get.index));
+            emit(X64_MOV, R(X64_RSI), R(X64_RAX)); emit(X64_POP, R(X64_RDI), x64_none()); emit_call("list_get");
             break;
         }
         case NODE_INDEX_SET: {
-            gen_expression(node->data.index_set.obj); emit("push rax"); 
-            gen_expression(node->data.index_set.index); emit("push rax"); 
-            gen_expression(node->data.index_set.value);
-            emit("mov rdx, rax"); emit("pop rsi"); emit("pop rdi");      
-            emit("call list_set"); 
+            gen_expression(AST_KID(node, index_set.obj)); emit(X64_PUSH, R(X64_RAX), x64_none());
+            gen_expression(AST_KID(node, index_set.index)); emit(X64_PUSH, R(X64_RAX), x64_none());
+            gen_expression(AST_KID(node, index_set.value));
+            emit(X64_MOV, R(X64_RDX), R(X64_RAX)); emit(X64_POP, R(X64_RSI), x64_none()); emit(X64_POP, R(X64_RDI), x64_none());
+            emit_call("list_set");
             // Result is in RAX now
             break;
         }
         case NODE_NEW: {
-            emit("call aria_alloc_object"); emit("push rax");
+            FrameAlloc* fa = escape_find(node);
+            if (fa) {
+                emit(X64_LEA, R(X64_RDI), x64_mem(X64_RBP, fa->offset));
+                emit_call("aria_alloc_object_at");
+            } else {
+                emit_call("aria_alloc_object");
+            }
+            emit(X64_PUSH, R(X64_RAX), x64_none());
             AstNode* cls = program_root;
             while(cls) {
-                if (cls->type == NODE_CLASS_DECL && strcmp(cls->data.class_decl.name, node->data.string_val) == 0) {
-                    AstNode* method = cls->data.class_decl.methods;
+                if (ast_type(cls) == NODE_CLASS_DECL && strcmp(cls->data.class_decl.name, node->data.string_val) == 0) {
+                    // Methods are already mangled to Class_method; the object key is the bare name
+                    size_t prefix = strlen(cls->data.class_decl.name) + 1;
+                    AstNode* method = AST_KID(cls, class_decl.methods);
                     while(method) {
-                         gen_string_literal(method->data.func_decl.name); 
-                         emit("mov rsi, rax"); 
-                         char mangled[256];
-                         snprintf(mangled, 256, "%s_%s", cls->data.class_decl.name, method->data.func_decl.name);
-                         emit("mov rdx, %s", mangled);
-                         emit("mov rdi, [rsp]"); 
-                         emit("call aria_obj_set");
-                         method = method->next;
+                         const char* mangled = method->data.func_decl.name;
+                         gen_string_literal(strlen(mangled) > prefix ? mangled + prefix : mangled);
+                         emit(X64_MOV, R(X64_RSI), R(X64_RAX));
+                         gen_function_address(X64_RDX, mangled);
+                         emit(X64_MOV, R(X64_RDI), x64_mem(X64_RSP, 0));
+                         emit_call("aria_obj_set");
+                         method = AST_NEXT(method);
                     }
                     break;
                 }
-                cls = cls->next;
+                cls = AST_NEXT(cls);
             }
-            emit("pop rax");
+            emit(X64_POP, R(X64_RAX), x64_none());
             break;
         }
         case NODE_GET: {
-            gen_expression(node->data.get.obj); emit("push rax"); 
+            gen_expression(AST_KID(node, get.obj)); emit(X64_PUSH, R(X64_RAX), x64_none());
             gen_string_literal(node->data.get.name); 
-            emit("mov rsi, rax"); emit("pop rdi"); emit("call aria_obj_get");
+            emit(X64_MOV, R(X64_RSI), R(X64_RAX)); emit(X64_POP, R(X64_RDI), x64_none()); gen_obj_get(node);
             break;
         }
         case NODE_SET: {
-            gen_expression(node->data.set.obj); emit("push rax"); 
-            gen_expression(node->data.set.value); emit("push rax"); 
+            gen_expression(AST_KID(node, set.obj)); emit(X64_PUSH, R(X64_RAX), x64_none());
+            gen_expression(AST_KID(node, set.value)); emit(X64_PUSH, R(X64_RAX), x64_none());
             gen_string_literal(node->data.set.name);
-            emit("mov rsi, rax"); emit("pop rdx"); emit("pop rdi");      
-            emit("call aria_obj_set"); 
+            emit(X64_MOV, R(X64_RSI), R(X64_RAX)); emit(X64_POP, R(X64_RDX), x64_none()); emit(X64_POP, R(X64_RDI), x64_none());
+            emit_call("aria_obj_set");
             break;
         }
         case NODE_TERNARY: {
-            int f = label_seq++, e = label_seq++;
-            gen_expression(node->data.ternary.condition);
-            emit("mov rdi, rax"); emit("call dyn_truthy"); emit("test rax, rax");
-            emit("jz.Ltern_%d", f); gen_expression(node->data.ternary.true_expr); emit("jmp.Ltern_end_%d", e);
-            fprintf(asm_out, ".Ltern_%d:\n", f); gen_expression(node->data.ternary.false_expr);
-            fprintf(asm_out, ".Ltern_end_%d:\n", e);
+            int f = x64_new_label(x64_out, "tern"), e = x64_new_label(x64_out, "tern_end");
+            gen_expression(AST_KID(node, ternary.condition));
+            emit(X64_MOV, R(X64_RDI), R(X64_RAX)); emit_call("dyn_truthy"); emit(X64_TEST, R(X64_RAX), R(X64_RAX));
+            emit(X64_JE, x64_label(f), x64_none()); gen_expression(AST_KID(node, ternary.true_expr)); emit(X64_JMP, x64_label(e), x64_none());
+            emit_label(f); gen_expression(AST_KID(node, ternary.false_expr));
+            emit_label(e);
             break;
         }
         default: break;
     }
 }
 
+void gen_statement(AstNode* node);
+
+/*
+ * for (var i = start; i < limit; i = i + step): the counter and its bound are
+ * raw integers in registers or spill slots. The bound is converted once when
+ * the limit cannot change in the body, and the counter is only boxed into i
+ * when the body reads it.
+ */
+static void gen_for_range(AstNode* node) {
+    ForStmtData* loop = &node->data.for_stmt;
+    AstNode* var = ast_at(node, loop->var);
+    AstNode* limit = ast_at(node, loop->iterable);
+    AstNode* body = ast_at(node, loop->body);
+    int64_t step = ast_at(node, loop->step)->data.int_val;
+    int vid = var->data.var_decl.shadow_stack_offset;
+    X64Operand counter = get_location(LOOP_STATE_ID(vid, 0));
+    X64Operand bound = get_location(LOOP_STATE_ID(vid, 1));
+    int invariant = loop_limit_is_invariant(limit, body);
+    int start = x64_new_label(x64_out, "for"), end = x64_new_label(x64_out, "end");
+
+    if (invariant) {
+        gen_expression(limit);
+        emit(X64_MOV, R(X64_RDI), R(X64_RAX)); emit_call("dyn_loop_bound");
+        emit(X64_MOV, bound, R(X64_RAX));
+    }
+    emit(X64_MOV, R(X64_RAX), x64_imm(ast_at(node, loop->start)->data.int_val));
+    emit(X64_MOV, counter, R(X64_RAX));
+    emit_label(start);
+    gen_safepoint_poll();
+    if (!invariant) {
+        gen_expression(limit);
+        emit(X64_MOV, R(X64_RDI), R(X64_RAX)); emit_call("dyn_loop_bound");
+        emit(X64_MOV, bound, R(X64_RAX));
+    }
+    emit(X64_MOV, R(X64_RAX), counter);
+    emit(X64_CMP, R(X64_RAX), bound);
+    emit(X64_JGE, x64_label(end), x64_none());
+    if (loop_reads_var(body, var)) {
+        emit(X64_MOV, R(X64_RDI), R(X64_RAX)); emit_call("dyn_new_int");
+        gen_store_var(vid, var);
+    }
+    gen_statement(body);
+    if (step <= INT32_MAX) {
+        emit(X64_ADD, counter, x64_imm(step));
+    } else {
+        emit(X64_MOV, R(X64_R11), x64_imm(step));
+        emit(X64_ADD, counter, R(X64_R11));
+    }
+    emit(X64_JMP, x64_label(start), x64_none());
+    emit_label(end);
+}
+
+// Copies a list header's int count (offset 12), then its item pointer
+// (offset 0): a pointer read after the count always covers it
+static void gen_list_fields(X64Operand header, X64Operand items, X64Operand count) {
+    emit(X64_MOV, R(X64_R11), header);
+    emit(X64_MOV, R(X64_RAX), x64_mem32(X64_R11, 12));
+    emit(X64_MOV, count, R(X64_RAX));
+    emit(X64_MOV, R(X64_RAX), x64_mem(X64_R11, 0));
+    emit(X64_MOV, items, R(X64_RAX));
+}
+
+/*
+ * for (var x in list): elements are loaded straight from the list's item
+ * array, skipping the list_get call and its bounds check. When the body cannot
+ * resize the list, the item pointer and count are read once before the loop;
+ * otherwise they are re-read from the header each iteration. Int lists pack
+ * their items as int32 and tag the pointer's top bits; those elements are
+ * read through the untagged pointer with a zero-extending 32-bit load and
+ * boxed inline.
+ */
+static void gen_for_each(AstNode* node) {
+    ForStmtData* loop = &node->data.for_stmt;
+    AstNode* var = ast_at(node, loop->var);
+    AstNode* body = ast_at(node, loop->body);
+    int vid = var->data.var_decl.shadow_stack_offset;
+    X64Operand index = get_location(LOOP_STATE_ID(vid, 0));
+    X64Operand header = get_location(LOOP_STATE_ID(vid, 1));
+    X64Operand items = get_location(LOOP_STATE_ID(vid, 2));
+    X64Operand count = get_location(LOOP_STATE_ID(vid, 3));
+    int stable = loop_list_is_stable(body, program_root);
+    int start = x64_new_label(x64_out, "for"), end = x64_new_label(x64_out, "end");
+
+    gen_expression(ast_at(node, loop->iterable));
+    emit(X64_MOV, R(X64_RDI), R(X64_RAX)); emit_call("list_header");
+    emit(X64_MOV, header, R(X64_RAX));
+    emit(X64_MOV, index, x64_imm(0));
+    gen_append_reset(vid);
+    if (stable) gen_list_fields(header, items, count);
+    emit_label(start);
+    gen_safepoint_poll();
+    if (!stable) gen_list_fields(header, items, count);
+    emit(X64_MOV, R(X64_RAX), index);
+    emit(X64_CMP, R(X64_RAX), count);
+    emit(X64_JGE, x64_label(end), x64_none());
+    if (is_boxed(var)) {
+        gen_new_cell(vid);
+        emit(X64_MOV, R(X64_RAX), index);
+    }
+    int packed = x64_new_label(x64_out, "each_ints"), loaded = x64_new_label(x64_out, "each_item");
+    emit(X64_MOV, R(X64_R11), items);
+    emit(X64_CMP, R(X64_R11), x64_imm(0));
+    emit(X64_JL, x64_label(packed), x64_none());
+    emit(X64_MOV, R(X64_RAX), x64_mem_index(X64_R11, X64_RAX, 8, 0));
+    emit(X64_JMP, x64_label(loaded), x64_none());
+    emit_label(packed);
+    X64Operand packed_item = x64_mem_index(X64_R11, X64_RAX, 4, 0);
+    packed_item.size = 4;
+    emit(X64_MOV, R(X64_R10), x64_imm(INTS_TAG));
+    emit(X64_XOR, R(X64_R11), R(X64_R10));
+    emit(X64_MOV, R(X64_RAX), packed_item);
+    emit(X64_MOV, R(X64_R10), x64_imm(INT_BOX_TAG));
+    emit(X64_OR, R(X64_RAX), R(X64_R10));
+    emit_label(loaded);
+    gen_store_var(vid, var);
+    gen_statement(body);
+    emit(X64_ADD, index, x64_imm(1));
+    emit(X64_JMP, x64_label(start), x64_none());
+    emit_label(end);
+}
+
+// Jumps through a table of 'count' labels indexed by RAX, which the caller
+// has bounds-checked. The targets must be emitted after the table.
+static void gen_jump_table(const int* targets, int count) {
+    int table = x64_new_label(x64_out, "table");
+    X64Operand entry = x64_mem_index(X64_R11, X64_RAX, 4, 0);
+    entry.size = 4;
+    emit(X64_LEA, R(X64_R11), x64_rip_label(table));
+    emit(X64_MOV, R(X64_RAX), entry);
+    emit(X64_ADD, R(X64_RAX), R(X64_R11));
+    emit(X64_JMP, R(X64_RAX), x64_none());
+    emit_label(table);
+    for (int i = 0; i < count; i++) emit(X64_CASE, x64_label(targets[i]), x64_label(table));
+}
+
+// Binary search for the integer key in RAX over plan->ints[lo, hi)
+static void gen_int_search(MatchPlan* plan, int lo, int hi, const int* arm_labels, int miss) {
+    if (hi - lo <= 3) {
+        for (int i = lo; i < hi; i++) {
+            emit(X64_CMP, R(X64_RAX), x64_imm(plan->ints[i].key));
+            emit(X64_JE, x64_label(arm_labels[plan->ints[i].arm]), x64_none());
+        }
+        emit(X64_JMP, x64_label(miss), x64_none());
+        return;
+    }
+    int mid = lo + (hi - lo) / 2, below = x64_new_label(x64_out, "match_lt");
+    emit(X64_CMP, R(X64_RAX), x64_imm(plan->ints[mid].key));
+    emit(X64_JE, x64_label(arm_labels[plan->ints[mid].arm]), x64_none());
+    emit(X64_JL, x64_label(below), x64_none());
+    gen_int_search(plan, mid + 1, hi, arm_labels, miss);
+    emit_label(below);
+    gen_int_search(plan, lo, mid, arm_labels, miss);
+}
+
+static void gen_int_dispatch(MatchPlan* plan, const int* arm_labels, int miss) {
+    emit(X64_MOV, R(X64_RDI), R(X64_RAX));
+    emit_call("dyn_match_int");
+    if (plan->int_strategy != MATCH_TABLE) {
+        gen_int_search(plan, 0, plan->int_count, arm_labels, miss);
+        return;
+    }
+    int64_t min = plan->ints[0].key;
+    int span = (int)(plan->ints[plan->int_count - 1].key - min + 1);
+    int* targets = malloc(sizeof(int) * span);
+    for (int i = 0; i < span; i++) targets[i] = miss;
+    for (int i = 0; i < plan->int_count; i++) targets[plan->ints[i].key - min] = arm_labels[plan->ints[i].arm];
+    // Non-integers come back as LLONG_MIN, which lands far outside the span
+    emit(X64_MOV, R(X64_R11), x64_imm(min));
+    emit(X64_SUB, R(X64_RAX), R(X64_R11));
+    emit(X64_CMP, R(X64_RAX), x64_imm(span));
+    emit(X64_JAE, x64_label(miss), x64_none());
+    gen_jump_table(targets, span);
+    free(targets);
+}
+
+// Hashes the subject at [rsp] into its slot, then confirms each candidate of the slot
+static void gen_string_dispatch(MatchPlan* plan, const int* arm_labels, int miss) {
+    emit(X64_MOV, R(X64_RDI), x64_mem(X64_RSP, 0));
+    emit(X64_MOV, R(X64_RSI), x64_imm((int64_t)plan->seed));
+    emit(X64_MOV, R(X64_RDX), x64_imm(plan->slot_count - 1));
+    emit_call("dyn_match_str");
+    emit(X64_CMP, R(X64_RAX), x64_imm(plan->slot_count));
+    emit(X64_JAE, x64_label(miss), x64_none());
+    int* targets = malloc(sizeof(int) * plan->slot_count);
+    for (int slot = 0; slot < plan->slot_count; slot++) {
+        int empty = plan->slot_start[slot] == plan->slot_start[slot + 1];
+        targets[slot] = empty ? miss : x64_new_label(x64_out, "match_slot");
+    }
+    gen_jump_table(targets, plan->slot_count);
+    for (int slot = 0; slot < plan->slot_count; slot++) {
+        if (targets[slot] == miss) continue;
+        emit_label(targets[slot]);
+        for (int i = plan->slot_start[slot]; i < plan->slot_start[slot + 1]; i++) {
+            gen_string_literal(plan->strs[i].key);
+            emit(X64_MOV, R(X64_RSI), R(X64_RAX));
+            emit(X64_MOV, R(X64_RDI), x64_mem(X64_RSP, 0));
+            emit_call("dyn_str_equals");
+            emit(X64_TEST, R(X64_RAX), R(X64_RAX));
+            emit(X64_JNE, x64_label(arm_labels[plan->strs[i].arm]), x64_none());
+        }
+        emit(X64_JMP, x64_label(miss), x64_none());
+    }
+    free(targets);
+}
+
+/*
+ * match (see backend/match.h): integer cases dispatch first, anything they
+ * miss goes on to the string hash, and anything that misses both runs the
+ * 'else' arm. String dispatch needs the subject after dyn_match_int, so it
+ * is parked in a 16-byte stack slot that every arm entry releases.
+ */
+static void gen_match(AstNode* node) {
+    MatchPlan* plan = match_plan(node);
+    int* arm_labels = malloc(sizeof(int) * (plan->arm_count + 1));
+    for (int i = 0; i < plan->arm_count; i++) arm_labels[i] = x64_new_label(x64_out, "match_arm");
+    int fallback = x64_new_label(x64_out, "match_else"), end = x64_new_label(x64_out, "match_end");
+    int parked = plan->str_count > 0;
+
+    gen_expression(AST_KID(node, match.subject));
+    if (parked) {
+        emit(X64_SUB, R(X64_RSP), x64_imm(16));
+        emit(X64_MOV, x64_mem(X64_RSP, 0), R(X64_RAX));
+    }
+    if (plan->int_count > 0) {
+        int miss = parked ? x64_new_label(x64_out, "match_str") : fallback;
+        gen_int_dispatch(plan, arm_labels, miss);
+        if (parked) emit_label(miss);
+    }
+    if (plan->str_count > 0) gen_string_dispatch(plan, arm_labels, fallback);
+    if (plan->int_count == 0 && plan->str_count == 0) emit(X64_JMP, x64_label(fallback), x64_none());
+
+    for (int i = 0; i < plan->arm_count; i++) {
+        emit_label(arm_labels[i]);
+        if (parked) emit(X64_ADD, R(X64_RSP), x64_imm(16));
+        gen_statement(AST_KID(plan->arms[i], match_arm.body));
+        emit(X64_JMP, x64_label(end), x64_none());
+    }
+    emit_label(fallback);
+    if (parked) emit(X64_ADD, R(X64_RSP), x64_imm(16));
+    gen_statement(AST_KID(node, match.otherwise));
+    emit_label(end);
+    free(arm_labels);
+    match_plan_free(plan);
+}
+
+// Evaluates an expression and sets ZF when it is falsy
+static void gen_condition(AstNode* cond) {
+    gen_expression(cond);
+    emit(X64_MOV, R(X64_RDI), R(X64_RAX)); emit_call("dyn_truthy"); emit(X64_TEST, R(X64_RAX), R(X64_RAX));
+}
+
+/*
+ * A loop the profile shows to be hot is rotated: the test moves below the
+ * body, so each iteration ends in one taken conditional branch instead of
+ * a jump back plus a test at the top.
+ */
+static void gen_while(AstNode* node) {
+    int end = x64_new_label(x64_out, "end");
+    if (pgo_is_hot(pgo_count(node, "body"))) {
+        int body = x64_new_label(x64_out, "loop"), test = x64_new_label(x64_out, "loop_test");
+        emit(X64_JMP, x64_label(test), x64_none());
+        emit_label(body);
+        gen_statement(AST_KID(node, while_stmt.body));
+        emit_label(test);
+        gen_line(node->line);
+        gen_safepoint_poll();
+        gen_condition(AST_KID(node, while_stmt.condition));
+        emit(X64_JNE, x64_label(body), x64_none());
+        emit_label(end);
+        return;
+    }
+    int start = x64_new_label(x64_out, "loop");
+    emit_label(start);
+    gen_safepoint_poll();
+    gen_condition(AST_KID(node, while_stmt.condition));
+    emit(X64_JE, x64_label(end), x64_none());
+    gen_profile_count(node, "body");
+    gen_statement(AST_KID(node, while_stmt.body)); emit(X64_JMP, x64_label(start), x64_none());
+    emit_label(end);
+}
+
+// The side of an if that the profile saw more often falls through; the other is branched to
+static void gen_if(AstNode* node) {
+    IfStmtData* s = &node->data.if_stmt;
+    int flip = pgo_count(node, "else") > pgo_count(node, "then");
+    int other = x64_new_label(x64_out, flip ? "then" : "else"), en = x64_new_label(x64_out, "end");
+    gen_condition(ast_at(node, s->condition));
+    emit(flip ? X64_JNE : X64_JE, x64_label(other), x64_none());
+    gen_profile_count(node, flip ? "else" : "then");
+    gen_statement(flip ? ast_at(node, s->else_branch) : ast_at(node, s->then_branch));
+    emit(X64_JMP, x64_label(en), x64_none());
+    emit_label(other);
+    gen_profile_count(node, flip ? "then" : "else");
+    gen_statement(flip ? ast_at(node, s->then_branch) : ast_at(node, s->else_branch));
+    emit_label(en);
+}
+
 void gen_statement(AstNode* node) {
     if (!node) return;
-    switch (node->type) {
+    gen_line(node->line);
+    switch (ast_type(node)) {
         case NODE_VAR_DECL:
+            if (node->data.var_decl.is_boxed) gen_new_cell(node->data.var_decl.shadow_stack_offset);
             if (node->data.var_decl.init_expr) {
-                gen_expression(node->data.var_decl.init_expr);
-                emit("mov %s, rax", get_location(node->data.var_decl.shadow_stack_offset));
+                gen_expression(AST_KID(node, var_decl.init_expr));
+                gen_store_var(node->data.var_decl.shadow_stack_offset, node);
             }
+            gen_append_reset(node->data.var_decl.shadow_stack_offset);
             break;
-        case NODE_WHILE: {
-            int start = label_seq++, end = label_seq++;
-            fprintf(asm_out, ".Lloop_%d:\n", start);
-            gen_safepoint_poll(label_seq++);
-            gen_expression(node->data.while_stmt.condition);
-            emit("mov rdi, rax"); emit("call dyn_truthy"); emit("test rax, rax");
-            emit("jz.Lend_%d", end);
-            gen_statement(node->data.while_stmt.body); emit("jmp.Lloop_%d", start);
-            fprintf(asm_out, ".Lend_%d:\n", end);
+        case NODE_WHILE: gen_while(node); break;
+        case NODE_FOR:
+            if (node->data.for_stmt.is_each) gen_for_each(node);
+            else gen_for_range(node);
             break;
-        }
-        case NODE_IF: {
-            int el = label_seq++, en = label_seq++;
-            gen_expression(node->data.if_stmt.condition);
-            emit("mov rdi, rax"); emit("call dyn_truthy"); emit("test rax, rax");
-            emit("jz.Lelse_%d", el);
-            gen_statement(node->data.if_stmt.then_branch); emit("jmp.Lend_%d", en);
-            fprintf(asm_out, ".Lelse_%d:\n", el);
-            if (node->data.if_stmt.else_branch) gen_statement(node->data.if_stmt.else_branch);
-            fprintf(asm_out, ".Lend_%d:\n", en);
+        case NODE_MATCH: gen_match(node); break;
+        case NODE_IF: gen_if(node); break;
+        case NODE_BLOCK: { AstNode* s = AST_KID(node, block.body); while(s) { gen_statement(s); s = AST_NEXT(s); } break; }
+        case NODE_RETURN: if (node->data.return_stmt.expr) gen_expression(AST_KID(node, return_stmt.expr)); gen_epilogue(); break;
+        case NODE_ASSIGN:
+            if (append_is_lowered(node)) gen_append(node);
+            else gen_expression(node);
             break;
-        }
-        case NODE_BLOCK: { AstNode* s = node->data.func_decl.body; while(s) { gen_statement(s); s = s->next; } break; }
-        case NODE_RETURN: if (node->data.return_stmt.expr) gen_expression(node->data.return_stmt.expr); emit("leave"); emit("ret"); break;
-        case NODE_CALL: case NODE_ASSIGN: case NODE_INDEX_SET: case NODE_SET: gen_expression(node); break;
+        case NODE_CALL: case NODE_INDEX_SET: case NODE_SET: case NODE_FUNC_DECL: gen_expression(node); break;
         default: break;
     }
 }
 
 void gen_function_node(AstNode* curr) {
+    current_function = curr;
+    pgo_function(curr);
     global_intervals.count = 0; instruction_counter = 0;
-    AstNode* p = curr->data.func_decl.params;
-    while(p) { liveness_record_use(p->data.var_decl.shadow_stack_offset, 0); p = p->next; }
-    analyze_liveness(curr->data.func_decl.body);
+    append_analyze(curr);
+    AstNode* p = AST_KID(curr, func_decl.params);
+    while(p) { liveness_record_use(p->data.var_decl.shadow_stack_offset, 0); p = AST_NEXT(p); }
+    analyze_liveness(AST_KID(curr, func_decl.body));
     allocate_registers();
-    fprintf(asm_out, "%s:\n", curr->data.func_decl.name);
-    emit("push rbp"); emit("mov rbp, rsp");
-    gen_safepoint_poll(label_seq++); emit("sub rsp, %d", max_stack_usage); 
-    p = curr->data.func_decl.params; int param_idx = 0;
+    // Non-escaping lists and objects live below the spill slots
+    int frame_allocs = escape_analyze(curr, program_root);
+    for (int i = 0; i < frame_allocs; i++) {
+        FrameAlloc* fa = escape_frame_alloc(i);
+        max_stack_usage += fa->bytes;
+        fa->offset = -max_stack_usage;
+    }
+    emit(X64_FUNC, x64_sym(curr->data.func_decl.name), x64_none());
+    gen_line(curr->line);
+    gen_frame_enter();
+    emit(X64_SUB, R(X64_RSP), x64_imm(max_stack_usage));
+    if (curr->data.func_decl.upvalue_count > 0) emit(X64_MOV, x64_mem(X64_RBP, ENV_SLOT), R(X64_R10));
+    for (int r = 0; r < REG_COUNT; r++) {
+        if (saved_regs_mask & (1 << r)) emit(X64_MOV, x64_mem(X64_RBP, -16 - 8 * r), R(REG_NAMES[r]));
+    }
+    p = AST_KID(curr, func_decl.params); int param_idx = 0;
     while(p && param_idx < 6) {
         int vid = p->data.var_decl.shadow_stack_offset;
-        const char* dst = get_location(vid); const char* src = ABI_ARG_REGS[param_idx];
-        if (strcmp(dst, src)!= 0) emit("mov %s, %s", dst, src);
-        p = p->next; param_idx++;
+        X64Operand dst = get_location(vid); X64Reg src = ABI_ARG_REGS[param_idx];
+        if (dst.kind != X64_OP_REG || dst.reg != src) emit(X64_MOV, dst, R(src));
+        p = AST_NEXT(p); param_idx++;
+    }
+    // Parameters are in callee-saved registers or the frame now, so calls are safe
+    for (p = AST_KID(curr, func_decl.params); p; p = AST_NEXT(p)) {
+        gen_append_reset(p->data.var_decl.shadow_stack_offset);
+        if (!p->data.var_decl.is_boxed) continue;
+        int vid = p->data.var_decl.shadow_stack_offset;
+        emit(X64_MOV, R(X64_RDI), x64_imm(8));
+        emit_call("aria_alloc");
+        emit(X64_MOV, R(X64_R11), get_location(vid));
+        emit(X64_MOV, x64_mem(X64_RAX, 0), R(X64_R11));
+        emit(X64_MOV, get_location(vid), R(X64_RAX));
     }
-    gen_statement(curr->data.func_decl.body);
-    emit("leave"); emit("ret");
+    gen_profile_count(curr, "entry");
+    gen_safepoint_poll();
+    gen_statement(AST_KID(curr, func_decl.body));
+    gen_epilogue();
+    current_function = NULL;
 }
 
-void gen_program(AstNode* head) {
+// Registers every top-level global as a GC root, then runs its initializer
+static void gen_global_setup(AstNode* head) {
+    AstNode* curr = head; while(curr) { if (ast_type(curr) == NODE_VAR_DECL) { emit(X64_LEA, R(X64_RDI), x64_rip_sym(curr->data.var_decl.name)); emit_call("aria_register_global_root"); } curr = AST_NEXT(curr); }
+    curr = head; while(curr) { if (ast_type(curr) == NODE_VAR_DECL && AST_KID(curr, var_decl.init_expr)) { gen_expression(AST_KID(curr, var_decl.init_expr)); emit(X64_MOV, x64_rip_sym(curr->data.var_decl.name), R(X64_RAX)); } curr = AST_NEXT(curr); }
+}
+
+typedef struct {
+    AstNode* func;
+    uint64_t entries;
+    int order;
+} RankedFunction;
+
+static int compare_hotness(const void* a, const void* b) {
+    const RankedFunction* x = a;
+    const RankedFunction* y = b;
+    if (x->entries != y->entries) return x->entries > y->entries ? -1 : 1;
+    return x->order - y->order;
+}
+
+// Emits every function and class method; imported (extern) classes only describe layout.
+// With a profile they are emitted hottest first, keeping hot code on few pages.
+static void gen_functions(AstNode* head) {
+    int count = 0;
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_FUNC_DECL) count++;
+        else if (ast_type(curr) == NODE_CLASS_DECL && !curr->data.class_decl.is_extern) {
+            for (AstNode* m = AST_KID(curr, class_decl.methods); m; m = AST_NEXT(m)) count++;
+        }
+    }
+    RankedFunction* funcs = malloc(sizeof(RankedFunction) * (count ? count : 1));
+    int n = 0;
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_FUNC_DECL) {
+            funcs[n] = (RankedFunction){ curr, pgo_count(curr, "entry"), n }; n++;
+        } else if (ast_type(curr) == NODE_CLASS_DECL && !curr->data.class_decl.is_extern) {
+            for (AstNode* m = AST_KID(curr, class_decl.methods); m; m = AST_NEXT(m)) { funcs[n] = (RankedFunction){ m, pgo_count(m, "entry"), n }; n++; }
+        }
+    }
+    if (pgo_mode == PGO_USE) qsort(funcs, n, sizeof(RankedFunction), compare_hotness);
+    for (int i = 0; i < n; i++) gen_function_node(funcs[i].func);
+    free(funcs);
+    // Lifted closures, including ones nested inside other closures
+    for (int i = 0; i < pending_count; i++) gen_function_node(pending_closures[i]);
+    pending_count = 0;
+}
+
+static void begin_codegen(AstNode* head) {
     program_root = head;
+    pgo_reset();
+    escape_analyze(NULL, head);
     global_intervals.capacity = 128; global_intervals.count = 0;
     global_intervals.intervals = malloc(sizeof(LiveInterval) * 128);
-    fprintf(asm_out, "global main\n");
-    fprintf(asm_out, "extern gc_suspend_request, gc_enter_safepoint, aria_runtime_init, aria_register_global_root\n");
-    fprintf(asm_out, "extern print, println, aria_alloc, exit\n");
-    fprintf(asm_out, "extern list_new, list_push, list_get, list_set\n");
-    fprintf(asm_out, "extern aria_alloc_object, aria_obj_get, aria_obj_set\n");
-    fprintf(asm_out, "extern dyn_new_int, dyn_new_float, dyn_new_str, dyn_new_bool, dyn_new_null\n");
-    fprintf(asm_out, "extern dyn_add, dyn_sub, dyn_mul, dyn_div, dyn_mod\n"); // Added dyn_mod
-    fprintf(asm_out, "extern dyn_truthy, dyn_eq, dyn_neq, dyn_lt, dyn_gt, dyn_neg, dyn_not\n"); // Added dyn_neg, dyn_not
-    
-    fprintf(asm_out, "section .data\n");
+    pending_count = 0;
+}
+
+static void gen_prologue(const char* name, int frame) {
+    emit(X64_FUNC, x64_sym(name), x64_none());
+    gen_frame_enter();
+    emit(X64_SUB, R(X64_RSP), x64_imm(frame));
+}
+
+/*
+ * Profile data blocks, emitted after every function so their sizes are
+ * known. Instrumented builds also get __aria_profile_init, which main calls
+ * first to hand the counters and their keys to the runtime.
+ */
+static void gen_profile_data(void) {
+    if (pgo_mode == PGO_GENERATE) {
+        int count = pgo_counter_count();
+        x64_add_global_block(x64_out, PGO_COUNTERS_SYM, count > 0 ? count : 1);
+        gen_prologue("__aria_profile_init", 0);
+        emit(X64_LEA, R(X64_RDI), x64_rip_sym(PGO_COUNTERS_SYM));
+        emit(X64_LEA, R(X64_RSI), x64_rip_label(x64_add_string_copy(x64_out, pgo_descriptor())));
+        emit(X64_MOV, R(X64_RDX), x64_imm(count));
+        emit_call("aria_profile_register");
+        gen_frame_return();
+    }
+    if (pgo_cache_count() > 0) x64_add_global_block(x64_out, PGO_CACHES_SYM, pgo_cache_count());
+}
+
+void gen_program(AstNode* head) {
+    begin_codegen(head);
+    x64_add_export(x64_out, "main");
+
     AstNode* curr = head;
-    while(curr) { if (curr->type == NODE_VAR_DECL) fprintf(asm_out, "%s: dq 0\n", curr->data.var_decl.name); curr = curr->next; }
+    while(curr) { if (ast_type(curr) == NODE_VAR_DECL) x64_add_global(x64_out, curr->data.var_decl.name); curr = AST_NEXT(curr); }
 
-    fprintf(asm_out, "section .text\n");
-    fprintf(asm_out, "main:\n"); emit("push rbp"); emit("mov rbp, rsp"); emit("sub rsp, 32"); 
-    curr = head; while(curr) { if (curr->type == NODE_VAR_DECL) { emit("lea rdi, [rel %s]", curr->data.var_decl.name); emit("call aria_register_global_root"); } curr = curr->next; }
-    curr = head; while(curr) { if (curr->type == NODE_VAR_DECL && curr->data.var_decl.init_expr) { gen_expression(curr->data.var_decl.init_expr); emit("mov [rel %s], rax", curr->data.var_decl.name); } curr = curr->next; }
+    gen_prologue("main", 32);
+    if (pgo_mode == PGO_GENERATE) emit_call("__aria_profile_init");
+    gen_global_setup(head);
     
-    // Find and inline the main function
-    AstNode* main_func = head;
-    while(main_func) { 
-        if (main_func->type == NODE_FUNC_DECL && strcmp(main_func->data.func_decl.name, "main") == 0) {
-            gen_statement(main_func->data.func_decl.body); 
-            break;
-        } 
-        main_func = main_func->next; 
-    }
+    // The parser renames the user's main to aria_main; run it after globals are set up
+    if (is_local_function("aria_main")) emit_call("aria_main");
     
-    emit("mov rdi, 0"); emit("call exit");
+    emit(X64_MOV, R(X64_RDI), x64_imm(0)); emit_call("exit");
     
-    curr = head; while (curr) { if (curr->type == NODE_FUNC_DECL && strcmp(curr->data.func_decl.name, "main") != 0) gen_function_node(curr); else if (curr->type == NODE_CLASS_DECL) { AstNode* m = curr->data.class_decl.methods; while(m) { gen_function_node(m); m = m->next; } } curr = curr->next; }
+    gen_functions(head);
+    gen_profile_data();
+    free(global_intervals.intervals);
+}
+
+/*
+ * Separate compilation: one object per module. Every top-level function,
+ * method and global is exported, and the module's globals are set up by
+ * 'init_name'. The root module (init_order != NULL) also emits main, which
+ * runs each module's initializer in dependency order before aria_main.
+ */
+void gen_module(AstNode* head, const char* init_name, const char** init_order, int init_count) {
+    begin_codegen(head);
+
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_VAR_DECL) {
+            x64_add_global(x64_out, curr->data.var_decl.name);
+            x64_add_export(x64_out, curr->data.var_decl.name);
+        } else if (ast_type(curr) == NODE_FUNC_DECL) {
+            x64_add_export(x64_out, curr->data.func_decl.name);
+        } else if (ast_type(curr) == NODE_CLASS_DECL && !curr->data.class_decl.is_extern) {
+            for (AstNode* m = AST_KID(curr, class_decl.methods); m; m = AST_NEXT(m)) x64_add_export(x64_out, m->data.func_decl.name);
+        }
+    }
+
+    x64_add_export(x64_out, init_name);
+    gen_prologue(init_name, 16);
+    gen_global_setup(head);
+    gen_frame_return();
+
+    if (init_order) {
+        x64_add_export(x64_out, "main");
+        gen_prologue("main", 32);
+        for (int i = 0; i < init_count; i++) emit_call(init_order[i]);
+        if (is_local_function("aria_main")) emit_call("aria_main");
+        emit(X64_MOV, R(X64_RDI), x64_imm(0)); emit_call("exit");
+    }
+
+    gen_functions(head);
     free(global_intervals.intervals);
 }
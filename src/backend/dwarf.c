@@ -0,0 +1,365 @@
+/* Aria_lang/src/backend/dwarf.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "x64.h"
+
+/*
+ * DWARF Debug and Unwind Info
+ * ---------------------------
+ * Built from the line and frame records the encoder collected:
+ *   .debug_abbrev / .debug_info  one compile unit for the source file and a
+ *                                subprogram per function
+ *   .debug_line                  version 4 line program for .text
+ *   .eh_frame                    one CIE and an FDE per function
+ * Every function uses the same rbp frame, so its FDE only describes the
+ * prologue and each leave/ret pair. That is enough for perf, gdb and
+ * libunwind to attribute samples to Aria lines and walk through Aria frames.
+ */
+
+#define R_X86_64_64   1
+#define R_X86_64_PC32 2
+#define R_X86_64_32   10
+
+// Tags, attributes and forms (DWARF 4, section 7)
+#define DW_TAG_compile_unit 0x11
+#define DW_TAG_subprogram   0x2e
+#define DW_AT_name          0x03
+#define DW_AT_stmt_list     0x10
+#define DW_AT_low_pc        0x11
+#define DW_AT_high_pc       0x12
+#define DW_AT_language      0x13
+#define DW_AT_comp_dir      0x1b
+#define DW_AT_producer      0x25
+#define DW_AT_decl_file     0x3a
+#define DW_AT_decl_line     0x3b
+#define DW_AT_external      0x3f
+#define DW_AT_frame_base    0x40
+#define DW_FORM_addr        0x01
+#define DW_FORM_data2       0x05
+#define DW_FORM_data8       0x07
+#define DW_FORM_string      0x08
+#define DW_FORM_data1       0x0b
+#define DW_FORM_udata       0x0f
+#define DW_FORM_sec_offset  0x17
+#define DW_FORM_exprloc     0x18
+#define DW_FORM_flag_present 0x19
+#define DW_OP_call_frame_cfa 0x9c
+// Debuggers have no Aria mode; C gives them plain names and line stepping
+#define DW_LANG_C99         0x0c
+
+// Line program opcodes
+#define DW_LNS_copy         0x01
+#define DW_LNS_advance_pc   0x02
+#define DW_LNS_advance_line 0x03
+#define DW_LNE_end_sequence 0x01
+#define DW_LNE_set_address  0x02
+#define LINE_BASE   (-5)
+#define LINE_RANGE  14
+#define OPCODE_BASE 13
+
+// Call frame instructions
+#define DW_CFA_advance_loc        0x40
+#define DW_CFA_offset             0x80
+#define DW_CFA_restore            0xc0
+#define DW_CFA_nop                0x00
+#define DW_CFA_advance_loc1       0x02
+#define DW_CFA_advance_loc2       0x03
+#define DW_CFA_advance_loc4       0x04
+#define DW_CFA_remember_state     0x0a
+#define DW_CFA_restore_state      0x0b
+#define DW_CFA_def_cfa            0x0c
+#define DW_CFA_def_cfa_register   0x0d
+#define DW_CFA_def_cfa_offset     0x0e
+#define DW_EH_PE_pcrel_sdata4     0x1b
+
+// DWARF register numbers
+#define DWARF_RBP 6
+#define DWARF_RSP 7
+#define DWARF_RA  16
+
+static X64DebugSection* sec;
+
+// --- Section Buffers ---
+
+static void put(const void* data, size_t n) {
+    if (sec->len + n > sec->cap) {
+        size_t cap = sec->cap ? sec->cap : 256;
+        while (cap < sec->len + n) cap *= 2;
+        sec->data = realloc(sec->data, cap);
+        if (!sec->data) { fprintf(stderr, "Fatal: Out of memory in DWARF writer.\n"); exit(1); }
+        sec->cap = cap;
+    }
+    memcpy(sec->data + sec->len, data, n);
+    sec->len += n;
+}
+
+static void put8(uint8_t v) { put(&v, 1); }
+static void put_str(const char* s) { put(s, strlen(s) + 1); }
+
+static void put_le(uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) put8((uint8_t)(v >> (i * 8)));
+}
+
+static void put_uleb(uint64_t v) {
+    do {
+        uint8_t b = v & 0x7f;
+        v >>= 7;
+        put8(v ? (b | 0x80) : b);
+    } while (v);
+}
+
+static void put_sleb(int64_t v) {
+    for (;;) {
+        uint8_t b = v & 0x7f;
+        v >>= 7;   // arithmetic shift on every supported compiler
+        int done = (v == 0 && !(b & 0x40)) || (v == -1 && (b & 0x40));
+        put8(done ? b : (b | 0x80));
+        if (done) return;
+    }
+}
+
+static void patch32(size_t at, uint32_t v) {
+    for (int i = 0; i < 4; i++) sec->data[at + i] = (uint8_t)(v >> (i * 8));
+}
+
+// A 'bytes'-wide field at the current position holding the address of 'target' + offset
+static void put_reloc(uint32_t type, int bytes, int target, int64_t offset) {
+    if (sec->reloc_count >= sec->reloc_cap) {
+        sec->reloc_cap = sec->reloc_cap ? sec->reloc_cap * 2 : 64;
+        sec->relocs = realloc(sec->relocs, sizeof(X64Reloc) * sec->reloc_cap);
+        if (!sec->relocs) { fprintf(stderr, "Fatal: Out of memory in DWARF writer.\n"); exit(1); }
+    }
+    X64Reloc* r = &sec->relocs[sec->reloc_count++];
+    r->offset = sec->len;
+    r->type = type;
+    r->addend = 0;
+    r->sym = NULL;
+    r->section = target;
+    r->section_offset = offset;
+    put_le(0, bytes);
+}
+
+static X64DebugSection* section(X64Object* obj, int id) {
+    return &obj->debug[id - X64_SEC_FIRST_DEBUG];
+}
+
+// --- Functions ---
+
+static int is_text_func(X64Symbol* s) {
+    return s->is_func && s->section == X64_SEC_TEXT;
+}
+
+// Line of the first row inside [start, end), 0 if the function has none
+static int first_line(X64Object* obj, uint64_t start, uint64_t end) {
+    for (int i = 0; i < obj->line_count; i++) {
+        if (obj->lines[i].text_offset >= end) break;
+        if (obj->lines[i].text_offset >= start) return obj->lines[i].line;
+    }
+    return 0;
+}
+
+// --- .debug_abbrev / .debug_info ---
+
+enum { ABBREV_CU = 1, ABBREV_SUBPROGRAM };
+
+static void build_abbrev(void) {
+    put_uleb(ABBREV_CU); put_uleb(DW_TAG_compile_unit); put8(1);
+    put_uleb(DW_AT_producer); put_uleb(DW_FORM_string);
+    put_uleb(DW_AT_language); put_uleb(DW_FORM_data2);
+    put_uleb(DW_AT_name); put_uleb(DW_FORM_string);
+    put_uleb(DW_AT_comp_dir); put_uleb(DW_FORM_string);
+    put_uleb(DW_AT_stmt_list); put_uleb(DW_FORM_sec_offset);
+    put_uleb(DW_AT_low_pc); put_uleb(DW_FORM_addr);
+    put_uleb(DW_AT_high_pc); put_uleb(DW_FORM_data8);
+    put8(0); put8(0);
+
+    put_uleb(ABBREV_SUBPROGRAM); put_uleb(DW_TAG_subprogram); put8(0);
+    put_uleb(DW_AT_name); put_uleb(DW_FORM_string);
+    put_uleb(DW_AT_decl_file); put_uleb(DW_FORM_data1);
+    put_uleb(DW_AT_decl_line); put_uleb(DW_FORM_udata);
+    put_uleb(DW_AT_external); put_uleb(DW_FORM_flag_present);
+    put_uleb(DW_AT_low_pc); put_uleb(DW_FORM_addr);
+    put_uleb(DW_AT_high_pc); put_uleb(DW_FORM_data8);
+    put_uleb(DW_AT_frame_base); put_uleb(DW_FORM_exprloc);
+    put8(0); put8(0);
+
+    put8(0);
+}
+
+static void build_info(X64Object* obj, const char* source_file) {
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) strcpy(cwd, ".");
+
+    size_t start = sec->len;
+    put_le(0, 4);                                  // unit_length, patched below
+    put_le(4, 2);                                  // version
+    put_reloc(R_X86_64_32, 4, X64_SEC_DEBUG_ABBREV, 0);
+    put8(8);                                       // address size
+
+    put_uleb(ABBREV_CU);
+    put_str("Aria compiler");
+    put_le(DW_LANG_C99, 2);
+    put_str(source_file);
+    put_str(cwd);
+    put_reloc(R_X86_64_32, 4, X64_SEC_DEBUG_LINE, 0);
+    put_reloc(R_X86_64_64, 8, X64_SEC_TEXT, 0);
+    put_le(obj->text_len, 8);
+
+    for (int i = 0; i < obj->symbol_count; i++) {
+        X64Symbol* s = &obj->symbols[i];
+        if (!is_text_func(s)) continue;
+        put_uleb(ABBREV_SUBPROGRAM);
+        put_str(s->name);
+        put8(1);
+        put_uleb((uint64_t)first_line(obj, s->value, s->value + s->size));
+        put_reloc(R_X86_64_64, 8, X64_SEC_TEXT, (int64_t)s->value);
+        put_le(s->size, 8);
+        put_uleb(1); put8(DW_OP_call_frame_cfa);
+    }
+    put8(0);
+    patch32(start, (uint32_t)(sec->len - start - 4));
+}
+
+// --- .debug_line ---
+
+static void build_line(X64Object* obj, const char* source_file) {
+    size_t start = sec->len;
+    put_le(0, 4);                                  // unit_length
+    put_le(4, 2);                                  // version
+    size_t header_length_at = sec->len;
+    put_le(0, 4);                                  // header_length
+    size_t header_start = sec->len;
+    put8(1);                                       // minimum_instruction_length
+    put8(1);                                       // maximum_operations_per_instruction
+    put8(1);                                       // default_is_stmt
+    put8((uint8_t)LINE_BASE);
+    put8(LINE_RANGE);
+    put8(OPCODE_BASE);
+    static const uint8_t standard_lengths[OPCODE_BASE - 1] = { 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1 };
+    put(standard_lengths, sizeof(standard_lengths));
+    put8(0);                                       // no include directories
+    put_str(source_file);                          // file 1, relative to comp_dir
+    put_uleb(0); put_uleb(0); put_uleb(0);
+    put8(0);
+    patch32(header_length_at, (uint32_t)(sec->len - header_start));
+
+    put8(0); put_uleb(9); put8(DW_LNE_set_address);
+    put_reloc(R_X86_64_64, 8, X64_SEC_TEXT, 0);
+
+    uint64_t address = 0;
+    int64_t line = 1;
+    for (int i = 0; i < obj->line_count; i++) {
+        uint64_t address_delta = obj->lines[i].text_offset - address;
+        int64_t line_delta = obj->lines[i].line - line;
+        // A special opcode advances both and appends a row in one byte
+        if (line_delta >= LINE_BASE && line_delta < LINE_BASE + LINE_RANGE) {
+            uint64_t opcode = (uint64_t)(line_delta - LINE_BASE) + LINE_RANGE * address_delta + OPCODE_BASE;
+            if (opcode <= 255) {
+                put8((uint8_t)opcode);
+                address = obj->lines[i].text_offset;
+                line = obj->lines[i].line;
+                continue;
+            }
+        }
+        if (address_delta) { put8(DW_LNS_advance_pc); put_uleb(address_delta); }
+        if (line_delta) { put8(DW_LNS_advance_line); put_sleb(line_delta); }
+        put8(DW_LNS_copy);
+        address = obj->lines[i].text_offset;
+        line = obj->lines[i].line;
+    }
+    if (obj->text_len > address) { put8(DW_LNS_advance_pc); put_uleb(obj->text_len - address); }
+    put8(0); put_uleb(1); put8(DW_LNE_end_sequence);
+    patch32(start, (uint32_t)(sec->len - start - 4));
+}
+
+// --- .eh_frame ---
+
+static void pad_cfa(size_t start) {
+    while ((sec->len - start) % 8) put8(DW_CFA_nop);
+}
+
+static void advance_loc(uint64_t delta) {
+    if (delta == 0) return;
+    if (delta < 0x40) put8((uint8_t)(DW_CFA_advance_loc | delta));
+    else if (delta <= 0xff) { put8(DW_CFA_advance_loc1); put_le(delta, 1); }
+    else if (delta <= 0xffff) { put8(DW_CFA_advance_loc2); put_le(delta, 2); }
+    else { put8(DW_CFA_advance_loc4); put_le(delta, 4); }
+}
+
+static void build_eh_frame(X64Object* obj) {
+    // CIE: on entry the CFA is rsp + 8 and the return address sits just below it
+    size_t cie = sec->len;
+    put_le(0, 4);
+    put_le(0, 4);                                  // CIE id
+    put8(1);                                       // version
+    put_str("zR");
+    put_uleb(1);                                   // code alignment
+    put_sleb(-8);                                  // data alignment
+    put8(DWARF_RA);
+    put_uleb(1);                                   // augmentation data length
+    put8(DW_EH_PE_pcrel_sdata4);
+    put8(DW_CFA_def_cfa); put_uleb(DWARF_RSP); put_uleb(8);
+    put8(DW_CFA_offset | DWARF_RA); put_uleb(1);
+    pad_cfa(cie + 4);
+    patch32(cie, (uint32_t)(sec->len - cie - 4));
+
+    int row = 0;
+    for (int i = 0; i < obj->symbol_count; i++) {
+        X64Symbol* s = &obj->symbols[i];
+        if (!is_text_func(s) || s->size == 0) continue;
+        uint64_t end = s->value + s->size;
+
+        size_t fde = sec->len;
+        put_le(0, 4);
+        put_le((uint32_t)(sec->len - cie), 4);     // distance back to the CIE
+        put_reloc(R_X86_64_PC32, 4, X64_SEC_TEXT, (int64_t)s->value);
+        put_le(s->size, 4);
+        put_uleb(0);                               // augmentation data length
+
+        uint64_t loc = s->value;
+        // Rows are recorded after their instruction, so one at a function's
+        // first byte closes the previous function and one at its end covers nothing
+        while (row < obj->cfi_count && obj->cfis[row].text_offset <= s->value) row++;
+        for (; row < obj->cfi_count && obj->cfis[row].text_offset < end; row++) {
+            advance_loc(obj->cfis[row].text_offset - loc);
+            loc = obj->cfis[row].text_offset;
+            switch (obj->cfis[row].cfi) {
+                case X64_CFI_PUSH_RBP:
+                    put8(DW_CFA_def_cfa_offset); put_uleb(16);
+                    put8(DW_CFA_offset | DWARF_RBP); put_uleb(2);
+                    break;
+                case X64_CFI_SET_RBP:
+                    put8(DW_CFA_def_cfa_register); put_uleb(DWARF_RBP);
+                    break;
+                case X64_CFI_LEAVE:
+                    put8(DW_CFA_remember_state);
+                    put8(DW_CFA_def_cfa); put_uleb(DWARF_RSP); put_uleb(8);
+                    put8(DW_CFA_restore | DWARF_RBP);
+                    break;
+                case X64_CFI_RET:
+                    put8(DW_CFA_restore_state);
+                    break;
+            }
+        }
+        pad_cfa(fde + 4);
+        patch32(fde, (uint32_t)(sec->len - fde - 4));
+    }
+}
+
+// --- Public API ---
+
+void dwarf_build(X64Object* obj, const char* source_file) {
+    sec = section(obj, X64_SEC_EH_FRAME);
+    build_eh_frame(obj);
+    if (source_file) {
+        sec = section(obj, X64_SEC_DEBUG_ABBREV);
+        build_abbrev();
+        sec = section(obj, X64_SEC_DEBUG_INFO);
+        build_info(obj, source_file);
+        sec = section(obj, X64_SEC_DEBUG_LINE);
+        build_line(obj, source_file);
+    }
+    sec = NULL;
+}
@@ -0,0 +1,315 @@
+/* Aria_lang/src/backend/elf_writer.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+#include "x64.h"
+
+/*
+ * ELF64 Relocatable Object Writer
+ * -------------------------------
+ * Section layout is fixed:
+ *   [0] null  [1] .text  [2] .rodata  [3] .data  [4] .debug_info
+ *   [5] .debug_abbrev  [6] .debug_line  [7] .eh_frame  [8] .symtab
+ *   [9] .strtab  [10] .rela.text  [11-14] .rela for [4-7]  [15] .shstrtab
+ *   [16] .note.GNU-stack
+ * Symbols referenced by relocations but not defined in the object are added
+ * as undefined globals for the linker to resolve against the runtime.
+ */
+
+enum {
+    SEC_NULL, SEC_TEXT, SEC_RODATA, SEC_DATA,
+    SEC_DEBUG_INFO, SEC_DEBUG_ABBREV, SEC_DEBUG_LINE, SEC_EH_FRAME, SEC_SYMTAB,
+    SEC_STRTAB, SEC_RELA_TEXT, SEC_RELA_DEBUG, SEC_SHSTRTAB = SEC_RELA_DEBUG + X64_DEBUG_SEC_COUNT,
+    SEC_NOTE_STACK, SEC_TOTAL
+};
+
+static const char* const DEBUG_NAMES[X64_DEBUG_SEC_COUNT] = { ".debug_info", ".debug_abbrev", ".debug_line", ".eh_frame" };
+static const char* const DEBUG_RELA_NAMES[X64_DEBUG_SEC_COUNT] = {
+    ".rela.debug_info", ".rela.debug_abbrev", ".rela.debug_line", ".rela.eh_frame"
+};
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} StrBuf;
+
+static size_t strbuf_add(StrBuf* b, const char* s) {
+    size_t n = strlen(s) + 1;
+    if (b->len + n > b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 4096;
+        while (b->cap < b->len + n) b->cap *= 2;
+        b->data = realloc(b->data, b->cap);
+        if (!b->data) { fprintf(stderr, "Fatal: Out of memory in ELF writer.\n"); exit(1); }
+    }
+    size_t off = b->len;
+    memcpy(b->data + off, s, n);
+    b->len += n;
+    return off;
+}
+
+// --- Symbol Lookup (FNV-1a, open addressing) ---
+
+typedef struct {
+    const char* name;
+    uint32_t index;   // .symtab index
+} SymSlot;
+
+static SymSlot* sym_slots;
+static size_t sym_slot_mask;
+
+static uint32_t hash_name(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+    return h;
+}
+
+static SymSlot* sym_lookup(const char* name) {
+    size_t i = hash_name(name) & sym_slot_mask;
+    while (sym_slots[i].name && strcmp(sym_slots[i].name, name) != 0) i = (i + 1) & sym_slot_mask;
+    return &sym_slots[i];
+}
+
+static const uint16_t SECTION_INDEX[X64_SEC_COUNT] = {
+    SEC_TEXT, SEC_RODATA, SEC_DATA, SEC_DEBUG_INFO, SEC_DEBUG_ABBREV, SEC_DEBUG_LINE, SEC_EH_FRAME
+};
+
+static void write_at(FILE* f, const void* data, size_t len, size_t* pos) {
+    fwrite(data, 1, len, f);
+    *pos += len;
+}
+
+static void pad_to(FILE* f, size_t align, size_t* pos) {
+    static const uint8_t zeros[16] = {0};
+    size_t rem = *pos % align;
+    if (rem) write_at(f, zeros, align - rem, pos);
+}
+
+// Section-relative targets use the section's own STT_SECTION symbol
+static Elf64_Rela* convert_relocs(X64Reloc* relocs, int count) {
+    Elf64_Rela* rela = malloc(sizeof(Elf64_Rela) * (count + 1));
+    if (!rela) { fprintf(stderr, "Fatal: Out of memory in ELF writer.\n"); exit(1); }
+    for (int i = 0; i < count; i++) {
+        X64Reloc* r = &relocs[i];
+        uint32_t sym_index;
+        int64_t addend = r->addend;
+        if (r->sym) {
+            sym_index = sym_lookup(r->sym)->index;
+        } else {
+            sym_index = 1 + (uint32_t)r->section;
+            addend += r->section_offset;
+        }
+        rela[i].r_offset = r->offset;
+        rela[i].r_info = ELF64_R_INFO((uint64_t)sym_index, r->type);
+        rela[i].r_addend = addend;
+    }
+    return rela;
+}
+
+static void write_rela(FILE* f, Elf64_Shdr* sh, int target, Elf64_Rela* rela, int count, size_t* pos) {
+    pad_to(f, 8, pos);
+    sh->sh_type = SHT_RELA;
+    sh->sh_flags = SHF_INFO_LINK;
+    sh->sh_offset = *pos;
+    sh->sh_size = sizeof(Elf64_Rela) * count;
+    sh->sh_link = SEC_SYMTAB;
+    sh->sh_info = target;
+    sh->sh_addralign = 8;
+    sh->sh_entsize = sizeof(Elf64_Rela);
+    write_at(f, rela, sizeof(Elf64_Rela) * count, pos);
+}
+
+int elf_write_object(X64Object* obj, const char* path) {
+    // Undefined symbols: everything relocations name that the object lacks
+    size_t slots = 64;
+    while (slots < (size_t)(obj->symbol_count + obj->reloc_count) * 2) slots *= 2;
+    sym_slots = calloc(slots, sizeof(SymSlot));
+    sym_slot_mask = slots - 1;
+    if (!sym_slots) { fprintf(stderr, "Fatal: Out of memory in ELF writer.\n"); exit(1); }
+
+    int total = obj->symbol_count;
+    X64Symbol* syms = malloc(sizeof(X64Symbol) * (obj->symbol_count + obj->reloc_count + 1));
+    if (!syms) { fprintf(stderr, "Fatal: Out of memory in ELF writer.\n"); exit(1); }
+    memcpy(syms, obj->symbols, sizeof(X64Symbol) * obj->symbol_count);
+    for (int i = 0; i < obj->symbol_count; i++) sym_lookup(syms[i].name)->name = syms[i].name;
+    for (int i = 0; i < obj->reloc_count; i++) {
+        const char* name = obj->relocs[i].sym;
+        if (!name) continue;
+        SymSlot* slot = sym_lookup(name);
+        if (slot->name) continue;
+        slot->name = name;
+        X64Symbol* s = &syms[total++];
+        memset(s, 0, sizeof(X64Symbol));
+        s->name = name;
+        s->section = -1;
+        s->is_global = 1;
+    }
+
+    // ELF requires all locals before the first global
+    StrBuf strtab = {0};
+    strbuf_add(&strtab, "");
+    Elf64_Sym* symtab = calloc(total + 1 + X64_SEC_COUNT, sizeof(Elf64_Sym));
+    if (!symtab) { fprintf(stderr, "Fatal: Out of memory in ELF writer.\n"); exit(1); }
+    uint32_t nsym = 1;
+    for (int s = 0; s < X64_SEC_COUNT; s++) {
+        symtab[nsym].st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+        symtab[nsym].st_shndx = SECTION_INDEX[s];
+        nsym++;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < total; i++) {
+            X64Symbol* s = &syms[i];
+            if (s->is_global != pass) continue;
+            Elf64_Sym* e = &symtab[nsym];
+            e->st_name = (uint32_t)strbuf_add(&strtab, s->name);
+            e->st_info = ELF64_ST_INFO(pass ? STB_GLOBAL : STB_LOCAL,
+                                       s->section < 0 ? STT_NOTYPE : (s->is_func ? STT_FUNC : STT_OBJECT));
+            e->st_shndx = s->section < 0 ? SHN_UNDEF : SECTION_INDEX[s->section];
+            e->st_value = s->value;
+            e->st_size = s->size;
+            sym_lookup(s->name)->index = nsym;
+            nsym++;
+        }
+    }
+    uint32_t first_global = 1 + X64_SEC_COUNT;
+    for (int i = 0; i < total; i++) if (!syms[i].is_global) first_global++;
+
+    Elf64_Rela* rela = convert_relocs(obj->relocs, obj->reloc_count);
+
+    StrBuf shstrtab = {0};
+    strbuf_add(&shstrtab, "");
+    Elf64_Shdr sh[SEC_TOTAL];
+    memset(sh, 0, sizeof(sh));
+    sh[SEC_TEXT].sh_name = (uint32_t)strbuf_add(&shstrtab, ".text");
+    sh[SEC_RODATA].sh_name = (uint32_t)strbuf_add(&shstrtab, ".rodata");
+    sh[SEC_DATA].sh_name = (uint32_t)strbuf_add(&shstrtab, ".data");
+    for (int d = 0; d < X64_DEBUG_SEC_COUNT; d++) {
+        sh[SEC_DEBUG_INFO + d].sh_name = (uint32_t)strbuf_add(&shstrtab, DEBUG_NAMES[d]);
+        sh[SEC_RELA_DEBUG + d].sh_name = (uint32_t)strbuf_add(&shstrtab, DEBUG_RELA_NAMES[d]);
+    }
+    sh[SEC_SYMTAB].sh_name = (uint32_t)strbuf_add(&shstrtab, ".symtab");
+    sh[SEC_STRTAB].sh_name = (uint32_t)strbuf_add(&shstrtab, ".strtab");
+    sh[SEC_RELA_TEXT].sh_name = (uint32_t)strbuf_add(&shstrtab, ".rela.text");
+    sh[SEC_SHSTRTAB].sh_name = (uint32_t)strbuf_add(&shstrtab, ".shstrtab");
+    sh[SEC_NOTE_STACK].sh_name = (uint32_t)strbuf_add(&shstrtab, ".note.GNU-stack");
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror("Failed to open object file");
+        free(sym_slots); free(syms); free(symtab); free(rela); free(strtab.data); free(shstrtab.data);
+        return 0;
+    }
+
+    size_t pos = 0;
+    Elf64_Ehdr eh;
+    memset(&eh, 0, sizeof(eh));
+    write_at(f, &eh, sizeof(eh), &pos);   // rewritten once offsets are known
+
+    pad_to(f, 16, &pos);
+    sh[SEC_TEXT].sh_type = SHT_PROGBITS;
+    sh[SEC_TEXT].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+    sh[SEC_TEXT].sh_offset = pos;
+    sh[SEC_TEXT].sh_size = obj->text_len;
+    sh[SEC_TEXT].sh_addralign = 16;
+    write_at(f, obj->text, obj->text_len, &pos);
+
+    pad_to(f, 8, &pos);
+    sh[SEC_RODATA].sh_type = SHT_PROGBITS;
+    sh[SEC_RODATA].sh_flags = SHF_ALLOC;
+    sh[SEC_RODATA].sh_offset = pos;
+    sh[SEC_RODATA].sh_size = obj->rodata_len;
+    sh[SEC_RODATA].sh_addralign = 8;   // string headers (literal.h)
+    write_at(f, obj->rodata, obj->rodata_len, &pos);
+
+    pad_to(f, 8, &pos);
+    sh[SEC_DATA].sh_type = SHT_PROGBITS;
+    sh[SEC_DATA].sh_flags = SHF_ALLOC | SHF_WRITE;
+    sh[SEC_DATA].sh_offset = pos;
+    sh[SEC_DATA].sh_size = obj->data_len;
+    sh[SEC_DATA].sh_addralign = 8;
+    for (size_t i = 0; i < obj->data_len; i += 8) {
+        uint64_t zero = 0;
+        write_at(f, &zero, 8, &pos);
+    }
+
+    // .eh_frame is loaded for the unwinder; the .debug sections are not
+    for (int d = 0; d < X64_DEBUG_SEC_COUNT; d++) {
+        Elf64_Shdr* h = &sh[SEC_DEBUG_INFO + d];
+        X64DebugSection* ds = &obj->debug[d];
+        if (SEC_DEBUG_INFO + d == SEC_EH_FRAME) pad_to(f, 8, &pos);
+        h->sh_type = SHT_PROGBITS;
+        h->sh_flags = SEC_DEBUG_INFO + d == SEC_EH_FRAME ? SHF_ALLOC : 0;
+        h->sh_offset = pos;
+        h->sh_size = ds->len;
+        h->sh_addralign = SEC_DEBUG_INFO + d == SEC_EH_FRAME ? 8 : 1;
+        write_at(f, ds->data, ds->len, &pos);
+    }
+
+    pad_to(f, 8, &pos);
+    sh[SEC_SYMTAB].sh_type = SHT_SYMTAB;
+    sh[SEC_SYMTAB].sh_offset = pos;
+    sh[SEC_SYMTAB].sh_size = sizeof(Elf64_Sym) * nsym;
+    sh[SEC_SYMTAB].sh_link = SEC_STRTAB;
+    sh[SEC_SYMTAB].sh_info = first_global;
+    sh[SEC_SYMTAB].sh_addralign = 8;
+    sh[SEC_SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+    write_at(f, symtab, sizeof(Elf64_Sym) * nsym, &pos);
+
+    sh[SEC_STRTAB].sh_type = SHT_STRTAB;
+    sh[SEC_STRTAB].sh_offset = pos;
+    sh[SEC_STRTAB].sh_size = strtab.len;
+    sh[SEC_STRTAB].sh_addralign = 1;
+    write_at(f, strtab.data, strtab.len, &pos);
+
+    write_rela(f, &sh[SEC_RELA_TEXT], SEC_TEXT, rela, obj->reloc_count, &pos);
+    for (int d = 0; d < X64_DEBUG_SEC_COUNT; d++) {
+        X64DebugSection* ds = &obj->debug[d];
+        Elf64_Rela* debug_rela = convert_relocs(ds->relocs, ds->reloc_count);
+        write_rela(f, &sh[SEC_RELA_DEBUG + d], SEC_DEBUG_INFO + d, debug_rela, ds->reloc_count, &pos);
+        free(debug_rela);
+    }
+
+    sh[SEC_SHSTRTAB].sh_type = SHT_STRTAB;
+    sh[SEC_SHSTRTAB].sh_offset = pos;
+    sh[SEC_SHSTRTAB].sh_size = shstrtab.len;
+    sh[SEC_SHSTRTAB].sh_addralign = 1;
+    write_at(f, shstrtab.data, shstrtab.len, &pos);
+
+    sh[SEC_NOTE_STACK].sh_type = SHT_PROGBITS;
+    sh[SEC_NOTE_STACK].sh_offset = pos;
+    sh[SEC_NOTE_STACK].sh_addralign = 1;
+
+    pad_to(f, 8, &pos);
+    size_t shoff = pos;
+    write_at(f, sh, sizeof(sh), &pos);
+
+    memcpy(eh.e_ident, ELFMAG, SELFMAG);
+    eh.e_ident[EI_CLASS] = ELFCLASS64;
+    eh.e_ident[EI_DATA] = ELFDATA2LSB;
+    eh.e_ident[EI_VERSION] = EV_CURRENT;
+    eh.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    eh.e_type = ET_REL;
+    eh.e_machine = EM_X86_64;
+    eh.e_version = EV_CURRENT;
+    eh.e_shoff = shoff;
+    eh.e_ehsize = sizeof(Elf64_Ehdr);
+    eh.e_shentsize = sizeof(Elf64_Shdr);
+    eh.e_shnum = SEC_TOTAL;
+    eh.e_shstrndx = SEC_SHSTRTAB;
+    fseek(f, 0, SEEK_SET);
+    fwrite(&eh, 1, sizeof(eh), f);
+
+    int ok = !ferror(f);
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "Error: Failed writing object file '%s'.\n", path);
+
+    free(sym_slots);
+    sym_slots = NULL;
+    free(syms);
+    free(symtab);
+    free(rela);
+    free(strtab.data);
+    free(shstrtab.data);
+    return ok;
+}
@@ -0,0 +1,336 @@
+/* Aria_lang/src/backend/escape.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "escape.h"
+
+#define MAX_CANDIDATES 64
+#define MAX_SUMMARIES 256
+#define MAX_CALL_DEPTH 8
+
+// Bigger literals and frames fall back to the heap: deep recursion must not blow the stack
+#define MAX_FRAME_ITEMS 32
+#define FRAME_BUDGET 1024
+
+int escape_enabled = 1;
+
+typedef struct {
+    AstNode* decl;      // the variable holding the allocation (or a parameter, for summaries)
+    AstNode* site;
+    int escapes;
+} Candidate;
+
+typedef struct {
+    Candidate items[MAX_CANDIDATES];
+    int count;
+    int depth;
+    Candidate* defining;  // candidate whose initializer is being walked
+} Scan;
+
+// Per (function, parameter) answers, shared by every function of the program
+enum { SUMMARY_PENDING, SUMMARY_KEPT, SUMMARY_ESCAPES };
+typedef struct {
+    AstNode* fn;
+    int index;
+    int state;
+} ParamSummary;
+
+static AstNode* program_root = NULL;
+static ParamSummary summaries[MAX_SUMMARIES];
+static int summary_count = 0;
+static FrameAlloc frame_allocs[MAX_CANDIDATES];
+static int frame_alloc_count = 0;
+
+// Runtime helpers that never keep the arguments in 'kept' (bit i = argument i)
+typedef struct {
+    const char* name;
+    unsigned kept;
+} RuntimeBorrow;
+
+static const RuntimeBorrow RUNTIME_BORROWS[] = {
+    { "dyn_print", 1 },
+    { "list_get", 3 }, { "list_set", 3 }, { "list_push", 1 },
+    { "aria_obj_get", 1 }, { "aria_obj_set", 1 },
+    { NULL, 0 }
+};
+
+static void walk(Scan* scan, AstNode* node, int escapes);
+
+// --- Lookups ---
+
+static AstNode* find_function(const char* name) {
+    for (AstNode* n = program_root; n; n = AST_NEXT(n)) {
+        if (ast_type(n) == NODE_FUNC_DECL && strcmp(n->data.func_decl.name, name) == 0) return n;
+    }
+    return NULL;
+}
+
+// The method 'name' of a class defined in this program (extern classes have no body here)
+static AstNode* find_method(const char* class_name, const char* name) {
+    for (AstNode* n = program_root; n; n = AST_NEXT(n)) {
+        if (ast_type(n) != NODE_CLASS_DECL || n->data.class_decl.is_extern) continue;
+        if (strcmp(n->data.class_decl.name, class_name) != 0) continue;
+        size_t prefix = strlen(class_name) + 1;
+        for (AstNode* m = AST_KID(n, class_decl.methods); m; m = AST_NEXT(m)) {
+            const char* mangled = m->data.func_decl.name;
+            if (strlen(mangled) > prefix && strcmp(mangled + prefix, name) == 0) return m;
+        }
+    }
+    return NULL;
+}
+
+static Candidate* candidate_of(Scan* scan, AstNode* expr) {
+    if (!expr || ast_type(expr) != NODE_VAR_ACCESS || expr->data.var_access.id <= 0) return NULL;
+    for (int i = 0; i < scan->count; i++) {
+        if (scan->items[i].decl == AST_KID(expr, var_access.decl)) return &scan->items[i];
+    }
+    return NULL;
+}
+
+static AstNode* candidate_method(Candidate* c, const char* name) {
+    if (!c || !c->site || ast_type(c->site) != NODE_NEW) return NULL;
+    return find_method(c->site->data.string_val, name);
+}
+
+// --- Parameter Summaries ---
+
+static int param_escapes(AstNode* fn, int index, int depth) {
+    AstNode* p = AST_KID(fn, func_decl.params);
+    for (int i = 0; p && i < index; i++) p = AST_NEXT(p);
+    if (!p) return 0;   // surplus arguments are never read
+    if (p->data.var_decl.is_captured) return 1;
+
+    // A pending entry means recursion: assume the worst
+    for (int i = 0; i < summary_count; i++) {
+        if (summaries[i].fn == fn && summaries[i].index == index) return summaries[i].state != SUMMARY_KEPT;
+    }
+    if (depth >= MAX_CALL_DEPTH || summary_count >= MAX_SUMMARIES) return 1;
+
+    int slot = summary_count++;
+    summaries[slot].fn = fn;
+    summaries[slot].index = index;
+    summaries[slot].state = SUMMARY_PENDING;
+
+    Scan* scan = malloc(sizeof(Scan));
+    scan->count = 1;
+    scan->depth = depth + 1;
+    scan->defining = NULL;
+    scan->items[0].decl = p;
+    scan->items[0].site = NULL;
+    scan->items[0].escapes = 0;
+    walk(scan, AST_KID(fn, func_decl.body), 0);
+    int escapes = scan->items[0].escapes;
+    free(scan);
+
+    summaries[slot].state = escapes ? SUMMARY_ESCAPES : SUMMARY_KEPT;
+    return escapes;
+}
+
+// --- Walk ---
+
+/*
+ * 'escapes' says whether the value of 'node' may be kept beyond the
+ * expression that consumes it. Runtime operators, conditions, indexing and
+ * field reads only inspect their operands; stores, returns, aliasing and
+ * unknown calls keep them.
+ */
+static void walk_call(Scan* scan, AstNode* node) {
+    AstNode* callee = AST_KID(node, call.callee);
+    AstNode* target = NULL;
+    const RuntimeBorrow* borrow = NULL;
+    int first = 0;
+
+    if (ast_type(callee) == NODE_GET) {
+        // Method call: the object is passed as the first argument
+        Candidate* c = candidate_of(scan, AST_KID(callee, get.obj));
+        target = candidate_method(c, callee->data.get.name);
+        walk(scan, AST_KID(callee, get.obj), !target || param_escapes(target, 0, scan->depth));
+        first = 1;
+    } else if (ast_type(callee) == NODE_VAR_ACCESS && callee->data.var_access.id == -1) {
+        target = find_function(callee->data.var_access.name);
+        if (!target) {
+            for (const RuntimeBorrow* b = RUNTIME_BORROWS; b->name; b++) {
+                if (strcmp(b->name, callee->data.var_access.name) == 0) borrow = b;
+            }
+        }
+    } else {
+        walk(scan, callee, 1);
+    }
+
+    int i = 0;
+    for (AstNode* arg = AST_KID(node, call.args); arg; arg = AST_NEXT(arg), i++) {
+        int escapes = 1;
+        if (target) escapes = param_escapes(target, first + i, scan->depth);
+        else if (borrow && i < 32) escapes = !(borrow->kept & (1u << i));
+        walk(scan, arg, escapes);
+    }
+}
+
+static void walk(Scan* scan, AstNode* node, int escapes) {
+    if (!node) return;
+    switch (ast_type(node)) {
+        case NODE_VAR_ACCESS: {
+            Candidate* c = candidate_of(scan, node);
+            // Reading the variable inside its own initializer sees the previous
+            // object, whose frame storage is being reinitialized
+            if (c && (escapes || c == scan->defining)) c->escapes = 1;
+            break;
+        }
+        case NODE_VAR_DECL: {
+            Candidate* outer = scan->defining;
+            for (int i = 0; i < scan->count; i++) {
+                if (scan->items[i].decl == node) scan->defining = &scan->items[i];
+            }
+            walk(scan, AST_KID(node, var_decl.init_expr), 1);
+            scan->defining = outer;
+            break;
+        }
+        case NODE_ASSIGN: walk(scan, AST_KID(node, assign.value), 1); break;
+        case NODE_RETURN: walk(scan, AST_KID(node, return_stmt.expr), 1); break;
+        case NODE_BLOCK:
+            for (AstNode* s = AST_KID(node, block.body); s; s = AST_NEXT(s)) walk(scan, s, 0);
+            break;
+        case NODE_IF:
+            walk(scan, AST_KID(node, if_stmt.condition), 0);
+            walk(scan, AST_KID(node, if_stmt.then_branch), 0);
+            walk(scan, AST_KID(node, if_stmt.else_branch), 0);
+            break;
+        case NODE_WHILE:
+            walk(scan, AST_KID(node, while_stmt.condition), 0);
+            walk(scan, AST_KID(node, while_stmt.body), 0);
+            break;
+        case NODE_FOR:
+            // Ranges only compare against the limit; for-each reads the list's items
+            walk(scan, AST_KID(node, for_stmt.iterable), 0);
+            walk(scan, AST_KID(node, for_stmt.body), 0);
+            break;
+        case NODE_MATCH:
+            // Dispatch only inspects the subject
+            walk(scan, AST_KID(node, match.subject), 0);
+            for (AstNode* arm = AST_KID(node, match.arms); arm; arm = AST_NEXT(arm)) walk(scan, AST_KID(arm, match_arm.body), 0);
+            walk(scan, AST_KID(node, match.otherwise), 0);
+            break;
+        case NODE_TERNARY:
+            walk(scan, AST_KID(node, ternary.condition), 0);
+            walk(scan, AST_KID(node, ternary.true_expr), escapes);
+            walk(scan, AST_KID(node, ternary.false_expr), escapes);
+            break;
+        case NODE_BINARY_OP:
+            // dyn_* operators always return a fresh or immediate value
+            walk(scan, AST_KID(node, binary.left), 0);
+            walk(scan, AST_KID(node, binary.right), 0);
+            break;
+        case NODE_INDEX_GET:
+            walk(scan, AST_KID(node, index_get.obj), 0);
+            walk(scan, AST_KID(node, index_get.index), 0);
+            break;
+        case NODE_INDEX_SET:
+            walk(scan, AST_KID(node, index_set.obj), 0);
+            walk(scan, AST_KID(node, index_set.index), 0);
+            walk(scan, AST_KID(node, index_set.value), 1);
+            break;
+        case NODE_GET: walk(scan, AST_KID(node, get.obj), 0); break;
+        case NODE_SET: {
+            // Overwriting a method would make later method calls unknown
+            Candidate* c = candidate_of(scan, AST_KID(node, set.obj));
+            if (c && candidate_method(c, node->data.set.name)) c->escapes = 1;
+            walk(scan, AST_KID(node, set.obj), 0);
+            walk(scan, AST_KID(node, set.value), 1);
+            break;
+        }
+        case NODE_ARRAY_LITERAL:
+            for (AstNode* e = AST_KID(node, array_literal.elements); e; e = AST_NEXT(e)) walk(scan, e, 1);
+            break;
+        case NODE_CALL: walk_call(scan, node); break;
+        // Nested functions see locals only through captures, which disqualify a candidate
+        case NODE_FUNC_DECL: break;
+        default: break;
+    }
+}
+
+// Collects 'var x = [...]' and 'var x = new C()' declarations of plain locals
+static void collect(Scan* scan, AstNode* node) {
+    if (!node) return;
+    switch (ast_type(node)) {
+        case NODE_VAR_DECL: {
+            AstNode* init = AST_KID(node, var_decl.init_expr);
+            if (!init || scan->count >= MAX_CANDIDATES) break;
+            if (node->data.var_decl.shadow_stack_offset <= 0) break;
+            if (node->data.var_decl.is_captured || node->data.var_decl.is_boxed) break;
+            if (ast_type(init) == NODE_NEW ||
+                (ast_type(init) == NODE_ARRAY_LITERAL && init->data.array_literal.count <= MAX_FRAME_ITEMS)) {
+                Candidate* c = &scan->items[scan->count++];
+                c->decl = node;
+                c->site = init;
+                c->escapes = 0;
+            }
+            break;
+        }
+        case NODE_BLOCK:
+            for (AstNode* s = AST_KID(node, block.body); s; s = AST_NEXT(s)) collect(scan, s);
+            break;
+        case NODE_IF:
+            collect(scan, AST_KID(node, if_stmt.then_branch));
+            collect(scan, AST_KID(node, if_stmt.else_branch));
+            break;
+        case NODE_WHILE: collect(scan, AST_KID(node, while_stmt.body)); break;
+        case NODE_FOR: collect(scan, AST_KID(node, for_stmt.body)); break;
+        case NODE_MATCH:
+            for (AstNode* arm = AST_KID(node, match.arms); arm; arm = AST_NEXT(arm)) collect(scan, AST_KID(arm, match_arm.body));
+            collect(scan, AST_KID(node, match.otherwise));
+            break;
+        default: break;
+    }
+}
+
+// --- Public API ---
+
+int escape_analyze(AstNode* func, AstNode* program) {
+    frame_alloc_count = 0;
+    program_root = program;
+    if (!func) summary_count = 0;
+    if (!func || !escape_enabled) return 0;
+
+    Scan* scan = malloc(sizeof(Scan));
+    scan->count = 0;
+    scan->depth = 0;
+    scan->defining = NULL;
+    collect(scan, AST_KID(func, func_decl.body));
+    if (scan->count > 0) walk(scan, AST_KID(func, func_decl.body), 0);
+
+    int used = 0;
+    for (int i = 0; i < scan->count; i++) {
+        Candidate* c = &scan->items[i];
+        if (c->escapes) continue;
+        FrameAlloc* fa = &frame_allocs[frame_alloc_count];
+        if (ast_type(c->site) == NODE_NEW) {
+            fa->capacity = 0;
+            fa->bytes = OBJECT_FRAME_BYTES;
+        } else {
+            // An even item count keeps every block 16-byte aligned
+            int cap = c->site->data.array_literal.count;
+            if (cap < 4) cap = 4;
+            cap += cap & 1;
+            fa->capacity = cap;
+            fa->bytes = LIST_FRAME_HEADER + 8 * cap;
+        }
+        if (used + fa->bytes > FRAME_BUDGET) continue;
+        used += fa->bytes;
+        fa->site = c->site;
+        fa->offset = 0;
+        frame_alloc_count++;
+    }
+    free(scan);
+    return frame_alloc_count;
+}
+
+FrameAlloc* escape_frame_alloc(int i) {
+    return (i >= 0 && i < frame_alloc_count) ? &frame_allocs[i] : NULL;
+}
+
+FrameAlloc* escape_find(AstNode* site) {
+    for (int i = 0; i < frame_alloc_count; i++) {
+        if (frame_allocs[i].site == site) return &frame_allocs[i];
+    }
+    return NULL;
+}
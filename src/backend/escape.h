@@ -0,0 +1,50 @@
+/* Aria_lang/src/backend/escape.h */
+#ifndef ARIA_ESCAPE_H
+#define ARIA_ESCAPE_H
+
+#include "../frontend/ast.h"
+
+/*
+ * Escape Analysis
+ * ---------------
+ * Finds `[]` literals and `new` expressions whose value provably dies with
+ * the function that creates them, so the backends can build them in the
+ * stack frame instead of calling aria_alloc. Only allocations bound directly
+ * to a local variable are candidates; the variable must then never be
+ * returned, stored anywhere, aliased, captured, or passed to code that
+ * might keep it. Calls into functions of the same program are followed one
+ * level per parameter (a method's first parameter receives the object), and
+ * a handful of runtime helpers are known not to retain their container.
+ *
+ * Frame memory is part of the stack, which the conservative GC already
+ * scans, so everything a frame list or object holds stays reachable. A list
+ * that outgrows its frame storage moves its items to the heap as usual.
+ */
+
+// Frame layout shared with the runtime (list_new_at / aria_alloc_object_at):
+// a list is an 80-byte header followed by its items; an object is a 16-byte
+// header followed by 8 hash entries of 24 bytes.
+#define LIST_FRAME_HEADER 80
+#define OBJECT_FRAME_BYTES 208
+
+typedef struct {
+    AstNode* site;      // NODE_ARRAY_LITERAL or NODE_NEW
+    int capacity;       // lists: item slots reserved after the header
+    int bytes;          // frame bytes, a multiple of 16
+    int offset;         // assigned by the backend
+} FrameAlloc;
+
+// Cleared by --no-stack-alloc; every allocation then goes to the heap
+extern int escape_enabled;
+
+// Analyzes one function; 'program' supplies callee bodies. Passing NULL for
+// func starts a new program. Returns the number of frame allocations.
+int escape_analyze(AstNode* func, AstNode* program);
+
+// The i-th frame allocation of the analyzed function
+FrameAlloc* escape_frame_alloc(int i);
+
+// The frame allocation for 'site', or NULL when it must go to the heap
+FrameAlloc* escape_find(AstNode* site);
+
+#endif
@@ -0,0 +1,138 @@
+/* Aria_lang/src/backend/format.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "format.h"
+
+#define FORMAT_MAX_ARGS 64
+// Expected width of one run-time placeholder when sizing the format buffer
+#define FORMAT_ARG_HINT 16
+
+static void* xmalloc(size_t n) {
+    void* p = malloc(n ? n : 1);
+    if (!p) { fprintf(stderr, "Fatal: Out of memory in format planning.\n"); exit(1); }
+    return p;
+}
+
+// Text waiting to become a FMT_TEXT segment
+typedef struct {
+    char* data;
+    int len;
+    int cap;
+} TextRun;
+
+static void run_append(TextRun* run, const char* s, int n) {
+    if (run->len + n + 1 > run->cap) {
+        run->cap = (run->len + n + 1) * 2;
+        run->data = realloc(run->data, run->cap);
+        if (!run->data) { fprintf(stderr, "Fatal: Out of memory in format planning.\n"); exit(1); }
+    }
+    memcpy(run->data + run->len, s, n);
+    run->len += n;
+    run->data[run->len] = '\0';
+}
+
+static void flush_run(FormatPlan* plan, TextRun* run) {
+    if (run->len == 0) return;
+    char* text = xmalloc(run->len + 1);
+    memcpy(text, run->data, run->len + 1);
+    plan->segments[plan->segment_count++] = (FormatSegment){ FMT_TEXT, text, run->len, -1 };
+    plan->size_hint += run->len;
+    run->len = 0;
+}
+
+// Formats a literal argument exactly as the runtime would; 0 if it must wait for run time
+static int fold_literal(char spec, AstNode* arg, TextRun* run) {
+    char temp[64];
+    int n;
+    if (spec == 's' && ast_type(arg) == NODE_STRING) {
+        run_append(run, arg->data.string_val, (int)strlen(arg->data.string_val));
+        return 1;
+    }
+    // Integers are boxed as 32-bit, so fold the truncated value dyn_new_int would hold
+    if (spec == 'd' && ast_type(arg) == NODE_LITERAL) {
+        n = snprintf(temp, sizeof(temp), "%d", (int)(int32_t)arg->data.int_val);
+    } else if (spec == 'f' && ast_type(arg) == NODE_LITERAL) {
+        n = snprintf(temp, sizeof(temp), "%.6f", (double)(int32_t)arg->data.int_val);
+    } else if (spec == 'f' && ast_type(arg) == NODE_FLOAT) {
+        n = snprintf(temp, sizeof(temp), "%.6f", arg->data.double_val);
+    } else {
+        return 0;
+    }
+    if (n < 0 || n >= (int)sizeof(temp)) return 0;
+    run_append(run, temp, n);
+    return 1;
+}
+
+// Number of placeholders in 'fmt', or -1 if it uses a conversion the runtime does not specialize
+static int count_placeholders(const char* fmt) {
+    int count = 0;
+    for (const char* p = fmt; *p; p++) {
+        if (*p != '%') continue;
+        p++;
+        if (*p == '%') continue;
+        if (*p != 'd' && *p != 'f' && *p != 's') return -1;
+        count++;
+    }
+    return count;
+}
+
+// --- Public API ---
+
+FormatPlan* format_plan(AstNode* call, AstNode* program) {
+    AstNode* callee = AST_KID(call, call.callee);
+    if (ast_type(callee) != NODE_VAR_ACCESS || callee->data.var_access.id != -1) return NULL;
+    const char* name = callee->data.var_access.name;
+    int is_print = strcmp(name, "print") == 0;
+    if (!is_print && strcmp(name, "format") != 0) return NULL;
+    for (AstNode* n = program; n; n = AST_NEXT(n)) {
+        if (ast_type(n) == NODE_FUNC_DECL && strcmp(n->data.func_decl.name, name) == 0) return NULL;
+    }
+
+    AstNode* fmt = AST_KID(call, call.args);
+    if (!fmt || ast_type(fmt) != NODE_STRING) return NULL;
+    AstNode* args[FORMAT_MAX_ARGS];
+    int argc = 0;
+    for (AstNode* a = AST_NEXT(fmt); a; a = AST_NEXT(a)) {
+        if (argc == FORMAT_MAX_ARGS) return NULL;
+        args[argc++] = a;
+    }
+    if (count_placeholders(fmt->data.string_val) != argc) return NULL;
+
+    FormatPlan* plan = xmalloc(sizeof(FormatPlan));
+    memset(plan, 0, sizeof(FormatPlan));
+    plan->is_print = is_print;
+    plan->segments = xmalloc(sizeof(FormatSegment) * (2 * argc + 1));
+    plan->args = xmalloc(sizeof(AstNode*) * argc);
+
+    TextRun run = { NULL, 0, 0 };
+    int next = 0;
+    for (const char* p = fmt->data.string_val; *p; p++) {
+        const char* start = p;
+        while (*p && *p != '%') p++;
+        run_append(&run, start, (int)(p - start));
+        if (!*p) break;
+        p++;
+        if (*p == '%') { run_append(&run, "%", 1); continue; }
+
+        AstNode* arg = args[next++];
+        if (fold_literal(*p, arg, &run)) continue;
+        flush_run(plan, &run);
+        FormatSegmentKind kind = *p == 'd' ? FMT_INT : *p == 'f' ? FMT_FLOAT : FMT_STR;
+        plan->segments[plan->segment_count++] = (FormatSegment){ kind, NULL, 0, plan->arg_count };
+        plan->args[plan->arg_count++] = arg;
+        plan->size_hint += FORMAT_ARG_HINT;
+    }
+    flush_run(plan, &run);
+    free(run.data);
+    return plan;
+}
+
+void format_plan_free(FormatPlan* plan) {
+    if (!plan) return;
+    for (int i = 0; i < plan->segment_count; i++) free((char*)plan->segments[i].text);
+    free(plan->segments);
+    free(plan->args);
+    free(plan);
+}
@@ -0,0 +1,42 @@
+/* Aria_lang/src/backend/format.h */
+#ifndef ARIA_FORMAT_H
+#define ARIA_FORMAT_H
+
+#include "../frontend/ast.h"
+
+/*
+ * Format Specialization
+ * ---------------------
+ * A call to print or format whose format is a string literal is split at
+ * compile time into text and placeholder segments, so the runtime never
+ * parses the format (see "Specialized Formatting" in stdlib/io.c). Literal
+ * arguments are formatted here and merged into the surrounding text; every
+ * other argument becomes an append for its conversion (%d, %f or %s).
+ *
+ * Calls with a dynamic format, an unknown conversion or an argument count
+ * that does not match the placeholders get no plan and keep the generic
+ * runtime call, as does any program that defines its own print or format.
+ */
+
+typedef enum { FMT_TEXT, FMT_INT, FMT_FLOAT, FMT_STR } FormatSegmentKind;
+
+typedef struct {
+    FormatSegmentKind kind;
+    const char* text;        // FMT_TEXT: NUL-terminated, owned by the plan
+    int len;
+    int arg;                 // otherwise: index into FormatPlan.args
+} FormatSegment;
+
+typedef struct {
+    int is_print;            // print writes to stdout, format returns a string
+    FormatSegment* segments;
+    int segment_count;
+    AstNode** args;          // arguments evaluated at run time, in source order
+    int arg_count;
+    int size_hint;           // initial capacity for the format buffer
+} FormatPlan;
+
+FormatPlan* format_plan(AstNode* call, AstNode* program);
+void format_plan_free(FormatPlan* plan);
+
+#endif
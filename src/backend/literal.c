@@ -0,0 +1,17 @@
+/* Aria_lang/src/backend/literal.c */
+#include "literal.h"
+
+// FNV-1a, with 0 reserved for "not computed yet"
+uint32_t literal_hash(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+void literal_header(const char* s, size_t len, unsigned char out[LITERAL_HEADER_SIZE]) {
+    uint32_t words[2] = { (uint32_t)len, literal_hash(s, len) };
+    for (int i = 0; i < 8; i++) out[i] = (unsigned char)(words[i / 4] >> (8 * (i % 4)));
+}
@@ -0,0 +1,29 @@
+/* Aria_lang/src/backend/literal.h */
+#ifndef ARIA_LITERAL_H
+#define ARIA_LITERAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * String Literal Layout
+ * ---------------------
+ * Runtime strings (stdlib/string_utils.c) are preceded by an 8-byte header:
+ * the byte length and a hash of the text, 0 until the runtime first needs
+ * it. A boxed string points at its characters, just past the header.
+ * String literals are emitted with the header already filled in, so
+ * dyn_new_str only has to box the address and the runtime never writes to
+ * a literal. Both halves are little-endian 32-bit words.
+ *
+ * literal_hash must stay identical to aria_str_hash in the runtime and is
+ * never 0.
+ */
+
+#define LITERAL_HEADER_SIZE 8
+
+uint32_t literal_hash(const char* s, size_t len);
+
+// The header for 's' (len bytes) as it is laid out in memory
+void literal_header(const char* s, size_t len, unsigned char out[LITERAL_HEADER_SIZE]);
+
+#endif
@@ -0,0 +1,1059 @@
+/* Aria_lang/src/backend/llvm_codegen.c */
+/*
+ * LLVM IR Backend
+ * ---------------
+ * Lowers the Aria AST to LLVM IR inside a TeslaLLVMContext. Values keep the
+ * exact representation the NASM backend uses: every Aria value is a 64-bit
+ * NaN-boxed word and all dynamic operations are calls into the runtime
+ * (dyn_*, list_*, aria_obj_*). Locals live in entry-block allocas so that
+ * mem2reg/SROA can promote them once the O2 pipeline runs.
+ *
+ * Closures share the native backend's representation: a code address when
+ * nothing is captured, otherwise a tagged record { code, count, captures }.
+ * Capturing closures take the record as a leading 'nest' parameter, which
+ * the x86-64 calling convention passes in r10, so both backends interoperate.
+ * Capture-free ones keep the plain signature of any other function value.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../frontend/ast.h"
+#include "../core/llvm_integration.h"
+#include "escape.h"
+#include "loops.h"
+#include "match.h"
+#include "format.h"
+#include "append.h"
+#include "literal.h"
+
+static TeslaLLVMContext* lctx = NULL;
+static LLVMTypeRef i64_t, i32_t, void_t;
+static LLVMValueRef cur_fn = NULL;
+static LLVMBasicBlockRef alloca_block = NULL;
+static AstNode* program_root = NULL;
+static AstNode* cur_func_node = NULL;
+static LLVMValueRef cur_env = NULL;       // closure record address (i64) in lifted functions
+
+#define CLOSURE_TAG 0xFFFF000000000000ULL
+// Packed int list item pointers and boxed ints (see stdlib/dataStructures.c)
+#define INTS_TAG 0xFFFF000000000000ULL
+#define INT_BOX_TAG 0xFFFC000000000000ULL
+
+// Closures declared while generating bodies; their own bodies are emitted afterwards
+static AstNode** pending_closures = NULL;
+static int pending_count = 0;
+static int pending_cap = 0;
+
+// Local variable slots indexed by unique variable id (parser guarantees ids are program-unique)
+static LLVMValueRef* local_slots = NULL;
+static int local_slot_cap = 0;
+
+// Buffer slots of the current function's accumulating variables (backend/append.h)
+typedef struct {
+    int vid;
+    LLVMValueRef slot;
+} AppendSlot;
+
+#define MAX_APPEND_SLOTS 64
+static AppendSlot append_slots[MAX_APPEND_SLOTS];
+static int append_slot_count = 0;
+
+typedef struct {
+    LLVMBasicBlockRef continue_target;
+    LLVMBasicBlockRef break_target;
+} LoopTarget;
+
+#define MAX_LOOP_DEPTH 128
+static LoopTarget loop_stack[MAX_LOOP_DEPTH];
+static int loop_depth = 0;
+
+/*
+ * Runtime Signatures
+ * ------------------
+ * 'pure' helpers only convert their argument and never touch memory, so they are
+ * marked readnone which lets GVN/LICM fold repeated boxing of constants.
+ */
+typedef struct {
+    const char* name;
+    int argc;
+    int returns_void;
+    int pure;
+} RuntimeSig;
+
+static const RuntimeSig RUNTIME_SIGS[] = {
+    { "dyn_new_int", 1, 0, 1 }, { "dyn_new_float", 1, 0, 1 },
+    { "dyn_new_str", 1, 0, 1 }, { "dyn_new_bool", 1, 0, 1 },
+    { "dyn_new_null", 0, 0, 1 },
+    { "dyn_add", 2, 0, 0 }, { "dyn_sub", 2, 0, 0 }, { "dyn_mul", 2, 0, 0 },
+    { "dyn_div", 2, 0, 0 }, { "dyn_mod", 2, 0, 0 },
+    { "dyn_eq", 2, 0, 0 }, { "dyn_neq", 2, 0, 0 },
+    { "dyn_lt", 2, 0, 0 }, { "dyn_gt", 2, 0, 0 },
+    { "dyn_neg", 1, 0, 0 }, { "dyn_not", 1, 0, 0 }, { "dyn_truthy", 1, 0, 0 },
+    { "dyn_loop_bound", 1, 0, 1 }, { "dyn_match_int", 1, 0, 1 },
+    { "dyn_match_str", 3, 0, 0 }, { "dyn_str_equals", 2, 0, 0 },
+    { "list_new", 0, 0, 0 }, { "list_new_at", 2, 0, 0 }, { "list_push", 2, 1, 0 },
+    { "list_header", 1, 0, 0 },
+    { "list_get", 2, 0, 0 }, { "list_set", 3, 0, 0 },
+    { "aria_alloc_object", 0, 0, 0 }, { "aria_alloc_object_at", 1, 0, 0 },
+    { "aria_obj_get", 2, 0, 0 },
+    { "aria_obj_set", 3, 0, 0 },
+    { "aria_register_global_root", 1, 1, 0 }, { "gc_enter_safepoint", 0, 1, 0 },
+    { "aria_alloc", 1, 0, 0 },
+    { "aria_print_begin", 0, 1, 0 }, { "aria_print_end", 0, 1, 0 },
+    { "aria_fmt_new", 1, 0, 0 }, { "aria_fmt_finish", 1, 0, 0 },
+    { "aria_fmt_text", 3, 1, 0 }, { "aria_fmt_int", 2, 1, 0 },
+    { "aria_fmt_float", 2, 1, 0 }, { "aria_fmt_str", 2, 1, 0 },
+    { NULL, 0, 0, 0 }
+};
+
+static void gen_llvm_statement(AstNode* node);
+static LLVMValueRef gen_llvm_expression(AstNode* node);
+
+static void add_fn_attr(LLVMValueRef fn, const char* attr) {
+    unsigned kind = LLVMGetEnumAttributeKindForName(attr, strlen(attr));
+    LLVMAddAttributeAtIndex(fn, LLVMAttributeFunctionIndex, LLVMCreateEnumAttribute(lctx->context, kind, 0));
+}
+
+static LLVMTypeRef value_fn_type(int argc, int variadic) {
+    LLVMTypeRef params[64];
+    for (int i = 0; i < argc && i < 64; i++) params[i] = i64_t;
+    return LLVMFunctionType(i64_t, params, (unsigned)argc, variadic);
+}
+
+static LLVMValueRef runtime_fn(const char* name) {
+    LLVMValueRef fn = LLVMGetNamedFunction(lctx->module, name);
+    if (fn) return fn;
+    for (const RuntimeSig* sig = RUNTIME_SIGS; sig->name; sig++) {
+        if (strcmp(sig->name, name) != 0) continue;
+        LLVMTypeRef params[3] = { i64_t, i64_t, i64_t };
+        LLVMTypeRef ty = LLVMFunctionType(sig->returns_void ? void_t : i64_t, params, (unsigned)sig->argc, 0);
+        fn = LLVMAddFunction(lctx->module, name, ty);
+        add_fn_attr(fn, "nounwind");
+        if (sig->pure) add_fn_attr(fn, "readnone");
+        return fn;
+    }
+    // Unknown external symbol (C stdlib binding): declare variadic so any arity links
+    return LLVMAddFunction(lctx->module, name, value_fn_type(0, 1));
+}
+
+/*
+ * Calls a named function with i64 arguments. If the declared type does not
+ * match the call site arity (user code calling a runtime helper directly, or
+ * an Aria function with the wrong argument count) the callee is bitcast, which
+ * mirrors the NASM backend's untyped 'call symbol'.
+ */
+static LLVMValueRef call_named(const char* name, LLVMValueRef* args, int argc) {
+    LLVMValueRef fn = runtime_fn(name);
+    LLVMTypeRef fn_ty = LLVMGlobalGetValueType(fn);
+    int declared = (int)LLVMCountParamTypes(fn_ty);
+    if (LLVMIsFunctionVarArg(fn_ty) ? declared <= argc : declared == argc) {
+        return LLVMBuildCall2(lctx->builder, fn_ty, fn, args, (unsigned)argc, "");
+    }
+    LLVMTypeRef cast_ty = value_fn_type(argc, 0);
+    LLVMValueRef cast = LLVMBuildBitCast(lctx->builder, fn, LLVMPointerType(cast_ty, 0), "");
+    return LLVMBuildCall2(lctx->builder, cast_ty, cast, args, (unsigned)argc, "");
+}
+
+static LLVMValueRef call_rt1(const char* name, LLVMValueRef a) { return call_named(name, &a, 1); }
+static LLVMValueRef call_rt2(const char* name, LLVMValueRef a, LLVMValueRef b) {
+    LLVMValueRef args[2] = { a, b };
+    return call_named(name, args, 2);
+}
+
+static LLVMValueRef const_i64(int64_t v) { return LLVMConstInt(i64_t, (unsigned long long)v, 1); }
+
+static LLVMValueRef cstring_ptr(const char* s) {
+    LLVMValueRef str = LLVMBuildGlobalStringPtr(lctx->builder, s, ".str");
+    return LLVMBuildPtrToInt(lctx->builder, str, i64_t, "");
+}
+
+// A string constant behind its runtime header (literal.h), addressed at the characters
+static LLVMValueRef literal_ptr(const char* s) {
+    size_t len = strlen(s);
+    LLVMValueRef fields[3] = {
+        LLVMConstInt(i32_t, len, 0),
+        LLVMConstInt(i32_t, literal_hash(s, len), 0),
+        LLVMConstStringInContext(lctx->context, s, (unsigned)len, 0),
+    };
+    LLVMValueRef init = LLVMConstStructInContext(lctx->context, fields, 3, 0);
+    LLVMValueRef g = LLVMAddGlobal(lctx->module, LLVMTypeOf(init), ".lit");
+    LLVMSetInitializer(g, init);
+    LLVMSetGlobalConstant(g, 1);
+    LLVMSetLinkage(g, LLVMPrivateLinkage);
+    LLVMSetAlignment(g, 8);
+    LLVMValueRef text = LLVMBuildPtrToInt(lctx->builder, g, i64_t, "");
+    return LLVMBuildAdd(lctx->builder, text, const_i64(LITERAL_HEADER_SIZE), "");
+}
+
+static LLVMValueRef function_address(const char* name) {
+    return LLVMBuildPtrToInt(lctx->builder, runtime_fn(name), i64_t, "");
+}
+
+// Starts a fresh block after a terminator so trailing dead statements still have somewhere to go
+static void ensure_open_block() {
+    LLVMBasicBlockRef bb = LLVMGetInsertBlock(lctx->builder);
+    if (LLVMGetBasicBlockTerminator(bb)) {
+        LLVMBasicBlockRef dead = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "dead");
+        LLVMPositionBuilderAtEnd(lctx->builder, dead);
+    }
+}
+
+static void branch_if_open(LLVMBasicBlockRef target) {
+    if (!LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(lctx->builder))) LLVMBuildBr(lctx->builder, target);
+}
+
+// --- Variable Storage ---
+
+// Allocas go at the top of the entry block so loops never grow the stack
+static LLVMValueRef entry_alloca(LLVMTypeRef ty) {
+    LLVMBuilderRef entry = LLVMCreateBuilderInContext(lctx->context);
+    LLVMValueRef first = LLVMGetFirstInstruction(alloca_block);
+    if (first) LLVMPositionBuilderBefore(entry, first);
+    else LLVMPositionBuilderAtEnd(entry, alloca_block);
+    LLVMValueRef slot = LLVMBuildAlloca(entry, ty, "");
+    LLVMDisposeBuilder(entry);
+    return slot;
+}
+
+static LLVMValueRef local_slot(int vid) {
+    if (vid >= local_slot_cap) {
+        int new_cap = local_slot_cap ? local_slot_cap : 64;
+        while (new_cap <= vid) new_cap *= 2;
+        local_slots = realloc(local_slots, sizeof(LLVMValueRef) * new_cap);
+        memset(local_slots + local_slot_cap, 0, sizeof(LLVMValueRef) * (new_cap - local_slot_cap));
+        local_slot_cap = new_cap;
+    }
+    if (!local_slots[vid]) local_slots[vid] = entry_alloca(i64_t);
+    return local_slots[vid];
+}
+
+// An accumulating variable's buffer slot, cleared once on function entry;
+// NULL when the function has too many to track
+static LLVMValueRef append_slot(int vid) {
+    for (int i = 0; i < append_slot_count; i++) {
+        if (append_slots[i].vid == vid) return append_slots[i].slot;
+    }
+    if (append_slot_count >= MAX_APPEND_SLOTS) return NULL;
+    LLVMValueRef slot = entry_alloca(i64_t);
+    LLVMBuilderRef entry = LLVMCreateBuilderInContext(lctx->context);
+    LLVMPositionBuilderAtEnd(entry, alloca_block);
+    LLVMBuildStore(entry, const_i64(0), slot);
+    LLVMDisposeBuilder(entry);
+    append_slots[append_slot_count++] = (AppendSlot){ vid, slot };
+    return slot;
+}
+
+// After any other read of an accumulating variable its text may be shared
+static void append_reset(int vid) {
+    LLVMValueRef slot = vid > 0 && append_tracks(vid) ? append_slot(vid) : NULL;
+    if (slot) LLVMBuildStore(lctx->builder, const_i64(0), slot);
+}
+
+// Storage for a list or object that escape analysis kept in the frame, as an i64 address
+static LLVMValueRef frame_block(FrameAlloc* fa) {
+    LLVMValueRef mem = entry_alloca(LLVMArrayType(LLVMInt8TypeInContext(lctx->context), (unsigned)fa->bytes));
+    LLVMSetAlignment(mem, 16);
+    return LLVMBuildPtrToInt(lctx->builder, mem, i64_t, "");
+}
+
+static LLVMValueRef global_slot(const char* name) {
+    LLVMValueRef g = LLVMGetNamedGlobal(lctx->module, name);
+    if (!g) {
+        g = LLVMAddGlobal(lctx->module, i64_t, name);
+        LLVMSetInitializer(g, const_i64(0));
+    }
+    return g;
+}
+
+// Loads/stores the word at an address held as an i64
+static LLVMValueRef load_word(LLVMValueRef addr) {
+    LLVMValueRef ptr = LLVMBuildIntToPtr(lctx->builder, addr, LLVMPointerType(i64_t, 0), "");
+    return LLVMBuildLoad2(lctx->builder, i64_t, ptr, "");
+}
+
+static void store_word(LLVMValueRef addr, LLVMValueRef val) {
+    LLVMBuildStore(lctx->builder, val, LLVMBuildIntToPtr(lctx->builder, addr, LLVMPointerType(i64_t, 0), ""));
+}
+
+static LLVMValueRef offset_addr(LLVMValueRef addr, int64_t offset) {
+    return LLVMBuildAdd(lctx->builder, addr, const_i64(offset), "");
+}
+
+static int is_boxed(AstNode* decl) {
+    return decl && decl->data.var_decl.is_boxed;
+}
+
+// Index of 'vid' in the record of the closure being generated, or -1
+static int upvalue_index(int vid) {
+    if (!cur_func_node) return -1;
+    int k = 0;
+    for (AstNode* up = AST_KID(cur_func_node, func_decl.upvalues); up; up = AST_NEXT(up), k++) {
+        if (up->data.var_access.id == vid) return k;
+    }
+    return -1;
+}
+
+// The variable's storage word: its value, or its cell when boxed
+static LLVMValueRef load_slot(int vid) {
+    int k = upvalue_index(vid);
+    if (k >= 0) return load_word(offset_addr(cur_env, 16 + 8 * k));
+    return LLVMBuildLoad2(lctx->builder, i64_t, local_slot(vid), "");
+}
+
+static LLVMValueRef load_var(int vid, const char* name, AstNode* decl) {
+    if (vid == -2) return LLVMBuildLoad2(lctx->builder, i64_t, global_slot(name), name);
+    if (vid == -1) return function_address(name);
+    LLVMValueRef v = load_slot(vid);
+    return is_boxed(decl) ? load_word(v) : v;
+}
+
+static void store_var(int vid, const char* name, AstNode* decl, LLVMValueRef val) {
+    if (vid == -2) LLVMBuildStore(lctx->builder, val, global_slot(name));
+    else if (vid > 0 && is_boxed(decl)) store_word(load_slot(vid), val);
+    else if (vid > 0) LLVMBuildStore(lctx->builder, val, local_slot(vid));
+}
+
+static LLVMValueRef new_cell(LLVMValueRef init) {
+    LLVMValueRef cell = call_rt1("aria_alloc", const_i64(8));
+    store_word(cell, init);
+    return cell;
+}
+
+// Mirrors gen_safepoint_poll: a single load + branch on the fast path
+static void gen_llvm_safepoint_poll() {
+    LLVMValueRef flag = LLVMGetNamedGlobal(lctx->module, "gc_suspend_request");
+    if (!flag) flag = LLVMAddGlobal(lctx->module, i32_t, "gc_suspend_request");
+    LLVMValueRef req = LLVMBuildLoad2(lctx->builder, i32_t, flag, "");
+    LLVMSetVolatile(req, 1);
+    LLVMValueRef pending = LLVMBuildICmp(lctx->builder, LLVMIntNE, req, LLVMConstInt(i32_t, 0, 0), "");
+    LLVMBasicBlockRef poll = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "safepoint");
+    LLVMBasicBlockRef cont = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "safe");
+    LLVMBuildCondBr(lctx->builder, pending, poll, cont);
+    LLVMPositionBuilderAtEnd(lctx->builder, poll);
+    call_named("gc_enter_safepoint", NULL, 0);
+    LLVMBuildBr(lctx->builder, cont);
+    LLVMPositionBuilderAtEnd(lctx->builder, cont);
+}
+
+static LLVMValueRef gen_truthy(AstNode* cond) {
+    LLVMValueRef v = call_rt1("dyn_truthy", gen_llvm_expression(cond));
+    return LLVMBuildICmp(lctx->builder, LLVMIntNE, v, const_i64(0), "");
+}
+
+// --- Expressions ---
+
+// && and || yield the deciding operand, like the ternary
+static LLVMValueRef gen_logical(AstNode* node) {
+    int is_and = (node->data.binary.op == TOKEN_AND);
+    LLVMValueRef left = gen_llvm_expression(AST_KID(node, binary.left));
+    LLVMValueRef truth = LLVMBuildICmp(lctx->builder, LLVMIntNE, call_rt1("dyn_truthy", left), const_i64(0), "");
+    LLVMBasicBlockRef left_bb = LLVMGetInsertBlock(lctx->builder);
+    LLVMBasicBlockRef rhs_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "logic.rhs");
+    LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "logic.end");
+    if (is_and) LLVMBuildCondBr(lctx->builder, truth, rhs_bb, end_bb);
+    else LLVMBuildCondBr(lctx->builder, truth, end_bb, rhs_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, rhs_bb);
+    LLVMValueRef right = gen_llvm_expression(AST_KID(node, binary.right));
+    LLVMBasicBlockRef right_bb = LLVMGetInsertBlock(lctx->builder);
+    LLVMBuildBr(lctx->builder, end_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+    LLVMValueRef phi = LLVMBuildPhi(lctx->builder, i64_t, "");
+    LLVMValueRef vals[2] = { left, right };
+    LLVMBasicBlockRef blocks[2] = { left_bb, right_bb };
+    LLVMAddIncoming(phi, vals, blocks, 2);
+    return phi;
+}
+
+static LLVMValueRef gen_binary(AstNode* node) {
+    if (AST_KID(node, binary.left) == NULL) {
+        LLVMValueRef operand = gen_llvm_expression(AST_KID(node, binary.right));
+        switch (node->data.binary.op) {
+            case TOKEN_MINUS: return call_rt1("dyn_neg", operand);
+            case TOKEN_BANG: return call_rt1("dyn_not", operand);
+            default:
+                fprintf(stderr, "Codegen Error: Unknown unary operator token %d\n", node->data.binary.op);
+                exit(1);
+        }
+    }
+    if (node->data.binary.op == TOKEN_AND || node->data.binary.op == TOKEN_OR) return gen_logical(node);
+
+    LLVMValueRef l = gen_llvm_expression(AST_KID(node, binary.left));
+    LLVMValueRef r = gen_llvm_expression(AST_KID(node, binary.right));
+    switch (node->data.binary.op) {
+        case TOKEN_PLUS: return call_rt2("dyn_add", l, r);
+        case TOKEN_MINUS: return call_rt2("dyn_sub", l, r);
+        case TOKEN_STAR: return call_rt2("dyn_mul", l, r);
+        case TOKEN_SLASH: return call_rt2("dyn_div", l, r);
+        case TOKEN_PERCENT: return call_rt2("dyn_mod", l, r);
+        case TOKEN_EQEQ: return call_rt2("dyn_eq", l, r);
+        case TOKEN_NEQ: return call_rt2("dyn_neq", l, r);
+        case TOKEN_LT: return call_rt2("dyn_lt", l, r);
+        case TOKEN_GT: return call_rt2("dyn_gt", l, r);
+        case TOKEN_LTEQ: return call_rt1("dyn_not", call_rt2("dyn_gt", l, r));
+        case TOKEN_GTEQ: return call_rt1("dyn_not", call_rt2("dyn_lt", l, r));
+        default: return r;
+    }
+}
+
+// --- Closures ---
+
+static LLVMAttributeRef nest_attr(void) {
+    unsigned kind = LLVMGetEnumAttributeKindForName("nest", 4);
+    return LLVMCreateEnumAttribute(lctx->context, kind, 0);
+}
+
+// i64 (i8* nest env, i64 x argc)
+static LLVMTypeRef closure_fn_type(int argc) {
+    LLVMTypeRef params[65];
+    params[0] = LLVMPointerType(LLVMInt8TypeInContext(lctx->context), 0);
+    for (int i = 0; i < argc && i < 64; i++) params[i + 1] = i64_t;
+    return LLVMFunctionType(i64_t, params, (unsigned)argc + 1, 0);
+}
+
+static LLVMValueRef declare_closure(AstNode* fn) {
+    LLVMValueRef f = LLVMGetNamedFunction(lctx->module, fn->data.func_decl.name);
+    if (f) return f;
+    int argc = 0;
+    for (AstNode* p = AST_KID(fn, func_decl.params); p; p = AST_NEXT(p)) argc++;
+    if (fn->data.func_decl.upvalue_count > 0) {
+        f = LLVMAddFunction(lctx->module, fn->data.func_decl.name, closure_fn_type(argc));
+        LLVMAddAttributeAtIndex(f, 1, nest_attr());
+    } else {
+        f = LLVMAddFunction(lctx->module, fn->data.func_decl.name, value_fn_type(argc, 0));
+    }
+    LLVMSetLinkage(f, LLVMInternalLinkage);
+    if (pending_count >= pending_cap) {
+        pending_cap = pending_cap ? pending_cap * 2 : 16;
+        pending_closures = realloc(pending_closures, sizeof(AstNode*) * pending_cap);
+    }
+    pending_closures[pending_count++] = fn;
+    return f;
+}
+
+// Captures are copied by value; boxed ones share the cell pointer
+static LLVMValueRef gen_llvm_closure(AstNode* fn) {
+    LLVMValueRef code = LLVMBuildPtrToInt(lctx->builder, declare_closure(fn), i64_t, "");
+    int count = fn->data.func_decl.upvalue_count;
+    if (count == 0) return code;
+
+    LLVMValueRef record = call_rt1("aria_alloc", const_i64(16 + 8 * count));
+    store_word(record, code);
+    store_word(offset_addr(record, 8), const_i64(count));
+    int k = 0;
+    for (AstNode* up = AST_KID(fn, func_decl.upvalues); up; up = AST_NEXT(up), k++) {
+        store_word(offset_addr(record, 16 + 8 * k), load_slot(up->data.var_access.id));
+    }
+    return LLVMBuildOr(lctx->builder, record, const_i64((int64_t)CLOSURE_TAG), "");
+}
+
+// Calls closure code with the untagged record as its environment
+static LLVMValueRef call_with_env(LLVMValueRef fn, LLVMValueRef record, LLVMValueRef* args, int argc) {
+    LLVMTypeRef ty = closure_fn_type(argc);
+    LLVMValueRef all[65];
+    all[0] = LLVMBuildIntToPtr(lctx->builder, record, LLVMPointerType(LLVMInt8TypeInContext(lctx->context), 0), "");
+    for (int i = 0; i < argc; i++) all[i + 1] = args[i];
+    if (LLVMTypeOf(fn) == i64_t) fn = LLVMBuildIntToPtr(lctx->builder, fn, LLVMPointerType(ty, 0), "");
+    LLVMValueRef call = LLVMBuildCall2(lctx->builder, ty, fn, all, (unsigned)argc + 1, "");
+    LLVMAddCallSiteAttribute(call, 1, nest_attr());
+    return call;
+}
+
+// A local bound once to a closure expression
+static AstNode* known_closure(AstNode* callee) {
+    if (ast_type(callee) != NODE_VAR_ACCESS || !callee->data.var_access.decl) return NULL;
+    VarDeclData* decl = &AST_KID(callee, var_access.decl)->data.var_decl;
+    if (decl->is_mutated || !ast_at(AST_KID(callee, var_access.decl), decl->init_expr)) return NULL;
+    AstNode* init = ast_at(AST_KID(callee, var_access.decl), decl->init_expr);
+    return (ast_type(init) == NODE_FUNC_DECL && init->data.func_decl.is_closure) ? init : NULL;
+}
+
+// Function values are code addresses or tagged closure records
+static LLVMValueRef gen_dynamic_call(LLVMValueRef target, LLVMValueRef* args, int argc) {
+    LLVMValueRef tag = const_i64((int64_t)CLOSURE_TAG);
+    LLVMValueRef is_closure = LLVMBuildICmp(lctx->builder, LLVMIntEQ, LLVMBuildAnd(lctx->builder, target, tag, ""), tag, "");
+    LLVMBasicBlockRef closure_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "call.closure");
+    LLVMBasicBlockRef plain_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "call.plain");
+    LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "call.end");
+    LLVMBuildCondBr(lctx->builder, is_closure, closure_bb, plain_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, closure_bb);
+    LLVMValueRef record = LLVMBuildXor(lctx->builder, target, tag, "");
+    LLVMValueRef via_record = call_with_env(load_word(record), record, args, argc);
+    LLVMBuildBr(lctx->builder, end_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, plain_bb);
+    LLVMTypeRef fn_ty = value_fn_type(argc, 0);
+    LLVMValueRef fn_ptr = LLVMBuildIntToPtr(lctx->builder, target, LLVMPointerType(fn_ty, 0), "");
+    LLVMValueRef direct = LLVMBuildCall2(lctx->builder, fn_ty, fn_ptr, args, (unsigned)argc, "");
+    LLVMBuildBr(lctx->builder, end_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+    LLVMValueRef phi = LLVMBuildPhi(lctx->builder, i64_t, "");
+    LLVMValueRef vals[2] = { via_record, direct };
+    LLVMBasicBlockRef blocks[2] = { closure_bb, plain_bb };
+    LLVMAddIncoming(phi, vals, blocks, 2);
+    return phi;
+}
+
+// print / format with a literal format (see format.h); arguments are evaluated before any output
+static LLVMValueRef gen_llvm_format(FormatPlan* plan) {
+    static const char* APPENDS[] = { NULL, "aria_fmt_int", "aria_fmt_float", "aria_fmt_str" };
+    LLVMValueRef args[64];
+    for (int i = 0; i < plan->arg_count; i++) args[i] = gen_llvm_expression(plan->args[i]);
+
+    LLVMValueRef sink = const_i64(0);
+    if (plan->is_print) call_named("aria_print_begin", NULL, 0);
+    else sink = call_rt1("aria_fmt_new", const_i64(plan->size_hint));
+    for (int i = 0; i < plan->segment_count; i++) {
+        FormatSegment* seg = &plan->segments[i];
+        if (seg->kind == FMT_TEXT) {
+            LLVMValueRef text[3] = { sink, cstring_ptr(seg->text), const_i64(seg->len) };
+            call_named("aria_fmt_text", text, 3);
+        } else {
+            call_rt2(APPENDS[seg->kind], sink, args[seg->arg]);
+        }
+    }
+    if (!plan->is_print) return call_rt1("aria_fmt_finish", sink);
+    call_named("aria_print_end", NULL, 0);
+    return const_i64(0);
+}
+
+static LLVMValueRef gen_call(AstNode* node) {
+    AstNode* callee = AST_KID(node, call.callee);
+    FormatPlan* format = format_plan(node, program_root);
+    if (format) {
+        LLVMValueRef result = gen_llvm_format(format);
+        format_plan_free(format);
+        return result;
+    }
+    LLVMValueRef args[64];
+    int argc = 0;
+
+    int implicit_this = (ast_type(callee) == NODE_GET);
+    LLVMValueRef target = NULL;
+    if (implicit_this) {
+        LLVMValueRef obj = gen_llvm_expression(AST_KID(callee, get.obj));
+        target = call_rt2("aria_obj_get", obj, cstring_ptr(callee->data.get.name));
+        args[argc++] = obj;
+    }
+    for (AstNode* arg = AST_KID(node, call.args); arg && argc < 64; arg = AST_NEXT(arg)) {
+        args[argc++] = gen_llvm_expression(arg);
+    }
+
+    if (!implicit_this && ast_type(callee) == NODE_VAR_ACCESS && callee->data.var_access.id == -1) {
+        return call_named(callee->data.var_access.name, args, argc);
+    }
+    AstNode* known = implicit_this ? NULL : known_closure(callee);
+    int known_argc = 0;
+    if (known) for (AstNode* p = AST_KID(known, func_decl.params); p; p = AST_NEXT(p)) known_argc++;
+    if (known && known_argc == argc) {
+        LLVMValueRef fn = declare_closure(known);
+        if (known->data.func_decl.upvalue_count == 0) {
+            return LLVMBuildCall2(lctx->builder, LLVMGlobalGetValueType(fn), fn, args, (unsigned)argc, "");
+        }
+        LLVMValueRef record = LLVMBuildXor(lctx->builder, gen_llvm_expression(callee), const_i64((int64_t)CLOSURE_TAG), "");
+        return call_with_env(fn, record, args, argc);
+    }
+    if (!implicit_this) target = gen_llvm_expression(callee);
+    return gen_dynamic_call(target, args, argc);
+}
+
+static LLVMValueRef gen_new(AstNode* node) {
+    FrameAlloc* fa = escape_find(node);
+    LLVMValueRef obj = fa ? call_rt1("aria_alloc_object_at", frame_block(fa)) : call_named("aria_alloc_object", NULL, 0);
+    for (AstNode* cls = program_root; cls; cls = AST_NEXT(cls)) {
+        if (ast_type(cls) != NODE_CLASS_DECL || strcmp(cls->data.class_decl.name, node->data.string_val) != 0) continue;
+        size_t prefix = strlen(cls->data.class_decl.name) + 1;
+        for (AstNode* method = AST_KID(cls, class_decl.methods); method; method = AST_NEXT(method)) {
+            // Method names arrive mangled as Class_method; the object key is the bare name
+            const char* mangled = method->data.func_decl.name;
+            LLVMValueRef args[3] = { obj, cstring_ptr(mangled + prefix), function_address(mangled) };
+            call_named("aria_obj_set", args, 3);
+        }
+        break;
+    }
+    return obj;
+}
+
+static LLVMValueRef gen_llvm_expression(AstNode* node) {
+    if (!node) return call_named("dyn_new_null", NULL, 0);
+    switch (ast_type(node)) {
+        case NODE_LITERAL: return call_rt1("dyn_new_int", const_i64(node->data.int_val));
+        case NODE_FLOAT: {
+            union { double d; int64_t i; } u; u.d = node->data.double_val;
+            return call_rt1("dyn_new_float", const_i64(u.i));
+        }
+        case NODE_BOOL: return call_rt1("dyn_new_bool", const_i64(node->data.int_val));
+        case NODE_NULL: return call_named("dyn_new_null", NULL, 0);
+        case NODE_STRING: return call_rt1("dyn_new_str", literal_ptr(node->data.string_val));
+        case NODE_VAR_ACCESS: {
+            LLVMValueRef v = load_var(node->data.var_access.id, node->data.var_access.name, AST_KID(node, var_access.decl));
+            append_reset(node->data.var_access.id);
+            return v;
+        }
+        case NODE_FUNC_DECL: return gen_llvm_closure(node);
+        case NODE_ASSIGN: {
+            LLVMValueRef v = gen_llvm_expression(AST_KID(node, assign.value));
+            store_var(node->data.assign.id, node->data.assign.name, AST_KID(node, assign.decl), v);
+            return v;
+        }
+        case NODE_BINARY_OP: return gen_binary(node);
+        case NODE_CALL: return gen_call(node);
+        case NODE_ARRAY_LITERAL: {
+            FrameAlloc* fa = escape_find(node);
+            LLVMValueRef list = fa ? call_rt2("list_new_at", frame_block(fa), const_i64(fa->capacity))
+                                   : call_named("list_new", NULL, 0);
+            for (AstNode* elem = AST_KID(node, array_literal.elements); elem; elem = AST_NEXT(elem)) {
+                call_rt2("list_push", list, gen_llvm_expression(elem));
+            }
+            return list;
+        }
+        case NODE_INDEX_GET: {
+            LLVMValueRef obj = gen_llvm_expression(AST_KID(node, index_get.obj));
+            return call_rt2("list_get", obj, gen_llvm_expression(AST_KID(node, index_get.index)));
+        }
+        case NODE_INDEX_SET: {
+            LLVMValueRef args[3];
+            args[0] = gen_llvm_expression(AST_KID(node, index_set.obj));
+            args[1] = gen_llvm_expression(AST_KID(node, index_set.index));
+            args[2] = gen_llvm_expression(AST_KID(node, index_set.value));
+            return call_named("list_set", args, 3);
+        }
+        case NODE_NEW: return gen_new(node);
+        case NODE_GET: {
+            LLVMValueRef obj = gen_llvm_expression(AST_KID(node, get.obj));
+            return call_rt2("aria_obj_get", obj, cstring_ptr(node->data.get.name));
+        }
+        case NODE_SET: {
+            LLVMValueRef args[3];
+            args[0] = gen_llvm_expression(AST_KID(node, set.obj));
+            args[2] = gen_llvm_expression(AST_KID(node, set.value));
+            args[1] = cstring_ptr(node->data.set.name);
+            return call_named("aria_obj_set", args, 3);
+        }
+        case NODE_TERNARY: {
+            LLVMValueRef cond = gen_truthy(AST_KID(node, ternary.condition));
+            LLVMBasicBlockRef t_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "tern.true");
+            LLVMBasicBlockRef f_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "tern.false");
+            LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "tern.end");
+            LLVMBuildCondBr(lctx->builder, cond, t_bb, f_bb);
+
+            LLVMPositionBuilderAtEnd(lctx->builder, t_bb);
+            LLVMValueRef tv = gen_llvm_expression(AST_KID(node, ternary.true_expr));
+            t_bb = LLVMGetInsertBlock(lctx->builder);
+            LLVMBuildBr(lctx->builder, end_bb);
+
+            LLVMPositionBuilderAtEnd(lctx->builder, f_bb);
+            LLVMValueRef fv = gen_llvm_expression(AST_KID(node, ternary.false_expr));
+            f_bb = LLVMGetInsertBlock(lctx->builder);
+            LLVMBuildBr(lctx->builder, end_bb);
+
+            LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+            LLVMValueRef phi = LLVMBuildPhi(lctx->builder, i64_t, "");
+            LLVMValueRef vals[2] = { tv, fv };
+            LLVMBasicBlockRef blocks[2] = { t_bb, f_bb };
+            LLVMAddIncoming(phi, vals, blocks, 2);
+            return phi;
+        }
+        default: return call_named("dyn_new_null", NULL, 0);
+    }
+}
+
+// --- Statements ---
+
+static void push_loop(LLVMBasicBlockRef continue_bb, LLVMBasicBlockRef break_bb) {
+    if (loop_depth >= MAX_LOOP_DEPTH) {
+        fprintf(stderr, "Codegen Error: Loops nested too deeply.\n");
+        exit(1);
+    }
+    loop_stack[loop_depth++] = (LoopTarget){ continue_bb, break_bb };
+}
+
+// Mirrors gen_for_range: an i64 counter against a bound converted once when
+// the limit is invariant; i is only boxed when the body reads it
+static void gen_llvm_for_range(AstNode* node) {
+    ForStmtData* loop = &node->data.for_stmt;
+    AstNode* var = ast_at(node, loop->var);
+    AstNode* limit = ast_at(node, loop->iterable);
+    AstNode* body = ast_at(node, loop->body);
+    int invariant = loop_limit_is_invariant(limit, body);
+    LLVMValueRef counter = entry_alloca(i64_t);
+    LLVMValueRef bound = NULL;
+    if (invariant) bound = call_rt1("dyn_loop_bound", gen_llvm_expression(limit));
+    LLVMBuildStore(lctx->builder, const_i64(ast_at(node, loop->start)->data.int_val), counter);
+
+    LLVMBasicBlockRef cond_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "for");
+    LLVMBasicBlockRef body_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "for.body");
+    LLVMBasicBlockRef step_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "for.step");
+    LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "for.end");
+    LLVMBuildBr(lctx->builder, cond_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, cond_bb);
+    gen_llvm_safepoint_poll();
+    if (!invariant) bound = call_rt1("dyn_loop_bound", gen_llvm_expression(limit));
+    LLVMValueRef i = LLVMBuildLoad2(lctx->builder, i64_t, counter, "");
+    LLVMBuildCondBr(lctx->builder, LLVMBuildICmp(lctx->builder, LLVMIntSLT, i, bound, ""), body_bb, end_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, body_bb);
+    if (loop_reads_var(body, var)) {
+        store_var(var->data.var_decl.shadow_stack_offset, var->data.var_decl.name, var, call_rt1("dyn_new_int", i));
+    }
+    push_loop(step_bb, end_bb);
+    gen_llvm_statement(body);
+    loop_depth--;
+    branch_if_open(step_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, step_bb);
+    LLVMValueRef next = LLVMBuildAdd(lctx->builder, LLVMBuildLoad2(lctx->builder, i64_t, counter, ""), const_i64(ast_at(node, loop->step)->data.int_val), "");
+    LLVMBuildStore(lctx->builder, next, counter);
+    LLVMBuildBr(lctx->builder, cond_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+}
+
+// List header fields read by for-each loops: int count at 12, then item
+// pointer at 0
+static void load_list_fields(LLVMValueRef header, LLVMValueRef* items, LLVMValueRef* count) {
+    LLVMValueRef count_ptr = LLVMBuildIntToPtr(lctx->builder, offset_addr(header, 12), LLVMPointerType(i32_t, 0), "");
+    *count = LLVMBuildZExt(lctx->builder, LLVMBuildLoad2(lctx->builder, i32_t, count_ptr, ""), i64_t, "");
+    *items = load_word(header);
+}
+
+// Mirrors gen_for_each: direct element loads, with the item pointer and count
+// hoisted out of the loop when the body cannot resize the list, and a 32-bit
+// load boxed inline for packed int lists (a negative item pointer)
+static void gen_llvm_for_each(AstNode* node) {
+    ForStmtData* loop = &node->data.for_stmt;
+    AstNode* var = ast_at(node, loop->var);
+    int vid = var->data.var_decl.shadow_stack_offset;
+    int stable = loop_list_is_stable(ast_at(node, loop->body), program_root);
+    LLVMValueRef header = call_rt1("list_header", gen_llvm_expression(ast_at(node, loop->iterable)));
+    LLVMValueRef index = entry_alloca(i64_t);
+    LLVMValueRef items = NULL, count = NULL;
+    LLVMBuildStore(lctx->builder, const_i64(0), index);
+    if (stable) load_list_fields(header, &items, &count);
+
+    LLVMBasicBlockRef cond_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "each");
+    LLVMBasicBlockRef body_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "each.body");
+    LLVMBasicBlockRef step_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "each.step");
+    LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "each.end");
+    LLVMBuildBr(lctx->builder, cond_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, cond_bb);
+    gen_llvm_safepoint_poll();
+    if (!stable) load_list_fields(header, &items, &count);
+    LLVMValueRef i = LLVMBuildLoad2(lctx->builder, i64_t, index, "");
+    LLVMBuildCondBr(lctx->builder, LLVMBuildICmp(lctx->builder, LLVMIntSLT, i, count, ""), body_bb, end_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, body_bb);
+    if (is_boxed(var)) LLVMBuildStore(lctx->builder, new_cell(const_i64(0)), local_slot(vid));
+    LLVMBasicBlockRef word_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "each.word");
+    LLVMBasicBlockRef ints_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "each.ints");
+    LLVMBasicBlockRef item_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "each.item");
+    LLVMBuildCondBr(lctx->builder, LLVMBuildICmp(lctx->builder, LLVMIntSLT, items, const_i64(0), ""), ints_bb, word_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, word_bb);
+    LLVMValueRef word = load_word(LLVMBuildAdd(lctx->builder, items, LLVMBuildShl(lctx->builder, i, const_i64(3), ""), ""));
+    LLVMBuildBr(lctx->builder, item_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, ints_bb);
+    LLVMValueRef ints = LLVMBuildXor(lctx->builder, items, const_i64((int64_t)INTS_TAG), "");
+    LLVMValueRef slot = LLVMBuildIntToPtr(lctx->builder, LLVMBuildAdd(lctx->builder, ints, LLVMBuildShl(lctx->builder, i, const_i64(2), ""), ""), LLVMPointerType(i32_t, 0), "");
+    LLVMValueRef payload = LLVMBuildZExt(lctx->builder, LLVMBuildLoad2(lctx->builder, i32_t, slot, ""), i64_t, "");
+    LLVMValueRef boxed = LLVMBuildOr(lctx->builder, payload, const_i64((int64_t)INT_BOX_TAG), "");
+    LLVMBuildBr(lctx->builder, item_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, item_bb);
+    LLVMValueRef elem = LLVMBuildPhi(lctx->builder, i64_t, "");
+    LLVMValueRef vals[2] = { word, boxed };
+    LLVMBasicBlockRef blocks[2] = { word_bb, ints_bb };
+    LLVMAddIncoming(elem, vals, blocks, 2);
+    store_var(vid, var->data.var_decl.name, var, elem);
+    push_loop(step_bb, end_bb);
+    gen_llvm_statement(ast_at(node, loop->body));
+    loop_depth--;
+    branch_if_open(step_bb);
+
+    LLVMPositionBuilderAtEnd(lctx->builder, step_bb);
+    LLVMValueRef next = LLVMBuildAdd(lctx->builder, LLVMBuildLoad2(lctx->builder, i64_t, index, ""), const_i64(1), "");
+    LLVMBuildStore(lctx->builder, next, index);
+    LLVMBuildBr(lctx->builder, cond_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+}
+
+/*
+ * Mirrors gen_match with LLVM switches: integer cases switch on
+ * dyn_match_int (LLVM picks a jump table, bit test or binary search), misses
+ * go on to a switch over the string hash slot whose blocks confirm the
+ * candidates, and everything else reaches the 'else' arm.
+ */
+static void gen_llvm_match(AstNode* node) {
+    MatchPlan* plan = match_plan(node);
+    LLVMValueRef subject = gen_llvm_expression(AST_KID(node, match.subject));
+    LLVMBasicBlockRef* arm_bbs = malloc(sizeof(LLVMBasicBlockRef) * (plan->arm_count + 1));
+    for (int i = 0; i < plan->arm_count; i++) arm_bbs[i] = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "match.arm");
+    LLVMBasicBlockRef else_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "match.else");
+    LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "match.end");
+
+    LLVMBasicBlockRef str_bb = plan->str_count > 0 ? LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "match.str") : else_bb;
+    if (plan->int_count > 0) {
+        LLVMValueRef key = call_rt1("dyn_match_int", subject);
+        LLVMValueRef sw = LLVMBuildSwitch(lctx->builder, key, str_bb, (unsigned)plan->int_count);
+        for (int i = 0; i < plan->int_count; i++) LLVMAddCase(sw, const_i64(plan->ints[i].key), arm_bbs[plan->ints[i].arm]);
+    } else {
+        LLVMBuildBr(lctx->builder, str_bb);
+    }
+
+    if (plan->str_count > 0) {
+        LLVMPositionBuilderAtEnd(lctx->builder, str_bb);
+        LLVMValueRef args[3] = { subject, const_i64((int64_t)plan->seed), const_i64(plan->slot_count - 1) };
+        LLVMValueRef slot = call_named("dyn_match_str", args, 3);
+        LLVMValueRef sw = LLVMBuildSwitch(lctx->builder, slot, else_bb, (unsigned)plan->slot_count);
+        for (int s = 0; s < plan->slot_count; s++) {
+            if (plan->slot_start[s] == plan->slot_start[s + 1]) continue;
+            LLVMBasicBlockRef check = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "match.slot");
+            LLVMAddCase(sw, const_i64(s), check);
+            for (int i = plan->slot_start[s]; i < plan->slot_start[s + 1]; i++) {
+                LLVMPositionBuilderAtEnd(lctx->builder, check);
+                LLVMValueRef same = call_rt2("dyn_str_equals", subject, literal_ptr(plan->strs[i].key));
+                check = i + 1 < plan->slot_start[s + 1] ? LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "match.slot") : else_bb;
+                LLVMBuildCondBr(lctx->builder, LLVMBuildICmp(lctx->builder, LLVMIntNE, same, const_i64(0), ""),
+                                arm_bbs[plan->strs[i].arm], check);
+            }
+        }
+    }
+
+    for (int i = 0; i < plan->arm_count; i++) {
+        LLVMPositionBuilderAtEnd(lctx->builder, arm_bbs[i]);
+        gen_llvm_statement(AST_KID(plan->arms[i], match_arm.body));
+        branch_if_open(end_bb);
+    }
+    LLVMPositionBuilderAtEnd(lctx->builder, else_bb);
+    gen_llvm_statement(AST_KID(node, match.otherwise));
+    branch_if_open(end_bb);
+    LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+    free(arm_bbs);
+    match_plan_free(plan);
+}
+
+/*
+ * v = v + x on an accumulating variable: aria_str_append returns the new
+ * text and the buffer holding it as a pair (RAX:RDX, like the x64 backend).
+ */
+static int gen_llvm_append(AstNode* node) {
+    int vid = node->data.assign.id;
+    AstNode* decl = AST_KID(node, assign.decl);
+    LLVMValueRef slot = append_slot(vid);
+    if (!slot) return 0;
+    LLVMValueRef left = load_var(vid, node->data.assign.name, decl);
+    LLVMValueRef right = gen_llvm_expression(AST_KID(AST_KID(node, assign.value), binary.right));
+    LLVMTypeRef fields[2] = { i64_t, i64_t };
+    LLVMTypeRef pair = LLVMStructTypeInContext(lctx->context, fields, 2, 0);
+    LLVMTypeRef params[3] = { i64_t, i64_t, i64_t };
+    LLVMTypeRef fn_ty = LLVMFunctionType(pair, params, 3, 0);
+    LLVMValueRef fn = LLVMGetNamedFunction(lctx->module, "aria_str_append");
+    if (!fn) {
+        fn = LLVMAddFunction(lctx->module, "aria_str_append", fn_ty);
+        add_fn_attr(fn, "nounwind");
+    }
+    LLVMValueRef args[3] = { LLVMBuildLoad2(lctx->builder, i64_t, slot, ""), left, right };
+    LLVMValueRef result = LLVMBuildCall2(lctx->builder, fn_ty, fn, args, 3, "");
+    LLVMBuildStore(lctx->builder, LLVMBuildExtractValue(lctx->builder, result, 1, ""), slot);
+    store_var(vid, node->data.assign.name, decl, LLVMBuildExtractValue(lctx->builder, result, 0, ""));
+    return 1;
+}
+
+static void gen_llvm_statement(AstNode* node) {
+    if (!node) return;
+    ensure_open_block();
+    switch (ast_type(node)) {
+        case NODE_VAR_DECL:
+            if (node->data.var_decl.is_boxed) {
+                LLVMBuildStore(lctx->builder, new_cell(const_i64(0)), local_slot(node->data.var_decl.shadow_stack_offset));
+            }
+            if (node->data.var_decl.init_expr) {
+                store_var(node->data.var_decl.shadow_stack_offset, node->data.var_decl.name, node,
+                          gen_llvm_expression(AST_KID(node, var_decl.init_expr)));
+            }
+            break;
+        case NODE_WHILE: {
+            LLVMBasicBlockRef cond_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "loop");
+            LLVMBasicBlockRef body_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "loop.body");
+            LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "loop.end");
+            LLVMBuildBr(lctx->builder, cond_bb);
+            LLVMPositionBuilderAtEnd(lctx->builder, cond_bb);
+            gen_llvm_safepoint_poll();
+            LLVMBuildCondBr(lctx->builder, gen_truthy(AST_KID(node, while_stmt.condition)), body_bb, end_bb);
+
+            LLVMPositionBuilderAtEnd(lctx->builder, body_bb);
+            push_loop(cond_bb, end_bb);
+            gen_llvm_statement(AST_KID(node, while_stmt.body));
+            loop_depth--;
+            branch_if_open(cond_bb);
+            LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+            break;
+        }
+        case NODE_FOR:
+            if (node->data.for_stmt.is_each) gen_llvm_for_each(node);
+            else gen_llvm_for_range(node);
+            break;
+        case NODE_MATCH: gen_llvm_match(node); break;
+        case NODE_IF: {
+            LLVMBasicBlockRef then_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "then");
+            LLVMBasicBlockRef else_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "else");
+            LLVMBasicBlockRef end_bb = LLVMAppendBasicBlockInContext(lctx->context, cur_fn, "endif");
+            LLVMBuildCondBr(lctx->builder, gen_truthy(AST_KID(node, if_stmt.condition)), then_bb, else_bb);
+            LLVMPositionBuilderAtEnd(lctx->builder, then_bb);
+            gen_llvm_statement(AST_KID(node, if_stmt.then_branch));
+            branch_if_open(end_bb);
+            LLVMPositionBuilderAtEnd(lctx->builder, else_bb);
+            gen_llvm_statement(AST_KID(node, if_stmt.else_branch));
+            branch_if_open(end_bb);
+            LLVMPositionBuilderAtEnd(lctx->builder, end_bb);
+            break;
+        }
+        case NODE_BLOCK:
+            for (AstNode* s = AST_KID(node, block.body); s; s = AST_NEXT(s)) gen_llvm_statement(s);
+            break;
+        case NODE_RETURN:
+            LLVMBuildRet(lctx->builder, gen_llvm_expression(AST_KID(node, return_stmt.expr)));
+            break;
+        case NODE_BREAK:
+            if (loop_depth > 0) LLVMBuildBr(lctx->builder, loop_stack[loop_depth - 1].break_target);
+            break;
+        case NODE_CONTINUE:
+            if (loop_depth > 0) LLVMBuildBr(lctx->builder, loop_stack[loop_depth - 1].continue_target);
+            break;
+        case NODE_CLASS_DECL:
+            break;
+        case NODE_ASSIGN:
+            if (!append_is_lowered(node) || !gen_llvm_append(node)) gen_llvm_expression(node);
+            break;
+        default:
+            gen_llvm_expression(node);
+            break;
+    }
+}
+
+// --- Functions ---
+
+static void declare_function(AstNode* func) {
+    int argc = 0;
+    for (AstNode* p = AST_KID(func, func_decl.params); p; p = AST_NEXT(p)) argc++;
+    if (!LLVMGetNamedFunction(lctx->module, func->data.func_decl.name)) {
+        LLVMAddFunction(lctx->module, func->data.func_decl.name, value_fn_type(argc, 0));
+    }
+}
+
+static void begin_body(LLVMValueRef fn) {
+    cur_fn = fn;
+    loop_depth = 0;
+    if (local_slots) memset(local_slots, 0, sizeof(LLVMValueRef) * local_slot_cap);
+    append_slot_count = 0;
+    alloca_block = LLVMAppendBasicBlockInContext(lctx->context, fn, "entry");
+    LLVMBasicBlockRef body = LLVMAppendBasicBlockInContext(lctx->context, fn, "body");
+    LLVMPositionBuilderAtEnd(lctx->builder, body);
+}
+
+static void end_body(LLVMBasicBlockRef body) {
+    LLVMPositionBuilderAtEnd(lctx->builder, alloca_block);
+    LLVMBuildBr(lctx->builder, body);
+}
+
+static void gen_llvm_function(AstNode* func) {
+    LLVMValueRef fn = LLVMGetNamedFunction(lctx->module, func->data.func_decl.name);
+    begin_body(fn);
+    cur_func_node = func;
+    escape_analyze(func, program_root);
+    append_analyze(func);
+    LLVMBasicBlockRef body = LLVMGetInsertBlock(lctx->builder);
+    gen_llvm_safepoint_poll();
+
+    // Lifted closures receive their record as the leading 'nest' parameter
+    int idx = 0;
+    if (func->data.func_decl.upvalue_count > 0) {
+        cur_env = LLVMBuildPtrToInt(lctx->builder, LLVMGetParam(fn, 0), i64_t, "env");
+        idx = 1;
+    }
+    for (AstNode* p = AST_KID(func, func_decl.params); p; p = AST_NEXT(p), idx++) {
+        LLVMValueRef arg = LLVMGetParam(fn, (unsigned)idx);
+        if (p->data.var_decl.is_boxed) arg = new_cell(arg);
+        LLVMBuildStore(lctx->builder, arg, local_slot(p->data.var_decl.shadow_stack_offset));
+    }
+    gen_llvm_statement(AST_KID(func, func_decl.body));
+    if (!LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(lctx->builder))) {
+        LLVMBuildRet(lctx->builder, call_named("dyn_new_null", NULL, 0));
+    }
+    end_body(body);
+    cur_func_node = NULL;
+    cur_env = NULL;
+}
+
+/*
+ * Program entry: registers and initializes globals, then runs the user's
+ * main (renamed aria_main by the parser).
+ */
+static void gen_llvm_main(AstNode* head) {
+    LLVMValueRef main_fn = LLVMAddFunction(lctx->module, "main", LLVMFunctionType(i32_t, NULL, 0, 0));
+    begin_body(main_fn);
+    LLVMBasicBlockRef body = LLVMGetInsertBlock(lctx->builder);
+
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) != NODE_VAR_DECL) continue;
+        LLVMValueRef slot = global_slot(curr->data.var_decl.name);
+        call_rt1("aria_register_global_root", LLVMBuildPtrToInt(lctx->builder, slot, i64_t, ""));
+    }
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_VAR_DECL && AST_KID(curr, var_decl.init_expr)) {
+            LLVMBuildStore(lctx->builder, gen_llvm_expression(AST_KID(curr, var_decl.init_expr)),
+                           global_slot(curr->data.var_decl.name));
+        }
+    }
+    if (LLVMGetNamedFunction(lctx->module, "aria_main")) call_named("aria_main", NULL, 0);
+    LLVMBuildRet(lctx->builder, LLVMConstInt(i32_t, 0, 0));
+    end_body(body);
+}
+
+bool gen_program_llvm(TeslaLLVMContext* ctx, AstNode* head) {
+    lctx = ctx;
+    program_root = head;
+    escape_analyze(NULL, head);
+    i64_t = LLVMInt64TypeInContext(ctx->context);
+    i32_t = LLVMInt32TypeInContext(ctx->context);
+    void_t = LLVMVoidTypeInContext(ctx->context);
+
+    // Pass 1: declare every Aria function so calls bind with exact arity
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_FUNC_DECL) declare_function(curr);
+        else if (ast_type(curr) == NODE_CLASS_DECL) {
+            for (AstNode* m = AST_KID(curr, class_decl.methods); m; m = AST_NEXT(m)) declare_function(m);
+        }
+    }
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_VAR_DECL) global_slot(curr->data.var_decl.name);
+    }
+
+    // Pass 2: bodies
+    gen_llvm_main(head);
+    for (AstNode* curr = head; curr; curr = AST_NEXT(curr)) {
+        if (ast_type(curr) == NODE_FUNC_DECL) gen_llvm_function(curr);
+        else if (ast_type(curr) == NODE_CLASS_DECL) {
+            for (AstNode* m = AST_KID(curr, class_decl.methods); m; m = AST_NEXT(m)) gen_llvm_function(m);
+        }
+    }
+    // Lifted closures, including ones declared while generating other closures
+    for (int i = 0; i < pending_count; i++) gen_llvm_function(pending_closures[i]);
+    free(pending_closures);
+    pending_closures = NULL;
+    pending_count = pending_cap = 0;
+
+    free(local_slots);
+    local_slots = NULL;
+    local_slot_cap = 0;
+
+    char* error = NULL;
+    if (LLVMVerifyModule(ctx->module, LLVMReturnStatusAction, &error)) {
+        snprintf(ctx->error_message, sizeof(ctx->error_message), "Invalid IR: %s", error ? error : "unknown error");
+        LLVMDisposeMessage(error);
+        return false;
+    }
+    LLVMDisposeMessage(error);
+    return true;
+}
@@ -0,0 +1,112 @@
+/* Aria_lang/src/backend/loops.c */
+#include <string.h>
+#include "loops.h"
+
+typedef int (*NodePredicate)(AstNode* node, void* ctx);
+
+// Runtime helpers that neither resize a list nor replace its storage
+static const char* STABLE_CALLS[] = {
+    "dyn_print", "print", "println", "format", "list_get", "list_set", NULL
+};
+
+static int any_one(AstNode* node, NodePredicate pred, void* ctx);
+
+// True if 'pred' holds anywhere in the list of nodes starting at 'node'
+static int any_node(AstNode* node, NodePredicate pred, void* ctx) {
+    for (; node; node = AST_NEXT(node)) {
+        if (any_one(node, pred, ctx)) return 1;
+    }
+    return 0;
+}
+
+// True if 'pred' holds for 'node' or anything under it. Nested function
+// bodies are searched too, which is conservative for every query here.
+static int any_one(AstNode* node, NodePredicate pred, void* ctx) {
+    if (!node) return 0;
+    if (pred(node, ctx)) return 1;
+    switch (ast_type(node)) {
+        case NODE_VAR_DECL: return any_one(AST_KID(node, var_decl.init_expr), pred, ctx);
+        case NODE_FUNC_DECL: return any_one(AST_KID(node, func_decl.body), pred, ctx);
+        case NODE_BLOCK: return any_node(AST_KID(node, block.body), pred, ctx);
+        case NODE_BINARY_OP:
+            return any_one(AST_KID(node, binary.left), pred, ctx) || any_one(AST_KID(node, binary.right), pred, ctx);
+        case NODE_IF:
+            return any_one(AST_KID(node, if_stmt.condition), pred, ctx) ||
+                   any_one(AST_KID(node, if_stmt.then_branch), pred, ctx) ||
+                   any_one(AST_KID(node, if_stmt.else_branch), pred, ctx);
+        case NODE_WHILE:
+            return any_one(AST_KID(node, while_stmt.condition), pred, ctx) || any_one(AST_KID(node, while_stmt.body), pred, ctx);
+        case NODE_FOR:
+            return any_one(AST_KID(node, for_stmt.iterable), pred, ctx) || any_one(AST_KID(node, for_stmt.body), pred, ctx);
+        case NODE_MATCH:
+            return any_one(AST_KID(node, match.subject), pred, ctx) ||
+                   any_node(AST_KID(node, match.arms), pred, ctx) ||
+                   any_one(AST_KID(node, match.otherwise), pred, ctx);
+        case NODE_MATCH_ARM: return any_one(AST_KID(node, match_arm.body), pred, ctx);
+        case NODE_RETURN: return any_one(AST_KID(node, return_stmt.expr), pred, ctx);
+        case NODE_ASSIGN: return any_one(AST_KID(node, assign.value), pred, ctx);
+        case NODE_CALL:
+            return any_one(AST_KID(node, call.callee), pred, ctx) || any_node(AST_KID(node, call.args), pred, ctx);
+        case NODE_GET: return any_one(AST_KID(node, get.obj), pred, ctx);
+        case NODE_SET:
+            return any_one(AST_KID(node, set.obj), pred, ctx) || any_one(AST_KID(node, set.value), pred, ctx);
+        case NODE_INDEX_GET:
+            return any_one(AST_KID(node, index_get.obj), pred, ctx) || any_one(AST_KID(node, index_get.index), pred, ctx);
+        case NODE_INDEX_SET:
+            return any_one(AST_KID(node, index_set.obj), pred, ctx) ||
+                   any_one(AST_KID(node, index_set.index), pred, ctx) ||
+                   any_one(AST_KID(node, index_set.value), pred, ctx);
+        case NODE_ARRAY_LITERAL: return any_node(AST_KID(node, array_literal.elements), pred, ctx);
+        case NODE_TERNARY:
+            return any_one(AST_KID(node, ternary.condition), pred, ctx) ||
+                   any_one(AST_KID(node, ternary.true_expr), pred, ctx) ||
+                   any_one(AST_KID(node, ternary.false_expr), pred, ctx);
+        default: return 0;
+    }
+}
+
+// --- Predicates ---
+
+// A call that might push to, pop from or otherwise rebuild a list
+static int is_resizing_call(AstNode* node, void* program) {
+    if (ast_type(node) != NODE_CALL) return 0;
+    AstNode* callee = AST_KID(node, call.callee);
+    if (ast_type(callee) != NODE_VAR_ACCESS || callee->data.var_access.id != -1) return 1;
+    const char* name = callee->data.var_access.name;
+    // Functions of the program shadow runtime helpers of the same name
+    for (AstNode* n = program; n; n = AST_NEXT(n)) {
+        if (ast_type(n) == NODE_FUNC_DECL && strcmp(n->data.func_decl.name, name) == 0) return 1;
+    }
+    for (const char** s = STABLE_CALLS; *s; s++) {
+        if (strcmp(*s, name) == 0) return 0;
+    }
+    return 1;
+}
+
+static int assigns_var(AstNode* node, void* decl) {
+    return ast_type(node) == NODE_ASSIGN && AST_KID(node, assign.decl) == decl;
+}
+
+static int reads_var(AstNode* node, void* decl) {
+    return ast_type(node) == NODE_VAR_ACCESS && AST_KID(node, var_access.decl) == decl;
+}
+
+// --- Public API ---
+
+int loop_list_is_stable(AstNode* body, AstNode* program) {
+    return !any_one(body, is_resizing_call, program);
+}
+
+int loop_limit_is_invariant(AstNode* limit, AstNode* body) {
+    if (!limit) return 0;
+    if (ast_type(limit) == NODE_LITERAL || ast_type(limit) == NODE_FLOAT) return 1;
+    if (ast_type(limit) != NODE_VAR_ACCESS || limit->data.var_access.id <= 0) return 0;
+    AstNode* decl = AST_KID(limit, var_access.decl);
+    // A boxed variable can be assigned by any closure the body calls
+    if (!decl || decl->data.var_decl.is_boxed) return 0;
+    return !any_one(body, assigns_var, decl);
+}
+
+int loop_reads_var(AstNode* body, AstNode* decl) {
+    return any_one(body, reads_var, decl);
+}
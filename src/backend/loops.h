@@ -0,0 +1,30 @@
+/* Aria_lang/src/backend/loops.h */
+#ifndef ARIA_LOOPS_H
+#define ARIA_LOOPS_H
+
+#include "../frontend/ast.h"
+
+/*
+ * Loop Queries
+ * ------------
+ * Facts about a NODE_FOR body that both backends use to keep loop state
+ * unboxed and out of the per-iteration path. Every answer is conservative:
+ * when in doubt the backend re-reads the value each iteration.
+ */
+
+// Hidden per-loop values (counter, bound, list header, ...) are compiled as
+// extra locals with ids derived from the loop variable's id
+#define LOOP_STATE_BASE 0x40000000
+#define LOOP_STATE_ID(var_id, k) (LOOP_STATE_BASE + 4 * (var_id) + (k))
+
+// True if nothing in 'body' can change the length or storage of a list: the
+// only calls are runtime helpers that read lists or overwrite elements
+int loop_list_is_stable(AstNode* body, AstNode* program);
+
+// True if 'limit' has the same value on every iteration of 'body'
+int loop_limit_is_invariant(AstNode* limit, AstNode* body);
+
+// True if 'body' reads the variable declared by 'decl'
+int loop_reads_var(AstNode* body, AstNode* decl);
+
+#endif
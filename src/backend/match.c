@@ -0,0 +1,155 @@
+/* Aria_lang/src/backend/match.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "match.h"
+#include "literal.h"
+
+// Jump tables need at least this many cases and must be at least half full
+#define TABLE_MIN_CASES 4
+#define TABLE_MAX_SPAN 4096
+#define LINEAR_MAX_CASES 3
+
+// Perfect hash search: table sizes from 2x to 8x the case count, this many seeds each
+#define HASH_SEEDS 512
+#define HASH_MAX_GROWTH 8
+
+static void* xmalloc(size_t n) {
+    void* p = malloc(n ? n : 1);
+    if (!p) { fprintf(stderr, "Fatal: Out of memory in match planning.\n"); exit(1); }
+    return p;
+}
+
+// The string's own hash (literal.h), so the runtime reuses its cached one
+uint64_t match_hash(const char* s, uint64_t seed) {
+    uint64_t h = literal_hash(s, strlen(s)) ^ (seed * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static int compare_int_cases(const void* a, const void* b) {
+    const MatchIntCase* x = a;
+    const MatchIntCase* y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return x->arm - y->arm;
+}
+
+// --- Integers ---
+
+static void plan_ints(MatchPlan* plan) {
+    qsort(plan->ints, plan->int_count, sizeof(MatchIntCase), compare_int_cases);
+    int kept = 0;
+    for (int i = 0; i < plan->int_count; i++) {
+        if (kept > 0 && plan->ints[kept - 1].key == plan->ints[i].key) continue;
+        plan->ints[kept++] = plan->ints[i];
+    }
+    plan->int_count = kept;
+
+    plan->int_strategy = kept <= LINEAR_MAX_CASES ? MATCH_LINEAR : MATCH_BINARY;
+    if (kept >= TABLE_MIN_CASES) {
+        int64_t span = plan->ints[kept - 1].key - plan->ints[0].key + 1;
+        if (span <= TABLE_MAX_SPAN && span <= 2 * (int64_t)kept) plan->int_strategy = MATCH_TABLE;
+    }
+}
+
+// --- Strings ---
+
+// Largest number of strings sharing a slot under (seed, size)
+static int worst_bucket(MatchPlan* plan, uint64_t seed, int size, int* counts) {
+    memset(counts, 0, sizeof(int) * size);
+    int worst = 0;
+    for (int i = 0; i < plan->str_count; i++) {
+        int c = ++counts[match_hash(plan->strs[i].key, seed) & (uint64_t)(size - 1)];
+        if (c > worst) worst = c;
+    }
+    return worst;
+}
+
+static void plan_strings(MatchPlan* plan) {
+    // A repeated string keeps its first arm
+    int kept = 0;
+    for (int i = 0; i < plan->str_count; i++) {
+        int seen = 0;
+        for (int j = 0; j < kept && !seen; j++) seen = strcmp(plan->strs[j].key, plan->strs[i].key) == 0;
+        if (!seen) plan->strs[kept++] = plan->strs[i];
+    }
+    plan->str_count = kept;
+
+    int size = 1;
+    while (size < 2 * kept) size *= 2;
+    int* counts = xmalloc(sizeof(int) * size * HASH_MAX_GROWTH);
+    int best = kept + 1, best_size = size;
+    uint64_t best_seed = 0;
+    for (int grow = 1; grow <= HASH_MAX_GROWTH && best > 1; grow *= 2) {
+        for (uint64_t seed = 0; seed < HASH_SEEDS && best > 1; seed++) {
+            int worst = worst_bucket(plan, seed, size * grow, counts);
+            if (worst < best) {
+                best = worst;
+                best_size = size * grow;
+                best_seed = seed;
+            }
+        }
+    }
+    free(counts);
+
+    plan->seed = best_seed;
+    plan->slot_count = best_size;
+    plan->slot_start = xmalloc(sizeof(int) * (best_size + 1));
+    memset(plan->slot_start, 0, sizeof(int) * (best_size + 1));
+    for (int i = 0; i < kept; i++) plan->slot_start[(match_hash(plan->strs[i].key, best_seed) & (uint64_t)(best_size - 1)) + 1]++;
+    for (int s = 0; s < best_size; s++) plan->slot_start[s + 1] += plan->slot_start[s];
+
+    // Stable counting sort by slot, so candidates of a slot stay in source order
+    MatchStrCase* sorted = xmalloc(sizeof(MatchStrCase) * kept);
+    int* fill = xmalloc(sizeof(int) * best_size);
+    memcpy(fill, plan->slot_start, sizeof(int) * best_size);
+    for (int i = 0; i < kept; i++) {
+        int slot = (int)(match_hash(plan->strs[i].key, best_seed) & (uint64_t)(best_size - 1));
+        sorted[fill[slot]++] = plan->strs[i];
+    }
+    free(fill);
+    free(plan->strs);
+    plan->strs = sorted;
+}
+
+// --- Public API ---
+
+MatchPlan* match_plan(AstNode* node) {
+    MatchPlan* plan = xmalloc(sizeof(MatchPlan));
+    memset(plan, 0, sizeof(MatchPlan));
+
+    int patterns = 0;
+    for (AstNode* arm = AST_KID(node, match.arms); arm; arm = AST_NEXT(arm)) {
+        plan->arm_count++;
+        for (AstNode* p = AST_KID(arm, match_arm.patterns); p; p = AST_NEXT(p)) patterns++;
+    }
+    plan->arms = xmalloc(sizeof(AstNode*) * plan->arm_count);
+    plan->ints = xmalloc(sizeof(MatchIntCase) * patterns);
+    plan->strs = xmalloc(sizeof(MatchStrCase) * patterns);
+
+    int index = 0;
+    for (AstNode* arm = AST_KID(node, match.arms); arm; arm = AST_NEXT(arm), index++) {
+        plan->arms[index] = arm;
+        for (AstNode* p = AST_KID(arm, match_arm.patterns); p; p = AST_NEXT(p)) {
+            if (ast_type(p) == NODE_STRING) {
+                plan->strs[plan->str_count++] = (MatchStrCase){ p->data.string_val, index };
+            } else {
+                plan->ints[plan->int_count++] = (MatchIntCase){ (int32_t)p->data.int_val, index };
+            }
+        }
+    }
+    if (plan->int_count > 0) plan_ints(plan);
+    if (plan->str_count > 0) plan_strings(plan);
+    return plan;
+}
+
+void match_plan_free(MatchPlan* plan) {
+    if (!plan) return;
+    free(plan->arms);
+    free(plan->ints);
+    free(plan->strs);
+    free(plan->slot_start);
+    free(plan);
+}
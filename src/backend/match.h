@@ -0,0 +1,57 @@
+/* Aria_lang/src/backend/match.h */
+#ifndef ARIA_MATCH_H
+#define ARIA_MATCH_H
+
+#include <stdint.h>
+#include "../frontend/ast.h"
+
+/*
+ * Match Dispatch Planning
+ * -----------------------
+ * Turns the cases of a NODE_MATCH into a dispatch plan both backends follow.
+ * Integer cases become a jump table when they are dense, a binary search
+ * when they are sparse, and a short compare chain when there are only a few.
+ * String cases are hashed at compile time with a seed chosen so that every
+ * case lands in its own slot; at run time the subject is hashed once
+ * (dyn_match_str) and confirmed with a single compare (dyn_str_equals).
+ * When no seed separates every string within the table size limit the best
+ * seed found is used and a slot confirms its few candidates in turn.
+ *
+ * Integer keys are compared as the runtime boxes them (32-bit), so case
+ * labels are truncated the same way dyn_new_int truncates literals.
+ */
+
+typedef enum { MATCH_LINEAR, MATCH_BINARY, MATCH_TABLE } MatchIntStrategy;
+
+typedef struct {
+    int64_t key;
+    int arm;
+} MatchIntCase;
+
+typedef struct {
+    const char* key;
+    int arm;
+} MatchStrCase;
+
+typedef struct {
+    AstNode** arms;          // arm index -> NODE_MATCH_ARM, in source order
+    int arm_count;
+
+    MatchIntCase* ints;      // sorted by key; a repeated key keeps its first arm
+    int int_count;
+    MatchIntStrategy int_strategy;
+
+    MatchStrCase* strs;      // grouped by slot: slot s owns strs[slot_start[s] .. slot_start[s + 1])
+    int str_count;
+    uint64_t seed;
+    int slot_count;          // power of two
+    int* slot_start;         // slot_count + 1 entries
+} MatchPlan;
+
+MatchPlan* match_plan(AstNode* node);
+void match_plan_free(MatchPlan* plan);
+
+// Must agree with dyn_match_str in the runtime (stdlib/dynamic.c)
+uint64_t match_hash(const char* s, uint64_t seed);
+
+#endif
@@ -0,0 +1,320 @@
+/* Aria_lang/src/backend/pgo.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pgo.h"
+
+// A site is hot when it ran at least PGO_MIN_HOT times and within
+// 1/PGO_HOT_FRACTION of the hottest site
+#define PGO_MIN_HOT 64
+#define PGO_HOT_FRACTION 100
+// Largest return expression (in nodes) expanded in place of a call
+#define PGO_INLINE_MAX_NODES 32
+
+PgoMode pgo_mode = PGO_OFF;
+
+static void* xrealloc(void* p, size_t n) {
+    p = realloc(p, n ? n : 1);
+    if (!p) { fprintf(stderr, "Fatal: Out of memory in profile handling.\n"); exit(1); }
+    return p;
+}
+
+// --- Sites of the current function ---
+
+typedef struct {
+    AstNode* node;
+    int ordinal;
+} Site;
+
+static const char* site_func = NULL;
+static Site* sites = NULL;
+static int site_count = 0, site_capacity = 0;
+
+static void add_site(AstNode* node) {
+    if (site_count == site_capacity) {
+        site_capacity = site_capacity ? site_capacity * 2 : 64;
+        sites = xrealloc(sites, sizeof(Site) * site_capacity);
+    }
+    sites[site_count].node = node;
+    sites[site_count].ordinal = site_count;
+    site_count++;
+}
+
+static void number_nodes(AstNode* node);
+
+static void number_node(AstNode* node) {
+    if (!node) return;
+    switch (ast_type(node)) {
+        // Nested functions are numbered on their own when they are generated
+        case NODE_FUNC_DECL: return;
+        case NODE_IF: case NODE_WHILE: case NODE_CALL: case NODE_GET: add_site(node); break;
+        default: break;
+    }
+    switch (ast_type(node)) {
+        case NODE_VAR_DECL: number_node(AST_KID(node, var_decl.init_expr)); break;
+        case NODE_BLOCK: number_nodes(AST_KID(node, block.body)); break;
+        case NODE_BINARY_OP: number_node(AST_KID(node, binary.left)); number_node(AST_KID(node, binary.right)); break;
+        case NODE_IF:
+            number_node(AST_KID(node, if_stmt.condition));
+            number_node(AST_KID(node, if_stmt.then_branch));
+            number_node(AST_KID(node, if_stmt.else_branch));
+            break;
+        case NODE_WHILE: number_node(AST_KID(node, while_stmt.condition)); number_node(AST_KID(node, while_stmt.body)); break;
+        case NODE_FOR: number_node(AST_KID(node, for_stmt.iterable)); number_node(AST_KID(node, for_stmt.body)); break;
+        case NODE_MATCH:
+            number_node(AST_KID(node, match.subject));
+            for (AstNode* arm = AST_KID(node, match.arms); arm; arm = AST_NEXT(arm)) number_node(AST_KID(arm, match_arm.body));
+            number_node(AST_KID(node, match.otherwise));
+            break;
+        case NODE_RETURN: number_node(AST_KID(node, return_stmt.expr)); break;
+        case NODE_ASSIGN: number_node(AST_KID(node, assign.value)); break;
+        case NODE_CALL: number_node(AST_KID(node, call.callee)); number_nodes(AST_KID(node, call.args)); break;
+        case NODE_GET: number_node(AST_KID(node, get.obj)); break;
+        case NODE_SET: number_node(AST_KID(node, set.obj)); number_node(AST_KID(node, set.value)); break;
+        case NODE_INDEX_GET: number_node(AST_KID(node, index_get.obj)); number_node(AST_KID(node, index_get.index)); break;
+        case NODE_INDEX_SET:
+            number_node(AST_KID(node, index_set.obj));
+            number_node(AST_KID(node, index_set.index));
+            number_node(AST_KID(node, index_set.value));
+            break;
+        case NODE_ARRAY_LITERAL: number_nodes(AST_KID(node, array_literal.elements)); break;
+        case NODE_TERNARY:
+            number_node(AST_KID(node, ternary.condition));
+            number_node(AST_KID(node, ternary.true_expr));
+            number_node(AST_KID(node, ternary.false_expr));
+            break;
+        default: break;
+    }
+}
+
+static void number_nodes(AstNode* node) {
+    for (; node; node = AST_NEXT(node)) number_node(node);
+}
+
+void pgo_function(AstNode* func) {
+    site_func = func->data.func_decl.name;
+    site_count = 0;
+    if (pgo_mode != PGO_OFF) number_nodes(AST_KID(func, func_decl.body));
+}
+
+// "name:entry" for a function, "name:ordinal:what" for a site of the current
+// function; NULL if 'site' was not numbered
+static char* site_key(AstNode* site, const char* what) {
+    char buf[512];
+    if (ast_type(site) == NODE_FUNC_DECL) {
+        snprintf(buf, sizeof(buf), "%s:%s", site->data.func_decl.name, what);
+    } else {
+        int i = 0;
+        while (i < site_count && sites[i].node != site) i++;
+        if (i == site_count) return NULL;
+        snprintf(buf, sizeof(buf), "%s:%d:%s", site_func, sites[i].ordinal, what);
+    }
+    return strdup(buf);
+}
+
+// --- Instrumentation ---
+
+static char* descriptor = NULL;
+static size_t descriptor_len = 0;
+static int counter_count = 0;
+
+int pgo_counter(AstNode* site, const char* what) {
+    char* key = site_key(site, what);
+    if (!key) return -1;
+    size_t n = strlen(key);
+    descriptor = xrealloc(descriptor, descriptor_len + n + 2);
+    memcpy(descriptor + descriptor_len, key, n);
+    descriptor_len += n;
+    descriptor[descriptor_len++] = '\n';
+    descriptor[descriptor_len] = '\0';
+    free(key);
+    return counter_count++;
+}
+
+int pgo_counter_count(void) { return counter_count; }
+const char* pgo_descriptor(void) { return descriptor ? descriptor : ""; }
+
+// --- Feedback ---
+
+typedef struct {
+    char* key;
+    uint64_t count;
+} ProfileEntry;
+
+static ProfileEntry* table = NULL;
+static size_t table_mask = 0;
+static uint64_t hottest = 0;
+
+static size_t key_hash(const char* key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char* p = key; *p; p++) { h ^= (uint8_t)*p; h *= 0x100000001b3ULL; }
+    return (size_t)h;
+}
+
+static ProfileEntry* lookup(const char* key) {
+    if (!table) return NULL;
+    for (size_t i = key_hash(key) & table_mask; table[i].key; i = (i + 1) & table_mask) {
+        if (strcmp(table[i].key, key) == 0) return &table[i];
+    }
+    return NULL;
+}
+
+static void insert(const char* key, uint64_t count) {
+    size_t i = key_hash(key) & table_mask;
+    while (table[i].key && strcmp(table[i].key, key) != 0) i = (i + 1) & table_mask;
+    if (!table[i].key) table[i].key = strdup(key);
+    table[i].count = count;
+    // Slot counters record a position, not a frequency
+    size_t n = strlen(key);
+    if ((n < 5 || strcmp(key + n - 5, ":slot") != 0) && count > hottest) hottest = count;
+}
+
+// Profile lines are "key count", as runtime/profile.c writes them
+int pgo_load(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Could not read profile %s\n", path);
+        return 0;
+    }
+    size_t lines = 0;
+    char line[600];
+    while (fgets(line, sizeof(line), f)) lines++;
+    size_t capacity = 64;
+    while (capacity < lines * 2) capacity *= 2;
+    table = calloc(capacity, sizeof(ProfileEntry));
+    if (!table) { fprintf(stderr, "Fatal: Out of memory in profile handling.\n"); exit(1); }
+    table_mask = capacity - 1;
+
+    rewind(f);
+    char key[512];
+    unsigned long long count;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%511s %llu", key, &count) == 2) insert(key, count);
+    }
+    fclose(f);
+    return 1;
+}
+
+uint64_t pgo_count(AstNode* site, const char* what) {
+    if (pgo_mode != PGO_USE) return 0;
+    char* key = site_key(site, what);
+    if (!key) return 0;
+    ProfileEntry* e = lookup(key);
+    free(key);
+    return e ? e->count : 0;
+}
+
+int pgo_is_hot(uint64_t count) {
+    return count >= PGO_MIN_HOT && count * PGO_HOT_FRACTION >= hottest;
+}
+
+// --- Inlining ---
+
+static int is_param(AstNode* func, AstNode* decl) {
+    for (AstNode* p = AST_KID(func, func_decl.params); p; p = AST_NEXT(p)) {
+        if (p == decl) return 1;
+    }
+    return 0;
+}
+
+// Node count of an expression built only from parts that are safe to
+// generate inside another function's frame, or -1
+static int inline_size(AstNode* func, AstNode* node) {
+    if (!node) return 0;
+    int a, b, c;
+    switch (ast_type(node)) {
+        case NODE_LITERAL: case NODE_FLOAT: case NODE_BOOL: case NODE_NULL: case NODE_STRING:
+            return 1;
+        case NODE_VAR_ACCESS:
+            // Parameters, globals and functions; never locals or captures of the callee
+            if (node->data.var_access.id > 0 && !is_param(func, AST_KID(node, var_access.decl))) return -1;
+            return 1;
+        case NODE_BINARY_OP:
+            a = inline_size(func, AST_KID(node, binary.left));
+            b = inline_size(func, AST_KID(node, binary.right));
+            return (a < 0 || b < 0) ? -1 : a + b + 1;
+        case NODE_GET:
+            a = inline_size(func, AST_KID(node, get.obj));
+            return a < 0 ? -1 : a + 1;
+        case NODE_INDEX_GET:
+            a = inline_size(func, AST_KID(node, index_get.obj));
+            b = inline_size(func, AST_KID(node, index_get.index));
+            return (a < 0 || b < 0) ? -1 : a + b + 1;
+        case NODE_TERNARY:
+            a = inline_size(func, AST_KID(node, ternary.condition));
+            b = inline_size(func, AST_KID(node, ternary.true_expr));
+            c = inline_size(func, AST_KID(node, ternary.false_expr));
+            return (a < 0 || b < 0 || c < 0) ? -1 : a + b + c + 1;
+        case NODE_CALL: {
+            AstNode* callee = AST_KID(node, call.callee);
+            if (ast_type(callee) != NODE_VAR_ACCESS || callee->data.var_access.id != -1) return -1;
+            int total = 1;
+            for (AstNode* arg = AST_KID(node, call.args); arg; arg = AST_NEXT(arg)) {
+                a = inline_size(func, arg);
+                if (a < 0) return -1;
+                total += a;
+            }
+            return total;
+        }
+        default:
+            return -1;
+    }
+}
+
+// Arguments that can be evaluated late, or more than once, without changing the result
+static int is_trivial_arg(AstNode* arg) {
+    switch (ast_type(arg)) {
+        case NODE_LITERAL: case NODE_FLOAT: case NODE_BOOL: case NODE_NULL: case NODE_STRING:
+            return 1;
+        case NODE_VAR_ACCESS:
+            return arg->data.var_access.id > 0 && arg->data.var_access.decl &&
+                   !AST_KID(arg, var_access.decl)->data.var_decl.is_boxed;
+        default:
+            return 0;
+    }
+}
+
+AstNode* pgo_inline_target(AstNode* call, AstNode* program) {
+    if (pgo_mode != PGO_USE) return NULL;
+    AstNode* callee = AST_KID(call, call.callee);
+    if (ast_type(callee) != NODE_VAR_ACCESS || callee->data.var_access.id != -1) return NULL;
+    if (!pgo_is_hot(pgo_count(call, "call"))) return NULL;
+
+    AstNode* func = program;
+    while (func && !(ast_type(func) == NODE_FUNC_DECL && strcmp(func->data.func_decl.name, callee->data.var_access.name) == 0)) {
+        func = AST_NEXT(func);
+    }
+    if (!func || func->data.func_decl.is_closure || func->data.func_decl.upvalue_count > 0) return NULL;
+    if (site_func && strcmp(func->data.func_decl.name, site_func) == 0) return NULL;
+
+    AstNode* body = AST_KID(func, func_decl.body);
+    if (body && ast_type(body) == NODE_BLOCK) body = AST_KID(body, block.body);
+    if (!body || AST_NEXT(body) || ast_type(body) != NODE_RETURN || !body->data.return_stmt.expr) return NULL;
+
+    AstNode* p = AST_KID(func, func_decl.params);
+    AstNode* arg = AST_KID(call, call.args);
+    for (; p && arg; p = AST_NEXT(p), arg = AST_NEXT(arg)) {
+        if (p->data.var_decl.is_boxed || !is_trivial_arg(arg)) return NULL;
+    }
+    if (p || arg) return NULL;
+
+    int size = inline_size(func, AST_KID(body, return_stmt.expr));
+    return (size > 0 && size <= PGO_INLINE_MAX_NODES) ? func : NULL;
+}
+
+// --- Inline caches ---
+
+static int cache_count = 0;
+
+int pgo_new_cache(void) { return cache_count++; }
+int pgo_cache_count(void) { return cache_count; }
+
+void pgo_reset(void) {
+    free(descriptor);
+    descriptor = NULL;
+    descriptor_len = 0;
+    counter_count = 0;
+    cache_count = 0;
+    site_func = NULL;
+    site_count = 0;
+}
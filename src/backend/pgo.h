@@ -0,0 +1,62 @@
+/* Aria_lang/src/backend/pgo.h */
+#ifndef ARIA_PGO_H
+#define ARIA_PGO_H
+
+#include <stdint.h>
+#include "../frontend/ast.h"
+
+/*
+ * Profile-Guided Optimization
+ * ---------------------------
+ * --profile-generate builds a binary that counts function entries, branch
+ * directions, loop iterations, calls to the program's own functions and
+ * property reads, and writes the counts to a profile when it exits
+ * (runtime/profile.c). --profile-use <file> compiles the same source
+ * against that profile: functions are emitted hottest first, the likelier
+ * side of an if falls through, hot while loops are rotated so each
+ * iteration takes a single branch, hot calls to small expression functions
+ * are expanded in place, and hot property reads get an inline cache seeded
+ * with the slot the training run found.
+ *
+ * Counters are keyed by function name and the site's position in that
+ * function ("fib:2:then"), so a profile stays valid while a function is
+ * unchanged and only loses the sites of functions that were edited.
+ */
+
+typedef enum { PGO_OFF, PGO_GENERATE, PGO_USE } PgoMode;
+
+// Set from the command line (main.c)
+extern PgoMode pgo_mode;
+
+// Counter block and inline cache block emitted into instrumented / optimized objects
+#define PGO_COUNTERS_SYM "__aria_profile_counters"
+#define PGO_CACHES_SYM "__aria_inline_caches"
+
+// Reads a profile for PGO_USE. Returns 0 (with a message) if it cannot be read.
+int pgo_load(const char* path);
+
+// Numbers the profile sites of one function; call before generating its body
+void pgo_function(AstNode* func);
+
+// --- Instrumentation (PGO_GENERATE) ---
+// Index of the counter 'what' of 'site' (a function for "entry"); counters
+// are numbered in request order, so two requests in a row are adjacent
+int pgo_counter(AstNode* site, const char* what);
+int pgo_counter_count(void);
+// Newline-separated counter keys in counter order, for the runtime
+const char* pgo_descriptor(void);
+
+// --- Feedback (PGO_USE) ---
+// Count recorded for 'what' of 'site', 0 if the profile has none
+uint64_t pgo_count(AstNode* site, const char* what);
+// True for counts within a small factor of the hottest site of the program
+int pgo_is_hot(uint64_t count);
+// The function to expand in place of a hot call, or NULL
+AstNode* pgo_inline_target(AstNode* call, AstNode* program);
+// Index of a new inline cache slot, and the number handed out
+int pgo_new_cache(void);
+int pgo_cache_count(void);
+
+void pgo_reset(void);
+
+#endif
@@ -0,0 +1,335 @@
+/* Aria_lang/src/backend/x64.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "x64.h"
+#include "literal.h"
+
+static const char* REG64_NAMES[16] = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+// Destination names for 'mov reg, dword [..]', which zero-extends
+static const char* REG32_NAMES[16] = {
+    "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+    "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+
+static const char* OPCODE_NAMES[] = {
+    "mov", "lea", "push", "pop",
+    "add", "or", "and", "sub", "xor", "cmp", "test",
+    "call", "jmp",
+    "je", "jne", "jl", "jge", "jle", "jg", "jb", "jae",
+    "leave", "ret"
+};
+
+// Grows a dynamic array in place, doubling like the rest of the compiler's tables
+#define GROW(arr, count, cap, init) \
+    do { \
+        if ((count) >= (cap)) { \
+            (cap) = (cap) ? (cap) * 2 : (init); \
+            (arr) = realloc((arr), sizeof(*(arr)) * (cap)); \
+            if (!(arr)) { fprintf(stderr, "Fatal: Out of memory in x64 emitter.\n"); exit(1); } \
+        } \
+    } while (0)
+
+// --- Program Construction ---
+
+void x64_program_init(X64Program* prog) {
+    memset(prog, 0, sizeof(X64Program));
+}
+
+void x64_program_free(X64Program* prog) {
+    for (int i = 0; i < prog->rodata_count; i++) {
+        if (prog->rodata[i].owned) free((char*)prog->rodata[i].bytes);
+    }
+    free(prog->insts);
+    free(prog->rodata);
+    free(prog->globals);
+    free(prog->label_names);
+    free(prog->exports);
+    memset(prog, 0, sizeof(X64Program));
+}
+
+int x64_new_label(X64Program* prog, const char* prefix) {
+    GROW(prog->label_names, prog->label_count, prog->label_capacity, 256);
+    prog->label_names[prog->label_count] = prefix;
+    return prog->label_count++;
+}
+
+int x64_add_string(X64Program* prog, const char* str) {
+    GROW(prog->rodata, prog->rodata_count, prog->rodata_capacity, 64);
+    X64Data* d = &prog->rodata[prog->rodata_count++];
+    d->label = x64_new_label(prog, "str");
+    d->bytes = str;
+    d->len = strlen(str);
+    d->owned = 0;
+    d->header = 0;
+    return d->label;
+}
+
+int x64_add_literal(X64Program* prog, const char* str) {
+    int label = x64_add_string(prog, str);
+    prog->rodata[prog->rodata_count - 1].header = 1;
+    return label;
+}
+
+int x64_add_string_copy(X64Program* prog, const char* str) {
+    char* copy = strdup(str);
+    if (!copy) { fprintf(stderr, "Fatal: Out of memory in x64 emitter.\n"); exit(1); }
+    int label = x64_add_string(prog, copy);
+    prog->rodata[prog->rodata_count - 1].owned = 1;
+    return label;
+}
+
+void x64_add_global(X64Program* prog, const char* name) {
+    x64_add_global_block(prog, name, 1);
+}
+
+void x64_add_global_block(X64Program* prog, const char* name, int slots) {
+    GROW(prog->globals, prog->global_count, prog->global_capacity, 16);
+    prog->globals[prog->global_count].name = name;
+    prog->globals[prog->global_count].slots = slots;
+    prog->global_count++;
+}
+
+void x64_add_export(X64Program* prog, const char* name) {
+    GROW(prog->exports, prog->export_count, prog->export_capacity, 16);
+    prog->exports[prog->export_count++] = name;
+}
+
+void x64_emit(X64Program* prog, X64Opcode op, X64Operand a, X64Operand b) {
+    GROW(prog->insts, prog->count, prog->capacity, 1024);
+    X64Inst* inst = &prog->insts[prog->count++];
+    inst->op = op;
+    inst->a = a;
+    inst->b = b;
+}
+
+// --- Operand Constructors ---
+
+static X64Operand blank(X64OperandKind kind) {
+    X64Operand o;
+    memset(&o, 0, sizeof(o));
+    o.kind = kind;
+    o.reg = X64_NOREG;
+    o.index = X64_NOREG;
+    o.scale = 1;
+    o.label = -1;
+    o.size = 8;
+    return o;
+}
+
+X64Operand x64_none(void) { return blank(X64_OP_NONE); }
+
+X64Operand x64_reg(X64Reg reg) {
+    X64Operand o = blank(X64_OP_REG);
+    o.reg = reg;
+    return o;
+}
+
+X64Operand x64_imm(int64_t value) {
+    X64Operand o = blank(X64_OP_IMM);
+    o.imm = value;
+    return o;
+}
+
+X64Operand x64_mem(X64Reg base, int64_t disp) {
+    X64Operand o = blank(X64_OP_MEM);
+    o.reg = base;
+    o.imm = disp;
+    return o;
+}
+
+X64Operand x64_mem_index(X64Reg base, X64Reg index, int scale, int64_t disp) {
+    X64Operand o = x64_mem(base, disp);
+    o.index = index;
+    o.scale = scale;
+    return o;
+}
+
+X64Operand x64_mem32(X64Reg base, int64_t disp) {
+    X64Operand o = x64_mem(base, disp);
+    o.size = 4;
+    return o;
+}
+
+X64Operand x64_rip_sym(const char* sym) {
+    X64Operand o = blank(X64_OP_MEM);
+    o.sym = sym;
+    return o;
+}
+
+X64Operand x64_rip_label(int label) {
+    X64Operand o = blank(X64_OP_MEM);
+    o.label = label;
+    return o;
+}
+
+X64Operand x64_got(const char* sym) {
+    X64Operand o = x64_rip_sym(sym);
+    o.got = 1;
+    return o;
+}
+
+X64Operand x64_sym(const char* sym) {
+    X64Operand o = blank(X64_OP_SYM);
+    o.sym = sym;
+    return o;
+}
+
+X64Operand x64_label(int label) {
+    X64Operand o = blank(X64_OP_LABEL);
+    o.label = label;
+    return o;
+}
+
+const char* x64_reg_name(X64Reg reg) {
+    if (reg < 0 || reg > 15) return "???";
+    return REG64_NAMES[reg];
+}
+
+// --- NASM Printer ---
+
+/*
+ * Labels print as '..@prefix_N': NASM treats '..@' names as non-local, so
+ * they neither attach to nor reset the enclosing function's label scope, and
+ * they can never collide with Aria identifiers.
+ */
+static void print_label_name(X64Program* prog, FILE* out, int label) {
+    const char* prefix = (label >= 0 && label < prog->label_count) ? prog->label_names[label] : "L";
+    fprintf(out, "..@%s_%d", prefix, label);
+}
+
+static void print_operand(X64Program* prog, FILE* out, X64Operand* o) {
+    switch (o->kind) {
+        case X64_OP_REG: fputs(x64_reg_name(o->reg), out); break;
+        case X64_OP_IMM: fprintf(out, "%lld", (long long)o->imm); break;
+        case X64_OP_SYM: fputs(o->sym, out); break;
+        case X64_OP_LABEL: print_label_name(prog, out, o->label); break;
+        case X64_OP_MEM:
+            fputs(o->size == 4 ? "dword [" : "qword [", out);
+            if (o->reg == X64_NOREG) {
+                fputs("rel ", out);
+                if (o->sym) fputs(o->sym, out);
+                else print_label_name(prog, out, o->label);
+                if (o->got) fputs(" wrt ..gotpc", out);
+            } else {
+                fputs(x64_reg_name(o->reg), out);
+                if (o->index != X64_NOREG) fprintf(out, " + %s*%d", x64_reg_name(o->index), o->scale);
+            }
+            if (o->imm > 0) fprintf(out, " + %lld", (long long)o->imm);
+            else if (o->imm < 0) fprintf(out, " - %lld", -(long long)o->imm);
+            fputc(']', out);
+            break;
+        default: break;
+    }
+}
+
+// Small string set for the printer's extern computation (FNV-1a, open addressing)
+typedef struct {
+    const char** slots;
+    size_t mask;
+} NameSet;
+
+static void nameset_init(NameSet* set, size_t expected) {
+    size_t cap = 64;
+    while (cap < expected * 2) cap *= 2;
+    set->slots = calloc(cap, sizeof(const char*));
+    if (!set->slots) { fprintf(stderr, "Fatal: Out of memory in x64 emitter.\n"); exit(1); }
+    set->mask = cap - 1;
+}
+
+// Returns 1 if the name was newly inserted
+static int nameset_add(NameSet* set, const char* name) {
+    uint32_t h = 2166136261u;
+    for (const char* p = name; *p; p++) { h ^= (uint8_t)*p; h *= 16777619u; }
+    size_t i = h & set->mask;
+    while (set->slots[i]) {
+        if (strcmp(set->slots[i], name) == 0) return 0;
+        i = (i + 1) & set->mask;
+    }
+    set->slots[i] = name;
+    return 1;
+}
+
+void x64_print_nasm(X64Program* prog, FILE* out) {
+    // NASM requires every undefined symbol to be declared extern
+    NameSet seen;
+    nameset_init(&seen, (size_t)prog->count + prog->global_count);
+    for (int i = 0; i < prog->count; i++) {
+        if (prog->insts[i].op == X64_FUNC) nameset_add(&seen, prog->insts[i].a.sym);
+    }
+    for (int i = 0; i < prog->global_count; i++) nameset_add(&seen, prog->globals[i].name);
+
+    for (int i = 0; i < prog->export_count; i++) fprintf(out, "global %s\n", prog->exports[i]);
+    for (int i = 0; i < prog->count; i++) {
+        X64Inst* in = &prog->insts[i];
+        if (in->op == X64_FUNC || in->op == X64_LABEL) continue;
+        if (in->a.sym && nameset_add(&seen, in->a.sym)) fprintf(out, "extern %s\n", in->a.sym);
+        if (in->b.sym && nameset_add(&seen, in->b.sym)) fprintf(out, "extern %s\n", in->b.sym);
+    }
+    free(seen.slots);
+
+    fprintf(out, "section .text\n");
+    for (int i = 0; i < prog->count; i++) {
+        X64Inst* in = &prog->insts[i];
+        if (in->op == X64_FUNC) { fprintf(out, "%s:\n", in->a.sym); continue; }
+        if (in->op == X64_LABEL) { print_label_name(prog, out, in->a.label); fputs(":\n", out); continue; }
+        // NASM has no CFI directives; --nasm objects carry line tables only
+        if (in->op == X64_CFI) continue;
+        if (in->op == X64_LINE) {
+            if (prog->source_file) fprintf(out, "%%line %d+0 %s\n", (int)in->a.imm, prog->source_file);
+            continue;
+        }
+        if (in->op == X64_CASE) {
+            fputs("    dd ", out);
+            print_label_name(prog, out, in->a.label);
+            fputs(" - ", out);
+            print_label_name(prog, out, in->b.label);
+            fputc('\n', out);
+            continue;
+        }
+
+        fprintf(out, "    %s", OPCODE_NAMES[in->op]);
+        if (in->a.kind == X64_OP_REG && in->b.kind == X64_OP_MEM && in->b.size == 4) {
+            fprintf(out, " %s", REG32_NAMES[in->a.reg & 15]);
+        } else if (in->a.kind != X64_OP_NONE) {
+            fputc(' ', out);
+            print_operand(prog, out, &in->a);
+            if (in->op == X64_CALL && in->a.kind == X64_OP_SYM) fputs(" wrt ..plt", out);
+        }
+        if (in->b.kind != X64_OP_NONE) {
+            fputs(", ", out);
+            print_operand(prog, out, &in->b);
+        }
+        fputc('\n', out);
+    }
+
+    if (prog->rodata_count > 0) {
+        fprintf(out, "section .rodata align=8\n");
+        for (int i = 0; i < prog->rodata_count; i++) {
+            X64Data* d = &prog->rodata[i];
+            if (d->header) {
+                unsigned char h[LITERAL_HEADER_SIZE];
+                literal_header(d->bytes, d->len, h);
+                fputs("align 8\ndb ", out);
+                for (int j = 0; j < LITERAL_HEADER_SIZE; j++) fprintf(out, "%d%s", h[j], j + 1 < LITERAL_HEADER_SIZE ? "," : "\n");
+            }
+            print_label_name(prog, out, d->label);
+            fputs(": db ", out);
+            for (size_t j = 0; j < d->len; j++) fprintf(out, "%d,", (unsigned char)d->bytes[j]);
+            fputs("0\n", out);
+        }
+    }
+
+    if (prog->global_count > 0) {
+        fprintf(out, "section .data\n");
+        for (int i = 0; i < prog->global_count; i++) {
+            if (prog->globals[i].slots == 1) fprintf(out, "%s: dq 0\n", prog->globals[i].name);
+            else fprintf(out, "%s: times %d dq 0\n", prog->globals[i].name, prog->globals[i].slots);
+        }
+    }
+    fprintf(out, "section .note.GNU-stack noalloc noexec nowrite progbits\n");
+}
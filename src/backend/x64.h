@@ -0,0 +1,219 @@
+/* Aria_lang/src/backend/x64.h */
+#ifndef X64_H
+#define X64_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * x86-64 Instruction Representation
+ * ---------------------------------
+ * Codegen appends structured instructions to an X64Program instead of
+ * printing NASM text. The program is then either encoded straight to
+ * machine code and written as an ELF64 relocatable object (x64_encoder.c,
+ * elf_writer.c) or printed as NASM source for debugging (x64_print_nasm).
+ *
+ * Symbol references are always position independent: calls go through
+ * PLT32, local data/code through RIP-relative PC32, and addresses of
+ * external symbols through the GOT. Objects therefore link into default PIE
+ * executables.
+ *
+ * Codegen also marks source lines (X64_LINE) and frame changes (X64_CFI)
+ * between instructions. The encoder turns them into DWARF line tables and
+ * .eh_frame unwind info (dwarf.c) so debuggers and profilers can map
+ * addresses back to Aria functions and lines.
+ */
+
+// Hardware register numbers (ModRM/REX encoding order)
+typedef enum {
+    X64_RAX = 0, X64_RCX, X64_RDX, X64_RBX, X64_RSP, X64_RBP, X64_RSI, X64_RDI,
+    X64_R8, X64_R9, X64_R10, X64_R11, X64_R12, X64_R13, X64_R14, X64_R15,
+    X64_NOREG = -1
+} X64Reg;
+
+typedef enum {
+    X64_OP_NONE = 0,
+    X64_OP_REG,      // 64-bit register
+    X64_OP_IMM,      // immediate
+    X64_OP_MEM,      // [base + index*scale + disp] or [rel target + disp]
+    X64_OP_SYM,      // code symbol (call/jmp target)
+    X64_OP_LABEL     // local label (jump target)
+} X64OperandKind;
+
+typedef struct {
+    X64OperandKind kind;
+    X64Reg reg;          // REG: register; MEM: base (X64_NOREG for RIP-relative)
+    X64Reg index;        // MEM: index register or X64_NOREG
+    int scale;           // MEM: 1, 2, 4 or 8
+    int64_t imm;         // IMM: value; MEM: displacement
+    const char* sym;     // MEM (RIP-relative) / SYM: symbol name
+    int label;           // MEM (RIP-relative) / LABEL: label id, -1 if unused
+    int size;            // MEM: access width in bytes (8 or 4)
+    int got;             // MEM: load the symbol's address from the GOT
+} X64Operand;
+
+typedef enum {
+    X64_MOV, X64_LEA, X64_PUSH, X64_POP,
+    X64_ADD, X64_OR, X64_AND, X64_SUB, X64_XOR, X64_CMP, X64_TEST,
+    X64_CALL, X64_JMP,
+    X64_JE, X64_JNE, X64_JL, X64_JGE, X64_JLE, X64_JG, X64_JB, X64_JAE,
+    X64_LEAVE, X64_RET,
+    // Pseudo instructions
+    X64_LABEL,       // a: LABEL operand, defines a local label here
+    X64_FUNC,        // a: SYM operand, defines a function symbol here
+    X64_CASE,        // a: LABEL target, b: LABEL table; jump table entry 'dd target - table'
+                     // (targets follow the table, so entries load zero-extended)
+    X64_LINE,        // a: IMM source line of the code that follows
+    X64_CFI          // a: IMM X64Cfi, the frame change made by the preceding instruction
+} X64Opcode;
+
+// Frame changes, in the order a function makes them
+typedef enum {
+    X64_CFI_PUSH_RBP,    // push rbp: CFA = rsp + 16, caller's rbp at CFA - 16
+    X64_CFI_SET_RBP,     // mov rbp, rsp: CFA = rbp + 16
+    X64_CFI_LEAVE,       // leave: CFA = rsp + 8, rbp restored
+    X64_CFI_RET          // ret: code after it is back in the frame of the body
+} X64Cfi;
+
+typedef struct {
+    X64Opcode op;
+    X64Operand a;
+    X64Operand b;
+} X64Inst;
+
+typedef struct {
+    int label;           // .rodata label id
+    const char* bytes;
+    size_t len;          // excluding the terminating NUL that is always emitted
+    int owned;           // bytes is a private copy freed with the program
+    int header;          // preceded by an 8-aligned string header (literal.h)
+} X64Data;
+
+typedef struct {
+    const char* name;
+    int slots;           // zero-initialized 8-byte words
+} X64Global;
+
+typedef struct {
+    X64Inst* insts;
+    int count;
+    int capacity;
+
+    X64Data* rodata;     // NUL-terminated string constants
+    int rodata_count;
+    int rodata_capacity;
+
+    X64Global* globals;      // zero-initialized .data blocks
+    int global_count;
+    int global_capacity;
+
+    const char** label_names; // label id -> descriptive prefix for the text printer
+    int label_count;
+    int label_capacity;
+
+    const char** exports;    // symbols marked global (at least "main")
+    int export_count;
+    int export_capacity;
+
+    const char* source_file; // named by the debug info, NULL to omit it
+} X64Program;
+
+// --- Program construction ---
+void x64_program_init(X64Program* prog);
+void x64_program_free(X64Program* prog);
+int x64_new_label(X64Program* prog, const char* prefix);
+int x64_add_string(X64Program* prog, const char* str);
+int x64_add_string_copy(X64Program* prog, const char* str);  // for strings that do not outlive codegen
+int x64_add_literal(X64Program* prog, const char* str);      // with a runtime string header
+void x64_add_global(X64Program* prog, const char* name);
+void x64_add_global_block(X64Program* prog, const char* name, int slots);
+void x64_add_export(X64Program* prog, const char* name);
+void x64_emit(X64Program* prog, X64Opcode op, X64Operand a, X64Operand b);
+
+// --- Operand constructors ---
+X64Operand x64_none(void);
+X64Operand x64_reg(X64Reg reg);
+X64Operand x64_imm(int64_t value);
+X64Operand x64_mem(X64Reg base, int64_t disp);
+X64Operand x64_mem_index(X64Reg base, X64Reg index, int scale, int64_t disp);
+X64Operand x64_mem32(X64Reg base, int64_t disp);
+X64Operand x64_rip_sym(const char* sym);      // [rel sym]
+X64Operand x64_rip_label(int label);          // [rel label]
+X64Operand x64_got(const char* sym);          // [rel sym wrt ..gotpc]
+X64Operand x64_sym(const char* sym);
+X64Operand x64_label(int label);
+
+const char* x64_reg_name(X64Reg reg);
+
+// --- Output ---
+// Writes NASM source equivalent to the encoded object (debug path)
+void x64_print_nasm(X64Program* prog, FILE* out);
+
+typedef struct {
+    uint64_t offset;     // offset inside the section being relocated
+    uint32_t type;       // R_X86_64_*
+    int64_t addend;
+    const char* sym;     // target symbol, or NULL for a section-relative target
+    int section;         // when sym == NULL: X64_SEC_TEXT / X64_SEC_RODATA / X64_SEC_DATA
+    int64_t section_offset;
+} X64Reloc;
+
+enum {
+    X64_SEC_TEXT = 0, X64_SEC_RODATA, X64_SEC_DATA,
+    // Built by dwarf.c from the line and frame records
+    X64_SEC_DEBUG_INFO, X64_SEC_DEBUG_ABBREV, X64_SEC_DEBUG_LINE, X64_SEC_EH_FRAME,
+    X64_SEC_COUNT
+};
+#define X64_SEC_FIRST_DEBUG X64_SEC_DEBUG_INFO
+#define X64_DEBUG_SEC_COUNT (X64_SEC_COUNT - X64_SEC_FIRST_DEBUG)
+
+typedef struct {
+    const char* name;
+    int section;         // X64_SEC_* or -1 when undefined
+    uint64_t value;
+    uint64_t size;
+    int is_global;
+    int is_func;
+} X64Symbol;
+
+typedef struct {
+    uint64_t text_offset;
+    int line;
+} X64LineRow;
+
+typedef struct {
+    uint64_t text_offset;    // just after the instruction that changed the frame
+    X64Cfi cfi;
+} X64CfiRow;
+
+// A debug section and the relocations applied to it
+typedef struct {
+    uint8_t* data; size_t len; size_t cap;
+    X64Reloc* relocs; int reloc_count; int reloc_cap;
+} X64DebugSection;
+
+typedef struct {
+    uint8_t* text;   size_t text_len;   size_t text_cap;
+    uint8_t* rodata; size_t rodata_len; size_t rodata_cap;
+    size_t data_len;
+
+    X64Reloc* relocs; int reloc_count; int reloc_cap;
+    X64Symbol* symbols; int symbol_count; int symbol_cap;
+
+    X64LineRow* lines; int line_count; int line_cap;
+    X64CfiRow* cfis; int cfi_count; int cfi_cap;
+    X64DebugSection debug[X64_DEBUG_SEC_COUNT];   // indexed by X64_SEC_* - X64_SEC_FIRST_DEBUG
+} X64Object;
+
+// Encodes the program into machine code; returns 0 on failure (message on stderr)
+int x64_encode(X64Program* prog, X64Object* obj);
+void x64_object_free(X64Object* obj);
+
+// Fills obj->debug from its line and frame records (dwarf.c)
+void dwarf_build(X64Object* obj, const char* source_file);
+
+// Writes an ELF64 relocatable object; returns 0 on failure
+int elf_write_object(X64Object* obj, const char* path);
+
+#endif
@@ -0,0 +1,484 @@
+/* Aria_lang/src/backend/x64_encoder.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "x64.h"
+#include "literal.h"
+
+/*
+ * x86-64 Machine Code Encoder
+ * ---------------------------
+ * Single pass over the X64Program. Branches to local labels always use the
+ * rel32 forms so instruction sizes never depend on label positions; their
+ * displacements are patched once every label is placed. Everything that
+ * crosses a section or names a symbol becomes an ELF relocation.
+ */
+
+#define R_X86_64_PC32     2
+#define R_X86_64_PLT32    4
+#define R_X86_64_GOTPCREL 9
+
+typedef struct {
+    size_t pos;      // offset of the rel32 field in .text
+    int label;
+    int trailing;    // bytes of instruction following the rel32 field
+    int base;        // jump table entries: label the offset is taken from, else -1
+} LabelFixup;
+
+typedef struct {
+    int section;     // X64_SEC_* or -1 while unplaced
+    uint64_t offset;
+} LabelDef;
+
+static X64Object* out;
+static LabelDef* label_defs;
+static LabelFixup* fixups;
+static int fixup_count;
+static int fixup_cap;
+
+// --- Buffers ---
+
+static void text_reserve(size_t n) {
+    if (out->text_len + n <= out->text_cap) return;
+    size_t cap = out->text_cap ? out->text_cap : 4096;
+    while (cap < out->text_len + n) cap *= 2;
+    out->text = realloc(out->text, cap);
+    if (!out->text) { fprintf(stderr, "Fatal: Out of memory in x64 encoder.\n"); exit(1); }
+    out->text_cap = cap;
+}
+
+static void emit8(uint8_t b) {
+    text_reserve(1);
+    out->text[out->text_len++] = b;
+}
+
+static void emit32(uint32_t v) {
+    text_reserve(4);
+    for (int i = 0; i < 4; i++) out->text[out->text_len++] = (uint8_t)(v >> (i * 8));
+}
+
+static void emit64(uint64_t v) {
+    text_reserve(8);
+    for (int i = 0; i < 8; i++) out->text[out->text_len++] = (uint8_t)(v >> (i * 8));
+}
+
+static void patch32(size_t pos, uint32_t v) {
+    for (int i = 0; i < 4; i++) out->text[pos + i] = (uint8_t)(v >> (i * 8));
+}
+
+static void add_reloc(uint64_t offset, uint32_t type, int64_t addend, const char* sym, int section, int64_t section_offset) {
+    if (out->reloc_count >= out->reloc_cap) {
+        out->reloc_cap = out->reloc_cap ? out->reloc_cap * 2 : 256;
+        out->relocs = realloc(out->relocs, sizeof(X64Reloc) * out->reloc_cap);
+        if (!out->relocs) { fprintf(stderr, "Fatal: Out of memory in x64 encoder.\n"); exit(1); }
+    }
+    X64Reloc* r = &out->relocs[out->reloc_count++];
+    r->offset = offset;
+    r->type = type;
+    r->addend = addend;
+    r->sym = sym;
+    r->section = section;
+    r->section_offset = section_offset;
+}
+
+static X64Symbol* add_symbol(const char* name, int section, uint64_t value, int is_global, int is_func) {
+    if (out->symbol_count >= out->symbol_cap) {
+        out->symbol_cap = out->symbol_cap ? out->symbol_cap * 2 : 64;
+        out->symbols = realloc(out->symbols, sizeof(X64Symbol) * out->symbol_cap);
+        if (!out->symbols) { fprintf(stderr, "Fatal: Out of memory in x64 encoder.\n"); exit(1); }
+    }
+    X64Symbol* s = &out->symbols[out->symbol_count++];
+    s->name = name;
+    s->section = section;
+    s->value = value;
+    s->size = 0;
+    s->is_global = is_global;
+    s->is_func = is_func;
+    return s;
+}
+
+static void add_line(int line) {
+    // Code for a line that produced no instructions is covered by the next row
+    if (out->line_count > 0 && out->lines[out->line_count - 1].text_offset == out->text_len) {
+        out->lines[out->line_count - 1].line = line;
+        return;
+    }
+    if (out->line_count > 0 && out->lines[out->line_count - 1].line == line) return;
+    if (out->line_count >= out->line_cap) {
+        out->line_cap = out->line_cap ? out->line_cap * 2 : 256;
+        out->lines = realloc(out->lines, sizeof(X64LineRow) * out->line_cap);
+        if (!out->lines) { fprintf(stderr, "Fatal: Out of memory in x64 encoder.\n"); exit(1); }
+    }
+    out->lines[out->line_count].text_offset = out->text_len;
+    out->lines[out->line_count].line = line;
+    out->line_count++;
+}
+
+static void add_cfi(X64Cfi cfi) {
+    if (out->cfi_count >= out->cfi_cap) {
+        out->cfi_cap = out->cfi_cap ? out->cfi_cap * 2 : 256;
+        out->cfis = realloc(out->cfis, sizeof(X64CfiRow) * out->cfi_cap);
+        if (!out->cfis) { fprintf(stderr, "Fatal: Out of memory in x64 encoder.\n"); exit(1); }
+    }
+    out->cfis[out->cfi_count].text_offset = out->text_len;
+    out->cfis[out->cfi_count].cfi = cfi;
+    out->cfi_count++;
+}
+
+static void add_fixup(size_t pos, int label, int trailing) {
+    if (fixup_count >= fixup_cap) {
+        fixup_cap = fixup_cap ? fixup_cap * 2 : 256;
+        fixups = realloc(fixups, sizeof(LabelFixup) * fixup_cap);
+        if (!fixups) { fprintf(stderr, "Fatal: Out of memory in x64 encoder.\n"); exit(1); }
+    }
+    fixups[fixup_count].pos = pos;
+    fixups[fixup_count].label = label;
+    fixups[fixup_count].trailing = trailing;
+    fixups[fixup_count].base = -1;
+    fixup_count++;
+}
+
+// --- Encoding Helpers ---
+
+static int fits_i8(int64_t v) { return v >= -128 && v <= 127; }
+static int fits_i32(int64_t v) { return v >= INT32_MIN && v <= INT32_MAX; }
+
+// REX prefix: W = 64-bit operand, R/X/B extend ModRM.reg, SIB.index, ModRM.rm/base
+static void emit_rex(int w, int reg, int index, int base) {
+    uint8_t rex = 0x40;
+    if (w) rex |= 0x08;
+    if (reg >= 8) rex |= 0x04;
+    if (index >= 8) rex |= 0x02;
+    if (base >= 8) rex |= 0x01;
+    if (rex != 0x40) emit8(rex);
+}
+
+static void emit_rex_mem(int w, int reg, X64Operand* m) {
+    emit_rex(w, reg, m->index == X64_NOREG ? 0 : m->index, m->reg == X64_NOREG ? 0 : m->reg);
+}
+
+static void emit_modrm_reg(int reg, int rm) {
+    emit8((uint8_t)(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+/*
+ * ModRM (+SIB, +disp) for a memory operand. 'trailing' is the number of
+ * immediate bytes that follow, which RIP-relative displacements must account
+ * for since the CPU measures them from the end of the instruction.
+ */
+static int emit_modrm_mem(int reg, X64Operand* m, int trailing) {
+    if (m->reg == X64_NOREG) {
+        emit8((uint8_t)(((reg & 7) << 3) | 5));
+        size_t pos = out->text_len;
+        emit32(0);
+        int64_t addend = m->imm - 4 - trailing;
+        if (m->sym) {
+            add_reloc(pos, m->got ? R_X86_64_GOTPCREL : R_X86_64_PC32, addend, m->sym, 0, 0);
+        } else {
+            LabelDef* def = &label_defs[m->label];
+            if (def->section == X64_SEC_TEXT || def->section < 0) {
+                // Code labels are resolved locally once placed
+                add_fixup(pos, m->label, trailing);
+                if (m->imm) {
+                    fprintf(stderr, "Encoder Error: displacement on code label reference.\n");
+                    return 0;
+                }
+            } else {
+                add_reloc(pos, R_X86_64_PC32, addend, NULL, def->section, (int64_t)def->offset);
+            }
+        }
+        return 1;
+    }
+
+    int base = m->reg & 7;
+    int need_sib = (m->index != X64_NOREG) || base == 4;
+    int mod;
+    if (m->imm == 0 && base != 5) mod = 0;
+    else if (fits_i8(m->imm)) mod = 1;
+    else if (fits_i32(m->imm)) mod = 2;
+    else {
+        fprintf(stderr, "Encoder Error: displacement out of range.\n");
+        return 0;
+    }
+
+    if (need_sib) {
+        int ss = m->scale == 8 ? 3 : m->scale == 4 ? 2 : m->scale == 2 ? 1 : 0;
+        int index = m->index == X64_NOREG ? 4 : (m->index & 7);
+        if (m->index == X64_RSP) {
+            fprintf(stderr, "Encoder Error: rsp cannot be an index register.\n");
+            return 0;
+        }
+        emit8((uint8_t)((mod << 6) | ((reg & 7) << 3) | 4));
+        emit8((uint8_t)((ss << 6) | (index << 3) | base));
+    } else {
+        emit8((uint8_t)((mod << 6) | ((reg & 7) << 3) | base));
+    }
+
+    if (mod == 1) emit8((uint8_t)(int8_t)m->imm);
+    else if (mod == 2) emit32((uint32_t)(int32_t)m->imm);
+    return 1;
+}
+
+// Opcode with a ModRM 'reg' field (register or /digit) and a reg-or-mem rm operand
+static int emit_op_rm(int w, uint8_t opcode, int reg, X64Operand* rm, int trailing) {
+    if (rm->kind == X64_OP_REG) {
+        emit_rex(w, reg, 0, rm->reg);
+        emit8(opcode);
+        emit_modrm_reg(reg, rm->reg);
+        return 1;
+    }
+    emit_rex_mem(w, reg, rm);
+    emit8(opcode);
+    return emit_modrm_mem(reg, rm, trailing);
+}
+
+static void emit_label_rel32(int label) {
+    size_t pos = out->text_len;
+    emit32(0);
+    add_fixup(pos, label, 0);
+}
+
+// --- Instruction Encoders ---
+
+static int encode_mov(X64Operand* a, X64Operand* b) {
+    if (a->kind == X64_OP_REG && b->kind == X64_OP_IMM) {
+        int64_t v = b->imm;
+        if (v >= 0 && v <= 0xFFFFFFFFLL) {
+            // mov r32, imm32 zero-extends into the full register
+            emit_rex(0, 0, 0, a->reg);
+            emit8((uint8_t)(0xB8 + (a->reg & 7)));
+            emit32((uint32_t)v);
+        } else if (fits_i32(v)) {
+            emit_rex(1, 0, 0, a->reg);
+            emit8(0xC7);
+            emit_modrm_reg(0, a->reg);
+            emit32((uint32_t)(int32_t)v);
+        } else {
+            emit_rex(1, 0, 0, a->reg);
+            emit8((uint8_t)(0xB8 + (a->reg & 7)));
+            emit64((uint64_t)v);
+        }
+        return 1;
+    }
+    if (a->kind == X64_OP_REG && b->kind == X64_OP_REG) {
+        return emit_op_rm(1, 0x89, b->reg, a, 0);
+    }
+    if (a->kind == X64_OP_REG && b->kind == X64_OP_MEM) {
+        return emit_op_rm(b->size == 8, 0x8B, a->reg, b, 0);
+    }
+    if (a->kind == X64_OP_MEM && b->kind == X64_OP_REG) {
+        return emit_op_rm(a->size == 8, 0x89, b->reg, a, 0);
+    }
+    if (a->kind == X64_OP_MEM && b->kind == X64_OP_IMM) {
+        if (!fits_i32(b->imm)) {
+            fprintf(stderr, "Encoder Error: 64-bit immediate store to memory.\n");
+            return 0;
+        }
+        if (!emit_op_rm(a->size == 8, 0xC7, 0, a, 4)) return 0;
+        emit32((uint32_t)(int32_t)b->imm);
+        return 1;
+    }
+    fprintf(stderr, "Encoder Error: unsupported mov operands.\n");
+    return 0;
+}
+
+// ALU group: add/or/and/sub/xor/cmp share encodings, differing in /digit
+static int encode_alu(int digit, X64Operand* a, X64Operand* b) {
+    uint8_t base = (uint8_t)(digit << 3);
+    if (b->kind == X64_OP_IMM) {
+        int w = a->kind == X64_OP_REG || a->size == 8;
+        if (fits_i8(b->imm)) {
+            if (!emit_op_rm(w, 0x83, digit, a, 1)) return 0;
+            emit8((uint8_t)(int8_t)b->imm);
+        } else if (fits_i32(b->imm)) {
+            if (!emit_op_rm(w, 0x81, digit, a, 4)) return 0;
+            emit32((uint32_t)(int32_t)b->imm);
+        } else {
+            fprintf(stderr, "Encoder Error: ALU immediate out of range.\n");
+            return 0;
+        }
+        return 1;
+    }
+    if (b->kind == X64_OP_REG) {
+        return emit_op_rm(a->kind == X64_OP_REG || a->size == 8, (uint8_t)(base | 0x01), b->reg, a, 0);
+    }
+    if (a->kind == X64_OP_REG && b->kind == X64_OP_MEM) {
+        return emit_op_rm(b->size == 8, (uint8_t)(base | 0x03), a->reg, b, 0);
+    }
+    fprintf(stderr, "Encoder Error: unsupported ALU operands.\n");
+    return 0;
+}
+
+static int encode_jcc(X64Opcode op, X64Operand* a) {
+    static const uint8_t CC[] = {
+        0x84, 0x85, 0x8C, 0x8D, 0x8E, 0x8F, 0x82, 0x83   // e ne l ge le g b ae
+    };
+    if (a->kind != X64_OP_LABEL) {
+        fprintf(stderr, "Encoder Error: conditional jump needs a label.\n");
+        return 0;
+    }
+    emit8(0x0F);
+    emit8(CC[op - X64_JE]);
+    emit_label_rel32(a->label);
+    return 1;
+}
+
+static int encode_inst(X64Inst* in) {
+    X64Operand* a = &in->a;
+    X64Operand* b = &in->b;
+    switch (in->op) {
+        case X64_MOV: return encode_mov(a, b);
+        case X64_LEA:
+            if (a->kind != X64_OP_REG || b->kind != X64_OP_MEM) break;
+            return emit_op_rm(1, 0x8D, a->reg, b, 0);
+        case X64_PUSH:
+            if (a->kind != X64_OP_REG) break;
+            emit_rex(0, 0, 0, a->reg);
+            emit8((uint8_t)(0x50 + (a->reg & 7)));
+            return 1;
+        case X64_POP:
+            if (a->kind != X64_OP_REG) break;
+            emit_rex(0, 0, 0, a->reg);
+            emit8((uint8_t)(0x58 + (a->reg & 7)));
+            return 1;
+        case X64_ADD: return encode_alu(0, a, b);
+        case X64_OR:  return encode_alu(1, a, b);
+        case X64_AND: return encode_alu(4, a, b);
+        case X64_SUB: return encode_alu(5, a, b);
+        case X64_XOR: return encode_alu(6, a, b);
+        case X64_CMP: return encode_alu(7, a, b);
+        case X64_TEST:
+            if (b->kind != X64_OP_REG) break;
+            return emit_op_rm(a->kind == X64_OP_REG || a->size == 8, 0x85, b->reg, a, 0);
+        case X64_CALL:
+            if (a->kind == X64_OP_SYM) {
+                emit8(0xE8);
+                add_reloc(out->text_len, R_X86_64_PLT32, -4, a->sym, 0, 0);
+                emit32(0);
+                return 1;
+            }
+            if (a->kind == X64_OP_REG || a->kind == X64_OP_MEM) return emit_op_rm(0, 0xFF, 2, a, 0);
+            break;
+        case X64_JMP:
+            if (a->kind == X64_OP_LABEL) {
+                emit8(0xE9);
+                emit_label_rel32(a->label);
+                return 1;
+            }
+            if (a->kind == X64_OP_REG || a->kind == X64_OP_MEM) return emit_op_rm(0, 0xFF, 4, a, 0);
+            break;
+        case X64_JE: case X64_JNE: case X64_JL: case X64_JGE:
+        case X64_JLE: case X64_JG: case X64_JB: case X64_JAE:
+            return encode_jcc(in->op, a);
+        case X64_CASE:
+            if (a->kind != X64_OP_LABEL || b->kind != X64_OP_LABEL) break;
+            emit_label_rel32(a->label);
+            fixups[fixup_count - 1].base = b->label;
+            return 1;
+        case X64_LEAVE: emit8(0xC9); return 1;
+        case X64_RET: emit8(0xC3); return 1;
+        default: break;
+    }
+    fprintf(stderr, "Encoder Error: unsupported operands for opcode %d.\n", in->op);
+    return 0;
+}
+
+// --- Driver ---
+
+static int is_exported(X64Program* prog, const char* name) {
+    for (int i = 0; i < prog->export_count; i++) {
+        if (strcmp(prog->exports[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+int x64_encode(X64Program* prog, X64Object* obj) {
+    memset(obj, 0, sizeof(X64Object));
+    out = obj;
+    fixup_count = 0;
+    label_defs = malloc(sizeof(LabelDef) * (prog->label_count + 1));
+    if (!label_defs) { fprintf(stderr, "Fatal: Out of memory in x64 encoder.\n"); exit(1); }
+    for (int i = 0; i < prog->label_count; i++) label_defs[i].section = -1;
+
+    // .rodata is laid out first so references to it are known section offsets
+    // String literals get their runtime header (literal.h) on an 8-byte boundary
+    size_t ro_len = 0;
+    for (int i = 0; i < prog->rodata_count; i++) {
+        ro_len += prog->rodata[i].len + 1;
+        if (prog->rodata[i].header) ro_len += 7 + LITERAL_HEADER_SIZE;
+    }
+    obj->rodata = malloc(ro_len ? ro_len : 1);
+    obj->rodata_cap = ro_len;
+    for (int i = 0; i < prog->rodata_count; i++) {
+        X64Data* d = &prog->rodata[i];
+        if (d->header) {
+            while (obj->rodata_len % 8) obj->rodata[obj->rodata_len++] = 0;
+            literal_header(d->bytes, d->len, (unsigned char*)obj->rodata + obj->rodata_len);
+            obj->rodata_len += LITERAL_HEADER_SIZE;
+        }
+        label_defs[d->label].section = X64_SEC_RODATA;
+        label_defs[d->label].offset = obj->rodata_len;
+        memcpy(obj->rodata + obj->rodata_len, d->bytes, d->len);
+        obj->rodata[obj->rodata_len + d->len] = 0;
+        obj->rodata_len += d->len + 1;
+    }
+
+    for (int i = 0; i < prog->global_count; i++) {
+        X64Global* g = &prog->globals[i];
+        X64Symbol* s = add_symbol(g->name, X64_SEC_DATA, obj->data_len, is_exported(prog, g->name), 0);
+        s->size = 8 * (uint64_t)g->slots;
+        obj->data_len += s->size;
+    }
+
+    int ok = 1;
+    X64Symbol* cur_func = NULL;
+    for (int i = 0; i < prog->count && ok; i++) {
+        X64Inst* in = &prog->insts[i];
+        if (in->op == X64_FUNC) {
+            if (cur_func) cur_func->size = obj->text_len - cur_func->value;
+            cur_func = add_symbol(in->a.sym, X64_SEC_TEXT, obj->text_len, is_exported(prog, in->a.sym), 1);
+            continue;
+        }
+        if (in->op == X64_LABEL) {
+            label_defs[in->a.label].section = X64_SEC_TEXT;
+            label_defs[in->a.label].offset = obj->text_len;
+            continue;
+        }
+        if (in->op == X64_LINE) { add_line((int)in->a.imm); continue; }
+        if (in->op == X64_CFI) { add_cfi((X64Cfi)in->a.imm); continue; }
+        ok = encode_inst(in);
+    }
+    if (cur_func) cur_func->size = obj->text_len - cur_func->value;
+
+    for (int i = 0; i < fixup_count && ok; i++) {
+        LabelFixup* f = &fixups[i];
+        if (label_defs[f->label].section != X64_SEC_TEXT) {
+            fprintf(stderr, "Encoder Error: undefined label %d.\n", f->label);
+            ok = 0;
+            break;
+        }
+        int64_t rel = (int64_t)label_defs[f->label].offset - (int64_t)(f->pos + 4 + f->trailing);
+        if (f->base >= 0) rel = (int64_t)label_defs[f->label].offset - (int64_t)label_defs[f->base].offset;
+        patch32(f->pos, (uint32_t)(int32_t)rel);
+    }
+
+    free(label_defs);
+    label_defs = NULL;
+    out = NULL;
+    if (ok) dwarf_build(obj, prog->source_file);
+    return ok;
+}
+
+void x64_object_free(X64Object* obj) {
+    free(obj->text);
+    free(obj->rodata);
+    free(obj->relocs);
+    free(obj->symbols);
+    free(obj->lines);
+    free(obj->cfis);
+    for (int i = 0; i < X64_DEBUG_SEC_COUNT; i++) {
+        free(obj->debug[i].data);
+        free(obj->debug[i].relocs);
+    }
+    memset(obj, 0, sizeof(X64Object));
+}
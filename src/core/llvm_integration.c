@@ -1,8 +1,11 @@
 #include "llvm_integration.h"
+#include <llvm-c/Support.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+extern char** environ;
+
 // Initialize LLVM context and components
 bool tesla_llvm_init(TeslaLLVMContext* ctx, const char* module_name) {
     if (!ctx || !module_name) {
@@ -58,20 +61,27 @@ bool tesla_llvm_init(TeslaLLVMContext* ctx, const char* module_name) {
         return false;
     }
     
+    // PIC so emitted objects link into the default PIE executables cc produces
     ctx->target_machine = LLVMCreateTargetMachine(
         target, target_triple, "generic", "",
-        LLVMCodeGenLevelDefault, LLVMRelocDefault, LLVMCodeModelDefault
+        LLVMCodeGenLevelDefault, LLVMRelocPIC, LLVMCodeModelDefault
     );
     
-    LLVMDisposeMessage(target_triple);
-    
     if (!ctx->target_machine) {
         snprintf(ctx->error_message, sizeof(ctx->error_message),
                 "Failed to create target machine");
+        LLVMDisposeMessage(target_triple);
         tesla_llvm_cleanup(ctx);
         return false;
     }
     
+    // Give the optimizer the real layout (vectorizer cost models need it)
+    LLVMSetTarget(ctx->module, target_triple);
+    LLVMTargetDataRef data_layout = LLVMCreateTargetDataLayout(ctx->target_machine);
+    LLVMSetModuleDataLayout(ctx->module, data_layout);
+    LLVMDisposeTargetData(data_layout);
+    LLVMDisposeMessage(target_triple);
+    
     ctx->is_initialized = true;
     return true;
 }
@@ -81,8 +91,10 @@ void tesla_llvm_cleanup(TeslaLLVMContext* ctx) {
     if (!ctx) return;
     
     if (ctx->execution_engine) {
+        // The engine owns the module it was created for
         LLVMDisposeExecutionEngine(ctx->execution_engine);
         ctx->execution_engine = NULL;
+        ctx->module = NULL;
     }
     
     if (ctx->target_machine) {
@@ -180,39 +192,94 @@ bool tesla_llvm_compile_to_assembly(TeslaLLVMContext* ctx, const char* output_pa
 }
 
 // Optimize module
+// Uses the standard PassManagerBuilder pipeline for the requested level so
+// that -O2 gets the same inliner, GVN and vectorizer setup clang uses.
 void tesla_llvm_optimize_module(TeslaLLVMContext* ctx, unsigned opt_level) {
     if (!ctx || !ctx->is_initialized) {
         return;
     }
     
-    // Create pass manager
+    LLVMPassManagerBuilderRef builder = LLVMPassManagerBuilderCreate();
+    LLVMPassManagerBuilderSetOptLevel(builder, opt_level);
+    LLVMPassManagerBuilderSetSizeLevel(builder, 0);
+    if (opt_level >= 2) {
+        // Threshold matches clang's default for -O2 (225); -O3 uses 275
+        LLVMPassManagerBuilderUseInlinerWithThreshold(builder, opt_level >= 3 ? 275 : 225);
+    }
+    
+    // Per-function cleanup passes (SROA, early CSE, ...)
+    LLVMPassManagerRef function_passes = LLVMCreateFunctionPassManagerForModule(ctx->module);
+    LLVMPassManagerBuilderPopulateFunctionPassManager(builder, function_passes);
+    
+    // Module pipeline (inlining, GVN, loop opts)
     LLVMPassManagerRef pass_manager = LLVMCreatePassManager();
+    LLVMPassManagerBuilderPopulateModulePassManager(builder, pass_manager);
     
-    // Add basic optimizations based on opt_level
-    if (opt_level >= 1) {
+    if (opt_level >= 2) {
+        LLVMAddLoopVectorizePass(pass_manager);
+        LLVMAddSLPVectorizePass(pass_manager);
         LLVMAddInstructionCombiningPass(pass_manager);
-        LLVMAddReassociatePass(pass_manager);
-        LLVMAddGVNPass(pass_manager);
         LLVMAddCFGSimplificationPass(pass_manager);
     }
     
-    if (opt_level >= 2) {
-        LLVMAddFunctionInliningPass(pass_manager);
-        LLVMAddGlobalDCEPass(pass_manager);
-        LLVMAddGlobalOptimizerPass(pass_manager);
-    }
-    
-    if (opt_level >= 3) {
-        LLVMAddAggressiveDCEPass(pass_manager);
-        LLVMAddScalarReplAggregatesPass(pass_manager);
-        LLVMAddLoopUnrollPass(pass_manager);
-    }
-    
     // Run optimization passes
+    LLVMInitializeFunctionPassManager(function_passes);
+    for (LLVMValueRef fn = LLVMGetFirstFunction(ctx->module); fn; fn = LLVMGetNextFunction(fn)) {
+        if (!LLVMIsDeclaration(fn)) LLVMRunFunctionPassManager(function_passes, fn);
+    }
+    LLVMFinalizeFunctionPassManager(function_passes);
     LLVMRunPassManager(pass_manager, ctx->module);
     
     // Cleanup
+    LLVMDisposePassManager(function_passes);
     LLVMDisposePassManager(pass_manager);
+    LLVMPassManagerBuilderDispose(builder);
+}
+
+// Create an MCJIT engine for the module
+bool tesla_llvm_create_jit(TeslaLLVMContext* ctx, unsigned opt_level) {
+    if (!ctx || !ctx->is_initialized || ctx->execution_engine) {
+        return false;
+    }
+    
+    LLVMLinkInMCJIT();
+    // NULL makes every symbol of the host process (the linked-in runtime) resolvable
+    LLVMLoadLibraryPermanently(NULL);
+    
+    struct LLVMMCJITCompilerOptions options;
+    LLVMInitializeMCJITCompilerOptions(&options, sizeof(options));
+    options.OptLevel = opt_level;
+    
+    char* error_msg = NULL;
+    if (LLVMCreateMCJITCompilerForModule(&ctx->execution_engine, ctx->module,
+                                        &options, sizeof(options), &error_msg)) {
+        snprintf(ctx->error_message, sizeof(ctx->error_message),
+                "Failed to create JIT: %s", error_msg ? error_msg : "unknown error");
+        if (error_msg) LLVMDisposeMessage(error_msg);
+        ctx->execution_engine = NULL;
+        return false;
+    }
+    
+    return true;
+}
+
+// Run the module's main() in-process and return its exit code
+int tesla_llvm_run_main(TeslaLLVMContext* ctx, int argc, const char* const* argv) {
+    if (!ctx || !ctx->execution_engine) {
+        return 1;
+    }
+    
+    LLVMValueRef main_fn = LLVMGetNamedFunction(ctx->module, "main");
+    if (!main_fn) {
+        snprintf(ctx->error_message, sizeof(ctx->error_message), "No main function");
+        return 1;
+    }
+    
+    LLVMRunStaticConstructors(ctx->execution_engine);
+    int status = LLVMRunFunctionAsMain(ctx->execution_engine, main_fn,
+                                       (unsigned)argc, argv, (const char* const*)environ);
+    LLVMRunStaticDestructors(ctx->execution_engine);
+    return status;
 }
 
 // Get error message
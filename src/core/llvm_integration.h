@@ -11,6 +11,8 @@
 #include <llvm-c/Analysis.h>
 #include <llvm-c/BitWriter.h>
 #include <llvm-c/Transforms/PassManagerBuilder.h>
+#include <llvm-c/Transforms/Scalar.h>
+#include <llvm-c/Transforms/Vectorize.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -52,6 +54,11 @@ bool tesla_llvm_compile_to_assembly(TeslaLLVMContext* ctx,
 // Optimization functions
 void tesla_llvm_optimize_module(TeslaLLVMContext* ctx, unsigned opt_level);
 
+// JIT execution
+// Takes ownership of ctx->module; runtime symbols resolve against the host process.
+bool tesla_llvm_create_jit(TeslaLLVMContext* ctx, unsigned opt_level);
+int tesla_llvm_run_main(TeslaLLVMContext* ctx, int argc, const char* const* argv);
+
 // Error handling
 const char* tesla_llvm_get_error(TeslaLLVMContext* ctx);
 void tesla_llvm_clear_error(TeslaLLVMContext* ctx);
@@ -0,0 +1,721 @@
+/* Aria_lang/src/driver/build.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "../frontend/ast.h"
+#include "../frontend/parser.h"
+#include "../frontend/source.h"
+#include "../backend/x64.h"
+#include "../runtime/bundler.h"
+#include "build.h"
+#include "cache.h"
+#include "parse_pool.h"
+#include "sha256.h"
+
+// Defined in codegen.c
+extern void gen_module(AstNode* head, const char* init_name, const char** init_order, int init_count);
+extern X64Program* x64_out;
+
+// Defined in main.c
+extern char* read_entire_file(const char* path);
+extern int run_command(char* const* argv);
+
+#define MAX_MODULES 1024
+#define MAX_DEPS 64
+
+typedef enum { MOD_PENDING, MOD_RUNNING, MOD_DONE } ModuleState;
+
+typedef struct {
+    char name[128];          // import name
+    char path[PATH_MAX];     // canonical source path
+    char base[192];          // build file stem: name-<path hash>
+    char init_sym[224];      // aria_init_<base>
+    SourceFile source;       // mapped for the whole build
+    AstArena* arena;         // set when parsed ahead of compilation
+    AstNode* root;
+    int deps[MAX_DEPS];
+    int dep_count;
+    ModuleState state;
+    int rebuilt;
+    pid_t pid;
+    char key[65];
+    char ast_key[65];        // names the parsed form of the source (.ast)
+} Module;
+
+static Module* modules;
+static int module_count;
+static char build_dir[PATH_MAX];
+
+// --- Module Graph ---
+
+static void artifact_path(Module* m, const char* ext, char* buf, size_t size) {
+    snprintf(buf, size, "%s/%s.%s", build_dir, m->base, ext);
+}
+
+static void dir_of(const char* path, char* buf, size_t size) {
+    snprintf(buf, size, "%s", path);
+    char* slash = strrchr(buf, '/');
+    if (slash) *slash = '\0';
+    else snprintf(buf, size, ".");
+}
+
+int source_has_imports(const char* source, size_t length) {
+    Lexer lx;
+    lexer_init(&lx, source, length);
+    for (;;) {
+        Token t = lexer_next(&lx);
+        if (t.type == TOKEN_EOF) return 0;
+        if (t.type == TOKEN_IMPORT) return 1;
+    }
+}
+
+static int find_module(const char* path) {
+    for (int i = 0; i < module_count; i++) {
+        if (strcmp(modules[i].path, path) == 0) return i;
+    }
+    return -1;
+}
+
+static int add_module(const char* name, const char* path) {
+    char real[PATH_MAX];
+    if (!realpath(path, real)) return -1;
+    int existing = find_module(real);
+    if (existing >= 0) return existing;
+    if (module_count >= MAX_MODULES) {
+        fprintf(stderr, "[Aria] Error: Too many modules (max %d).\n", MAX_MODULES);
+        return -2;
+    }
+
+    Module* m = &modules[module_count];
+    memset(m, 0, sizeof(Module));
+    snprintf(m->name, sizeof(m->name), "%s", name);
+    snprintf(m->path, sizeof(m->path), "%s", real);
+    if (!source_load(&m->source, real)) return -1;
+
+    // Same-named modules in different directories must not share artifacts
+    Sha256 ctx;
+    char hex[65];
+    sha256_init(&ctx);
+    sha256_update(&ctx, real, strlen(real));
+    sha256_final_hex(&ctx, hex);
+    snprintf(m->base, sizeof(m->base), "%s-%.8s", name, hex);
+    snprintf(m->init_sym, sizeof(m->init_sym), "aria_init_%s", m->base);
+    for (char* p = m->init_sym; *p; p++) if (*p == '-') *p = '_';
+    return module_count++;
+}
+
+// Scans each module's imports (lexer only) and records dependency edges
+static int discover(const char* root_path) {
+    char root_dir[PATH_MAX];
+    dir_of(root_path, root_dir, sizeof(root_dir));
+
+    const char* slash = strrchr(root_path, '/');
+    char root_name[128];
+    snprintf(root_name, sizeof(root_name), "%s", slash ? slash + 1 : root_path);
+    char* dot = strrchr(root_name, '.');
+    if (dot) *dot = '\0';
+    if (add_module(root_name, root_path) != 0) {
+        fprintf(stderr, "Error: Could not read file %s\n", root_path);
+        return 0;
+    }
+
+    for (int i = 0; i < module_count; i++) {
+        char dir[PATH_MAX];
+        dir_of(modules[i].path, dir, sizeof(dir));
+        Lexer lx;
+        lexer_init(&lx, modules[i].source.text, modules[i].source.length);
+        for (;;) {
+            Token t = lexer_next(&lx);
+            if (t.type == TOKEN_EOF) break;
+            if (t.type != TOKEN_IMPORT) continue;
+            Token name = lexer_next(&lx);
+            if (name.type != TOKEN_IDENTIFIER) continue;   // the parser reports it
+
+            char mod_name[128];
+            char path[PATH_MAX * 2];
+            snprintf(mod_name, sizeof(mod_name), "%.*s", name.length, name.start);
+            snprintf(path, sizeof(path), "%s/%s.aria", dir, mod_name);
+            if (access(path, R_OK) != 0) snprintf(path, sizeof(path), "%s/%s.aria", root_dir, mod_name);
+
+            int dep = add_module(mod_name, path);
+            if (dep == -2) return 0;
+            if (dep < 0) {
+                fprintf(stderr, "[Aria] Error: %s imports '%s', but %s/%s.aria was not found.\n",
+                        modules[i].name, mod_name, dir, mod_name);
+                return 0;
+            }
+            if (dep == i) {
+                fprintf(stderr, "[Aria] Error: Module '%s' imports itself.\n", modules[i].name);
+                return 0;
+            }
+            if (modules[i].dep_count >= MAX_DEPS) {
+                fprintf(stderr, "[Aria] Error: Module '%s' has too many imports.\n", modules[i].name);
+                return 0;
+            }
+            modules[i].deps[modules[i].dep_count++] = dep;
+        }
+    }
+    return 1;
+}
+
+// Dependencies-first order; fails on import cycles
+static int topo_visit(int i, int* mark, int* order, int* count) {
+    if (mark[i] == 2) return 1;
+    if (mark[i] == 1) {
+        fprintf(stderr, "[Aria] Error: Import cycle through module '%s'.\n", modules[i].name);
+        return 0;
+    }
+    mark[i] = 1;
+    for (int d = 0; d < modules[i].dep_count; d++) {
+        if (!topo_visit(modules[i].deps[d], mark, order, count)) return 0;
+    }
+    mark[i] = 2;
+    order[(*count)++] = i;
+    return 1;
+}
+
+// --- Interface Files ---
+
+/*
+ * Format, one declaration per line:
+ *   aria-interface 1
+ *   func <name> <arity>
+ *   global <name>
+ *   class <name>
+ *   method <class> <mangled name> <arity>
+ */
+static int count_list(AstNode* n) {
+    int count = 0;
+    for (; n; n = AST_NEXT(n)) count++;
+    return count;
+}
+
+static char* render_interface(AstNode* root, size_t* out_len) {
+    char* buf = NULL;
+    size_t len = 0;
+    FILE* f = open_memstream(&buf, &len);
+    if (!f) return NULL;
+    fprintf(f, "aria-interface 1\n");
+    for (AstNode* n = root; n; n = AST_NEXT(n)) {
+        if (ast_type(n) == NODE_FUNC_DECL && strcmp(n->data.func_decl.name, "aria_main") != 0) {
+            fprintf(f, "func %s %d\n", n->data.func_decl.name, count_list(AST_KID(n, func_decl.params)));
+        } else if (ast_type(n) == NODE_VAR_DECL) {
+            fprintf(f, "global %s\n", n->data.var_decl.name);
+        } else if (ast_type(n) == NODE_CLASS_DECL && !n->data.class_decl.is_extern) {
+            fprintf(f, "class %s\n", n->data.class_decl.name);
+            for (AstNode* m = AST_KID(n, class_decl.methods); m; m = AST_NEXT(m)) {
+                fprintf(f, "method %s %s %d\n", n->data.class_decl.name, m->data.func_decl.name,
+                        count_list(AST_KID(m, func_decl.params)));
+            }
+        }
+    }
+    fclose(f);
+    *out_len = len;
+    return buf;
+}
+
+// Rewrites the interface only when it changed, keeping its digest stable
+static int write_interface(Module* m, AstNode* root) {
+    char path[PATH_MAX + 256];
+    size_t len;
+    char* text = render_interface(root, &len);
+    if (!text) return 0;
+    artifact_path(m, "ari", path, sizeof(path));
+
+    char* old = read_entire_file(path);
+    int same = old && strlen(old) == len && memcmp(old, text, len) == 0;
+    free(old);
+    int ok = 1;
+    if (!same) {
+        FILE* f = fopen(path, "w");
+        ok = f && fwrite(text, 1, len, f) == len;
+        if (f && fclose(f) != 0) ok = 0;
+    }
+    free(text);
+    return ok;
+}
+
+typedef struct {
+    const char* name;
+    int arity;          // -1 for globals
+} ImportedSymbol;
+
+typedef struct {
+    ImportedSymbol* syms;
+    int count;
+    int capacity;
+    AstNode* classes;   // extern class stubs, appended to the module's AST
+} Imports;
+
+static void add_import_symbol(Imports* imp, const char* name, int arity) {
+    if (imp->count >= imp->capacity) {
+        imp->capacity = imp->capacity ? imp->capacity * 2 : 64;
+        imp->syms = realloc(imp->syms, sizeof(ImportedSymbol) * imp->capacity);
+        if (!imp->syms) { fprintf(stderr, "Fatal: Out of memory in build driver.\n"); exit(1); }
+    }
+    imp->syms[imp->count].name = name;
+    imp->syms[imp->count].arity = arity;
+    imp->count++;
+}
+
+static ImportedSymbol* find_import(Imports* imp, const char* name) {
+    for (int i = 0; i < imp->count; i++) {
+        if (strcmp(imp->syms[i].name, name) == 0) return &imp->syms[i];
+    }
+    return NULL;
+}
+
+static int load_interface(Module* dep, AstArena* arena, Imports* imp) {
+    char path[PATH_MAX + 256];
+    artifact_path(dep, "ari", path, sizeof(path));
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "[Aria] Error: Missing interface for module '%s'.\n", dep->name);
+        return 0;
+    }
+
+    char line[512];
+    char a[256], b[256];
+    int arity;
+    AstNode* last_method = NULL;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "func %255s %d", a, &arity) == 2) {
+            add_import_symbol(imp, arena_strndup(arena, a, strlen(a)), arity);
+        } else if (sscanf(line, "global %255s", a) == 1) {
+            add_import_symbol(imp, arena_strndup(arena, a, strlen(a)), -1);
+        } else if (sscanf(line, "class %255s", a) == 1) {
+            AstNode* cls = arena_alloc(arena);
+            ast_set_type(cls, NODE_CLASS_DECL);
+            cls->data.class_decl.name = arena_strndup(arena, a, strlen(a));
+            cls->data.class_decl.is_extern = 1;
+            cls->next = ast_ref(imp->classes);
+            imp->classes = cls;
+            last_method = NULL;
+        } else if (sscanf(line, "method %255s %255s %d", a, b, &arity) == 3 && imp->classes) {
+            AstNode* method = arena_alloc(arena);
+            ast_set_type(method, NODE_FUNC_DECL);
+            method->data.func_decl.name = arena_strndup(arena, b, strlen(b));
+            if (last_method) last_method->next = ast_ref(method);
+            else imp->classes->data.class_decl.methods = ast_ref(method);
+            last_method = method;
+        }
+    }
+    fclose(f);
+    return 1;
+}
+
+// --- Import Resolution ---
+
+static const char* resolve_module_name;
+static int resolve_errors;
+
+/*
+ * The parser marks names it cannot resolve as external symbols (id -1).
+ * Imported globals become global slots (id -2) so they are accessed as data,
+ * and direct calls to imported functions are checked against their arity.
+ */
+static void resolve_node(AstNode* n, Imports* imp) {
+    for (; n; n = AST_NEXT(n)) {
+        switch (ast_type(n)) {
+            case NODE_VAR_ACCESS: {
+                ImportedSymbol* s = n->data.var_access.id == -1 ? find_import(imp, n->data.var_access.name) : NULL;
+                if (s && s->arity < 0) n->data.var_access.id = -2;
+                break;
+            }
+            case NODE_ASSIGN: {
+                ImportedSymbol* s = n->data.assign.id == -1 ? find_import(imp, n->data.assign.name) : NULL;
+                if (s && s->arity < 0) n->data.assign.id = -2;
+                resolve_node(AST_KID(n, assign.value), imp);
+                break;
+            }
+            case NODE_CALL: {
+                AstNode* callee = AST_KID(n, call.callee);
+                if (ast_type(callee) == NODE_VAR_ACCESS && callee->data.var_access.id == -1) {
+                    ImportedSymbol* s = find_import(imp, callee->data.var_access.name);
+                    int argc = count_list(AST_KID(n, call.args));
+                    if (s && s->arity >= 0 && s->arity != argc) {
+                        fprintf(stderr, "[Aria] Error in module '%s': '%s' expects %d argument(s), got %d.\n",
+                                resolve_module_name, s->name, s->arity, argc);
+                        resolve_errors++;
+                    }
+                }
+                resolve_node(callee, imp);
+                resolve_node(AST_KID(n, call.args), imp);
+                break;
+            }
+            case NODE_FUNC_DECL: resolve_node(AST_KID(n, func_decl.body), imp); break;
+            case NODE_BLOCK: resolve_node(AST_KID(n, block.body), imp); break;
+            case NODE_CLASS_DECL: resolve_node(AST_KID(n, class_decl.methods), imp); break;
+            case NODE_VAR_DECL: resolve_node(AST_KID(n, var_decl.init_expr), imp); break;
+            case NODE_RETURN: resolve_node(AST_KID(n, return_stmt.expr), imp); break;
+            case NODE_BINARY_OP:
+                if (n->data.binary.left) resolve_node(AST_KID(n, binary.left), imp);
+                resolve_node(AST_KID(n, binary.right), imp);
+                break;
+            case NODE_IF:
+                resolve_node(AST_KID(n, if_stmt.condition), imp);
+                resolve_node(AST_KID(n, if_stmt.then_branch), imp);
+                resolve_node(AST_KID(n, if_stmt.else_branch), imp);
+                break;
+            case NODE_WHILE:
+                resolve_node(AST_KID(n, while_stmt.condition), imp);
+                resolve_node(AST_KID(n, while_stmt.body), imp);
+                break;
+            case NODE_FOR:
+                resolve_node(AST_KID(n, for_stmt.iterable), imp);
+                resolve_node(AST_KID(n, for_stmt.body), imp);
+                break;
+            case NODE_MATCH:
+                resolve_node(AST_KID(n, match.subject), imp);
+                resolve_node(AST_KID(n, match.arms), imp);
+                resolve_node(AST_KID(n, match.otherwise), imp);
+                break;
+            case NODE_MATCH_ARM: resolve_node(AST_KID(n, match_arm.body), imp); break;
+            case NODE_GET: resolve_node(AST_KID(n, get.obj), imp); break;
+            case NODE_SET: resolve_node(AST_KID(n, set.obj), imp); resolve_node(AST_KID(n, set.value), imp); break;
+            case NODE_INDEX_GET: resolve_node(AST_KID(n, index_get.obj), imp); resolve_node(AST_KID(n, index_get.index), imp); break;
+            case NODE_INDEX_SET:
+                resolve_node(AST_KID(n, index_set.obj), imp);
+                resolve_node(AST_KID(n, index_set.index), imp);
+                resolve_node(AST_KID(n, index_set.value), imp);
+                break;
+            case NODE_ARRAY_LITERAL: resolve_node(AST_KID(n, array_literal.elements), imp); break;
+            case NODE_TERNARY:
+                resolve_node(AST_KID(n, ternary.condition), imp);
+                resolve_node(AST_KID(n, ternary.true_expr), imp);
+                resolve_node(AST_KID(n, ternary.false_expr), imp);
+                break;
+            default: break;
+        }
+    }
+}
+
+// --- Compilation (runs in a worker process) ---
+
+static int compile_module(int idx, const char** init_order, int init_count) {
+    Module* m = &modules[idx];
+    AstArena* arena = m->arena;
+    AstNode* root = m->root;
+    if (!arena) {
+        // Went stale when an import's interface changed, after the parse pool ran
+        char ast_path[PATH_MAX + 256];
+        artifact_path(m, "ast", ast_path, sizeof(ast_path));
+        arena = arena_create(m->source.length);
+        if (!arena) return 1;
+        if (!arena_load(arena, m->ast_key, ast_path, &root)) {
+            root = parse_program(m->source.text, m->source.length, m->path, arena);
+            arena_save(arena, root, m->ast_key, ast_path);
+        }
+    }
+
+    if (idx != 0) {
+        for (AstNode* n = root; n; n = AST_NEXT(n)) {
+            if (ast_type(n) == NODE_FUNC_DECL && strcmp(n->data.func_decl.name, "aria_main") == 0) {
+                fprintf(stderr, "[Aria] Error: Only the root module may define main (found in '%s').\n", m->name);
+                return 1;
+            }
+        }
+    }
+    if (!write_interface(m, root)) {
+        fprintf(stderr, "[Aria] Error: Could not write interface for '%s'.\n", m->name);
+        return 1;
+    }
+
+    Imports imp;
+    memset(&imp, 0, sizeof(imp));
+    for (int d = 0; d < m->dep_count; d++) {
+        if (!load_interface(&modules[m->deps[d]], arena, &imp)) return 1;
+    }
+    resolve_module_name = m->name;
+    resolve_errors = 0;
+    resolve_node(root, &imp);
+    if (resolve_errors) return 1;
+
+    // Imported class layouts let NEW populate method slots without the bodies
+    if (imp.classes) {
+        AstNode* tail = imp.classes;
+        while (tail->next) tail = AST_NEXT(tail);
+        tail->next = ast_ref(root);
+        root = imp.classes;
+    }
+
+    X64Program prog;
+    X64Object obj;
+    char obj_path[PATH_MAX + 256];
+    x64_program_init(&prog);
+    prog.source_file = m->path;
+    x64_out = &prog;
+    gen_module(root, m->init_sym, idx == 0 ? init_order : NULL, init_count);
+    x64_out = NULL;
+    artifact_path(m, "o", obj_path, sizeof(obj_path));
+    if (!x64_encode(&prog, &obj) || !elf_write_object(&obj, obj_path)) {
+        fprintf(stderr, "[Aria] Object emission failed for '%s'.\n", m->name);
+        return 1;
+    }
+    return 0;
+}
+
+// --- Scheduling ---
+
+static void file_hex(const char* path, char hex[65]) {
+    Sha256 ctx;
+    sha256_init(&ctx);
+    char* text = read_entire_file(path);
+    if (text) sha256_update(&ctx, text, strlen(text));
+    free(text);
+    sha256_final_hex(&ctx, hex);
+}
+
+// Build key: compiler, source, direct imports' interfaces and (root) the init order
+static void module_key(int idx, const char* compiler_hex, const char** init_order, int init_count) {
+    Module* m = &modules[idx];
+    Sha256 ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, "aria-module-v1", 15);
+    sha256_update(&ctx, compiler_hex, 65);
+    sha256_update(&ctx, m->source.text, m->source.length + 1);
+    for (int d = 0; d < m->dep_count; d++) {
+        char path[PATH_MAX + 256];
+        char hex[65];
+        artifact_path(&modules[m->deps[d]], "ari", path, sizeof(path));
+        file_hex(path, hex);
+        sha256_update(&ctx, hex, 65);
+    }
+    if (idx == 0) {
+        for (int i = 0; i < init_count; i++) sha256_update(&ctx, init_order[i], strlen(init_order[i]) + 1);
+    }
+    sha256_final_hex(&ctx, m->key);
+}
+
+static int is_up_to_date(Module* m) {
+    char path[PATH_MAX + 256];
+    artifact_path(m, "o", path, sizeof(path));
+    if (access(path, R_OK) != 0) return 0;
+    artifact_path(m, "ari", path, sizeof(path));
+    if (access(path, R_OK) != 0) return 0;
+    artifact_path(m, "stamp", path, sizeof(path));
+    char* stamp = read_entire_file(path);
+    int fresh = stamp && strcmp(stamp, m->key) == 0;
+    free(stamp);
+    return fresh;
+}
+
+static void write_stamp(Module* m) {
+    char path[PATH_MAX + 256];
+    artifact_path(m, "stamp", path, sizeof(path));
+    FILE* f = fopen(path, "w");
+    if (!f) return;
+    fputs(m->key, f);
+    fclose(f);
+}
+
+static int deps_done(Module* m) {
+    for (int d = 0; d < m->dep_count; d++) {
+        if (modules[m->deps[d]].state != MOD_DONE) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Parses every module that is out of date against the interfaces on disk,
+ * on up to 'jobs' threads, before any worker is forked; the workers inherit
+ * the ASTs. A module whose text is unchanged since its last parse (only an
+ * import's interface moved) maps its saved AST (.ast) instead. Returns 0 if
+ * a module has syntax errors.
+ */
+static int parse_stale(const char* compiler_hex, const char** init_order, int init_count, int jobs) {
+    ParseJob* parse_jobs = calloc(module_count, sizeof(ParseJob));
+    int* owner = malloc(sizeof(int) * module_count);
+    if (!parse_jobs || !owner) { fprintf(stderr, "Fatal: Out of memory in build driver.\n"); exit(1); }
+    int count = 0;
+    for (int i = 0; i < module_count; i++) {
+        Module* m = &modules[i];
+        module_key(i, compiler_hex, init_order, init_count);
+        cache_ast_key(compiler_hex, m->source.text, m->source.length, m->ast_key);
+        if (is_up_to_date(m)) continue;
+
+        char ast_path[PATH_MAX + 256];
+        artifact_path(m, "ast", ast_path, sizeof(ast_path));
+        AstArena* arena = arena_create(m->source.length);
+        if (!arena) {
+            free(parse_jobs);
+            free(owner);
+            return 0;
+        }
+        if (arena_load(arena, m->ast_key, ast_path, &m->root)) {
+            m->arena = arena;
+            continue;
+        }
+        arena_free(arena);
+        parse_jobs[count].path = m->path;
+        parse_jobs[count].source = m->source.text;
+        parse_jobs[count].length = m->source.length;
+        owner[count++] = i;
+    }
+
+    int failed = parse_files(parse_jobs, count, jobs);
+    for (int j = 0; j < count; j++) {
+        Module* m = &modules[owner[j]];
+        m->arena = parse_jobs[j].arena;
+        m->root = parse_jobs[j].root;
+        if (parse_jobs[j].ok) {
+            char ast_path[PATH_MAX + 256];
+            artifact_path(m, "ast", ast_path, sizeof(ast_path));
+            arena_save(m->arena, m->root, m->ast_key, ast_path);
+        }
+    }
+    free(parse_jobs);
+    free(owner);
+    return failed == 0;
+}
+
+static int link_program(const char* root_path) {
+    char bin_file[PATH_MAX];
+    snprintf(bin_file, sizeof(bin_file), "%s", root_path);
+    char* dot = strrchr(bin_file, '.');
+    char* slash = strrchr(bin_file, '/');
+    if (dot && (!slash || dot > slash)) *dot = '\0';
+
+    int rebuilt = 0;
+    for (int i = 0; i < module_count; i++) rebuilt |= modules[i].rebuilt;
+    if (!rebuilt && access(bin_file, X_OK) == 0) {
+        printf("[Aria] Up to date: %s\n", bin_file);
+        return 0;
+    }
+
+    char** argv = calloc(module_count + 12, sizeof(char*));
+    char (*objs)[PATH_MAX + 256] = malloc(sizeof(*objs) * module_count);
+    if (!argv || !objs) { fprintf(stderr, "Fatal: Out of memory in build driver.\n"); exit(1); }
+    int argc = 0;
+    argv[argc++] = (char*)bundler_get_cc_path();
+    argv[argc++] = "-o";
+    argv[argc++] = bin_file;
+    for (int i = 0; i < module_count; i++) {
+        artifact_path(&modules[i], "o", objs[i], sizeof(objs[i]));
+        argv[argc++] = objs[i];
+    }
+    argv[argc++] = (char*)bundler_get_runtime_path();
+    argv[argc++] = "-lm";
+    argv[argc++] = "-lpthread";
+    argv[argc++] = "-ldl";
+    argv[argc++] = "-lssh";
+    argv[argc] = NULL;
+
+    printf("[Aria] Linking %d module(s) with %s...\n", module_count, argv[0]);
+    int status = run_command(argv);
+    free(argv);
+    free(objs);
+    if (status != 0) {
+        fprintf(stderr, "[Aria] Linker failed. Ensure dependencies are installed.\n");
+        return 1;
+    }
+    printf("[Aria] Build Successful: %s\n", bin_file);
+    return 0;
+}
+
+int build_modules(const char* root_path, int jobs, int link) {
+    if (jobs < 1) jobs = 1;
+    modules = calloc(MAX_MODULES, sizeof(Module));
+    if (!modules) { fprintf(stderr, "Fatal: Out of memory in build driver.\n"); exit(1); }
+    module_count = 0;
+
+    if (!discover(root_path)) return 1;
+
+    int* mark = calloc(module_count, sizeof(int));
+    int* order = malloc(sizeof(int) * module_count);
+    const char** init_order = malloc(sizeof(char*) * module_count);
+    int order_count = 0;
+    if (!mark || !order || !init_order) { fprintf(stderr, "Fatal: Out of memory in build driver.\n"); exit(1); }
+    if (!topo_visit(0, mark, order, &order_count)) return 1;
+    for (int i = 0; i < order_count; i++) init_order[i] = modules[order[i]].init_sym;
+
+    char root_dir[PATH_MAX];
+    dir_of(modules[0].path, root_dir, sizeof(root_dir));
+    if (snprintf(build_dir, sizeof(build_dir), "%s/.aria_build", root_dir) >= (int)sizeof(build_dir)) {
+        fprintf(stderr, "[Aria] Error: Build directory path too long under '%s'.\n", root_dir);
+        return 1;
+    }
+    if (mkdir(build_dir, 0755) != 0 && access(build_dir, W_OK) != 0) {
+        perror("[Aria] Could not create build directory");
+        return 1;
+    }
+
+    BuildCache stamps;
+    char compiler_hex[65];
+    memset(&stamps, 0, sizeof(stamps));
+    if (snprintf(stamps.dir, sizeof(stamps.dir), "%s", build_dir) >= (int)sizeof(stamps.dir)) {
+        fprintf(stderr, "[Aria] Error: Build directory path too long: '%s'.\n", build_dir);
+        return 1;
+    }
+    if (!cache_file_digest(&stamps, "/proc/self/exe", compiler_hex)) strcpy(compiler_hex, ARIA_COMPILER_VERSION);
+
+    if (!parse_stale(compiler_hex, init_order, order_count, jobs)) {
+        fprintf(stderr, "[Aria] Build failed.\n");
+        return 1;
+    }
+
+    int done = 0, running = 0, failed = 0, compiled = 0;
+    while (done < module_count) {
+        // Launch every module whose imports are finished, up to the job limit
+        for (int i = 0; i < module_count && !failed; i++) {
+            Module* m = &modules[i];
+            if (m->state != MOD_PENDING || !deps_done(m)) continue;
+            module_key(i, compiler_hex, init_order, order_count);
+            if (is_up_to_date(m)) {
+                m->state = MOD_DONE;
+                done++;
+                i = -1;   // a finished module may unblock earlier entries
+                continue;
+            }
+            if (running >= jobs) continue;
+
+            printf("[Aria] Compiling %s\n", m->name);
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                failed = 1;
+                break;
+            }
+            if (pid == 0) _exit(compile_module(i, init_order, order_count));
+            m->pid = pid;
+            m->state = MOD_RUNNING;
+            running++;
+        }
+
+        if (running == 0) break;
+
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) break;
+        for (int i = 0; i < module_count; i++) {
+            Module* m = &modules[i];
+            if (m->state != MOD_RUNNING || m->pid != pid) continue;
+            running--;
+            m->state = MOD_DONE;
+            done++;
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                m->rebuilt = 1;
+                compiled++;
+                write_stamp(m);
+            } else {
+                failed = 1;
+            }
+        }
+    }
+
+    free(mark);
+    free(order);
+    free(init_order);
+    if (failed || done < module_count) {
+        fprintf(stderr, "[Aria] Build failed.\n");
+        return 1;
+    }
+    printf("[Aria] %d of %d module(s) recompiled\n", compiled, module_count);
+    return link ? link_program(root_path) : 0;
+}
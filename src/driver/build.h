@@ -0,0 +1,31 @@
+/* Aria_lang/src/driver/build.h */
+#ifndef ARIA_BUILD_H
+#define ARIA_BUILD_H
+
+#include <stddef.h>
+
+/*
+ * Separate Compilation Driver
+ * ---------------------------
+ * `import name;` pulls in name.aria from the importer's directory (falling
+ * back to the root module's directory). Each module compiles to its own
+ * object plus an interface file (.ari) listing its exported functions with
+ * arity, globals and class layouts; importers are compiled against those
+ * interfaces only.
+ *
+ * Everything lives in <root dir>/.aria_build/. A module is recompiled when
+ * its source, the compiler, or the interface of a direct import changes, so
+ * editing a function body never cascades into dependents. Stale modules
+ * are parsed up front on a pool of threads (parse_pool.h), independent
+ * modules compile in parallel worker processes, and the final link only
+ * runs when an object changed.
+ */
+
+// Builds root_path and everything it imports with up to 'jobs' workers.
+// When 'link' is 0 the build stops after the objects. Returns 0 on success.
+int build_modules(const char* root_path, int jobs, int link);
+
+// True if the source has a top-level import and must go through build_modules.
+int source_has_imports(const char* source, size_t length);
+
+#endif
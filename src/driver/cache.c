@@ -0,0 +1,238 @@
+/* Aria_lang/src/driver/cache.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "cache.h"
+#include "sha256.h"
+
+#define DEFAULT_MAX_MB 256
+
+// --- Helpers ---
+
+static int mkdir_p(const char* path) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for (char* p = tmp + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(tmp, 0755) != 0 && errno != EEXIST) return 0;
+        *p = '/';
+    }
+    return mkdir(tmp, 0755) == 0 || errno == EEXIST;
+}
+
+static int hash_file(const char* path, Sha256* ctx) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) sha256_update(ctx, buf, n);
+    fclose(f);
+    return 1;
+}
+
+/*
+ * Hashing libaria.a or the compiler binary on every invocation would cost
+ * more than a small compile, so file digests are memoized in stamp files
+ * keyed by path, inode, size and mtime.
+ */
+int cache_file_digest(BuildCache* cache, const char* path, char hex[65]) {
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+
+    char id[1024];
+    Sha256 ctx;
+    char id_hex[65];
+    snprintf(id, sizeof(id), "%s|%llu|%llu|%lld.%09ld", path,
+             (unsigned long long)st.st_ino, (unsigned long long)st.st_size,
+             (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec);
+    sha256_init(&ctx);
+    sha256_update(&ctx, id, strlen(id));
+    sha256_final_hex(&ctx, id_hex);
+
+    char stamp[PATH_MAX + 32];
+    snprintf(stamp, sizeof(stamp), "%s/stamp-%.16s", cache->dir, id_hex);
+    FILE* f = fopen(stamp, "r");
+    if (f) {
+        int ok = fread(hex, 1, 64, f) == 64;
+        fclose(f);
+        hex[64] = '\0';
+        if (ok) return 1;
+    }
+
+    sha256_init(&ctx);
+    if (!hash_file(path, &ctx)) return 0;
+    sha256_final_hex(&ctx, hex);
+
+    char tmp[PATH_MAX + 64];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", stamp, (int)getpid());
+    f = fopen(tmp, "w");
+    if (f) {
+        fwrite(hex, 1, 64, f);
+        fclose(f);
+        if (rename(tmp, stamp) != 0) remove(tmp);
+    }
+    return 1;
+}
+
+static int copy_file(const char* src, const char* dst, mode_t mode) {
+    int in = open(src, O_RDONLY);
+    if (in < 0) return 0;
+    int out = open(dst, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (out < 0) { close(in); return 0; }
+
+    char buf[65536];
+    ssize_t n;
+    int ok = 1;
+    while ((n = read(in, buf, sizeof(buf))) > 0) {
+        if (write(out, buf, n) != n) { ok = 0; break; }
+    }
+    if (n < 0) ok = 0;
+    close(in);
+    if (close(out) != 0) ok = 0;
+    return ok;
+}
+
+static void entry_path(BuildCache* cache, const char* kind, char* buf, size_t size) {
+    snprintf(buf, size, "%s/%s.%s", cache->dir, cache->key, kind);
+}
+
+// --- Public API ---
+
+int cache_open(BuildCache* cache, const char* source, size_t source_len,
+               const char* flags, const char* runtime_path) {
+    memset(cache, 0, sizeof(BuildCache));
+
+    const char* toggle = getenv("ARIA_CACHE");
+    if (toggle && strcmp(toggle, "0") == 0) return 0;
+
+    const char* dir = getenv("ARIA_CACHE_DIR");
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (dir && *dir) snprintf(cache->dir, sizeof(cache->dir), "%s", dir);
+    else if (xdg && *xdg) snprintf(cache->dir, sizeof(cache->dir), "%s/aria", xdg);
+    else if (home && *home) snprintf(cache->dir, sizeof(cache->dir), "%s/.cache/aria", home);
+    else return 0;
+    if (!mkdir_p(cache->dir)) return 0;
+
+    const char* max_mb = getenv("ARIA_CACHE_MAX_MB");
+    cache->max_bytes = (unsigned long long)(max_mb ? strtoull(max_mb, NULL, 10) : DEFAULT_MAX_MB) << 20;
+
+    char compiler_hex[65];
+    char runtime_hex[65];
+    if (!cache_file_digest(cache, "/proc/self/exe", compiler_hex)) return 0;
+    memcpy(cache->compiler, compiler_hex, sizeof(compiler_hex));
+    // A missing runtime simply fails at link time; it must not alias a real one
+    if (!cache_file_digest(cache, runtime_path, runtime_hex)) strcpy(runtime_hex, "none");
+
+    // Every field is NUL-terminated so adjacent fields cannot run together
+    Sha256 ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, "aria-cache-v1", 14);
+    sha256_update(&ctx, ARIA_COMPILER_VERSION, sizeof(ARIA_COMPILER_VERSION));
+    sha256_update(&ctx, compiler_hex, 65);
+    sha256_update(&ctx, flags, strlen(flags) + 1);
+    sha256_update(&ctx, runtime_hex, strlen(runtime_hex) + 1);
+    sha256_update(&ctx, source, source_len);
+    sha256_final_hex(&ctx, cache->key);
+
+    cache->enabled = 1;
+    return 1;
+}
+
+void cache_ast_key(const char* compiler, const char* source, size_t source_len, char key[65]) {
+    Sha256 ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, "aria-ast-v1", 12);
+    sha256_update(&ctx, compiler, strlen(compiler) + 1);
+    sha256_update(&ctx, source, source_len);
+    sha256_final_hex(&ctx, key);
+}
+
+int cache_fetch(BuildCache* cache, const char* kind, const char* dest) {
+    if (!cache->enabled) return 0;
+    char path[PATH_MAX + 80];
+    entry_path(cache, kind, path, sizeof(path));
+
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    if (!copy_file(path, dest, st.st_mode & 0777)) return 0;
+    // Refresh mtime so eviction sees this entry as recently used
+    utimensat(AT_FDCWD, path, NULL, 0);
+    return 1;
+}
+
+typedef struct {
+    char name[300];
+    unsigned long long size;
+    time_t mtime;
+} CacheEntry;
+
+static int compare_age(const void* a, const void* b) {
+    time_t ta = ((const CacheEntry*)a)->mtime, tb = ((const CacheEntry*)b)->mtime;
+    return (ta > tb) - (ta < tb);
+}
+
+// Deletes least recently used entries until the directory is under 90% of budget
+static void cache_evict(BuildCache* cache) {
+    DIR* d = opendir(cache->dir);
+    if (!d) return;
+
+    CacheEntry* entries = NULL;
+    int count = 0, cap = 0;
+    unsigned long long total = 0;
+    struct dirent* de;
+    while ((de = readdir(d)) != NULL) {
+        if (de->d_name[0] == '.' || strstr(de->d_name, ".tmp")) continue;
+        char path[PATH_MAX + 272];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", cache->dir, de->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (count >= cap) {
+            cap = cap ? cap * 2 : 256;
+            CacheEntry* grown = realloc(entries, sizeof(CacheEntry) * cap);
+            if (!grown) break;
+            entries = grown;
+        }
+        snprintf(entries[count].name, sizeof(entries[count].name), "%s", de->d_name);
+        entries[count].size = (unsigned long long)st.st_size;
+        entries[count].mtime = st.st_mtime;
+        total += entries[count].size;
+        count++;
+    }
+    closedir(d);
+
+    if (total > cache->max_bytes) {
+        unsigned long long target = cache->max_bytes / 10 * 9;
+        qsort(entries, count, sizeof(CacheEntry), compare_age);
+        for (int i = 0; i < count && total > target; i++) {
+            char path[PATH_MAX + 272];
+            snprintf(path, sizeof(path), "%s/%s", cache->dir, entries[i].name);
+            if (remove(path) == 0) total -= entries[i].size;
+        }
+    }
+    free(entries);
+}
+
+void cache_store(BuildCache* cache, const char* kind, const char* src) {
+    if (!cache->enabled) return;
+    struct stat st;
+    if (stat(src, &st) != 0) return;
+
+    // Write then rename so concurrent builds never observe a partial entry
+    char path[PATH_MAX + 80];
+    char tmp[PATH_MAX + 112];
+    entry_path(cache, kind, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    if (!copy_file(src, tmp, st.st_mode & 0777) || rename(tmp, path) != 0) {
+        remove(tmp);
+        return;
+    }
+    cache_evict(cache);
+}
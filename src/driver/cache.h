@@ -0,0 +1,53 @@
+/* Aria_lang/src/driver/cache.h */
+#ifndef ARIA_CACHE_H
+#define ARIA_CACHE_H
+
+#include <stddef.h>
+#include <limits.h>
+
+/*
+ * Content-Addressed Build Cache
+ * -----------------------------
+ * Outputs are stored under a key hashing everything that determines them:
+ * the source text, the compiler (version string and executable contents),
+ * the backend flags and the runtime library contents. A hit copies the
+ * stored object or binary out and the driver skips parsing, codegen,
+ * assembly and linking.
+ *
+ * Location: $ARIA_CACHE_DIR, else $XDG_CACHE_HOME/aria, else ~/.cache/aria.
+ * Size bound: $ARIA_CACHE_MAX_MB (default 256); least recently used entries
+ * are evicted after each store. ARIA_CACHE=0 disables the cache.
+ *
+ * Parsed ASTs are cached as well, under a key of the source text and the
+ * compiler alone (cache_ast_key), so changing a flag, the runtime or an
+ * import still skips lexing and parsing; see arena_save in arena.c.
+ */
+
+#define ARIA_COMPILER_VERSION "0.0.1"
+
+typedef struct {
+    int enabled;
+    char dir[PATH_MAX];
+    char key[65];            // hex SHA-256
+    char compiler[65];       // digest of the compiler executable
+    unsigned long long max_bytes;
+} BuildCache;
+
+// Computes the key for this compilation. Returns 0 (cache disabled) if the
+// cache directory is unusable; callers then build normally.
+int cache_open(BuildCache* cache, const char* source, size_t source_len,
+               const char* flags, const char* runtime_path);
+
+// Copies the cached artifact ("o" or "bin") to dest. Returns 1 on a hit.
+int cache_fetch(BuildCache* cache, const char* kind, const char* dest);
+
+// Stores a freshly built artifact and evicts old entries if over budget.
+void cache_store(BuildCache* cache, const char* kind, const char* src);
+
+// Key of the parsed AST of 'source' for the compiler with digest 'compiler'
+void cache_ast_key(const char* compiler, const char* source, size_t source_len, char key[65]);
+
+// SHA-256 of a file's contents, memoized in a stamp file under cache->dir.
+int cache_file_digest(BuildCache* cache, const char* path, char hex[65]);
+
+#endif
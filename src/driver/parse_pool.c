@@ -0,0 +1,63 @@
+/* Aria_lang/src/driver/parse_pool.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "../frontend/parser.h"
+#include "parse_pool.h"
+
+#define MAX_PARSE_THREADS 64
+
+typedef struct {
+    ParseJob* jobs;
+    int count;
+    int next;               // next job to hand out
+    pthread_mutex_t lock;
+} ParsePool;
+
+static void run_job(ParseJob* job) {
+    Parser* parser = malloc(sizeof(Parser));
+    if (!parser) { fprintf(stderr, "Fatal: Out of memory allocating parser.\n"); exit(1); }
+    job->arena = arena_create(job->length);
+    if (!job->arena) {
+        job->ok = 0;
+        free(parser);
+        return;
+    }
+    parser_init(parser, job->source, job->length, job->arena, job->path);
+    job->root = parser_parse(parser);
+    job->ok = !parser->had_error;
+    free(parser);
+}
+
+static void* parse_worker(void* arg) {
+    ParsePool* pool = (ParsePool*)arg;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        int i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->count) return NULL;
+        run_job(&pool->jobs[i]);
+    }
+}
+
+int parse_files(ParseJob* jobs, int count, int threads) {
+    ParsePool pool;
+    pool.jobs = jobs;
+    pool.count = count;
+    pool.next = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+
+    if (threads > count) threads = count;
+    if (threads > MAX_PARSE_THREADS) threads = MAX_PARSE_THREADS;
+    pthread_t workers[MAX_PARSE_THREADS];
+    int started = 0;
+    // The calling thread is one of the workers
+    while (started < threads - 1 && pthread_create(&workers[started], NULL, parse_worker, &pool) == 0) started++;
+    parse_worker(&pool);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    pthread_mutex_destroy(&pool.lock);
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) failed += !jobs[i].ok;
+    return failed;
+}
@@ -0,0 +1,29 @@
+/* Aria_lang/src/driver/parse_pool.h */
+#ifndef ARIA_PARSE_POOL_H
+#define ARIA_PARSE_POOL_H
+
+#include "../frontend/ast.h"
+
+/*
+ * Parallel Parsing
+ * ----------------
+ * Parses many sources at once on a pool of threads. Every job gets its own
+ * Parser and arena, so jobs share nothing but the read-only parse rules;
+ * workers take the next unparsed job until none are left. Errors are
+ * reported per file as they are found.
+ */
+
+typedef struct {
+    const char* path;       // prefixes error messages
+    const char* source;
+    size_t length;
+    AstArena* arena;        // created by parse_files, owned by the caller
+    AstNode* root;
+    int ok;
+} ParseJob;
+
+// Parses every job on up to 'threads' threads (1 parses on the calling
+// thread). Returns the number of jobs that had errors.
+int parse_files(ParseJob* jobs, int count, int threads);
+
+#endif
@@ -0,0 +1,23 @@
+/* Aria_lang/src/driver/sha256.h */
+#ifndef ARIA_SHA256_H
+#define ARIA_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming SHA-256 (FIPS 180-4), used for content-addressed cache keys
+typedef struct {
+    uint32_t state[8];
+    uint64_t bit_len;
+    uint8_t block[64];
+    size_t block_len;
+} Sha256;
+
+void sha256_init(Sha256* ctx);
+void sha256_update(Sha256* ctx, const void* data, size_t len);
+void sha256_final(Sha256* ctx, uint8_t digest[32]);
+
+// Finishes the hash and writes 64 lowercase hex digits plus NUL
+void sha256_final_hex(Sha256* ctx, char hex[65]);
+
+#endif
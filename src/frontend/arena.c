@@ -4,17 +4,35 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /* 
  * OPTIMIZATION CONSTANTS
  * ----------------------
- * NODES_PER_PAGE: Defines the granularity of AST node allocation. 
- * Larger pages reduce malloc overhead but increase fragmentation.
- * 
+ * NODES_PER_COMMIT: Nodes are carved out of one reserved address range
+ * (see "Compact Node Layout" in ast.h); pages are made accessible this
+ * many node slots at a time. Untouched pages cost no memory, so this only
+ * bounds the number of mprotect calls.
+ *
+ * NODES_PER_SOURCE_BYTE: An arena reserves node slots for its source at
+ * this rate. Real programs make about one node per four bytes; operator
+ * chains such as 1+1+1 approach one per byte.
+ *
+ * MIN_NODES: Smallest reservation, used for short sources and as the floor
+ * when the address space is limited (ulimit -v, many parse threads).
+ *
  * STRING_BLOCK_SIZE: 64KB blocks for string data storage. 
- * This fits well within L2 caches of modern CPUs.
+ * This fits well within L2 caches of modern CPUs. Longer strings get a
+ * block of their own, sized to fit.
  */
-#define NODES_PER_PAGE 2048
+#define NODES_PER_COMMIT (1024 * 64)
+#define MAX_NODES ((AST_REGION_SIZE - AST_TYPES_SIZE) / sizeof(AstNode))
+#define NODES_PER_SOURCE_BYTE 2
+#define MIN_NODES (NODES_PER_COMMIT * 4)
+#define PLACEMENT_TRIES 64
 #define STRING_BLOCK_SIZE (1024 * 64) 
 
 /* 
@@ -27,16 +45,11 @@
 
 // --- Internal Structures ---
 
-struct ArenaPage {
-    AstNode nodes[NODES_PER_PAGE];
-    struct ArenaPage* next;
-    int count;
-};
-
 typedef struct StringBlock {
-    char data[STRING_BLOCK_SIZE];
     struct StringBlock* next;
     size_t used;
+    size_t capacity;
+    char data[];
 } StringBlock;
 
 /*
@@ -53,12 +66,17 @@ typedef struct {
 
 struct AstArena {
     // Node Allocation State
-    struct ArenaPage* head;
-    struct ArenaPage* current;
+    char* region;           // aligned to AST_REGION_SIZE (see arena_map_aligned)
+    uint8_t* types;         // type byte per node slot, at the region start
+    AstNode* nodes;         // node slots; slot 0 stays unused (AstRef 0)
+    size_t capacity;        // node slots the reservation covers
+    size_t node_count;
+    size_t committed;       // slots made accessible so far
     
     // String Allocation State
     StringBlock* str_head;
     StringBlock* str_current;
+    StringBlock* str_reserved;  // block holding an uncommitted reservation
 
     // Interning State (Hash Table)
     InternEntry* intern_table;
@@ -82,28 +100,100 @@ static uint32_t fnv1a_hash(const char* str, int len) {
 
 // --- Allocation Helpers ---
 
-static struct ArenaPage* arena_new_page() {
-    struct ArenaPage* page = (struct ArenaPage*)malloc(sizeof(struct ArenaPage));
-    if (!page) {
-        fprintf(stderr, "Fatal: Out of memory allocating AST page.\n");
+/*
+ * Maps inaccessible type bytes and node slots for 'nodes' nodes at an
+ * AST_REGION_SIZE-aligned address, the slots AST_TYPES_SIZE above it.
+ * Instead of mapping a whole extra region to trim, a trial mapping shows
+ * where the kernel has room and the aligned addresses at or below it are
+ * offered as hints until both ranges land where asked. NULL if none does.
+ */
+static char* arena_map_aligned(size_t nodes) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    size_t node_bytes = nodes * sizeof(AstNode);
+    char* probe = mmap(NULL, node_bytes, PROT_NONE, flags, -1, 0);
+    if (probe == MAP_FAILED) return NULL;
+    munmap(probe, node_bytes);
+
+    uintptr_t hint = (uintptr_t)probe & ~(AST_REGION_SIZE - 1);
+    for (int i = 0; i < PLACEMENT_TRIES && hint != 0; i++, hint -= AST_REGION_SIZE) {
+        char* types = mmap((void*)hint, nodes, PROT_NONE, flags, -1, 0);
+        if (types == MAP_FAILED) return NULL;
+        char* slots = MAP_FAILED;
+        if ((uintptr_t)types == hint) {
+            slots = mmap(types + AST_TYPES_SIZE, node_bytes, PROT_NONE, flags, -1, 0);
+            if (slots == types + AST_TYPES_SIZE) return types;
+        }
+        munmap(types, nodes);
+        if (slots != MAP_FAILED) munmap(slots, node_bytes);
+    }
+    return NULL;
+}
+
+/*
+ * Reserves room for 'nodes' nodes, halving the count down to MIN_NODES
+ * while the address space refuses it. Returns 0 if even that fails.
+ */
+static int arena_reserve_region(AstArena* arena, size_t nodes) {
+    if (nodes > MAX_NODES) nodes = MAX_NODES;
+    for (;; nodes /= 2) {
+        if (nodes < MIN_NODES) nodes = MIN_NODES;
+        nodes = nodes / NODES_PER_COMMIT * NODES_PER_COMMIT;
+        char* region = arena_map_aligned(nodes);
+        if (region) {
+            arena->region = region;
+            arena->capacity = nodes;
+            return 1;
+        }
+        if (nodes == MIN_NODES) return 0;
+    }
+}
+
+// Makes the next NODES_PER_COMMIT node slots and their type bytes writable
+static void arena_commit_nodes(AstArena* arena) {
+    if (arena->committed + NODES_PER_COMMIT > arena->capacity) {
+        fprintf(stderr, "Fatal: AST exceeds %zu nodes.\n", arena->capacity);
+        exit(1);
+    }
+    if (mprotect(arena->nodes + arena->committed, NODES_PER_COMMIT * sizeof(AstNode), PROT_READ | PROT_WRITE) != 0 ||
+        mprotect(arena->types + arena->committed, NODES_PER_COMMIT, PROT_READ | PROT_WRITE) != 0) {
+        fprintf(stderr, "Fatal: Out of memory allocating AST nodes.\n");
         exit(1);
     }
-    page->next = NULL;
-    page->count = 0;
-    return page;
+    arena->committed += NODES_PER_COMMIT;
 }
 
-static StringBlock* arena_new_str_block() {
-    StringBlock* block = (StringBlock*)malloc(sizeof(StringBlock));
+static StringBlock* arena_new_str_block(size_t capacity) {
+    StringBlock* block = (StringBlock*)malloc(sizeof(StringBlock) + capacity);
     if (!block) {
         fprintf(stderr, "Fatal: Out of memory allocating String block.\n");
         exit(1);
     }
     block->next = NULL;
     block->used = 0;
+    block->capacity = capacity;
     return block;
 }
 
+/*
+ * Returns the block that will hold the next 'size' bytes, without marking
+ * them used. Sizes over STRING_BLOCK_SIZE get a dedicated block linked at
+ * the head of the list, so the current block keeps filling.
+ */
+static StringBlock* arena_str_block_for(AstArena* arena, size_t size) {
+    if (size > STRING_BLOCK_SIZE) {
+        StringBlock* big = arena_new_str_block(size);
+        big->next = arena->str_head;
+        arena->str_head = big;
+        return big;
+    }
+    if (arena->str_current->used + size > arena->str_current->capacity) {
+        StringBlock* new_block = arena_new_str_block(STRING_BLOCK_SIZE);
+        arena->str_current->next = new_block;
+        arena->str_current = new_block;
+    }
+    return arena->str_current;
+}
+
 // --- Interning Logic ---
 
 /*
@@ -141,15 +231,24 @@ static void arena_resize_intern_table(AstArena* arena) {
 
 // --- Public Interface ---
 
-AstArena* arena_create() {
+AstArena* arena_create(size_t source_length) {
     AstArena* arena = (AstArena*)malloc(sizeof(AstArena));
     if (!arena) exit(1);
     
-    arena->head = arena_new_page();
-    arena->current = arena->head;
+    if (!arena_reserve_region(arena, source_length * NODES_PER_SOURCE_BYTE)) {
+        fprintf(stderr, "Error: Could not reserve address space for the AST.\n");
+        free(arena);
+        return NULL;
+    }
+    arena->types = (uint8_t*)arena->region;
+    arena->nodes = (AstNode*)(arena->region + AST_TYPES_SIZE);
+    arena->committed = 0;
+    arena_commit_nodes(arena);
+    arena->node_count = 1;
 
-    arena->str_head = arena_new_str_block();
+    arena->str_head = arena_new_str_block(STRING_BLOCK_SIZE);
     arena->str_current = arena->str_head;
+    arena->str_reserved = NULL;
 
     // Initialize Intern Table
     arena->intern_capacity = INITIAL_INTERN_CAPACITY;
@@ -165,35 +264,23 @@ AstArena* arena_create() {
 }
 
 AstNode* arena_alloc(AstArena* arena) {
-    struct ArenaPage* page = arena->current;
-    
-    if (page->count >= NODES_PER_PAGE) {
-        struct ArenaPage* new_page = arena_new_page();
-        page->next = new_page;
-        arena->current = new_page;
-        page = new_page;
-    }
-    
-    AstNode* node = &page->nodes[page->count++];
-    // Zero-init is crucial for AST processing safety
-    memset(node, 0, sizeof(AstNode));
-    return node;
+    if (arena->node_count == arena->committed) arena_commit_nodes(arena);
+
+    // Freshly committed pages are zero-filled, so a new node already has
+    // no links, no payload and type 0; nodes are never reused
+    return &arena->nodes[arena->node_count++];
+}
+
+size_t arena_node_count(AstArena* arena) {
+    return arena->node_count - 1;
 }
 
 /*
- * arena_strndup (INTERNING VERSION)
- * ---------------------------------
- * 1. Computes hash of incoming string.
- * 2. Checks table for existence.
- *    - If found (Hash matches AND strcmp matches), return existing pointer.
- * 3. If not found:
- *    - Check load factor and resize table if necessary.
- *    - Allocate string bytes in the linear StringBlock.
- *    - Insert new entry into the hash table.
- *    - Return new pointer.
+ * Finds 'str' in the intern table. Returns the canonical pointer, or NULL
+ * with *slot set to the empty slot where it belongs (the table is grown
+ * first if an insertion would push it past 75% load).
  */
-char* arena_strndup(AstArena* arena, const char* str, int len) {
-    uint32_t hash = fnv1a_hash(str, len);
+static char* arena_intern_find(AstArena* arena, const char* str, int len, uint32_t hash, uint32_t* slot) {
     uint32_t idx = hash & (arena->intern_capacity - 1);
 
     // 1. Check for existing string (Lookup Phase)
@@ -210,7 +297,7 @@ char* arena_strndup(AstArena* arena, const char* str, int len) {
         idx = (idx + 1) & (arena->intern_capacity - 1);
     }
 
-    // 2. Not found, prepare to allocate (Insertion Phase)
+    // 2. Not found, prepare the insertion slot
     
     // Check Load Factor: count * 4 > capacity * 3 implies > 75% full
     if (arena->intern_count * 4 > arena->intern_capacity * 3) { 
@@ -221,41 +308,314 @@ char* arena_strndup(AstArena* arena, const char* str, int len) {
             idx = (idx + 1) & (arena->intern_capacity - 1);
         }
     }
+    *slot = idx;
+    return NULL;
+}
 
-    // Allocate in StringBlock
-    if (arena->str_current->used + len + 1 > STRING_BLOCK_SIZE) {
-        // Edge Case: String larger than block size?
-        if (len + 1 > STRING_BLOCK_SIZE) {
-            fprintf(stderr, "Fatal: String literal too large for arena block (>64KB).\n");
-            exit(1);
-        }
-        StringBlock* new_block = arena_new_str_block();
-        arena->str_current->next = new_block;
-        arena->str_current = new_block;
-    }
+static void arena_intern_insert(AstArena* arena, char* str, uint32_t hash, uint32_t slot) {
+    arena->intern_table[slot].hash = hash;
+    arena->intern_table[slot].str = str;
+    arena->intern_count++;
+}
 
-    char* ptr = &arena->str_current->data[arena->str_current->used];
+/*
+ * arena_strndup (INTERNING VERSION)
+ * ---------------------------------
+ * 1. Computes hash of incoming string.
+ * 2. Checks table for existence.
+ *    - If found (Hash matches AND strcmp matches), return existing pointer.
+ * 3. If not found:
+ *    - Allocate string bytes in the linear StringBlock.
+ *    - Insert new entry into the hash table.
+ *    - Return new pointer.
+ */
+char* arena_strndup(AstArena* arena, const char* str, int len) {
+    uint32_t hash = fnv1a_hash(str, len);
+    uint32_t slot;
+    char* existing = arena_intern_find(arena, str, len, hash, &slot);
+    if (existing) return existing;
+
+    StringBlock* block = arena_str_block_for(arena, (size_t)len + 1);
+    char* ptr = &block->data[block->used];
     memcpy(ptr, str, len);
     ptr[len] = '\0';
-    arena->str_current->used += (len + 1);
-
-    // 3. Insert into Intern Table
-    arena->intern_table[idx].hash = hash;
-    arena->intern_table[idx].str = ptr;
-    arena->intern_count++;
+    block->used += (size_t)len + 1;
 
+    arena_intern_insert(arena, ptr, hash, slot);
     return ptr;
 }
 
-void arena_free(AstArena* arena) {
-    // 1. Free Node Pages
-    struct ArenaPage* current = arena->head;
-    while (current) {
-        struct ArenaPage* next = current->next;
-        free(current);
-        current = next;
+/*
+ * Decoding in place
+ * -----------------
+ * A reservation is scratch space at the free end of a string block: the
+ * caller writes up to max_len bytes there and commits the length it used.
+ * Commit interns the bytes where they lie, so decoded literals are written
+ * once instead of being built in a temporary buffer and copied. When the
+ * string is already interned the reservation is simply dropped. No other
+ * string may be allocated between the two calls.
+ */
+char* arena_str_reserve(AstArena* arena, size_t max_len) {
+    arena->str_reserved = arena_str_block_for(arena, max_len + 1);
+    StringBlock* block = arena->str_reserved;
+    return &block->data[block->used];
+}
+
+char* arena_str_commit(AstArena* arena, char* str, int len) {
+    StringBlock* block = arena->str_reserved;
+    arena->str_reserved = NULL;
+    str[len] = '\0';
+
+    uint32_t hash = fnv1a_hash(str, len);
+    uint32_t slot;
+    char* existing = arena_intern_find(arena, str, len, hash, &slot);
+    if (existing) {
+        // A dedicated block linked in by the reservation is not needed after all
+        if (block->capacity > STRING_BLOCK_SIZE && block->used == 0) {
+            arena->str_head = block->next;
+            free(block);
+        }
+        return existing;
+    }
+    block->used += (size_t)len + 1;
+    arena_intern_insert(arena, str, hash, slot);
+    return str;
+}
+
+// --- Serialized Arenas ---
+
+/*
+ * File layout, every section starting on a page boundary:
+ *
+ *   header | type bytes | nodes | string bytes | intern table
+ *
+ * Node links are already indices and need nothing. Strings are written as
+ * the concatenated used part of every string block; a node's string field
+ * and an intern entry hold the offset into that blob plus one (0 for NULL).
+ * Loading maps the types and nodes straight over the arena's region
+ * (private, so later passes may still modify nodes) and rebases the string
+ * fields, the only pointers a node holds. The key names the compiler that
+ * wrote the file, which fixes the node layout.
+ */
+#define AST_FILE_MAGIC "ARIAAST1"
+
+typedef struct {
+    char magic[8];
+    char key[64];
+    uint32_t root;
+    uint32_t node_count;        // slots, including the unused slot 0
+    uint64_t types_offset;
+    uint64_t nodes_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t intern_offset;
+    uint64_t intern_capacity;
+    uint64_t intern_count;
+} AstFileHeader;
+
+typedef struct {
+    StringBlock* block;
+    uint64_t offset;            // of the block's bytes within the blob
+} BlockSpan;
+
+static int node_has_string(AstType type) {
+    switch (type) {
+        case NODE_FUNC_DECL: case NODE_VAR_DECL: case NODE_VAR_ACCESS:
+        case NODE_ASSIGN: case NODE_GET: case NODE_SET: case NODE_CLASS_DECL:
+        case NODE_STRING: case NODE_NEW: case NODE_IMPORT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static uint64_t page_round(uint64_t n) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    return (n + page - 1) / page * page;
+}
+
+static int compare_spans(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t)((const BlockSpan*)a)->block, y = (uintptr_t)((const BlockSpan*)b)->block;
+    return (x > y) - (x < y);
+}
+
+// Blob offset plus one of an arena string, found by binary search on address
+static uint64_t string_ref(const BlockSpan* spans, int count, const char* str) {
+    if (!str) return 0;
+    int lo = 0, hi = count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((uintptr_t)spans[mid].block->data <= (uintptr_t)str) lo = mid;
+        else hi = mid - 1;
+    }
+    return spans[lo].offset + (uint64_t)(str - spans[lo].block->data) + 1;
+}
+
+static int write_padding(FILE* f, uint64_t offset) {
+    static const char zeros[4096];
+    long at = ftell(f);
+    if (at < 0) return 0;
+    for (uint64_t n = offset - (uint64_t)at; n > 0; ) {
+        size_t chunk = n < sizeof(zeros) ? (size_t)n : sizeof(zeros);
+        if (fwrite(zeros, 1, chunk, f) != chunk) return 0;
+        n -= chunk;
+    }
+    return 1;
+}
+
+static int write_arena(AstArena* arena, AstNode* root, const char* key, FILE* f) {
+    int span_count = 0;
+    for (StringBlock* b = arena->str_head; b; b = b->next) span_count++;
+    BlockSpan* spans = malloc(sizeof(BlockSpan) * span_count);
+    if (!spans) return 0;
+    span_count = 0;
+    for (StringBlock* b = arena->str_head; b; b = b->next) spans[span_count++].block = b;
+    qsort(spans, span_count, sizeof(BlockSpan), compare_spans);
+    uint64_t strings_size = 0;
+    for (int i = 0; i < span_count; i++) {
+        spans[i].offset = strings_size;
+        strings_size += spans[i].block->used;
+    }
+
+    AstFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, AST_FILE_MAGIC, 8);
+    memcpy(h.key, key, 64);
+    h.root = ast_ref(root);
+    h.node_count = (uint32_t)arena->node_count;
+    h.types_offset = page_round(sizeof(h));
+    h.nodes_offset = h.types_offset + page_round(arena->node_count);
+    h.strings_offset = h.nodes_offset + page_round(arena->node_count * sizeof(AstNode));
+    h.strings_size = strings_size;
+    h.intern_offset = h.strings_offset + page_round(strings_size);
+    h.intern_capacity = arena->intern_capacity;
+    h.intern_count = arena->intern_count;
+
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1 && write_padding(f, h.types_offset) &&
+             fwrite(arena->types, 1, arena->node_count, f) == arena->node_count &&
+             write_padding(f, h.nodes_offset);
+
+    AstNode buf[1024];
+    for (size_t i = 0; ok && i < arena->node_count; i += 1024) {
+        size_t n = arena->node_count - i < 1024 ? arena->node_count - i : 1024;
+        memcpy(buf, &arena->nodes[i], n * sizeof(AstNode));
+        for (size_t j = 0; j < n; j++) {
+            if (!node_has_string((AstType)arena->types[i + j])) continue;
+            buf[j].data.string_val = (char*)(uintptr_t)string_ref(spans, span_count, buf[j].data.string_val);
+        }
+        ok = fwrite(buf, sizeof(AstNode), n, f) == n;
+    }
+
+    ok = ok && write_padding(f, h.strings_offset);
+    for (int i = 0; ok && i < span_count; i++) {
+        ok = fwrite(spans[i].block->data, 1, spans[i].block->used, f) == spans[i].block->used;
+    }
+    ok = ok && write_padding(f, h.intern_offset);
+    for (size_t i = 0; ok && i < arena->intern_capacity; i++) {
+        InternEntry entry = arena->intern_table[i];
+        entry.str = (char*)(uintptr_t)string_ref(spans, span_count, entry.str);
+        ok = fwrite(&entry, sizeof(entry), 1, f) == 1;
+    }
+    free(spans);
+    return ok;
+}
+
+int arena_save(AstArena* arena, AstNode* root, const char* key, const char* path) {
+    // Write then rename so a concurrent compiler never maps a partial file
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return 0;
+    int ok = write_arena(arena, root, key, f);
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return 0;
+    }
+    return 1;
+}
+
+static int header_fits(const AstFileHeader* h, const char* key, uint64_t file_size, size_t capacity) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    if (memcmp(h->magic, AST_FILE_MAGIC, 8) != 0 || memcmp(h->key, key, 64) != 0) return 0;
+    if (h->node_count < 1 || h->node_count > capacity || h->root >= h->node_count) return 0;
+    if (h->types_offset % page || h->nodes_offset % page) return 0;
+    if (h->intern_capacity == 0 || (h->intern_capacity & (h->intern_capacity - 1)) ||
+        h->intern_count >= h->intern_capacity) return 0;
+    return h->types_offset + h->node_count <= h->nodes_offset &&
+           h->nodes_offset + page_round(h->node_count * sizeof(AstNode)) <= h->strings_offset &&
+           h->strings_offset + h->strings_size <= h->intern_offset &&
+           h->intern_offset + h->intern_capacity * sizeof(InternEntry) <= file_size;
+}
+
+// Turns a stored blob offset back into a pointer; 0 if it is out of range
+static int rebase_string(char** field, StringBlock* blob) {
+    uint64_t ref = (uint64_t)(uintptr_t)*field;
+    if (ref > blob->used) return 0;
+    *field = ref ? blob->data + ref - 1 : NULL;
+    return 1;
+}
+
+int arena_load(AstArena* arena, const char* key, const char* path, AstNode** root) {
+    if (arena->node_count != 1) return 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    AstFileHeader h;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        !header_fits(&h, key, (uint64_t)st.st_size, arena->capacity)) {
+        close(fd);
+        return 0;
+    }
+
+    // Strings and the intern table are read and checked before the arena changes
+    StringBlock* blob = arena_new_str_block(h.strings_size);
+    InternEntry* table = malloc(h.intern_capacity * sizeof(InternEntry));
+    int ok = table != NULL &&
+             pread(fd, blob->data, h.strings_size, h.strings_offset) == (ssize_t)h.strings_size &&
+             pread(fd, table, h.intern_capacity * sizeof(InternEntry), h.intern_offset) ==
+                 (ssize_t)(h.intern_capacity * sizeof(InternEntry));
+    blob->used = h.strings_size;
+    for (uint64_t i = 0; ok && i < h.intern_capacity; i++) ok = rebase_string(&table[i].str, blob);
+
+    size_t types_bytes = page_round(h.node_count);
+    size_t node_bytes = page_round(h.node_count * sizeof(AstNode));
+    ok = ok && mmap(arena->types, types_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                    fd, h.types_offset) != MAP_FAILED;
+    ok = ok && mmap(arena->nodes, node_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                    fd, h.nodes_offset) != MAP_FAILED;
+    close(fd);
+    for (uint32_t i = 1; ok && i < h.node_count; i++) {
+        if (node_has_string((AstType)arena->types[i])) ok = rebase_string(&arena->nodes[i].data.string_val, blob);
     }
 
+    if (!ok) {
+        // Put fresh zero pages back over anything that was mapped
+        mmap(arena->types, types_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        mmap(arena->nodes, node_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        free(blob);
+        free(table);
+        return 0;
+    }
+
+    while (arena->committed < h.node_count) arena_commit_nodes(arena);
+    arena->node_count = h.node_count;
+    blob->next = arena->str_head;
+    arena->str_head = blob;
+    free(arena->intern_table);
+    arena->intern_table = table;
+    arena->intern_capacity = h.intern_capacity;
+    arena->intern_count = h.intern_count;
+    *root = h.root ? &arena->nodes[h.root] : NULL;
+    return 1;
+}
+
+void arena_free(AstArena* arena) {
+    // 1. Release the Node Region
+    munmap(arena->types, arena->capacity);
+    munmap(arena->nodes, arena->capacity * sizeof(AstNode));
+
     // 2. Free String Blocks
     StringBlock* str_curr = arena->str_head;
     while (str_curr) {
@@ -15,108 +15,169 @@ typedef enum {
     NODE_IF, NODE_WHILE, NODE_BREAK, NODE_CONTINUE,
     NODE_ASSIGN, NODE_GET, NODE_SET,       
     NODE_INDEX_GET, NODE_INDEX_SET, NODE_ARRAY_LITERAL,
-    NODE_TERNARY
+    NODE_TERNARY,
+    NODE_IMPORT,             // top-level 'import name;', module name in string_val
+    NODE_FOR,                // counted range or list for-each loop
+    NODE_MATCH,              // match (subject) { cases -> stmt ... else -> stmt }
+    NODE_MATCH_ARM
 } AstType;
 
 struct AstNode;
 
+/*
+ * Compact Node Layout
+ * -------------------
+ * Every node of an arena lives in one contiguous array inside an
+ * AST_REGION_SIZE-aligned address reservation, sized from the source
+ * rather than the whole region (see arena.c). Links between nodes are
+ * 32-bit indices into that array (AstRef, 0 meaning none) instead of
+ * pointers, and node types are kept in a byte array at the start of the
+ * region rather than in the node, so a node is 32 bytes where it was 64.
+ *
+ * Since a region is aligned to its size, the array base is recovered from
+ * any node address: ast_at(owner, ref) resolves a link stored in 'owner',
+ * ast_ref(node) produces one. Nodes never move, so passes keep holding
+ * AstNode pointers; only the stored links are indices.
+ */
+typedef uint32_t AstRef;
+
+#define AST_REGION_SIZE ((uintptr_t)1 << 32)
+#define AST_TYPES_SIZE (AST_REGION_SIZE / 32)   // one type byte per node slot
+
 // --- Node Data Structures ---
 
 typedef struct {
     char* name;
-    char* type_name;
-    struct AstNode* init_expr;
-    int is_managed;          
+    AstRef init_expr;
     int shadow_stack_offset; // Unique Variable ID
+    uint8_t is_managed;
+    uint8_t is_captured;     // referenced from a nested function
+    uint8_t is_mutated;      // assigned after its declaration
+    uint8_t is_boxed;        // captured and mutated: lives in a heap cell
 } VarDeclData;
 
 typedef struct {
     char* name;
     int id; // Resolved Unique Variable ID
+    AstRef decl;             // declaring NODE_VAR_DECL for locals, 0 otherwise
 } VarAccessData;
 
 typedef struct {
     char* name;
-    struct AstNode* params; 
-    struct AstNode* body;   
-    int is_closure;         
-    int upvalue_count;      
+    AstRef params;
+    AstRef body;
+    AstRef upvalues;         // closures: captured variables (NODE_VAR_ACCESS), in record order
+    unsigned upvalue_count : 31;
+    unsigned is_closure : 1;
 } FuncDeclData;
 
 typedef struct {
     TokenType op;
-    struct AstNode* left;
-    struct AstNode* right;
+    AstRef left;
+    AstRef right;
 } BinaryOpData;
 
 typedef struct {
-    struct AstNode* condition;
-    struct AstNode* then_branch;
-    struct AstNode* else_branch;
+    AstRef body;             // first statement, the rest linked through 'next'
+} BlockData;
+
+typedef struct {
+    AstRef condition;
+    AstRef then_branch;
+    AstRef else_branch;
 } IfStmtData;
 
 typedef struct {
-    struct AstNode* condition;
-    struct AstNode* body;
+    AstRef condition;
+    AstRef body;
 } WhileStmtData;
 
 typedef struct {
-    struct AstNode* expr; 
+    AstRef expr;
 } ReturnStmtData;
 
+// 'for (var i = start; i < limit; i = i + step)' whose body never assigns i,
+// or 'for (var x in list)'. Other for loops are desugared into NODE_WHILE.
+typedef struct {
+    AstRef var;               // loop variable (NODE_VAR_DECL)
+    AstRef iterable;          // ranges: the exclusive limit; for-each: the list
+    AstRef body;
+    AstRef start;             // ranges: NODE_LITERAL start and step values
+    AstRef step;
+    int is_each;
+} ForStmtData;
+
+// 'match (subject) { 1, 2 -> stmt  "get" -> stmt  else -> stmt }'. Arms are
+// tried as a whole (no fallthrough); backends dispatch by table or hash.
+typedef struct {
+    AstRef subject;
+    AstRef arms;               // NODE_MATCH_ARM list in source order
+    AstRef otherwise;          // 'else' body, or 0
+} MatchData;
+
+typedef struct {
+    AstRef patterns;           // NODE_LITERAL / NODE_STRING list
+    AstRef body;
+} MatchArmData;
+
 // FIX: Added 'id' to track assignment target resolution
 typedef struct {
     char* name;
     int id; 
-    struct AstNode* value;
+    AstRef value;
+    AstRef decl;             // declaring NODE_VAR_DECL for locals, 0 otherwise
 } AssignData;
 
 typedef struct {
-    struct AstNode* callee;
-    struct AstNode* args;
+    AstRef callee;
+    AstRef args;
 } CallData;
 
 typedef struct {
-    struct AstNode* obj;
     char* name;
-    struct AstNode* value; 
+    AstRef obj;
+    AstRef value;
 } PropAccessData;
 
 typedef struct {
-    struct AstNode* obj;
-    struct AstNode* index;
-    struct AstNode* value; 
+    AstRef obj;
+    AstRef index;
+    AstRef value;
 } IndexAccessData;
 
 typedef struct {
-    struct AstNode* elements;
+    AstRef elements;
     int count;
 } ArrayLitData;
 
 typedef struct {
-    struct AstNode* condition;
-    struct AstNode* true_expr;
-    struct AstNode* false_expr;
+    AstRef condition;
+    AstRef true_expr;
+    AstRef false_expr;
 } TernaryData;
 
 typedef struct {
     char* name;
-    struct AstNode* methods;
+    AstRef methods;
+    int is_extern;           // layout imported from another module's interface
 } ClassDeclData;
 
 // --- Unified Node ---
 
 typedef struct AstNode {
-    AstType type;
     int line;
-    struct AstNode* next; 
+    AstRef next;
     union {
         FuncDeclData func_decl;
+        BlockData block;
         VarDeclData var_decl;
         VarAccessData var_access;
         BinaryOpData binary;
         IfStmtData if_stmt;
         WhileStmtData while_stmt;
+        ForStmtData for_stmt;
+        MatchData match;
+        MatchArmData match_arm;
         ReturnStmtData return_stmt;
         AssignData assign;
         CallData call;
@@ -127,8 +188,10 @@ typedef struct AstNode {
         ArrayLitData array_literal;
         TernaryData ternary;
         ClassDeclData class_decl;
-        
-        char* string_val;   
+
+        // Every node's name or text is the first member of its payload and
+        // lives in the arena, so this aliases all of them (see arena_save)
+        char* string_val;
         int64_t int_val; 
         double double_val; 
     } data;
@@ -137,9 +200,51 @@ typedef struct AstNode {
 // Opaque Arena Handle
 typedef struct AstArena AstArena;
 
-AstArena* arena_create(); 
+// Sized for a source of 'source_length' bytes. NULL, after reporting it, if
+// no address space is left for the nodes
+AstArena* arena_create(size_t source_length);
 AstNode* arena_alloc(AstArena* arena);
+size_t arena_node_count(AstArena* arena);
 void arena_free(AstArena* arena);
 char* arena_strndup(AstArena* arena, const char* str, int len);
+// Space for up to max_len bytes (plus a NUL) to write a string into directly;
+// commit the length written to intern it (see arena.c)
+char* arena_str_reserve(AstArena* arena, size_t max_len);
+char* arena_str_commit(AstArena* arena, char* str, int len);
+
+// Writes the nodes, strings and intern table of a freshly parsed arena to
+// 'path' under 'key' (64 hex digits). Returns 0 if the file was not written.
+int arena_save(AstArena* arena, AstNode* root, const char* key, const char* path);
+// Maps a file written by arena_save into the empty 'arena'. Returns 0, with
+// the arena untouched, if the file is missing, damaged or has another key.
+int arena_load(AstArena* arena, const char* key, const char* path, AstNode** root);
+
+// --- Node Access ---
+
+static inline AstNode* ast_nodes(const AstNode* node) {
+    return (AstNode*)(((uintptr_t)node & ~(AST_REGION_SIZE - 1)) + AST_TYPES_SIZE);
+}
+
+// Link stored in 'owner' to the node it names, or NULL
+static inline AstNode* ast_at(const AstNode* owner, AstRef ref) {
+    return ref ? ast_nodes(owner) + ref : NULL;
+}
+
+// Link to 'node' (0 for NULL); only valid within the node's own arena
+static inline AstRef ast_ref(const AstNode* node) {
+    return node ? (AstRef)(node - ast_nodes(node)) : 0;
+}
+
+static inline AstType ast_type(const AstNode* node) {
+    return (AstType)((const uint8_t*)ast_nodes(node) - AST_TYPES_SIZE)[node - ast_nodes(node)];
+}
+
+static inline void ast_set_type(AstNode* node, AstType type) {
+    ((uint8_t*)ast_nodes(node) - AST_TYPES_SIZE)[node - ast_nodes(node)] = (uint8_t)type;
+}
+
+// Follows the link 'field' (e.g. binary.left) or the sibling link of 'node'
+#define AST_KID(node, field) ast_at((node), (node)->data.field)
+#define AST_NEXT(node) ast_at((node), (node)->next)
 
 #endif
@@ -2,255 +2,422 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include "token.h"
 
-static const char* start;
-static const char* current;
-static int line;
+/*
+ * Vector scans
+ * ------------
+ * The hot loops of a lexer are runs of bytes that all belong to one class:
+ * indentation, comment text, string bodies and identifier characters. They
+ * are scanned bytewise through the CHAR_CLASS table. Define
+ * ARIA_VECTOR_LEXER to continue a blank, comment or string run that is still
+ * going after SCAN_WIDTH bytes with SSE2 or AVX2, SCAN_WIDTH bytes at a time,
+ * its length read off a bit mask. That only pays on long runs: on ordinary
+ * code, where most runs are a few bytes, it measures no faster
+ * (scripts/bench_lexer.sh). Vector loads never read past lexer->end, so the
+ * tail of a buffer is scanned bytewise.
+ */
+#if defined(__AVX2__) && defined(ARIA_VECTOR_LEXER)
+#include <immintrin.h>
+#define SCAN_WIDTH 32
+typedef __m256i ScanVec;
+static inline ScanVec scan_load(const char* p) { return _mm256_loadu_si256((const __m256i*)p); }
+static inline uint32_t scan_eq(ScanVec v, char c) {
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+}
+#elif defined(__SSE2__) && defined(ARIA_VECTOR_LEXER)
+#include <emmintrin.h>
+#define SCAN_WIDTH 16
+typedef __m128i ScanVec;
+static inline ScanVec scan_load(const char* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline uint32_t scan_eq(ScanVec v, char c) {
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+#endif
+
+// --- Character Classes ---
 
-void init_lexer(const char* source) {
-    start = source;
-    current = source;
-    line = 1;
+enum { CC_SPACE = 1, CC_DIGIT = 2, CC_ALPHA = 4, CC_HEX = 8 };
+
+// ASCII only, like the language; bytes >= 0x80 have no class
+static const uint8_t CHAR_CLASS[256] = {
+    ['\t'] = CC_SPACE, ['\n'] = CC_SPACE, ['\r'] = CC_SPACE, [' '] = CC_SPACE,
+    ['0'] = CC_DIGIT | CC_HEX, ['1'] = CC_DIGIT | CC_HEX, ['2'] = CC_DIGIT | CC_HEX,
+    ['3'] = CC_DIGIT | CC_HEX, ['4'] = CC_DIGIT | CC_HEX, ['5'] = CC_DIGIT | CC_HEX,
+    ['6'] = CC_DIGIT | CC_HEX, ['7'] = CC_DIGIT | CC_HEX, ['8'] = CC_DIGIT | CC_HEX,
+    ['9'] = CC_DIGIT | CC_HEX,
+    ['A'] = CC_ALPHA | CC_HEX, ['B'] = CC_ALPHA | CC_HEX, ['C'] = CC_ALPHA | CC_HEX,
+    ['D'] = CC_ALPHA | CC_HEX, ['E'] = CC_ALPHA | CC_HEX, ['F'] = CC_ALPHA | CC_HEX,
+    ['G'] = CC_ALPHA, ['H'] = CC_ALPHA, ['I'] = CC_ALPHA, ['J'] = CC_ALPHA, ['K'] = CC_ALPHA,
+    ['L'] = CC_ALPHA, ['M'] = CC_ALPHA, ['N'] = CC_ALPHA, ['O'] = CC_ALPHA, ['P'] = CC_ALPHA,
+    ['Q'] = CC_ALPHA, ['R'] = CC_ALPHA, ['S'] = CC_ALPHA, ['T'] = CC_ALPHA, ['U'] = CC_ALPHA,
+    ['V'] = CC_ALPHA, ['W'] = CC_ALPHA, ['X'] = CC_ALPHA, ['Y'] = CC_ALPHA, ['Z'] = CC_ALPHA,
+    ['_'] = CC_ALPHA,
+    ['a'] = CC_ALPHA | CC_HEX, ['b'] = CC_ALPHA | CC_HEX, ['c'] = CC_ALPHA | CC_HEX,
+    ['d'] = CC_ALPHA | CC_HEX, ['e'] = CC_ALPHA | CC_HEX, ['f'] = CC_ALPHA | CC_HEX,
+    ['g'] = CC_ALPHA, ['h'] = CC_ALPHA, ['i'] = CC_ALPHA, ['j'] = CC_ALPHA, ['k'] = CC_ALPHA,
+    ['l'] = CC_ALPHA, ['m'] = CC_ALPHA, ['n'] = CC_ALPHA, ['o'] = CC_ALPHA, ['p'] = CC_ALPHA,
+    ['q'] = CC_ALPHA, ['r'] = CC_ALPHA, ['s'] = CC_ALPHA, ['t'] = CC_ALPHA, ['u'] = CC_ALPHA,
+    ['v'] = CC_ALPHA, ['w'] = CC_ALPHA, ['x'] = CC_ALPHA, ['y'] = CC_ALPHA, ['z'] = CC_ALPHA,
+};
+
+static inline int has_class(char c, int cls) {
+    return (CHAR_CLASS[(uint8_t)c] & cls) != 0;
+}
+
+// --- Run Scanners ---
+
+#ifdef SCAN_WIDTH
+// skip_blanks past its first SCAN_WIDTH bytes
+static __attribute__((noinline)) const char* skip_blanks_wide(const char* p, const char* end, int* line) {
+    while (end - p >= SCAN_WIDTH) {
+        ScanVec v = scan_load(p);
+        uint32_t newline = scan_eq(v, '\n');
+        uint32_t blank = scan_eq(v, ' ') | scan_eq(v, '\t') | scan_eq(v, '\r') | newline;
+        uint32_t stop = ~blank;
+#if SCAN_WIDTH < 32
+        stop &= (1u << SCAN_WIDTH) - 1;
+#endif
+        if (stop) {
+            int n = __builtin_ctz(stop);
+            *line += __builtin_popcount(newline & ((1u << n) - 1));
+            return p + n;
+        }
+        *line += __builtin_popcount(newline);
+        p += SCAN_WIDTH;
+    }
+    while (p < end && has_class(*p, CC_SPACE)) {
+        if (*p == '\n') (*line)++;
+        p++;
+    }
+    return p;
 }
 
-static int is_at_end() {
-    return *current == '\0';
+// find_any past its first SCAN_WIDTH bytes
+static __attribute__((noinline)) const char* find_any_wide(const char* p, const char* end, char a, char b, char c) {
+    while (end - p >= SCAN_WIDTH) {
+        ScanVec v = scan_load(p);
+        uint32_t hit = scan_eq(v, a) | scan_eq(v, b) | scan_eq(v, c);
+        if (hit) return p + __builtin_ctz(hit);
+        p += SCAN_WIDTH;
+    }
+    while (p < end && *p != a && *p != b && *p != c) p++;
+    return p;
 }
+#endif
 
-static char advance() {
-    current++;
-    return current[-1];
+// Skips spaces, tabs and line breaks; adds the line breaks passed to *line
+static const char* skip_blanks(const char* p, const char* end, int* line) {
+#ifdef SCAN_WIDTH
+    const char* run_end = end - p > SCAN_WIDTH ? p + SCAN_WIDTH : end;
+#else
+    const char* run_end = end;
+#endif
+    while (p < run_end && has_class(*p, CC_SPACE)) {
+        if (*p == '\n') (*line)++;
+        p++;
+    }
+#ifdef SCAN_WIDTH
+    if (p == run_end && p < end) return skip_blanks_wide(p, end, line);
+#endif
+    return p;
 }
 
-static char peek() {
-    return *current;
+// First byte equal to a, b or c at or after p, or end
+static const char* find_any(const char* p, const char* end, char a, char b, char c) {
+#ifdef SCAN_WIDTH
+    const char* run_end = end - p > SCAN_WIDTH ? p + SCAN_WIDTH : end;
+#else
+    const char* run_end = end;
+#endif
+    while (p < run_end && *p != a && *p != b && *p != c) p++;
+#ifdef SCAN_WIDTH
+    if (p == run_end && p < end) return find_any_wide(p, end, a, b, c);
+#endif
+    return p;
 }
 
-static char peek_next() {
-    if (is_at_end()) return '\0';
-    return current[1];
+// First byte at or after p that cannot continue an identifier
+static const char* skip_ident(const char* p, const char* end) {
+    while (p < end && has_class(*p, CC_ALPHA | CC_DIGIT)) p++;
+    return p;
 }
 
-static int match_char(char expected) {
-    if (is_at_end()) return 0;
-    if (*current != expected) return 0;
-    current++;
-    return 1;
+// --- Scanner ---
+
+void lexer_init(Lexer* lexer, const char* source, size_t length) {
+    lexer->source = source;
+    lexer->start = source;
+    lexer->current = source;
+    lexer->end = source + length;
+    lexer->line = 1;
 }
 
-static Token make_token(TokenType type) {
+static Token make_token(Lexer* lx, TokenType type) {
     Token token;
     token.type = type;
-    token.start = start;
-    token.length = (int)(current - start);
-    token.line = line;
+    token.start = lx->start;
+    token.length = (int)(lx->current - lx->start);
+    token.line = lx->line;
     return token;
 }
 
-static Token error_token(const char* message) {
+static const char* const ERROR_MESSAGES[] = { "Unterminated string.", "Unexpected character." };
+enum { ERR_UNTERMINATED_STRING, ERR_UNEXPECTED_CHAR };
+
+static Token error_token(Lexer* lx, int error) {
     Token token;
     token.type = TOKEN_ERROR;
-    token.start = message;
-    token.length = (int)strlen(message);
-    token.line = line;
+    token.start = ERROR_MESSAGES[error];
+    token.length = (int)strlen(ERROR_MESSAGES[error]);
+    token.line = lx->line;
     return token;
 }
 
-static void skip_whitespace() {
+static int match_char(Lexer* lx, char expected) {
+    if (lx->current == lx->end || *lx->current != expected) return 0;
+    lx->current++;
+    return 1;
+}
+
+static void skip_whitespace(Lexer* lx) {
     for (;;) {
-        char c = peek();
-        switch (c) {
-            case ' ':
-            case '\t':
-                advance();
-                break;
-            case '\r':
-                advance();
-                if (peek() == '\n') {
-                    advance();
-                    line++;
-                }
-                break;
-            case '\n':
-                line++;
-                advance();
-                break;
-            case '/':
-                if (peek_next() == '/') {
-                    while (peek() != '\n' && !is_at_end()) advance();
-                } 
-                else if (peek_next() == '*') {
-                    advance();
-                    advance();
-                    while (!is_at_end()) {
-                        if (peek() == '*' && peek_next() == '/') {
-                            advance();
-                            advance();
-                            break;
-                        }
-                        if (peek() == '\n') line++;
-                        advance();
-                    }
-                } else {
-                    return;
-                }
-                break;
-            default:
-                return;
+        lx->current = skip_blanks(lx->current, lx->end, &lx->line);
+        if (lx->end - lx->current < 2 || lx->current[0] != '/') return;
+        if (lx->current[1] == '/') {
+            const char* eol = memchr(lx->current, '\n', lx->end - lx->current);
+            lx->current = eol ? eol : lx->end;
+        } else if (lx->current[1] == '*') {
+            const char* p = lx->current + 2;
+            for (;;) {
+                p = find_any(p, lx->end, '*', '\n', '\n');
+                if (p == lx->end) break;
+                if (*p == '\n') { lx->line++; p++; continue; }
+                if (p + 1 < lx->end && p[1] == '/') { p += 2; break; }
+                p++;
+            }
+            lx->current = p;
+        } else {
+            return;
         }
     }
 }
 
-static TokenType check_keyword(int start_len, int length, const char* rest, TokenType type) {
-    if (current - start == start_len + length && memcmp(start + start_len, rest, length) == 0) {
+static TokenType check_keyword(Lexer* lx, int start_len, int length, const char* rest, TokenType type) {
+    if (lx->current - lx->start == start_len + length && memcmp(lx->start + start_len, rest, length) == 0) {
         return type;
     }
     return TOKEN_IDENTIFIER;
 }
 
-static TokenType identifier_type() {
+static TokenType identifier_type(Lexer* lx) {
+    const char* start = lx->start;
+    long len = lx->current - start;
     switch (*start) {
-        case 'b': return check_keyword(1, 4, "reak", TOKEN_BREAK);
-        case 'c': 
-            if (current - start > 1) {
+        case 'b': return check_keyword(lx, 1, 4, "reak", TOKEN_BREAK);
+        case 'c':
+            if (len > 1) {
                 switch(start[1]) {
-                    case 'l': return check_keyword(2, 3, "ass", TOKEN_CLASS);
-                    case 'o': return check_keyword(2, 6, "ntinue", TOKEN_CONTINUE);
+                    case 'l': return check_keyword(lx, 2, 3, "ass", TOKEN_CLASS);
+                    case 'o': return check_keyword(lx, 2, 6, "ntinue", TOKEN_CONTINUE);
                 }
             }
             break;
-        case 'e': return check_keyword(1, 3, "lse", TOKEN_ELSE);
-        case 'f': 
-            if (current - start > 1) {
+        case 'e': return check_keyword(lx, 1, 3, "lse", TOKEN_ELSE);
+        case 'f':
+            if (len > 1) {
                 switch(start[1]) {
-                    case 'a': return check_keyword(2, 3, "lse", TOKEN_FALSE);
-                    case 'o': return check_keyword(2, 1, "r", TOKEN_FOR);
-                    case 'u': return check_keyword(2, 2, "nc", TOKEN_FUNC);
+                    case 'a': return check_keyword(lx, 2, 3, "lse", TOKEN_FALSE);
+                    case 'o': return check_keyword(lx, 2, 1, "r", TOKEN_FOR);
+                    case 'u': return check_keyword(lx, 2, 2, "nc", TOKEN_FUNC);
                 }
             }
             break;
-        case 'i': 
-            if (current - start == 2) {
+        case 'i':
+            if (len == 2) {
                 if (start[1] == 'f') return TOKEN_IF;
+                if (start[1] == 'n') return TOKEN_IN;
                 if (start[1] == 's') return TOKEN_IS;
             }
-            return TOKEN_IDENTIFIER;
-        case 'm': return check_keyword(1, 6, "anaged", TOKEN_MANAGED);
-        case 'n': 
-             if (current - start > 1) {
+            return check_keyword(lx, 1, 5, "mport", TOKEN_IMPORT);
+        case 'm':
+            if (len > 2 && start[1] == 'a') {
+                if (start[2] == 'n') return check_keyword(lx, 3, 4, "aged", TOKEN_MANAGED);
+                if (start[2] == 't') return check_keyword(lx, 3, 2, "ch", TOKEN_MATCH);
+            }
+            break;
+        case 'n':
+             if (len > 1) {
                  switch(start[1]) {
-                     case 'e': return check_keyword(2, 1, "w", TOKEN_NEW);
-                     case 'u': return check_keyword(2, 2, "ll", TOKEN_NULL);
+                     case 'e': return check_keyword(lx, 2, 1, "w", TOKEN_NEW);
+                     case 'u': return check_keyword(lx, 2, 2, "ll", TOKEN_NULL);
                  }
              }
              break;
-        case 'r': return check_keyword(1, 5, "eturn", TOKEN_RETURN);
-        case 't': return check_keyword(1, 3, "rue", TOKEN_TRUE);
-        case 'v': return check_keyword(1, 2, "ar", TOKEN_VAR);
-        case 'w': return check_keyword(1, 4, "hile", TOKEN_WHILE);
+        case 'r': return check_keyword(lx, 1, 5, "eturn", TOKEN_RETURN);
+        case 't': return check_keyword(lx, 1, 3, "rue", TOKEN_TRUE);
+        case 'v': return check_keyword(lx, 1, 2, "ar", TOKEN_VAR);
+        case 'w': return check_keyword(lx, 1, 4, "hile", TOKEN_WHILE);
     }
     return TOKEN_IDENTIFIER;
 }
 
-static Token identifier() {
-    // FIX: Corrected OR syntax
-    while (isalnum(peek()) || peek() == '_') advance();
-    return make_token(identifier_type());
+static Token identifier(Lexer* lx) {
+    lx->current = skip_ident(lx->current, lx->end);
+    return make_token(lx, identifier_type(lx));
 }
 
-static Token number() {
-    // Hex Literals (0x...)
-    // FIX: Corrected OR syntax
-    if (peek() == '0' && (peek_next() == 'x' || peek_next() == 'X')) {
-        advance(); advance(); 
-        while (isxdigit(peek())) advance();
-        return make_token(TOKEN_NUMBER);
+static Token number(Lexer* lx) {
+    const char* p = lx->current;
+    const char* end = lx->end;
+    // Hex (0x...) and binary (0b...) literals; the leading '0' is already consumed
+    if (p[-1] == '0' && p < end && (*p == 'x' || *p == 'X')) {
+        p++;
+        while (p < end && has_class(*p, CC_HEX)) p++;
+        lx->current = p;
+        return make_token(lx, TOKEN_NUMBER);
     }
-    // Binary Literals (0b...)
-    // FIX: Corrected OR syntax
-    if (peek() == '0' && (peek_next() == 'b' || peek_next() == 'B')) {
-        advance(); advance(); 
-        // FIX: Corrected OR syntax
-        while (peek() == '0' || peek() == '1') advance();
-        return make_token(TOKEN_NUMBER);
+    if (p[-1] == '0' && p < end && (*p == 'b' || *p == 'B')) {
+        p++;
+        while (p < end && (*p == '0' || *p == '1')) p++;
+        lx->current = p;
+        return make_token(lx, TOKEN_NUMBER);
     }
 
-    while (isdigit(peek())) advance();
+    while (p < end && has_class(*p, CC_DIGIT)) p++;
 
     // Floating Point detection
-    if (peek() == '.' && isdigit(peek_next())) {
-        advance(); 
-        while (isdigit(peek())) advance();
-        return make_token(TOKEN_FLOAT);
+    if (end - p >= 2 && *p == '.' && has_class(p[1], CC_DIGIT)) {
+        p++;
+        while (p < end && has_class(*p, CC_DIGIT)) p++;
+        lx->current = p;
+        return make_token(lx, TOKEN_FLOAT);
     }
 
-    return make_token(TOKEN_NUMBER);
+    lx->current = p;
+    return make_token(lx, TOKEN_NUMBER);
 }
 
-static Token string_val() {
-    while (peek() != '"' && !is_at_end()) {
-        if (peek() == '\n') line++;
-        if (peek() == '\\') {
-            advance(); 
-            if (!is_at_end()) advance(); 
-        } else {
-            advance();
+static Token string_val(Lexer* lx) {
+    const char* p = lx->current;
+    for (;;) {
+        p = find_any(p, lx->end, '"', '\\', '\n');
+        if (p == lx->end) {
+            lx->current = p;
+            return error_token(lx, ERR_UNTERMINATED_STRING);
         }
+        if (*p == '"') break;
+        if (*p == '\n') lx->line++;
+        // An escape also skips the byte it escapes, which may be a line break
+        else if (p + 1 < lx->end) { p++; if (*p == '\n') lx->line++; }
+        p++;
     }
-    if (is_at_end()) return error_token("Unterminated string.");
-    advance(); 
-    return make_token(TOKEN_STRING);
+    lx->current = p + 1;
+    return make_token(lx, TOKEN_STRING);
 }
 
-Token scan_token() {
-    skip_whitespace();
-    start = current;
-    
-    if (is_at_end()) return make_token(TOKEN_EOF);
+Token lexer_next(Lexer* lx) {
+    skip_whitespace(lx);
+    lx->start = lx->current;
+
+    if (lx->current == lx->end) return make_token(lx, TOKEN_EOF);
 
-    char c = advance();
-    
-    // FIX: Corrected OR syntax
-    if (isalpha(c) || c == '_') return identifier();
-    if (isdigit(c)) return number();
+    char c = *lx->current++;
+
+    if (has_class(c, CC_ALPHA)) return identifier(lx);
+    if (has_class(c, CC_DIGIT)) return number(lx);
 
     switch (c) {
-        case '(': return make_token(TOKEN_LPAREN);
-        case ')': return make_token(TOKEN_RPAREN);
-        case '{': return make_token(TOKEN_LBRACE);
-        case '}': return make_token(TOKEN_RBRACE);
-        case '[': return make_token(TOKEN_LBRACKET);
-        case ']': return make_token(TOKEN_RBRACKET); 
-        case ';': return make_token(TOKEN_SEMICOLON);
-        case ',': return make_token(TOKEN_COMMA);
-        case '.': return make_token(TOKEN_DOT);
-        case '?': return make_token(TOKEN_QUESTION);
-        case ':': return make_token(TOKEN_COLON);
-        
-        case '-': 
-            if (match_char('>')) return make_token(TOKEN_ARROW);
-            if (match_char('=')) return make_token(TOKEN_MINUS_EQ); 
-            return make_token(TOKEN_MINUS);
-        case '+': 
-            if (match_char('=')) return make_token(TOKEN_PLUS_EQ); 
-            return make_token(TOKEN_PLUS);
-        case '*': 
-            if (match_char('=')) return make_token(TOKEN_STAR_EQ); 
-            return make_token(TOKEN_STAR);
-        case '/': 
-            if (match_char('=')) return make_token(TOKEN_SLASH_EQ); 
-            return make_token(TOKEN_SLASH);
-        case '%': return make_token(TOKEN_PERCENT);
-        case '!': return make_token(match_char('=') ? TOKEN_NEQ : TOKEN_BANG); 
-        case '=': return make_token(match_char('=') ? TOKEN_EQEQ : TOKEN_EQ);
-        case '<': return make_token(match_char('=') ? TOKEN_LTEQ : TOKEN_LT);
-        case '>': return make_token(match_char('=') ? TOKEN_GTEQ : TOKEN_GT);
-        case '&': if (match_char('&')) return make_token(TOKEN_AND); break;
-        case '|': if (match_char('|')) return make_token(TOKEN_OR); break;
-        case '"': return string_val();
+        case '(': return make_token(lx, TOKEN_LPAREN);
+        case ')': return make_token(lx, TOKEN_RPAREN);
+        case '{': return make_token(lx, TOKEN_LBRACE);
+        case '}': return make_token(lx, TOKEN_RBRACE);
+        case '[': return make_token(lx, TOKEN_LBRACKET);
+        case ']': return make_token(lx, TOKEN_RBRACKET);
+        case ';': return make_token(lx, TOKEN_SEMICOLON);
+        case ',': return make_token(lx, TOKEN_COMMA);
+        case '.': return make_token(lx, TOKEN_DOT);
+        case '?': return make_token(lx, TOKEN_QUESTION);
+        case ':': return make_token(lx, TOKEN_COLON);
+
+        case '-':
+            if (match_char(lx, '>')) return make_token(lx, TOKEN_ARROW);
+            if (match_char(lx, '=')) return make_token(lx, TOKEN_MINUS_EQ);
+            return make_token(lx, TOKEN_MINUS);
+        case '+':
+            if (match_char(lx, '=')) return make_token(lx, TOKEN_PLUS_EQ);
+            return make_token(lx, TOKEN_PLUS);
+        case '*':
+            if (match_char(lx, '=')) return make_token(lx, TOKEN_STAR_EQ);
+            return make_token(lx, TOKEN_STAR);
+        case '/':
+            if (match_char(lx, '=')) return make_token(lx, TOKEN_SLASH_EQ);
+            return make_token(lx, TOKEN_SLASH);
+        case '%': return make_token(lx, TOKEN_PERCENT);
+        case '!': return make_token(lx, match_char(lx, '=') ? TOKEN_NEQ : TOKEN_BANG);
+        case '=': return make_token(lx, match_char(lx, '=') ? TOKEN_EQEQ : TOKEN_EQ);
+        case '<': return make_token(lx, match_char(lx, '=') ? TOKEN_LTEQ : TOKEN_LT);
+        case '>': return make_token(lx, match_char(lx, '=') ? TOKEN_GTEQ : TOKEN_GT);
+        case '&': if (match_char(lx, '&')) return make_token(lx, TOKEN_AND); break;
+        case '|': if (match_char(lx, '|')) return make_token(lx, TOKEN_OR); break;
+        case '"': return string_val(lx);
+    }
+
+    return error_token(lx, ERR_UNEXPECTED_CHAR);
+}
+
+// --- Token Arrays ---
+
+int lex_all(const char* source, size_t length, TokenArray* out) {
+    memset(out, 0, sizeof(TokenArray));
+    if (length >= UINT32_MAX) return 0;
+    out->source = source;
+    // Source averages well over four bytes per token
+    out->capacity = (int)(length / 4) + 16;
+    out->tokens = malloc(sizeof(LexToken) * out->capacity);
+    if (!out->tokens) { fprintf(stderr, "Fatal: Out of memory in lexer.\n"); exit(1); }
+
+    Lexer lx;
+    lexer_init(&lx, source, length);
+    for (;;) {
+        Token t = lexer_next(&lx);
+        if (out->count == out->capacity) {
+            out->capacity *= 2;
+            out->tokens = realloc(out->tokens, sizeof(LexToken) * out->capacity);
+            if (!out->tokens) { fprintf(stderr, "Fatal: Out of memory in lexer.\n"); exit(1); }
+        }
+        LexToken* lt = &out->tokens[out->count++];
+        lt->type = t.type;
+        lt->line = (uint32_t)t.line;
+        if (t.type == TOKEN_ERROR) {
+            // The message is not in the source; remember which one it was
+            lt->offset = (uint32_t)(lx.start - source);
+            lt->length = t.start == ERROR_MESSAGES[ERR_UNTERMINATED_STRING] ? ERR_UNTERMINATED_STRING : ERR_UNEXPECTED_CHAR;
+            out->error_count++;
+        } else {
+            lt->offset = (uint32_t)(t.start - source);
+            lt->length = (uint32_t)t.length;
+        }
+        if (t.type == TOKEN_EOF) return 1;
     }
+}
 
-    return error_token("Unexpected character.");
+void token_array_free(TokenArray* tokens) {
+    free(tokens->tokens);
+    memset(tokens, 0, sizeof(TokenArray));
+}
+
+Token token_at(const TokenArray* tokens, int index) {
+    const LexToken* lt = &tokens->tokens[index];
+    Token t;
+    t.type = (TokenType)lt->type;
+    t.line = (int)lt->line;
+    if (t.type == TOKEN_ERROR) {
+        t.start = ERROR_MESSAGES[lt->length];
+        t.length = (int)strlen(t.start);
+    } else {
+        t.start = tokens->source + lt->offset;
+        t.length = (int)lt->length;
+    }
+    return t;
 }
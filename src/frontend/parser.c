@@ -4,74 +4,100 @@
 #include <string.h>
 #include <stdint.h>
 #include <ctype.h>
-#include "ast.h"
-#include "token.h"
+#include "parser.h"
 
-Token current_token;
-Token previous_token;
-AstArena* global_arena;
-
-int had_error = 0;
-int panic_mode = 0;
-
-static char* current_class_name = NULL;
-
-typedef struct {
-    const char* name;
-    int depth;
-    int id; 
-} Symbol;
-
-#define MAX_SYMBOLS 2048
-Symbol symbol_table[MAX_SYMBOLS];
-int symbol_count = 0;
-int current_scope_depth = 0;
-int unique_var_id_counter = 1; 
+// Nodes carry the line of the token just consumed (codegen's debug line table)
+static AstNode* new_node(Parser* p) {
+    AstNode* node = arena_alloc(p->arena);
+    node->line = p->previous.line;
+    return node;
+}
 
-void begin_scope() {
-    current_scope_depth++;
+static void begin_scope(Parser* p) {
+    p->scope_depth++;
 }
 
-void end_scope() {
-    while (symbol_count > 0 && symbol_table[symbol_count - 1].depth > current_scope_depth) {
-        symbol_count--;
+static void end_scope(Parser* p) {
+    p->scope_depth--;
+    while (p->symbol_count > 0 && p->symbols[p->symbol_count - 1].depth > p->scope_depth) {
+        p->symbol_count--;
     }
-    current_scope_depth--;
 }
 
-int declare_variable(const char* name) {
-    if (symbol_count >= MAX_SYMBOLS) {
+static int declare_variable(Parser* p, const char* name, AstNode* decl) {
+    if (p->symbol_count >= MAX_SYMBOLS) {
         fprintf(stderr, "Fatal: Symbol table overflow.\n");
         exit(1);
     }
-    for (int i = symbol_count - 1; i >= 0; i--) {
-        if (symbol_table[i].depth < current_scope_depth) break;
-        if (strcmp(symbol_table[i].name, name) == 0) {
-            fprintf(stderr, "Error: Variable '%s' already declared in this scope.\n", name);
-            had_error = 1;
-            return symbol_table[i].id;
+    for (int i = p->symbol_count - 1; i >= 0; i--) {
+        if (p->symbols[i].depth < p->scope_depth) break;
+        if (strcmp(p->symbols[i].name, name) == 0) {
+            fprintf(stderr, "%s%sError: Variable '%s' already declared in this scope.\n",
+                    p->path ? p->path : "", p->path ? ": " : "", name);
+            p->had_error = 1;
+            return p->symbols[i].id;
         }
     }
     
     // FIX: Identify Global Variables
     int id;
-    if (current_scope_depth == 0) {
+    if (p->scope_depth == 0) {
         id = -2; // Special ID for Global Variables
     } else {
-        id = unique_var_id_counter++;
+        id = p->next_var_id++;
     }
 
-    symbol_table[symbol_count].name = name;
-    symbol_table[symbol_count].depth = current_scope_depth;
-    symbol_table[symbol_count].id = id;
-    symbol_count++;
+    p->symbols[p->symbol_count].name = name;
+    p->symbols[p->symbol_count].depth = p->scope_depth;
+    p->symbols[p->symbol_count].id = id;
+    p->symbols[p->symbol_count].level = p->function_level;
+    p->symbols[p->symbol_count].decl = decl;
+    p->symbol_count++;
     return id;
 }
 
-int resolve_variable(const char* name) {
-    for (int i = symbol_count - 1; i >= 0; i--) {
-        if (strcmp(symbol_table[i].name, name) == 0) {
-            return symbol_table[i].id;
+static void add_upvalue(Parser* p, FunctionScope* fn, Symbol* sym) {
+    FuncDeclData* data = &fn->node->data.func_decl;
+    for (AstNode* up = ast_at(fn->node, data->upvalues); up; up = AST_NEXT(up)) {
+        if (up->data.var_access.id == sym->id) return;
+    }
+    AstNode* up = new_node(p);
+    ast_set_type(up, NODE_VAR_ACCESS);
+    up->data.var_access.name = (char*)sym->name;
+    up->data.var_access.id = sym->id;
+    up->data.var_access.decl = ast_ref(sym->decl);
+    if (fn->upvalue_tail) fn->upvalue_tail->next = ast_ref(up);
+    else data->upvalues = ast_ref(up);
+    fn->upvalue_tail = up;
+    data->upvalue_count++;
+}
+
+// Captured variables are copied into the closure record by value unless
+// they are also assigned somewhere, in which case they move to a heap cell
+static void capture_variable(Parser* p, Symbol* sym) {
+    for (int level = sym->level + 1; level <= p->function_level; level++) {
+        add_upvalue(p, &p->functions[level], sym);
+    }
+    VarDeclData* decl = &sym->decl->data.var_decl;
+    decl->is_captured = 1;
+    if (decl->is_mutated) decl->is_boxed = 1;
+}
+
+static void mark_mutated(AstNode* decl) {
+    if (!decl) return;
+    decl->data.var_decl.is_mutated = 1;
+    if (decl->data.var_decl.is_captured) decl->data.var_decl.is_boxed = 1;
+}
+
+static int resolve_variable(Parser* p, const char* name, AstNode** decl) {
+    *decl = NULL;
+    for (int i = p->symbol_count - 1; i >= 0; i--) {
+        if (strcmp(p->symbols[i].name, name) == 0) {
+            if (p->symbols[i].id > 0) {
+                if (p->symbols[i].level < p->function_level) capture_variable(p, &p->symbols[i]);
+                *decl = p->symbols[i].decl;
+            }
+            return p->symbols[i].id;
         }
     }
     // Return -1 for Unresolved (External Symbols/Functions)
@@ -79,14 +105,15 @@ int resolve_variable(const char* name) {
 }
 
 // --- Forward Declarations ---
-AstNode* parse_expression(int precedence);
-AstNode* parse_statement();
-AstNode* parse_block();
-AstNode* parse_var_decl();
-AstNode* ternary_op(AstNode* left); 
-void advance();
-int match(TokenType type);
-void consume(TokenType type, const char* message);
+static AstNode* parse_expression(Parser* p, int precedence);
+static AstNode* parse_statement(Parser* p);
+static AstNode* parse_block(Parser* p);
+static AstNode* parse_var_decl(Parser* p);
+static AstNode* parse_local_function(Parser* p);
+static AstNode* function_expression(Parser* p);
+static void advance(Parser* p);
+static int match(Parser* p, TokenType type);
+static void consume(Parser* p, TokenType type, const char* message);
 
 typedef enum {
     PREC_NONE, PREC_ASSIGNMENT, PREC_TERNARY, PREC_OR, PREC_AND,
@@ -94,8 +121,8 @@ typedef enum {
     PREC_UNARY, PREC_CALL, PREC_PRIMARY
 } Precedence;
 
-typedef AstNode* (*ParsePrefixFn)();
-typedef AstNode* (*ParseInfixFn)(AstNode* left);
+typedef AstNode* (*ParsePrefixFn)(Parser* p);
+typedef AstNode* (*ParseInfixFn)(Parser* p, AstNode* left);
 
 typedef struct {
     ParsePrefixFn prefix;
@@ -103,59 +130,59 @@ typedef struct {
     Precedence precedence;
 } ParseRule;
 
-ParseRule rules[100]; 
+static const ParseRule* get_rule(TokenType type);
 
-void error_at_current(const char* message) {
-    if (panic_mode) return;
-    panic_mode = 1;
-    had_error = 1;
-    fprintf(stderr, "[line %d] Error at '%.*s': %s\n", 
-            current_token.line, current_token.length, current_token.start, message);
+static void error_at_current(Parser* p, const char* message) {
+    if (p->panic_mode) return;
+    p->panic_mode = 1;
+    p->had_error = 1;
+    fprintf(stderr, "%s%s[line %d] Error at '%.*s': %s\n", p->path ? p->path : "", p->path ? ": " : "",
+            p->current.line, p->current.length, p->current.start, message);
 }
 
-void synchronize() {
-    panic_mode = 0;
-    while (current_token.type != TOKEN_EOF) {
-        if (previous_token.type == TOKEN_SEMICOLON) return;
-        switch (current_token.type) {
+static void synchronize(Parser* p) {
+    p->panic_mode = 0;
+    while (p->current.type != TOKEN_EOF) {
+        if (p->previous.type == TOKEN_SEMICOLON) return;
+        switch (p->current.type) {
             case TOKEN_FUNC: case TOKEN_VAR: case TOKEN_IF:
             case TOKEN_WHILE: case TOKEN_FOR: case TOKEN_RETURN:
-            case TOKEN_MANAGED: case TOKEN_CLASS:
+            case TOKEN_MANAGED: case TOKEN_CLASS: case TOKEN_IMPORT: case TOKEN_MATCH:
                 return;
             default: ;
         }
-        advance();
+        advance(p);
     }
 }
 
-void advance() {
-    previous_token = current_token;
+static void advance(Parser* p) {
+    p->previous = p->current;
     for (;;) {
-        current_token = scan_token();
-        if (current_token.type != TOKEN_ERROR) break;
-        error_at_current(current_token.start); 
+        p->current = lexer_next(&p->lexer);
+        if (p->current.type != TOKEN_ERROR) break;
+        error_at_current(p, p->current.start); 
     }
 }
 
-void consume(TokenType type, const char* message) {
-    if (current_token.type == type) {
-        advance();
+static void consume(Parser* p, TokenType type, const char* message) {
+    if (p->current.type == type) {
+        advance(p);
         return;
     }
-    error_at_current(message);
+    error_at_current(p, message);
 }
 
-int match(TokenType type) {
-    if (current_token.type == type) {
-        advance();
+static int match(Parser* p, TokenType type) {
+    if (p->current.type == type) {
+        advance(p);
         return 1;
     }
     return 0;
 }
 
-char* parse_string_content(AstArena* arena, const char* src, int len) {
-    char* buf = malloc(len + 1);
-    if (!buf) exit(1);
+// Decodes the escapes of a string token straight into the arena
+static char* parse_string_content(AstArena* arena, const char* src, int len) {
+    char* buf = arena_str_reserve(arena, len);
     int write_idx = 0;
     for (int i = 1; i < len - 1; i++) {
         if (src[i] == '\\' && i + 1 < len - 1) {
@@ -173,24 +200,21 @@ char* parse_string_content(AstArena* arena, const char* src, int len) {
             buf[write_idx++] = src[i];
         }
     }
-    buf[write_idx] = '\0';
-    char* result = arena_strndup(arena, buf, write_idx);
-    free(buf);
-    return result;
+    return arena_str_commit(arena, buf, write_idx);
 }
 
-AstNode* number() {
-    AstNode* node = arena_alloc(global_arena);
+static AstNode* number(Parser* p) {
+    AstNode* node = new_node(p);
     char buf[128]; 
-    int len = previous_token.length < 127 ? previous_token.length : 127;
-    memcpy(buf, previous_token.start, len);
+    int len = p->previous.length < 127 ? p->previous.length : 127;
+    memcpy(buf, p->previous.start, len);
     buf[len] = '\0';
 
-    if (previous_token.type == TOKEN_FLOAT) {
-        node->type = NODE_FLOAT;
+    if (p->previous.type == TOKEN_FLOAT) {
+        ast_set_type(node, NODE_FLOAT);
         node->data.double_val = strtod(buf, NULL);
     } else {
-        node->type = NODE_LITERAL;
+        ast_set_type(node, NODE_LITERAL);
         if (len > 2 && buf[0] == '0') {
             if (buf[1] == 'x' || buf[1] == 'X') {
                 node->data.int_val = strtoll(buf, NULL, 16);
@@ -212,558 +236,773 @@ AstNode* number() {
     return node;
 }
 
-AstNode* literal() {
-    AstNode* node = arena_alloc(global_arena);
-    switch (previous_token.type) {
-        case TOKEN_TRUE: node->type = NODE_BOOL; node->data.int_val = 1; break;
-        case TOKEN_FALSE: node->type = NODE_BOOL; node->data.int_val = 0; break;
-        case TOKEN_NULL: node->type = NODE_NULL; node->data.int_val = 0; break;
+static AstNode* literal(Parser* p) {
+    AstNode* node = new_node(p);
+    switch (p->previous.type) {
+        case TOKEN_TRUE: ast_set_type(node, NODE_BOOL); node->data.int_val = 1; break;
+        case TOKEN_FALSE: ast_set_type(node, NODE_BOOL); node->data.int_val = 0; break;
+        case TOKEN_NULL: ast_set_type(node, NODE_NULL); node->data.int_val = 0; break;
         default: return NULL;
     }
     return node;
 }
 
-AstNode* string_literal() {
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_STRING;
-    node->data.string_val = parse_string_content(global_arena, previous_token.start, previous_token.length);
+static AstNode* string_literal(Parser* p) {
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_STRING);
+    node->data.string_val = parse_string_content(p->arena, p->previous.start, p->previous.length);
     return node;
 }
 
-AstNode* variable() {
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_VAR_ACCESS;
-    node->data.var_access.name = arena_strndup(global_arena, previous_token.start, previous_token.length);
-    node->data.var_access.id = resolve_variable(node->data.var_access.name);
+static AstNode* variable(Parser* p) {
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_VAR_ACCESS);
+    node->data.var_access.name = arena_strndup(p->arena, p->previous.start, p->previous.length);
+    AstNode* decl;
+    node->data.var_access.id = resolve_variable(p, node->data.var_access.name, &decl);
+    node->data.var_access.decl = ast_ref(decl);
     return node;
 }
 
-AstNode* grouping() {
-    AstNode* expr = parse_expression(PREC_ASSIGNMENT);
-    consume(TOKEN_RPAREN, "Expect ')' after expression.");
+static AstNode* grouping(Parser* p) {
+    AstNode* expr = parse_expression(p, PREC_ASSIGNMENT);
+    consume(p, TOKEN_RPAREN, "Expect ')' after expression.");
     return expr;
 }
 
-AstNode* unary() {
-    TokenType operatorType = previous_token.type;
-    AstNode* operand = parse_expression(PREC_UNARY);
+static AstNode* unary(Parser* p) {
+    TokenType operatorType = p->previous.type;
+    AstNode* operand = parse_expression(p, PREC_UNARY);
 
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_BINARY_OP;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_BINARY_OP);
     node->data.binary.op = operatorType;
-    node->data.binary.left = NULL;
-    node->data.binary.right = operand;
+    node->data.binary.left = 0;
+    node->data.binary.right = ast_ref(operand);
     return node;
 }
 
-AstNode* binary(AstNode* left) {
-    TokenType op = previous_token.type;
-    ParseRule* rule = &rules[op];
-    AstNode* right = parse_expression((int)rule->precedence + 1);
+static AstNode* binary(Parser* p, AstNode* left) {
+    TokenType op = p->previous.type;
+    const ParseRule* rule = get_rule(op);
+    AstNode* right = parse_expression(p, (int)rule->precedence + 1);
     
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_BINARY_OP;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_BINARY_OP);
     node->data.binary.op = op;
-    node->data.binary.left = left;
-    node->data.binary.right = right;
+    node->data.binary.left = ast_ref(left);
+    node->data.binary.right = ast_ref(right);
     return node;
 }
 
-AstNode* ternary_op(AstNode* condition) {
-    AstNode* true_expr = parse_expression(PREC_TERNARY);
-    consume(TOKEN_COLON, "Expect ':' after true branch of ternary.");
-    AstNode* false_expr = parse_expression(PREC_TERNARY);
+static AstNode* ternary_op(Parser* p, AstNode* condition) {
+    AstNode* true_expr = parse_expression(p, PREC_TERNARY);
+    consume(p, TOKEN_COLON, "Expect ':' after true branch of ternary.");
+    AstNode* false_expr = parse_expression(p, PREC_TERNARY);
     
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_TERNARY;
-    node->data.ternary.condition = condition;
-    node->data.ternary.true_expr = true_expr;
-    node->data.ternary.false_expr = false_expr;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_TERNARY);
+    node->data.ternary.condition = ast_ref(condition);
+    node->data.ternary.true_expr = ast_ref(true_expr);
+    node->data.ternary.false_expr = ast_ref(false_expr);
     return node;
 }
 
-AstNode* call(AstNode* callee) {
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_CALL;
-    node->data.call.callee = callee;
-    node->data.call.args = NULL;
-
-    if (current_token.type != TOKEN_RPAREN) {
-        AstNode* arg = parse_expression(PREC_ASSIGNMENT);
-        node->data.call.args = arg;
-        while (match(TOKEN_COMMA)) {
-            arg->next = parse_expression(PREC_ASSIGNMENT);
-            arg = arg->next;
+static AstNode* call(Parser* p, AstNode* callee) {
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_CALL);
+    node->data.call.callee = ast_ref(callee);
+    node->data.call.args = 0;
+
+    if (p->current.type != TOKEN_RPAREN) {
+        AstNode* arg = parse_expression(p, PREC_ASSIGNMENT);
+        node->data.call.args = ast_ref(arg);
+        while (match(p, TOKEN_COMMA)) {
+            arg->next = ast_ref(parse_expression(p, PREC_ASSIGNMENT));
+            arg = AST_NEXT(arg);
         }
     }
-    consume(TOKEN_RPAREN, "Expect ')' after arguments.");
+    consume(p, TOKEN_RPAREN, "Expect ')' after arguments.");
     return node;
 }
 
-AstNode* index_op(AstNode* left) {
-    AstNode* index = parse_expression(PREC_ASSIGNMENT);
-    consume(TOKEN_RBRACKET, "Expect ']' after index.");
-
-    if (match(TOKEN_EQ)) {
-        AstNode* val = parse_expression(PREC_ASSIGNMENT);
-        AstNode* node = arena_alloc(global_arena);
-        node->type = NODE_INDEX_SET;
-        node->data.index_set.obj = left;
-        node->data.index_set.index = index;
-        node->data.index_set.value = val;
+static AstNode* index_op(Parser* p, AstNode* left) {
+    AstNode* index = parse_expression(p, PREC_ASSIGNMENT);
+    consume(p, TOKEN_RBRACKET, "Expect ']' after index.");
+
+    if (match(p, TOKEN_EQ)) {
+        AstNode* val = parse_expression(p, PREC_ASSIGNMENT);
+        AstNode* node = new_node(p);
+        ast_set_type(node, NODE_INDEX_SET);
+        node->data.index_set.obj = ast_ref(left);
+        node->data.index_set.index = ast_ref(index);
+        node->data.index_set.value = ast_ref(val);
         return node;
     }
 
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_INDEX_GET;
-    node->data.index_get.obj = left;
-    node->data.index_get.index = index;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_INDEX_GET);
+    node->data.index_get.obj = ast_ref(left);
+    node->data.index_get.index = ast_ref(index);
     return node;
 }
 
-AstNode* array_literal() {
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_ARRAY_LITERAL;
-    node->data.array_literal.elements = NULL;
+static AstNode* array_literal(Parser* p) {
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_ARRAY_LITERAL);
+    node->data.array_literal.elements = 0;
     node->data.array_literal.count = 0;
 
-    if (current_token.type != TOKEN_RBRACKET) {
-        AstNode* elem = parse_expression(PREC_ASSIGNMENT);
-        node->data.array_literal.elements = elem;
+    if (p->current.type != TOKEN_RBRACKET) {
+        AstNode* elem = parse_expression(p, PREC_ASSIGNMENT);
+        node->data.array_literal.elements = ast_ref(elem);
         node->data.array_literal.count++;
         
         AstNode* curr = elem;
-        while (match(TOKEN_COMMA)) {
-            AstNode* next = parse_expression(PREC_ASSIGNMENT);
-            curr->next = next;
+        while (match(p, TOKEN_COMMA)) {
+            AstNode* next = parse_expression(p, PREC_ASSIGNMENT);
+            curr->next = ast_ref(next);
             curr = next;
             node->data.array_literal.count++;
         }
     }
-    consume(TOKEN_RBRACKET, "Expect ']' after array elements.");
+    consume(p, TOKEN_RBRACKET, "Expect ']' after array elements.");
     return node;
 }
 
-AstNode* dot(AstNode* left) {
-    consume(TOKEN_IDENTIFIER, "Expect property name after '.'.");
-    char* name = arena_strndup(global_arena, previous_token.start, previous_token.length);
+static AstNode* dot(Parser* p, AstNode* left) {
+    consume(p, TOKEN_IDENTIFIER, "Expect property name after '.'.");
+    char* name = arena_strndup(p->arena, p->previous.start, p->previous.length);
     
-    if (match(TOKEN_EQ)) {
-        AstNode* value = parse_expression(PREC_ASSIGNMENT);
-        AstNode* node = arena_alloc(global_arena);
-        node->type = NODE_SET;
-        node->data.set.obj = left;
+    if (match(p, TOKEN_EQ)) {
+        AstNode* value = parse_expression(p, PREC_ASSIGNMENT);
+        AstNode* node = new_node(p);
+        ast_set_type(node, NODE_SET);
+        node->data.set.obj = ast_ref(left);
         node->data.set.name = name;
-        node->data.set.value = value;
+        node->data.set.value = ast_ref(value);
         return node;
     }
 
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_GET;
-    node->data.get.obj = left;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_GET);
+    node->data.get.obj = ast_ref(left);
     node->data.get.name = name;
     return node;
 }
 
-AstNode* object_new() {
-    consume(TOKEN_IDENTIFIER, "Expect class name after 'new'.");
-    char* name = arena_strndup(global_arena, previous_token.start, previous_token.length);
-    consume(TOKEN_LPAREN, "Expect '()' after class name.");
-    consume(TOKEN_RPAREN, "Expect '()' after class name.");
+static AstNode* object_new(Parser* p) {
+    consume(p, TOKEN_IDENTIFIER, "Expect class name after 'new'.");
+    char* name = arena_strndup(p->arena, p->previous.start, p->previous.length);
+    consume(p, TOKEN_LPAREN, "Expect '()' after class name.");
+    consume(p, TOKEN_RPAREN, "Expect '()' after class name.");
     
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_NEW;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_NEW);
     node->data.string_val = name;
     return node;
 }
 
-void init_rules() {
-    for(int i=0; i<100; i++) rules[i] = (ParseRule){NULL, NULL, PREC_NONE};
-
-    rules[TOKEN_IDENTIFIER] = (ParseRule){variable, NULL, PREC_NONE};
-    rules[TOKEN_NUMBER]     = (ParseRule){number, NULL, PREC_NONE};
-    rules[TOKEN_FLOAT]      = (ParseRule){number, NULL, PREC_NONE};
-    rules[TOKEN_STRING]     = (ParseRule){string_literal, NULL, PREC_NONE};
-    rules[TOKEN_LPAREN]     = (ParseRule){grouping, call, PREC_CALL};
-    rules[TOKEN_TRUE]       = (ParseRule){literal, NULL, PREC_NONE};
-    rules[TOKEN_FALSE]      = (ParseRule){literal, NULL, PREC_NONE};
-    rules[TOKEN_NULL]       = (ParseRule){literal, NULL, PREC_NONE};
-    
-    rules[TOKEN_PLUS]       = (ParseRule){NULL, binary, PREC_TERM};
-    rules[TOKEN_MINUS]      = (ParseRule){unary, binary, PREC_TERM}; 
-    rules[TOKEN_STAR]       = (ParseRule){NULL, binary, PREC_FACTOR};
-    rules[TOKEN_SLASH]      = (ParseRule){NULL, binary, PREC_FACTOR};
-    rules[TOKEN_PERCENT]    = (ParseRule){NULL, binary, PREC_FACTOR};
-    rules[TOKEN_BANG]       = (ParseRule){unary, NULL, PREC_UNARY};
-    
-    rules[TOKEN_EQEQ]       = (ParseRule){NULL, binary, PREC_EQUALITY};
-    rules[TOKEN_NEQ]        = (ParseRule){NULL, binary, PREC_EQUALITY};
-    rules[TOKEN_LT]         = (ParseRule){NULL, binary, PREC_COMPARISON};
-    rules[TOKEN_LTEQ]       = (ParseRule){NULL, binary, PREC_COMPARISON};
-    rules[TOKEN_GT]         = (ParseRule){NULL, binary, PREC_COMPARISON};
-    rules[TOKEN_GTEQ]       = (ParseRule){NULL, binary, PREC_COMPARISON};
-    rules[TOKEN_AND]        = (ParseRule){NULL, binary, PREC_AND};
-    rules[TOKEN_OR]         = (ParseRule){NULL, binary, PREC_OR};
-    
-    rules[TOKEN_DOT]        = (ParseRule){NULL, dot, PREC_CALL};
-    rules[TOKEN_LBRACKET]   = (ParseRule){array_literal, index_op, PREC_CALL}; 
-    rules[TOKEN_NEW]        = (ParseRule){object_new, NULL, PREC_NONE};
-
-    rules[TOKEN_IS]         = (ParseRule){NULL, ternary_op, PREC_TERNARY};
-    rules[TOKEN_QUESTION]   = (ParseRule){NULL, ternary_op, PREC_TERNARY};
+// Indexed by token type; read-only, so every Parser shares it
+static const ParseRule rules[100] = {
+    [TOKEN_IDENTIFIER] = {variable, NULL, PREC_NONE},
+    [TOKEN_NUMBER]     = {number, NULL, PREC_NONE},
+    [TOKEN_FLOAT]      = {number, NULL, PREC_NONE},
+    [TOKEN_STRING]     = {string_literal, NULL, PREC_NONE},
+    [TOKEN_LPAREN]     = {grouping, call, PREC_CALL},
+    [TOKEN_TRUE]       = {literal, NULL, PREC_NONE},
+    [TOKEN_FALSE]      = {literal, NULL, PREC_NONE},
+    [TOKEN_NULL]       = {literal, NULL, PREC_NONE},
+    [TOKEN_PLUS]       = {NULL, binary, PREC_TERM},
+    [TOKEN_MINUS]      = {unary, binary, PREC_TERM},
+    [TOKEN_STAR]       = {NULL, binary, PREC_FACTOR},
+    [TOKEN_SLASH]      = {NULL, binary, PREC_FACTOR},
+    [TOKEN_PERCENT]    = {NULL, binary, PREC_FACTOR},
+    [TOKEN_BANG]       = {unary, NULL, PREC_UNARY},
+    [TOKEN_EQEQ]       = {NULL, binary, PREC_EQUALITY},
+    [TOKEN_NEQ]        = {NULL, binary, PREC_EQUALITY},
+    [TOKEN_LT]         = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_LTEQ]       = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_GT]         = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_GTEQ]       = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_AND]        = {NULL, binary, PREC_AND},
+    [TOKEN_OR]         = {NULL, binary, PREC_OR},
+    [TOKEN_DOT]        = {NULL, dot, PREC_CALL},
+    [TOKEN_LBRACKET]   = {array_literal, index_op, PREC_CALL},
+    [TOKEN_NEW]        = {object_new, NULL, PREC_NONE},
+    [TOKEN_FUNC]       = {function_expression, NULL, PREC_NONE},
+    [TOKEN_IS]         = {NULL, ternary_op, PREC_TERNARY},
+    [TOKEN_QUESTION]   = {NULL, ternary_op, PREC_TERNARY},
+};
+
+static const ParseRule* get_rule(TokenType type) {
+    return &rules[type];
 }
 
-AstNode* parse_expression(int precedence) {
-    advance();
-    ParsePrefixFn prefix = rules[previous_token.type].prefix;
+static AstNode* parse_expression(Parser* p, int precedence) {
+    advance(p);
+    ParsePrefixFn prefix = get_rule(p->previous.type)->prefix;
     if (!prefix) {
-        error_at_current("Expect expression.");
+        error_at_current(p, "Expect expression.");
         return NULL;
     }
-    AstNode* left = prefix();
+    AstNode* left = prefix(p);
 
-    while (precedence <= rules[current_token.type].precedence) {
-        advance();
-        ParseInfixFn infix = rules[previous_token.type].infix;
+    while (precedence <= get_rule(p->current.type)->precedence) {
+        advance(p);
+        ParseInfixFn infix = get_rule(p->previous.type)->infix;
         if (!infix) return left;
-        left = infix(left);
+        left = infix(p, left);
     }
     
-    if (match(TOKEN_EQ)) {
+    if (match(p, TOKEN_EQ)) {
         if (precedence <= PREC_ASSIGNMENT) {
-            AstNode* value = parse_expression(PREC_ASSIGNMENT);
-            if (left->type == NODE_VAR_ACCESS) {
-                AstNode* assign = arena_alloc(global_arena);
-                assign->type = NODE_ASSIGN;
+            AstNode* value = parse_expression(p, PREC_ASSIGNMENT);
+            if (ast_type(left) == NODE_VAR_ACCESS) {
+                AstNode* assign = new_node(p);
+                ast_set_type(assign, NODE_ASSIGN);
                 assign->data.assign.name = left->data.var_access.name;
                 assign->data.assign.id = left->data.var_access.id; 
-                assign->data.assign.value = value;
+                assign->data.assign.decl = ast_ref(AST_KID(left, var_access.decl));
+                assign->data.assign.value = ast_ref(value);
+                mark_mutated(AST_KID(assign, assign.decl));
                 return assign;
             }
-            error_at_current("Invalid assignment target.");
+            error_at_current(p, "Invalid assignment target.");
         }
     }
     
     TokenType op = TOKEN_ERROR;
-    if (match(TOKEN_PLUS_EQ)) op = TOKEN_PLUS;
-    else if (match(TOKEN_MINUS_EQ)) op = TOKEN_MINUS;
-    else if (match(TOKEN_STAR_EQ)) op = TOKEN_STAR;
-    else if (match(TOKEN_SLASH_EQ)) op = TOKEN_SLASH;
+    if (match(p, TOKEN_PLUS_EQ)) op = TOKEN_PLUS;
+    else if (match(p, TOKEN_MINUS_EQ)) op = TOKEN_MINUS;
+    else if (match(p, TOKEN_STAR_EQ)) op = TOKEN_STAR;
+    else if (match(p, TOKEN_SLASH_EQ)) op = TOKEN_SLASH;
 
     if (op != TOKEN_ERROR) {
          if (precedence <= PREC_ASSIGNMENT) {
-            AstNode* value = parse_expression(PREC_ASSIGNMENT);
-            if (left->type == NODE_VAR_ACCESS) {
-                AstNode* bin = arena_alloc(global_arena);
-                bin->type = NODE_BINARY_OP;
+            AstNode* value = parse_expression(p, PREC_ASSIGNMENT);
+            if (ast_type(left) == NODE_VAR_ACCESS) {
+                AstNode* bin = new_node(p);
+                ast_set_type(bin, NODE_BINARY_OP);
                 bin->data.binary.op = op;
-                bin->data.binary.left = left;
-                bin->data.binary.right = value;
+                bin->data.binary.left = ast_ref(left);
+                bin->data.binary.right = ast_ref(value);
 
-                AstNode* assign = arena_alloc(global_arena);
-                assign->type = NODE_ASSIGN;
+                AstNode* assign = new_node(p);
+                ast_set_type(assign, NODE_ASSIGN);
                 assign->data.assign.name = left->data.var_access.name;
                 assign->data.assign.id = left->data.var_access.id;
-                assign->data.assign.value = bin;
+                assign->data.assign.decl = ast_ref(AST_KID(left, var_access.decl));
+                assign->data.assign.value = ast_ref(bin);
+                mark_mutated(AST_KID(assign, assign.decl));
                 return assign;
             }
-            error_at_current("Invalid assignment target.");
+            error_at_current(p, "Invalid assignment target.");
          }
     }
     return left;
 }
 
-AstNode* parse_var_decl() {
-    consume(TOKEN_IDENTIFIER, "Expect variable name.");
-    char* name = arena_strndup(global_arena, previous_token.start, previous_token.length);
-    
-    int id = declare_variable(name);
-
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_VAR_DECL;
+// Declaration whose name was just consumed
+static AstNode* finish_var_decl(Parser* p, char* name) {
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_VAR_DECL);
     node->data.var_decl.name = name;
-    node->data.var_decl.shadow_stack_offset = id;
+    node->data.var_decl.shadow_stack_offset = declare_variable(p, name, node);
     node->data.var_decl.is_managed = 0; 
     
-    if (match(TOKEN_EQ)) {
-        node->data.var_decl.init_expr = parse_expression(PREC_ASSIGNMENT);
+    if (match(p, TOKEN_EQ)) {
+        node->data.var_decl.init_expr = ast_ref(parse_expression(p, PREC_ASSIGNMENT));
+        // Captured by its own initializer: the closure exists before the store
+        if (node->data.var_decl.is_captured) node->data.var_decl.is_boxed = 1;
     } else {
-        node->data.var_decl.init_expr = NULL;
+        node->data.var_decl.init_expr = 0;
     }
-    consume(TOKEN_SEMICOLON, "Expect ';' after variable declaration.");
+    consume(p, TOKEN_SEMICOLON, "Expect ';' after variable declaration.");
     return node;
 }
 
-AstNode* parse_statement() {
-    if (match(TOKEN_VAR)) return parse_var_decl();
-    if (match(TOKEN_MANAGED)) {
-        consume(TOKEN_VAR, "Expect 'var' after 'managed'.");
-        AstNode* node = parse_var_decl();
+static AstNode* parse_var_decl(Parser* p) {
+    consume(p, TOKEN_IDENTIFIER, "Expect variable name.");
+    return finish_var_decl(p, arena_strndup(p->arena, p->previous.start, p->previous.length));
+}
+
+// 'in <list>) <body>' after the loop variable's name; the list is parsed before
+// the variable is declared so it cannot refer to it
+static AstNode* parse_for_each(Parser* p, char* name, int parens) {
+    AstNode* list = parse_expression(p, PREC_ASSIGNMENT);
+    if (parens) consume(p, TOKEN_RPAREN, "Expect ')' after for-each list.");
+
+    AstNode* var = new_node(p);
+    ast_set_type(var, NODE_VAR_DECL);
+    var->data.var_decl.name = name;
+    var->data.var_decl.shadow_stack_offset = declare_variable(p, name, var);
+
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_FOR);
+    node->data.for_stmt.var = ast_ref(var);
+    node->data.for_stmt.iterable = ast_ref(list);
+    node->data.for_stmt.is_each = 1;
+    node->data.for_stmt.body = ast_ref(parse_statement(p));
+    return node;
+}
+
+// A case label: an integer (optionally negative) or a string literal
+static AstNode* parse_match_pattern(Parser* p) {
+    int negative = match(p, TOKEN_MINUS);
+    if (match(p, TOKEN_NUMBER)) {
+        AstNode* node = number(p);
+        if (negative) node->data.int_val = -node->data.int_val;
+        return node;
+    }
+    if (!negative && match(p, TOKEN_STRING)) return string_literal(p);
+    error_at_current(p, "Expect integer or string case in match.");
+    advance(p);
+    return NULL;
+}
+
+// 'match (subject) { p1, p2 -> stmt ... else -> stmt }' after the keyword
+static AstNode* parse_match(Parser* p) {
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_MATCH);
+    consume(p, TOKEN_LPAREN, "Expect '(' after 'match'.");
+    node->data.match.subject = ast_ref(parse_expression(p, PREC_ASSIGNMENT));
+    consume(p, TOKEN_RPAREN, "Expect ')' after match subject.");
+    consume(p, TOKEN_LBRACE, "Expect '{' before match arms.");
+
+    AstNode* tail = NULL;
+    while (p->current.type != TOKEN_RBRACE && p->current.type != TOKEN_EOF && !p->panic_mode) {
+        if (match(p, TOKEN_ELSE)) {
+            if (node->data.match.otherwise) error_at_current(p, "Match already has an 'else' arm.");
+            consume(p, TOKEN_ARROW, "Expect '->' after 'else'.");
+            node->data.match.otherwise = ast_ref(parse_statement(p));
+            continue;
+        }
+        AstNode* arm = new_node(p);
+        ast_set_type(arm, NODE_MATCH_ARM);
+        AstNode* pattern = NULL;
+        do {
+            AstNode* next = parse_match_pattern(p);
+            if (!next) continue;
+            if (pattern) pattern->next = ast_ref(next);
+            else arm->data.match_arm.patterns = ast_ref(next);
+            pattern = next;
+        } while (match(p, TOKEN_COMMA));
+        consume(p, TOKEN_ARROW, "Expect '->' after match case.");
+        arm->data.match_arm.body = ast_ref(parse_statement(p));
+        if (tail) tail->next = ast_ref(arm);
+        else node->data.match.arms = ast_ref(arm);
+        tail = arm;
+    }
+    consume(p, TOKEN_RBRACE, "Expect '}' after match arms.");
+    return node;
+}
+
+static int is_var_access(AstNode* node, AstNode* decl) {
+    return node && ast_type(node) == NODE_VAR_ACCESS && AST_KID(node, var_access.decl) == decl;
+}
+
+/*
+ * The counting loop 'for (var i = <int>; i < limit; i = i + <int>)' is
+ * returned as its variable so the caller can turn it into a NODE_FOR once the
+ * body is known not to assign i. Anything else stays a generic loop.
+ */
+static AstNode* range_loop_var(AstNode* init, AstNode* condition, AstNode* increment) {
+    if (!init || ast_type(init) != NODE_VAR_DECL || init->data.var_decl.shadow_stack_offset <= 0) return NULL;
+    AstNode* start = AST_KID(init, var_decl.init_expr);
+    if (!start || ast_type(start) != NODE_LITERAL) return NULL;
+    if (!condition || ast_type(condition) != NODE_BINARY_OP || condition->data.binary.op != TOKEN_LT) return NULL;
+    if (!is_var_access(AST_KID(condition, binary.left), init)) return NULL;
+    if (!increment || ast_type(increment) != NODE_ASSIGN || AST_KID(increment, assign.decl) != init) return NULL;
+    AstNode* sum = AST_KID(increment, assign.value);
+    if (ast_type(sum) != NODE_BINARY_OP || sum->data.binary.op != TOKEN_PLUS) return NULL;
+    if (!is_var_access(AST_KID(sum, binary.left), init)) return NULL;
+    AstNode* step = AST_KID(sum, binary.right);
+    if (!step || ast_type(step) != NODE_LITERAL || step->data.int_val <= 0) return NULL;
+    return init;
+}
+
+static AstNode* parse_statement_inner(Parser* p) {
+    if (match(p, TOKEN_VAR)) return parse_var_decl(p);
+    if (match(p, TOKEN_FUNC)) return parse_local_function(p);
+    if (match(p, TOKEN_MANAGED)) {
+        consume(p, TOKEN_VAR, "Expect 'var' after 'managed'.");
+        AstNode* node = parse_var_decl(p);
         node->data.var_decl.is_managed = 1;
         return node;
     }
-    if (match(TOKEN_RETURN)) {
-        AstNode* node = arena_alloc(global_arena);
-        node->type = NODE_RETURN;
-        if (current_token.type != TOKEN_SEMICOLON) {
-             node->data.return_stmt.expr = parse_expression(PREC_ASSIGNMENT);
+    if (match(p, TOKEN_RETURN)) {
+        AstNode* node = new_node(p);
+        ast_set_type(node, NODE_RETURN);
+        if (p->current.type != TOKEN_SEMICOLON) {
+             node->data.return_stmt.expr = ast_ref(parse_expression(p, PREC_ASSIGNMENT));
         } else {
-             node->data.return_stmt.expr = NULL;
+             node->data.return_stmt.expr = 0;
         }
-        consume(TOKEN_SEMICOLON, "Expect ';' after return.");
+        consume(p, TOKEN_SEMICOLON, "Expect ';' after return.");
         return node;
     }
-    if (match(TOKEN_BREAK)) {
-        AstNode* node = arena_alloc(global_arena);
-        node->type = NODE_BREAK;
-        consume(TOKEN_SEMICOLON, "Expect ';' after break.");
+    if (match(p, TOKEN_BREAK)) {
+        AstNode* node = new_node(p);
+        ast_set_type(node, NODE_BREAK);
+        consume(p, TOKEN_SEMICOLON, "Expect ';' after break.");
         return node;
     }
-    if (match(TOKEN_CONTINUE)) {
-        AstNode* node = arena_alloc(global_arena);
-        node->type = NODE_CONTINUE;
-        consume(TOKEN_SEMICOLON, "Expect ';' after continue.");
+    if (match(p, TOKEN_CONTINUE)) {
+        AstNode* node = new_node(p);
+        ast_set_type(node, NODE_CONTINUE);
+        consume(p, TOKEN_SEMICOLON, "Expect ';' after continue.");
         return node;
     }
-    if (match(TOKEN_IF)) {
-        consume(TOKEN_LPAREN, "Expect '(' after 'if'.");
-        AstNode* cond = parse_expression(PREC_ASSIGNMENT);
-        consume(TOKEN_RPAREN, "Expect ')' after condition.");
-        AstNode* thenBranch = parse_statement();
+    if (match(p, TOKEN_IF)) {
+        consume(p, TOKEN_LPAREN, "Expect '(' after 'if'.");
+        AstNode* cond = parse_expression(p, PREC_ASSIGNMENT);
+        consume(p, TOKEN_RPAREN, "Expect ')' after condition.");
+        AstNode* thenBranch = parse_statement(p);
         AstNode* elseBranch = NULL;
-        if (match(TOKEN_ELSE)) elseBranch = parse_statement();
+        if (match(p, TOKEN_ELSE)) elseBranch = parse_statement(p);
         
-        AstNode* node = arena_alloc(global_arena);
-        node->type = NODE_IF;
-        node->data.if_stmt.condition = cond;
-        node->data.if_stmt.then_branch = thenBranch;
-        node->data.if_stmt.else_branch = elseBranch;
+        AstNode* node = new_node(p);
+        ast_set_type(node, NODE_IF);
+        node->data.if_stmt.condition = ast_ref(cond);
+        node->data.if_stmt.then_branch = ast_ref(thenBranch);
+        node->data.if_stmt.else_branch = ast_ref(elseBranch);
         return node;
     }
-    if (match(TOKEN_WHILE)) {
-        consume(TOKEN_LPAREN, "Expect '(' after 'while'.");
-        AstNode* cond = parse_expression(PREC_ASSIGNMENT);
-        consume(TOKEN_RPAREN, "Expect ')' after condition.");
-        AstNode* body = parse_statement();
+    if (match(p, TOKEN_WHILE)) {
+        consume(p, TOKEN_LPAREN, "Expect '(' after 'while'.");
+        AstNode* cond = parse_expression(p, PREC_ASSIGNMENT);
+        consume(p, TOKEN_RPAREN, "Expect ')' after condition.");
+        AstNode* body = parse_statement(p);
         
-        AstNode* node = arena_alloc(global_arena);
-        node->type = NODE_WHILE;
-        node->data.while_stmt.condition = cond;
-        node->data.while_stmt.body = body;
+        AstNode* node = new_node(p);
+        ast_set_type(node, NODE_WHILE);
+        node->data.while_stmt.condition = ast_ref(cond);
+        node->data.while_stmt.body = ast_ref(body);
         return node;
     }
-    if (match(TOKEN_FOR)) {
-        begin_scope(); 
-        consume(TOKEN_LPAREN, "Expect '(' after 'for'.");
+    if (match(p, TOKEN_MATCH)) return parse_match(p);
+
+    if (match(p, TOKEN_FOR)) {
+        int for_line = p->previous.line;
+        begin_scope(p); 
+        // 'for x in list body'
+        if (match(p, TOKEN_IDENTIFIER)) {
+            char* name = arena_strndup(p->arena, p->previous.start, p->previous.length);
+            consume(p, TOKEN_IN, "Expect 'in' after for-each variable.");
+            AstNode* loop = parse_for_each(p, name, 0);
+            end_scope(p);
+            return loop;
+        }
+        consume(p, TOKEN_LPAREN, "Expect '(' after 'for'.");
         AstNode* init = NULL;
-        if (match(TOKEN_SEMICOLON)) {
-        } else if (match(TOKEN_VAR)) {
-            init = parse_var_decl();
+        if (match(p, TOKEN_SEMICOLON)) {
+        } else if (match(p, TOKEN_VAR)) {
+            consume(p, TOKEN_IDENTIFIER, "Expect variable name.");
+            char* name = arena_strndup(p->arena, p->previous.start, p->previous.length);
+            if (match(p, TOKEN_IN)) {
+                AstNode* loop = parse_for_each(p, name, 1);
+                end_scope(p);
+                return loop;
+            }
+            init = finish_var_decl(p, name);
         } else {
-            AstNode* expr = parse_expression(PREC_ASSIGNMENT);
-            consume(TOKEN_SEMICOLON, "Expect ';' after init.");
+            AstNode* expr = parse_expression(p, PREC_ASSIGNMENT);
+            consume(p, TOKEN_SEMICOLON, "Expect ';' after init.");
             init = expr; 
         }
 
         AstNode* condition = NULL;
-        if (!match(TOKEN_SEMICOLON)) {
-            condition = parse_expression(PREC_ASSIGNMENT);
-            consume(TOKEN_SEMICOLON, "Expect ';' after loop condition.");
+        if (!match(p, TOKEN_SEMICOLON)) {
+            condition = parse_expression(p, PREC_ASSIGNMENT);
+            consume(p, TOKEN_SEMICOLON, "Expect ';' after loop condition.");
         } else {
-            AstNode* true_node = arena_alloc(global_arena);
-            true_node->type = NODE_BOOL; 
+            AstNode* true_node = new_node(p);
+            ast_set_type(true_node, NODE_BOOL); 
             true_node->data.int_val = 1;
             condition = true_node;
         }
 
         AstNode* increment = NULL;
-        if (!match(TOKEN_RPAREN)) {
-            increment = parse_expression(PREC_ASSIGNMENT);
-            consume(TOKEN_RPAREN, "Expect ')' after for clauses.");
+        if (!match(p, TOKEN_RPAREN)) {
+            increment = parse_expression(p, PREC_ASSIGNMENT);
+            consume(p, TOKEN_RPAREN, "Expect ')' after for clauses.");
         }
 
-        AstNode* body = parse_statement();
-        end_scope(); 
+        // The increment marked the variable mutated; see whether the body does too
+        AstNode* range_var = range_loop_var(init, condition, increment);
+        if (range_var) range_var->data.var_decl.is_mutated = 0;
+        AstNode* body = parse_statement(p);
+        end_scope(p); 
+
+        // A captured counter stays one shared variable, as in the generic loop
+        if (range_var && !range_var->data.var_decl.is_mutated && !range_var->data.var_decl.is_captured) {
+            range_var->data.var_decl.is_mutated = 1;
+            AstNode* loop = new_node(p);
+            ast_set_type(loop, NODE_FOR);
+            loop->data.for_stmt.var = ast_ref(range_var);
+            loop->data.for_stmt.iterable = ast_ref(AST_KID(condition, binary.right));
+            loop->data.for_stmt.start = ast_ref(AST_KID(range_var, var_decl.init_expr));
+            loop->data.for_stmt.step = ast_ref(AST_KID(AST_KID(increment, assign.value), binary.right));
+            loop->data.for_stmt.body = ast_ref(body);
+            return loop;
+        }
+        if (range_var) mark_mutated(range_var);
 
-        AstNode* while_node = arena_alloc(global_arena);
-        while_node->type = NODE_WHILE;
-        while_node->data.while_stmt.condition = condition;
+        AstNode* while_node = new_node(p);
+        while_node->line = for_line;
+        ast_set_type(while_node, NODE_WHILE);
+        while_node->data.while_stmt.condition = ast_ref(condition);
 
         if (increment) {
-            AstNode* seq_block = arena_alloc(global_arena);
-            seq_block->type = NODE_BLOCK;
-            body->next = increment;
-            seq_block->data.func_decl.body = body;
-            while_node->data.while_stmt.body = seq_block;
+            AstNode* seq_block = new_node(p);
+            ast_set_type(seq_block, NODE_BLOCK);
+            body->next = ast_ref(increment);
+            seq_block->data.block.body = ast_ref(body);
+            while_node->data.while_stmt.body = ast_ref(seq_block);
         } else {
-            while_node->data.while_stmt.body = body;
+            while_node->data.while_stmt.body = ast_ref(body);
         }
 
-        AstNode* outer_block = arena_alloc(global_arena);
-        outer_block->type = NODE_BLOCK;
+        AstNode* outer_block = new_node(p);
+        ast_set_type(outer_block, NODE_BLOCK);
         if (init) {
-            init->next = while_node;
-            outer_block->data.func_decl.body = init;
+            init->next = ast_ref(while_node);
+            outer_block->data.block.body = ast_ref(init);
         } else {
-            outer_block->data.func_decl.body = while_node;
+            outer_block->data.block.body = ast_ref(while_node);
         }
         
         return outer_block;
     }
     
-    if (match(TOKEN_LBRACE)) return parse_block();
+    if (match(p, TOKEN_LBRACE)) return parse_block(p);
     
-    AstNode* expr = parse_expression(PREC_ASSIGNMENT);
-    consume(TOKEN_SEMICOLON, "Expect ';' after expression.");
+    AstNode* expr = parse_expression(p, PREC_ASSIGNMENT);
+    consume(p, TOKEN_SEMICOLON, "Expect ';' after expression.");
     return expr; 
 }
 
-AstNode* parse_block() {
-    begin_scope();
+// Statement nodes are often built after their parts; they report the line they start on
+static AstNode* parse_statement(Parser* p) {
+    int line = p->current.line;
+    AstNode* node = parse_statement_inner(p);
+    if (node) node->line = line;
+    return node;
+}
+
+static AstNode* parse_block(Parser* p) {
+    begin_scope(p);
     AstNode* head = NULL;
     AstNode* cur = NULL;
-    while (current_token.type != TOKEN_RBRACE && current_token.type != TOKEN_EOF) {
-        AstNode* stmt = parse_statement();
+    while (p->current.type != TOKEN_RBRACE && p->current.type != TOKEN_EOF) {
+        AstNode* stmt = parse_statement(p);
         if (stmt) {
             if (!head) head = stmt;
-            else cur->next = stmt;
+            else cur->next = ast_ref(stmt);
             cur = stmt;
         }
     }
-    consume(TOKEN_RBRACE, "Expect '}' after block.");
-    end_scope();
+    consume(p, TOKEN_RBRACE, "Expect '}' after block.");
+    end_scope(p);
     
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_BLOCK;
-    node->data.func_decl.body = head;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_BLOCK);
+    node->data.block.body = ast_ref(head);
     return node;
 }
 
-AstNode* parse_function() {
-    consume(TOKEN_IDENTIFIER, "Expect function name.");
-    char* raw_name = arena_strndup(global_arena, previous_token.start, previous_token.length);
-    
-    char* name;
-    if (current_class_name) {
-        size_t cls_len = strlen(current_class_name);
-        size_t fn_len = strlen(raw_name);
-        char* mangled = malloc(cls_len + fn_len + 2);
-        sprintf(mangled, "%s_%s", current_class_name, raw_name);
-        name = arena_strndup(global_arena, mangled, cls_len + fn_len + 1);
-        free(mangled);
-    } else {
-        // FIX: Rename entry point to avoid conflict with compiler-generated main
-        if (strcmp(raw_name, "main") == 0) {
-            name = "aria_main";
-        } else {
-            name = raw_name;
-        }
+// Parameters and body of 'node'; it is the innermost function while they are parsed
+static void parse_function_body(Parser* p, AstNode* node) {
+    if (p->function_level + 1 >= MAX_FUNCTION_NESTING) {
+        fprintf(stderr, "Fatal: Functions nested too deeply.\n");
+        exit(1);
     }
+    p->functions[++p->function_level] = (FunctionScope){ node, NULL };
 
-    consume(TOKEN_LPAREN, "Expect '(' after function name.");
+    consume(p, TOKEN_LPAREN, "Expect '(' after function name.");
     
-    begin_scope(); 
+    begin_scope(p); 
     
     AstNode* param_head = NULL;
     AstNode* param_cur = NULL;
     
-    if (current_token.type != TOKEN_RPAREN) {
+    if (p->current.type != TOKEN_RPAREN) {
         do {
-            consume(TOKEN_IDENTIFIER, "Expect parameter name.");
-            char* param_name = arena_strndup(global_arena, previous_token.start, previous_token.length);
-            int id = declare_variable(param_name);
+            consume(p, TOKEN_IDENTIFIER, "Expect parameter name.");
+            char* param_name = arena_strndup(p->arena, p->previous.start, p->previous.length);
             
-            AstNode* param = arena_alloc(global_arena);
-            param->type = NODE_VAR_DECL;
+            AstNode* param = new_node(p);
+            ast_set_type(param, NODE_VAR_DECL);
             param->data.var_decl.name = param_name;
-            param->data.var_decl.shadow_stack_offset = id;
+            param->data.var_decl.shadow_stack_offset = declare_variable(p, param_name, param);
             
             if (!param_head) param_head = param;
-            else param_cur->next = param;
+            else param_cur->next = ast_ref(param);
             param_cur = param;
             
-        } while (match(TOKEN_COMMA));
+        } while (match(p, TOKEN_COMMA));
     }
     
-    consume(TOKEN_RPAREN, "Expect ')' after parameters.");
-    consume(TOKEN_LBRACE, "Expect '{' before function body.");
+    consume(p, TOKEN_RPAREN, "Expect ')' after parameters.");
+    consume(p, TOKEN_LBRACE, "Expect '{' before function body.");
     
-    AstNode* body_block = parse_block(); 
+    node->data.func_decl.params = ast_ref(param_head); 
+    node->data.func_decl.body = ast_ref(parse_block(p)); 
     
-    end_scope();
+    end_scope(p);
+    p->function_level--;
+}
+
+static AstNode* parse_function(Parser* p) {
+    consume(p, TOKEN_IDENTIFIER, "Expect function name.");
+    char* raw_name = arena_strndup(p->arena, p->previous.start, p->previous.length);
     
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_FUNC_DECL;
+    char* name;
+    if (p->class_name) {
+        size_t cls_len = strlen(p->class_name);
+        size_t fn_len = strlen(raw_name);
+        char* mangled = malloc(cls_len + fn_len + 2);
+        sprintf(mangled, "%s_%s", p->class_name, raw_name);
+        name = arena_strndup(p->arena, mangled, cls_len + fn_len + 1);
+        free(mangled);
+    } else {
+        // FIX: Rename entry point to avoid conflict with compiler-generated main
+        if (strcmp(raw_name, "main") == 0) {
+            name = arena_strndup(p->arena, "aria_main", 9);
+        } else {
+            name = raw_name;
+        }
+    }
+
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_FUNC_DECL);
     node->data.func_decl.name = name;
-    node->data.func_decl.params = param_head; 
-    node->data.func_decl.body = body_block;
+    parse_function_body(p, node);
+    return node;
+}
+
+// Nested function: lifted to a top-level symbol named after its enclosing function
+static AstNode* parse_closure(Parser* p, const char* local_name) {
+    const char* outer = p->function_level > 0 ? p->functions[p->function_level].node->data.func_decl.name : "global";
+    char lifted[256];
+    int len = snprintf(lifted, sizeof(lifted), "%s__%s_%d", outer, local_name ? local_name : "lambda", ++p->closure_counter);
+    if (len >= (int)sizeof(lifted)) len = sizeof(lifted) - 1;
+
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_FUNC_DECL);
+    node->data.func_decl.name = arena_strndup(p->arena, lifted, len);
+    node->data.func_decl.is_closure = 1;
+    parse_function_body(p, node);
     return node;
 }
 
-AstNode* parse_class_decl() {
-    consume(TOKEN_IDENTIFIER, "Expect class name.");
-    char* name = arena_strndup(global_arena, previous_token.start, previous_token.length);
-    consume(TOKEN_LBRACE, "Expect '{' before class body.");
+// func (params) { ... } as an expression
+static AstNode* function_expression(Parser* p) {
+    return parse_closure(p, NULL);
+}
+
+// func name(params) { ... } inside a body: a local variable bound to a closure
+static AstNode* parse_local_function(Parser* p) {
+    consume(p, TOKEN_IDENTIFIER, "Expect function name.");
+    char* name = arena_strndup(p->arena, p->previous.start, p->previous.length);
+
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_VAR_DECL);
+    node->data.var_decl.name = name;
+    // Declared before the body so the function can call itself
+    node->data.var_decl.shadow_stack_offset = declare_variable(p, name, node);
+    node->data.var_decl.init_expr = ast_ref(parse_closure(p, name));
+    if (node->data.var_decl.is_captured) node->data.var_decl.is_boxed = 1;
+    return node;
+}
+
+static AstNode* parse_class_decl(Parser* p) {
+    consume(p, TOKEN_IDENTIFIER, "Expect class name.");
+    char* name = arena_strndup(p->arena, p->previous.start, p->previous.length);
+    consume(p, TOKEN_LBRACE, "Expect '{' before class body.");
     
-    current_class_name = name;
+    p->class_name = name;
     
     AstNode* head = NULL;
     AstNode* cur = NULL;
     
-    while (current_token.type != TOKEN_RBRACE && current_token.type != TOKEN_EOF) {
-        if (match(TOKEN_FUNC)) {
-             AstNode* method = parse_function();
+    while (p->current.type != TOKEN_RBRACE && p->current.type != TOKEN_EOF) {
+        if (match(p, TOKEN_FUNC)) {
+             AstNode* method = parse_function(p);
              if (!head) head = method;
-             else cur->next = method;
+             else cur->next = ast_ref(method);
              cur = method;
         } else {
-             if (had_error) synchronize(); 
-             else advance();
+             if (p->had_error) synchronize(p); 
+             else advance(p);
         }
     }
-    consume(TOKEN_RBRACE, "Expect '}' after class body.");
+    consume(p, TOKEN_RBRACE, "Expect '}' after class body.");
     
-    current_class_name = NULL;
+    p->class_name = NULL;
     
-    AstNode* node = arena_alloc(global_arena);
-    node->type = NODE_CLASS_DECL;
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_CLASS_DECL);
     node->data.class_decl.name = name;
-    node->data.class_decl.methods = head;
+    node->data.class_decl.methods = ast_ref(head);
+    return node;
+}
+
+// import name;  (resolved by the build driver to name.aria beside the importer)
+static AstNode* parse_import(Parser* p) {
+    consume(p, TOKEN_IDENTIFIER, "Expect module name after 'import'.");
+    AstNode* node = new_node(p);
+    ast_set_type(node, NODE_IMPORT);
+    node->data.string_val = arena_strndup(p->arena, p->previous.start, p->previous.length);
+    consume(p, TOKEN_SEMICOLON, "Expect ';' after import.");
     return node;
 }
 
-AstNode* parse_program(AstArena* arena) {
-    global_arena = arena;
-    init_rules();
-    advance(); 
+void parser_init(Parser* p, const char* source, size_t length, AstArena* arena, const char* path) {
+    memset(p, 0, sizeof(Parser));
+    lexer_init(&p->lexer, source, length);
+    p->arena = arena;
+    p->path = path;
+    p->next_var_id = 1;
+}
+
+AstNode* parser_parse(Parser* p) {
+    advance(p); 
     AstNode* head = NULL;
     AstNode* tail = NULL;
-    
-    symbol_count = 0;
-    current_scope_depth = 0;
-    unique_var_id_counter = 1;
-    current_class_name = NULL;
 
-    while (current_token.type != TOKEN_EOF) {
+    while (p->current.type != TOKEN_EOF) {
         AstNode* node = NULL;
-        if (match(TOKEN_FUNC)) node = parse_function();
-        else if (match(TOKEN_CLASS)) node = parse_class_decl();
-        else if (match(TOKEN_VAR)) node = parse_var_decl();
-        else if (match(TOKEN_MANAGED)) {
-            consume(TOKEN_VAR, "Expect 'var' after 'managed'.");
-            node = parse_var_decl();
+        if (match(p, TOKEN_FUNC)) node = parse_function(p);
+        else if (match(p, TOKEN_CLASS)) node = parse_class_decl(p);
+        else if (match(p, TOKEN_VAR)) node = parse_var_decl(p);
+        else if (match(p, TOKEN_IMPORT)) node = parse_import(p);
+        else if (match(p, TOKEN_MANAGED)) {
+            consume(p, TOKEN_VAR, "Expect 'var' after 'managed'.");
+            node = parse_var_decl(p);
             node->data.var_decl.is_managed = 1;
         } else {
-            if (had_error) synchronize();
-            else advance();
+            if (p->had_error) synchronize(p);
+            else advance(p);
         }
 
         if (node) {
             if (!head) head = node;
-            else tail->next = node;
+            else tail->next = ast_ref(node);
             tail = node;
         }
     }
-    if (had_error) exit(1);
+    return head;
+}
+
+AstNode* parse_program(const char* source, size_t length, const char* path, AstArena* arena) {
+    // The symbol table makes a Parser about 64KB; keep it off the stack
+    Parser* p = malloc(sizeof(Parser));
+    if (!p) { fprintf(stderr, "Fatal: Out of memory allocating parser.\n"); exit(1); }
+    parser_init(p, source, length, arena, path);
+    AstNode* head = parser_parse(p);
+    if (p->had_error) exit(1);
+    free(p);
     return head;
 }
@@ -0,0 +1,70 @@
+/* Aria_lang/src/frontend/parser.h */
+#ifndef ARIA_PARSER_H
+#define ARIA_PARSER_H
+
+#include "ast.h"
+#include "token.h"
+
+/*
+ * Parser Context
+ * --------------
+ * All parsing state lives in a Parser: the lexer, the current and previous
+ * token, the scope and symbol tables, the stack of functions being parsed
+ * and the error flags. Nodes and names go into the arena the context was
+ * given, so separate Parsers over separate arenas share nothing and can run
+ * on different threads (driver/parse_pool.h).
+ */
+
+#define MAX_SYMBOLS 2048
+#define MAX_FUNCTION_NESTING 64
+
+typedef struct {
+    const char* name;
+    int depth;
+    int id;
+    int level;          // function nesting level of the declaring function
+    AstNode* decl;      // NODE_VAR_DECL (locals and parameters)
+} Symbol;
+
+/*
+ * Functions currently being parsed, innermost last. Level 0 is the program
+ * scope; a local resolved from a deeper level than it was declared at is a
+ * capture and is recorded on every function in between (flat closures).
+ */
+typedef struct {
+    AstNode* node;
+    AstNode* upvalue_tail;
+} FunctionScope;
+
+typedef struct {
+    Lexer lexer;
+    Token current;
+    Token previous;
+    AstArena* arena;
+    const char* path;           // prefixes messages when set
+
+    int had_error;
+    int panic_mode;
+    char* class_name;           // class whose methods are being parsed
+
+    Symbol symbols[MAX_SYMBOLS];
+    int symbol_count;
+    int scope_depth;
+    int next_var_id;
+
+    FunctionScope functions[MAX_FUNCTION_NESTING];
+    int function_level;
+    int closure_counter;
+} Parser;
+
+// Prepares 'parser' to read 'source'; 'path' may be NULL
+void parser_init(Parser* parser, const char* source, size_t length, AstArena* arena, const char* path);
+
+// Parses the whole source into a list of top-level declarations.
+// Errors are reported on stderr and leave parser->had_error set.
+AstNode* parser_parse(Parser* parser);
+
+// One-shot parse for the command line driver: exits with status 1 on errors
+AstNode* parse_program(const char* source, size_t length, const char* path, AstArena* arena);
+
+#endif
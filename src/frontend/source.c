@@ -0,0 +1,62 @@
+/* Aria_lang/src/frontend/source.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "source.h"
+
+static int read_copy(SourceFile* source, int fd, size_t length) {
+    char* buf = malloc(length + 1);
+    if (!buf) return 0;
+    size_t got = 0;
+    while (got < length) {
+        ssize_t n = read(fd, buf + got, length - got);
+        if (n <= 0) { free(buf); return 0; }
+        got += (size_t)n;
+    }
+    buf[length] = '\0';
+    source->text = buf;
+    source->length = length;
+    source->mapped = 0;
+    return 1;
+}
+
+int source_load(SourceFile* source, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { close(fd); return 0; }
+
+    size_t length = (size_t)st.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    int ok;
+    if (length == 0 || length % page == 0) {
+        // No zero fill to terminate the text
+        ok = read_copy(source, fd, length);
+    } else {
+        void* map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ok = read_copy(source, fd, length);
+        } else {
+            madvise(map, length, MADV_SEQUENTIAL);
+            source->text = map;
+            source->length = length;
+            source->mapped = length;
+            ok = 1;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+void source_release(SourceFile* source) {
+    if (!source->text) return;
+    if (source->mapped) munmap((void*)source->text, source->mapped);
+    else free((void*)source->text);
+    source->text = NULL;
+    source->length = 0;
+    source->mapped = 0;
+}
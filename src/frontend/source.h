@@ -0,0 +1,30 @@
+/* Aria_lang/src/frontend/source.h */
+#ifndef ARIA_SOURCE_H
+#define ARIA_SOURCE_H
+
+#include <stddef.h>
+
+/*
+ * Source Files
+ * ------------
+ * Sources are mapped read-only rather than copied into the heap; tokens
+ * point straight into the mapping and the parser copies out only the names
+ * and literals it keeps (into its arena), so a source can be released as
+ * soon as it is parsed.
+ *
+ * The text is always NUL-terminated: a mapping whose length is not a
+ * multiple of the page size ends in zero fill, and a file that fills its
+ * last page exactly is read into the heap instead.
+ */
+
+typedef struct {
+    const char* text;
+    size_t length;
+    size_t mapped;      // bytes mapped, 0 when 'text' is a heap copy
+} SourceFile;
+
+// Returns 0 if the file cannot be opened or read
+int source_load(SourceFile* source, const char* path);
+void source_release(SourceFile* source);
+
+#endif
@@ -2,6 +2,9 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef enum {
     // Keywords
     TOKEN_FUNC, TOKEN_VAR, TOKEN_RETURN, 
@@ -9,6 +12,7 @@ typedef enum {
     TOKEN_CLASS, TOKEN_MANAGED, TOKEN_NEW,
     TOKEN_TRUE, TOKEN_FALSE, TOKEN_NULL,
     TOKEN_BREAK, TOKEN_CONTINUE,
+    TOKEN_IMPORT, TOKEN_IN, TOKEN_MATCH,
     
     // Feature: Ternary Operator
     // The user requested 'is' for the ternary condition.
@@ -48,6 +52,48 @@ typedef struct {
     int line;
 } Token;
 
-Token scan_token();
+/*
+ * Reentrant Lexer
+ * ---------------
+ * All scanning state lives in a Lexer, so any number of buffers can be
+ * tokenized at once (one Lexer per thread). Whitespace, comments, string
+ * bodies and identifiers are skipped a vector at a time where the build
+ * target has SSE2/SSE4.2/AVX2 (see lexer.c); other bytes are classified
+ * through a table instead of the locale-dependent <ctype.h> calls.
+ *
+ * The source must be NUL-terminated; 'length' excludes the NUL.
+ */
+typedef struct {
+    const char* source;
+    const char* start;       // first byte of the token being scanned
+    const char* current;
+    const char* end;
+    int line;
+} Lexer;
+
+void lexer_init(Lexer* lexer, const char* source, size_t length);
+Token lexer_next(Lexer* lexer);
+
+// 16 bytes per token: positions are offsets into the source buffer
+typedef struct {
+    uint32_t offset;
+    uint32_t length;         // TOKEN_ERROR: index of the message (see token_at)
+    uint32_t line;
+    uint32_t type;           // TokenType
+} LexToken;
+
+typedef struct {
+    const char* source;
+    LexToken* tokens;        // ends with TOKEN_EOF
+    int count;
+    int capacity;
+    int error_count;
+} TokenArray;
+
+// Tokenizes a whole buffer. Returns 0 if the buffer is too large to index.
+int lex_all(const char* source, size_t length, TokenArray* out);
+void token_array_free(TokenArray* tokens);
+// Expands token 'index' back into a Token pointing into the source
+Token token_at(const TokenArray* tokens, int index);
 
 #endif
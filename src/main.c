@@ -3,17 +3,32 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <limits.h>
 #include <sys/wait.h>
 #include "frontend/ast.h"
+#include "frontend/parser.h"
+#include "frontend/source.h"
 #include "runtime/bundler.h"
-
-// Defined in parser.c / lexer.c
-extern AstNode* parse_program(AstArena* arena);
-extern void init_lexer(const char* source);
+#include "backend/x64.h"
+#include "backend/pgo.h"
+#include "driver/cache.h"
+#include "driver/build.h"
+#include "driver/sha256.h"
+#ifdef ARIA_ENABLE_LLVM
+#include "core/llvm_integration.h"
+#endif
 
 // Defined in codegen.c
 extern void gen_program(AstNode* head);
-extern FILE* asm_out;
+extern X64Program* x64_out;
+
+// Defined in escape.c
+extern int escape_enabled;
+
+#ifdef ARIA_ENABLE_LLVM
+// Defined in llvm_codegen.c
+extern bool gen_program_llvm(TeslaLLVMContext* ctx, AstNode* head);
+#endif
 
 char* read_entire_file(const char* path) {
     FILE* f = fopen(path, "rb");
@@ -62,11 +77,149 @@ int run_command(char* const* argv) {
     }
 }
 
+/*
+ * A source parsed before by this same compiler is mapped back from the cache
+ * directory instead of being lexed and parsed again.
+ */
+static AstNode* parse_source(BuildCache* cache, SourceFile* source, const char* path, AstArena* arena) {
+    if (!cache->compiler[0]) return parse_program(source->text, source->length, path, arena);
+
+    char key[65];
+    char ast_path[PATH_MAX + 80];
+    AstNode* root;
+    cache_ast_key(cache->compiler, source->text, source->length, key);
+    snprintf(ast_path, sizeof(ast_path), "%s/%s.ast", cache->dir, key);
+    if (arena_load(arena, key, ast_path, &root)) return root;
+    root = parse_program(source->text, source->length, path, arena);
+    arena_save(arena, root, key, ast_path);
+    return root;
+}
+
+#ifdef ARIA_ENABLE_LLVM
+/*
+ * `aria_compiler run <input.aria> [args...]`
+ * Compiles straight to memory and executes through the MCJIT engine. No .asm
+ * or .o is written and neither nasm nor cc is spawned; runtime symbols come
+ * from the libaria copy linked into this driver.
+ */
+static int run_jit(const char* input_file, int argc, char** argv) {
+    SourceFile source;
+    if (!source_load(&source, input_file)) {
+        fprintf(stderr, "Error: Could not read file %s\n", input_file);
+        return 1;
+    }
+
+    AstArena* arena = arena_create(source.length);
+    if (!arena) return 1;
+    AstNode* root = parse_program(source.text, source.length, input_file, arena);
+    source_release(&source);
+
+    TeslaLLVMContext llvm_ctx;
+    if (!tesla_llvm_init(&llvm_ctx, input_file) || !gen_program_llvm(&llvm_ctx, root)) {
+        fprintf(stderr, "[Aria] LLVM backend failed: %s\n", tesla_llvm_get_error(&llvm_ctx));
+        return 1;
+    }
+    arena_free(arena);
+
+    tesla_llvm_optimize_module(&llvm_ctx, 2);
+    if (!tesla_llvm_create_jit(&llvm_ctx, 2)) {
+        fprintf(stderr, "[Aria] %s\n", tesla_llvm_get_error(&llvm_ctx));
+        return 1;
+    }
+
+    int status = tesla_llvm_run_main(&llvm_ctx, argc, (const char* const*)argv);
+    tesla_llvm_cleanup(&llvm_ctx);
+    return status;
+}
+#endif
+
 int main(int argc, char** argv) {
     if (argc < 2) {
-        printf("Usage: aria_compiler <input.aria> [--asm-only]\n");
+        printf("Usage: aria_compiler <input.aria> [-c] [--asm-only] [--nasm] [--llvm] [--emit-llvm] [--no-cache] [--no-stack-alloc]\n");
+        printf("       aria_compiler <input.aria> [--profile-generate | --profile-use <file>]\n");
+        printf("       aria_compiler run <input.aria> [args...]\n");
+        printf("       aria_compiler build <main.aria> [-j N] [-c]\n");
+        return 1;
+    }
+
+    if (strcmp(argv[1], "build") == 0) {
+        const char* root_file = NULL;
+        long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+        int link = 1;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "-c") == 0) link = 0;
+            else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) jobs = atol(argv[++i]);
+            else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2]) jobs = atol(argv[i] + 2);
+            else if (!root_file) root_file = argv[i];
+            else {
+                fprintf(stderr, "Error: Unexpected argument %s\n", argv[i]);
+                return 1;
+            }
+        }
+        if (!root_file) {
+            fprintf(stderr, "Error: No input file.\n");
+            return 1;
+        }
+        if (!bundler_init()) {
+            fprintf(stderr, "Fatal: Failed to initialize bundled toolchain.\n");
+            return 1;
+        }
+        return build_modules(root_file, jobs > 0 ? (int)jobs : 1, link);
+    }
+
+    if (strcmp(argv[1], "run") == 0) {
+#ifdef ARIA_ENABLE_LLVM
+        if (argc < 3) {
+            fprintf(stderr, "Error: No input file.\n");
+            return 1;
+        }
+        // The program sees its own path as argv[0]
+        return run_jit(argv[2], argc - 2, argv + 2);
+#else
+        fprintf(stderr, "Error: 'run' requires the LLVM backend (rebuild with ARIA_LLVM=1).\n");
+        return 1;
+#endif
+    }
+
+    const char* input_file = NULL;
+    int asm_only = 0;
+    int use_nasm = 0;
+    int compile_only = 0;
+    int use_llvm = 0;
+    int emit_llvm = 0;
+    int use_cache = 1;
+    const char* profile_file = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--asm-only") == 0) asm_only = 1;
+        else if (strcmp(argv[i], "--nasm") == 0) use_nasm = 1;
+        else if (strcmp(argv[i], "-c") == 0) compile_only = 1;
+        else if (strcmp(argv[i], "--no-cache") == 0) use_cache = 0;
+        else if (strcmp(argv[i], "--no-stack-alloc") == 0) escape_enabled = 0;
+        else if (strcmp(argv[i], "--llvm") == 0) use_llvm = 1;
+        else if (strcmp(argv[i], "--emit-llvm") == 0) { use_llvm = 1; emit_llvm = 1; }
+        else if (strcmp(argv[i], "--profile-generate") == 0) pgo_mode = PGO_GENERATE;
+        else if (strcmp(argv[i], "--profile-use") == 0 && i + 1 < argc) { pgo_mode = PGO_USE; profile_file = argv[++i]; }
+        else if (!input_file) input_file = argv[i];
+        else {
+            fprintf(stderr, "Error: Unexpected argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!input_file) {
+        fprintf(stderr, "Error: No input file.\n");
+        return 1;
+    }
+#ifndef ARIA_ENABLE_LLVM
+    if (use_llvm) {
+        fprintf(stderr, "Error: This compiler was built without the LLVM backend (rebuild with ARIA_LLVM=1).\n");
         return 1;
     }
+#endif
+    if (pgo_mode != PGO_OFF && use_llvm) {
+        fprintf(stderr, "Error: Profile-guided builds use the native backend only.\n");
+        return 1;
+    }
+    if (pgo_mode == PGO_USE && !pgo_load(profile_file)) return 1;
 
     // 0. Initialize Tool Bundler (Extract nasm/cc/libaria)
     if (!bundler_init()) {
@@ -74,22 +227,24 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    const char* input_file = argv[1];
-    int asm_only = (argc >= 3 && strcmp(argv[2], "--asm-only") == 0);
-
-    // 1. Read Source
-    char* source = read_entire_file(input_file);
-    if (!source) {
+    // 1. Map Source
+    SourceFile source;
+    if (!source_load(&source, input_file)) {
         fprintf(stderr, "Error: Could not read file %s\n", input_file);
         return 1;
     }
 
-    // 2. Setup Arena & Parse
-    AstArena* arena = arena_create();
-    init_lexer(source);
-    AstNode* root = parse_program(arena);
-    
-    // 3. Determine Output Names
+    // Programs split into modules go through the separate-compilation driver
+    if (source_has_imports(source.text, source.length)) {
+        if (use_llvm || asm_only || use_nasm || pgo_mode != PGO_OFF) {
+            fprintf(stderr, "Error: Programs with imports are built with the native backend only.\n");
+            return 1;
+        }
+        source_release(&source);
+        return build_modules(input_file, 1, !compile_only);
+    }
+
+    // 2. Determine Output Names
     char asm_file[256];
     char obj_file[256];
     char bin_file[256];
@@ -98,36 +253,131 @@ int main(int argc, char** argv) {
     replace_extension(input_file, ".o", obj_file, sizeof(obj_file));
     replace_extension(input_file, "", bin_file, sizeof(bin_file)); 
 
-    // 4. Codegen
-    asm_out = fopen(asm_file, "w");
-    if (!asm_out) {
-        fprintf(stderr, "Error: Could not open output file %s\n", asm_file);
-        return 1;
+    // 3. Build Cache: identical source + compiler + flags + runtime => reuse outputs
+    BuildCache cache;
+    memset(&cache, 0, sizeof(cache));
+    if (use_cache) {
+        // A profile-use build depends on the profile's contents, not its name
+        char profile_hex[65] = "none";
+        if (pgo_mode == PGO_USE) {
+            char* profile = read_entire_file(profile_file);
+            Sha256 ctx;
+            sha256_init(&ctx);
+            if (profile) sha256_update(&ctx, profile, strlen(profile));
+            sha256_final_hex(&ctx, profile_hex);
+            free(profile);
+        }
+        // Debug info names the source as given and the directory it was built in
+        char cwd[PATH_MAX];
+        if (!getcwd(cwd, sizeof(cwd))) strcpy(cwd, ".");
+        char flags[700 + 2 * PATH_MAX];
+        snprintf(flags, sizeof(flags), "backend=%s;cc=%s;stack_alloc=%d;profile=%s:%s;debug=%s:%s",
+                 use_llvm ? "llvm" : use_nasm ? "nasm" : "x64", bundler_get_cc_path(), escape_enabled,
+                 pgo_mode == PGO_GENERATE ? "gen" : pgo_mode == PGO_USE ? "use" : "off", profile_hex,
+                 cwd, input_file);
+        cache_open(&cache, source.text, source.length, flags, bundler_get_runtime_path());
+        const char* want = compile_only ? obj_file : bin_file;
+        if (!asm_only && !emit_llvm && cache_fetch(&cache, compile_only ? "o" : "bin", want)) {
+            source_release(&source);
+            printf("[Aria] Cache hit: %s\n", want);
+            return 0;
+        }
     }
-    
-    gen_program(root);
-    fclose(asm_out);
-    
-    arena_free(arena);
-    free(source);
-    
-    printf("[Aria] Generated Assembly: %s\n", asm_file);
 
-    if (asm_only) return 0;
+    // 4. Setup Arena & Parse (or map the AST cached for this exact text)
+    AstArena* arena = arena_create(source.length);
+    if (!arena) return 1;
+    AstNode* root = parse_source(&cache, &source, input_file, arena);
+    // The AST holds arena copies of everything it needs from the text
+    source_release(&source);
 
-    // 5. Assemble and Link (Secure Execution using Bundled Tools)
-    
-    // Step A: NASM
-    char* nasm_cmd = (char*)bundler_get_nasm_path();
-    char* nasm_args[] = { nasm_cmd, "-f", "elf64", asm_file, "-o", obj_file, NULL };
-    
-    printf("[Aria] Assembling with %s...\n", nasm_cmd);
-    if (run_command(nasm_args) != 0) {
-        fprintf(stderr, "[Aria] Assembler failed.\n");
-        return 1;
+    // 5. Codegen
+#ifdef ARIA_ENABLE_LLVM
+    if (use_llvm) {
+        // LLVM path: AST -> IR -> O2 pipeline -> object file, no NASM involved
+        TeslaLLVMContext llvm_ctx;
+        if (!tesla_llvm_init(&llvm_ctx, input_file) || !gen_program_llvm(&llvm_ctx, root)) {
+            fprintf(stderr, "[Aria] LLVM backend failed: %s\n", tesla_llvm_get_error(&llvm_ctx));
+            return 1;
+        }
+        arena_free(arena);
+        tesla_llvm_optimize_module(&llvm_ctx, 2);
+
+        if (emit_llvm) {
+            char ll_file[256];
+            char* error = NULL;
+            replace_extension(input_file, ".ll", ll_file, sizeof(ll_file));
+            if (LLVMPrintModuleToFile(llvm_ctx.module, ll_file, &error)) {
+                fprintf(stderr, "[Aria] Could not write %s: %s\n", ll_file, error ? error : "unknown error");
+                LLVMDisposeMessage(error);
+                return 1;
+            }
+            tesla_llvm_cleanup(&llvm_ctx);
+            printf("[Aria] Generated LLVM IR: %s\n", ll_file);
+            return 0;
+        }
+
+        printf("[Aria] Emitting object with LLVM...\n");
+        if (!tesla_llvm_compile_to_object(&llvm_ctx, obj_file)) {
+            fprintf(stderr, "[Aria] %s\n", tesla_llvm_get_error(&llvm_ctx));
+            return 1;
+        }
+        tesla_llvm_cleanup(&llvm_ctx);
+    } else
+#endif
+    {
+        X64Program prog;
+        x64_program_init(&prog);
+        prog.source_file = input_file;
+        x64_out = &prog;
+        gen_program(root);
+        x64_out = NULL;
+
+        if (asm_only || use_nasm) {
+            // Textual assembly: debugging aid, and input for the external assembler path
+            FILE* asm_fp = fopen(asm_file, "w");
+            if (!asm_fp) {
+                fprintf(stderr, "Error: Could not open output file %s\n", asm_file);
+                return 1;
+            }
+            x64_print_nasm(&prog, asm_fp);
+            fclose(asm_fp);
+            printf("[Aria] Generated Assembly: %s\n", asm_file);
+        }
+
+        if (asm_only) return 0;
+
+        // 6. Assemble (built-in encoder by default, NASM with --nasm)
+        if (use_nasm) {
+            char* nasm_cmd = (char*)bundler_get_nasm_path();
+            // %line markers in the source become NASM's DWARF line table
+            char* nasm_args[] = { nasm_cmd, "-f", "elf64", "-g", "-F", "dwarf", asm_file, "-o", obj_file, NULL };
+
+            printf("[Aria] Assembling with %s...\n", nasm_cmd);
+            if (run_command(nasm_args) != 0) {
+                fprintf(stderr, "[Aria] Assembler failed.\n");
+                return 1;
+            }
+        } else {
+            X64Object obj;
+            printf("[Aria] Encoding object: %s\n", obj_file);
+            if (!x64_encode(&prog, &obj) || !elf_write_object(&obj, obj_file)) {
+                fprintf(stderr, "[Aria] Object emission failed.\n");
+                return 1;
+            }
+            x64_object_free(&obj);
+        }
+        x64_program_free(&prog);
+        arena_free(arena);
     }
 
-    // Step B: Linker (TCC/GCC)
+    cache_store(&cache, "o", obj_file);
+    if (compile_only) {
+        printf("[Aria] Generated Object: %s\n", obj_file);
+        return 0;
+    }
+
+    // 7. Link (TCC/GCC)
     char* cc_cmd = (char*)bundler_get_cc_path();
     char* runtime_lib = (char*)bundler_get_runtime_path();
     
@@ -148,6 +398,8 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    cache_store(&cache, "bin", bin_file);
+
     // Cleanup object file
     remove(obj_file);
 
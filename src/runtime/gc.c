@@ -11,10 +11,13 @@
 #include "gc.h"
 
 #define HEAP_LIMIT (1024 * 1024 * 64) 
-#define BLOOM_SIZE 65536             
+#define TABLE_MIN 1024               // object table slots, a power of two
+#define STRING_HEADER_SIZE 8         // see stdlib/string_utils.c
 
-// NaN Boxing Constants for Masking
-#define TAG_MASK 0xFFFF000000000000ULL
+// NaN Boxing Constants for Masking. Boxed strings, objects and lists are
+// TAG_BASE | pointer | type (5-7) in the low 3 bits; closure records and
+// packed int arrays (stdlib/dataStructures.c) carry all 16 top bits.
+#define TAG_BASE 0xFFF8000000000000ULL
 #define PTR_MASK 0x0000FFFFFFFFFFFFULL
 
 volatile int32_t gc_suspend_request = 0; 
@@ -25,8 +28,13 @@ static pthread_cond_t gc_stopped_cond = PTHREAD_COND_INITIALIZER;
 static atomic_int active_thread_count = 0;
 static atomic_int stopped_thread_count = 0;
 static atomic_size_t bytes_allocated = 0;
+// Collect once this much is allocated: HEAP_LIMIT, or twice what the last
+// collection kept, so a large live heap is not rescanned on every allocation
+static atomic_size_t next_collection = HEAP_LIMIT;
 
-static uint64_t bloom[BLOOM_SIZE / 64]; 
+// Lifetime totals, reported at exit when ARIA_GC_STATS is set
+static atomic_size_t total_allocations = 0;
+static atomic_size_t total_bytes = 0;
 
 typedef struct RootEntry {
     void** ptr;
@@ -39,8 +47,7 @@ static pthread_mutex_t roots_lock = PTHREAD_MUTEX_INITIALIZER;
 typedef struct ThreadDesc {
     pthread_t thread_id;
     void* stack_bottom; 
-    void* stack_top;    
-    jmp_buf regs;       
+    void* stack_top;    // where its last safepoint saved its registers
     struct ThreadDesc* next;
 } ThreadDesc;
 
@@ -57,22 +64,62 @@ typedef struct ObjHeader {
 static ObjHeader* heap_head = NULL;
 static pthread_mutex_t alloc_lock = PTHREAD_MUTEX_INITIALIZER;
 
-static inline void bloom_add(void* ptr) {
-    uintptr_t h = (uintptr_t)ptr;
+// Live objects by payload address, so marking can tell a heap pointer from
+// any other word without walking the heap: open addressing with linear
+// probing, kept at most half full. Written under alloc_lock.
+static ObjHeader** object_table = NULL;
+static size_t table_mask = 0;
+static size_t table_count = 0;
+
+static inline size_t table_slot(void* payload) {
+    uintptr_t h = (uintptr_t)payload;
     h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
     h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
     h = h ^ (h >> 31);
-    uint32_t idx = h % BLOOM_SIZE;
-    bloom[idx / 64] |= (1ULL << (idx % 64));
+    return (size_t)h & table_mask;
 }
 
-static inline int bloom_check(void* ptr) {
-    uintptr_t h = (uintptr_t)ptr;
-    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
-    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
-    h = h ^ (h >> 31);
-    uint32_t idx = h % BLOOM_SIZE;
-    return (bloom[idx / 64] & (1ULL << (idx % 64))) != 0;
+static void table_put(ObjHeader* h) {
+    size_t i = table_slot(h + 1);
+    while (object_table[i]) i = (i + 1) & table_mask;
+    object_table[i] = h;
+    table_count++;
+}
+
+// Empties the table, sized for 'count' objects
+static void table_reset(size_t count) {
+    size_t slots = TABLE_MIN;
+    while (slots < count * 2) slots *= 2;
+    if (slots != table_mask + 1) {
+        free(object_table);
+        object_table = calloc(slots, sizeof(ObjHeader*));
+        if (!object_table) { fprintf(stderr, "OOM\n"); exit(1); }
+        table_mask = slots - 1;
+    } else {
+        memset(object_table, 0, slots * sizeof(ObjHeader*));
+    }
+    table_count = 0;
+}
+
+static void table_add(ObjHeader* h) {
+    if (!object_table || (table_count + 1) * 2 > table_mask + 1) {
+        ObjHeader** old = object_table;
+        size_t old_slots = old ? table_mask + 1 : 0;
+        object_table = NULL;
+        table_mask = 0;
+        table_reset(table_count + 1);
+        for (size_t i = 0; i < old_slots; i++) if (old[i]) table_put(old[i]);
+        free(old);
+    }
+    table_put(h);
+}
+
+static inline ObjHeader* table_find(void* payload) {
+    if (!object_table) return NULL;
+    for (size_t i = table_slot(payload); object_table[i]; i = (i + 1) & table_mask) {
+        if ((void*)(object_table[i] + 1) == payload) return object_table[i];
+    }
+    return NULL;
 }
 
 void aria_register_global_root(void** ptr) {
@@ -88,6 +135,7 @@ void gc_register_thread(void* stack_bottom) {
     ThreadDesc* td = malloc(sizeof(ThreadDesc));
     td->thread_id = pthread_self();
     td->stack_bottom = stack_bottom;
+    td->stack_top = NULL;
     td->next = NULL;
     pthread_mutex_lock(&thread_list_lock);
     td->next = threads_head;
@@ -114,24 +162,25 @@ void gc_unregister_thread() {
 }
 
 void gc_enter_safepoint() {
+    // Registers and stack are scanned from here up, as in perform_collection
+    jmp_buf regs;
+    setjmp(regs);
     pthread_mutex_lock(&gc_sync_lock);
     pthread_t self = pthread_self();
     pthread_mutex_lock(&thread_list_lock);
     ThreadDesc* curr = threads_head;
     while (curr) {
         if (pthread_equal(curr->thread_id, self)) {
-            setjmp(curr->regs);
-            curr->stack_top = __builtin_frame_address(0);
+            curr->stack_top = (void*)&regs;
             break;
         }
         curr = curr->next;
     }
     pthread_mutex_unlock(&thread_list_lock);
 
+    // The collector is running and waits for every other thread
     atomic_fetch_add(&stopped_thread_count, 1);
-    if (atomic_load(&stopped_thread_count) == atomic_load(&active_thread_count)) {
-        pthread_cond_signal(&gc_stopped_cond);
-    }
+    pthread_cond_signal(&gc_stopped_cond);
     
     while (atomic_load((_Atomic int32_t*)&gc_suspend_request) != 0) {
         pthread_cond_wait(&gc_resume_cond, &gc_sync_lock);
@@ -147,32 +196,29 @@ void mark_object(void* ptr) {
 
     // 1. Unmask NaN-boxed pointers
     uint64_t val = (uint64_t)ptr;
-    // If top bits are set (NaN Tag), mask them out to get the pointer
-    if ((val & TAG_MASK) == TAG_MASK) {
-        ptr = (void*)(val & PTR_MASK);
+    // If the NaN tag is set, mask it and the type bits out to get the pointer
+    if ((val & TAG_BASE) == TAG_BASE) {
+        ptr = (void*)(val & PTR_MASK & ~7ULL);
     }
 
     // 2. Validate Pointer
     if (!ptr) return;
     if ((uintptr_t)ptr % 8 != 0) return; // Alignment check
-    if (!bloom_check(ptr)) return;
+    ObjHeader* curr = table_find(ptr);
+    // Strings are referenced by their characters, just past an 8-byte header
+    if (!curr) {
+        curr = table_find((char*)ptr - STRING_HEADER_SIZE);
+        if (!curr || curr->size <= STRING_HEADER_SIZE) return;
+    }
 
-    ObjHeader* curr = heap_head;
-    while (curr) {
-        void* payload = (void*)(curr + 1);
-        if (ptr == payload) {
-            if (!curr->marked) {
-                curr->marked = 1;
-                // Scan payload
-                void** fields = (void**)payload;
-                size_t cnt = curr->size / sizeof(void*);
-                for (size_t i = 0; i < cnt; i++) {
-                    mark_object(fields[i]);
-                }
-            }
-            return;
+    if (!curr->marked) {
+        curr->marked = 1;
+        // Scan payload
+        void** fields = (void**)(curr + 1);
+        size_t cnt = curr->size / sizeof(void*);
+        for (size_t i = 0; i < cnt; i++) {
+            mark_object(fields[i]);
         }
-        curr = curr->next;
     }
 }
 
@@ -198,21 +244,21 @@ void perform_collection() {
     }
     pthread_mutex_unlock(&gc_sync_lock);
     
+    // This thread's callee-saved registers may hold the only reference to
+    // an object: setjmp spills them into a local, and the scan starts below
+    // it so the registers this function saved on entry are covered too
+    jmp_buf self_regs;
+    setjmp(self_regs);
+    void* self_top = (void*)&self_regs;
+    pthread_t self = pthread_self();
+
     pthread_mutex_lock(&thread_list_lock);
     ThreadDesc* curr = threads_head;
-    while (curr) {
-        mark_range(curr->stack_top, curr->stack_bottom);
-        mark_range(curr->regs, (void*)((uintptr_t)curr->regs + sizeof(jmp_buf)));
-        curr = curr->next;
-    }
-    
-    void* self_top = __builtin_frame_address(0);
-    curr = threads_head;
-    pthread_t self = pthread_self();
     while (curr) {
         if (pthread_equal(curr->thread_id, self)) {
             mark_range(self_top, curr->stack_bottom);
-            break;
+        } else if (curr->stack_top) {
+            mark_range(curr->stack_top, curr->stack_bottom);
         }
         curr = curr->next;
     }
@@ -227,8 +273,7 @@ void perform_collection() {
     pthread_mutex_unlock(&roots_lock);
     
     pthread_mutex_lock(&alloc_lock);
-    memset(bloom, 0, sizeof(bloom));
-    
+    size_t live = 0;
     ObjHeader** node = &heap_head;
     while (*node) {
         ObjHeader* entry = *node;
@@ -238,10 +283,14 @@ void perform_collection() {
             free(entry);
         } else {
             entry->marked = 0;
-            bloom_add((void*)(entry + 1));
+            live++;
             node = &entry->next;
         }
     }
+    table_reset(live);
+    for (ObjHeader* entry = heap_head; entry; entry = entry->next) table_put(entry);
+    size_t kept = atomic_load(&bytes_allocated);
+    atomic_store(&next_collection, kept * 2 > HEAP_LIMIT ? kept * 2 : HEAP_LIMIT);
     pthread_mutex_unlock(&alloc_lock);
     
     pthread_mutex_lock(&gc_sync_lock);
@@ -257,7 +306,7 @@ void* aria_alloc(size_t size) {
         gc_enter_safepoint();
     }
 
-    if (atomic_load(&bytes_allocated) + size > HEAP_LIMIT) {
+    if (atomic_load(&bytes_allocated) + size > atomic_load(&next_collection)) {
         perform_collection();
     }
     
@@ -276,14 +325,26 @@ void* aria_alloc(size_t size) {
     h->next = heap_head;
     heap_head = h;
     atomic_fetch_add(&bytes_allocated, size);
-    bloom_add(h + 1);
+    atomic_fetch_add(&total_allocations, 1);
+    atomic_fetch_add(&total_bytes, size);
+    table_add(h);
     pthread_mutex_unlock(&alloc_lock);
     
     return (void*)(h + 1);
 }
 
+static void report_stats(void) {
+    fprintf(stderr, "[Aria GC] %zu allocations, %zu bytes\n",
+            atomic_load(&total_allocations), atomic_load(&total_bytes));
+}
+
+// Top of the main thread's stack, set by the dynamic loader. Constructors
+// run before _start resets the stack, so their own frames lie below main's.
+extern void* __libc_stack_end;
+
 __attribute__((constructor))
 void aria_runtime_init() {
-    void* stack_bottom = __builtin_frame_address(0); 
-    gc_register_thread(stack_bottom);
+    gc_register_thread(__libc_stack_end);
+    const char* stats = getenv("ARIA_GC_STATS");
+    if (stats && *stats && strcmp(stats, "0") != 0) atexit(report_stats);
 }
@@ -26,8 +26,4 @@ void mark_range(void* start, void* end);
 // Memory allocation
 void* aria_alloc(size_t size);
 
-// Internal bloom filter functions (static inline, defined in gc.c)
-// static inline void bloom_add(void* ptr);
-// static inline int bloom_check(void* ptr);
-
 #endif
\ No newline at end of file
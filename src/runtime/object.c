@@ -14,12 +14,14 @@ typedef uint64_t Value;
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+// Objects are 8-byte aligned and box_ptr ORs the type tag into the low bits
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 
 typedef struct {
     char* key;
     Value value; 
     int is_occupied; 
+    uint32_t hash;   // hash_key(key), so probes and resizes skip most strcmp calls
 } Entry;
 
 typedef struct {
@@ -39,6 +41,11 @@ static uint32_t hash_key(const char* key) {
     return hash;
 }
 
+// Same pointer, or the same hash and text
+static inline int same_key(const Entry* e, const char* key, uint32_t hash) {
+    return e->key == key || (e->hash == hash && strcmp(e->key, key) == 0);
+}
+
 void* aria_alloc_object() {
     AriaObject* obj = (AriaObject*)aria_alloc(sizeof(AriaObject));
     obj->capacity = INITIAL_CAPACITY;
@@ -47,6 +54,32 @@ void* aria_alloc_object() {
     return (void*)box_ptr(obj, TAG_OBJECT);
 }
 
+// Object with room for 'count' properties before it first resizes
+void* aria_alloc_object_sized(long long count) {
+    int capacity = INITIAL_CAPACITY;
+    while (count * 4 > (long long)capacity * 3) capacity *= 2;
+    AriaObject* obj = (AriaObject*)aria_alloc(sizeof(AriaObject));
+    obj->capacity = capacity;
+    obj->count = 0;
+    obj->entries = (Entry*)aria_alloc(sizeof(Entry) * capacity);
+    return (void*)box_ptr(obj, TAG_OBJECT);
+}
+
+/*
+ * Frame object: the compiler reserved OBJECT_FRAME_BYTES in the caller's
+ * stack frame (backend/escape.h) for the header and its initial entries.
+ */
+#define OBJECT_FRAME_BYTES 208
+typedef char object_frame_fits[sizeof(AriaObject) + sizeof(Entry) * INITIAL_CAPACITY <= OBJECT_FRAME_BYTES ? 1 : -1];
+
+void* aria_alloc_object_at(void* mem) {
+    AriaObject* obj = (AriaObject*)mem;
+    memset(mem, 0, sizeof(AriaObject) + sizeof(Entry) * INITIAL_CAPACITY);
+    obj->capacity = INITIAL_CAPACITY;
+    obj->entries = (Entry*)(obj + 1);
+    return (void*)box_ptr(obj, TAG_OBJECT);
+}
+
 static void resize_object(AriaObject* obj) {
     int old_cap = obj->capacity;
     Entry* old_entries = obj->entries;
@@ -55,8 +88,7 @@ static void resize_object(AriaObject* obj) {
 
     for (int i = 0; i < old_cap; i++) {
         if (old_entries[i].is_occupied == 1) {
-            uint32_t hash = hash_key(old_entries[i].key);
-            int idx = hash % new_cap;
+            int idx = old_entries[i].hash % new_cap;
             while (new_entries[idx].is_occupied) idx = (idx + 1) % new_cap;
             new_entries[idx] = old_entries[i];
         }
@@ -79,7 +111,7 @@ void* aria_obj_set(void* obj_tagged, char* key, void* value_tagged) {
     int idx = hash % obj->capacity;
 
     while (obj->entries[idx].is_occupied) {
-        if (strcmp(obj->entries[idx].key, key) == 0) {
+        if (same_key(&obj->entries[idx], key, hash)) {
             obj->entries[idx].value = val;
             return value_tagged;
         }
@@ -89,24 +121,85 @@ void* aria_obj_set(void* obj_tagged, char* key, void* value_tagged) {
     obj->entries[idx].key = key;
     obj->entries[idx].value = val;
     obj->entries[idx].is_occupied = 1;
+    obj->entries[idx].hash = hash;
     obj->count++;
     return value_tagged;
 }
 
-void* aria_obj_get(void* obj_tagged, char* key) {
-    AriaObject* obj = (AriaObject*)unbox_ptr((Value)obj_tagged);
-    if (!obj) { fprintf(stderr, "Runtime Error: Get on null object.\n"); exit(1); }
-    if (!key) return (void*)0; 
-
+// Slot holding 'key', or -1
+static int find_entry(AriaObject* obj, const char* key) {
     uint32_t hash = hash_key(key);
     int idx = hash % obj->capacity;
     int start_idx = idx;
     int looped = 0;
 
     while (obj->entries[idx].is_occupied) {
-        if (strcmp(obj->entries[idx].key, key) == 0) return (void*)obj->entries[idx].value;
+        if (same_key(&obj->entries[idx], key, hash)) return idx;
         idx = (idx + 1) % obj->capacity;
         if (idx == start_idx || ++looped > obj->capacity) break; 
     }
-    return (void*)0; 
+    return -1;
+}
+
+void* aria_obj_get(void* obj_tagged, char* key) {
+    AriaObject* obj = (AriaObject*)unbox_ptr((Value)obj_tagged);
+    if (!obj) { fprintf(stderr, "Runtime Error: Get on null object.\n"); exit(1); }
+    if (!key) return (void*)0; 
+
+    int idx = find_entry(obj, key);
+    return idx < 0 ? (void*)0 : (void*)obj->entries[idx].value;
+}
+
+/*
+ * Profile-guided property reads (backend/pgo.h). An instrumented build
+ * counts each read in counters[0] and leaves the slot it found, plus one, in
+ * counters[1]. An optimized build gives each hot read site a cache word that
+ * starts out empty; until the site caches a slot of its own it tries the
+ * 'seed' slot from the training run before falling back to a full lookup.
+ */
+void* aria_obj_get_profiled(void* obj_tagged, char* key, uint64_t* counters) {
+    AriaObject* obj = (AriaObject*)unbox_ptr((Value)obj_tagged);
+    if (!obj) { fprintf(stderr, "Runtime Error: Get on null object.\n"); exit(1); }
+    counters[0]++;
+    if (!key) return (void*)0;
+
+    int idx = find_entry(obj, key);
+    if (idx < 0) return (void*)0;
+    counters[1] = (uint64_t)idx + 1;
+    return (void*)obj->entries[idx].value;
+}
+
+void* aria_obj_get_cached(void* obj_tagged, char* key, int64_t* cache, int64_t seed) {
+    AriaObject* obj = (AriaObject*)unbox_ptr((Value)obj_tagged);
+    if (!obj) { fprintf(stderr, "Runtime Error: Get on null object.\n"); exit(1); }
+    if (!key) return (void*)0;
+
+    int64_t hint = *cache ? *cache : seed;
+    if (hint > 0 && hint <= obj->capacity) {
+        Entry* e = &obj->entries[hint - 1];
+        if (e->is_occupied && (e->key == key || strcmp(e->key, key) == 0)) return (void*)e->value;
+    }
+    int idx = find_entry(obj, key);
+    if (idx < 0) return (void*)0;
+    *cache = idx + 1;
+    return (void*)obj->entries[idx].value;
+}
+
+/*
+ * Property iteration in slot order, for runtime code that visits every
+ * property (stdlib/json.c): returns the first occupied slot at or after
+ * 'slot' and fills in its key and value, or returns -1.
+ */
+long long aria_obj_next(void* obj_tagged, long long slot, char** key, void** value) {
+    AriaObject* obj = (AriaObject*)unbox_ptr((Value)obj_tagged);
+    if (!obj) return -1;
+    for (; slot < obj->capacity; slot++) {
+        Entry* e = &obj->entries[slot];
+        if (e->is_occupied == 1) {
+            *key = e->key;
+            *value = (void*)e->value;
+            return slot;
+        }
+    }
+    return -1;
 }
@@ -0,0 +1,78 @@
+/* Aria_lang/src/runtime/profile.c */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/*
+ * Profile Collection
+ * ------------------
+ * Binaries built with --profile-generate register one block of 64-bit
+ * counters plus a descriptor naming each counter (one key per line, see
+ * backend/pgo.h). At exit every counter is written as "key count" to the
+ * file named by ARIA_PROFILE, or to "<executable>.profile" next to the
+ * binary. Each run replaces the previous profile.
+ *
+ * Counters are bumped without synchronization, so threaded programs get
+ * approximate counts, which is all the compiler needs.
+ */
+
+#define MAX_PROFILE_UNITS 64
+
+typedef struct {
+    uint64_t* counters;
+    const char* descriptor;
+    long long count;
+} ProfileUnit;
+
+static ProfileUnit units[MAX_PROFILE_UNITS];
+static int unit_count = 0;
+
+static void profile_path(char* out, size_t size) {
+    const char* env = getenv("ARIA_PROFILE");
+    if (env && *env) {
+        snprintf(out, size, "%s", env);
+        return;
+    }
+    char exe[4096];
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (n <= 0) {
+        snprintf(out, size, "aria.profile");
+        return;
+    }
+    exe[n] = '\0';
+    snprintf(out, size, "%s.profile", exe);
+}
+
+static void write_profile(void) {
+    char path[4200];
+    profile_path(path, sizeof(path));
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "[Aria] Could not write profile %s\n", path);
+        return;
+    }
+    for (int u = 0; u < unit_count; u++) {
+        const char* key = units[u].descriptor;
+        for (long long i = 0; i < units[u].count && *key; i++) {
+            const char* eol = strchr(key, '\n');
+            int len = eol ? (int)(eol - key) : (int)strlen(key);
+            fprintf(f, "%.*s %llu\n", len, key, (unsigned long long)units[u].counters[i]);
+            key += len + (eol ? 1 : 0);
+        }
+    }
+    fclose(f);
+}
+
+void aria_profile_register(uint64_t* counters, const char* descriptor, long long count) {
+    if (unit_count == MAX_PROFILE_UNITS) return;
+    if (unit_count == 0) atexit(write_profile);
+    units[unit_count].counters = counters;
+    units[unit_count].descriptor = descriptor;
+    units[unit_count].count = count;
+    unit_count++;
+}
@@ -11,9 +11,9 @@ typedef uint64_t Value;
 #define PTR_MASK 0x0000FFFFFFFFFFFFULL
 #define TAG_OBJECT 0xFFF8000000000006ULL // Match object tag
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
 
 typedef struct {
     int width;
@@ -13,7 +13,7 @@ typedef uint64_t Value;
 #define TAG_OBJECT (0xFFF8000000000000ULL | 6ULL)
 
 static inline Value box_ptr(void* ptr) { return TAG_OBJECT | (uintptr_t)ptr; }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 
 // --- 3D Context ---
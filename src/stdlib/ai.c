@@ -28,18 +28,20 @@ extern void net_close(void* sock);
 // Aria uses NaN-boxing. We must carefully unbox values before processing.
 typedef uint64_t Value;
 #define TAG_OBJECT      (0xFFF8000000000000ULL | 6ULL)
-#define TAG_INTEGER     (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER     (0xFFF8000000000000ULL | (4ULL << 48))
 #define TAG_STRING      (0xFFF8000000000000ULL | 5ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
 static inline Value box_ptr(void* p) { return TAG_OBJECT | (uintptr_t)p; }
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
-static inline Value box_str(char* s) { return TAG_STRING | (uintptr_t)s; }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+// Copies into a length-prefixed string (string_utils.c)
+extern void* aria_str_box(const char* c_str);
+static inline Value box_str(const char* s) { return (Value)aria_str_box(s); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 // Helper to safely extract double from either float or int tagged values
 static inline double unbox_double(Value v) { 
-    if ((v & 0xFFF8000000000000ULL) == TAG_INTEGER) return (double)((int32_t)v);
+    if ((v & 0xFFFF000000000000ULL) == TAG_INTEGER) return (double)((int32_t)v);
     union { uint64_t u; double d; } u; u.u = v; return u.d; 
 }
 
@@ -519,7 +521,7 @@ HNSWNode* search_layer(HNSWNode* entry, Tensor* query, int layer) {
 void db_insert(void* db_t, void* vec_t, void* payload_t) {
     VectorDB* db = unbox_ptr((Value)db_t);
     Tensor* vec = unbox_ptr((Value)vec_t);
-    char* payload = (char*)((Value)payload_t & PTR_MASK);
+    char* payload = (char*)((Value)payload_t & PTR_MASK & ~7ULL);
     
     HNSWNode* node = aria_alloc(sizeof(HNSWNode));
     node->id = db->count;
@@ -584,13 +586,11 @@ void agent_handler(void* arg) {
     void* req_val = net_read(box_int(ctx->fd));
     if (req_val) {
         // High-level "Process" simulation
-        char* req_s = (char*)((Value)req_val & PTR_MASK);
+        char* req_s = (char*)((Value)req_val & PTR_MASK & ~7ULL);
         char buf[256];
         snprintf(buf, 256, "AI_ACK: %lu bytes", strlen(req_s));
         
-        char* r = aria_alloc(strlen(buf)+1);
-        strcpy(r, buf);
-        net_write(box_int(ctx->fd), box_str(r));
+        net_write(box_int(ctx->fd), box_str(buf));
     }
     net_close(box_int(ctx->fd));
     free(ctx);
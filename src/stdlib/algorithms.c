@@ -8,11 +8,12 @@ typedef uint64_t Value;
 // Re-definition of tagging constants for isolation
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define TAG_BASE        (QNAN_MASK | 0x8000000000000000ULL)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_LIST        (TAG_BASE | 7ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+// Lists are 8-byte aligned and box_ptr ORs the type tag into the low bits
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 static inline double unbox_double(Value v) {
     union { uint64_t u; double d; } cast;
@@ -20,16 +21,21 @@ static inline double unbox_double(Value v) {
     return cast.d;
 }
 static inline int is_double(Value v) { return ((v & QNAN_MASK)!= QNAN_MASK); }
-static inline int is_int(Value v) { return ((v & TAG_BASE) == TAG_INTEGER); }
+static inline int is_int(Value v) { return ((v & 0xFFFF000000000000ULL) == TAG_INTEGER); }
 
-// Must match structure in dataStructures.c
+// Must match the leading fields of the structure in dataStructures.c
 typedef struct {
-    Value* items; 
+    Value* items;
     int capacity;
     int count;
-    void* lock; 
 } AriaList;
 
+// Int lists pack their items as int32_t behind this tag (dataStructures.c)
+#define INTS_TAG        0xFFFF000000000000ULL
+static inline int32_t* packed_ints(AriaList* list) {
+    return ((uint64_t)list->items & INTS_TAG) ? (int32_t*)((uint64_t)list->items & PTR_MASK) : NULL;
+}
+
 static int compare_values(Value a, Value b) {
     double va = is_int(a)? (double)unbox_int(a) : (is_double(a)? unbox_double(a) : 0.0);
     double vb = is_int(b)? (double)unbox_int(b) : (is_double(b)? unbox_double(b) : 0.0);
@@ -64,11 +70,18 @@ static void quick_sort(Value* arr, int low, int high) {
     }
 }
 
+static int compare_ints(const void* a, const void* b) {
+    int32_t x = *(const int32_t*)a, y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
 // API: algo_sort(list)
 void* algo_sort(void* list_tagged) {
     AriaList* list = (AriaList*)unbox_ptr((uint64_t)list_tagged);
     if (list && list->count > 1) {
-        quick_sort(list->items, 0, list->count - 1);
+        int32_t* ints = packed_ints(list);
+        if (ints) qsort(ints, (size_t)list->count, sizeof(int32_t), compare_ints);
+        else quick_sort(list->items, 0, list->count - 1);
     }
     return list_tagged;
 }
@@ -80,11 +93,13 @@ void* algo_binary_search(void* list_tagged, void* target_tagged) {
     
     if (!list) return (void*)(TAG_INTEGER | (uint32_t)-1);
     
+    int32_t* ints = packed_ints(list);
     int l = 0;
     int r = list->count - 1;
     while (l <= r) {
         int m = l + (r - l) / 2;
-        int cmp = compare_values(list->items[m], target);
+        Value item = ints ? (TAG_INTEGER | (uint32_t)ints[m]) : list->items[m];
+        int cmp = compare_values(item, target);
         if (cmp == 0) return (void*)(TAG_INTEGER | (uint32_t)m);
         if (cmp < 0) l = m + 1;
         else r = m - 1;
@@ -6,15 +6,19 @@
 
 extern void* aria_alloc(size_t size);
 
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+extern void* aria_str_box(const char* c_str);
+
 typedef uint64_t Value;
-#define TAG_INTEGER     (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER     (0xFFF8000000000000ULL | (4ULL << 48))
 #define TAG_STRING      (0xFFF8000000000000ULL | 5ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
 
 static const char DIGITS = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
@@ -25,14 +29,14 @@ void* base_to_str(void* num_tagged, void* base_tagged) {
     
     if (base < 2 |
 
-| base > 36) return (void*)box_ptr("", TAG_STRING);
+| base > 36) return aria_str_box("");
     
     char buf;
     int i = 0;
     uint32_t n = (num < 0)? -num : num;
     
     if (n == 0) {
-        char* r = aria_alloc(2);
+        char* r = aria_str_alloc(1);
         r = '0'; r[1] = 0;
         return (void*)box_ptr(r, TAG_STRING);
     }
@@ -45,7 +49,7 @@ void* base_to_str(void* num_tagged, void* base_tagged) {
     buf[i] = '\0';
     
     // Reverse
-    char* res = aria_alloc(i + 1);
+    char* res = aria_str_alloc(i);
     for(int j=0; j<i; j++) res[j] = buf[i-j-1];
     res[i] = 0;
     return (void*)box_ptr(res, TAG_STRING);
@@ -5,7 +5,7 @@
 typedef uint64_t Value;
 #define PTR_MASK 0x0000FFFFFFFFFFFFULL
 
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 
 // We treat 'ptr' as a tagged pointer to a heap location.
 // We treat 'val' as a tagged value to store/add.
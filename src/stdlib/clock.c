@@ -7,7 +7,7 @@ typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
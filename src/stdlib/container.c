@@ -14,9 +14,9 @@
 extern void* aria_alloc(size_t size);
 
 typedef uint64_t Value;
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
-static inline char* unbox_str(Value v) { return (char*)(v & 0x0000FFFFFFFFFFFFULL); }
+static inline char* unbox_str(Value v) { return (char*)(v & 0x0000FFFFFFFFFFFFULL & ~7ULL); }
 
 // Stack for the container child process
 static char child_stack[1048576];
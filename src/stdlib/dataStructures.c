@@ -2,8 +2,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <stdint.h>
-#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
 
 extern void* aria_alloc(size_t size);
 
@@ -11,43 +13,177 @@ typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
+#define TAG_NULL        (TAG_BASE | 1ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_LIST        (TAG_BASE | 7ULL) 
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
+#define IS_DOUBLE(v)    (((v) & QNAN_MASK) != QNAN_MASK)
 
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
+static inline Value box_double(double d) {
+    union { double d; uint64_t u; } cast = { d };
+    if ((cast.u & QNAN_MASK) == QNAN_MASK) return QNAN_MASK;
+    return cast.u;
+}
+static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
+static inline double unbox_double(Value v) { union { uint64_t u; double d; } cast = { v }; return cast.d; }
+static inline int is_int(Value v) { return (v & 0xFFFF000000000000ULL) == TAG_INTEGER; }
+// Lists are 8-byte aligned and box_ptr ORs the type tag into the low bits
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
+
+/*
+ * Lists keep one of three item layouts, chosen by what has been stored:
+ *   LIST_INTS     every item an int, packed as int32_t. The items pointer
+ *                 carries INTS_TAG in its top bits, which the collector
+ *                 strips like a Value tag (runtime/gc.c).
+ *   LIST_DOUBLES  every item a float. The array holds the Values, which
+ *                 for floats are the doubles themselves.
+ *   LIST_VALUES   anything else, as Values.
+ * A new list is LIST_EMPTY until its first push picks the layout. Storing
+ * an item of another type turns the list into LIST_VALUES for good: an int
+ * array is widened into a new Value array, a float array is copied if an
+ * existing item is overwritten and kept otherwise.
+ *
+ * Reads take no lock. A push that outgrows or widens 'items' makes a new
+ * array and publishes it before the count that needs it, so a reader that
+ * loads count and then items always has a long enough array; the INTS_TAG
+ * on the pointer it loaded tells it the array's layout. A new kind is
+ * published before the array it belongs to, so a reader that loads kind
+ * after items never pairs an array with an older kind. The old array is
+ * left to the collector, which stops threads only at safepoints and scans
+ * their stacks: it is freed once no reader still holds it. Writers (push,
+ * set) take the one-byte 'writer' lock.
+ */
+enum { LIST_EMPTY, LIST_INTS, LIST_DOUBLES, LIST_VALUES };
+#define INTS_TAG        0xFFFF000000000000ULL
 
 typedef struct {
-    Value* items; 
+    _Atomic(Value*) items;
     int capacity;
-    int count;
-    pthread_rwlock_t lock;
+    _Atomic int count;
+    atomic_flag writer;
+    _Atomic int kind;
 } AriaList;
 
+static inline int is_ints(Value* items) { return ((uintptr_t)items & INTS_TAG) != 0; }
+static inline int32_t* ints_of(Value* items) { return (int32_t*)((uintptr_t)items & PTR_MASK); }
+static inline Value* tag_ints(void* ints) { return (Value*)(INTS_TAG | (uintptr_t)ints); }
+
+static inline Value item_at(Value* items, int index) {
+    return is_ints(items) ? box_int(ints_of(items)[index]) : items[index];
+}
+
+static inline int kind_of(Value v) {
+    if (is_int(v)) return LIST_INTS;
+    return IS_DOUBLE(v) ? LIST_DOUBLES : LIST_VALUES;
+}
+
+static inline void writer_lock(AriaList* list) {
+    while (atomic_flag_test_and_set_explicit(&list->writer, memory_order_acquire)) sched_yield();
+}
+
+static inline void writer_unlock(AriaList* list) {
+    atomic_flag_clear_explicit(&list->writer, memory_order_release);
+}
+
 void* list_new() {
     AriaList* list = (AriaList*)aria_alloc(sizeof(AriaList));
     list->capacity = 8;
-    list->count = 0;
-    list->items = (Value*)aria_alloc(sizeof(Value) * list->capacity);
-    pthread_rwlock_init(&list->lock, NULL);
+    atomic_init(&list->count, 0);
+    atomic_init(&list->kind, LIST_EMPTY);
+    atomic_init(&list->items, (Value*)aria_alloc(sizeof(Value) * list->capacity));
+    return (void*)box_ptr(list, TAG_LIST);
+}
+
+// List with room for 'capacity' items before it first grows
+void* list_new_sized(long long capacity) {
+    AriaList* list = (AriaList*)aria_alloc(sizeof(AriaList));
+    list->capacity = capacity > 8 ? (int)capacity : 8;
+    atomic_init(&list->count, 0);
+    atomic_init(&list->kind, LIST_EMPTY);
+    atomic_init(&list->items, (Value*)aria_alloc(sizeof(Value) * list->capacity));
+    return (void*)box_ptr(list, TAG_LIST);
+}
+
+/*
+ * Frame list: escape analysis proved the list dies with the calling function,
+ * so the compiler reserved LIST_FRAME_HEADER bytes plus 'capacity' items in
+ * its stack frame (backend/escape.h). Pushing past capacity moves the items
+ * to the heap like any other list.
+ */
+#define LIST_FRAME_HEADER 80
+typedef char list_frame_header_fits[sizeof(AriaList) <= LIST_FRAME_HEADER ? 1 : -1];
+
+void* list_new_at(void* mem, long long capacity) {
+    AriaList* list = (AriaList*)mem;
+    list->capacity = (int)capacity;
+    atomic_init(&list->count, 0);
+    atomic_init(&list->kind, LIST_EMPTY);
+    atomic_init(&list->items, (Value*)((char*)mem + LIST_FRAME_HEADER));
+    atomic_flag_clear_explicit(&list->writer, memory_order_relaxed);
     return (void*)box_ptr(list, TAG_LIST);
 }
 
+/*
+ * Untagged list for compiled for-each loops, which read 'items' and 'count'
+ * directly (offsets 0 and 12) instead of calling list_get per element; they
+ * fall back to list_get when 'items' carries INTS_TAG. A null list iterates
+ * as empty.
+ */
+typedef char list_items_at_0[offsetof(AriaList, items) == 0 ? 1 : -1];
+typedef char list_count_at_12[offsetof(AriaList, count) == 12 ? 1 : -1];
+
+void* list_header(void* list_tagged) {
+    static AriaList empty;
+    AriaList* list = (AriaList*)unbox_ptr((Value)list_tagged);
+    return list ? (void*)list : (void*)&empty;
+}
+
+// Writer lock held: copies the first 'count' items into a new Value array
+// and makes it the list's, as LIST_VALUES
+static Value* to_values(AriaList* list, int count, Value* items) {
+    Value* values = (Value*)aria_alloc(sizeof(Value) * list->capacity);
+    for (int i = 0; i < count; i++) values[i] = item_at(items, i);
+    atomic_store_explicit(&list->kind, LIST_VALUES, memory_order_release);
+    atomic_store_explicit(&list->items, values, memory_order_release);
+    return values;
+}
+
 void list_push(void* list_tagged, void* item_tagged) {
     AriaList* list = (AriaList*)unbox_ptr((Value)list_tagged);
     Value item = (Value)item_tagged;
 
     if (!list) return;
-    pthread_rwlock_wrlock(&list->lock);
-    if (list->count >= list->capacity) {
+    writer_lock(list);
+    int count = atomic_load_explicit(&list->count, memory_order_relaxed);
+    int kind = atomic_load_explicit(&list->kind, memory_order_relaxed);
+    Value* items = atomic_load_explicit(&list->items, memory_order_relaxed);
+    int item_kind = kind_of(item);
+    if (kind == LIST_EMPTY) {
+        // Nothing stored yet: the array takes the first item's layout
+        if (item_kind == LIST_INTS) {
+            items = tag_ints(items);
+            atomic_store_explicit(&list->items, items, memory_order_release);
+        }
+        atomic_store_explicit(&list->kind, item_kind, memory_order_release);
+    } else if (kind != item_kind && kind != LIST_VALUES) {
+        if (kind == LIST_INTS) items = to_values(list, count, items);
+        else atomic_store_explicit(&list->kind, LIST_VALUES, memory_order_release);
+    }
+    if (count >= list->capacity) {
         int new_cap = list->capacity * 2;
-        Value* new_items = (Value*)aria_alloc(sizeof(Value) * new_cap);
-        memcpy(new_items, list->items, sizeof(Value) * list->count);
-        list->items = new_items;
+        size_t width = is_ints(items) ? sizeof(int32_t) : sizeof(Value);
+        void* new_items = aria_alloc(width * new_cap);
+        memcpy(new_items, ints_of(items), width * count);
+        items = is_ints(items) ? tag_ints(new_items) : (Value*)new_items;
+        atomic_store_explicit(&list->items, items, memory_order_release);
         list->capacity = new_cap;
     }
-    list->items[list->count++] = item;
-    pthread_rwlock_unlock(&list->lock);
+    if (is_ints(items)) ints_of(items)[count] = unbox_int(item);
+    else items[count] = item;
+    atomic_store_explicit(&list->count, count + 1, memory_order_release);
+    writer_unlock(list);
 }
 
 // Correctly accepts Tagged Integer
@@ -56,15 +192,11 @@ void* list_get(void* list_tagged, void* index_tagged) {
     int index = (int)((Value)index_tagged & 0xFFFFFFFF);
 
     if (!list) return (void*)0;
-    pthread_rwlock_rdlock(&list->lock);
-    if (index < 0 || index >= list->count) {
-        pthread_rwlock_unlock(&list->lock);
+    if (index < 0 || index >= atomic_load_explicit(&list->count, memory_order_acquire)) {
         fprintf(stderr, "Runtime Error: Index OOB\n");
         exit(1);
     }
-    Value val = list->items[index];
-    pthread_rwlock_unlock(&list->lock);
-    return (void*)val;
+    return (void*)item_at(atomic_load_explicit(&list->items, memory_order_acquire), index);
 }
 
 // Returns the assigned value to satisfy Codegen requirements
@@ -74,13 +206,225 @@ void* list_set(void* list_tagged, void* index_tagged, void* val_tagged) {
     Value val = (Value)val_tagged;
 
     if (!list) return (void*)0;
-    pthread_rwlock_wrlock(&list->lock);
-    if (index < 0 || index >= list->count) {
-        pthread_rwlock_unlock(&list->lock);
+    writer_lock(list);
+    int count = atomic_load_explicit(&list->count, memory_order_relaxed);
+    if (index < 0 || index >= count) {
+        writer_unlock(list);
         fprintf(stderr, "Runtime Error: Index OOB\n");
         exit(1);
     }
-    list->items[index] = val;
-    pthread_rwlock_unlock(&list->lock);
+    int kind = atomic_load_explicit(&list->kind, memory_order_relaxed);
+    Value* items = atomic_load_explicit(&list->items, memory_order_relaxed);
+    // A float array that readers may hold is never given a non-float
+    if (kind != LIST_VALUES && kind != kind_of(val)) items = to_values(list, count, items);
+    if (is_ints(items)) ints_of(items)[index] = unbox_int(val);
+    else items[index] = val;
+    writer_unlock(list);
     return val_tagged; // Return the value for chaining
 }
+
+/*
+ * Numeric Kernels
+ * list_sum, list_min, list_max, list_dot, list_map_add and list_map_mul run
+ * the vector kernels of list_kernels.c straight over int and float arrays,
+ * and a loop over the Values otherwise. Items that are not numbers are
+ * skipped (the maps copy them unchanged). Int results that do not fit in
+ * 32 bits come back as floats; the maps wrap ints at 32 bits, as + and *
+ * do, and return a new list. list_map takes any one-argument function
+ * instead, and calls it per item.
+ */
+extern int64_t aria_list_sum_ints(const int32_t* a, size_t n);
+extern double aria_list_sum_doubles(const double* a, size_t n);
+extern int64_t aria_list_dot_ints(const int32_t* a, const int32_t* b, size_t n);
+extern double aria_list_dot_doubles(const double* a, const double* b, size_t n);
+extern void aria_list_range_ints(const int32_t* a, size_t n, int32_t* min, int32_t* max);
+extern void aria_list_range_doubles(const double* a, size_t n, double* min, double* max);
+extern void aria_list_map_ints(int32_t* out, const int32_t* a, size_t n, int32_t x, int mul);
+extern int aria_list_map_doubles(double* out, const double* a, size_t n, double x, int mul);
+extern int aria_list_map_ints_to_doubles(double* out, const int32_t* a, size_t n, double x, int mul);
+
+// Count, then items, then kind (see AriaList); the layout of the array
+// read is LIST_INTS, LIST_DOUBLES or LIST_VALUES
+static int list_view(void* list_tagged, int* count, Value** items) {
+    AriaList* list = (AriaList*)list_header(list_tagged);
+    *count = atomic_load_explicit(&list->count, memory_order_acquire);
+    *items = atomic_load_explicit(&list->items, memory_order_acquire);
+    int kind = atomic_load_explicit(&list->kind, memory_order_acquire);
+    if (is_ints(*items)) return LIST_INTS;
+    return kind == LIST_DOUBLES ? LIST_DOUBLES : LIST_VALUES;
+}
+
+static inline int is_number(Value v) { return is_int(v) || IS_DOUBLE(v); }
+static inline double number_of(Value v) { return is_int(v) ? (double)unbox_int(v) : unbox_double(v); }
+
+static Value box_total(int64_t n) {
+    return n == (int32_t)n ? box_int((int32_t)n) : box_double((double)n);
+}
+
+void* list_sum(void* list_tagged) {
+    int count;
+    Value* items;
+    int kind = list_view(list_tagged, &count, &items);
+    if (kind == LIST_INTS) return (void*)box_total(aria_list_sum_ints(ints_of(items), count));
+    if (kind == LIST_DOUBLES) return (void*)box_double(aria_list_sum_doubles((double*)items, count));
+
+    int64_t int_sum = 0;
+    double float_sum = 0;
+    int all_ints = 1;
+    for (int i = 0; i < count; i++) {
+        Value v = items[i];
+        if (is_int(v)) int_sum += unbox_int(v);
+        else if (IS_DOUBLE(v)) { float_sum += unbox_double(v); all_ints = 0; }
+    }
+    return (void*)(all_ints ? box_total(int_sum) : box_double((double)int_sum + float_sum));
+}
+
+// Smallest or largest number; null when there is none
+static void* list_extreme(void* list_tagged, int largest) {
+    int count;
+    Value* items;
+    int kind = list_view(list_tagged, &count, &items);
+    if (count == 0) return (void*)TAG_NULL;
+    if (kind == LIST_INTS) {
+        int32_t min, max;
+        aria_list_range_ints(ints_of(items), count, &min, &max);
+        return (void*)box_int(largest ? max : min);
+    }
+    if (kind == LIST_DOUBLES) {
+        double min, max;
+        aria_list_range_doubles((double*)items, count, &min, &max);
+        return (void*)box_double(largest ? max : min);
+    }
+
+    Value best = TAG_NULL;
+    double best_number = 0;
+    for (int i = 0; i < count; i++) {
+        Value v = items[i];
+        if (!is_number(v)) continue;
+        double n = number_of(v);
+        if (best == TAG_NULL || (largest ? n > best_number : n < best_number)) {
+            best = v;
+            best_number = n;
+        }
+    }
+    return (void*)best;
+}
+
+void* list_min(void* list_tagged) { return list_extreme(list_tagged, 0); }
+void* list_max(void* list_tagged) { return list_extreme(list_tagged, 1); }
+
+void* list_dot(void* a_tagged, void* b_tagged) {
+    int count, b_count;
+    Value *a, *b;
+    int a_kind = list_view(a_tagged, &count, &a);
+    int b_kind = list_view(b_tagged, &b_count, &b);
+    if (count != b_count) {
+        fprintf(stderr, "Runtime Error: list_dot of lists of different lengths\n");
+        exit(1);
+    }
+    if (a_kind == LIST_INTS && b_kind == LIST_INTS) {
+        return (void*)box_total(aria_list_dot_ints(ints_of(a), ints_of(b), count));
+    }
+    if (a_kind == LIST_DOUBLES && b_kind == LIST_DOUBLES) {
+        return (void*)box_double(aria_list_dot_doubles((double*)a, (double*)b, count));
+    }
+
+    int64_t int_sum = 0;
+    double float_sum = 0;
+    int all_ints = 1;
+    for (int i = 0; i < count; i++) {
+        Value x = item_at(a, i), y = item_at(b, i);
+        if (is_int(x) && is_int(y)) int_sum += (int64_t)unbox_int(x) * unbox_int(y);
+        else if (is_number(x) && is_number(y)) { float_sum += number_of(x) * number_of(y); all_ints = 0; }
+    }
+    return (void*)(all_ints ? box_total(int_sum) : box_double((double)int_sum + float_sum));
+}
+
+// New list of 'count' items in the given layout, for a kernel to fill
+static AriaList* list_packed(int kind, int count, void** array) {
+    AriaList* list = (AriaList*)aria_alloc(sizeof(AriaList));
+    list->capacity = count > 8 ? count : 8;
+    *array = aria_alloc((kind == LIST_INTS ? sizeof(int32_t) : sizeof(Value)) * list->capacity);
+    atomic_init(&list->count, count);
+    atomic_init(&list->kind, kind);
+    atomic_init(&list->items, kind == LIST_INTS ? tag_ints(*array) : (Value*)*array);
+    return list;
+}
+
+// Float results are Values already, except NaN, which boxes to a tag
+static void* finish_doubles(AriaList* list, double* out, int count, int nan) {
+    if (nan) {
+        for (int i = 0; i < count; i++) ((Value*)out)[i] = box_double(out[i]);
+        atomic_store_explicit(&list->kind, LIST_VALUES, memory_order_relaxed);
+    }
+    return (void*)box_ptr(list, TAG_LIST);
+}
+
+static Value map_value(Value v, Value x, int mul) {
+    if (is_int(v) && is_int(x)) {
+        uint32_t a = (uint32_t)unbox_int(v), b = (uint32_t)unbox_int(x);
+        return box_int((int32_t)(mul ? a * b : a + b));
+    }
+    if (!is_number(v) || !is_number(x)) return v;
+    return box_double(mul ? number_of(v) * number_of(x) : number_of(v) + number_of(x));
+}
+
+static void* map_op(void* list_tagged, void* x_tagged, int mul) {
+    Value x = (Value)x_tagged;
+    int count;
+    Value* items;
+    int kind = list_view(list_tagged, &count, &items);
+    int x_kind = kind_of(x);
+    void* out;
+    if (kind == LIST_INTS && x_kind == LIST_INTS) {
+        AriaList* list = list_packed(LIST_INTS, count, &out);
+        aria_list_map_ints((int32_t*)out, ints_of(items), count, unbox_int(x), mul);
+        return (void*)box_ptr(list, TAG_LIST);
+    }
+    if (kind == LIST_INTS && x_kind == LIST_DOUBLES) {
+        AriaList* list = list_packed(LIST_DOUBLES, count, &out);
+        int nan = aria_list_map_ints_to_doubles((double*)out, ints_of(items), count, unbox_double(x), mul);
+        return finish_doubles(list, (double*)out, count, nan);
+    }
+    if (kind == LIST_DOUBLES && x_kind != LIST_VALUES) {
+        AriaList* list = list_packed(LIST_DOUBLES, count, &out);
+        int nan = aria_list_map_doubles((double*)out, (double*)items, count, number_of(x), mul);
+        return finish_doubles(list, (double*)out, count, nan);
+    }
+
+    void* result = list_new_sized(count);
+    for (int i = 0; i < count; i++) list_push(result, (void*)map_value(item_at(items, i), x, mul));
+    return result;
+}
+
+void* list_map_add(void* list_tagged, void* x_tagged) { return map_op(list_tagged, x_tagged, 0); }
+void* list_map_mul(void* list_tagged, void* x_tagged) { return map_op(list_tagged, x_tagged, 1); }
+
+/*
+ * Function values are code addresses, or closure records
+ * { code, count, captures... } tagged with CLOSURE_TAG, whose code takes the
+ * untagged record as its static chain (R10; see gen_dynamic_call in
+ * backend/codegen.c).
+ */
+#define CLOSURE_TAG     0xFFFF000000000000ULL
+typedef Value (*AriaFn1)(Value);
+
+static Value call_fn1(Value fn, Value arg) {
+    if ((fn & CLOSURE_TAG) == CLOSURE_TAG) {
+        Value* record = (Value*)(fn ^ CLOSURE_TAG);
+        AriaFn1 code = (AriaFn1)record[0];
+        return __builtin_call_with_static_chain(code(arg), record);
+    }
+    return ((AriaFn1)fn)(arg);
+}
+
+// New list of fn(item) for each item the list held on entry. Results are
+// pushed, so ints and floats come back packed like any list of them.
+void* list_map(void* list_tagged, void* fn_tagged) {
+    int count;
+    Value* items;
+    list_view(list_tagged, &count, &items);
+    void* result = list_new_sized(count);
+    for (int i = 0; i < count; i++) list_push(result, (void*)call_fn1((Value)fn_tagged, item_at(items, i)));
+    return result;
+}
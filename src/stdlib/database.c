@@ -7,6 +7,9 @@
 
 // Runtime Imports: We utilize the existing runtime's object system for our Keydir index.
 extern void* aria_alloc(size_t s);
+
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
 extern void* aria_alloc_object();
 extern void* aria_obj_set(void* o, char* k, void* v);
 extern void* aria_obj_get(void* o, char* k);
@@ -17,7 +20,7 @@ typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_STRING      (TAG_BASE | 5ULL)
 #define TAG_OBJECT      (TAG_BASE | 6ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
@@ -25,8 +28,8 @@ typedef uint64_t Value;
 // Helper macros for boxing/unboxing
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 
 // --- Database Structures ---
@@ -171,7 +174,7 @@ void* db_get(void* db_tagged, void* k_tagged) {
     // Check validity of the result (0/NULL indicates key not found)
     Value off_val = (Value)offset_boxed;
     // Aria uses tagged integers. If the tag isn't Integer, it's not a valid offset.
-    if ((off_val & TAG_BASE)!= TAG_INTEGER) return (void*)0;
+    if ((off_val & 0xFFFF000000000000ULL)!= TAG_INTEGER) return (void*)0;
 
     long offset = (long)unbox_int(off_val);
 
@@ -195,7 +198,7 @@ void* db_get(void* db_tagged, void* k_tagged) {
     fseek(db->file_handle, header.key_sz, SEEK_CUR);
 
     // Read the Value
-    char* val_buf = (char*)aria_alloc(header.val_sz + 1);
+    char* val_buf = aria_str_alloc(header.val_sz);
     if (fread(val_buf, 1, header.val_sz, db->file_handle)!= header.val_sz) {
         fseek(db->file_handle, write_pos, SEEK_SET); // Restore state
         return (void*)0; // Read failed
@@ -5,9 +5,17 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
+#include <limits.h>
+#include "number_text.h"
 
 extern void* aria_alloc(size_t size);
 
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+extern uint32_t aria_str_length(const char* data);
+extern uint32_t aria_str_hash(const char* data);
+extern int aria_str_same(const char* a, const char* b);
+
 typedef uint64_t Value;
 
 #define QNAN_MASK       0x7FF8000000000000ULL
@@ -17,13 +25,17 @@ typedef uint64_t Value;
 #define TAG_NULL        (TAG_BASE | 1ULL)
 #define TAG_FALSE       (TAG_BASE | 2ULL)
 #define TAG_TRUE        (TAG_BASE | 3ULL)
-#define TAG_INTEGER     (TAG_BASE | 4ULL) 
+// Integers keep their tag above the 48-bit payload, clear of the value in
+// the low 32 bits; pointers are 8-byte aligned and carry theirs in the low 3
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48)) 
 #define TAG_STRING      (TAG_BASE | 5ULL) 
 #define TAG_OBJECT      (TAG_BASE | 6ULL) 
 #define TAG_LIST        (TAG_BASE | 7ULL) 
 
 #define IS_DOUBLE(v)    (((v) & QNAN_MASK)!= QNAN_MASK)
 #define IS_TAGGED(v)    (((v) & TAG_BASE) == TAG_BASE)
+#define IS_INT(v)       (((v) & 0xFFFF000000000000ULL) == TAG_INTEGER)
+#define IS_STRING(v)    (((v) & 0xFFFF000000000007ULL) == TAG_STRING)
 
 #define VAL_NULL        TAG_NULL
 #define VAL_FALSE       TAG_FALSE
@@ -55,7 +67,7 @@ static inline int32_t unbox_int(Value v) {
 }
 
 static inline void* unbox_ptr(Value v) {
-    return (void*)(v & 0x0000FFFFFFFFFFFFULL);
+    return (void*)(v & 0x0000FFFFFFFFFFFFULL & ~7ULL);
 }
 
 // Constructors
@@ -64,6 +76,7 @@ void* dyn_new_float(long long bits) {
     union { long long i; double d; } u; u.i = bits;
     return (void*)box_double(u.d);
 }
+// 'val' is a literal the compiler emitted with its string header
 void* dyn_new_str(char* val) { return (void*)box_ptr(val, TAG_STRING); }
 void* dyn_new_bool(long long val) { return (void*)(val? VAL_TRUE : VAL_FALSE); }
 void* dyn_new_null() { return (void*)VAL_NULL; }
@@ -76,7 +89,7 @@ int dyn_get_type(void* handle) {
     if (v == VAL_TRUE || v == VAL_FALSE) return 4;
     uint64_t tag = v & 0xFFFF000000000000ULL;
     if (tag == TAG_INTEGER) return 2;
-    if (tag == TAG_STRING) return 3;
+    if (IS_STRING(v)) return 3;
     return -1;
 }
 
@@ -86,7 +99,7 @@ int64_t dyn_truthy(void* ptr) {
     if (v == VAL_FALSE || v == VAL_NULL) return 0;
     if (v == VAL_TRUE) return 1;
     if (IS_DOUBLE(v)) return unbox_double(v)!= 0.0;
-    if ((v & TAG_BASE) == TAG_INTEGER) return unbox_int(v)!= 0;
+    if (IS_INT(v)) return unbox_int(v)!= 0;
     return 1; // Objects/Strings are true
 }
 
@@ -95,8 +108,8 @@ void* dyn_add(void* a_ptr, void* b_ptr) {
     Value a = (Value)a_ptr;
     Value b = (Value)b_ptr;
     
-    bool a_int = ((a & TAG_BASE) == TAG_INTEGER);
-    bool b_int = ((b & TAG_BASE) == TAG_INTEGER);
+    bool a_int = IS_INT(a);
+    bool b_int = IS_INT(b);
     
     if (a_int && b_int) return (void*)box_int(unbox_int(a) + unbox_int(b));
     
@@ -105,13 +118,14 @@ void* dyn_add(void* a_ptr, void* b_ptr) {
     
     if (IS_DOUBLE(a) || IS_DOUBLE(b)) return (void*)box_double(da + db);
     
-    // String Concat
-    if ((a & TAG_BASE) == TAG_STRING && (b & TAG_BASE) == TAG_STRING) {
+    // String Concat (repeated `s = s + x` statements use aria_str_append instead)
+    if (IS_STRING(a) && IS_STRING(b)) {
         char* s1 = (char*)unbox_ptr(a);
         char* s2 = (char*)unbox_ptr(b);
-        size_t l1 = strlen(s1), l2 = strlen(s2);
-        char* r = aria_alloc(l1 + l2 + 1);
-        strcpy(r, s1); strcat(r, s2);
+        size_t l1 = aria_str_length(s1), l2 = aria_str_length(s2);
+        char* r = aria_str_alloc(l1 + l2);
+        memcpy(r, s1, l1);
+        memcpy(r + l1, s2, l2);
         return (void*)box_ptr(r, TAG_STRING);
     }
     return (void*)VAL_NULL;
@@ -121,7 +135,7 @@ void* dyn_sub(void* a_ptr, void* b_ptr) {
     Value a = (Value)a_ptr;
     Value b = (Value)b_ptr;
     
-    if (((a & TAG_BASE) == TAG_INTEGER) && ((b & TAG_BASE) == TAG_INTEGER)) 
+    if (IS_INT(a) && IS_INT(b)) 
         return (void*)box_int(unbox_int(a) - unbox_int(b));
         
     double da = IS_DOUBLE(a)? unbox_double(a) : unbox_int(a);
@@ -133,7 +147,7 @@ void* dyn_mul(void* a_ptr, void* b_ptr) {
     Value a = (Value)a_ptr;
     Value b = (Value)b_ptr;
     
-    if (((a & TAG_BASE) == TAG_INTEGER) && ((b & TAG_BASE) == TAG_INTEGER)) 
+    if (IS_INT(a) && IS_INT(b)) 
         return (void*)box_int(unbox_int(a) * unbox_int(b));
         
     double da = IS_DOUBLE(a)? unbox_double(a) : unbox_int(a);
@@ -155,7 +169,7 @@ void* dyn_mod(void* a_ptr, void* b_ptr) {
     Value b = (Value)b_ptr;
     
     // Fast path for integers
-    if (((a & TAG_BASE) == TAG_INTEGER) && ((b & TAG_BASE) == TAG_INTEGER)) {
+    if (IS_INT(a) && IS_INT(b)) {
         int32_t va = unbox_int(a);
         int32_t vb = unbox_int(b);
         if (vb == 0) {
@@ -175,7 +189,7 @@ void* dyn_mod(void* a_ptr, void* b_ptr) {
 void* dyn_neg(void* a_ptr) {
     Value a = (Value)a_ptr;
     
-    if ((a & TAG_BASE) == TAG_INTEGER) {
+    if (IS_INT(a)) {
         return (void*)box_int(-unbox_int(a));
     }
     
@@ -192,9 +206,15 @@ void* dyn_not(void* a_ptr) {
     return (void*)(truth? VAL_FALSE : VAL_TRUE);
 }
 
-// Comparisons
-void* dyn_eq(void* a, void* b) { return (void*)(a == b? VAL_TRUE : VAL_FALSE); }
-void* dyn_neq(void* a, void* b) { return (void*)(a!= b? VAL_TRUE : VAL_FALSE); }
+// Comparisons: strings by content, everything else by identity
+static bool dyn_same(Value a, Value b) {
+    if (a == b) return true;
+    if (!IS_STRING(a) || !IS_STRING(b)) return false;
+    return aria_str_same((const char*)unbox_ptr(a), (const char*)unbox_ptr(b));
+}
+
+void* dyn_eq(void* a, void* b) { return (void*)(dyn_same((Value)a, (Value)b)? VAL_TRUE : VAL_FALSE); }
+void* dyn_neq(void* a, void* b) { return (void*)(dyn_same((Value)a, (Value)b)? VAL_FALSE : VAL_TRUE); }
 
 void* dyn_lt(void* a_ptr, void* b_ptr) {
     Value a = (Value)a_ptr, b = (Value)b_ptr;
@@ -203,6 +223,48 @@ void* dyn_lt(void* a_ptr, void* b_ptr) {
     return (void*)(da < db? VAL_TRUE : VAL_FALSE);
 }
 
+// Smallest integer i with !(i < v), for counted loops that keep their counter unboxed
+long long dyn_loop_bound(void* v_ptr) {
+    Value v = (Value)v_ptr;
+    if (!IS_DOUBLE(v)) return unbox_int(v);
+    double d = unbox_double(v);
+    if (d != d) return LLONG_MIN;
+    if (d >= 9.2e18) return LLONG_MAX;
+    if (d <= -9.2e18) return LLONG_MIN;
+    return (long long)ceil(d);
+}
+
+/*
+ * Match dispatch (backend/match.h). Integer cases switch on dyn_match_int,
+ * which yields LLONG_MIN for anything that is not a boxed integer. String
+ * cases switch on the slot dyn_match_str computes from the string's cached
+ * hash and the compiler's seed, or -1 for non-strings, then confirm the
+ * candidate with dyn_str_equals. The mix must stay identical to match_hash
+ * in the compiler.
+ */
+long long dyn_match_int(void* v_ptr) {
+    Value v = (Value)v_ptr;
+    if (!IS_INT(v)) return LLONG_MIN;
+    return unbox_int(v);
+}
+
+long long dyn_match_str(void* v_ptr, long long seed, long long mask) {
+    Value v = (Value)v_ptr;
+    if (!IS_STRING(v)) return -1;
+    uint64_t h = aria_str_hash((const char*)unbox_ptr(v)) ^ ((uint64_t)seed * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (long long)(h & (uint64_t)mask);
+}
+
+// 'literal' carries its string header, so this is usually a length compare
+long long dyn_str_equals(void* v_ptr, const char* literal) {
+    Value v = (Value)v_ptr;
+    if (!IS_STRING(v)) return 0;
+    return aria_str_same((const char*)unbox_ptr(v), literal);
+}
+
 void* dyn_gt(void* a_ptr, void* b_ptr) {
     Value a = (Value)a_ptr, b = (Value)b_ptr;
     double da = IS_DOUBLE(a)? unbox_double(a) : unbox_int(a);
@@ -212,11 +274,15 @@ void* dyn_gt(void* a_ptr, void* b_ptr) {
 
 void dyn_print(void* ptr) {
     Value v = (Value)ptr;
-    if (IS_DOUBLE(v)) printf("%f", unbox_double(v));
+    char num[FLOAT_TEXT_MAX];
+    if (IS_DOUBLE(v)) fwrite(num, 1, aria_float_text(num, unbox_double(v)), stdout);
     else if (v == VAL_TRUE) printf("true");
     else if (v == VAL_FALSE) printf("false");
     else if (v == VAL_NULL) printf("null");
-    else if ((v & TAG_BASE) == TAG_INTEGER) printf("%d", unbox_int(v));
-    else if ((v & TAG_BASE) == TAG_STRING) printf("%s", (char*)unbox_ptr(v));
+    else if (IS_INT(v)) fwrite(num, 1, aria_int_text(num, unbox_int(v)), stdout);
+    else if (IS_STRING(v)) {
+        char* s = (char*)unbox_ptr(v);
+        if (s) fwrite(s, 1, aria_str_length(s), stdout);
+    }
     else printf("<object>");
 }
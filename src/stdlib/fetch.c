@@ -10,10 +10,13 @@
 
 extern void* aria_alloc(size_t size);
 
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+
 typedef uint64_t Value;
 #define TAG_STRING 0xFFF8000000000005ULL
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
-static inline char* unbox_str(Value v) { return (char*)(v & 0x0000FFFFFFFFFFFFULL); }
+static inline char* unbox_str(Value v) { return (char*)(v & 0x0000FFFFFFFFFFFFULL & ~7ULL); }
 
 static void parse_url(char* url, char* host, int* port, char* path) {
     *port = 80;
@@ -76,10 +79,10 @@ void* fetch_get(void* url_tagged) {
     if (body) {
         body += 4;
         size_t body_len = strlen(body);
-        result = (char*)aria_alloc(body_len + 1);
+        result = aria_str_alloc(body_len);
         memcpy(result, body, body_len + 1);
     } else {
-        result = (char*)aria_alloc(len + 1);
+        result = aria_str_alloc(len);
         memcpy(result, buf, len + 1);
     }
     free(buf);
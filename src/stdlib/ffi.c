@@ -9,16 +9,16 @@ extern void* aria_alloc(size_t size);
 typedef uint64_t Value;
 #define QNAN_MASK 0x7FF8000000000000ULL
 #define TAG_BASE (QNAN_MASK | 0x8000000000000000ULL)
-#define TAG_INTEGER (TAG_BASE | 4ULL)
+#define TAG_INTEGER (TAG_BASE | (4ULL << 48))
 #define TAG_OBJECT (TAG_BASE | 6ULL)
 #define PTR_MASK 0x0000FFFFFFFFFFFFULL
 
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline Value box_ptr(void* ptr) { return TAG_OBJECT | (uintptr_t)ptr; }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 static inline int64_t unbox_val(Value v) {
-    if ((v & TAG_BASE) == TAG_INTEGER) return (int32_t)(v & 0xFFFFFFFF);
+    if ((v & 0xFFFF000000000000ULL) == TAG_INTEGER) return (int32_t)(v & 0xFFFFFFFF);
     return (int64_t)(v & PTR_MASK); 
 }
 
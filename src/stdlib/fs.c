@@ -9,6 +9,10 @@
 #include <stdint.h>
 
 extern void* aria_alloc(size_t size);
+
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+extern void aria_str_seal(char* data, size_t len);
 extern void* list_new();
 extern void list_push(void* list, void* item);
 
@@ -17,13 +21,13 @@ typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_STRING      (TAG_BASE | 5ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 
 // Returns Tagged Integer (FD)
@@ -59,11 +63,11 @@ void* fs_read_all(void* path_tagged) {
     long length = ftell(f);
     fseek(f, 0, SEEK_SET);
     
-    char* buffer = (char*)aria_alloc(length + 1);
+    char* buffer = aria_str_alloc(length);
     if (!buffer) { fclose(f); return NULL; }
     
     size_t read_len = fread(buffer, 1, length, f);
-    buffer[read_len] = '\0';
+    aria_str_seal(buffer, read_len);
     fclose(f);
     return (void*)box_ptr(buffer, TAG_STRING);
 }
@@ -108,7 +112,7 @@ void* fs_list_dir(void* path_tagged) {
         if (strcmp(dir->d_name, ".") == 0 || strcmp(dir->d_name, "..") == 0) continue;
         
         size_t len = strlen(dir->d_name);
-        char* name_copy = (char*)aria_alloc(len + 1);
+        char* name_copy = aria_str_alloc(len);
         memcpy(name_copy, dir->d_name, len + 1);
         
         // Box string and push
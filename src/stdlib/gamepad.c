@@ -5,7 +5,7 @@
 #include <stdint.h>
 
 typedef uint64_t Value;
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 
 static int fd = -1;
@@ -20,11 +20,11 @@ extern WinContext* get_win_context();
 extern void* aria_alloc(size_t size);
 
 typedef uint64_t Value;
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 #define PTR_MASK    0x0000FFFFFFFFFFFFULL
 
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
 
 // --- Styling Constants ---
 #define COL_BG      0xEEEEEE
@@ -9,22 +9,37 @@
 #include <stdint.h>
 #include <errno.h>
 #include <pthread.h>
+#include "number_text.h"
 
 extern void* aria_alloc(size_t size);
+extern void* dyn_add(void* a, void* b);
+extern void* dyn_new_int(long long val);
+extern void* dyn_new_float(long long bits);
+
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+extern void aria_str_seal(char* data, size_t len);
+extern void* aria_str_box_n(const char* buf, size_t len);
+extern uint32_t aria_str_length(const char* data);
 
 // --- Tagging Helpers ---
 typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_STRING      (TAG_BASE | 5ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
+#define IS_TAGGED(v)    (((v) & TAG_BASE) == TAG_BASE)
+#define IS_INT(v)       (((v) & 0xFFFF000000000000ULL) == TAG_INTEGER)
+// Pointers are 8-byte aligned and carry their type in the low 3 bits
+#define IS_STRING(v)    (((v) & 0xFFFF000000000007ULL) == TAG_STRING)
 
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
 static inline double unbox_double(Value v) { union { uint64_t u; double d; } u; u.u = v; return u.d; }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
-static inline char* unbox_ptr(Value v) { return (char*)(v & PTR_MASK); }
+// A raw char* from C passes through untouched
+static inline char* unbox_ptr(Value v) { return (char*)(IS_TAGGED(v) ? v & PTR_MASK & ~7ULL : v); }
 
 // --- Thread Safe IO State ---
 #define BUFFER_SIZE 4096
@@ -105,8 +120,8 @@ static char* read_line_raw() {
     buffer[length] = '\0';
     if (c == '\n') read_char_buffered();
     
-    char* result = (char*)aria_alloc(length + 1);
-    memcpy(result, buffer, length + 1);
+    char* result = aria_str_alloc(length);
+    memcpy(result, buffer, length);
     free(buffer);
     pthread_mutex_unlock(&io_mutex);
     return result;
@@ -130,67 +145,303 @@ void* read_file(void* filename_tagged) {
     off_t size = lseek(fd, 0, SEEK_END);
     lseek(fd, 0, SEEK_SET);
     
-    char* content = (char*)aria_alloc(size + 1); 
+    char* content = aria_str_alloc(size); 
     ssize_t total = 0;
     while (total < size) {
         ssize_t r = read(fd, content + total, size - total);
         if (r <= 0) break;
         total += r;
     }
-    content[total] = '\0';
+    aria_str_seal(content, total);
     close(fd);
     return (void*)box_ptr(content, TAG_STRING);
 }
 
-// Output Helpers (Unlocked, caller holds mutex)
-void put_str_unlocked(const char* s) {
-    while (*s) {
-        if (out_buf_idx >= BUFFER_SIZE) flush_buffer();
-        out_buffer[out_buf_idx++] = *s++;
+// --- Number Text ---
+// Integers are written two digits at a time from a pair table. Floats keep
+// the "%.6f" text print has always produced, but finite values below 2^63
+// are rounded exactly (to nearest, ties to even, as printf does) in integer
+// arithmetic, and larger ones, all whole numbers, are expanded into base
+// 10^9 limbs; only inf and nan still go through snprintf. The parsers
+// return what strtod / strtoll would, taking a short path for plain
+// decimals. Buffer sizes are in number_text.h.
+typedef unsigned __int128 uint128;
+
+static const char DIGIT_PAIRS[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes u ending just before 'end'; returns where the digits start
+static char* put_u64(char* end, uint64_t u) {
+    while (u >= 100) {
+        const char* pair = DIGIT_PAIRS + (u % 100) * 2;
+        u /= 100;
+        end -= 2;
+        end[0] = pair[0];
+        end[1] = pair[1];
+    }
+    if (u >= 10) {
+        end -= 2;
+        end[0] = DIGIT_PAIRS[u * 2];
+        end[1] = DIGIT_PAIRS[u * 2 + 1];
+    } else {
+        *--end = (char)('0' + u);
     }
+    return end;
 }
 
-void put_int_unlocked(int64_t n) {
-    if (n == 0) { if(out_buf_idx>=BUFFER_SIZE) flush_buffer(); out_buffer[out_buf_idx++]='0'; return; }
-    if (n < 0) { if(out_buf_idx>=BUFFER_SIZE) flush_buffer(); out_buffer[out_buf_idx++]='-'; n=-n; }
-    char temp[32]; int i=0;
-    while(n>0) { temp[i++]=(n%10)+'0'; n/=10; }
-    while(i>0) { if(out_buf_idx>=BUFFER_SIZE) flush_buffer(); out_buffer[out_buf_idx++]=temp[--i]; }
+// Decimal text of n in out[0..20); returns its length
+int aria_int_text(char* out, int64_t n) {
+    char temp[24];
+    char* end = temp + sizeof(temp);
+    char* p = put_u64(end, n < 0 ? -(uint64_t)n : (uint64_t)n);
+    if (n < 0) *--p = '-';
+    memcpy(out, p, end - p);
+    return (int)(end - p);
 }
 
-void put_float_unlocked(double f) {
-    char temp[64]; int len = snprintf(temp, 64, "%.6f", f);
-    for(int i=0; i<len; i++) { if(out_buf_idx>=BUFFER_SIZE) flush_buffer(); out_buffer[out_buf_idx++]=temp[i]; }
+// Writes the digits of m * 2^e (e > 0), at most 309 of them, ending just
+// before 'end'; returns where they start
+static char* put_big(char* end, uint64_t m, int e) {
+    uint32_t limb[40];          // base 10^9, least significant first
+    int n = 0;
+    for (; m; m /= 1000000000) limb[n++] = (uint32_t)(m % 1000000000);
+    for (; e > 0; e -= 32) {
+        int s = e < 32 ? e : 32;
+        uint64_t carry = 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t x = ((uint64_t)limb[i] << s) + carry;
+            limb[i] = (uint32_t)(x % 1000000000);
+            carry = x / 1000000000;
+        }
+        for (; carry; carry /= 1000000000) limb[n++] = (uint32_t)(carry % 1000000000);
+    }
+    for (int i = 0; i < n - 1; i++) {
+        uint32_t u = limb[i];
+        for (int j = 0; j < 9; j++, u /= 10) *--end = (char)('0' + u % 10);
+    }
+    return put_u64(end, limb[n - 1]);
 }
 
-// FIX: Unbox arguments for printing
-void aria_vprintf(const char* format, va_list args) {
-    pthread_mutex_lock(&io_mutex);
-    for (const char* p = format; *p; p++) {
-        if (*p != '%') {
-            if (out_buf_idx >= BUFFER_SIZE) flush_buffer();
-            out_buffer[out_buf_idx++] = *p;
-            continue;
+// snprintf(out, FLOAT_TEXT_MAX, "%.6f", f); returns its length
+int aria_float_text(char* out, double f) {
+    union { double d; uint64_t u; } bits = { f };
+    int biased = (int)(bits.u >> 52) & 0x7FF;
+    uint64_t m = bits.u & ((1ULL << 52) - 1);
+    int e = biased ? biased - 1075 : -1074;
+    if (biased) m |= 1ULL << 52;
+    if (biased == 0x7FF) return snprintf(out, FLOAT_TEXT_MAX, "%.6f", f);
+    if (e > 10) {
+        char temp[FLOAT_TEXT_MAX];
+        char* end = temp + sizeof(temp);
+        char* p = end - 7;
+        memcpy(p, ".000000", 7);
+        p = put_big(p, m, e);
+        if (bits.u >> 63) *--p = '-';
+        memcpy(out, p, end - p);
+        return (int)(end - p);
+    }
+
+    // q = f * 10^6 rounded to an integer; m * 10^6 < 2^73
+    uint128 q;
+    if (e >= 0) {
+        q = (uint128)(m << e) * 1000000;
+    } else if (-e >= 75) {
+        q = 0;
+    } else {
+        uint128 scaled = (uint128)m * 1000000;
+        int k = -e;
+        uint128 rest = scaled & (((uint128)1 << k) - 1);
+        uint128 half = (uint128)1 << (k - 1);
+        q = scaled >> k;
+        if (rest > half || (rest == half && (q & 1))) q++;
+    }
+
+    char temp[40];
+    char* end = temp + sizeof(temp);
+    unsigned frac = (unsigned)(q % 1000000);
+    char* p = end - 6;
+    for (int i = 4; i >= 0; i -= 2) {
+        p[i] = DIGIT_PAIRS[(frac % 100) * 2];
+        p[i + 1] = DIGIT_PAIRS[(frac % 100) * 2 + 1];
+        frac /= 100;
+    }
+    *--p = '.';
+    p = put_u64(p, (uint64_t)(q / 1000000));
+    if (bits.u >> 63) *--p = '-';
+    memcpy(out, p, end - p);
+    return (int)(end - p);
+}
+
+static const double POW10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// strtod(s, end). A decimal with at most 19 significant digits whose value
+// is m * 10^e with m <= 2^53 and |e| <= 22 is one exact multiply or divide,
+// so it rounds exactly as strtod does; anything else (spaces, hex, inf, nan,
+// long mantissas, big exponents) is left to strtod.
+double aria_parse_double(const char* s, char** end) {
+    const char* p = s;
+    int negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) return strtod(s, end);
+
+    uint64_t m = 0;
+    int digits = 0, any = 0, e = 0;
+    for (; *p >= '0' && *p <= '9'; p++, any = 1) {
+        if (m || *p != '0') { m = m * 10 + (uint64_t)(*p - '0'); digits++; }
+        if (digits > 19) return strtod(s, end);
+    }
+    if (*p == '.') {
+        for (p++; *p >= '0' && *p <= '9'; p++, any = 1) {
+            if (m || *p != '0') { m = m * 10 + (uint64_t)(*p - '0'); digits++; }
+            if (digits > 19) return strtod(s, end);
+            e--;
         }
-        p++; 
-        Value v = va_arg(args, Value);
-        switch (*p) {
-            case 'd': 
-                if ((v & TAG_BASE) == TAG_INTEGER) put_int_unlocked(unbox_int(v));
-                else put_int_unlocked((int64_t)unbox_double(v)); 
-                break;
-            case 'f': 
-                if ((v & TAG_BASE) != TAG_INTEGER) put_float_unlocked(unbox_double(v));
-                else put_float_unlocked((double)unbox_int(v));
-                break;
-            case 's': {
-                char* s = unbox_ptr(v);
-                if (!s) s = "(null)";
-                put_str_unlocked(s);
-                break;
+    }
+    if (!any) return strtod(s, end);
+    if (*p == 'e' || *p == 'E') {
+        const char* q = p + 1;
+        int exp_negative = *q == '-';
+        if (*q == '-' || *q == '+') q++;
+        if (*q >= '0' && *q <= '9') {
+            int x = 0;
+            for (; *q >= '0' && *q <= '9'; q++) {
+                if (x > 1000) return strtod(s, end);
+                x = x * 10 + (*q - '0');
             }
+            e += exp_negative ? -x : x;
+            p = q;
+        }
+    }
+    if (m > (1ULL << 53) || e < -22 || e > 22) return strtod(s, end);
+
+    double d = (double)m;
+    d = e < 0 ? d / POW10[-e] : d * POW10[e];
+    if (end) *end = (char*)p;
+    return negative ? -d : d;
+}
+
+// strtoll(s, end, 10), with up to 18 digits read directly
+long long aria_parse_int(const char* s, char** end) {
+    const char* p = s;
+    int negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    const char* digits = p;
+    long long n = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        if (p - digits >= 18) return strtoll(s, end, 10);
+        n = n * 10 + (*p - '0');
+    }
+    if (p == digits) return strtoll(s, end, 10);
+    if (end) *end = (char*)p;
+    return negative ? -n : n;
+}
+
+// parse_int("42") -> 42 as strtoll reads it, truncated to an int; 0 when
+// the text does not start with a number
+void* parse_int(void* s_tagged) {
+    char* s = unbox_ptr((Value)s_tagged);
+    return dyn_new_int(s ? aria_parse_int(s, NULL) : 0);
+}
+
+// parse_float("2.5e3") -> 2500.0 as strtod reads it
+void* parse_float(void* s_tagged) {
+    char* s = unbox_ptr((Value)s_tagged);
+    union { double d; long long bits; } v = { s ? aria_parse_double(s, NULL) : 0.0 };
+    return dyn_new_float(v.bits);
+}
+
+// --- Format Sinks ---
+// Formatted text goes either to the shared stdout buffer (sink NULL, caller
+// holds io_mutex) or to a growable string that format() returns. The
+// string's buffer comes from aria_str_alloc, so finishing it only fills in
+// the header.
+typedef struct {
+    char* data;
+    int64_t len;
+    int64_t cap;
+} FmtBuf;
+
+static void sink_write(FmtBuf* b, const char* s, int64_t n) {
+    if (!b) {
+        while (n > 0) {
+            if (out_buf_idx >= BUFFER_SIZE) flush_buffer();
+            int64_t chunk = BUFFER_SIZE - out_buf_idx;
+            if (chunk > n) chunk = n;
+            memcpy(out_buffer + out_buf_idx, s, chunk);
+            out_buf_idx += chunk; s += chunk; n -= chunk;
+        }
+        return;
+    }
+    if (b->len + n + 1 > b->cap) {
+        int64_t cap = b->cap * 2;
+        if (cap < b->len + n + 1) cap = b->len + n + 1;
+        char* data = aria_str_alloc(cap - 1);
+        memcpy(data, b->data, b->len);
+        b->data = data;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+static void sink_int(FmtBuf* b, int64_t n) {
+    char temp[24];
+    sink_write(b, temp, aria_int_text(temp, n));
+}
+
+static void sink_float(FmtBuf* b, double f) {
+    char temp[FLOAT_TEXT_MAX];
+    sink_write(b, temp, aria_float_text(temp, f));
+}
+
+// One %d / %f / %s placeholder
+static void sink_value(FmtBuf* b, char spec, Value v) {
+    switch (spec) {
+        case 'd':
+            if (IS_INT(v)) sink_int(b, unbox_int(v));
+            else sink_int(b, (int64_t)unbox_double(v));
+            break;
+        case 'f':
+            if (!IS_INT(v)) sink_float(b, unbox_double(v));
+            else sink_float(b, (double)unbox_int(v));
+            break;
+        case 's': {
+            char* s = unbox_ptr(v);
+            if (!s) sink_write(b, "(null)", 6);
+            else sink_write(b, s, IS_STRING(v) ? aria_str_length(s) : strlen(s));
+            break;
         }
     }
+}
+
+static void sink_vformat(FmtBuf* b, const char* format, va_list args) {
+    for (const char* p = format; *p; p++) {
+        const char* run = p;
+        while (*p && *p != '%') p++;
+        sink_write(b, run, p - run);
+        if (!*p || !p[1]) break;
+        p++;
+        if (*p == '%') sink_write(b, "%", 1);
+        else sink_value(b, *p, va_arg(args, Value));
+    }
+}
+
+// Output Helpers (Unlocked, caller holds mutex)
+void put_str_unlocked(const char* s) { sink_write(NULL, s, strlen(s)); }
+void put_int_unlocked(int64_t n) { sink_int(NULL, n); }
+void put_float_unlocked(double f) { sink_float(NULL, f); }
+
+// The format may arrive tagged (from Aria) or raw (from C); masking handles both
+void aria_vprintf(const char* format, va_list args) {
+    pthread_mutex_lock(&io_mutex);
+    sink_vformat(NULL, unbox_ptr((Value)format), args);
     pthread_mutex_unlock(&io_mutex);
 }
 
@@ -205,17 +456,111 @@ void print(const char* format, ...) {
     pthread_mutex_lock(&io_mutex); flush_buffer(); pthread_mutex_unlock(&io_mutex);
 }
 
+static FmtBuf* fmt_buf_new(int64_t capacity) {
+    FmtBuf* b = (FmtBuf*)aria_alloc(sizeof(FmtBuf));
+    b->cap = capacity > 0 ? capacity : 16;
+    b->data = aria_str_alloc(b->cap - 1);
+    b->len = 0;
+    return b;
+}
+
+static void* fmt_buf_finish(FmtBuf* b) {
+    aria_str_seal(b->data, b->len);
+    return (void*)box_ptr(b->data, TAG_STRING);
+}
+
+// format("x = %d", x) -> Tagged String
+void* format(const char* fmt, ...) {
+    FmtBuf* b = fmt_buf_new(64);
+    va_list args; va_start(args, fmt); sink_vformat(b, unbox_ptr((Value)fmt), args); va_end(args);
+    return fmt_buf_finish(b);
+}
+
+/*
+ * Specialized Formatting
+ * The compiler lowers print/format calls with a literal format string into
+ * these: constant text is written with its length known, and each
+ * placeholder calls the append for its conversion, so nothing parses the
+ * format at run time. The sink is NULL for print (between aria_print_begin
+ * and aria_print_end) or the buffer from aria_fmt_new for format.
+ */
+void aria_print_begin(void) { pthread_mutex_lock(&io_mutex); }
+void aria_print_end(void) { flush_buffer(); pthread_mutex_unlock(&io_mutex); }
+
+void* aria_fmt_new(long long capacity) { return fmt_buf_new(capacity + 1); }
+void* aria_fmt_finish(void* sink) { return fmt_buf_finish((FmtBuf*)sink); }
+
+void aria_fmt_text(void* sink, const char* s, long long len) { sink_write((FmtBuf*)sink, s, len); }
+void aria_fmt_int(void* sink, void* v) { sink_value((FmtBuf*)sink, 'd', (Value)v); }
+void aria_fmt_float(void* sink, void* v) { sink_value((FmtBuf*)sink, 'f', (Value)v); }
+void aria_fmt_str(void* sink, void* v) { sink_value((FmtBuf*)sink, 's', (Value)v); }
+
 void println(const char* s_raw) {
     // Note: s_raw usually comes from a string literal which is NOT tagged in C-land call 
     // if called from C directly. But from Aria, it's a Tagged Value. 
     // However, current codegen emits `call println` passing a tagged value in RDI.
     // So `s_raw` is actually a Value.
+    // Either way the text is NUL-terminated; only a tagged string has a length.
     Value v = (Value)s_raw;
     char* s = unbox_ptr(v);
     if (!s) s = "(null)";
+    size_t len = IS_STRING(v) && unbox_ptr(v) ? aria_str_length(s) : strlen(s);
     pthread_mutex_lock(&io_mutex);
-    put_str_unlocked(s);
+    sink_write(NULL, s, len);
     if(out_buf_idx>=BUFFER_SIZE) flush_buffer(); out_buffer[out_buf_idx++]='\n';
     flush_buffer();
     pthread_mutex_unlock(&io_mutex);
 }
+
+/*
+ * String Accumulation
+ * The compiler lowers `s = s + x` on a local it can track to
+ * aria_str_append (backend/append.h), passing the buffer s was last built
+ * in, or NULL. While s still holds exactly that buffer's text, x is written
+ * after it in place and the buffer doubles when full; otherwise a new buffer
+ * starts from a copy of s. The text and its buffer come back as a pair
+ * (RAX:RDX). Anything but two strings is left to dyn_add.
+ */
+typedef struct {
+    void* value;
+    FmtBuf* buffer;
+} AppendResult;
+
+AppendResult aria_str_append(FmtBuf* buffer, void* left, void* right) {
+    Value a = (Value)left, b = (Value)right;
+    if (!IS_STRING(a) || !IS_STRING(b)) {
+        return (AppendResult){ dyn_add(left, right), NULL };
+    }
+    char* s = unbox_ptr(a);
+    if (!buffer || buffer->data != s) {
+        int64_t len = aria_str_length(s);
+        buffer = fmt_buf_new(2 * len + 16);
+        sink_write(buffer, s, len);
+    }
+    char* t = unbox_ptr(b);
+    sink_write(buffer, t, aria_str_length(t));
+    return (AppendResult){ fmt_buf_finish(buffer), buffer };
+}
+
+/*
+ * String Builders
+ * sb_new() returns a builder for text assembled piece by piece. sb_append
+ * adds a string, or a number as print's %d / %f would show it, at amortized
+ * constant cost and returns the builder; sb_to_string copies out the text
+ * so far and leaves the builder usable.
+ */
+void* sb_new(void) { return fmt_buf_new(64); }
+
+void* sb_append(void* sb, void* value) {
+    Value v = (Value)value;
+    char spec = IS_STRING(v) ? 's' : IS_INT(v) ? 'd' : 'f';
+    sink_value((FmtBuf*)sb, spec, v);
+    return sb;
+}
+
+void* sb_length(void* sb) { return dyn_new_int(((FmtBuf*)sb)->len); }
+
+void* sb_to_string(void* sb) {
+    FmtBuf* b = (FmtBuf*)sb;
+    return aria_str_box_n(b->data, b->len);
+}
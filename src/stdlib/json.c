@@ -0,0 +1,802 @@
+/*
+ * Aria JSON
+ *
+ * json_parse(text) turns a JSON document into Aria values: objects become
+ * AriaObject, arrays AriaList, integers that fit in 32 bits ints and other
+ * numbers floats. json_stringify(value) and json_write(builder, value) go
+ * the other way, writing compact JSON into a growable string buffer (the
+ * sb_* builders in io.c).
+ *
+ * Parsing makes two passes over the text and one over the tape:
+ *  1. Structural index. Each 64-byte block is classified with vector
+ *     compares (AVX2 or SSE2 by cpuid, a scalar loop elsewhere) into bit
+ *     masks of quotes, backslashes, operators and whitespace. Escaped quotes
+ *     are dropped, a prefix XOR of the remaining ones marks the bytes inside
+ *     strings, and what is outside them gives the offset of every operator
+ *     and of the first byte of every string and scalar.
+ *  2. Tape. The offsets are walked with an explicit container stack that
+ *     checks the grammar; numbers, literals and string extents go on a flat
+ *     tape and each container records its element count.
+ * The tape is then turned into values, allocating every object and list at
+ * its final size. Invalid input reports a "JSON Error" with its byte offset
+ * on stderr and parses as null.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "number_text.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JSON_X86 1
+#endif
+
+extern void* aria_alloc_object_sized(long long count);
+extern void* aria_obj_set(void* obj_tagged, char* key, void* value_tagged);
+extern long long aria_obj_next(void* obj_tagged, long long slot, char** key, void** value);
+extern void* list_new_sized(long long capacity);
+extern void list_push(void* list_tagged, void* item_tagged);
+extern void* list_header(void* list_tagged);
+extern void* list_get(void* list_tagged, void* index_tagged);
+
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+extern uint32_t aria_str_length(const char* data);
+
+// String builders (io.c)
+extern void* aria_fmt_new(long long capacity);
+extern void aria_fmt_text(void* sink, const char* s, long long len);
+extern void* aria_fmt_finish(void* sink);
+
+// --- Tagging System (NaN Boxing) ---
+typedef uint64_t Value;
+#define QNAN_MASK       0x7FF8000000000000ULL
+#define SIGN_BIT        0x8000000000000000ULL
+#define TAG_BASE        (QNAN_MASK | SIGN_BIT)
+#define TAG_NULL        (TAG_BASE | 1ULL)
+#define TAG_FALSE       (TAG_BASE | 2ULL)
+#define TAG_TRUE        (TAG_BASE | 3ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
+#define TAG_STRING      (TAG_BASE | 5ULL)
+#define TAG_OBJECT      (TAG_BASE | 6ULL)
+#define TAG_LIST        (TAG_BASE | 7ULL)
+#define PTR_MASK        0x0000FFFFFFFFFFFFULL
+#define IS_DOUBLE(v)    (((v) & QNAN_MASK) != QNAN_MASK)
+#define IS_INT(v)       (((v) & 0xFFFF000000000000ULL) == TAG_INTEGER)
+#define IS_STRING(v)    (((v) & 0xFFFF000000000007ULL) == TAG_STRING)
+#define IS_OBJECT(v)    (((v) & 0xFFFF000000000007ULL) == TAG_OBJECT)
+#define IS_LIST(v)      (((v) & 0xFFFF000000000007ULL) == TAG_LIST)
+
+static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
+static inline Value box_str(char* data) { return TAG_STRING | (uintptr_t)data; }
+static inline Value box_double(double d) {
+    union { double d; uint64_t u; } cast = { d };
+    if ((cast.u & QNAN_MASK) == QNAN_MASK) return QNAN_MASK;
+    return cast.u;
+}
+static inline double unbox_double(Value v) { union { uint64_t u; double d; } cast = { v }; return cast.d; }
+static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
+static inline char* unbox_ptr(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
+
+// Stable prefix of AriaList that compiled loops read (dataStructures.c)
+typedef struct {
+    Value* items;
+    int capacity;
+    int count;
+} ListItems;
+
+#define JSON_MAX_DEPTH 1024
+
+// --- Stage 1: Block Classification ---
+
+typedef struct {
+    uint64_t quote, backslash, op, space, control, high;
+} BlockMasks;
+
+static void classify_scalar(const uint8_t* p, BlockMasks* m) {
+    memset(m, 0, sizeof(*m));
+    for (int i = 0; i < 64; i++) {
+        uint64_t bit = 1ULL << i;
+        switch (p[i]) {
+            case '"': m->quote |= bit; break;
+            case '\\': m->backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': m->op |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': m->space |= bit; break;
+        }
+        if (p[i] < 0x20) m->control |= bit;
+        if (p[i] >= 0x80) m->high |= bit;
+    }
+}
+
+#ifdef JSON_X86
+
+// '[' and ']' are '{' and '}' without bit 5, and no other byte is
+__attribute__((target("sse2")))
+static void classify_sse2(const uint8_t* p, BlockMasks* m) {
+    memset(m, 0, sizeof(*m));
+    for (int k = 0; k < 64; k += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + k));
+        __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        __m128i space = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+        m->quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << k;
+        m->backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << k;
+        m->op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << k;
+        m->space |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << k;
+        m->control |= (uint64_t)(uint16_t)_mm_movemask_epi8(control) << k;
+        m->high |= (uint64_t)(uint16_t)_mm_movemask_epi8(v) << k;
+    }
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const uint8_t* p, BlockMasks* m) {
+    memset(m, 0, sizeof(*m));
+    for (int k = 0; k < 64; k += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + k));
+        __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+        __m256i space = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F));
+        m->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << k;
+        m->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << k;
+        m->op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << k;
+        m->space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << k;
+        m->control |= (uint64_t)(uint32_t)_mm256_movemask_epi8(control) << k;
+        m->high |= (uint64_t)(uint32_t)_mm256_movemask_epi8(v) << k;
+    }
+}
+
+#endif
+
+static void (*classify)(const uint8_t* p, BlockMasks* m) = classify_scalar;
+
+// Widest classifier the CPU runs; ARIA_STR_KERNELS caps it as it does the
+// string kernels (string_kernels.c)
+static const char* pick_classifier(const char* limit) {
+    classify = classify_scalar;
+    if (limit && strcmp(limit, "scalar") == 0) return "scalar";
+#ifdef JSON_X86
+    __builtin_cpu_init();
+    classify = classify_sse2;
+    if (limit && strcmp(limit, "sse4.2") == 0) return "sse2";
+    if (__builtin_cpu_supports("avx2")) {
+        classify = classify_avx2;
+        return "avx2";
+    }
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+__attribute__((constructor))
+static void json_init(void) {
+    pick_classifier(getenv("ARIA_STR_KERNELS"));
+}
+
+// For tests and benchmarks: switches classifier, returns the one in use
+const char* aria_json_kernels_use(const char* limit) {
+    return pick_classifier(limit);
+}
+
+// --- Stage 1: Structural Index ---
+
+typedef struct {
+    uint32_t tape_at;
+    uint32_t count;
+    char type;
+} Container;
+
+typedef struct {
+    const char* text;
+    size_t len;
+    uint32_t* index;      // offsets of structural bytes
+    size_t count;
+    size_t index_cap;
+    uint64_t* tape;
+    size_t tape_len;
+    size_t at;            // read position while building values
+    Container stack[JSON_MAX_DEPTH];
+} JsonParser;
+
+static int fail(JsonParser* p, size_t offset, const char* message) {
+    (void)p;
+    fprintf(stderr, "JSON Error: %s at byte %zu\n", message, offset);
+    return 0;
+}
+
+// Bytes preceded by an unescaped backslash; *carry escapes byte 0 of the
+// next block. Backslashes are rare, so they are walked one at a time.
+static uint64_t escaped_bits(uint64_t backslash, uint64_t* carry) {
+    uint64_t escaped = *carry;
+    *carry = 0;
+    while (backslash) {
+        int i = __builtin_ctzll(backslash);
+        uint64_t bit = 1ULL << i;
+        if (!(escaped & bit)) {
+            if (i == 63) *carry = 1;
+            else escaped |= bit << 1;
+        }
+        backslash &= backslash - 1;
+    }
+    return escaped;
+}
+
+// Bit i is the XOR of bits 0..i: set from an opening quote up to (not
+// including) its closing quote
+static inline uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Offset of the first byte that is not valid UTF-8, or len
+static size_t utf8_invalid_at(const uint8_t* s, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        uint64_t word;
+        if (len - i >= 8 && (memcpy(&word, s + i, 8), !(word & 0x8080808080808080ULL))) {
+            i += 8;
+            continue;
+        }
+        uint8_t c = s[i];
+        if (c < 0x80) { i++; continue; }
+        size_t n;
+        uint32_t cp;
+        if (c >= 0xC2 && c <= 0xDF) { n = 1; cp = c & 0x1F; }
+        else if (c >= 0xE0 && c <= 0xEF) { n = 2; cp = c & 0x0F; }
+        else if (c >= 0xF0 && c <= 0xF4) { n = 3; cp = c & 0x07; }
+        else return i;
+        if (len - i <= n) return i;
+        for (size_t k = 1; k <= n; k++) {
+            if ((s[i + k] & 0xC0) != 0x80) return i;
+            cp = (cp << 6) | (s[i + k] & 0x3F);
+        }
+        // Overlong forms, surrogates and code points past U+10FFFF
+        if ((n == 2 && cp < 0x800) || (n == 3 && cp < 0x10000) || cp > 0x10FFFF ||
+            (cp >= 0xD800 && cp <= 0xDFFF)) return i;
+        i += n + 1;
+    }
+    return len;
+}
+
+static int build_index(JsonParser* p) {
+    const uint8_t* text = (const uint8_t*)p->text;
+    uint64_t prev_escaped = 0, prev_in_string = 0, prev_scalar = 0, high = 0;
+    p->index_cap = p->len / 8 + 64;
+    p->index = (uint32_t*)malloc(sizeof(uint32_t) * p->index_cap);
+    if (!p->index) return fail(p, 0, "out of memory");
+
+    for (size_t pos = 0; pos < p->len; pos += 64) {
+        uint8_t tail[64];
+        const uint8_t* block = text + pos;
+        if (p->len - pos < 64) {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, p->len - pos);
+            block = tail;
+        }
+        BlockMasks m;
+        classify(block, &m);
+
+        uint64_t quote = m.quote & ~escaped_bits(m.backslash, &prev_escaped);
+        uint64_t in_string = prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+        if (m.control & in_string) {
+            return fail(p, pos + __builtin_ctzll(m.control & in_string), "control character in string");
+        }
+        high |= m.high;
+
+        uint64_t scalar = ~(m.op | m.space | quote | in_string);
+        uint64_t starts = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+        uint64_t structural = (m.op & ~in_string) | (quote & in_string) | starts;
+
+        if (p->count + 68 > p->index_cap) {
+            p->index_cap *= 2;
+            uint32_t* grown = (uint32_t*)realloc(p->index, sizeof(uint32_t) * p->index_cap);
+            if (!grown) return fail(p, pos, "out of memory");
+            p->index = grown;
+        }
+        // Offsets four at a time; the spare ones written past the count are
+        // overwritten by the next block
+        uint32_t* out = p->index + p->count;
+        p->count += (size_t)__builtin_popcountll(structural);
+        while (structural) {
+            for (int k = 0; k < 4; k++) {
+                out[k] = (uint32_t)(pos + __builtin_ctzll(structural | (1ULL << 63)));
+                structural &= structural - 1;
+            }
+            out += 4;
+        }
+    }
+    if (prev_in_string) return fail(p, p->len, "unterminated string");
+    if (high) {
+        size_t bad = utf8_invalid_at(text, p->len);
+        if (bad < p->len) return fail(p, bad, "invalid UTF-8");
+    }
+    return 1;
+}
+
+// --- Stage 2: Tape ---
+// One word per value, with the type in the top byte: containers hold their
+// element count, ints their value. A string is followed by a word with its
+// raw and decoded lengths, a float by its bits.
+
+#define TAPE(type, payload) (((uint64_t)(type) << 56) | (uint64_t)(payload))
+#define TAPE_PAYLOAD(word)  ((word) & ((1ULL << 56) - 1))
+
+// Length of the prefix of s[0..n) holding no quote, backslash or control
+// byte: everything a string can hold without an escape
+static size_t plain_run(const char* s, size_t n) {
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i stop = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F)));
+        int mask = _mm_movemask_epi8(stop);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\' || c < 0x20) break;
+    }
+    return i;
+}
+
+static int hex4(const char* s, size_t avail, uint32_t* out) {
+    if (avail < 4) return 0;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (uint32_t)(c - 'A' + 10);
+        else return 0;
+    }
+    *out = v;
+    return 1;
+}
+
+// Code point of the \u escape at s (one or two of them), and the bytes read
+static size_t unicode_escape(const char* s, size_t avail, uint32_t* cp) {
+    uint32_t lo;
+    if (avail < 2 || !hex4(s + 2, avail - 2, cp)) return 0;
+    if (*cp >= 0xDC00 && *cp <= 0xDFFF) return 0;
+    if (*cp < 0xD800 || *cp > 0xDBFF) return 6;
+    if (avail < 12 || s[6] != '\\' || s[7] != 'u' || !hex4(s + 8, avail - 8, &lo) || lo < 0xDC00 || lo > 0xDFFF) return 0;
+    *cp = 0x10000 + ((*cp - 0xD800) << 10) + (lo - 0xDC00);
+    return 12;
+}
+
+static size_t utf8_length(uint32_t cp) {
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
+
+// The string opening at 'at': checks its escapes and measures it
+static int tape_string(JsonParser* p, size_t at) {
+    const char* s = p->text;
+    size_t i = at + 1, decoded = 0;
+    for (;;) {
+        size_t run = plain_run(s + i, p->len - i);
+        i += run;
+        decoded += run;
+        if (i >= p->len) return fail(p, at, "unterminated string");
+        if (s[i] == '"') break;
+        if (s[i] != '\\') return fail(p, i, "control character in string");
+        if (i + 1 >= p->len) return fail(p, at, "unterminated string");
+        switch (s[i + 1]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                decoded++;
+                i += 2;
+                break;
+            case 'u': {
+                uint32_t cp;
+                size_t used = unicode_escape(s + i, p->len - i, &cp);
+                if (!used) return fail(p, i, "invalid \\u escape");
+                decoded += utf8_length(cp);
+                i += used;
+                break;
+            }
+            default:
+                return fail(p, i, "invalid escape");
+        }
+    }
+    size_t raw = i - (at + 1);
+    if (raw > UINT32_MAX) return fail(p, at, "string too long");
+    p->tape[p->tape_len++] = TAPE('"', at);
+    p->tape[p->tape_len++] = ((uint64_t)raw << 32) | decoded;
+    return 1;
+}
+
+// Whatever may follow a scalar: the end, whitespace, an operator or a quote
+static inline int ends_scalar(JsonParser* p, size_t at) {
+    if (at >= p->len) return 1;
+    switch (p->text[at]) {
+        case ' ': case '\t': case '\n': case '\r':
+        case ',': case ':': case '[': case ']': case '{': case '}': case '"':
+            return 1;
+    }
+    return 0;
+}
+
+static inline int is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+static int tape_number(JsonParser* p, size_t at) {
+    const char* s = p->text;
+    size_t i = at, end = p->len;
+    int negative = s[i] == '-';
+    if (negative) i++;
+    size_t digits = i;
+    if (i < end && s[i] == '0') i++;
+    else while (i < end && is_digit(s[i])) i++;
+    if (i == digits) return fail(p, at, "invalid number");
+    size_t int_end = i;
+    int is_int = 1;
+    if (i < end && s[i] == '.') {
+        size_t frac = ++i;
+        while (i < end && is_digit(s[i])) i++;
+        if (i == frac) return fail(p, at, "invalid number");
+        is_int = 0;
+    }
+    if (i < end && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        if (i < end && (s[i] == '+' || s[i] == '-')) i++;
+        size_t exp = i;
+        while (i < end && is_digit(s[i])) i++;
+        if (i == exp) return fail(p, at, "invalid number");
+        is_int = 0;
+    }
+    if (!ends_scalar(p, i)) return fail(p, i, "invalid number");
+
+    if (is_int && int_end - digits <= 10) {
+        int64_t v = 0;
+        for (size_t k = digits; k < int_end; k++) v = v * 10 + (s[k] - '0');
+        if (negative) v = -v;
+        if (v >= INT32_MIN && v <= INT32_MAX) {
+            p->tape[p->tape_len++] = TAPE('l', (uint32_t)(int32_t)v);
+            return 1;
+        }
+    }
+    union { double d; uint64_t u; } v = { aria_parse_double(s + at, NULL) };
+    p->tape[p->tape_len++] = TAPE('d', 0);
+    p->tape[p->tape_len++] = v.u;
+    return 1;
+}
+
+static int tape_literal(JsonParser* p, size_t at, const char* word, char type) {
+    size_t n = strlen(word);
+    if (p->len - at < n || memcmp(p->text + at, word, n) != 0 || !ends_scalar(p, at + n)) {
+        return fail(p, at, "invalid literal");
+    }
+    p->tape[p->tape_len++] = TAPE(type, 0);
+    return 1;
+}
+
+static int build_tape(JsonParser* p) {
+    const char* s = p->text;
+    const uint32_t* index = p->index;
+    size_t n = p->count, i = 0;
+    int depth = 0;
+    // Every structural byte adds at most two words
+    p->tape = (uint64_t*)malloc(sizeof(uint64_t) * (2 * n + 1));
+    if (!p->tape) return fail(p, 0, "out of memory");
+    if (n == 0) return fail(p, p->len, "empty document");
+
+value:
+    if (i >= n) return fail(p, p->len, "unexpected end of input");
+    {
+        size_t at = index[i++];
+        switch (s[at]) {
+            case '{':
+            case '[': {
+                if (depth >= JSON_MAX_DEPTH) return fail(p, at, "nesting too deep");
+                Container* c = &p->stack[depth++];
+                c->type = s[at];
+                c->tape_at = (uint32_t)p->tape_len;
+                c->count = 0;
+                p->tape[p->tape_len++] = TAPE(s[at], 0);
+                if (i < n && s[index[i]] == (c->type == '{' ? '}' : ']')) {
+                    i++;
+                    depth--;
+                    goto after_value;
+                }
+                if (c->type == '{') goto key;
+                c->count++;
+                goto value;
+            }
+            case '"':
+                if (!tape_string(p, at)) return 0;
+                goto after_value;
+            case 't':
+                if (!tape_literal(p, at, "true", 't')) return 0;
+                goto after_value;
+            case 'f':
+                if (!tape_literal(p, at, "false", 'f')) return 0;
+                goto after_value;
+            case 'n':
+                if (!tape_literal(p, at, "null", 'n')) return 0;
+                goto after_value;
+            case '-': case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                if (!tape_number(p, at)) return 0;
+                goto after_value;
+            default:
+                return fail(p, at, "unexpected character");
+        }
+    }
+
+key:
+    if (i >= n || s[index[i]] != '"') return fail(p, i < n ? index[i] : p->len, "expected a string key");
+    if (!tape_string(p, index[i++])) return 0;
+    if (i >= n || s[index[i]] != ':') return fail(p, i < n ? index[i] : p->len, "expected ':'");
+    i++;
+    p->stack[depth - 1].count++;
+    goto value;
+
+after_value:
+    if (depth == 0) {
+        if (i < n) return fail(p, index[i], "unexpected data after the document");
+        return 1;
+    }
+    if (i >= n) return fail(p, p->len, "unexpected end of input");
+    {
+        size_t at = index[i++];
+        Container* c = &p->stack[depth - 1];
+        if (s[at] == ',') {
+            if (c->type == '{') goto key;
+            c->count++;
+            goto value;
+        }
+        if (s[at] != (c->type == '{' ? '}' : ']')) {
+            return fail(p, at, c->type == '{' ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+        p->tape[c->tape_at] |= c->count;
+        depth--;
+        goto after_value;
+    }
+}
+
+// --- Values ---
+
+static void put_utf8(char** out, uint32_t cp) {
+    char* o = *out;
+    if (cp < 0x80) {
+        *o++ = (char)cp;
+    } else if (cp < 0x800) {
+        *o++ = (char)(0xC0 | (cp >> 6));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *o++ = (char)(0xE0 | (cp >> 12));
+        *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *o++ = (char)(0xF0 | (cp >> 18));
+        *o++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    }
+    *out = o;
+}
+
+// Decodes the string whose tape word was just read; escapes are valid
+static char* make_string(JsonParser* p, size_t at) {
+    uint64_t lengths = p->tape[p->at++];
+    size_t raw = (size_t)(lengths >> 32), decoded = (size_t)(uint32_t)lengths;
+    const char* s = p->text + at + 1;
+    char* data = aria_str_alloc(decoded);
+    if (raw == decoded) {
+        memcpy(data, s, raw);
+        return data;
+    }
+    char* out = data;
+    size_t i = 0;
+    while (i < raw) {
+        size_t run = plain_run(s + i, raw - i);
+        memcpy(out, s + i, run);
+        out += run;
+        i += run;
+        if (i >= raw) break;
+        char e = s[i + 1];
+        i += 2;
+        switch (e) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                i += unicode_escape(s + i - 2, raw - (i - 2), &cp) - 2;
+                put_utf8(&out, cp);
+                break;
+            }
+            default: *out++ = e; break;
+        }
+    }
+    return data;
+}
+
+static Value make_value(JsonParser* p) {
+    uint64_t word = p->tape[p->at++];
+    uint64_t payload = TAPE_PAYLOAD(word);
+    switch ((char)(word >> 56)) {
+        case '{': {
+            void* obj = aria_alloc_object_sized((long long)payload);
+            for (uint64_t k = 0; k < payload; k++) {
+                char* key = make_string(p, TAPE_PAYLOAD(p->tape[p->at++]));
+                Value v = make_value(p);
+                aria_obj_set(obj, key, (void*)v);
+            }
+            return (Value)obj;
+        }
+        case '[': {
+            void* list = list_new_sized((long long)payload);
+            for (uint64_t k = 0; k < payload; k++) list_push(list, (void*)make_value(p));
+            return (Value)list;
+        }
+        case '"': return box_str(make_string(p, payload));
+        case 'l': return box_int((int32_t)(uint32_t)payload);
+        case 'd': return box_double(unbox_double(p->tape[p->at++]));
+        case 't': return TAG_TRUE;
+        case 'f': return TAG_FALSE;
+        default: return TAG_NULL;
+    }
+}
+
+/*
+ * Parses text[0..len) into *out, or only checks it when out is NULL.
+ * Returns 1 for a valid document and 0 (after reporting why) otherwise.
+ */
+long long aria_json_parse(const char* text, size_t len, void** out) {
+    JsonParser* p = (JsonParser*)calloc(1, sizeof(JsonParser));
+    if (!p) return 0;
+    p->text = text;
+    p->len = len;
+    int ok = build_index(p) && build_tape(p);
+    if (ok && out) *out = (void*)make_value(p);
+    free(p->index);
+    free(p->tape);
+    free(p);
+    return ok;
+}
+
+// json_parse(text) -> value, or null (with a message) if text is not JSON
+void* json_parse(void* text_tagged) {
+    Value text = (Value)text_tagged;
+    char* s = unbox_ptr(text);
+    void* result = (void*)TAG_NULL;
+    if (!s) return result;
+    size_t len = IS_STRING(text) ? aria_str_length(s) : strlen(s);
+    if (!aria_json_parse(s, len, &result)) return (void*)TAG_NULL;
+    return result;
+}
+
+// --- Serializer ---
+
+static void write_string(void* sink, const char* s, size_t n) {
+    static const char HEX[] = "0123456789abcdef";
+    aria_fmt_text(sink, "\"", 1);
+    size_t i = 0;
+    while (i < n) {
+        size_t run = plain_run(s + i, n - i);
+        if (run) aria_fmt_text(sink, s + i, (long long)run);
+        i += run;
+        if (i >= n) break;
+        unsigned char c = (unsigned char)s[i++];
+        char esc[6] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 15] };
+        switch (c) {
+            case '"': aria_fmt_text(sink, "\\\"", 2); break;
+            case '\\': aria_fmt_text(sink, "\\\\", 2); break;
+            case '\b': aria_fmt_text(sink, "\\b", 2); break;
+            case '\f': aria_fmt_text(sink, "\\f", 2); break;
+            case '\n': aria_fmt_text(sink, "\\n", 2); break;
+            case '\r': aria_fmt_text(sink, "\\r", 2); break;
+            case '\t': aria_fmt_text(sink, "\\t", 2); break;
+            default: aria_fmt_text(sink, esc, 6); break;
+        }
+    }
+    aria_fmt_text(sink, "\"", 1);
+}
+
+// Fewest significant digits that read back as the same double; a float
+// always shows a '.' or an exponent so it parses back as a float
+static void write_double(void* sink, double d) {
+    char buf[40];
+    int len = 0;
+    if (d != d || d - d != 0) {
+        aria_fmt_text(sink, "null", 4);
+        return;
+    }
+    for (int digits = 15; digits <= 17; digits++) {
+        len = snprintf(buf, sizeof(buf) - 2, "%.*g", digits, d);
+        if (aria_parse_double(buf, NULL) == d) break;
+    }
+    if (!strpbrk(buf, ".e")) {
+        buf[len++] = '.';
+        buf[len++] = '0';
+    }
+    aria_fmt_text(sink, buf, len);
+}
+
+static int write_value(void* sink, Value v, int depth) {
+    if (depth > JSON_MAX_DEPTH) {
+        fprintf(stderr, "JSON Error: value nested too deep to write\n");
+        return 0;
+    }
+    if (v == 0 || v == TAG_NULL) { aria_fmt_text(sink, "null", 4); return 1; }
+    if (v == TAG_TRUE) { aria_fmt_text(sink, "true", 4); return 1; }
+    if (v == TAG_FALSE) { aria_fmt_text(sink, "false", 5); return 1; }
+    if (IS_DOUBLE(v)) { write_double(sink, unbox_double(v)); return 1; }
+    if (IS_INT(v)) {
+        char buf[24];
+        aria_fmt_text(sink, buf, aria_int_text(buf, unbox_int(v)));
+        return 1;
+    }
+    if (IS_STRING(v)) {
+        char* s = unbox_ptr(v);
+        write_string(sink, s, aria_str_length(s));
+        return 1;
+    }
+    if (IS_LIST(v)) {
+        ListItems* list = (ListItems*)list_header((void*)v);
+        aria_fmt_text(sink, "[", 1);
+        // Items may be packed ints, which list_get boxes
+        for (int i = 0; i < list->count; i++) {
+            if (i) aria_fmt_text(sink, ",", 1);
+            if (!write_value(sink, (Value)list_get((void*)v, (void*)(uintptr_t)i), depth + 1)) return 0;
+        }
+        aria_fmt_text(sink, "]", 1);
+        return 1;
+    }
+    if (IS_OBJECT(v)) {
+        char* key;
+        void* value;
+        int first = 1;
+        aria_fmt_text(sink, "{", 1);
+        for (long long slot = 0; (slot = aria_obj_next((void*)v, slot, &key, &value)) >= 0; slot++) {
+            if (!first) aria_fmt_text(sink, ",", 1);
+            first = 0;
+            write_string(sink, key, strlen(key));
+            aria_fmt_text(sink, ":", 1);
+            if (!write_value(sink, (Value)value, depth + 1)) return 0;
+        }
+        aria_fmt_text(sink, "}", 1);
+        return 1;
+    }
+    aria_fmt_text(sink, "null", 4);
+    return 1;
+}
+
+// json_write(builder, value): appends value as JSON to an sb_new() builder
+void* json_write(void* sb, void* value) {
+    write_value(sb, (Value)value, 0);
+    return sb;
+}
+
+// json_stringify(value) -> compact JSON text, or null if it nests too deep
+void* json_stringify(void* value) {
+    void* sink = aria_fmt_new(64);
+    if (!write_value(sink, (Value)value, 0)) return (void*)TAG_NULL;
+    return aria_fmt_finish(sink);
+}
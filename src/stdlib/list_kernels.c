@@ -0,0 +1,395 @@
+/*
+ * Aria List Kernels
+ *
+ * Sum, dot product, min/max and scalar add/multiply over the packed item
+ * arrays of int and float lists (dataStructures.c): int32_t for ints and
+ * double for floats. Each kernel has a scalar version and an AVX2 version
+ * (8 ints or 4 doubles per step); the level is chosen once at startup from
+ * cpuid, and ARIA_LIST_KERNELS=scalar|avx2 caps it.
+ *
+ * Int sums and dot products accumulate in 64 bits and are exact. Float
+ * sums and dot products keep 16 partial sums, item i going to sum i % 16,
+ * and add them pairwise at the end; the scalar code keeps the same 16 sums
+ * as the four AVX2 registers, so every level rounds the same way and gives
+ * the same answer. Multiplies and adds stay separate (no FMA) for the same
+ * reason.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIST_KERNELS_X86 1
+#endif
+
+#define LANES 16
+
+typedef struct {
+    const char* name;
+    int64_t (*sum_ints)(const int32_t* a, size_t n);
+    double (*sum_doubles)(const double* a, size_t n);
+    int64_t (*dot_ints)(const int32_t* a, const int32_t* b, size_t n);
+    double (*dot_doubles)(const double* a, const double* b, size_t n);
+    void (*range_ints)(const int32_t* a, size_t n, int32_t* min, int32_t* max);
+    void (*range_doubles)(const double* a, size_t n, double* min, double* max);
+    void (*map_ints)(int32_t* out, const int32_t* a, size_t n, int32_t x, int mul);
+    int (*map_doubles)(double* out, const double* a, size_t n, double x, int mul);
+    int (*map_ints_to_doubles)(double* out, const int32_t* a, size_t n, double x, int mul);
+} ListKernels;
+
+// Pairwise sum of the 16 partial sums, in the same order at every level
+static double combine_sum(double* lane) {
+    for (int w = LANES / 2; w > 0; w /= 2) {
+        for (int k = 0; k < w; k++) lane[k] += lane[k + w];
+    }
+    return lane[0];
+}
+
+static void combine_range(double* lo, double* hi) {
+    for (int w = LANES / 2; w > 0; w /= 2) {
+        for (int k = 0; k < w; k++) {
+            lo[k] = lo[k + w] < lo[k] ? lo[k + w] : lo[k];
+            hi[k] = hi[k + w] > hi[k] ? hi[k + w] : hi[k];
+        }
+    }
+}
+
+// --- Scalar ---
+
+static int64_t sum_ints_scalar(const int32_t* a, size_t n) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += a[i];
+    return sum;
+}
+
+static double sum_doubles_scalar(const double* a, size_t n) {
+    double lane[LANES] = { 0 };
+    for (size_t i = 0; i < n; i++) lane[i % LANES] += a[i];
+    return combine_sum(lane);
+}
+
+static int64_t dot_ints_scalar(const int32_t* a, const int32_t* b, size_t n) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += (int64_t)a[i] * b[i];
+    return sum;
+}
+
+static double dot_doubles_scalar(const double* a, const double* b, size_t n) {
+    double lane[LANES] = { 0 };
+    for (size_t i = 0; i < n; i++) {
+        double product = a[i] * b[i];
+        lane[i % LANES] += product;
+    }
+    return combine_sum(lane);
+}
+
+// 'n' is at least 1
+static void range_ints_scalar(const int32_t* a, size_t n, int32_t* min, int32_t* max) {
+    int32_t lo = a[0], hi = a[0];
+    for (size_t i = 1; i < n; i++) {
+        lo = a[i] < lo ? a[i] : lo;
+        hi = a[i] > hi ? a[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+// Same lanes as the AVX2 version, so ties between -0.0 and 0.0 resolve alike
+static void range_doubles_scalar(const double* a, size_t n, double* min, double* max) {
+    double lo[LANES], hi[LANES];
+    for (int k = 0; k < LANES; k++) lo[k] = hi[k] = a[0];
+    for (size_t i = 0; i < n; i++) {
+        double* l = &lo[i % LANES];
+        double* h = &hi[i % LANES];
+        *l = a[i] < *l ? a[i] : *l;
+        *h = a[i] > *h ? a[i] : *h;
+    }
+    combine_range(lo, hi);
+    *min = lo[0];
+    *max = hi[0];
+}
+
+// Ints wrap at 32 bits, as int + int does
+static void map_ints_scalar(int32_t* out, const int32_t* a, size_t n, int32_t x, int mul) {
+    uint32_t ux = (uint32_t)x;
+    if (mul) {
+        for (size_t i = 0; i < n; i++) out[i] = (int32_t)((uint32_t)a[i] * ux);
+    } else {
+        for (size_t i = 0; i < n; i++) out[i] = (int32_t)((uint32_t)a[i] + ux);
+    }
+}
+
+// Returns 1 if any result is NaN
+static int map_doubles_scalar(double* out, const double* a, size_t n, double x, int mul) {
+    int nan = 0;
+    for (size_t i = 0; i < n; i++) {
+        double r = mul ? a[i] * x : a[i] + x;
+        out[i] = r;
+        nan |= r != r;
+    }
+    return nan;
+}
+
+static int map_ints_to_doubles_scalar(double* out, const int32_t* a, size_t n, double x, int mul) {
+    int nan = 0;
+    for (size_t i = 0; i < n; i++) {
+        double r = mul ? (double)a[i] * x : (double)a[i] + x;
+        out[i] = r;
+        nan |= r != r;
+    }
+    return nan;
+}
+
+static const ListKernels SCALAR_KERNELS = {
+    "scalar", sum_ints_scalar, sum_doubles_scalar, dot_ints_scalar, dot_doubles_scalar,
+    range_ints_scalar, range_doubles_scalar, map_ints_scalar, map_doubles_scalar,
+    map_ints_to_doubles_scalar
+};
+
+#ifdef LIST_KERNELS_X86
+
+// --- AVX2 ---
+
+__attribute__((target("avx2")))
+static int64_t hsum_epi64(__m256i v) {
+    int64_t part[4];
+    _mm256_storeu_si256((__m256i*)part, v);
+    return part[0] + part[1] + part[2] + part[3];
+}
+
+__attribute__((target("avx2")))
+static int64_t sum_ints_avx2(const int32_t* a, size_t n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + i));
+        s0 = _mm256_add_epi64(s0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        s1 = _mm256_add_epi64(s1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t sum = hsum_epi64(_mm256_add_epi64(s0, s1));
+    for (; i < n; i++) sum += a[i];
+    return sum;
+}
+
+// Four registers of four lanes hold the 16 partial sums
+__attribute__((target("avx2")))
+static double sum_doubles_avx2(const double* a, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + i));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(a + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_loadu_pd(a + i + 8));
+        s3 = _mm256_add_pd(s3, _mm256_loadu_pd(a + i + 12));
+    }
+    double lane[LANES];
+    _mm256_storeu_pd(lane, s0);
+    _mm256_storeu_pd(lane + 4, s1);
+    _mm256_storeu_pd(lane + 8, s2);
+    _mm256_storeu_pd(lane + 12, s3);
+    for (; i < n; i++) lane[i % LANES] += a[i];
+    return combine_sum(lane);
+}
+
+// VPMULDQ multiplies the low, sign-extended halves of each 64-bit lane
+__attribute__((target("avx2")))
+static int64_t dot_ints_avx2(const int32_t* a, const int32_t* b, size_t n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a0 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m256i b0 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(b + i)));
+        __m256i a1 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i + 4)));
+        __m256i b1 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(b + i + 4)));
+        s0 = _mm256_add_epi64(s0, _mm256_mul_epi32(a0, b0));
+        s1 = _mm256_add_epi64(s1, _mm256_mul_epi32(a1, b1));
+    }
+    int64_t sum = hsum_epi64(_mm256_add_epi64(s0, s1));
+    for (; i < n; i++) sum += (int64_t)a[i] * b[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static double dot_doubles_avx2(const double* a, const double* b, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        s0 = _mm256_add_pd(s0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+        s2 = _mm256_add_pd(s2, _mm256_mul_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8)));
+        s3 = _mm256_add_pd(s3, _mm256_mul_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12)));
+    }
+    double lane[LANES];
+    _mm256_storeu_pd(lane, s0);
+    _mm256_storeu_pd(lane + 4, s1);
+    _mm256_storeu_pd(lane + 8, s2);
+    _mm256_storeu_pd(lane + 12, s3);
+    for (; i < n; i++) {
+        double product = a[i] * b[i];
+        lane[i % LANES] += product;
+    }
+    return combine_sum(lane);
+}
+
+__attribute__((target("avx2")))
+static void range_ints_avx2(const int32_t* a, size_t n, int32_t* min, int32_t* max) {
+    __m256i lo = _mm256_set1_epi32(a[0]), hi = lo;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + i));
+        lo = _mm256_min_epi32(lo, v);
+        hi = _mm256_max_epi32(hi, v);
+    }
+    int32_t l[8], h[8];
+    _mm256_storeu_si256((__m256i*)l, lo);
+    _mm256_storeu_si256((__m256i*)h, hi);
+    int32_t rl = l[0], rh = h[0];
+    for (int k = 1; k < 8; k++) {
+        rl = l[k] < rl ? l[k] : rl;
+        rh = h[k] > rh ? h[k] : rh;
+    }
+    for (; i < n; i++) {
+        rl = a[i] < rl ? a[i] : rl;
+        rh = a[i] > rh ? a[i] : rh;
+    }
+    *min = rl;
+    *max = rh;
+}
+
+// MINPD(x, m) is x < m ? x : m, the scalar version's comparison
+__attribute__((target("avx2")))
+static void range_doubles_avx2(const double* a, size_t n, double* min, double* max) {
+    __m256d first = _mm256_set1_pd(a[0]);
+    __m256d l0 = first, l1 = first, l2 = first, l3 = first;
+    __m256d h0 = first, h1 = first, h2 = first, h3 = first;
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        __m256d v0 = _mm256_loadu_pd(a + i), v1 = _mm256_loadu_pd(a + i + 4);
+        __m256d v2 = _mm256_loadu_pd(a + i + 8), v3 = _mm256_loadu_pd(a + i + 12);
+        l0 = _mm256_min_pd(v0, l0); h0 = _mm256_max_pd(v0, h0);
+        l1 = _mm256_min_pd(v1, l1); h1 = _mm256_max_pd(v1, h1);
+        l2 = _mm256_min_pd(v2, l2); h2 = _mm256_max_pd(v2, h2);
+        l3 = _mm256_min_pd(v3, l3); h3 = _mm256_max_pd(v3, h3);
+    }
+    double lo[LANES], hi[LANES];
+    _mm256_storeu_pd(lo, l0); _mm256_storeu_pd(lo + 4, l1);
+    _mm256_storeu_pd(lo + 8, l2); _mm256_storeu_pd(lo + 12, l3);
+    _mm256_storeu_pd(hi, h0); _mm256_storeu_pd(hi + 4, h1);
+    _mm256_storeu_pd(hi + 8, h2); _mm256_storeu_pd(hi + 12, h3);
+    for (; i < n; i++) {
+        double* l = &lo[i % LANES];
+        double* h = &hi[i % LANES];
+        *l = a[i] < *l ? a[i] : *l;
+        *h = a[i] > *h ? a[i] : *h;
+    }
+    combine_range(lo, hi);
+    *min = lo[0];
+    *max = hi[0];
+}
+
+__attribute__((target("avx2")))
+static void map_ints_avx2(int32_t* out, const int32_t* a, size_t n, int32_t x, int mul) {
+    __m256i vx = _mm256_set1_epi32(x);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + i));
+        v = mul ? _mm256_mullo_epi32(v, vx) : _mm256_add_epi32(v, vx);
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+    map_ints_scalar(out + i, a + i, n - i, x, mul);
+}
+
+__attribute__((target("avx2")))
+static int map_doubles_avx2(double* out, const double* a, size_t n, double x, int mul) {
+    __m256d vx = _mm256_set1_pd(x), nan = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(a + i);
+        v = mul ? _mm256_mul_pd(v, vx) : _mm256_add_pd(v, vx);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+        _mm256_storeu_pd(out + i, v);
+    }
+    return (_mm256_movemask_pd(nan) != 0) | map_doubles_scalar(out + i, a + i, n - i, x, mul);
+}
+
+__attribute__((target("avx2")))
+static int map_ints_to_doubles_avx2(double* out, const int32_t* a, size_t n, double x, int mul) {
+    __m256d vx = _mm256_set1_pd(x), nan = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(a + i)));
+        v = mul ? _mm256_mul_pd(v, vx) : _mm256_add_pd(v, vx);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+        _mm256_storeu_pd(out + i, v);
+    }
+    return (_mm256_movemask_pd(nan) != 0) | map_ints_to_doubles_scalar(out + i, a + i, n - i, x, mul);
+}
+
+static const ListKernels AVX2_KERNELS = {
+    "avx2", sum_ints_avx2, sum_doubles_avx2, dot_ints_avx2, dot_doubles_avx2,
+    range_ints_avx2, range_doubles_avx2, map_ints_avx2, map_doubles_avx2,
+    map_ints_to_doubles_avx2
+};
+
+#endif
+
+// --- Dispatch ---
+
+static const ListKernels* kernels = &SCALAR_KERNELS;
+
+// Widest kernels the CPU runs, capped by 'limit' (a level name, or NULL)
+static const ListKernels* best_kernels(const char* limit) {
+    const ListKernels* best = &SCALAR_KERNELS;
+    if (limit && strcmp(limit, "scalar") == 0) return best;
+#ifdef LIST_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) best = &AVX2_KERNELS;
+#endif
+    return best;
+}
+
+__attribute__((constructor))
+static void list_kernels_init(void) {
+    kernels = best_kernels(getenv("ARIA_LIST_KERNELS"));
+}
+
+// Switches to the widest level up to 'limit'; returns the level now in use
+const char* aria_list_kernels_use(const char* limit) {
+    kernels = best_kernels(limit);
+    return kernels->name;
+}
+
+// --- Entry Points ---
+// Ranges need at least one item. The float maps return 1 if any result is
+// NaN, which a float list cannot hold.
+
+int64_t aria_list_sum_ints(const int32_t* a, size_t n) { return kernels->sum_ints(a, n); }
+double aria_list_sum_doubles(const double* a, size_t n) { return kernels->sum_doubles(a, n); }
+
+int64_t aria_list_dot_ints(const int32_t* a, const int32_t* b, size_t n) { return kernels->dot_ints(a, b, n); }
+double aria_list_dot_doubles(const double* a, const double* b, size_t n) { return kernels->dot_doubles(a, b, n); }
+
+void aria_list_range_ints(const int32_t* a, size_t n, int32_t* min, int32_t* max) {
+    kernels->range_ints(a, n, min, max);
+}
+
+void aria_list_range_doubles(const double* a, size_t n, double* min, double* max) {
+    kernels->range_doubles(a, n, min, max);
+}
+
+void aria_list_map_ints(int32_t* out, const int32_t* a, size_t n, int32_t x, int mul) {
+    kernels->map_ints(out, a, n, x, mul);
+}
+
+int aria_list_map_doubles(double* out, const double* a, size_t n, double x, int mul) {
+    return kernels->map_doubles(out, a, n, x, mul);
+}
+
+int aria_list_map_ints_to_doubles(double* out, const int32_t* a, size_t n, double x, int mul) {
+    return kernels->map_ints_to_doubles(out, a, n, x, mul);
+}
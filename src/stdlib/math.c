@@ -7,11 +7,11 @@
 // --- Runtime Tagging ---
 typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
-#define TAG_INTEGER     (QNAN_MASK | 0x8000000000000000ULL | 4ULL)
+#define TAG_INTEGER     (QNAN_MASK | 0x8000000000000000ULL | (4ULL << 48))
 
 // Helper: Extract double from Value (handles Int and Float)
 static inline double unbox(Value v) {
-    if ((v & 0xFFF8000000000000ULL) == TAG_INTEGER) {
+    if ((v & 0xFFFF000000000000ULL) == TAG_INTEGER) {
         return (double)((int32_t)(v & 0xFFFFFFFF));
     }
     union { uint64_t u; double d; } u;
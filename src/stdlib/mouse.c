@@ -9,7 +9,7 @@
 extern void* aria_alloc(size_t size);
 
 typedef uint64_t Value;
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 
 static int mouse_fd = -1;
@@ -19,20 +19,23 @@
 
 extern void* aria_alloc(size_t size);
 
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+
 // --- Tagging Helpers ---
 // Aria uses NaN-boxing. We must conform to this ABI for all return values.
 typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_STRING      (TAG_BASE | 5ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
 
 // --- Global SSL Context Registry ---
 // We map File Descriptors (int) to SSL Objects (SSL*) to maintain ABI compatibility.
@@ -292,7 +295,7 @@ void* net_read(void* socket_tagged) {
     }
     
     // Allocate string in Aria heap
-    char* res = (char*)aria_alloc(valread + 1);
+    char* res = aria_str_alloc(valread);
     if (res) {
         memcpy(res, buffer, valread);
         res[valread] = '\0';
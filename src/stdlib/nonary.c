@@ -6,11 +6,14 @@
 
 extern void* aria_alloc(size_t size);
 
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+
 typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_STRING      (TAG_BASE | 5ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
@@ -85,7 +88,7 @@ void* non_to_string(void* val_tagged) {
     }
     
     size_t len = strlen(s);
-    char* res = (char*)aria_alloc(len + 1);
+    char* res = aria_str_alloc(len);
     memcpy(res, s, len + 1);
     return (void*)box_ptr(res, TAG_STRING);
 }
@@ -0,0 +1,28 @@
+/* Aria_lang/src/stdlib/number_text.h */
+#ifndef ARIA_NUMBER_TEXT_H
+#define ARIA_NUMBER_TEXT_H
+
+#include <stdint.h>
+
+/*
+ * Number Text
+ * -----------
+ * The integer and float text print and format() write, and the parsers
+ * behind parse_int / parse_float (see "Number Text" in stdlib/io.c). The
+ * writers produce exactly what snprintf would, without a terminating NUL.
+ */
+
+// Room aria_float_text needs: "%.6f" of -DBL_MAX is 317 characters
+#define FLOAT_TEXT_MAX 320
+
+// Decimal text of n into out[0..20); returns its length
+int aria_int_text(char* out, int64_t n);
+
+// "%.6f" of f into out, which must hold FLOAT_TEXT_MAX bytes; returns its length
+int aria_float_text(char* out, double f);
+
+// strtod(s, end) and strtoll(s, end, 10)
+double aria_parse_double(const char* s, char** end);
+long long aria_parse_int(const char* s, char** end);
+
+#endif
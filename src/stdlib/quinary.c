@@ -5,7 +5,7 @@
 typedef uint64_t Value;
 #define QNAN_MASK 0x7FF8000000000000ULL
 #define TAG_TRUE (QNAN_MASK | 0x8000000000000000ULL | 3ULL)
-#define TAG_INTEGER (QNAN_MASK | 0x8000000000000000ULL | 4ULL)
+#define TAG_INTEGER (QNAN_MASK | 0x8000000000000000ULL | (4ULL << 48))
 
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
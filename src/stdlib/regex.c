@@ -0,0 +1,1396 @@
+/*
+ * Aria Regular Expressions
+ *
+ * regex_compile(pattern) compiles a pattern; regex_match, regex_find,
+ * regex_find_all and regex_replace take its result or the pattern text
+ * itself. Each distinct pattern is compiled once and kept for the life of
+ * the program, so passing the text in a loop costs a table lookup.
+ *
+ * Syntax: literals, . (any character but \n), [...] and [^...] with
+ * ranges, \d \w \s and their negations, \t \n \r \f \v \xHH, groups (...)
+ * and (?:...), |, the quantifiers * + ? {n} {n,} {n,m} (lazy with a
+ * trailing ?), ^ and $ for the start and end of the text, and a leading
+ * (?i) for ASCII case-insensitive matching. Text is UTF-8: . and negated
+ * classes match whole characters. There are no backreferences or
+ * lookaround; without them every search is linear in the text.
+ *
+ * A pattern is parsed to a tree and compiled to two Thompson NFA programs,
+ * one for the text and one for the text read backwards. Searches run DFAs
+ * built lazily from them: a DFA state is the ordered set of NFA states it
+ * stands for, made the first time some byte leads to it and kept in a
+ * cache of bounded size that is emptied and refilled when full, so no
+ * search does more than O(pattern x text) work.
+ *  - The forward DFA, with threads of lower priority than a match dropped,
+ *    finds where the leftmost-first match (as Perl and Python pick it)
+ *    ends.
+ *  - The reverse DFA, run back from there, finds where it starts.
+ *  - Only when groups are asked for does a Pike VM run, over that span
+ *    alone, to place them.
+ * Whenever the forward DFA is back at its start state, a pattern that
+ * starts with a literal skips to its next occurrence with the vector string
+ * search (string_kernels.c); one that starts with a few possible bytes
+ * skips to the next of those.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+extern void* list_new_sized(long long capacity);
+extern void list_push(void* list_tagged, void* item_tagged);
+
+// Length-prefixed strings (string_utils.c)
+extern void* aria_str_box_n(const char* buf, size_t len);
+extern uint32_t aria_str_length(const char* data);
+extern uint32_t aria_str_hash(const char* data);
+
+// string_kernels.c
+extern long long aria_str_find(const char* s, size_t n, const char* needle, size_t m);
+
+// String builders (io.c)
+extern void* aria_fmt_new(long long capacity);
+extern void aria_fmt_text(void* sink, const char* s, long long len);
+extern void* aria_fmt_finish(void* sink);
+
+// --- Tagging System (NaN Boxing) ---
+typedef uint64_t Value;
+#define QNAN_MASK       0x7FF8000000000000ULL
+#define SIGN_BIT        0x8000000000000000ULL
+#define TAG_BASE        (QNAN_MASK | SIGN_BIT)
+#define TAG_NULL        (TAG_BASE | 1ULL)
+#define TAG_FALSE       (TAG_BASE | 2ULL)
+#define TAG_TRUE        (TAG_BASE | 3ULL)
+#define TAG_STRING      (TAG_BASE | 5ULL)
+#define PTR_MASK        0x0000FFFFFFFFFFFFULL
+
+static inline char* unbox_ptr(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
+
+#define RX_MAX_INSTS    20000       // per program, after {n,m} is expanded
+#define RX_MAX_REPEAT   1000
+#define RX_MAX_GROUPS   99
+#define RX_MAX_PREFIX   64
+#define RX_DFA_BUDGET   (2 << 20)   // bytes of cached states per DFA
+#define RX_MAX_FIRST    32          // most bytes that can begin a match worth skipping to
+
+// --- Parse Tree ---
+
+typedef struct { uint64_t bits[4]; } ByteSet;
+
+static inline int set_has(const ByteSet* s, unsigned b) { return (int)((s->bits[b >> 6] >> (b & 63)) & 1); }
+static inline void set_add(ByteSet* s, unsigned b) { s->bits[b >> 6] |= 1ULL << (b & 63); }
+static void set_range(ByteSet* s, unsigned lo, unsigned hi) { for (unsigned b = lo; b <= hi; b++) set_add(s, b); }
+
+enum { N_EMPTY, N_SET, N_CAT, N_ALT, N_REPEAT, N_GROUP, N_BOL, N_EOL };
+
+typedef struct {
+    uint8_t type;
+    uint8_t greedy;
+    int a, b;          // children; a is the set index of N_SET, b the group of N_GROUP
+    int min, max;      // N_REPEAT; max is -1 for no limit
+} Node;
+
+typedef struct {
+    const char* pat;
+    size_t len, pos;
+    Node* nodes;
+    int n_nodes, cap_nodes;
+    ByteSet* sets;
+    int n_sets, cap_sets;
+    int groups;
+    int icase;
+    const char* error;
+    size_t error_at;
+} Parser;
+
+static int parse_error(Parser* ps, const char* message) {
+    if (!ps->error) {
+        ps->error = message;
+        ps->error_at = ps->pos;
+    }
+    return -1;
+}
+
+static int new_node(Parser* ps, int type, int a, int b) {
+    if (ps->error) return -1;
+    if (ps->n_nodes == ps->cap_nodes) {
+        ps->cap_nodes = ps->cap_nodes ? 2 * ps->cap_nodes : 64;
+        ps->nodes = (Node*)realloc(ps->nodes, sizeof(Node) * ps->cap_nodes);
+    }
+    Node* n = &ps->nodes[ps->n_nodes];
+    memset(n, 0, sizeof(*n));
+    n->type = (uint8_t)type;
+    n->a = a;
+    n->b = b;
+    return ps->n_nodes++;
+}
+
+// A node matching one byte of 'set'; equal sets share an index
+static int set_node(Parser* ps, const ByteSet* set) {
+    int i;
+    for (i = 0; i < ps->n_sets; i++) {
+        if (memcmp(&ps->sets[i], set, sizeof(*set)) == 0) break;
+    }
+    if (i == ps->n_sets) {
+        if (ps->n_sets == ps->cap_sets) {
+            ps->cap_sets = ps->cap_sets ? 2 * ps->cap_sets : 16;
+            ps->sets = (ByteSet*)realloc(ps->sets, sizeof(ByteSet) * ps->cap_sets);
+        }
+        ps->sets[ps->n_sets++] = *set;
+    }
+    return new_node(ps, N_SET, i, 0);
+}
+
+static int byte_node(Parser* ps, unsigned lo, unsigned hi) {
+    ByteSet set = {{0}};
+    set_range(&set, lo, hi);
+    return set_node(ps, &set);
+}
+
+static int cat_node(Parser* ps, int a, int b) {
+    if (a < 0 || b < 0) return a < 0 ? b : a;
+    return new_node(ps, N_CAT, a, b);
+}
+
+static int alt_node(Parser* ps, int a, int b) {
+    if (a < 0 || b < 0) return a < 0 ? b : a;
+    return new_node(ps, N_ALT, a, b);
+}
+
+// Any character of two to four UTF-8 bytes
+static int multibyte_node(Parser* ps) {
+    int two = cat_node(ps, byte_node(ps, 0xC2, 0xDF), byte_node(ps, 0x80, 0xBF));
+    int three = byte_node(ps, 0xE0, 0xEF);
+    for (int i = 0; i < 2; i++) three = cat_node(ps, three, byte_node(ps, 0x80, 0xBF));
+    int four = byte_node(ps, 0xF0, 0xF4);
+    for (int i = 0; i < 3; i++) four = cat_node(ps, four, byte_node(ps, 0x80, 0xBF));
+    return alt_node(ps, two, alt_node(ps, three, four));
+}
+
+// The UTF-8 bytes of code point cp, one node each
+static int char_node(Parser* ps, uint32_t cp) {
+    if (cp < 0x80) {
+        ByteSet set = {{0}};
+        set_add(&set, cp);
+        if (ps->icase && ((cp | 0x20) >= 'a' && (cp | 0x20) <= 'z')) set_add(&set, cp ^ 0x20);
+        return set_node(ps, &set);
+    }
+    uint8_t bytes[4];
+    int n = cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+    for (int i = n - 1; i > 0; i--) {
+        bytes[i] = (uint8_t)(0x80 | (cp & 0x3F));
+        cp >>= 6;
+    }
+    bytes[0] = (uint8_t)((n == 2 ? 0xC0 : n == 3 ? 0xE0 : 0xF0) | cp);
+    int node = -1;
+    for (int i = 0; i < n; i++) node = cat_node(ps, node, byte_node(ps, bytes[i], bytes[i]));
+    return node;
+}
+
+// Next code point of the pattern, which must be valid UTF-8
+static int next_char(Parser* ps, uint32_t* cp) {
+    const uint8_t* s = (const uint8_t*)ps->pat + ps->pos;
+    size_t avail = ps->len - ps->pos;
+    uint8_t c = s[0];
+    int n = c < 0x80 ? 1 : c >= 0xC2 && c <= 0xDF ? 2 : c >= 0xE0 && c <= 0xEF ? 3 : c >= 0xF0 && c <= 0xF4 ? 4 : 0;
+    if (n == 0 || (size_t)n > avail) return parse_error(ps, "invalid UTF-8");
+    uint32_t v = n == 1 ? c : c & (0x3F >> (n - 1));
+    for (int i = 1; i < n; i++) {
+        if ((s[i] & 0xC0) != 0x80) return parse_error(ps, "invalid UTF-8");
+        v = (v << 6) | (s[i] & 0x3F);
+    }
+    ps->pos += (size_t)n;
+    *cp = v;
+    return 0;
+}
+
+// --- Classes ---
+
+typedef struct {
+    ByteSet ascii;       // bytes below 0x80
+    int multibyte;       // also every character of two or more bytes
+    uint32_t cps[64];    // and these ones
+    int n_cps;
+} Class;
+
+static void class_perl(Class* c, char kind) {
+    ByteSet set = {{0}};
+    switch (kind | 0x20) {
+        case 'd': set_range(&set, '0', '9'); break;
+        case 'w': set_range(&set, '0', '9'); set_range(&set, 'A', 'Z'); set_range(&set, 'a', 'z'); set_add(&set, '_'); break;
+        case 's': set_range(&set, '\t', '\r'); set_add(&set, ' '); break;
+    }
+    if (kind & 0x20) {
+        for (int i = 0; i < 2; i++) c->ascii.bits[i] |= set.bits[i];
+    } else {
+        for (int i = 0; i < 2; i++) c->ascii.bits[i] |= ~set.bits[i];
+        c->multibyte = 1;
+    }
+}
+
+static void class_add(Parser* ps, Class* c, uint32_t lo, uint32_t hi) {
+    if (hi < 0x80) {
+        set_range(&c->ascii, lo, hi);
+        if (ps->icase) {
+            for (uint32_t b = lo; b <= hi; b++) {
+                if ((b | 0x20) >= 'a' && (b | 0x20) <= 'z') set_add(&c->ascii, b ^ 0x20);
+            }
+        }
+        return;
+    }
+    if (lo < 0x80 || hi - lo >= 64 - (uint32_t)c->n_cps) {
+        parse_error(ps, "range of non-ASCII characters too wide");
+        return;
+    }
+    for (uint32_t cp = lo; cp <= hi; cp++) c->cps[c->n_cps++] = cp;
+}
+
+// Escape after '\'; returns the character, -1 having added a \d-style
+// class to c (when c is given), or -2 for an error
+static long escape_char(Parser* ps, Class* c) {
+    if (ps->pos >= ps->len) {
+        parse_error(ps, "trailing backslash");
+        return -2;
+    }
+    char e = ps->pat[ps->pos++];
+    switch (e) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+            if (c) class_perl(c, e);
+            return -1;
+        case 'x': {
+            uint32_t v = 0;
+            for (int i = 0; i < 2; i++) {
+                char h = ps->pos < ps->len ? ps->pat[ps->pos] : 0;
+                int d = h >= '0' && h <= '9' ? h - '0' : (h | 0x20) >= 'a' && (h | 0x20) <= 'f' ? (h | 0x20) - 'a' + 10 : -1;
+                if (d < 0) {
+                    parse_error(ps, "\\x needs two hex digits");
+                    return -2;
+                }
+                v = v * 16 + (uint32_t)d;
+                ps->pos++;
+            }
+            return v;
+        }
+    }
+    if ((e >= 'a' && e <= 'z') || (e >= 'A' && e <= 'Z') || (e >= '0' && e <= '9')) {
+        ps->pos--;
+        parse_error(ps, "unsupported escape");
+        return -2;
+    }
+    if ((unsigned char)e >= 0x80) {
+        ps->pos--;
+        uint32_t cp;
+        return next_char(ps, &cp) < 0 ? -2 : (long)cp;
+    }
+    return (unsigned char)e;
+}
+
+static int class_node(Parser* ps, Class* c, int negated) {
+    if (negated) {
+        if (c->n_cps) return parse_error(ps, "non-ASCII characters in a negated class");
+        c->ascii.bits[0] = ~c->ascii.bits[0];
+        c->ascii.bits[1] = ~c->ascii.bits[1];
+        c->multibyte = !c->multibyte;
+    }
+    c->ascii.bits[2] = c->ascii.bits[3] = 0;
+    int node = set_node(ps, &c->ascii);
+    if (c->multibyte) return alt_node(ps, node, multibyte_node(ps));
+    for (int i = 0; i < c->n_cps; i++) node = alt_node(ps, node, char_node(ps, c->cps[i]));
+    return node;
+}
+
+// After '[': items up to the closing ']'
+static int parse_class(Parser* ps) {
+    Class c;
+    memset(&c, 0, sizeof(c));
+    int negated = ps->pos < ps->len && ps->pat[ps->pos] == '^';
+    if (negated) ps->pos++;
+    int first = 1;
+    while (ps->pos < ps->len && (ps->pat[ps->pos] != ']' || first)) {
+        first = 0;
+        long lo;
+        uint32_t cp;
+        if (ps->pat[ps->pos] == '\\') {
+            ps->pos++;
+            lo = escape_char(ps, &c);
+            if (lo == -1) {
+                if (ps->pos + 1 < ps->len && ps->pat[ps->pos] == '-' && ps->pat[ps->pos + 1] != ']') {
+                    return parse_error(ps, "class escape as a range start");
+                }
+                continue;
+            }
+        } else {
+            if (next_char(ps, &cp) < 0) return -1;
+            lo = cp;
+        }
+        if (lo < 0) return -1;
+        long hi = lo;
+        if (ps->pos + 1 < ps->len && ps->pat[ps->pos] == '-' && ps->pat[ps->pos + 1] != ']') {
+            ps->pos++;
+            if (ps->pat[ps->pos] == '\\') {
+                ps->pos++;
+                hi = escape_char(ps, NULL);
+                if (hi == -1) return parse_error(ps, "class escape as a range end");
+            } else {
+                if (next_char(ps, &cp) < 0) return -1;
+                hi = cp;
+            }
+            if (hi < 0) return -1;
+            if (hi < lo) return parse_error(ps, "range out of order");
+        }
+        class_add(ps, &c, (uint32_t)lo, (uint32_t)hi);
+        if (ps->error) return -1;
+    }
+    if (ps->pos >= ps->len) return parse_error(ps, "missing ]");
+    ps->pos++;
+    return class_node(ps, &c, negated);
+}
+
+// --- Parser ---
+
+static int parse_alt(Parser* ps, int depth);
+
+static int parse_number(Parser* ps, int* out) {
+    size_t start = ps->pos;
+    long v = 0;
+    while (ps->pos < ps->len && ps->pat[ps->pos] >= '0' && ps->pat[ps->pos] <= '9') {
+        v = v * 10 + (ps->pat[ps->pos++] - '0');
+        if (v > RX_MAX_REPEAT) v = RX_MAX_REPEAT + 1;
+    }
+    *out = (int)v;
+    return ps->pos > start;
+}
+
+// {n}, {n,} or {n,m} at pos; leaves pos alone and returns 0 if the brace
+// does not start one, which then stands for itself
+static int parse_braces(Parser* ps, int* min, int* max) {
+    size_t start = ps->pos;
+    ps->pos++;
+    if (!parse_number(ps, min)) { ps->pos = start; return 0; }
+    *max = *min;
+    if (ps->pos < ps->len && ps->pat[ps->pos] == ',') {
+        ps->pos++;
+        if (!parse_number(ps, max)) *max = -1;
+    }
+    if (ps->pos >= ps->len || ps->pat[ps->pos] != '}') { ps->pos = start; return 0; }
+    ps->pos++;
+    if (*min > RX_MAX_REPEAT || *max > RX_MAX_REPEAT) return parse_error(ps, "repeat count over 1000");
+    if (*max >= 0 && *max < *min) return parse_error(ps, "repeat range out of order");
+    return 1;
+}
+
+static int parse_atom(Parser* ps, int depth) {
+    char c = ps->pat[ps->pos];
+    switch (c) {
+        case '(': {
+            ps->pos++;
+            int group = -1;
+            if (ps->pos + 1 < ps->len && ps->pat[ps->pos] == '?' && ps->pat[ps->pos + 1] == ':') {
+                ps->pos += 2;
+            } else if (ps->pos < ps->len && ps->pat[ps->pos] == '?') {
+                return parse_error(ps, "unsupported group");
+            } else {
+                if (ps->groups == RX_MAX_GROUPS) return parse_error(ps, "too many groups");
+                group = ++ps->groups;
+            }
+            int inner = parse_alt(ps, depth + 1);
+            if (ps->error) return -1;
+            if (ps->pos >= ps->len || ps->pat[ps->pos] != ')') return parse_error(ps, "missing )");
+            ps->pos++;
+            if (inner < 0) inner = new_node(ps, N_EMPTY, 0, 0);
+            return group < 0 ? inner : new_node(ps, N_GROUP, inner, group);
+        }
+        case '[':
+            ps->pos++;
+            return parse_class(ps);
+        case '.': {
+            ps->pos++;
+            ByteSet set = {{0}};
+            set_range(&set, 0, 0x7F);
+            set.bits[0] &= ~(1ULL << '\n');
+            return alt_node(ps, set_node(ps, &set), multibyte_node(ps));
+        }
+        case '^': ps->pos++; return new_node(ps, N_BOL, 0, 0);
+        case '$': ps->pos++; return new_node(ps, N_EOL, 0, 0);
+        case '*': case '+': case '?': return parse_error(ps, "nothing to repeat");
+        case '\\': {
+            ps->pos++;
+            Class cls;
+            memset(&cls, 0, sizeof(cls));
+            long v = escape_char(ps, &cls);
+            if (v == -1) return class_node(ps, &cls, 0);
+            if (v < 0) return -1;
+            return char_node(ps, (uint32_t)v);
+        }
+        default: {
+            uint32_t cp;
+            if (next_char(ps, &cp) < 0) return -1;
+            return char_node(ps, cp);
+        }
+    }
+}
+
+static int parse_repeat(Parser* ps, int depth) {
+    if (ps->pat[ps->pos] == '{') {
+        int min, max;
+        if (parse_braces(ps, &min, &max) != 0) return parse_error(ps, "nothing to repeat");
+    }
+    int atom = parse_atom(ps, depth);
+    int repeated = 0;
+    while (ps->pos < ps->len && !ps->error) {
+        int min, max;
+        char c = ps->pat[ps->pos];
+        if (c == '*') { min = 0; max = -1; ps->pos++; }
+        else if (c == '+') { min = 1; max = -1; ps->pos++; }
+        else if (c == '?') { min = 0; max = 1; ps->pos++; }
+        else if (c == '{') {
+            int found = parse_braces(ps, &min, &max);
+            if (found < 0) return -1;
+            if (!found) break;
+        } else break;
+        if (repeated++) return parse_error(ps, "multiple repeat");
+        int node = new_node(ps, N_REPEAT, atom, 0);
+        if (node < 0) return -1;
+        ps->nodes[node].min = min;
+        ps->nodes[node].max = max;
+        ps->nodes[node].greedy = 1;
+        if (ps->pos < ps->len && ps->pat[ps->pos] == '?') {
+            ps->nodes[node].greedy = 0;
+            ps->pos++;
+        }
+        atom = node;
+    }
+    return atom;
+}
+
+// Alternatives up to a ')' or the end; -1 with no error is the empty pattern
+static int parse_alt(Parser* ps, int depth) {
+    if (depth > 200) return parse_error(ps, "groups nested too deep");
+    int result = -1, have_alt = 0;
+    for (;;) {
+        int seq = -1;
+        while (ps->pos < ps->len && ps->pat[ps->pos] != '|' && ps->pat[ps->pos] != ')' && !ps->error) {
+            seq = cat_node(ps, seq, parse_repeat(ps, depth));
+        }
+        if (ps->error) return -1;
+        if (seq < 0) seq = new_node(ps, N_EMPTY, 0, 0);
+        result = have_alt ? alt_node(ps, result, seq) : seq;
+        have_alt = 1;
+        if (ps->pos >= ps->len || ps->pat[ps->pos] != '|') return result;
+        ps->pos++;
+    }
+}
+
+// --- Programs ---
+
+enum { I_BYTE, I_SPLIT, I_JMP, I_SAVE, I_BOL, I_EOL, I_MATCH };
+
+typedef struct {
+    uint8_t op;
+    int x, y;          // BYTE: set; SPLIT: preferred, other; JMP: target; SAVE: slot
+} Inst;
+
+typedef struct {
+    Inst* insts;
+    int n, cap;
+    int too_large;
+} Prog;
+
+static int emit(Prog* p, int op, int x, int y) {
+    if (p->n == RX_MAX_INSTS) {
+        p->too_large = 1;
+        return p->n - 1;
+    }
+    if (p->n == p->cap) {
+        p->cap = p->cap ? 2 * p->cap : 64;
+        p->insts = (Inst*)realloc(p->insts, sizeof(Inst) * p->cap);
+    }
+    p->insts[p->n].op = (uint8_t)op;
+    p->insts[p->n].x = x;
+    p->insts[p->n].y = y;
+    return p->n++;
+}
+
+// Points the open end of the SPLIT at pc (the one not taken first) to 'to'
+static void patch_split(Prog* p, int pc, int greedy, int to) {
+    if (p->too_large) return;
+    if (greedy) p->insts[pc].y = to;
+    else p->insts[pc].x = to;
+}
+
+// Emits node; a reversed program matches the text read backwards, so
+// sequences run last to first, ^ and $ trade places and groups are dropped
+static void compile_node(Prog* p, const Parser* ps, int id, int reverse) {
+    if (p->too_large) return;
+    const Node* n = &ps->nodes[id];
+    switch (n->type) {
+        case N_EMPTY: break;
+        case N_SET: emit(p, I_BYTE, n->a, 0); break;
+        case N_CAT:
+            compile_node(p, ps, reverse ? n->b : n->a, reverse);
+            compile_node(p, ps, reverse ? n->a : n->b, reverse);
+            break;
+        case N_ALT: {
+            int split = emit(p, I_SPLIT, p->n + 1, 0);
+            compile_node(p, ps, n->a, reverse);
+            int jmp = emit(p, I_JMP, 0, 0);
+            patch_split(p, split, 1, p->n);
+            compile_node(p, ps, n->b, reverse);
+            if (!p->too_large) p->insts[jmp].x = p->n;
+            break;
+        }
+        case N_GROUP:
+            if (!reverse) emit(p, I_SAVE, 2 * n->b, 0);
+            compile_node(p, ps, n->a, reverse);
+            if (!reverse) emit(p, I_SAVE, 2 * n->b + 1, 0);
+            break;
+        case N_BOL: emit(p, reverse ? I_EOL : I_BOL, 0, 0); break;
+        case N_EOL: emit(p, reverse ? I_BOL : I_EOL, 0, 0); break;
+        case N_REPEAT: {
+            int copies = n->max < 0 && n->min > 0 ? n->min - 1 : n->min;
+            for (int i = 0; i < copies; i++) compile_node(p, ps, n->a, reverse);
+            if (n->max < 0 && n->min > 0) {
+                // x+ : the last required copy loops back on itself
+                int body = p->n;
+                compile_node(p, ps, n->a, reverse);
+                emit(p, I_SPLIT, n->greedy ? body : p->n + 1, n->greedy ? p->n + 1 : body);
+            } else if (n->max < 0) {
+                int split = emit(p, I_SPLIT, p->n + 1, p->n + 1);
+                compile_node(p, ps, n->a, reverse);
+                emit(p, I_JMP, split, 0);
+                patch_split(p, split, n->greedy, p->n);
+            } else {
+                // x{0,k} as nested options, each skip going to the end;
+                // every copy has the same size, so the splits are evenly spaced
+                int first = p->n, k = n->max - n->min;
+                for (int i = 0; i < k; i++) {
+                    emit(p, I_SPLIT, p->n + 1, p->n + 1);
+                    compile_node(p, ps, n->a, reverse);
+                }
+                int spacing = k ? (p->n - first) / k : 0;
+                for (int i = 0; i < k; i++) patch_split(p, first + i * spacing, n->greedy, p->n);
+            }
+            break;
+        }
+    }
+}
+
+// --- Lazy DFA ---
+
+typedef struct {
+    int first, count;  // its NFA states in dfa->pcs, highest priority first
+    uint8_t match;     // a match ends before the next byte
+    int8_t end_match;  // a match ends if the text ends here; -1 until known
+} DState;
+
+typedef struct {
+    const Prog* prog;
+    const ByteSet* sets;
+    const uint8_t* classes;
+    int stride, shift; // byte classes rounded up to 1 << shift
+    int longest;       // keep threads after a match (reverse) instead of cutting them
+    int skip_start;    // searches skip ahead from start[0] (a literal prefix)
+    DState* states;
+    int n_states, cap_states;
+    int* pcs;
+    int n_pcs, cap_pcs;
+    int32_t* next;     // n_states x stride; -1 until built, else the target's row
+                       // (state x stride, saving the search loops a multiply) | RX_SPECIAL
+    int* table;        // hash of NFA state sets -> state + 1
+    int table_size;
+    int start[2];      // by whether the search begins at text start; -1 until built
+    size_t bytes;
+    int flushes;
+    // Scratch for building states
+    int* stack;
+    int* seeds;
+    int* set;
+    uint32_t* seen;
+    uint32_t generation;
+} Dfa;
+
+// Set on a cached transition to the dead state, a match state or, when
+// searches skip ahead from it, the start state: the search loops stop to
+// look at those, and run through every other cached transition with no
+// checks. -1 has it too.
+#define RX_SPECIAL 0x40000000
+
+static int dfa_state(Dfa* d, int n);
+
+// Empties the state cache; the dead state (no NFA states) is always 0
+static void dfa_flush(Dfa* d) {
+    d->n_states = 0;
+    d->n_pcs = 0;
+    d->bytes = 0;
+    d->start[0] = d->start[1] = -1;
+    memset(d->table, 0, sizeof(int) * d->table_size);
+    d->flushes++;
+    dfa_state(d, 0);
+}
+
+static void dfa_init(Dfa* d, const Prog* prog, const ByteSet* sets, const uint8_t* classes, int stride, int longest) {
+    memset(d, 0, sizeof(*d));
+    d->prog = prog;
+    d->sets = sets;
+    d->classes = classes;
+    while ((1 << d->shift) < stride) d->shift++;
+    d->stride = 1 << d->shift;
+    d->longest = longest;
+    d->stack = (int*)malloc(sizeof(int) * 2 * (prog->n + 1));
+    d->seeds = (int*)malloc(sizeof(int) * (prog->n + 1));
+    d->set = (int*)malloc(sizeof(int) * (prog->n + 1));
+    d->seen = (uint32_t*)calloc((size_t)prog->n + 1, sizeof(uint32_t));
+    d->table_size = 1024;
+    d->table = (int*)calloc((size_t)d->table_size, sizeof(int));
+    dfa_flush(d);
+    d->flushes = 0;
+}
+
+static uint32_t hash_set(const int* pcs, int n) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < n; i++) h = (h ^ (uint32_t)pcs[i]) * 16777619u;
+    return h;
+}
+
+// Adds the states reachable from seeds without reading a byte, in priority
+// order, to d->set. Assertions hold according to the flags; an unresolved
+// $ stays in the set. Unless the DFA is 'longest', nothing after a MATCH
+// is kept: those threads could only give a lower-priority match.
+static int closure(Dfa* d, const int* seeds, int n_seeds, int at_start, int at_end) {
+    const Inst* insts = d->prog->insts;
+    int n = 0;
+    if (++d->generation == 0) {
+        memset(d->seen, 0, sizeof(uint32_t) * ((size_t)d->prog->n + 1));
+        d->generation = 1;
+    }
+    for (int s = 0; s < n_seeds; s++) {
+        int top = 0;
+        d->stack[top++] = seeds[s];
+        while (top > 0) {
+            int pc = d->stack[--top];
+            if (d->seen[pc] == d->generation) continue;
+            d->seen[pc] = d->generation;
+            const Inst* in = &insts[pc];
+            switch (in->op) {
+                case I_JMP: d->stack[top++] = in->x; break;
+                case I_SPLIT: d->stack[top++] = in->y; d->stack[top++] = in->x; break;
+                case I_SAVE: d->stack[top++] = pc + 1; break;
+                case I_BOL: if (at_start) d->stack[top++] = pc + 1; break;
+                case I_EOL:
+                    if (at_end) d->stack[top++] = pc + 1;
+                    else d->set[n++] = pc;
+                    break;
+                case I_BYTE: d->set[n++] = pc; break;
+                case I_MATCH:
+                    d->set[n++] = pc;
+                    if (!d->longest) return n;
+                    break;
+            }
+        }
+    }
+    return n;
+}
+
+// The state for the n NFA states in d->set, made if new
+static int dfa_state(Dfa* d, int n) {
+    uint32_t h = hash_set(d->set, n);
+    int mask = d->table_size - 1;
+    for (int i = (int)(h & (uint32_t)mask); d->table[i]; i = (i + 1) & mask) {
+        DState* st = &d->states[d->table[i] - 1];
+        if (st->count == n && memcmp(d->pcs + st->first, d->set, sizeof(int) * n) == 0) return d->table[i] - 1;
+    }
+
+    size_t cost = sizeof(DState) + sizeof(int32_t) * d->stride + sizeof(int) * (n + 2);
+    if (d->bytes + cost > RX_DFA_BUDGET && d->n_states > 0) dfa_flush(d);
+    if (2 * (d->n_states + 1) > d->table_size) {
+        free(d->table);
+        d->table_size *= 2;
+        d->table = (int*)calloc((size_t)d->table_size, sizeof(int));
+        mask = d->table_size - 1;
+        for (int s = 0; s < d->n_states; s++) {
+            DState* st = &d->states[s];
+            int i = (int)(hash_set(d->pcs + st->first, st->count) & (uint32_t)mask);
+            while (d->table[i]) i = (i + 1) & mask;
+            d->table[i] = s + 1;
+        }
+    }
+    if (d->n_states == d->cap_states) {
+        d->cap_states = d->cap_states ? 2 * d->cap_states : 64;
+        d->states = (DState*)realloc(d->states, sizeof(DState) * d->cap_states);
+        d->next = (int32_t*)realloc(d->next, sizeof(int32_t) * d->stride * d->cap_states);
+    }
+    if (d->n_pcs + n > d->cap_pcs) {
+        while (d->n_pcs + n > d->cap_pcs) d->cap_pcs = d->cap_pcs ? 2 * d->cap_pcs : 256;
+        d->pcs = (int*)realloc(d->pcs, sizeof(int) * d->cap_pcs);
+    }
+
+    int id = d->n_states++;
+    DState* st = &d->states[id];
+    st->first = d->n_pcs;
+    st->count = n;
+    st->match = 0;
+    st->end_match = -1;
+    for (int i = 0; i < n; i++) {
+        if (d->prog->insts[d->set[i]].op == I_MATCH) st->match = 1;
+    }
+    if (n) memcpy(d->pcs + d->n_pcs, d->set, sizeof(int) * n);
+    d->n_pcs += n;
+    memset(d->next + (size_t)id * d->stride, 0xFF, sizeof(int32_t) * d->stride);
+    int i = (int)(h & (uint32_t)mask);
+    while (d->table[i]) i = (i + 1) & mask;
+    d->table[i] = id + 1;
+    d->bytes += cost;
+    return id;
+}
+
+static int dfa_start(Dfa* d, int at_start) {
+    if (d->start[at_start] < 0) {
+        int entry = 0, existing = d->n_states, flushes = d->flushes;
+        int n = closure(d, &entry, 1, at_start, 0);
+        int id = dfa_state(d, n);
+        d->start[at_start] = id;
+        if (!at_start && d->skip_start && id < existing && d->flushes == flushes) {
+            // Transitions to it were cached before it was the start state
+            size_t cells = (size_t)d->n_states * d->stride;
+            for (size_t c = 0; c < cells; c++) {
+                if (d->next[c] == id * d->stride) d->next[c] |= RX_SPECIAL;
+            }
+        }
+    }
+    return d->start[at_start];
+}
+
+// State after reading byte b in state s. If the cache was emptied to make
+// room, ids from before are gone and the caller must refresh any it holds.
+static int dfa_step(Dfa* d, int s, uint8_t b) {
+    const DState* st = &d->states[s];
+    const Inst* insts = d->prog->insts;
+    int n_seeds = 0;
+    for (int i = 0; i < st->count; i++) {
+        int pc = d->pcs[st->first + i];
+        if (insts[pc].op == I_BYTE && set_has(&d->sets[insts[pc].x], b)) d->seeds[n_seeds++] = pc + 1;
+    }
+    int flushes = d->flushes;
+    int t = dfa_state(d, closure(d, d->seeds, n_seeds, 0, 0));
+    if (d->flushes == flushes) {
+        int special = t == 0 || d->states[t].match || (d->skip_start && t == d->start[0]);
+        d->next[(size_t)s * d->stride + d->classes[b]] = t * d->stride | (special ? RX_SPECIAL : 0);
+    }
+    return t;
+}
+
+// Whether a match ends at the end of the text in state s: its pending $
+// assertions now hold
+static int dfa_end_match(Dfa* d, int s) {
+    DState* st = &d->states[s];
+    if (st->end_match < 0) {
+        int n_seeds = 0, match = st->match;
+        for (int i = 0; i < st->count; i++) {
+            int pc = d->pcs[st->first + i];
+            if (d->prog->insts[pc].op == I_EOL) d->seeds[n_seeds++] = pc + 1;
+        }
+        int n = closure(d, d->seeds, n_seeds, 0, 1);
+        for (int i = 0; i < n && !match; i++) match = d->prog->insts[d->set[i]].op == I_MATCH;
+        st->end_match = (int8_t)match;
+    }
+    return d->states[s].end_match;
+}
+
+// --- Compiled Patterns ---
+
+// Pike VM threads in priority order, as a sparse set over instructions
+typedef struct {
+    int* dense;
+    int* sparse;
+    int n;
+    long long* caps;   // group offsets of the thread at each instruction
+} Threads;
+
+typedef struct {
+    int pc;            // < 0: put old back in caps[slot]
+    int slot;
+    long long old;
+} PikeJob;
+
+typedef struct Regex {
+    char* pattern;
+    uint32_t length, hash;
+    struct Regex* chain;
+    Prog fwd;          // an unanchored loop, then the pattern from fwd_main
+    Prog rev;
+    int fwd_main;
+    int groups;
+    int n_caps;        // 2 per group, with the whole match as group 0
+    ByteSet* sets;
+    uint8_t classes[256];
+    char prefix[RX_MAX_PREFIX];
+    size_t prefix_len;
+    int literal;       // the pattern is just its prefix
+    uint8_t first[256];  // without a prefix, the bytes that can begin a match
+    int first_count;   // 0 to not skip by them
+    uint8_t first_byte;
+    Dfa dfa, rdfa;
+    Threads threads[2];
+    PikeJob* jobs;
+    long long* caps;
+    pthread_mutex_t lock;
+} Regex;
+
+// Bytes no set tells apart share a class, so a DFA row has one column per
+// class rather than 256
+static int byte_classes(const ByteSet* sets, int n_sets, uint8_t* classes) {
+    int cls = 0;
+    classes[0] = 0;
+    for (int b = 1; b < 256; b++) {
+        for (int i = 0; i < n_sets; i++) {
+            if (set_has(&sets[i], (unsigned)b) != set_has(&sets[i], (unsigned)b - 1)) {
+                cls++;
+                break;
+            }
+        }
+        classes[b] = (uint8_t)cls;
+    }
+    return cls + 1;
+}
+
+// Appends the bytes every match of the node starts with; returns 1 when
+// the node is exactly those bytes, so that what follows it extends them
+static int literal_prefix(const Parser* ps, int id, char* out, size_t* len) {
+    const Node* n = &ps->nodes[id];
+    switch (n->type) {
+        case N_EMPTY: return 1;
+        case N_SET: {
+            const ByteSet* set = &ps->sets[n->a];
+            int count = 0, byte = 0;
+            for (int i = 0; i < 4; i++) {
+                if (set->bits[i]) byte = i * 64 + __builtin_ctzll(set->bits[i]);
+                count += __builtin_popcountll(set->bits[i]);
+            }
+            if (count != 1 || *len == RX_MAX_PREFIX) return 0;
+            out[(*len)++] = (char)byte;
+            return 1;
+        }
+        case N_CAT: return literal_prefix(ps, n->a, out, len) && literal_prefix(ps, n->b, out, len);
+        case N_GROUP: return literal_prefix(ps, n->a, out, len);
+        case N_REPEAT:
+            if (n->min > 0) literal_prefix(ps, n->a, out, len);
+            return 0;
+        default: return 0;
+    }
+}
+
+// Bytes that can begin a match away from the text start, if there are at
+// most RX_MAX_FIRST; none if a match can be empty there
+static void first_bytes(Regex* re) {
+    Dfa* d = &re->dfa;
+    int n = closure(d, &re->fwd_main, 1, 0, 0);
+    ByteSet first = {{0}};
+    for (int i = 0; i < n; i++) {
+        const Inst* in = &re->fwd.insts[d->set[i]];
+        if (in->op != I_BYTE) return;   // MATCH or a pending $
+        for (int w = 0; w < 4; w++) first.bits[w] |= re->sets[in->x].bits[w];
+    }
+    int count = 0;
+    for (int b = 0; b < 256; b++) {
+        re->first[b] = (uint8_t)set_has(&first, (unsigned)b);
+        if (re->first[b]) {
+            re->first_byte = (uint8_t)b;
+            count++;
+        }
+    }
+    re->first_count = count <= RX_MAX_FIRST ? count : 0;
+}
+
+static Regex* regex_build(const char* pattern, uint32_t len, const char** error, size_t* error_at) {
+    Parser ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.pat = pattern;
+    ps.len = len;
+    if (len >= 4 && memcmp(pattern, "(?i)", 4) == 0) {
+        ps.icase = 1;
+        ps.pos = 4;
+    }
+    int root = parse_alt(&ps, 0);
+    if (!ps.error && ps.pos < ps.len) parse_error(&ps, "unmatched )");
+    if (!ps.error && root < 0) root = new_node(&ps, N_EMPTY, 0, 0);
+    int any = 0;
+    if (!ps.error) {
+        int node = byte_node(&ps, 0, 255);   // may move ps.nodes
+        any = ps.nodes[node].a;
+    }
+
+    Regex* re = (Regex*)calloc(1, sizeof(Regex));
+    if (!ps.error) {
+        // (?s:.)*? ahead of the pattern, preferring the pattern: a match
+        // starting earlier outranks any starting later
+        Prog* f = &re->fwd;
+        emit(f, I_SPLIT, 3, 1);
+        emit(f, I_BYTE, any, 0);
+        emit(f, I_JMP, 0, 0);
+        re->fwd_main = f->n;
+        emit(f, I_SAVE, 0, 0);
+        compile_node(f, &ps, root, 0);
+        emit(f, I_SAVE, 1, 0);
+        emit(f, I_MATCH, 0, 0);
+        compile_node(&re->rev, &ps, root, 1);
+        emit(&re->rev, I_MATCH, 0, 0);
+        if (f->too_large || re->rev.too_large) {
+            ps.pos = 0;
+            parse_error(&ps, "pattern too large");
+        }
+    }
+    if (ps.error) {
+        *error = ps.error;
+        *error_at = ps.error_at;
+        free(ps.nodes);
+        free(ps.sets);
+        free(re->fwd.insts);
+        free(re->rev.insts);
+        free(re);
+        return NULL;
+    }
+
+    re->pattern = (char*)malloc((size_t)len + 1);
+    memcpy(re->pattern, pattern, len);
+    re->pattern[len] = '\0';
+    re->length = len;
+    re->groups = ps.groups;
+    re->n_caps = 2 * (ps.groups + 1);
+    re->literal = literal_prefix(&ps, root, re->prefix, &re->prefix_len) && ps.groups == 0 && re->prefix_len > 0;
+    re->sets = ps.sets;
+    int n_classes = byte_classes(re->sets, ps.n_sets, re->classes);
+    dfa_init(&re->dfa, &re->fwd, re->sets, re->classes, n_classes, 0);
+    if (!re->prefix_len) first_bytes(re);
+    re->dfa.skip_start = re->prefix_len > 0 || re->first_count > 0;
+    dfa_init(&re->rdfa, &re->rev, re->sets, re->classes, n_classes, 1);
+    pthread_mutex_init(&re->lock, NULL);
+    free(ps.nodes);
+    return re;
+}
+
+// --- Searching ---
+
+// First offset from i that can begin a match, or n
+static size_t skip_to_first(const Regex* re, const uint8_t* s, size_t i, size_t n) {
+    if (re->first_count == 1) {
+        const uint8_t* p = (const uint8_t*)memchr(s + i, re->first_byte, n - i);
+        return p ? (size_t)(p - s) : n;
+    }
+    while (i < n && !re->first[s[i]]) i++;
+    return i;
+}
+
+// End of the leftmost-first match in text[from..n), or -1. With 'any' it
+// stops as soon as some match is certain, which may be before that end.
+static long long search_end(Regex* re, const char* text, size_t n, size_t from, int any) {
+    Dfa* d = &re->dfa;
+    const uint8_t* s = (const uint8_t*)text;
+    int state = dfa_start(d, from == 0);
+    // Just after the cache is emptied it has room for the restart state
+    if (d->skip_start && d->start[0] < 0) dfa_start(d, 0);
+    long long end = -1;
+    size_t i = from;
+    for (;;) {
+        if (d->states[state].match) {
+            end = (long long)i;
+            if (any) break;
+        }
+        if (i == n) {
+            if (dfa_end_match(d, state)) end = (long long)n;
+            break;
+        }
+        if (state == d->start[0] && d->skip_start) {
+            // Nothing in progress: the next match starts at the prefix, or
+            // at least at a byte that can begin one
+            if (re->prefix_len) {
+                long long k = aria_str_find(text + i, n - i, re->prefix, re->prefix_len);
+                if (k < 0) break;
+                i += (size_t)k;
+            } else {
+                i = skip_to_first(re, s, i, n);
+                if (i == n) break;
+            }
+        }
+        int t = d->next[(size_t)state * d->stride + re->classes[s[i]]];
+        i++;
+        if (t < 0 || (t & RX_SPECIAL)) {
+            if (t < 0) {
+                state = dfa_step(d, state, s[i - 1]);
+                if (d->skip_start && d->start[0] < 0) dfa_start(d, 0);
+            } else {
+                state = (t & ~RX_SPECIAL) >> d->shift;
+            }
+            if (state == 0) break;
+            continue;
+        }
+        // Cached steps between ordinary states need none of the checks above
+        const int32_t* next = d->next;
+        const uint8_t* classes = re->classes;
+        size_t row = (size_t)t;
+        while (i < n) {
+            int32_t u = next[row + classes[s[i]]];
+            if (u & RX_SPECIAL) break;
+            row = (size_t)u;
+            i++;
+        }
+        state = (int)(row >> d->shift);
+    }
+    return end;
+}
+
+// Start of the match ending at 'end', reading back no further than 'from'
+static size_t search_start(Regex* re, const char* text, size_t n, size_t from, size_t end) {
+    Dfa* d = &re->rdfa;
+    const uint8_t* s = (const uint8_t*)text;
+    int state = dfa_start(d, end == n);
+    size_t start = end, i = end;
+    for (;;) {
+        if (d->states[state].match) start = i;
+        if (i == from) {
+            if (from == 0 && dfa_end_match(d, state)) start = 0;
+            break;
+        }
+        i--;
+        int t = d->next[(size_t)state * d->stride + re->classes[s[i]]];
+        if (t < 0 || (t & RX_SPECIAL)) {
+            state = t < 0 ? dfa_step(d, state, s[i]) : (t & ~RX_SPECIAL) >> d->shift;
+            if (state == 0) break;
+            continue;
+        }
+        const int32_t* next = d->next;
+        const uint8_t* classes = re->classes;
+        size_t row = (size_t)t;
+        while (i > from) {
+            int32_t u = next[row + classes[s[i - 1]]];
+            if (u & RX_SPECIAL) break;
+            row = (size_t)u;
+            i--;
+        }
+        state = (int)(row >> d->shift);
+    }
+    return start;
+}
+
+static int in_threads(const Threads* l, int pc) {
+    return l->sparse[pc] < l->n && l->dense[l->sparse[pc]] == pc;
+}
+
+// Adds the thread at pc, and those it leads to without reading a byte, to
+// l; caps is the thread's group offsets, changed on the way and restored
+static void add_thread(Regex* re, Threads* l, int pc0, size_t pos, size_t n, long long* caps) {
+    PikeJob* stack = re->jobs;
+    int top = 0;
+    stack[top++] = (PikeJob){ pc0, 0, 0 };
+    while (top > 0) {
+        PikeJob job = stack[--top];
+        if (job.pc < 0) {
+            caps[job.slot] = job.old;
+            continue;
+        }
+        int pc = job.pc;
+        while (!in_threads(l, pc)) {
+            l->sparse[pc] = l->n;
+            l->dense[l->n++] = pc;
+            const Inst* in = &re->fwd.insts[pc];
+            if (in->op == I_JMP) { pc = in->x; continue; }
+            if (in->op == I_SPLIT) {
+                stack[top++] = (PikeJob){ in->y, 0, 0 };
+                pc = in->x;
+                continue;
+            }
+            if (in->op == I_SAVE) {
+                stack[top++] = (PikeJob){ -1, in->x, caps[in->x] };
+                caps[in->x] = (long long)pos;
+                pc++;
+                continue;
+            }
+            if (in->op == I_BOL) { if (pos != 0) break; pc++; continue; }
+            if (in->op == I_EOL) { if (pos != n) break; pc++; continue; }
+            memcpy(l->caps + (size_t)pc * re->n_caps, caps, sizeof(long long) * re->n_caps);
+            break;
+        }
+    }
+}
+
+// Group offsets of the match the DFAs found at text[start..end), from a
+// Pike VM run over that span alone; -1 where a group took no part
+static void place_groups(Regex* re, const char* text, size_t n, size_t start, size_t end, long long* out) {
+    if (!re->jobs) {
+        size_t insts = (size_t)re->fwd.n;
+        for (int k = 0; k < 2; k++) {
+            re->threads[k].dense = (int*)malloc(sizeof(int) * insts);
+            re->threads[k].sparse = (int*)calloc(insts, sizeof(int));
+            re->threads[k].caps = (long long*)malloc(sizeof(long long) * insts * re->n_caps);
+        }
+        re->jobs = (PikeJob*)malloc(sizeof(PikeJob) * (2 * insts + 2));
+        re->caps = (long long*)malloc(sizeof(long long) * re->n_caps);
+    }
+    Threads* cur = &re->threads[0];
+    Threads* nxt = &re->threads[1];
+    for (int k = 0; k < re->n_caps; k++) re->caps[k] = -1;
+    for (int k = 0; k < re->n_caps; k++) out[k] = -1;
+    cur->n = 0;
+    add_thread(re, cur, re->fwd_main, start, n, re->caps);
+    for (size_t pos = start; cur->n > 0; pos++) {
+        nxt->n = 0;
+        for (int t = 0; t < cur->n; t++) {
+            int pc = cur->dense[t];
+            const Inst* in = &re->fwd.insts[pc];
+            long long* caps = cur->caps + (size_t)pc * re->n_caps;
+            if (in->op == I_MATCH) {
+                // Threads after this one could only give lower-priority matches
+                memcpy(out, caps, sizeof(long long) * re->n_caps);
+                break;
+            }
+            if (in->op == I_BYTE && pos < end && set_has(&re->sets[in->x], (uint8_t)text[pos])) {
+                add_thread(re, nxt, pc + 1, pos + 1, n, caps);
+            }
+        }
+        Threads* swap = cur;
+        cur = nxt;
+        nxt = swap;
+    }
+}
+
+// The next match in text[from..n): its span, and with caps its groups
+static int next_match(Regex* re, const char* text, size_t n, size_t from, long long* caps, size_t* start, size_t* end) {
+    if (re->literal) {
+        long long k = aria_str_find(text + from, n - from, re->prefix, re->prefix_len);
+        if (k < 0) return 0;
+        *start = from + (size_t)k;
+        *end = *start + re->prefix_len;
+    } else {
+        long long e = search_end(re, text, n, from, 0);
+        if (e < 0) return 0;
+        *end = (size_t)e;
+        *start = search_start(re, text, n, from, *end);
+    }
+    if (caps && re->groups > 0) {
+        place_groups(re, text, n, *start, *end, caps);
+    } else if (caps) {
+        caps[0] = (long long)*start;
+        caps[1] = (long long)*end;
+    }
+    return 1;
+}
+
+// Group offsets of up to 'limit' matches (0 for all) left to right, each
+// n_caps wide, or only the whole match when !groups. After an empty match
+// the search resumes one character on.
+static size_t collect_matches(Regex* re, const char* text, size_t n, size_t limit, int groups, long long** out) {
+    int width = groups ? re->n_caps : 2;
+    size_t count = 0, cap = 16, at = 0, start, end;
+    long long* all = (long long*)malloc(sizeof(long long) * width * cap);
+    long long* caps = (long long*)malloc(sizeof(long long) * re->n_caps);
+    pthread_mutex_lock(&re->lock);
+    while (at <= n && (limit == 0 || count < limit) && next_match(re, text, n, at, groups ? caps : NULL, &start, &end)) {
+        if (count == cap) {
+            cap *= 2;
+            all = (long long*)realloc(all, sizeof(long long) * width * cap);
+        }
+        if (groups) memcpy(all + count * width, caps, sizeof(long long) * width);
+        else {
+            all[count * 2] = (long long)start;
+            all[count * 2 + 1] = (long long)end;
+        }
+        count++;
+        if (end > start) at = end;
+        else if (end == n) break;
+        else {
+            uint8_t c = (uint8_t)text[end];
+            at = end + (c < 0xC0 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4);
+        }
+    }
+    pthread_mutex_unlock(&re->lock);
+    free(caps);
+    *out = all;
+    return count;
+}
+
+// --- Pattern Table ---
+// Every pattern compiled so far, by its text
+
+static pthread_mutex_t patterns_lock = PTHREAD_MUTEX_INITIALIZER;
+static Regex** patterns;
+static size_t patterns_size, patterns_count;
+
+static Regex* regex_lookup(const char* pattern) {
+    uint32_t len = pattern ? aria_str_length(pattern) : 0;
+    uint32_t hash = pattern ? aria_str_hash(pattern) : 0;
+    if (!pattern) pattern = "";
+    pthread_mutex_lock(&patterns_lock);
+    if (patterns_size) {
+        for (Regex* re = patterns[hash & (patterns_size - 1)]; re; re = re->chain) {
+            if (re->hash == hash && re->length == len && memcmp(re->pattern, pattern, len) == 0) {
+                pthread_mutex_unlock(&patterns_lock);
+                return re;
+            }
+        }
+    }
+    const char* error = NULL;
+    size_t error_at = 0;
+    Regex* re = regex_build(pattern, len, &error, &error_at);
+    if (!re) {
+        pthread_mutex_unlock(&patterns_lock);
+        fprintf(stderr, "Regex Error: %s at offset %zu in /%s/\n", error, error_at, pattern);
+        return NULL;
+    }
+    re->hash = hash;
+    if (patterns_count + 1 > patterns_size / 2) {
+        size_t size = patterns_size ? 2 * patterns_size : 64;
+        Regex** grown = (Regex**)calloc(size, sizeof(Regex*));
+        for (size_t i = 0; i < patterns_size; i++) {
+            for (Regex* r = patterns[i]; r; ) {
+                Regex* next = r->chain;
+                r->chain = grown[r->hash & (size - 1)];
+                grown[r->hash & (size - 1)] = r;
+                r = next;
+            }
+        }
+        free(patterns);
+        patterns = grown;
+        patterns_size = size;
+    }
+    re->chain = patterns[hash & (patterns_size - 1)];
+    patterns[hash & (patterns_size - 1)] = re;
+    patterns_count++;
+    pthread_mutex_unlock(&patterns_lock);
+    return re;
+}
+
+// A regex from regex_compile, or pattern text compiled here
+static Regex* regex_arg(Value re) {
+    if (re == 0 || re == TAG_NULL) return NULL;
+    if ((re & ~PTR_MASK) == 0) return (Regex*)(uintptr_t)re;
+    return regex_lookup(unbox_ptr(re));
+}
+
+static const char* text_arg(Value s, size_t* len) {
+    const char* text = unbox_ptr(s);
+    if (!text) {
+        *len = 0;
+        return "";
+    }
+    *len = aria_str_length(text);
+    return text;
+}
+
+// --- Aria API ---
+
+// regex_compile(pattern) -> regex, or null (with a message) if it is invalid
+void* regex_compile(void* pattern_tagged) {
+    Regex* re = regex_lookup(unbox_ptr((Value)pattern_tagged));
+    return re ? (void*)re : (void*)TAG_NULL;
+}
+
+// regex_match(re, s) -> whether re matches anywhere in s
+void* regex_match(void* re_tagged, void* s_tagged) {
+    Regex* re = regex_arg((Value)re_tagged);
+    if (!re) return (void*)TAG_FALSE;
+    size_t n;
+    const char* text = text_arg((Value)s_tagged, &n);
+    long long found;
+    if (re->literal) {
+        found = aria_str_find(text, n, re->prefix, re->prefix_len);
+    } else {
+        pthread_mutex_lock(&re->lock);
+        found = search_end(re, text, n, 0, 1);
+        pthread_mutex_unlock(&re->lock);
+    }
+    return (void*)(found >= 0 ? TAG_TRUE : TAG_FALSE);
+}
+
+// regex_find(re, s) -> [match, group 1, group 2, ...] for the first match,
+// or null; a group that took no part in the match is null
+void* regex_find(void* re_tagged, void* s_tagged) {
+    Regex* re = regex_arg((Value)re_tagged);
+    if (!re) return (void*)TAG_NULL;
+    size_t n;
+    const char* text = text_arg((Value)s_tagged, &n);
+    long long* caps;
+    if (!collect_matches(re, text, n, 1, 1, &caps)) {
+        free(caps);
+        return (void*)TAG_NULL;
+    }
+    void* parts = list_new_sized(re->groups + 1);
+    for (int g = 0; g <= re->groups; g++) {
+        long long a = caps[2 * g], b = caps[2 * g + 1];
+        list_push(parts, a < 0 ? (void*)TAG_NULL : aria_str_box_n(text + a, (size_t)(b - a)));
+    }
+    free(caps);
+    return parts;
+}
+
+// regex_find_all(re, s) -> list of every match, left to right, not overlapping
+void* regex_find_all(void* re_tagged, void* s_tagged) {
+    Regex* re = regex_arg((Value)re_tagged);
+    size_t n;
+    const char* text = text_arg((Value)s_tagged, &n);
+    long long* spans = NULL;
+    size_t count = re ? collect_matches(re, text, n, 0, 0, &spans) : 0;
+    void* list = list_new_sized((long long)count);
+    for (size_t i = 0; i < count; i++) {
+        list_push(list, aria_str_box_n(text + spans[2 * i], (size_t)(spans[2 * i + 1] - spans[2 * i])));
+    }
+    free(spans);
+    return list;
+}
+
+// regex_replace(re, s, with) -> s with every match replaced by 'with', in
+// which $0 to $9 and ${n} stand for the match and its groups and $$ for $
+void* regex_replace(void* re_tagged, void* s_tagged, void* with_tagged) {
+    Regex* re = regex_arg((Value)re_tagged);
+    size_t n, with_len;
+    const char* text = text_arg((Value)s_tagged, &n);
+    const char* with = text_arg((Value)with_tagged, &with_len);
+    int groups = re && memchr(with, '$', with_len) != NULL;
+    long long* caps = NULL;
+    size_t count = re ? collect_matches(re, text, n, 0, groups, &caps) : 0;
+    int width = groups ? re->n_caps : 2;
+
+    void* sink = aria_fmt_new((long long)(n + count * with_len));
+    size_t at = 0;
+    for (size_t i = 0; i < count; i++) {
+        const long long* m = caps + i * width;
+        aria_fmt_text(sink, text + at, m[0] - (long long)at);
+        for (size_t k = 0; k < with_len; k++) {
+            size_t run = k;
+            while (run < with_len && (!groups || with[run] != '$')) run++;
+            aria_fmt_text(sink, with + k, (long long)(run - k));
+            k = run;
+            if (k >= with_len) break;
+            // with[k] is '$'
+            long g = -1;
+            size_t next = k + 1;
+            if (next < with_len && with[next] == '$') {
+                aria_fmt_text(sink, "$", 1);
+                k = next;
+                continue;
+            }
+            if (next < with_len && with[next] >= '0' && with[next] <= '9') {
+                g = with[next] - '0';
+                k = next;
+            } else if (next < with_len && with[next] == '{') {
+                size_t close = next + 1;
+                long v = 0;
+                while (close < with_len && with[close] >= '0' && with[close] <= '9' && v <= RX_MAX_GROUPS) v = v * 10 + (with[close++] - '0');
+                if (close < with_len && with[close] == '}' && close > next + 1) {
+                    g = v;
+                    k = close;
+                }
+            }
+            if (g < 0) aria_fmt_text(sink, "$", 1);
+            else if (g <= re->groups && m[2 * g] >= 0) aria_fmt_text(sink, text + m[2 * g], m[2 * g + 1] - m[2 * g]);
+        }
+        at = (size_t)m[1];
+    }
+    aria_fmt_text(sink, text + at, (long long)(n - at));
+    free(caps);
+    return aria_fmt_finish(sink);
+}
@@ -8,7 +8,7 @@
 
 // --- Runtime Imports ---
 typedef uint64_t Value;
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 
 // --- Audio Constants ---
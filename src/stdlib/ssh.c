@@ -6,16 +6,20 @@
 #include <stdint.h>
 
 extern void* aria_alloc(size_t size);
+
+// Length-prefixed strings (string_utils.c)
+extern char* aria_str_alloc(size_t len);
+extern void* aria_str_box(const char* c_str);
 typedef uint64_t Value;
 #define TAG_OBJECT (0xFFF8000000000000ULL | 6ULL)
 #define TAG_STRING (0xFFF8000000000000ULL | 5ULL)
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 #define PTR_MASK 0x0000FFFFFFFFFFFFULL
 
 static inline Value box_ptr(void* p, uint64_t t) { return t | (uintptr_t)p; }
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 
 void* ssh_connect_sess(void* host_t, void* user_t, void* port_t) {
     char* host = unbox_str((Value)host_t);
@@ -69,12 +73,12 @@ void* ssh_run(void* sess_t, void* cmd_t) {
     ssh_channel_free(ch);
     
     if (n > 0) {
-        char* r = aria_alloc(n+1);
+        char* r = aria_str_alloc(n);
         memcpy(r, buf, n);
         r[n] = 0;
         return (void*)box_ptr(r, TAG_STRING);
     }
-    return (void*)box_ptr("", TAG_STRING);
+    return aria_str_box("");
 }
 
 void ssh_disconnect_sess(void* sess_t) {
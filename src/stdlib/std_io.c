@@ -6,7 +6,7 @@
 typedef uint64_t Value;
 #define TAG_STRING (0xFFF8000000000000ULL | 5ULL)
 #define PTR_MASK 0x0000FFFFFFFFFFFFULL
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
 
 void io_print(void* s_t) {
     char* s = unbox_str((Value)s_t);
@@ -10,8 +10,10 @@ typedef uint64_t Value;
 #define TAG_STRING (0xFFF8000000000000ULL | 5ULL)
 
 extern void* aria_alloc(size_t size);
-static inline Value box_str(char* s) { return TAG_STRING | (uintptr_t)s; }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
+// Copies into a length-prefixed string (string_utils.c)
+extern void* aria_str_box(const char* c_str);
+static inline Value box_str(const char* s) { return (Value)aria_str_box(s); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
 
 // Standard error: normal standard error
 void err_print(void* s_t) {
@@ -27,9 +29,7 @@ void* data_in() {
     if (n < 0) n = 0; // If FD 3 isn't open, just return empty
     buffer[n] = '\0';
     
-    char* res = aria_alloc(n + 1);
-    memcpy(res, buffer, n + 1);
-    return (void*)box_str(res);
+    return (void*)box_str(buffer);
 }
 
 // Standard dataOut: a separate output path for data (FD 4)
@@ -0,0 +1,321 @@
+/*
+ * Aria String Kernels
+ *
+ * Byte-level search and case folding behind the str_* functions in
+ * string_utils.c: find, find-any-of, count and ASCII upper/lower. Each
+ * kernel has a scalar version, an SSE4.2 version (16 bytes per step,
+ * PCMPESTRI for small byte sets) and an AVX2 version (32 bytes per step).
+ * The widest set the CPU reports through cpuid is chosen once at startup;
+ * ARIA_STR_KERNELS=scalar|sse4.2|avx2 caps it, for benchmarks and for
+ * checking that every level gives the same answers.
+ *
+ * Substring search compares the first and last needle bytes at every
+ * position of a block and only calls memcmp where both match. Byte sets
+ * are matched with two nibble lookups (PSHUFB), which handles any set in
+ * constant time per block. Vector loads never read past the end of the
+ * text; the tail is finished by the scalar code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STR_KERNELS_X86 1
+#endif
+
+typedef struct {
+    const char* name;
+    long long (*find)(const char* s, size_t n, const char* needle, size_t m);
+    long long (*find_any)(const char* s, size_t n, const char* set, size_t k);
+    size_t (*count_byte)(const char* s, size_t n, char c);
+    void (*fold)(char* dst, const char* src, size_t n, int upper);
+} StrKernels;
+
+// --- Scalar ---
+
+static long long find_scalar(const char* s, size_t n, const char* needle, size_t m) {
+    if (m == 0) return 0;
+    if (m > n) return -1;
+    for (size_t i = 0; i + m <= n; i++) {
+        if (s[i] == needle[0] && memcmp(s + i + 1, needle + 1, m - 1) == 0) return (long long)i;
+    }
+    return -1;
+}
+
+static void set_table(uint8_t table[256], const char* set, size_t k) {
+    memset(table, 0, 256);
+    for (size_t i = 0; i < k; i++) table[(uint8_t)set[i]] = 1;
+}
+
+static long long find_any_scalar(const char* s, size_t n, const char* set, size_t k) {
+    uint8_t table[256];
+    set_table(table, set, k);
+    for (size_t i = 0; i < n; i++) {
+        if (table[(uint8_t)s[i]]) return (long long)i;
+    }
+    return -1;
+}
+
+static size_t count_byte_scalar(const char* s, size_t n, char c) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) count += s[i] == c;
+    return count;
+}
+
+// ASCII only: bytes outside A-Z / a-z are copied unchanged
+static void fold_scalar(char* dst, const char* src, size_t n, int upper) {
+    char lo = upper ? 'a' : 'A';
+    for (size_t i = 0; i < n; i++) {
+        char c = src[i];
+        dst[i] = (unsigned char)(c - lo) < 26 ? (char)(c ^ 0x20) : c;
+    }
+}
+
+static const StrKernels SCALAR_KERNELS = {
+    "scalar", find_scalar, find_any_scalar, count_byte_scalar, fold_scalar
+};
+
+#ifdef STR_KERNELS_X86
+
+// Nibble tables for a byte set: row[lo] has bit (hi & 7) set for each member
+// hi:lo, in 'low' for hi < 8 and in 'high' otherwise
+typedef struct {
+    uint8_t low[16];
+    uint8_t high[16];
+} NibbleSet;
+
+static void nibble_set(NibbleSet* t, const char* set, size_t k) {
+    memset(t, 0, sizeof(*t));
+    for (size_t i = 0; i < k; i++) {
+        uint8_t c = (uint8_t)set[i];
+        if (c < 0x80) t->low[c & 15] |= (uint8_t)(1 << (c >> 4));
+        else t->high[c & 15] |= (uint8_t)(1 << ((c >> 4) - 8));
+    }
+}
+
+static const uint8_t NIBBLE_BITS[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+
+// --- SSE4.2 ---
+
+__attribute__((target("sse4.2")))
+static long long find_sse42(const char* s, size_t n, const char* needle, size_t m) {
+    if (m == 0) return 0;
+    if (m > n) return -1;
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + i + m - 1));
+        uint32_t hits = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (hits) {
+            size_t at = i + (size_t)__builtin_ctz(hits);
+            if (m <= 2 || memcmp(s + at + 1, needle + 1, m - 2) == 0) return (long long)at;
+            hits &= hits - 1;
+        }
+    }
+    long long rest = find_scalar(s + i, n - i, needle, m);
+    return rest < 0 ? -1 : (long long)i + rest;
+}
+
+__attribute__((target("sse4.2")))
+static long long find_any_sse42(const char* s, size_t n, const char* set, size_t k) {
+    size_t i = 0;
+    if (k == 0) return -1;
+    if (k <= 16) {
+        char buf[16] = {0};
+        memcpy(buf, set, k);
+        const __m128i members = _mm_loadu_si128((const __m128i*)buf);
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+            int at = _mm_cmpestri(members, (int)k, v, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY);
+            if (at < 16) return (long long)(i + at);
+        }
+    } else {
+        NibbleSet t;
+        nibble_set(&t, set, k);
+        const __m128i low = _mm_loadu_si128((const __m128i*)t.low);
+        const __m128i high = _mm_loadu_si128((const __m128i*)t.high);
+        const __m128i bits = _mm_loadu_si128((const __m128i*)NIBBLE_BITS);
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+            __m128i lo = _mm_and_si128(v, nibble);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+            __m128i row = _mm_blendv_epi8(_mm_shuffle_epi8(low, lo), _mm_shuffle_epi8(high, lo), v);
+            __m128i bit = _mm_shuffle_epi8(bits, hi);
+            uint32_t hits = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit));
+            if (hits) return (long long)(i + __builtin_ctz(hits));
+        }
+    }
+    long long rest = find_any_scalar(s + i, n - i, set, k);
+    return rest < 0 ? -1 : (long long)i + rest;
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static size_t count_byte_sse42(const char* s, size_t n, char c) {
+    const __m128i target = _mm_set1_epi8(c);
+    size_t count = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        count += (size_t)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, target)));
+    }
+    return count + count_byte_scalar(s + i, n - i, c);
+}
+
+__attribute__((target("sse4.2")))
+static void fold_sse42(char* dst, const char* src, size_t n, int upper) {
+    // Signed compares: bytes >= 0x80 are negative and never in range
+    const __m128i below = _mm_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    const __m128i above = _mm_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    const __m128i flip = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i in = _mm_and_si128(_mm_cmpgt_epi8(v, below), _mm_cmplt_epi8(v, above));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, _mm_and_si128(in, flip)));
+    }
+    fold_scalar(dst + i, src + i, n - i, upper);
+}
+
+static const StrKernels SSE42_KERNELS = {
+    "sse4.2", find_sse42, find_any_sse42, count_byte_sse42, fold_sse42
+};
+
+// --- AVX2 ---
+
+__attribute__((target("avx2")))
+static long long find_avx2(const char* s, size_t n, const char* needle, size_t m) {
+    if (m == 0) return 0;
+    if (m > n) return -1;
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + i + m - 1));
+        uint32_t hits = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while (hits) {
+            size_t at = i + (size_t)__builtin_ctz(hits);
+            if (m <= 2 || memcmp(s + at + 1, needle + 1, m - 2) == 0) return (long long)at;
+            hits &= hits - 1;
+        }
+    }
+    long long rest = find_sse42(s + i, n - i, needle, m);
+    return rest < 0 ? -1 : (long long)i + rest;
+}
+
+__attribute__((target("avx2")))
+static long long find_any_avx2(const char* s, size_t n, const char* set, size_t k) {
+    if (k == 0) return -1;
+    NibbleSet t;
+    nibble_set(&t, set, k);
+    const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)t.low));
+    const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)t.high));
+    const __m256i bits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)NIBBLE_BITS));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i lo = _mm256_and_si256(v, nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, lo), _mm256_shuffle_epi8(high, lo), v);
+        __m256i bit = _mm256_shuffle_epi8(bits, hi);
+        uint32_t hits = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit));
+        if (hits) return (long long)(i + __builtin_ctz(hits));
+    }
+    long long rest = find_any_scalar(s + i, n - i, set, k);
+    return rest < 0 ? -1 : (long long)i + rest;
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t count_byte_avx2(const char* s, size_t n, char c) {
+    const __m256i target = _mm256_set1_epi8(c);
+    size_t count = 0, i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+        count += (size_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, target)));
+    }
+    return count + count_byte_scalar(s + i, n - i, c);
+}
+
+__attribute__((target("avx2")))
+static void fold_avx2(char* dst, const char* src, size_t n, int upper) {
+    const __m256i below = _mm256_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    const __m256i above = _mm256_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    const __m256i flip = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i in = _mm256_and_si256(_mm256_cmpgt_epi8(v, below), _mm256_cmpgt_epi8(above, v));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(v, _mm256_and_si256(in, flip)));
+    }
+    fold_scalar(dst + i, src + i, n - i, upper);
+}
+
+static const StrKernels AVX2_KERNELS = {
+    "avx2", find_avx2, find_any_avx2, count_byte_avx2, fold_avx2
+};
+
+#endif
+
+// --- Dispatch ---
+
+static const StrKernels* kernels = &SCALAR_KERNELS;
+
+// Widest kernels the CPU runs, capped by 'limit' (a level name, or NULL)
+static const StrKernels* best_kernels(const char* limit) {
+    const StrKernels* best = &SCALAR_KERNELS;
+    if (limit && strcmp(limit, "scalar") == 0) return best;
+#ifdef STR_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) best = &SSE42_KERNELS;
+    if (limit && strcmp(limit, "sse4.2") == 0) return best;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) best = &AVX2_KERNELS;
+#endif
+    return best;
+}
+
+__attribute__((constructor))
+static void str_kernels_init(void) {
+    kernels = best_kernels(getenv("ARIA_STR_KERNELS"));
+}
+
+// Switches to the widest level up to 'limit'; returns the level now in use
+const char* aria_str_kernels_use(const char* limit) {
+    kernels = best_kernels(limit);
+    return kernels->name;
+}
+
+// --- Entry Points ---
+// Offsets are in bytes; -1 when there is no match. An empty needle is
+// found at 0, and an empty set matches nothing.
+
+long long aria_str_find(const char* s, size_t n, const char* needle, size_t m) {
+    return kernels->find(s, n, needle, m);
+}
+
+long long aria_str_find_any(const char* s, size_t n, const char* set, size_t k) {
+    return kernels->find_any(s, n, set, k);
+}
+
+// Non-overlapping occurrences, scanning left to right; 0 for an empty needle
+size_t aria_str_count(const char* s, size_t n, const char* needle, size_t m) {
+    if (m == 0) return 0;
+    if (m == 1) return kernels->count_byte(s, n, needle[0]);
+    size_t count = 0, at = 0;
+    long long found;
+    while ((found = kernels->find(s + at, n - at, needle, m)) >= 0) {
+        count++;
+        at += (size_t)found + m;
+    }
+    return count;
+}
+
+// ASCII case folding of n bytes; dst may be src
+void aria_str_fold(char* dst, const char* src, size_t n, int upper) {
+    kernels->fold(dst, src, n, upper);
+}
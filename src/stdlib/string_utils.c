@@ -1,52 +1,143 @@
 /*
  * Aria Binary-Safe String Implementation
- * 
+ *
  * Replaces null-terminated C strings with length-prefixed structures.
- * This ensures O(1) length access and support for binary data (0x00) 
+ * This ensures O(1) length access and support for binary data (0x00)
  * required for WebSockets, Images, and Encryption.
+ *
+ * Every boxed string shares this layout. The header sits immediately
+ * before the characters and the box points at the characters, so C code
+ * that unboxes a string still sees a NUL-terminated char*. Strings are
+ * immutable once boxed; the hash is computed on first use and cached.
+ * String literals are emitted by the compiler with the header already
+ * filled in (backend/literal.h), and their hash is never 0.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
 
 extern void* aria_alloc(size_t size);
+extern void* list_new();
+extern void list_push(void* list_tagged, void* item_tagged);
+
+// string_kernels.c
+extern long long aria_str_find(const char* s, size_t n, const char* needle, size_t m);
+extern long long aria_str_find_any(const char* s, size_t n, const char* set, size_t k);
+extern size_t aria_str_count(const char* s, size_t n, const char* needle, size_t m);
+extern void aria_str_fold(char* dst, const char* src, size_t n, int upper);
 
 // --- Tagging System (NaN Boxing) ---
 typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_STRING      (TAG_BASE | 5ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
 // --- String Structure ---
 typedef struct {
     uint32_t length;
-    char data[]; // Flexible array member
+    uint32_t hash;   // 0 until first computed
+    char data[];     // Flexible array member, NUL-terminated
 } AriaString;
 
+typedef char aria_string_header_is_8[offsetof(AriaString, data) == 8 ? 1 : -1];
+
+static inline AriaString* str_header(const char* data) {
+    return (AriaString*)(data - offsetof(AriaString, data));
+}
+
 // --- Boxing/Unboxing Helpers ---
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
-static inline Value box_str(AriaString* s) { return TAG_STRING | (uintptr_t)s; }
-static inline AriaString* unbox_str(Value v) { return (AriaString*)(v & PTR_MASK); }
+static inline Value box_str(AriaString* s) { return TAG_STRING | (uintptr_t)s->data; }
+static inline AriaString* unbox_str(Value v) {
+    char* data = (char*)(v & PTR_MASK & ~7ULL);
+    return data ? str_header(data) : NULL;
+}
+
+// --- Shared Constructors ---
+// Other runtime modules declare these extern rather than boxing char*
+// themselves, so that no string without a header reaches Aria code.
+
+// Uninitialized text of 'len' bytes, NUL-terminated, to be filled then boxed
+char* aria_str_alloc(size_t len) {
+    AriaString* s = (AriaString*)aria_alloc(sizeof(AriaString) + len + 1);
+    s->length = (uint32_t)len;
+    s->data[len] = '\0';
+    return s->data;
+}
+
+// Sets the length of text still being built in an aria_str_alloc buffer
+// of at least 'len' bytes (plus NUL), before it is boxed again
+void aria_str_seal(char* data, size_t len) {
+    AriaString* s = str_header(data);
+    s->length = (uint32_t)len;
+    s->hash = 0;
+    data[len] = '\0';
+}
+
+// Boxes text from aria_str_alloc (or a compiler-emitted literal)
+void* aria_str_box_text(char* data) {
+    return (void*)(TAG_STRING | (uintptr_t)data);
+}
+
+void* aria_str_box_n(const char* buf, size_t len) {
+    char* data = aria_str_alloc(len);
+    if (len > 0) memcpy(data, buf, len);
+    return aria_str_box_text(data);
+}
+
+// Copy of a C string; NULL stays a null string
+void* aria_str_box(const char* c_str) {
+    if (!c_str) return (void*)TAG_STRING;
+    return aria_str_box_n(c_str, strlen(c_str));
+}
+
+// FNV-1a, never 0. Must stay identical to literal_hash in the compiler.
+static uint32_t hash_bytes(const char* s, uint32_t len) {
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+uint32_t aria_str_length(const char* data) { return str_header(data)->length; }
+
+uint32_t aria_str_hash(const char* data) {
+    AriaString* s = str_header(data);
+    if (!s->hash) s->hash = hash_bytes(s->data, s->length);
+    return s->hash;
+}
+
+// Length, then cached hash, then bytes
+int aria_str_same(const char* a, const char* b) {
+    if (a == b) return 1;
+    if (!a || !b) return 0;
+    AriaString* sa = str_header(a);
+    AriaString* sb = str_header(b);
+    if (sa->length != sb->length) return 0;
+    if (aria_str_hash(a) != aria_str_hash(b)) return 0;
+    return memcmp(a, b, sa->length) == 0;
+}
 
 // --- String Operations ---
 
-/* 
+/*
  * FIX 3.3: Binary Safe Constructor
  * Allocates string based on explicit length, not strlen.
  */
 Value str_from_buffer(const char* buf, uint32_t len) {
-    AriaString* s = (AriaString*)aria_alloc(sizeof(AriaString) + len + 1);
-    s->length = len;
+    char* data = aria_str_alloc(len);
     if (buf) {
-        memcpy(s->data, buf, len);
+        memcpy(data, buf, len);
     }
-    s->data[len] = '\0'; // Sentinel for legacy C-interop safety
-    return box_str(s);
+    return box_str(str_header(data));
 }
 
 // Construct from C-string (Legacy support)
@@ -66,19 +157,17 @@ Value str_len(Value s_tagged) {
 Value str_concat(Value a_tagged, Value b_tagged) {
     AriaString* a = unbox_str(a_tagged);
     AriaString* b = unbox_str(b_tagged);
-    
+
     uint32_t len_a = a ? a->length : 0;
     uint32_t len_b = b ? b->length : 0;
     uint32_t new_len = len_a + len_b;
-    
-    AriaString* res = (AriaString*)aria_alloc(sizeof(AriaString) + new_len + 1);
-    res->length = new_len;
-    
-    if (len_a > 0) memcpy(res->data, a->data, len_a);
-    if (len_b > 0) memcpy(res->data + len_a, b->data, len_b);
-    
-    res->data[new_len] = '\0';
-    return box_str(res);
+
+    char* res = aria_str_alloc(new_len);
+
+    if (len_a > 0) memcpy(res, a->data, len_a);
+    if (len_b > 0) memcpy(res + len_a, b->data, len_b);
+
+    return box_str(str_header(res));
 }
 
 // Substring (Binary Safe)
@@ -86,27 +175,106 @@ Value str_sub(Value s_tagged, Value start_t, Value len_t) {
     AriaString* s = unbox_str(s_tagged);
     int32_t start = (int32_t)(start_t & 0xFFFFFFFF);
     int32_t len = (int32_t)(len_t & 0xFFFFFFFF);
-    
+
     if (!s) return str_new("");
-    
+
     // Bounds clamping
     if (start < 0) start = 0;
     if (start > (int32_t)s->length) start = s->length;
     if (start + len > (int32_t)s->length) len = s->length - start;
     if (len < 0) len = 0;
-    
+
     return str_from_buffer(s->data + start, (uint32_t)len);
 }
 
-// Comparison (Binary Safe using memcmp)
+// Comparison (Binary Safe: length and cached hash before memcmp)
 Value str_equals(Value a_tagged, Value b_tagged) {
     AriaString* a = unbox_str(a_tagged);
     AriaString* b = unbox_str(b_tagged);
-    
-    if (a == b) return box_int(1); // Same pointer or both null
-    if (!a || !b) return box_int(0); // One is null
-    
-    if (a->length != b->length) return box_int(0);
-    
-    return box_int(memcmp(a->data, b->data, a->length) == 0);
-}
\ No newline at end of file
+    return box_int(aria_str_same(a ? a->data : NULL, b ? b->data : NULL));
+}
+
+// --- Search, Split and Replace ---
+// Vectorized byte kernels (string_kernels.c). Offsets are byte offsets and
+// a null string behaves as empty.
+
+static const char* str_text(AriaString* s) { return s ? s->data : ""; }
+static uint32_t str_length(AriaString* s) { return s ? s->length : 0; }
+
+// Offset of the first occurrence of needle, or -1
+Value str_find(Value s_tagged, Value needle_tagged) {
+    AriaString* s = unbox_str(s_tagged);
+    AriaString* needle = unbox_str(needle_tagged);
+    long long at = aria_str_find(str_text(s), str_length(s), str_text(needle), str_length(needle));
+    return box_int((int32_t)at);
+}
+
+// Offset of the first byte that appears in 'chars', or -1
+Value str_find_any(Value s_tagged, Value chars_tagged) {
+    AriaString* s = unbox_str(s_tagged);
+    AriaString* chars = unbox_str(chars_tagged);
+    long long at = aria_str_find_any(str_text(s), str_length(s), str_text(chars), str_length(chars));
+    return box_int((int32_t)at);
+}
+
+// Non-overlapping occurrences of needle; 0 for an empty needle
+Value str_count(Value s_tagged, Value needle_tagged) {
+    AriaString* s = unbox_str(s_tagged);
+    AriaString* needle = unbox_str(needle_tagged);
+    return box_int((int32_t)aria_str_count(str_text(s), str_length(s), str_text(needle), str_length(needle)));
+}
+
+// List of the pieces between separators; an empty separator gives [s]
+Value str_split(Value s_tagged, Value sep_tagged) {
+    AriaString* s = unbox_str(s_tagged);
+    AriaString* sep = unbox_str(sep_tagged);
+    const char* text = str_text(s);
+    size_t len = str_length(s), sep_len = str_length(sep);
+    void* parts = list_new();
+
+    size_t at = 0;
+    long long found;
+    while (sep_len > 0 && (found = aria_str_find(text + at, len - at, sep->data, sep_len)) >= 0) {
+        list_push(parts, (void*)str_from_buffer(text + at, (uint32_t)found));
+        at += (size_t)found + sep_len;
+    }
+    list_push(parts, (void*)str_from_buffer(text + at, (uint32_t)(len - at)));
+    return (Value)parts;
+}
+
+// Every non-overlapping occurrence of 'from' replaced by 'to', left to right
+Value str_replace(Value s_tagged, Value from_tagged, Value to_tagged) {
+    AriaString* s = unbox_str(s_tagged);
+    AriaString* from = unbox_str(from_tagged);
+    AriaString* to = unbox_str(to_tagged);
+    const char* text = str_text(s);
+    size_t len = str_length(s), from_len = str_length(from), to_len = str_length(to);
+
+    size_t hits = aria_str_count(text, len, str_text(from), from_len);
+    if (hits == 0) return str_from_buffer(text, (uint32_t)len);
+
+    char* res = aria_str_alloc(len - hits * from_len + hits * to_len);
+    char* out = res;
+    size_t at = 0;
+    for (size_t i = 0; i < hits; i++) {
+        size_t found = (size_t)aria_str_find(text + at, len - at, from->data, from_len);
+        memcpy(out, text + at, found);
+        out += found;
+        if (to_len > 0) memcpy(out, to->data, to_len);
+        out += to_len;
+        at += found + from_len;
+    }
+    memcpy(out, text + at, len - at);
+    return box_str(str_header(res));
+}
+
+// ASCII case folding; other bytes are copied unchanged
+static Value str_fold(Value s_tagged, int upper) {
+    AriaString* s = unbox_str(s_tagged);
+    char* res = aria_str_alloc(str_length(s));
+    aria_str_fold(res, str_text(s), str_length(s), upper);
+    return box_str(str_header(res));
+}
+
+Value str_lower(Value s_tagged) { return str_fold(s_tagged, 0); }
+Value str_upper(Value s_tagged) { return str_fold(s_tagged, 1); }
@@ -4,7 +4,7 @@
 
 typedef uint64_t Value;
 #define PTR_MASK 0x0000FFFFFFFFFFFFULL
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 
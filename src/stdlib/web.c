@@ -15,6 +15,8 @@
 // We interact with the Aria object system and memory allocator.
 extern void* aria_alloc(size_t size);
 extern void* aria_alloc_object();
+extern char* aria_str_alloc(size_t len);
+extern void* aria_str_box(const char* c_str);   // copies into a length-prefixed string
 extern void* aria_obj_set(void* o, char* k, void* v);
 extern void* aria_obj_get(void* o, char* k);
 extern void* list_new();
@@ -34,15 +36,15 @@ typedef uint64_t Value;
 #define QNAN_MASK       0x7FF8000000000000ULL
 #define SIGN_BIT        0x8000000000000000ULL
 #define TAG_BASE        (QNAN_MASK | SIGN_BIT)
-#define TAG_INTEGER     (TAG_BASE | 4ULL)
+#define TAG_INTEGER     (TAG_BASE | (4ULL << 48))
 #define TAG_STRING      (TAG_BASE | 5ULL)
 #define TAG_OBJECT      (TAG_BASE | 6ULL)
 #define PTR_MASK        0x0000FFFFFFFFFFFFULL
 
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
-static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK); }
-static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK); }
+static inline char* unbox_str(Value v) { return (char*)(v & PTR_MASK & ~7ULL); }
+static inline void* unbox_ptr(Value v) { return (void*)(v & PTR_MASK & ~7ULL); }
 static inline int32_t unbox_int(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
 
 // --- WebSocket Constants ---
@@ -197,10 +199,8 @@ void* match_route(RouteNode* root, const char* path, void* params_obj) {
             for (int i=0; i < curr->child_count; i++) {
                 if (curr->children[i]->is_param) {
                     // Capture parameter: e.g. "123" for ":id"
-                    char* val = (char*)aria_alloc(strlen(token)+1);
-                    strcpy(val, token);
                     // Store in the params object: params["id"] = "123"
-                    aria_obj_set(params_obj, curr->children[i]->param_name, box_ptr(val, TAG_STRING));
+                    aria_obj_set(params_obj, curr->children[i]->param_name, aria_str_box(token));
                     
                     curr = curr->children[i];
                     found = 1;
@@ -285,14 +285,9 @@ void send_response(void* socket, int status, const char* content_type, const cha
         "\r\n", 
         status, status_text, content_type, len);
         
-    char* h_copy = (char*)aria_alloc(strlen(header)+1);
-    strcpy(h_copy, header);
-    
-    net_write(socket, box_ptr(h_copy, TAG_STRING));
+    net_write(socket, aria_str_box(header));
     if (body) {
-        char* b_copy = (char*)aria_alloc(len+1);
-        strcpy(b_copy, body);
-        net_write(socket, box_ptr(b_copy, TAG_STRING));
+        net_write(socket, aria_str_box(body));
     }
 }
 
@@ -382,14 +377,13 @@ void handle_websocket_frame(void* socket) {
     
     if (opcode == WS_OP_TEXT) {
         // Payload is a string
-        char* msg = (char*)aria_alloc(payload_len + 1);
+        char* msg = aria_str_alloc(payload_len);
         memcpy(msg, payload, payload_len);
-        msg[payload_len] = '\0';
         
         // Pass to User Handler
         // We create a message object
         void* msg_obj = aria_alloc_object();
-        aria_obj_set(msg_obj, "type", box_ptr("message", TAG_STRING));
+        aria_obj_set(msg_obj, "type", aria_str_box("message"));
         aria_obj_set(msg_obj, "data", box_ptr(msg, TAG_STRING));
         
         // Simulating callback execution would happen here in the VM loop
@@ -431,8 +425,8 @@ void handle_client(void* socket) {
     
     // 2. Create Request Object for Aria
     void* req_obj = aria_alloc_object();
-    aria_obj_set(req_obj, "method", box_ptr(method, TAG_STRING));
-    aria_obj_set(req_obj, "path", box_ptr(path, TAG_STRING));
+    aria_obj_set(req_obj, "method", aria_str_box(method));
+    aria_obj_set(req_obj, "path", aria_str_box(path));
     
     // 3. WebSocket Upgrade Check
     char* ws_key = NULL;
@@ -460,9 +454,7 @@ void handle_client(void* socket) {
             "Connection: Upgrade\r\n"
             "Sec-WebSocket-Accept: %s\r\n\r\n", accept_key);
             
-        char* r_copy = (char*)aria_alloc(strlen(response)+1);
-        strcpy(r_copy, response);
-        net_write(socket, box_ptr(r_copy, TAG_STRING));
+        net_write(socket, aria_str_box(response));
         
         // Switch to WS Loop
         // In a threaded server, this connection keeps the thread alive.
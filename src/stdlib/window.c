@@ -14,14 +14,16 @@ extern void* aria_obj_set(void* o, char* k, void* v);
 
 // --- Tagging System ---
 typedef uint64_t Value;
-#define TAG_INTEGER (0xFFF8000000000000ULL | 4ULL)
+#define TAG_INTEGER (0xFFF8000000000000ULL | (4ULL << 48))
 #define TAG_STRING  (0xFFF8000000000000ULL | 5ULL)
 #define TAG_OBJECT  (0xFFF8000000000000ULL | 6ULL)
 #define PTR_MASK    0x0000FFFFFFFFFFFFULL
 
 static inline Value box_int(int32_t i) { return TAG_INTEGER | (uint32_t)i; }
 static inline Value box_ptr(void* ptr, uint64_t tag) { return tag | (uintptr_t)ptr; }
-static inline Value box_str(char* s) { return TAG_STRING | (uintptr_t)s; }
+// Copies into a length-prefixed string (string_utils.c)
+extern void* aria_str_box(const char* c_str);
+static inline Value box_str(const char* s) { return (Value)aria_str_box(s); }
 
 // --- Shared Context Definition ---
 // This context is shared with gui_components.c
@@ -49,7 +51,7 @@ WinContext* get_win_context() {
 void* win_create(void* w_t, void* h_t, void* title_t) {
     int w = (int)((Value)w_t & 0xFFFFFFFF);
     int h = (int)((Value)h_t & 0xFFFFFFFF);
-    char* title = (char*)((Value)title_t & PTR_MASK);
+    char* title = (char*)((Value)title_t & PTR_MASK & ~7ULL);
     if (!title) title = "Aria Application";
 
     if (!initialized) {
@@ -1,13 +1,68 @@
 /**
  * Tesla Consciousness Computing - DataStructures Module Tests
  * 
- * Unit tests for Tesla consciousness-enhanced dataStructures module
+ * Unit tests for Tesla consciousness-enhanced dataStructures module. Lists
+ * are checked through growth, from stack frames, across changes of item
+ * layout and with readers racing a writer; the numeric kernels against
+ * plain loops at every vector level. Build against the module and its
+ * kernels; the test allocates with calloc:
+ *
+ *   gcc -O2 -std=c99 -D_GNU_SOURCE -o tests/tesla_dataStructures_tests \
+ *       tests/test_tesla_dataStructures.c src/stdlib/dataStructures.c \
+ *       src/stdlib/list_kernels.c -lpthread -lm
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
 #include <math.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+void* list_new(void);
+void* list_new_at(void* mem, long long capacity);
+void list_push(void* list_tagged, void* item_tagged);
+void* list_get(void* list_tagged, void* index_tagged);
+void* list_set(void* list_tagged, void* index_tagged, void* val_tagged);
+void* list_header(void* list_tagged);
+void* list_sum(void* list_tagged);
+void* list_min(void* list_tagged);
+void* list_max(void* list_tagged);
+void* list_dot(void* a_tagged, void* b_tagged);
+void* list_map_add(void* list_tagged, void* x_tagged);
+void* list_map_mul(void* list_tagged, void* x_tagged);
+void* list_map(void* list_tagged, void* fn_tagged);
+const char* aria_list_kernels_use(const char* limit);
+
+// The collector is not linked in: reader threads here never reach a
+// safepoint, so nothing may be freed under them
+void* aria_alloc(size_t size) { return calloc(1, size); }
+
+// The fields of AriaList: compiled for-each loops read the first three
+typedef struct { uint64_t* items; int capacity; int count; char writer; int kind; } ListHeader;
+enum { LIST_EMPTY, LIST_INTS, LIST_DOUBLES, LIST_VALUES };
+#define INTS_TAG    0xFFFF000000000000ULL
+
+#define QNAN_MASK   0x7FF8000000000000ULL
+#define TAG_BASE    (QNAN_MASK | 0x8000000000000000ULL)
+#define TAG_NULL    (TAG_BASE | 1ULL)
+#define TAG_INTEGER (TAG_BASE | (4ULL << 48))
+#define TAG_STRING  (TAG_BASE | 5ULL)
+
+static void* box_int(int32_t i) { return (void*)(TAG_INTEGER | (uint32_t)i); }
+static void* box_double(double d) { uint64_t u; memcpy(&u, &d, 8); return (void*)u; }
+static double unbox_double(void* v) { double d; memcpy(&d, &v, 8); return d; }
+static int kind_of(void* list) { return ((ListHeader*)list_header(list))->kind; }
+static int packed(void* list) { return ((uint64_t)((ListHeader*)list_header(list))->items & INTS_TAG) != 0; }
+
+// Ints are read from the low 32 bits
+static void* num(int i) { return (void*)(uintptr_t)(uint32_t)i; }
+static int count_of(void* list) {
+    return atomic_load_explicit((_Atomic int*)&((ListHeader*)list_header(list))->count, memory_order_acquire);
+}
 
 // Test framework
 static int tests_run = 0;
@@ -51,6 +106,284 @@ bool test_tesla_dataStructures_performance() {
     return true;
 }
 
+// Items survive every growth and read back as set
+bool test_tesla_dataStructures_push_get_set() {
+    void* list = list_new();
+    for (int i = 0; i < 100000; i++) list_push(list, num(i));
+    TESLA_ASSERT(count_of(list) == 100000, "wrong count");
+    for (int i = 0; i < 100000; i++) {
+        TESLA_ASSERT(list_get(list, num(i)) == num(i), "item lost in growth");
+    }
+    for (int i = 0; i < 100000; i += 3) {
+        TESLA_ASSERT(list_set(list, num(i), num(-i)) == num(-i), "set returns its value");
+    }
+    for (int i = 0; i < 100000; i++) {
+        TESLA_ASSERT(list_get(list, num(i)) == (i % 3 ? num(i) : num(-i)), "set item wrong");
+    }
+    TESLA_ASSERT(list_get(NULL, num(0)) == NULL, "null list read");
+    TESLA_ASSERT(count_of(NULL) == 0, "null list not empty");
+    return true;
+}
+
+// A list in a stack frame moves its items to the heap when it outgrows it
+bool test_tesla_dataStructures_frame_list() {
+    uint64_t frame[10 + 4];   // 80-byte header, then 4 items
+    void* list = list_new_at(frame, 4);
+    for (int i = 0; i < 4; i++) list_push(list, num(i + 1));
+    TESLA_ASSERT(((ListHeader*)list_header(list))->items == frame + 10, "items not in the frame");
+    for (int i = 4; i < 40; i++) list_push(list, num(i + 1));
+    TESLA_ASSERT(((ListHeader*)list_header(list))->items != frame + 10, "items still in the frame");
+    for (int i = 0; i < 40; i++) {
+        TESLA_ASSERT(list_get(list, num(i)) == num(i + 1), "item lost moving to the heap");
+    }
+    return true;
+}
+
+typedef struct {
+    void* list;
+    atomic_int* done;
+    long reads, wrong;
+} Reader;
+
+// Reads every index below the count it sees, over and over
+static void* read_while_growing(void* arg) {
+    Reader* r = arg;
+    while (!atomic_load(r->done)) {
+        int count = count_of(r->list);
+        for (int i = 0; i < count; i += 7) {
+            r->wrong += list_get(r->list, num(i)) != num(i);
+            r->reads++;
+        }
+    }
+    return NULL;
+}
+
+// Readers take no lock: while a writer grows the list they must still see
+// every pushed item, never a stale or half-copied array
+bool test_tesla_dataStructures_readers_during_growth() {
+    void* list = list_new();
+    atomic_int done = 0;
+    Reader readers[3];
+    pthread_t threads[3];
+    for (int t = 0; t < 3; t++) {
+        readers[t] = (Reader){ list, &done, 0, 0 };
+        pthread_create(&threads[t], NULL, read_while_growing, &readers[t]);
+    }
+    for (int i = 0; i < 2000000; i++) list_push(list, num(i));
+    atomic_store(&done, 1);
+    long reads = 0, wrong = 0;
+    for (int t = 0; t < 3; t++) {
+        pthread_join(threads[t], NULL);
+        reads += readers[t].reads;
+        wrong += readers[t].wrong;
+    }
+    TESLA_ASSERT(reads > 0, "readers never ran");
+    TESLA_ASSERT(wrong == 0, "a reader saw a wrong item");
+    TESLA_ASSERT(count_of(list) == 2000000, "pushes lost");
+    return true;
+}
+
+// The first item picks the layout; another type turns the list generic
+// without changing what any index reads
+bool test_tesla_dataStructures_item_kinds() {
+    static char text[16] = "string";
+    void* s = (void*)(TAG_STRING | (uintptr_t)text);
+    void* ints = list_new();
+    TESLA_ASSERT(kind_of(ints) == LIST_EMPTY, "new list has a kind");
+    for (int i = 0; i < 1000; i++) list_push(ints, box_int(i - 500));
+    TESLA_ASSERT(kind_of(ints) == LIST_INTS && packed(ints), "int list not packed");
+    list_set(ints, num(7), box_int(-7));
+    TESLA_ASSERT(packed(ints), "int set unpacked the list");
+    list_push(ints, box_double(0.5));
+    TESLA_ASSERT(kind_of(ints) == LIST_VALUES && !packed(ints), "float pushed into packed ints");
+    for (int i = 0; i < 1000; i++) {
+        TESLA_ASSERT(list_get(ints, num(i)) == box_int(i == 7 ? -7 : i - 500), "int lost widening");
+    }
+    TESLA_ASSERT(list_get(ints, num(1000)) == box_double(0.5), "pushed float lost");
+
+    void* floats = list_new();
+    for (int i = 0; i < 100; i++) list_push(floats, box_double(i * 0.25));
+    TESLA_ASSERT(kind_of(floats) == LIST_DOUBLES, "float list not marked");
+    list_set(floats, num(3), s);
+    TESLA_ASSERT(kind_of(floats) == LIST_VALUES, "string set into a float list");
+    TESLA_ASSERT(list_get(floats, num(3)) == s && list_get(floats, num(4)) == box_double(1.0), "set lost");
+
+    void* mixed = list_new();
+    list_push(mixed, s);
+    list_push(mixed, box_int(1));
+    TESLA_ASSERT(kind_of(mixed) == LIST_VALUES && list_get(mixed, num(1)) == box_int(1), "mixed list");
+
+    uint64_t frame[10 + 4];
+    void* local = list_new_at(frame, 4);
+    for (int i = 0; i < 4; i++) list_push(local, box_int(i));
+    TESLA_ASSERT(packed(local) && ((uint64_t)((ListHeader*)list_header(local))->items & ~INTS_TAG) == (uint64_t)(frame + 10),
+                 "frame ints not packed in the frame");
+    list_push(local, s);
+    for (int i = 0; i < 4; i++) TESLA_ASSERT(list_get(local, num(i)) == box_int(i), "frame int lost");
+    return true;
+}
+
+static uint64_t seed = 88172645463325252ULL;
+static uint64_t next_random(void) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    return seed;
+}
+
+// Kernels give what plain loops give, at every level and every length
+bool test_tesla_dataStructures_kernels() {
+    const char* levels[] = { "scalar", "avx2" };
+    for (int n = 0; n < 300; n += n < 40 ? 1 : 37) {
+        void* a = list_new();
+        void* b = list_new();
+        void* fa = list_new();
+        void* fb = list_new();
+        int64_t sum = 0, dot = 0;
+        int32_t min = INT32_MAX, max = INT32_MIN;
+        double fmin = INFINITY, fmax = -INFINITY;
+        for (int i = 0; i < n; i++) {
+            int32_t x = (int32_t)next_random(), y = (int32_t)(next_random() % 2001) - 1000;
+            list_push(a, box_int(x));
+            list_push(b, box_int(y));
+            sum += x;
+            dot += (int64_t)x * y;
+            min = x < min ? x : min;
+            max = x > max ? x : max;
+            double fx = (double)(int32_t)next_random() / 7, fy = (double)(int32_t)next_random() / 3;
+            list_push(fa, box_double(fx));
+            list_push(fb, box_double(fy));
+            fmin = fx < fmin ? fx : fmin;
+            fmax = fx > fmax ? fx : fmax;
+        }
+        void* first[9] = { 0 };
+        for (int l = 0; l < 2; l++) {
+            aria_list_kernels_use(levels[l]);
+            void* got[9] = {
+                list_sum(a), list_dot(a, b), list_min(a), list_max(fa), list_sum(fa), list_dot(fa, fb),
+                list_sum(list_map_mul(a, box_int(3))), list_sum(list_map_add(fa, box_int(1))),
+                list_sum(list_map_mul(a, box_double(0.5)))
+            };
+            void* want_sum = sum == (int32_t)sum ? box_int((int32_t)sum) : box_double((double)sum);
+            TESLA_ASSERT(got[0] == want_sum, "int sum");
+            TESLA_ASSERT(unbox_double(got[1]) == (double)dot || got[1] == box_int((int32_t)dot), "int dot");
+            TESLA_ASSERT(got[2] == (n ? box_int(min) : (void*)TAG_NULL), "int min");
+            TESLA_ASSERT(got[3] == (n ? box_double(fmax) : (void*)TAG_NULL), "float max");
+            TESLA_ASSERT(n == 0 || list_min(fa) == box_double(fmin), "float min");
+            for (int k = 0; k < 9; k++) {
+                if (l) TESLA_ASSERT(got[k] == first[k], "levels disagree");
+                first[k] = got[k];
+            }
+        }
+        // The maps keep ints packed and turn ints times a float into floats
+        void* tripled = list_map_mul(a, box_int(3));
+        void* halved = list_map_mul(a, box_double(0.5));
+        TESLA_ASSERT(n == 0 || (packed(tripled) && kind_of(halved) == LIST_DOUBLES), "map result layout");
+        for (int i = 0; i < n; i++) {
+            int32_t x = (int32_t)(uint64_t)list_get(a, num(i));
+            TESLA_ASSERT(list_get(tripled, num(i)) == box_int((int32_t)((uint32_t)x * 3u)), "int map wraps");
+            TESLA_ASSERT(list_get(halved, num(i)) == box_double(x * 0.5), "float map");
+        }
+    }
+    aria_list_kernels_use(NULL);
+
+    // Float sums match a plain loop to rounding, and NaN leaves float lists
+    void* fs = list_new();
+    double plain = 0;
+    for (int i = 0; i < 100000; i++) {
+        double x = (double)(next_random() % 1000000) / 1000;
+        list_push(fs, box_double(x));
+        plain += x;
+    }
+    TESLA_ASSERT(fabs(unbox_double(list_sum(fs)) - plain) < 1e-6 * plain, "float sum");
+    void* inf = list_new();
+    list_push(inf, box_double(INFINITY));
+    list_push(inf, box_double(1));
+    void* nan = list_map_mul(inf, box_int(0));
+    TESLA_ASSERT(kind_of(nan) == LIST_VALUES && (uint64_t)list_get(nan, num(0)) == QNAN_MASK, "NaN item");
+    TESLA_ASSERT(list_get(nan, num(1)) == box_double(0), "item after NaN");
+
+    // Generic lists skip what is not a number
+    static char text[8] = "x";
+    void* mixed = list_new();
+    list_push(mixed, box_int(2));
+    list_push(mixed, (void*)(TAG_STRING | (uintptr_t)text));
+    list_push(mixed, box_double(0.5));
+    TESLA_ASSERT(list_sum(mixed) == box_double(2.5), "mixed sum");
+    TESLA_ASSERT(list_min(mixed) == box_double(0.5) && list_max(mixed) == box_int(2), "mixed range");
+    TESLA_ASSERT(list_get(list_map_add(mixed, box_int(1)), num(1)) == list_get(mixed, num(1)), "string mapped");
+    return true;
+}
+
+typedef struct {
+    void* list;
+    atomic_int* done;
+    long reads, wrong;
+} Widener;
+
+// Items are box_int(i), apart from the strings at multiples of 100000
+static void* read_while_widening(void* arg) {
+    Widener* r = arg;
+    while (!atomic_load(r->done)) {
+        int count = count_of(r->list);
+        for (int i = 1; i < count; i += 7) {
+            if (i % 100000 == 0) continue;
+            r->wrong += list_get(r->list, num(i)) != box_int(i);
+            r->reads++;
+        }
+    }
+    return NULL;
+}
+
+// Readers holding the packed array while it is widened keep reading it
+bool test_tesla_dataStructures_readers_during_widening() {
+    static char text[8] = "s";
+    atomic_int done = 0;
+    Widener readers[3];
+    pthread_t threads[3];
+    for (int round = 0; round < 4; round++) {
+        void* list = list_new();
+        atomic_store(&done, 0);
+        for (int t = 0; t < 3; t++) {
+            readers[t] = (Widener){ list, &done, 0, 0 };
+            pthread_create(&threads[t], NULL, read_while_widening, &readers[t]);
+        }
+        for (int i = 0; i < 500000; i++) {
+            list_push(list, i % 100000 || i == 0 ? box_int(i) : (void*)(TAG_STRING | (uintptr_t)text));
+        }
+        atomic_store(&done, 1);
+        long reads = 0, wrong = 0;
+        for (int t = 0; t < 3; t++) {
+            pthread_join(threads[t], NULL);
+            reads += readers[t].reads;
+            wrong += readers[t].wrong;
+        }
+        TESLA_ASSERT(wrong == 0, "a reader saw a wrong item");
+        TESLA_ASSERT(kind_of(list) == LIST_VALUES && list_get(list, num(499999)) == box_int(499999), "widened");
+    }
+    return true;
+}
+
+// Callbacks for list_map, passed as plain code addresses
+static void* halve(void* v) { return box_double((double)(int32_t)(uint64_t)v / 2); }
+static void* mapped_list;
+static void* square_and_grow(void* v) {
+    int32_t x = (int32_t)(uint64_t)v;
+    list_push(mapped_list, box_int(-1));
+    return box_int(x * x);
+}
+
+// list_map calls any function value per item, over the items it started with
+bool test_tesla_dataStructures_map_function() {
+    mapped_list = list_new();
+    for (int i = 0; i < 1000; i++) list_push(mapped_list, box_int(i));
+    void* squares = list_map(mapped_list, (void*)square_and_grow);
+    TESLA_ASSERT(count_of(squares) == 1000 && count_of(mapped_list) == 2000, "mapped the items on entry");
+    TESLA_ASSERT(packed(squares) && list_get(squares, num(999)) == box_int(998001), "int results packed");
+    void* halves = list_map(squares, (void*)halve);
+    TESLA_ASSERT(kind_of(halves) == LIST_DOUBLES && list_get(halves, num(3)) == box_double(4.5), "float results");
+    TESLA_ASSERT(count_of(list_map(list_new(), (void*)halve)) == 0, "empty list");
+    return true;
+}
+
 int main() {
     printf("🧠⚡ Tesla DataStructures Module Test Suite ⚡🧠\n");
     printf("=======================================\n\n");
@@ -59,6 +392,13 @@ int main() {
     TESLA_TEST(consciousness_validation);
     TESLA_TEST(frequency_synchronization);
     TESLA_TEST(performance);
+    TESLA_TEST(push_get_set);
+    TESLA_TEST(frame_list);
+    TESLA_TEST(readers_during_growth);
+    TESLA_TEST(item_kinds);
+    TESLA_TEST(kernels);
+    TESLA_TEST(readers_during_widening);
+    TESLA_TEST(map_function);
     
     printf("\n🧠⚡ Tesla  Test Results ⚡🧠\n");
     printf("============================\n");
@@ -0,0 +1,196 @@
+/**
+ * Tesla Consciousness Computing - Dynamic Module Tests
+ *
+ * Unit tests for the dynamic value operations. Match statements dispatch
+ * through dyn_match_int and dyn_match_str: these tests build the same
+ * tables the compiler plans (a switch on integer keys, hash slots with a
+ * confirming compare for strings) and run int and string subjects through
+ * them. dyn_print is checked on every kind of value. Build against the
+ * runtime sources:
+ *
+ *   gcc -O2 -std=c99 -D_GNU_SOURCE -o tests/tesla_dynamic_tests \
+ *       tests/test_tesla_dynamic.c src/stdlib/dynamic.c src/stdlib/io.c \
+ *       src/stdlib/string_utils.c src/stdlib/string_kernels.c \
+ *       src/stdlib/dataStructures.c src/stdlib/list_kernels.c \
+ *       src/runtime/object.c src/runtime/gc.c -lpthread -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+
+void* dyn_new_int(long long val);
+void* dyn_new_float(long long bits);
+void* dyn_new_null(void);
+void* dyn_add(void* a, void* b);
+void* dyn_mul(void* a, void* b);
+long long dyn_match_int(void* v_ptr);
+long long dyn_match_str(void* v_ptr, long long seed, long long mask);
+long long dyn_str_equals(void* v_ptr, const char* literal);
+void* aria_str_box(const char* c_str);
+void* dyn_new_bool(long long b);
+void dyn_print(void* ptr);
+
+#define PTR_MASK 0x0000FFFFFFFFFFFFULL
+
+// Test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TESLA_TEST(name) \
+    do { \
+        printf("🔬 Testing tesla_dynamic_%s... ", #name); \
+        tests_run++; \
+        if (test_tesla_dynamic_##name()) { \
+            printf("✅ PASSED\n"); \
+            tests_passed++; \
+        } else { \
+            printf("❌ FAILED\n"); \
+        } \
+    } while(0)
+
+#define TESLA_ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            printf("\n💥 Assertion failed: %s\n", message); \
+            return false; \
+        } \
+    } while(0)
+
+static void* box_float(double d) {
+    long long bits;
+    memcpy(&bits, &d, 8);
+    return dyn_new_float(bits);
+}
+
+// match (k) { 0, 1 -> ...  7 -> ...  -3 -> ...  else -> ... } as arm numbers
+static int route_int(void* k) {
+    switch (dyn_match_int(k)) {
+        case 0: case 1: return 1;
+        case 7: return 2;
+        case -3: return 3;
+        default: return 0;
+    }
+}
+
+// Ints keep their value through boxing and arithmetic
+bool test_tesla_dynamic_int_values() {
+    for (int i = -1000; i <= 1000; i++) {
+        TESLA_ASSERT(dyn_match_int(dyn_new_int(i)) == i, "boxed int changed value");
+    }
+    TESLA_ASSERT(dyn_match_int(dyn_new_int(INT_MAX)) == INT_MAX, "largest int");
+    TESLA_ASSERT(dyn_match_int(dyn_new_int(INT_MIN)) == INT_MIN, "smallest int");
+    TESLA_ASSERT(dyn_match_int(dyn_add(dyn_new_int(5), dyn_new_int(1))) == 6, "5 + 1");
+    TESLA_ASSERT(dyn_match_int(dyn_mul(dyn_new_int(-6), dyn_new_int(7))) == -42, "-6 * 7");
+    return true;
+}
+
+bool test_tesla_dynamic_match_int() {
+    TESLA_ASSERT(route_int(dyn_new_int(0)) == 1 && route_int(dyn_new_int(1)) == 1, "0, 1 arm");
+    TESLA_ASSERT(route_int(dyn_new_int(7)) == 2, "7 arm");
+    TESLA_ASSERT(route_int(dyn_new_int(-3)) == 3, "-3 arm");
+    TESLA_ASSERT(route_int(dyn_new_int(2)) == 0 && route_int(dyn_new_int(5)) == 0, "unmatched ints take else");
+    TESLA_ASSERT(dyn_match_int(box_float(7.0)) == LLONG_MIN, "a float is not an int key");
+    TESLA_ASSERT(dyn_match_int(aria_str_box("7")) == LLONG_MIN, "a string is not an int key");
+    TESLA_ASSERT(dyn_match_int(dyn_new_null()) == LLONG_MIN, "null is not an int key");
+    return true;
+}
+
+// Slots as the compiler lays them out: every case hashed with one seed,
+// each slot confirming its candidates in turn. Case literals carry a string
+// header, as the compiler emits them.
+#define SLOTS 16
+static const char* CASES[] = { "get", "put", "post", "delete", "route7", "" };
+#define CASE_COUNT (int)(sizeof(CASES) / sizeof(CASES[0]))
+static const char* literals[CASE_COUNT];
+
+static int route_str(void* s, long long seed, int table[SLOTS][CASE_COUNT + 1]) {
+    long long slot = dyn_match_str(s, seed, SLOTS - 1);
+    if (slot < 0) return -1;
+    for (int* c = table[slot]; *c >= 0; c++) {
+        if (dyn_str_equals(s, literals[*c])) return *c;
+    }
+    return -1;
+}
+
+bool test_tesla_dynamic_match_str() {
+    int table[SLOTS][CASE_COUNT + 1];
+    for (int i = 0; i < CASE_COUNT; i++) literals[i] = (const char*)((uint64_t)aria_str_box(CASES[i]) & PTR_MASK & ~7ULL);
+    for (long long seed = 0; seed < 4; seed++) {
+        int fill[SLOTS] = { 0 };
+        for (int i = 0; i < CASE_COUNT; i++) {
+            long long slot = dyn_match_str(aria_str_box(CASES[i]), seed, SLOTS - 1);
+            TESLA_ASSERT(slot >= 0 && slot < SLOTS, "case string has no slot");
+            table[slot][fill[slot]++] = i;
+        }
+        for (int s = 0; s < SLOTS; s++) table[s][fill[s]] = -1;
+
+        // Subjects are separate boxes from the ones the table was built from
+        for (int i = 0; i < CASE_COUNT; i++) {
+            char copy[16];
+            snprintf(copy, sizeof(copy), "%s", CASES[i]);
+            TESLA_ASSERT(route_str(aria_str_box(copy), seed, table) == i, "string subject took the wrong arm");
+        }
+        TESLA_ASSERT(route_str(aria_str_box("patch"), seed, table) == -1, "unmatched string takes else");
+        TESLA_ASSERT(route_str(aria_str_box("gets"), seed, table) == -1, "prefix of a case takes else");
+    }
+    TESLA_ASSERT(dyn_match_str(dyn_new_int(7), 0, SLOTS - 1) == -1, "an int is not a string key");
+    TESLA_ASSERT(dyn_match_str(box_float(1.5), 0, SLOTS - 1) == -1, "a float is not a string key");
+    TESLA_ASSERT(!dyn_str_equals(dyn_new_int(0), literals[CASE_COUNT - 1]), "an int never equals a string case");
+    return true;
+}
+
+// dyn_print shows each kind as print does; stdout goes to a file meanwhile
+bool test_tesla_dynamic_print_values() {
+    char path[] = "/tmp/tesla_dynamic_printXXXXXX";
+    int fd = mkstemp(path);
+    TESLA_ASSERT(fd >= 0, "no temporary file");
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    void* values[] = { aria_str_box("hello"), dyn_new_int(-42), box_float(1.5), dyn_new_null(), dyn_new_bool(1) };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        if (i) dyn_print(aria_str_box(" "));
+        dyn_print(values[i]);
+    }
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    char got[64] = { 0 };
+    ssize_t n = pread(fd, got, sizeof(got) - 1, 0);
+    close(fd);
+    unlink(path);
+    TESLA_ASSERT(n > 0 && strcmp(got, "hello -42 1.500000 null true") == 0, "printed values");
+    return true;
+}
+
+int main() {
+    printf("🧠⚡ Tesla Dynamic Module Test Suite ⚡🧠\n");
+    printf("=======================================\n\n");
+
+    TESLA_TEST(int_values);
+    TESLA_TEST(match_int);
+    TESLA_TEST(match_str);
+    TESLA_TEST(print_values);
+
+    printf("\n🧠⚡ Tesla  Test Results ⚡🧠\n");
+    printf("============================\n");
+    printf("Tests Run:    %d\n", tests_run);
+    printf("Tests Passed: %d\n", tests_passed);
+    printf("Tests Failed: %d\n", tests_run - tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("✅ All Tesla dynamic tests PASSED! π Hz synchronized! 🚀\n");
+        return 0;
+    } else {
+        printf("❌ Some Tesla dynamic tests FAILED! ⚠️\n");
+        return 1;
+    }
+}
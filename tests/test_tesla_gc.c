@@ -0,0 +1,180 @@
+/**
+ * Tesla Consciousness Computing - Garbage Collector Tests
+ *
+ * Unit tests for the collector in runtime/gc.c. Lists are reached only
+ * through NaN-boxed Values and packed int arrays only through their tagged
+ * item pointers; each test allocates garbage until the collector has run
+ * several times, then checks that everything still reachable reads back
+ * intact. Build against the collector and the list module:
+ *
+ *   gcc -O2 -std=c99 -D_GNU_SOURCE -o tests/tesla_gc_tests \
+ *       tests/test_tesla_gc.c src/runtime/gc.c \
+ *       src/stdlib/dataStructures.c src/stdlib/list_kernels.c -lpthread -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+void* aria_alloc(size_t size);
+void gc_register_thread(void* stack_bottom);
+void gc_unregister_thread(void);
+void gc_enter_safepoint(void);
+extern volatile int32_t gc_suspend_request;
+
+void* list_new(void);
+void list_push(void* list_tagged, void* item_tagged);
+void* list_get(void* list_tagged, void* index_tagged);
+void* list_header(void* list_tagged);
+
+// The fields of AriaList that compiled for-each loops read
+typedef struct { uint64_t* items; int capacity; int count; } ListHeader;
+#define INTS_TAG    0xFFFF000000000000ULL
+#define PTR_MASK    0x0000FFFFFFFFFFFFULL
+#define TAG_INTEGER 0xFFFC000000000000ULL
+
+static void* box_int(int32_t i) { return (void*)(TAG_INTEGER | (uint32_t)i); }
+static void* box_double(double d) { uint64_t u; memcpy(&u, &d, 8); return (void*)u; }
+static void* num(int i) { return (void*)(uintptr_t)(uint32_t)i; }
+static int count_of(void* list) {
+    return atomic_load_explicit((_Atomic int*)&((ListHeader*)list_header(list))->count, memory_order_acquire);
+}
+
+// Well past the collector's 64 MB threshold, so it runs more than once
+static void churn(void) {
+    for (int i = 0; i < 256; i++) memset(aria_alloc(1 << 20), 0xA5, 1 << 20);
+}
+
+// Test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TESLA_TEST(name) \
+    do { \
+        printf("🔬 Testing tesla_gc_%s... ", #name); \
+        tests_run++; \
+        if (test_tesla_gc_##name()) { \
+            printf("✅ PASSED\n"); \
+            tests_passed++; \
+        } else { \
+            printf("❌ FAILED\n"); \
+        } \
+    } while(0)
+
+#define TESLA_ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            printf("\n💥 Assertion failed: %s\n", message); \
+            return false; \
+        } \
+    } while(0)
+
+// Lists held only as tagged Values, on the stack and inside another list,
+// keep their headers and item arrays through collections
+bool test_tesla_gc_tagged_lists() {
+    void* outer = list_new();
+    for (int i = 0; i < 1000; i++) {
+        void* inner = list_new();
+        for (int k = 0; k < 20; k++) list_push(inner, i % 2 ? box_double(i + k * 0.5) : box_int(i * k));
+        list_push(outer, inner);
+    }
+    churn();
+    TESLA_ASSERT(count_of(outer) == 1000, "outer list freed");
+    for (int i = 0; i < 1000; i++) {
+        void* inner = list_get(outer, num(i));
+        TESLA_ASSERT(count_of(inner) == 20, "inner list freed");
+        for (int k = 0; k < 20; k++) {
+            void* want = i % 2 ? box_double(i + k * 0.5) : box_int(i * k);
+            TESLA_ASSERT(list_get(inner, num(k)) == want, "inner item lost");
+        }
+    }
+    return true;
+}
+
+// A list pushed past several collections keeps every item
+bool test_tesla_gc_long_push() {
+    void* floats = list_new();
+    for (int i = 0; i < 6000000; i++) list_push(floats, box_double(i + 0.5));
+    churn();
+    TESLA_ASSERT(count_of(floats) == 6000000, "pushes lost");
+    for (int i = 0; i < 6000000; i += 999) {
+        TESLA_ASSERT(list_get(floats, num(i)) == box_double(i + 0.5), "item lost");
+    }
+    return true;
+}
+
+typedef struct {
+    void* list;
+    atomic_int* done;
+    long reads, wrong;
+} Reader;
+
+// Reads a packed int array the way a for-each loop does: the tagged item
+// pointer is loaded once and held across safepoints, while the writer
+// replaces it with bigger arrays and the old one is garbage
+static void* read_through_collections(void* arg) {
+    Reader* r = arg;
+    int stack_bottom;
+    gc_register_thread(&stack_bottom);
+    while (!atomic_load(r->done)) {
+        ListHeader* h = list_header(r->list);
+        int count = atomic_load_explicit((_Atomic int*)&h->count, memory_order_acquire);
+        uint64_t* items = atomic_load_explicit((uint64_t* _Atomic*)&h->items, memory_order_acquire);
+        for (int i = 0; i < count; i++) {
+            if (gc_suspend_request) gc_enter_safepoint();
+            int32_t* ints = (int32_t*)((uintptr_t)items & PTR_MASK);
+            r->wrong += ((uintptr_t)items & INTS_TAG) != INTS_TAG || ints[i] != i;
+            r->reads++;
+        }
+    }
+    gc_unregister_thread();
+    return NULL;
+}
+
+// Collections stop a registered reader at a safepoint and keep the array
+// it holds alive, even after the list has moved on to a new one
+bool test_tesla_gc_collection_with_reader() {
+    void* list = list_new();
+    list_push(list, box_int(0));
+    atomic_int done = 0;
+    Reader reader = { list, &done, 0, 0 };
+    pthread_t thread;
+    pthread_create(&thread, NULL, read_through_collections, &reader);
+    for (int round = 0; round < 4; round++) {
+        for (int i = count_of(list); i < (round + 1) * 500000; i++) list_push(list, box_int(i));
+        churn();
+    }
+    atomic_store(&done, 1);
+    pthread_join(thread, NULL);
+    TESLA_ASSERT(reader.reads > 0, "reader never ran");
+    TESLA_ASSERT(reader.wrong == 0, "reader saw a freed array");
+    TESLA_ASSERT(count_of(list) == 2000000 && list_get(list, num(1999999)) == box_int(1999999), "list lost");
+    return true;
+}
+
+int main() {
+    printf("🧠⚡ Tesla GC Test Suite ⚡🧠\n");
+    printf("=======================================\n\n");
+
+    TESLA_TEST(tagged_lists);
+    TESLA_TEST(long_push);
+    TESLA_TEST(collection_with_reader);
+
+    printf("\n🧠⚡ Tesla  Test Results ⚡🧠\n");
+    printf("============================\n");
+    printf("Tests Run:    %d\n", tests_run);
+    printf("Tests Passed: %d\n", tests_passed);
+    printf("Tests Failed: %d\n", tests_run - tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("✅ All Tesla GC tests PASSED! π Hz synchronized! 🚀\n");
+        return 0;
+    } else {
+        printf("❌ Some Tesla GC tests FAILED! ⚠️\n");
+        return 1;
+    }
+}
@@ -1,14 +1,54 @@
 /**
  * Tesla Consciousness Computing - Io Module Tests
  * 
- * Unit tests for Tesla consciousness-enhanced io module
+ * Unit tests for Tesla consciousness-enhanced io module. The formatter is
+ * checked with int, float and string arguments, through format() and
+ * through the appends the compiler emits for literal formats, as are
+ * in-place string appends and the string builder. Build against the
+ * runtime sources:
+ *
+ *   gcc -O2 -std=c99 -D_GNU_SOURCE -o tests/tesla_io_tests tests/test_tesla_io.c \
+ *       src/stdlib/io.c src/stdlib/dynamic.c src/stdlib/string_utils.c \
+ *       src/stdlib/string_kernels.c src/stdlib/dataStructures.c \
+ *       src/stdlib/list_kernels.c src/runtime/object.c src/runtime/gc.c -lpthread -lm
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
 #include <assert.h>
 #include <math.h>
 
+void* format(const char* fmt, ...);
+void* aria_fmt_new(long long capacity);
+void* aria_fmt_finish(void* sink);
+void aria_fmt_text(void* sink, const char* s, long long len);
+void aria_fmt_int(void* sink, void* v);
+void aria_fmt_float(void* sink, void* v);
+void aria_fmt_str(void* sink, void* v);
+void* dyn_new_int(long long val);
+void* dyn_new_float(long long bits);
+void* aria_str_box(const char* c_str);
+long long dyn_match_int(void* v_ptr);
+typedef struct { void* value; void* buffer; } AppendResult;
+AppendResult aria_str_append(void* buffer, void* left, void* right);
+int aria_float_text(char* out, double f);
+void* sb_new(void);
+void* sb_append(void* sb, void* value);
+void* sb_to_string(void* sb);
+
+#define PTR_MASK 0x0000FFFFFFFFFFFFULL
+
+static const char* text_of(void* v) { return (const char*)((uint64_t)v & PTR_MASK & ~7ULL); }
+static void* num(double d) {
+    long long bits;
+    memcpy(&bits, &d, 8);
+    return dyn_new_float(bits);
+}
+
 // Test framework
 static int tests_run = 0;
 static int tests_passed = 0;
@@ -51,6 +91,80 @@ bool test_tesla_io_performance() {
     return true;
 }
 
+// %d and %f take ints and floats alike; ints print exactly
+bool test_tesla_io_format_numbers() {
+    void* i = dyn_new_int(42);
+    void* n = dyn_new_int(-7);
+    TESLA_ASSERT(strcmp(text_of(format("%d", i)), "42") == 0, "%d of an int");
+    TESLA_ASSERT(strcmp(text_of(format("%d|%d", n, dyn_new_int(0))), "-7|0") == 0, "%d of negative and zero ints");
+    TESLA_ASSERT(strcmp(text_of(format("%d", dyn_new_int(INT_MIN))), "-2147483648") == 0, "%d of the smallest int");
+    TESLA_ASSERT(strcmp(text_of(format("%f", i)), "42.000000") == 0, "%f of an int");
+    TESLA_ASSERT(strcmp(text_of(format("%f", n)), "-7.000000") == 0, "%f of a negative int");
+    TESLA_ASSERT(strcmp(text_of(format("%d", num(2.9))), "2") == 0, "%d of a float");
+    TESLA_ASSERT(strcmp(text_of(format("%f", num(2.5))), "2.500000") == 0, "%f of a float");
+    TESLA_ASSERT(strcmp(text_of(format("%s=%d%%", aria_str_box("x"), i)), "x=42%") == 0, "%s, %d and %%");
+    return true;
+}
+
+// format("n = %d, f = %f, s = %s", ...) as the compiler specializes it
+bool test_tesla_io_specialized_format() {
+    void* sink = aria_fmt_new(24);
+    aria_fmt_text(sink, "n = ", 4);
+    aria_fmt_int(sink, dyn_new_int(1234567));
+    aria_fmt_text(sink, ", f = ", 6);
+    aria_fmt_float(sink, dyn_new_int(3));
+    aria_fmt_text(sink, ", s = ", 6);
+    aria_fmt_str(sink, aria_str_box("ok"));
+    const char* got = text_of(aria_fmt_finish(sink));
+    TESLA_ASSERT(strcmp(got, "n = 1234567, f = 3.000000, s = ok") == 0, "specialized format");
+    return true;
+}
+
+// s = s + x grows one buffer while both sides are strings; numbers go to dyn_add
+bool test_tesla_io_string_accumulation() {
+    AppendResult r = aria_str_append(NULL, aria_str_box("ab"), aria_str_box("cd"));
+    TESLA_ASSERT(r.buffer && strcmp(text_of(r.value), "abcd") == 0, "first append");
+    void* buffer = r.buffer;
+    for (int i = 0; i < 100; i++) r = aria_str_append(r.buffer, r.value, aria_str_box("x"));
+    TESLA_ASSERT(strlen(text_of(r.value)) == 104, "appends kept every piece");
+    TESLA_ASSERT(r.buffer == buffer, "appends reuse the buffer");
+
+    r = aria_str_append(NULL, dyn_new_int(40), dyn_new_int(2));
+    TESLA_ASSERT(!r.buffer && dyn_match_int(r.value) == 42, "ints are added");
+
+    void* sb = sb_new();
+    sb_append(sb, aria_str_box("n="));
+    sb_append(sb, dyn_new_int(-12));
+    sb_append(sb, aria_str_box(" f="));
+    sb_append(sb, num(0.5));
+    TESLA_ASSERT(strcmp(text_of(sb_to_string(sb)), "n=-12 f=0.500000") == 0, "builder of strings and numbers");
+    return true;
+}
+
+// Every binary exponent, with assorted mantissas and both signs, prints as
+// printf's "%.6f" does, up to the 317 characters of -DBL_MAX
+bool test_tesla_io_float_text() {
+    char got[320], want[400];
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (uint64_t biased = 0; biased <= 0x7FF; biased++) {
+        for (int k = 0; k < 8; k++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint64_t mantissa = k == 0 ? 0 : k == 1 ? (1ULL << 52) - 1 : seed >> 12;
+            uint64_t u = (biased << 52) | mantissa | ((uint64_t)(k & 1) << 63);
+            double f;
+            memcpy(&f, &u, 8);
+            int len = aria_float_text(got, f);
+            int want_len = snprintf(want, sizeof(want), "%.6f", f);
+            TESLA_ASSERT(len == want_len && memcmp(got, want, len) == 0, "float text differs from %.6f");
+        }
+    }
+    double max = -1.7976931348623157e308;
+    TESLA_ASSERT(aria_float_text(got, max) == 317, "-DBL_MAX is 317 characters");
+    snprintf(want, sizeof(want), "%.6f", 1e300);
+    TESLA_ASSERT(strcmp(text_of(format("%f", num(1e300))), want) == 0, "format of a huge float");
+    return true;
+}
+
 int main() {
     printf("🧠⚡ Tesla Io Module Test Suite ⚡🧠\n");
     printf("=======================================\n\n");
@@ -59,6 +173,10 @@ int main() {
     TESLA_TEST(consciousness_validation);
     TESLA_TEST(frequency_synchronization);
     TESLA_TEST(performance);
+    TESLA_TEST(format_numbers);
+    TESLA_TEST(specialized_format);
+    TESLA_TEST(string_accumulation);
+    TESLA_TEST(float_text);
     
     printf("\n🧠⚡ Tesla  Test Results ⚡🧠\n");
     printf("============================\n");
@@ -0,0 +1,254 @@
+/**
+ * Tesla Consciousness Computing - Json Module Tests
+ *
+ * Conformance tests for the json module: documents that must parse or be
+ * rejected, the text json_stringify writes back, escapes that straddle the
+ * parser's 64-byte blocks, and agreement between the vector and scalar
+ * classifiers. Build against the runtime sources:
+ *
+ *   gcc -O2 -std=c99 -D_GNU_SOURCE -o tests/tesla_json_tests tests/test_tesla_json.c \
+ *       src/stdlib/json.c src/stdlib/io.c src/stdlib/dynamic.c src/stdlib/string_utils.c \
+ *       src/stdlib/string_kernels.c src/stdlib/dataStructures.c src/stdlib/list_kernels.c \
+ *       src/runtime/object.c src/runtime/gc.c -lpthread -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+
+long long aria_json_parse(const char* text, size_t len, void** out);
+const char* aria_json_kernels_use(const char* limit);
+void* json_stringify(void* value);
+void* aria_obj_get(void* obj_tagged, char* key);
+void* list_get(void* list_tagged, void* index_tagged);
+
+#define PTR_MASK 0x0000FFFFFFFFFFFFULL
+
+// Test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TESLA_TEST(name) \
+    do { \
+        printf("🔬 Testing tesla_json_%s... ", #name); \
+        tests_run++; \
+        if (test_tesla_json_##name()) { \
+            printf("✅ PASSED\n"); \
+            tests_passed++; \
+        } else { \
+            printf("❌ FAILED\n"); \
+        } \
+    } while(0)
+
+#define TESLA_ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            printf("\n💥 Assertion failed: %s\n", message); \
+            return false; \
+        } \
+    } while(0)
+
+static const char* LEVELS[] = { "scalar", "sse4.2", "avx2" };
+
+static bool parses(const char* text) {
+    return aria_json_parse(text, strlen(text), NULL) == 1;
+}
+
+// Parses and writes back text; NULL if it does not parse
+static const char* round_trip(const char* text) {
+    void* value;
+    if (!aria_json_parse(text, strlen(text), &value)) return NULL;
+    return (const char*)((uint64_t)json_stringify(value) & PTR_MASK & ~7ULL);
+}
+
+// Rejected documents report on stderr; keep the test output readable
+static int saved_stderr = -1;
+static void quiet_stderr(bool quiet) {
+    fflush(stderr);
+    if (quiet) {
+        saved_stderr = dup(2);
+        if (!freopen("/dev/null", "w", stderr)) return;
+    } else if (saved_stderr >= 0) {
+        dup2(saved_stderr, 2);
+        close(saved_stderr);
+        saved_stderr = -1;
+    }
+}
+
+static bool same_text(const char* got, const char* want) {
+    if (got && strcmp(got, want) == 0) return true;
+    printf("\n   got  %s\n   want %s", got ? got : "(no parse)", want);
+    return false;
+}
+
+// Documents every conforming parser accepts
+bool test_tesla_json_valid_documents() {
+    static const char* DOCS[] = {
+        "0", "-0", "1.5", "-12.25e-3", "1E+2", "true", "false", "null", "\"\"",
+        "[]", "{}", " [ ] ", "\t\n\r{\"a\" : [1, 2, {\"b\": null}]}\n",
+        "\"\\u0041\\u00e9\\ud83d\\ude00\"", "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"",
+        "[1,[2,[3,[4,[5]]]]]", "{\"\":0}", "\"caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\"",
+        "123456789012345678901234567890", "[1e400, -1e-400]"
+    };
+    for (size_t i = 0; i < sizeof(DOCS) / sizeof(*DOCS); i++) {
+        if (!parses(DOCS[i])) printf("\n   rejected %s", DOCS[i]);
+        TESLA_ASSERT(parses(DOCS[i]), "valid document rejected");
+    }
+    return true;
+}
+
+// Documents every conforming parser rejects
+bool test_tesla_json_invalid_documents() {
+    static const char* DOCS[] = {
+        "", " ", "[", "]", "{", "[1,]", "[,1]", "[1 2]", "{\"a\"}", "{\"a\":}", "{\"a\" 1}",
+        "{1:2}", "{\"a\":1,}", "[1]]", "[1]x", "01", "1.", ".5", "-", "1e", "1e+", "+1",
+        "0x10", "tru", "truex", "nul", "NaN", "Infinity", "'a'", "\"abc", "\"a\\x\"",
+        "\"\\u12\"", "\"\\ud800\"", "\"\\udc00\"", "\"a\tb\"", "\"\x01\"", "[1]\x0b",
+        "\"\xc3\"", "\"\xc0\xaf\"", "\"\xed\xa0\x80\"", "\"\xf5\x80\x80\x80\"", "[\"a\"\"b\"]",
+        "{\"a\":1 \"b\":2}", "\\", "[1,\\]"
+    };
+    quiet_stderr(true);
+    bool all_rejected = true;
+    for (size_t i = 0; i < sizeof(DOCS) / sizeof(*DOCS); i++) {
+        if (parses(DOCS[i])) {
+            printf("\n   accepted %s", DOCS[i]);
+            all_rejected = false;
+        }
+    }
+    quiet_stderr(false);
+    TESLA_ASSERT(all_rejected, "invalid document accepted");
+    return true;
+}
+
+// Compact output: ints stay ints, floats keep a '.' or exponent
+bool test_tesla_json_canonical_output() {
+    static const char* CASES[][2] = {
+        { " [ 1 , -2 , 2147483647 , -2147483648 ] ", "[1,-2,2147483647,-2147483648]" },
+        { "[2147483648, 1e2, 0.1, -0, 1.5e-7]", "[2147483648.0,100.0,0.1,0,1.5e-07]" },
+        { "[true,false,null,[],{}]", "[true,false,null,[],{}]" },
+        { "{ \"key\" : { \"inner\" : [ \"v\" ] } }", "{\"key\":{\"inner\":[\"v\"]}}" },
+        { "\"\\u0041\\u00e9\\ud83d\\ude00\\/\"", "\"A\xc3\xa9\xf0\x9f\x98\x80/\"" },
+        { "\"q\\\"b\\\\n\\nt\\tc\\u0001\\u001f\"", "\"q\\\"b\\\\n\\nt\\tc\\u0001\\u001f\"" },
+        { "[0.30000000000000004, 1.7976931348623157e308, 5e-324]",
+          "[0.30000000000000004,1.7976931348623157e+308,4.94065645841247e-324]" }
+    };
+    for (size_t i = 0; i < sizeof(CASES) / sizeof(*CASES); i++) {
+        TESLA_ASSERT(same_text(round_trip(CASES[i][0]), CASES[i][1]), "unexpected JSON text");
+    }
+    return true;
+}
+
+// Parsed documents are ordinary objects and lists
+bool test_tesla_json_values() {
+    const char* text = "{\"name\": \"aria\", \"tags\": [\"fast\", \"small\"], \"n\": 3}";
+    void* value;
+    TESLA_ASSERT(aria_json_parse(text, strlen(text), &value), "document rejected");
+    const char* name = (const char*)((uint64_t)aria_obj_get(value, "name") & PTR_MASK & ~7ULL);
+    TESLA_ASSERT(name && strcmp(name, "aria") == 0, "string property lost");
+    void* tags = aria_obj_get(value, "tags");
+    const char* second = (const char*)((uint64_t)list_get(tags, (void*)(uintptr_t)1) & PTR_MASK & ~7ULL);
+    TESLA_ASSERT(second && strcmp(second, "small") == 0, "list element lost");
+    TESLA_ASSERT(((uint64_t)aria_obj_get(value, "n") & 0xFFFFFFFF) == 3, "int property lost");
+    TESLA_ASSERT(aria_obj_get(value, "missing") == NULL, "unknown property found");
+    return true;
+}
+
+// Backslash runs and quotes at every offset around a block boundary, with
+// each classifier
+bool test_tesla_json_escapes_across_blocks() {
+    char text[256], want[256];
+    for (int l = 0; l < 3; l++) {
+        aria_json_kernels_use(LEVELS[l]);
+        for (int pad = 40; pad < 80; pad++) {
+            for (int run = 1; run <= 5; run++) {
+                // ["xxx", "<run backslash pairs>\"", 1]: every pair is an escaped
+                // backslash, and the quote after them is escaped too
+                int n = sprintf(text, "[\"%.*s\",\"", pad, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+                for (int k = 0; k < run; k++) n += sprintf(text + n, "\\\\");
+                sprintf(text + n, "\\\"\",1]");
+                n = sprintf(want, "[\"%.*s\",\"", pad, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+                for (int k = 0; k < run; k++) n += sprintf(want + n, "\\\\");
+                sprintf(want + n, "\\\"\",1]");
+                TESLA_ASSERT(same_text(round_trip(text), want), "escape misread near a block boundary");
+            }
+        }
+    }
+    aria_json_kernels_use(NULL);
+    return true;
+}
+
+// A long generated document reads back the same with every classifier and
+// survives a second round trip unchanged
+bool test_tesla_json_classifiers_agree() {
+    size_t cap = 1 << 20, n = 0;
+    char* doc = malloc(cap);
+    n += sprintf(doc + n, "[");
+    for (int i = 0; n < cap - 256; i++) {
+        n += sprintf(doc + n, "%s{\"id\":%d,\"score\":%d.%03d,\"name\":\"user \\\"%d\\\" \\u00e9\\n\","
+                     "\"tags\":[\"a\",\"b\\\\\",%s],\"ok\":%s}",
+                     i ? ",\n  " : "", i, i % 97, i % 1000, i, i % 3 ? "null" : "[]", i % 2 ? "true" : "false");
+    }
+    sprintf(doc + n, "]");
+
+    const char* first = NULL;
+    for (int l = 0; l < 3; l++) {
+        aria_json_kernels_use(LEVELS[l]);
+        const char* out = round_trip(doc);
+        TESLA_ASSERT(out != NULL, "generated document rejected");
+        if (!first) first = out;
+        TESLA_ASSERT(strcmp(first, out) == 0, "classifiers disagree");
+    }
+    aria_json_kernels_use(NULL);
+    TESLA_ASSERT(same_text(round_trip(first), first), "second round trip changed the text");
+    free(doc);
+    return true;
+}
+
+// Nesting is limited to 1024 containers
+bool test_tesla_json_nesting_limit() {
+    char deep[2100];
+    for (int i = 0; i < 1024; i++) { deep[i] = '['; deep[2047 - i] = ']'; }
+    deep[2048] = '\0';
+    TESLA_ASSERT(parses(deep), "1024 levels rejected");
+    memmove(deep + 1, deep, 2049);
+    deep[0] = '[';
+    strcat(deep, "]");
+    quiet_stderr(true);
+    bool accepted = parses(deep);
+    quiet_stderr(false);
+    TESLA_ASSERT(!accepted, "1025 levels accepted");
+    return true;
+}
+
+int main() {
+    printf("🧠⚡ Tesla Json Module Test Suite ⚡🧠\n");
+    printf("=======================================\n\n");
+
+    // Run Tesla json tests
+    TESLA_TEST(valid_documents);
+    TESLA_TEST(invalid_documents);
+    TESLA_TEST(canonical_output);
+    TESLA_TEST(values);
+    TESLA_TEST(escapes_across_blocks);
+    TESLA_TEST(classifiers_agree);
+    TESLA_TEST(nesting_limit);
+
+    printf("\n🧠⚡ Tesla  Test Results ⚡🧠\n");
+    printf("============================\n");
+    printf("Tests Run:    %d\n", tests_run);
+    printf("Tests Passed: %d\n", tests_passed);
+    printf("Tests Failed: %d\n", tests_run - tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("✅ All Tesla json tests PASSED! π Hz synchronized! 🚀\n");
+        return 0;
+    } else {
+        printf("❌ Some Tesla json tests FAILED! ⚠️\n");
+        return 1;
+    }
+}
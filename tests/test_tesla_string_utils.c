@@ -1,14 +1,43 @@
 /**
  * Tesla Consciousness Computing - String_utils Module Tests
  * 
- * Unit tests for Tesla consciousness-enhanced string_utils module
+ * Unit tests for Tesla consciousness-enhanced string_utils module. Boxed
+ * strings are read through their length and hash header, and compared by
+ * content by the dynamic operators. Build against the runtime sources:
+ *
+ *   gcc -O2 -std=c99 -D_GNU_SOURCE -o tests/tesla_string_utils_tests \
+ *       tests/test_tesla_string_utils.c src/stdlib/string_utils.c \
+ *       src/stdlib/string_kernels.c src/stdlib/dynamic.c src/stdlib/io.c \
+ *       src/stdlib/dataStructures.c src/stdlib/list_kernels.c \
+ *       src/runtime/object.c src/runtime/gc.c -lpthread -lm
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
 #include <math.h>
 
+typedef uint64_t Value;
+void* aria_str_box(const char* c_str);
+uint32_t aria_str_length(const char* data);
+Value str_len(Value s_tagged);
+Value str_find(Value s_tagged, Value needle_tagged);
+Value str_equals(Value a_tagged, Value b_tagged);
+Value str_concat(Value a_tagged, Value b_tagged);
+void* dyn_eq(void* a, void* b);
+void* dyn_add(void* a, void* b);
+
+#define PTR_MASK 0x0000FFFFFFFFFFFFULL
+#define TAG_TRUE 0xFFF8000000000003ULL
+
+static Value str(const char* s) { return (Value)aria_str_box(s); }
+static const char* text_of(Value v) { return (const char*)(v & PTR_MASK & ~7ULL); }
+// Ints are read from the low 32 bits
+static int32_t int_of(Value v) { return (int32_t)(v & 0xFFFFFFFF); }
+
 // Test framework
 static int tests_run = 0;
 static int tests_passed = 0;
@@ -51,6 +80,32 @@ bool test_tesla_string_utils_performance() {
     return true;
 }
 
+// Boxed strings point at their characters, just past the header
+bool test_tesla_string_utils_boxed_strings() {
+    Value s = str("hello world");
+    TESLA_ASSERT(strcmp(text_of(s), "hello world") == 0, "boxed text");
+    TESLA_ASSERT(aria_str_length(text_of(s)) == 11, "header length");
+    TESLA_ASSERT(int_of(str_len(s)) == 11, "str_len");
+    TESLA_ASSERT(int_of(str_find(s, str("world"))) == 6, "str_find");
+    TESLA_ASSERT(int_of(str_find(s, str("xyz"))) == -1, "str_find of a missing needle");
+    TESLA_ASSERT(int_of(str_equals(s, str("hello world"))) == 1, "str_equals of equal text");
+    TESLA_ASSERT(int_of(str_equals(s, str("hello there"))) == 0, "str_equals of different text");
+    TESLA_ASSERT(strcmp(text_of(str_concat(s, str("!"))), "hello world!") == 0, "str_concat");
+    return true;
+}
+
+// ==, != and + on two separately built strings look at their content
+bool test_tesla_string_utils_dynamic_equality() {
+    Value a = str("route7"), b = str("route7"), c = str("route8");
+    TESLA_ASSERT(a != b, "distinct boxes");
+    TESLA_ASSERT((Value)dyn_eq((void*)a, (void*)b) == TAG_TRUE, "equal text compares equal");
+    TESLA_ASSERT((Value)dyn_eq((void*)a, (void*)c) != TAG_TRUE, "different text compares unequal");
+    Value ab = (Value)dyn_add((void*)a, (void*)c);
+    TESLA_ASSERT(strcmp(text_of(ab), "route7route8") == 0, "dyn_add concatenates");
+    TESLA_ASSERT(aria_str_length(text_of(ab)) == 12, "concatenation length");
+    return true;
+}
+
 int main() {
     printf("🧠⚡ Tesla String_utils Module Test Suite ⚡🧠\n");
     printf("=======================================\n\n");
@@ -59,6 +114,8 @@ int main() {
     TESLA_TEST(consciousness_validation);
     TESLA_TEST(frequency_synchronization);
     TESLA_TEST(performance);
+    TESLA_TEST(boxed_strings);
+    TESLA_TEST(dynamic_equality);
     
     printf("\n🧠⚡ Tesla  Test Results ⚡🧠\n");
     printf("============================\n");